@@ -64,9 +64,12 @@
 /*
 	Allocator debugging
 	ARC_ALLOCATOR_DEBUG_LOG: Logs all allocations performed with Arclight Allocators
+	ARC_ALLOCATOR_NO_DEBUG_LOG: Defined by the build to suppress allocation logs, e.g. for benchmarks
 */
 
+#ifndef ARC_ALLOCATOR_NO_DEBUG_LOG
 #define ARC_ALLOCATOR_DEBUG_LOG
+#endif
 
 
 /*
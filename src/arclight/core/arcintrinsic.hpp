@@ -55,18 +55,36 @@
 
 
 
+/*
+	Defines ARC_TARGET(isa)
+	Enables an instruction set extension for a single function, e.g. ARC_TARGET("avx2").
+	Such functions must only be called after checking for support with CPUID::hasFeature().
+	MSVC permits intrinsics without switches.
+*/
+#if defined(ARC_COMPILER_CLANG) || defined(ARC_COMPILER_GCC)
+	#define ARC_TARGET(isa)	__attribute__((target(isa)))
+#else
+	#define ARC_TARGET(isa)
+#endif
+
+
+
 /*
 	Code vectorization
 */
 #ifdef ARC_PLATFORM_X86
 
+	/*
+		x86 runtime dispatch: Kernels for extensions beyond the build target are compiled with ARC_TARGET and selected at runtime
+	*/
+	#include <immintrin.h>
+	#define ARC_DISPATCH_X86
+
 	/*
 		x86 code vectorization: SSE and AVX support (except AVX512)
 	*/
 	#ifdef ARC_VECTORIZE_X86
 
-		#include <immintrin.h>
-
 		#ifdef ARC_TARGET_HAS_SSE
 			#define ARC_VECTORIZE_X86_SSE
 		#endif
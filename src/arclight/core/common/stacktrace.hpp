@@ -12,7 +12,17 @@
 #include "filesystem/path.hpp"
 #include "arcconfig.hpp"
 
-#include <stacktrace>
+#include <string>
+#include <version>
+
+//Standard libraries without <stacktrace> support fall back to empty traces
+#if !defined(ARC_DISABLE_STACKTRACES) && !defined(__cpp_lib_stacktrace)
+	#define ARC_DISABLE_STACKTRACES
+#endif
+
+#ifndef ARC_DISABLE_STACKTRACES
+	#include <stacktrace>
+#endif
 
 
 
@@ -21,6 +31,9 @@ class StacktraceEntry {
 public:
 
 	StacktraceEntry() noexcept = default;
+
+#ifndef ARC_DISABLE_STACKTRACES
+
 	explicit StacktraceEntry(const std::stacktrace_entry& entry) noexcept : eHandle(entry) {}
 
 	std::string description() const {
@@ -39,6 +52,22 @@ private:
 
 	std::stacktrace_entry eHandle;
 
+#else
+
+	std::string description() const {
+		return {};
+	}
+
+	std::string filepath() const {
+		return {};
+	}
+
+	SizeT lineNumber() const {
+		return 0;
+	}
+
+#endif
+
 };
 
 
@@ -57,11 +86,15 @@ public:
 	}
 
 	bool empty() const noexcept {
-		return stHandle.empty();
+		return depth() == 0;
 	}
 
 	SizeT depth() const noexcept {
+#ifndef ARC_DISABLE_STACKTRACES
 		return stHandle.size();
+#else
+		return 0;
+#endif
 	}
 
 	StacktraceEntry entryAt(SizeT index) const {
@@ -70,7 +103,11 @@ public:
 			return StacktraceEntry();
 		}
 
+#ifndef ARC_DISABLE_STACKTRACES
 		return StacktraceEntry(stHandle[index]);
+#else
+		return StacktraceEntry();
+#endif
 
 	}
 
@@ -122,8 +159,12 @@ public:
 
 	}
 
+#ifndef ARC_DISABLE_STACKTRACES
+
 private:
 
 	std::stacktrace stHandle;
 
+#endif
+
 };
\ No newline at end of file
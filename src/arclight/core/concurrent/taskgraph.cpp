@@ -0,0 +1,95 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 taskgraph.cpp
+ */
+
+#include "taskgraph.hpp"
+
+
+
+void TaskGraph::precede(NodeID before, NodeID after) {
+
+	if (before >= nodes.size() || after >= nodes.size()) {
+		throw TaskGraphException("Invalid task graph node ID");
+	}
+
+	if (before == after) {
+		throw TaskGraphException("Task graph node cannot depend on itself");
+	}
+
+	nodes[after].predecessors.push_back(before);
+
+}
+
+
+
+void TaskGraph::validate() const {
+
+	//Kahn's algorithm: The graph is acyclic if every node can be visited
+	std::vector<SizeT> inDegree(nodes.size());
+	std::vector<std::vector<NodeID>> successors(nodes.size());
+
+	for (NodeID i = 0; i < nodes.size(); i++) {
+
+		inDegree[i] = nodes[i].predecessors.size();
+
+		for (NodeID p : nodes[i].predecessors) {
+			successors[p].push_back(i);
+		}
+
+	}
+
+	std::vector<NodeID> ready;
+
+	for (NodeID i = 0; i < nodes.size(); i++) {
+
+		if (!inDegree[i]) {
+			ready.push_back(i);
+		}
+
+	}
+
+	SizeT visited = 0;
+
+	while (!ready.empty()) {
+
+		NodeID node = ready.back();
+		ready.pop_back();
+		visited++;
+
+		for (NodeID s : successors[node]) {
+
+			if (--inDegree[s] == 0) {
+				ready.push_back(s);
+			}
+
+		}
+
+	}
+
+	if (visited != nodes.size()) {
+		throw TaskGraphException("Task graph contains a cycle");
+	}
+
+}
+
+
+
+void TaskGraph::clear() noexcept {
+	nodes.clear();
+}
+
+
+
+SizeT TaskGraph::size() const noexcept {
+	return nodes.size();
+}
+
+
+
+bool TaskGraph::empty() const noexcept {
+	return nodes.empty();
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 taskgraph.hpp
+ */
+
+#pragma once
+
+#include "common/exception.hpp"
+#include "types.hpp"
+
+#include <functional>
+#include <vector>
+
+
+
+class TaskGraphException : public ArclightException {
+
+public:
+
+	using ArclightException::ArclightException;
+	virtual const char* name() const noexcept override { return "Task Graph Exception"; }
+
+};
+
+
+
+/*
+	TaskGraph
+	Describes a set of tasks and their dependencies (a DAG) that is executed by ThreadPool::run().
+	The graph itself is reusable and can be run multiple times.
+*/
+class TaskGraph {
+
+public:
+
+	using NodeID = SizeT;
+
+	TaskGraph() = default;
+
+
+	//Adds a node and returns its ID
+	template<class Function>
+	NodeID add(Function&& function) {
+
+		nodes.emplace_back(std::function<void()>(std::forward<Function>(function)));
+		return nodes.size() - 1;
+
+	}
+
+
+	//Makes after depend on before
+	void precede(NodeID before, NodeID after);
+
+	//Throws a TaskGraphException if the graph contains a cycle
+	void validate() const;
+
+	void clear() noexcept;
+
+	SizeT size() const noexcept;
+	bool empty() const noexcept;
+
+private:
+
+	friend class ThreadPool;
+
+	struct Node {
+
+		explicit Node(std::function<void()>&& function) : function(std::move(function)) {}
+
+		std::function<void()> function;
+		std::vector<NodeID> predecessors;
+
+	};
+
+	std::vector<Node> nodes;
+
+};
\ No newline at end of file
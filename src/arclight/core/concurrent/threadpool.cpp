@@ -0,0 +1,469 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 threadpool.cpp
+ */
+
+#include "threadpool.hpp"
+#include "taskgraph.hpp"
+
+
+
+thread_local ThreadPool* ThreadPool::currentPool = nullptr;
+thread_local u32 ThreadPool::currentWorker = ThreadPool::NoWorker;
+
+
+
+ThreadPool::ThreadPool(u32 workerCount) : workerCount(workerCount ? workerCount : Math::max(Thread::getHardwareThreadCount(), 1u)),
+	injectionCount(0), sleepingWorkers(0), queuedTasks(0), running(true) {
+
+	workers = std::make_unique<Worker[]>(this->workerCount);
+	threads.reserve(this->workerCount);
+
+	for (u32 i = 0; i < this->workerCount; i++) {
+
+		threads.emplace_back();
+		threads.back().start([this, i]() {
+			workerMain(i);
+		});
+
+	}
+
+}
+
+
+
+ThreadPool::~ThreadPool() {
+
+	{
+		std::lock_guard lock(sleepLock);
+		running.store(false, std::memory_order_seq_cst);
+	}
+
+	sleepCondition.notify_all();
+
+	for (Thread& thread : threads) {
+		thread.finish();
+	}
+
+}
+
+
+
+void ThreadPool::wait(const TaskHandle& task) {
+
+	if (!task.task) {
+		return;
+	}
+
+	helpUntilZero(task.task->pending);
+
+	if (task.task->exception) {
+		std::rethrow_exception(task.task->exception);
+	}
+
+}
+
+
+
+void ThreadPool::wait(std::span<const TaskHandle> tasks) {
+
+	for (const TaskHandle& task : tasks) {
+
+		if (task.task) {
+			helpUntilZero(task.task->pending);
+		}
+
+	}
+
+	for (const TaskHandle& task : tasks) {
+
+		if (task.task && task.task->exception) {
+			std::rethrow_exception(task.task->exception);
+		}
+
+	}
+
+}
+
+
+
+void ThreadPool::run(const TaskGraph& graph) {
+
+	graph.validate();
+
+	std::vector<TaskHandle> tasks(graph.size());
+	std::vector<TaskHandle> dependencies;
+	std::vector<bool> created(graph.size());
+
+	//Create in topological order so that every predecessor already has a handle
+	SizeT remaining = graph.size();
+
+	while (remaining) {
+
+		for (TaskGraph::NodeID i = 0; i < graph.size(); i++) {
+
+			if (created[i]) {
+				continue;
+			}
+
+			const TaskGraph::Node& node = graph.nodes[i];
+			bool ready = true;
+
+			dependencies.clear();
+
+			for (TaskGraph::NodeID p : node.predecessors) {
+
+				if (!created[p]) {
+					ready = false;
+					break;
+				}
+
+				dependencies.push_back(tasks[p]);
+
+			}
+
+			if (ready) {
+
+				tasks[i] = createTask([&function = node.function]() { function(); }, dependencies, true);
+				created[i] = true;
+				remaining--;
+
+			}
+
+		}
+
+	}
+
+	wait(tasks);
+
+}
+
+
+
+u32 ThreadPool::getWorkerCount() const noexcept {
+	return workerCount;
+}
+
+
+
+bool ThreadPool::isWorkerThread() const noexcept {
+	return currentPool == this;
+}
+
+
+
+ThreadPool& ThreadPool::shared() {
+
+	static ThreadPool pool;
+	return pool;
+
+}
+
+
+
+TaskHandle ThreadPool::createTask(std::function<void()>&& function, std::span<const TaskHandle> dependencies, bool handle) {
+
+	//One reference is held until the task has been executed, the other one by the returned handle
+	Task* task = new Task(std::move(function), handle ? 2 : 1);
+
+	for (const TaskHandle& dependency : dependencies) {
+
+		if (dependency.task) {
+			addDependency(task, dependency.task);
+		}
+
+	}
+
+	//Without a handle the task might already be gone after resolving the last dependency
+	TaskHandle taskHandle(handle ? task : nullptr);
+	resolveDependency(task);
+
+	return taskHandle;
+
+}
+
+
+
+void ThreadPool::addDependency(Task* task, Task* dependency) {
+
+	std::lock_guard lock(dependency->successorLock);
+
+	if (!dependency->finished) {
+
+		task->dependencies.fetch_add(1, std::memory_order_relaxed);
+		dependency->successors.push_back(task);
+
+	} else if (dependency->exception) {
+
+		inheritException(task, dependency->exception);
+
+	}
+
+}
+
+
+
+void ThreadPool::inheritException(Task* task, const std::exception_ptr& exception) {
+
+	//Several predecessors may fail concurrently, the first one wins
+	std::lock_guard lock(task->successorLock);
+
+	if (!task->exception) {
+		task->exception = exception;
+	}
+
+}
+
+
+
+void ThreadPool::resolveDependency(Task* task) {
+
+	if (task->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		schedule(task);
+	}
+
+}
+
+
+
+TaskHandle ThreadPool::createLatch(u32 count) {
+
+	Task* task = new Task(nullptr, 2);
+	task->dependencies.store(count, std::memory_order_relaxed);
+
+	return TaskHandle(task);
+
+}
+
+
+
+void ThreadPool::countDown(const TaskHandle& latch) {
+
+	//The latch is completed in-place since there is nothing to execute
+	if (latch.task->dependencies.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		execute(latch.task);
+	}
+
+}
+
+
+
+void ThreadPool::schedule(Task* task) {
+
+	//Counted before publishing to prevent the counter from wrapping when the task is taken immediately
+	queuedTasks.fetch_add(1, std::memory_order_seq_cst);
+
+	if (currentPool == this) {
+
+		workers[currentWorker].deque.push(task);
+
+	} else {
+
+		std::lock_guard lock(injectionLock);
+		injectionQueue.push_back(task);
+		injectionCount.fetch_add(1, std::memory_order_release);
+
+	}
+
+	if (sleepingWorkers.load(std::memory_order_seq_cst)) {
+
+		std::lock_guard lock(sleepLock);
+		sleepCondition.notify_one();
+
+	}
+
+}
+
+
+
+Task* ThreadPool::findTask(u32 workerIndex) {
+
+	thread_local u32 stealSeed = 0x9E3779B9 ^ static_cast<u32>(reinterpret_cast<AddressT>(&stealSeed));
+
+	Task* task = nullptr;
+
+	if (workerIndex != NoWorker && workers[workerIndex].deque.pop(task)) {
+
+		queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+		return task;
+
+	}
+
+	if (injectionCount.load(std::memory_order_acquire)) {
+
+		std::lock_guard lock(injectionLock);
+
+		if (!injectionQueue.empty()) {
+
+			task = injectionQueue.front();
+			injectionQueue.pop_front();
+			injectionCount.fetch_sub(1, std::memory_order_relaxed);
+			queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+
+			return task;
+
+		}
+
+	}
+
+	//Xorshift to pick the first victim
+	stealSeed ^= stealSeed << 13;
+	stealSeed ^= stealSeed >> 17;
+	stealSeed ^= stealSeed << 5;
+
+	u32 start = stealSeed % workerCount;
+
+	for (u32 i = 0; i < workerCount; i++) {
+
+		u32 victim = (start + i) % workerCount;
+
+		if (victim != workerIndex && workers[victim].deque.steal(task)) {
+
+			queuedTasks.fetch_sub(1, std::memory_order_relaxed);
+			return task;
+
+		}
+
+	}
+
+	return nullptr;
+
+}
+
+
+
+bool ThreadPool::tryRunTask() {
+
+	Task* task = findTask(isWorkerThread() ? currentWorker : NoWorker);
+
+	if (!task) {
+		return false;
+	}
+
+	execute(task);
+
+	return true;
+
+}
+
+
+
+void ThreadPool::execute(Task* task) {
+
+	if (task->function) {
+
+		//A task whose predecessor failed is skipped and fails with the same exception
+		if (!task->exception) {
+
+			try {
+				task->function();
+			} catch (...) {
+				task->exception = std::current_exception();
+			}
+
+		}
+
+		//Release captured state as early as possible
+		task->function = nullptr;
+
+	}
+
+	std::vector<Task*> successors;
+
+	{
+		std::lock_guard lock(task->successorLock);
+		task->finished = true;
+		successors.swap(task->successors);
+	}
+
+	for (Task* successor : successors) {
+
+		if (task->exception) {
+			inheritException(successor, task->exception);
+		}
+
+		resolveDependency(successor);
+
+	}
+
+	task->pending.store(0, std::memory_order_release);
+	task->pending.notify_all();
+	task->release();
+
+}
+
+
+
+void ThreadPool::helpUntilZero(std::atomic<u32>& counter) {
+
+	while (true) {
+
+		u32 value = counter.load(std::memory_order_acquire);
+
+		if (!value) {
+			return;
+		}
+
+		if (tryRunTask()) {
+			continue;
+		}
+
+		//Workers must not block since the awaited task might sit in their own deque later on
+		if (isWorkerThread()) {
+			std::this_thread::yield();
+		} else {
+			counter.wait(value, std::memory_order_acquire);
+		}
+
+	}
+
+}
+
+
+
+void ThreadPool::workerMain(u32 workerIndex) {
+
+	currentPool = this;
+	currentWorker = workerIndex;
+
+	while (true) {
+
+		Task* task = findTask(workerIndex);
+
+		for (u32 i = 0; !task && i < SpinCount; i++) {
+
+			std::this_thread::yield();
+			task = findTask(workerIndex);
+
+		}
+
+		if (task) {
+
+			execute(task);
+			continue;
+
+		}
+
+		std::unique_lock lock(sleepLock);
+
+		sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+
+		sleepCondition.wait(lock, [this]() {
+			return queuedTasks.load(std::memory_order_seq_cst) || !running.load(std::memory_order_seq_cst);
+		});
+
+		sleepingWorkers.fetch_sub(1, std::memory_order_seq_cst);
+
+		if (!running.load(std::memory_order_seq_cst) && !queuedTasks.load(std::memory_order_seq_cst)) {
+			break;
+		}
+
+	}
+
+	currentPool = nullptr;
+	currentWorker = NoWorker;
+
+}
\ No newline at end of file
@@ -0,0 +1,392 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 threadpool.hpp
+ */
+
+#pragma once
+
+#include "thread.hpp"
+#include "workstealingdeque.hpp"
+#include "common/concepts.hpp"
+#include "math/math.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+
+
+class ThreadPool;
+class TaskGraph;
+
+
+class Task final {
+
+public:
+
+	Task(const Task& task) = delete;
+	Task& operator=(const Task& task) = delete;
+
+private:
+
+	friend class ThreadPool;
+	friend class TaskHandle;
+
+	explicit Task(std::function<void()>&& function, u32 references) noexcept : function(std::move(function)), references(references), dependencies(1), pending(1), finished(false) {}
+
+	void acquire() noexcept {
+		references.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void release() noexcept {
+
+		if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete this;
+		}
+
+	}
+
+	std::function<void()> function;
+	std::exception_ptr exception;
+
+	std::atomic<u32> references;
+	std::atomic<u32> dependencies;
+	std::atomic<u32> pending;
+
+	std::mutex successorLock;
+	std::vector<Task*> successors;
+	bool finished;
+
+};
+
+
+
+class TaskHandle final {
+
+public:
+
+	constexpr TaskHandle() noexcept : task(nullptr) {}
+
+	~TaskHandle() noexcept {
+
+		if (task) {
+			task->release();
+		}
+
+	}
+
+	TaskHandle(const TaskHandle& handle) noexcept : task(handle.task) {
+
+		if (task) {
+			task->acquire();
+		}
+
+	}
+
+	TaskHandle& operator=(const TaskHandle& handle) noexcept {
+
+		TaskHandle copy(handle);
+		std::swap(task, copy.task);
+
+		return *this;
+
+	}
+
+	TaskHandle(TaskHandle&& handle) noexcept : task(std::exchange(handle.task, nullptr)) {}
+
+	TaskHandle& operator=(TaskHandle&& handle) noexcept {
+
+		TaskHandle moved(std::move(handle));
+		std::swap(task, moved.task);
+
+		return *this;
+
+	}
+
+	bool valid() const noexcept {
+		return task;
+	}
+
+	bool finished() const noexcept {
+		return !task || task->pending.load(std::memory_order_acquire) == 0;
+	}
+
+private:
+
+	friend class ThreadPool;
+
+	explicit TaskHandle(Task* task) noexcept : task(task) {}
+
+	Task* task;
+
+};
+
+
+
+/*
+	ThreadPool
+	Work-stealing task scheduler on top of Thread.
+
+	Every worker owns a WorkStealingDeque. Tasks spawned from inside a worker go onto its own deque, tasks submitted
+	from outside land in a shared injection queue. Idle workers steal from the top of other deques before going to sleep.
+	Threads waiting on a task (including workers waiting on nested tasks) execute pending tasks instead of blocking.
+*/
+class ThreadPool final {
+
+public:
+
+	//Creates the pool with the given number of workers. 0 uses all hardware threads.
+	explicit ThreadPool(u32 workerCount = 0);
+
+	//Remaining tasks are finished before the workers are joined.
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool& pool) = delete;
+	ThreadPool& operator=(const ThreadPool& pool) = delete;
+
+
+	/*
+		Submits a task for execution.
+		dependencies:	Tasks that must finish before this task starts.
+		returns:		A handle to wait on the task.
+		If a dependency throws, function is skipped and the task fails with the same exception.
+	*/
+	template<class Function>
+	TaskHandle submit(Function&& function, std::span<const TaskHandle> dependencies = {}) {
+		return createTask(std::function<void()>(std::forward<Function>(function)), dependencies, true);
+	}
+
+	template<class Function>
+	TaskHandle submit(Function&& function, std::initializer_list<TaskHandle> dependencies) {
+		return submit(std::forward<Function>(function), std::span<const TaskHandle>(dependencies.begin(), dependencies.size()));
+	}
+
+
+	//Submits a continuation that runs once task has finished. It is skipped and fails as well if task throws.
+	template<class Function>
+	TaskHandle then(const TaskHandle& task, Function&& function) {
+		return submit(std::forward<Function>(function), std::span<const TaskHandle>(&task, 1));
+	}
+
+
+	/*
+		Waits until the task has finished, executing other tasks in the meantime.
+		Rethrows the exception thrown by the task if there was one.
+	*/
+	void wait(const TaskHandle& task);
+	void wait(std::span<const TaskHandle> tasks);
+
+
+	//Executes the task graph and waits for all nodes to finish. Nodes downstream of a failed node are skipped, the exception is rethrown.
+	void run(const TaskGraph& graph);
+
+
+	/*
+		Calls function for every index in [begin, end).
+		function is either invoked as function(i) or on whole chunks as function(chunkBegin, chunkEnd).
+		grainSize specifies the minimum number of indices per task, 0 picks a size based on the worker count.
+		Returns after all indices have been processed. The calling thread participates.
+	*/
+	template<class Function>
+	void parallelFor(SizeT begin, SizeT end, Function&& function, SizeT grainSize = 0) {
+
+		forEachChunk(begin, end, grainSize, [&function](SizeT, SizeT chunkBegin, SizeT chunkEnd) {
+
+			if constexpr (CC::Invocable<Function, SizeT, SizeT>) {
+
+				function(chunkBegin, chunkEnd);
+
+			} else {
+
+				for (SizeT i = chunkBegin; i < chunkEnd; i++) {
+					function(i);
+				}
+
+			}
+
+		});
+
+	}
+
+
+	/*
+		Reduces all indices in [begin, end) to a single value.
+		function is either invoked as function(i) or on whole chunks as function(chunkBegin, chunkEnd) and returns a T.
+		reduce(T, T) must be associative. Chunk results are combined in index order, making the result deterministic for a fixed grain size.
+	*/
+	template<class T, class Function, class Reduce>
+	T parallelReduce(SizeT begin, SizeT end, const T& identity, Function&& function, Reduce&& reduce, SizeT grainSize = 0) {
+
+		std::vector<T> partials(getChunkCount(begin, end, grainSize), identity);
+
+		forEachChunk(begin, end, grainSize, [&](SizeT chunk, SizeT chunkBegin, SizeT chunkEnd) {
+
+			T& partial = partials[chunk];
+
+			if constexpr (CC::Invocable<Function, SizeT, SizeT>) {
+
+				partial = reduce(partial, function(chunkBegin, chunkEnd));
+
+			} else {
+
+				for (SizeT i = chunkBegin; i < chunkEnd; i++) {
+					partial = reduce(partial, function(i));
+				}
+
+			}
+
+		});
+
+		T result = identity;
+
+		for (const T& partial : partials) {
+			result = reduce(result, partial);
+		}
+
+		return result;
+
+	}
+
+
+	u32 getWorkerCount() const noexcept;
+
+	//Returns whether the calling thread is a worker of this pool
+	bool isWorkerThread() const noexcept;
+
+
+	//Returns a process-wide pool sized to the hardware thread count
+	static ThreadPool& shared();
+
+private:
+
+	constexpr static u32 NoWorker = -1;
+	constexpr static u32 ChunksPerWorker = 4;
+	constexpr static u32 SpinCount = 64;
+
+	struct alignas(CacheLineSize) Worker {
+		WorkStealingDeque<Task*> deque;
+	};
+
+
+	TaskHandle createTask(std::function<void()>&& function, std::span<const TaskHandle> dependencies, bool handle);
+	void addDependency(Task* task, Task* dependency);
+	void inheritException(Task* task, const std::exception_ptr& exception);
+	void resolveDependency(Task* task);
+
+	//A latch is a task without function that completes once count has reached zero
+	TaskHandle createLatch(u32 count);
+	void countDown(const TaskHandle& latch);
+
+	void schedule(Task* task);
+	Task* findTask(u32 workerIndex);
+	bool tryRunTask();
+	void execute(Task* task);
+
+	void helpUntilZero(std::atomic<u32>& counter);
+	void workerMain(u32 workerIndex);
+
+
+	SizeT getChunkSize(SizeT begin, SizeT end, SizeT grainSize) const noexcept {
+		return grainSize ? grainSize : Math::max((end - begin) / (getWorkerCount() * ChunksPerWorker), SizeT(1));
+	}
+
+	SizeT getChunkCount(SizeT begin, SizeT end, SizeT grainSize) const noexcept {
+
+		if (begin >= end) {
+			return 0;
+		}
+
+		SizeT chunkSize = getChunkSize(begin, end, grainSize);
+
+		return (end - begin + chunkSize - 1) / chunkSize;
+
+	}
+
+
+	//Splits [begin, end) into chunks and calls function(chunkIndex, chunkBegin, chunkEnd) for each of them
+	template<class Function>
+	void forEachChunk(SizeT begin, SizeT end, SizeT grainSize, Function&& function) {
+
+		SizeT chunkCount = getChunkCount(begin, end, grainSize);
+
+		if (chunkCount == 0) {
+			return;
+		}
+
+		SizeT chunkSize = getChunkSize(begin, end, grainSize);
+
+		if (chunkCount == 1) {
+
+			function(SizeT(0), begin, end);
+			return;
+
+		}
+
+		TaskHandle latch = createLatch(static_cast<u32>(chunkCount));
+		std::exception_ptr exception;
+		std::mutex exceptionLock;
+
+		auto runChunk = [&](SizeT chunk) {
+
+			try {
+
+				SizeT chunkBegin = begin + chunk * chunkSize;
+				function(chunk, chunkBegin, Math::min(chunkBegin + chunkSize, end));
+
+			} catch (...) {
+
+				std::lock_guard lock(exceptionLock);
+
+				if (!exception) {
+					exception = std::current_exception();
+				}
+
+			}
+
+			countDown(latch);
+
+		};
+
+		for (SizeT chunk = 1; chunk < chunkCount; chunk++) {
+			createTask([&runChunk, chunk]() { runChunk(chunk); }, {}, false);
+		}
+
+		runChunk(0);
+		wait(latch);
+
+		if (exception) {
+			std::rethrow_exception(exception);
+		}
+
+	}
+
+
+	std::unique_ptr<Worker[]> workers;
+	std::vector<Thread> threads;
+	u32 workerCount;
+
+	std::mutex injectionLock;
+	std::deque<Task*> injectionQueue;
+	std::atomic<SizeT> injectionCount;
+
+	std::mutex sleepLock;
+	std::condition_variable sleepCondition;
+	std::atomic<u32> sleepingWorkers;
+	std::atomic<SizeT> queuedTasks;
+	std::atomic<bool> running;
+
+	static thread_local ThreadPool* currentPool;
+	static thread_local u32 currentWorker;
+
+};
\ No newline at end of file
@@ -0,0 +1,176 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 workstealingdeque.hpp
+ */
+
+#pragma once
+
+#include "types.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+
+
+/*
+	WorkStealingDeque
+	Chase-Lev deque based on the memory orderings from Lê et al. (2013).
+
+	The owning thread pushes and pops at the bottom while any other thread may steal from the top.
+	The ring buffer grows on demand; retired buffers are kept alive until destruction because thieves might still read from them.
+	T must be trivially copyable since elements are read speculatively before ownership is established.
+*/
+template<class T>
+class WorkStealingDeque final {
+
+	static_assert(std::is_trivially_copyable_v<T>, "WorkStealingDeque requires T to be trivially copyable");
+
+	class Buffer {
+
+	public:
+
+		explicit Buffer(i64 capacity) : capacity(capacity), mask(capacity - 1), data(std::make_unique<std::atomic<T>[]>(capacity)) {}
+
+		T get(i64 index) const noexcept {
+			return data[index & mask].load(std::memory_order_relaxed);
+		}
+
+		void put(i64 index, T value) noexcept {
+			data[index & mask].store(value, std::memory_order_relaxed);
+		}
+
+		Buffer* grow(i64 bottom, i64 top) const {
+
+			Buffer* buffer = new Buffer(capacity * 2);
+
+			for (i64 i = top; i != bottom; i++) {
+				buffer->put(i, get(i));
+			}
+
+			return buffer;
+
+		}
+
+		i64 size() const noexcept {
+			return capacity;
+		}
+
+	private:
+
+		i64 capacity;
+		i64 mask;
+		std::unique_ptr<std::atomic<T>[]> data;
+
+	};
+
+public:
+
+	//Capacity must be a power of two
+	explicit WorkStealingDeque(i64 capacity = 256) : top(0), bottom(0) {
+
+		retired.emplace_back(std::make_unique<Buffer>(capacity));
+		buffer.store(retired.back().get(), std::memory_order_relaxed);
+
+	}
+
+	WorkStealingDeque(const WorkStealingDeque& deque) = delete;
+	WorkStealingDeque& operator=(const WorkStealingDeque& deque) = delete;
+
+
+	//Owner only
+	void push(T value) {
+
+		i64 b = bottom.load(std::memory_order_relaxed);
+		i64 t = top.load(std::memory_order_acquire);
+		Buffer* a = buffer.load(std::memory_order_relaxed);
+
+		if (b - t > a->size() - 1) {
+
+			retired.emplace_back(a->grow(b, t));
+			a = retired.back().get();
+			buffer.store(a, std::memory_order_release);
+
+		}
+
+		a->put(b, value);
+		bottom.store(b + 1, std::memory_order_release);
+
+	}
+
+
+	//Owner only
+	bool pop(T& value) noexcept {
+
+		i64 b = bottom.load(std::memory_order_relaxed) - 1;
+		Buffer* a = buffer.load(std::memory_order_relaxed);
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		i64 t = top.load(std::memory_order_relaxed);
+
+		if (t > b) {
+
+			//Empty
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return false;
+
+		}
+
+		value = a->get(b);
+
+		if (t == b) {
+
+			//Last element, race against thieves
+			bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_relaxed);
+
+			return won;
+
+		}
+
+		return true;
+
+	}
+
+
+	//Any thread
+	bool steal(T& value) noexcept {
+
+		i64 t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		i64 b = bottom.load(std::memory_order_acquire);
+
+		if (t >= b) {
+			return false;
+		}
+
+		Buffer* a = buffer.load(std::memory_order_acquire);
+		value = a->get(t);
+
+		return top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+
+	}
+
+
+	//Returns whether the deque is empty. It's NOT a qualitative measurement since it might not represent the actual current state!
+	bool empty() const noexcept {
+
+		i64 t = top.load(std::memory_order_relaxed);
+		i64 b = bottom.load(std::memory_order_relaxed);
+
+		return t >= b;
+
+	}
+
+private:
+
+	alignas(CacheLineSize) std::atomic<i64> top;
+	alignas(CacheLineSize) std::atomic<i64> bottom;
+	std::atomic<Buffer*> buffer;
+	std::vector<std::unique_ptr<Buffer>> retired;
+
+};
\ No newline at end of file
@@ -0,0 +1,1041 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 aes.cpp
+ */
+
+#include "aes.hpp"
+#include "arcintrinsic.hpp"
+#include "concurrent/threadpool.hpp"
+#include "util/assert.hpp"
+#include "util/bits.hpp"
+#include "util/cpuid.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+
+using BlockFunction = void(*)(const u8* keys, u32 rounds, const u8* source, u8* target, SizeT count);
+using CounterFunction = void(*)(const u8* keys, u32 rounds, const u8* counter, u32 width, const u8* source, u8* target, SizeT size);
+using GHashFunction = void(*)(u8* y, const u8* h, const u8* data, SizeT size);
+
+constexpr static u8 roundConstants[10] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36};
+
+//Blocks per keystream batch and per CTR task
+constexpr static SizeT KeystreamBlocks = 8;
+constexpr static SizeT ParallelChunkBlocks = 4096;
+
+
+
+/*
+	Portable implementation
+	The S-box is evaluated as the Boyar-Peralta circuit on bit planes of 64 bytes, everything else is plain byte arithmetic without data dependent branches or lookups.
+*/
+
+//Transposes the bits of every 8 byte group
+static void transposeBits(u64 (&x)[8]) {
+
+	for (u64& w : x) {
+
+		u64 t = (w ^ (w >> 7)) & 0x00AA00AA00AA00AA;
+		w ^= t ^ (t << 7);
+		t = (w ^ (w >> 14)) & 0x0000CCCC0000CCCC;
+		w ^= t ^ (t << 14);
+		t = (w ^ (w >> 28)) & 0x00000000F0F0F0F0;
+		w ^= t ^ (t << 28);
+
+	}
+
+}
+
+
+
+//Transposes the 8x8 byte matrix formed by x
+static void transposeBytes(u64 (&x)[8]) {
+
+	u64 y[8] = {};
+
+	for (u32 i = 0; i < 8; i++) {
+
+		for (u32 j = 0; j < 8; j++) {
+			y[i] |= ((x[j] >> (i * 8)) & 0xFF) << (j * 8);
+		}
+
+	}
+
+	std::copy_n(y, 8, x);
+
+}
+
+
+
+//S-box on bit planes, q[i] holds bit i of every byte
+static void sBoxPlanes(u64 (&q)[8]) {
+
+	u64 x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4], x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+	//Top linear transform
+	u64 y14 = x3 ^ x5;
+	u64 y13 = x0 ^ x6;
+	u64 y9 = x0 ^ x3;
+	u64 y8 = x0 ^ x5;
+	u64 t0 = x1 ^ x2;
+	u64 y1 = t0 ^ x7;
+	u64 y4 = y1 ^ x3;
+	u64 y12 = y13 ^ y14;
+	u64 y2 = y1 ^ x0;
+	u64 y5 = y1 ^ x6;
+	u64 y3 = y5 ^ y8;
+	u64 t1 = x4 ^ y12;
+	u64 y15 = t1 ^ x5;
+	u64 y20 = t1 ^ x1;
+	u64 y6 = y15 ^ x7;
+	u64 y10 = y15 ^ t0;
+	u64 y11 = y20 ^ y9;
+	u64 y7 = x7 ^ y11;
+	u64 y17 = y10 ^ y11;
+	u64 y19 = y10 ^ y8;
+	u64 y16 = t0 ^ y11;
+	u64 y21 = y13 ^ y16;
+	u64 y18 = x0 ^ y16;
+
+	//Nonlinear section
+	u64 t2 = y12 & y15;
+	u64 t3 = y3 & y6;
+	u64 t4 = t3 ^ t2;
+	u64 t5 = y4 & x7;
+	u64 t6 = t5 ^ t2;
+	u64 t7 = y13 & y16;
+	u64 t8 = y5 & y1;
+	u64 t9 = t8 ^ t7;
+	u64 t10 = y2 & y7;
+	u64 t11 = t10 ^ t7;
+	u64 t12 = y9 & y11;
+	u64 t13 = y14 & y17;
+	u64 t14 = t13 ^ t12;
+	u64 t15 = y8 & y10;
+	u64 t16 = t15 ^ t12;
+	u64 t17 = t4 ^ t14;
+	u64 t18 = t6 ^ t16;
+	u64 t19 = t9 ^ t14;
+	u64 t20 = t11 ^ t16;
+	u64 t21 = t17 ^ y20;
+	u64 t22 = t18 ^ y19;
+	u64 t23 = t19 ^ y21;
+	u64 t24 = t20 ^ y18;
+	u64 t25 = t21 ^ t22;
+	u64 t26 = t21 & t23;
+	u64 t27 = t24 ^ t26;
+	u64 t28 = t25 & t27;
+	u64 t29 = t28 ^ t22;
+	u64 t30 = t23 ^ t24;
+	u64 t31 = t22 ^ t26;
+	u64 t32 = t31 & t30;
+	u64 t33 = t32 ^ t24;
+	u64 t34 = t23 ^ t33;
+	u64 t35 = t27 ^ t33;
+	u64 t36 = t24 & t35;
+	u64 t37 = t36 ^ t34;
+	u64 t38 = t27 ^ t36;
+	u64 t39 = t29 & t38;
+	u64 t40 = t25 ^ t39;
+	u64 t41 = t40 ^ t37;
+	u64 t42 = t29 ^ t33;
+	u64 t43 = t29 ^ t40;
+	u64 t44 = t33 ^ t37;
+	u64 t45 = t42 ^ t41;
+	u64 z0 = t44 & y15;
+	u64 z1 = t37 & y6;
+	u64 z2 = t33 & x7;
+	u64 z3 = t43 & y16;
+	u64 z4 = t40 & y1;
+	u64 z5 = t29 & y7;
+	u64 z6 = t42 & y11;
+	u64 z7 = t45 & y17;
+	u64 z8 = t41 & y10;
+	u64 z9 = t44 & y12;
+	u64 z10 = t37 & y3;
+	u64 z11 = t33 & y4;
+	u64 z12 = t43 & y13;
+	u64 z13 = t40 & y5;
+	u64 z14 = t29 & y2;
+	u64 z15 = t42 & y9;
+	u64 z16 = t45 & y14;
+	u64 z17 = t41 & y8;
+
+	//Bottom linear transform
+	u64 t46 = z15 ^ z16;
+	u64 t47 = z10 ^ z11;
+	u64 t48 = z5 ^ z13;
+	u64 t49 = z9 ^ z10;
+	u64 t50 = z2 ^ z12;
+	u64 t51 = z2 ^ z5;
+	u64 t52 = z7 ^ z8;
+	u64 t53 = z0 ^ z3;
+	u64 t54 = z6 ^ z7;
+	u64 t55 = z16 ^ z17;
+	u64 t56 = z12 ^ t48;
+	u64 t57 = t50 ^ t53;
+	u64 t58 = z4 ^ t46;
+	u64 t59 = z3 ^ t54;
+	u64 t60 = t46 ^ t57;
+	u64 t61 = z14 ^ t57;
+	u64 t62 = t52 ^ t58;
+	u64 t63 = t49 ^ t58;
+	u64 t64 = z4 ^ t59;
+	u64 t65 = t61 ^ t62;
+	u64 t66 = z1 ^ t63;
+	u64 t67 = t64 ^ t65;
+
+	u64 s3 = t53 ^ t66;
+
+	q[7] = t59 ^ t63;
+	q[6] = t64 ^ ~s3;
+	q[5] = t55 ^ ~t67;
+	q[4] = s3;
+	q[3] = t51 ^ t66;
+	q[2] = t47 ^ t65;
+	q[1] = t56 ^ ~t62;
+	q[0] = t48 ^ ~t60;
+
+}
+
+
+
+//Inverse affine transform of the S-box, S^-1 = A^-1 S A^-1
+static void inverseAffinePlanes(u64 (&q)[8]) {
+
+	u64 p[8];
+
+	for (u32 i = 0; i < 8; i++) {
+		p[i] = q[(i + 2) % 8] ^ q[(i + 5) % 8] ^ q[(i + 7) % 8];
+	}
+
+	p[0] = ~p[0];
+	p[2] = ~p[2];
+
+	std::copy_n(p, 8, q);
+
+}
+
+
+
+template<bool Inverse>
+static void subBytes(u8 (&bytes)[64]) {
+
+	u64 q[8];
+	std::memcpy(q, bytes, 64);
+
+	//Bit planes, q[i] receives bit i of all 64 bytes
+	transposeBits(q);
+	transposeBytes(q);
+
+	if constexpr (Inverse) {
+
+		inverseAffinePlanes(q);
+		sBoxPlanes(q);
+		inverseAffinePlanes(q);
+
+	} else {
+
+		sBoxPlanes(q);
+
+	}
+
+	transposeBytes(q);
+	transposeBits(q);
+
+	std::memcpy(bytes, q, 64);
+
+}
+
+
+
+constexpr static u8 xtime(u8 x) {
+	return (x << 1) ^ (0x1B & -(x >> 7));
+}
+
+
+
+template<bool Inverse>
+static void shiftRows(u8* block) {
+
+	u8 s[16];
+	std::copy_n(block, 16, s);
+
+	for (u32 c = 0; c < 4; c++) {
+
+		for (u32 r = 1; r < 4; r++) {
+			block[c * 4 + r] = s[(Inverse ? (c + 4 - r) % 4 : (c + r) % 4) * 4 + r];
+		}
+
+	}
+
+}
+
+
+
+template<bool Inverse>
+static void mixColumns(u8* block) {
+
+	for (u32 c = 0; c < 4; c++) {
+
+		u8* col = block + c * 4;
+
+		if constexpr (Inverse) {
+
+			//InvMixColumns = MixColumns after a preprocessing step with {04}x^2 + {05}
+			u8 u = xtime(xtime(col[0] ^ col[2]));
+			u8 v = xtime(xtime(col[1] ^ col[3]));
+
+			col[0] ^= u;
+			col[1] ^= v;
+			col[2] ^= u;
+			col[3] ^= v;
+
+		}
+
+		u8 t = col[0] ^ col[1] ^ col[2] ^ col[3];
+		u8 a0 = col[0];
+
+		col[0] ^= t ^ xtime(col[0] ^ col[1]);
+		col[1] ^= t ^ xtime(col[1] ^ col[2]);
+		col[2] ^= t ^ xtime(col[2] ^ col[3]);
+		col[3] ^= t ^ xtime(col[3] ^ a0);
+
+	}
+
+}
+
+
+
+static void addRoundKey(u8* block, const u8* key) {
+
+	for (u32 i = 0; i < 16; i++) {
+		block[i] ^= key[i];
+	}
+
+}
+
+
+
+//Runs the cipher (or the equivalent inverse cipher) on four blocks at a time
+template<bool Inverse>
+static void cryptBlocksPortable(const u8* keys, u32 rounds, const u8* source, u8* target, SizeT count) {
+
+	for (SizeT i = 0; i < count; i += 4) {
+
+		SizeT blocks = std::min<SizeT>(count - i, 4);
+		u8 state[64] = {};
+
+		std::memcpy(state, source + i * 16, blocks * 16);
+
+		for (u32 b = 0; b < 4; b++) {
+			addRoundKey(state + b * 16, keys);
+		}
+
+		for (u32 r = 1; r <= rounds; r++) {
+
+			subBytes<Inverse>(state);
+
+			for (u32 b = 0; b < 4; b++) {
+
+				shiftRows<Inverse>(state + b * 16);
+
+				if (r != rounds) {
+					mixColumns<Inverse>(state + b * 16);
+				}
+
+				addRoundKey(state + b * 16, keys + r * 16);
+
+			}
+
+		}
+
+		std::memcpy(target + i * 16, state, blocks * 16);
+
+	}
+
+}
+
+
+
+//Adds n to the big endian integer formed by the last width bytes of the counter block
+static void addCounter(u8* counter, u64 n, u32 width) {
+
+	for (u32 i = 0; i < width && n; i++) {
+
+		u64 sum = counter[15 - i] + (n & 0xFF);
+
+		counter[15 - i] = sum;
+		n = (n >> 8) + (sum >> 8);
+
+	}
+
+}
+
+
+
+//CTR keystream over a counter of width bytes
+static void counterPortable(const u8* keys, u32 rounds, const u8* counterBlock, u32 width, const u8* source, u8* target, SizeT size) {
+
+	u8 counter[16];
+	std::copy_n(counterBlock, 16, counter);
+
+	u8 keystream[KeystreamBlocks * 16];
+
+	for (SizeT i = 0; i < size; i += sizeof(keystream)) {
+
+		SizeT bytes = std::min(size - i, sizeof(keystream));
+		SizeT blocks = (bytes + 16 - 1) / 16;
+
+		for (SizeT b = 0; b < blocks; b++) {
+
+			std::copy_n(counter, 16, keystream + b * 16);
+			addCounter(counter, 1, width);
+
+		}
+
+		cryptBlocksPortable<false>(keys, rounds, keystream, keystream, blocks);
+
+		for (SizeT j = 0; j < bytes; j++) {
+			target[i + j] = source[i + j] ^ keystream[j];
+		}
+
+	}
+
+}
+
+
+
+//Multiplies y by h in GF(2^128) in GCM bit order without secret dependent branches
+static void multiplyGF128(u64& yh, u64& yl, u64 hh, u64 hl) {
+
+	u64 zh = 0, zl = 0;
+
+	for (u32 i = 0; i < 128; i++) {
+
+		u64 mask = -((i < 64 ? yh >> (63 - i) : yl >> (127 - i)) & 1);
+
+		zh ^= hh & mask;
+		zl ^= hl & mask;
+
+		u64 carry = -(hl & 1);
+
+		hl = (hl >> 1) | (hh << 63);
+		hh = (hh >> 1) ^ (0xE100000000000000 & carry);
+
+	}
+
+	yh = zh;
+	yl = zl;
+
+}
+
+
+
+static void ghashPortable(u8* y, const u8* h, const u8* data, SizeT size) {
+
+	u64 yh = Bits::big64(Bits::assemble<u64>(y));
+	u64 yl = Bits::big64(Bits::assemble<u64>(y + 8));
+	u64 hh = Bits::big64(Bits::assemble<u64>(h));
+	u64 hl = Bits::big64(Bits::assemble<u64>(h + 8));
+
+	for (SizeT i = 0; i < size; i += 16) {
+
+		u8 block[16] = {};
+		std::memcpy(block, data + i, std::min<SizeT>(size - i, 16));
+
+		yh ^= Bits::big64(Bits::assemble<u64>(block));
+		yl ^= Bits::big64(Bits::assemble<u64>(block + 8));
+
+		multiplyGF128(yh, yl, hh, hl);
+
+	}
+
+	Bits::disassemble(Bits::big64(yh), y);
+	Bits::disassemble(Bits::big64(yl), y + 8);
+
+}
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+/*
+	AES-NI implementation
+	Independent blocks are interleaved eight at a time since aesenc has a latency of several cycles but a throughput of one or two per cycle.
+*/
+template<bool Inverse>
+ARC_TARGET("aes,sse2") ARC_FORCE_INLINE static __m128i roundNI(__m128i block, __m128i key) {
+
+	if constexpr (Inverse) {
+		return _mm_aesdec_si128(block, key);
+	} else {
+		return _mm_aesenc_si128(block, key);
+	}
+
+}
+
+
+
+template<bool Inverse>
+ARC_TARGET("aes,sse2") ARC_FORCE_INLINE static __m128i lastRoundNI(__m128i block, __m128i key) {
+
+	if constexpr (Inverse) {
+		return _mm_aesdeclast_si128(block, key);
+	} else {
+		return _mm_aesenclast_si128(block, key);
+	}
+
+}
+
+
+
+template<bool Inverse>
+ARC_TARGET("aes,sse2") static void cryptBlocksNI(const u8* keys, u32 rounds, const u8* source, u8* target, SizeT count) {
+
+	__m128i k[15];
+
+	for (u32 r = 0; r <= rounds; r++) {
+		k[r] = _mm_load_si128(reinterpret_cast<const __m128i*>(keys + r * 16));
+	}
+
+	SizeT i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+
+		__m128i b[8];
+
+		for (u32 j = 0; j < 8; j++) {
+			b[j] = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + (i + j) * 16)), k[0]);
+		}
+
+		for (u32 r = 1; r < rounds; r++) {
+
+			for (u32 j = 0; j < 8; j++) {
+				b[j] = roundNI<Inverse>(b[j], k[r]);
+			}
+
+		}
+
+		for (u32 j = 0; j < 8; j++) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target + (i + j) * 16), lastRoundNI<Inverse>(b[j], k[rounds]));
+		}
+
+	}
+
+	for (; i < count; i++) {
+
+		__m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 16)), k[0]);
+
+		for (u32 r = 1; r < rounds; r++) {
+			b = roundNI<Inverse>(b, k[r]);
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i * 16), lastRoundNI<Inverse>(b, k[rounds]));
+
+	}
+
+}
+
+
+
+//Adds n to the counter held as two native halves, limited to the low width bytes
+ARC_FORCE_INLINE static void addCounter(u64& high, u64& low, u64 n, u32 width) {
+
+	if (width == 4) {
+
+		low = (low & 0xFFFFFFFF00000000) | u32(low + n);
+
+	} else {
+
+		u64 sum = low + n;
+		high += sum < low;
+		low = sum;
+
+	}
+
+}
+
+
+
+//CTR keeping the counter in registers and encrypting eight counter blocks in flight
+ARC_TARGET("aes,ssse3") static void counterNI(const u8* keys, u32 rounds, const u8* counter, u32 width, const u8* source, u8* target, SizeT size) {
+
+	const __m128i mask = _mm_set_epi64x(0x08090A0B0C0D0E0F, 0x0001020304050607);
+
+	__m128i k[15];
+
+	for (u32 r = 0; r <= rounds; r++) {
+		k[r] = _mm_load_si128(reinterpret_cast<const __m128i*>(keys + r * 16));
+	}
+
+	u64 high = Bits::big64(Bits::assemble<u64>(counter));
+	u64 low = Bits::big64(Bits::assemble<u64>(counter + 8));
+
+	SizeT i = 0;
+
+	for (; i + 128 <= size; i += 128) {
+
+		__m128i b[8];
+
+		for (u32 j = 0; j < 8; j++) {
+
+			b[j] = _mm_xor_si128(_mm_shuffle_epi8(_mm_set_epi64x(low, high), mask), k[0]);
+			addCounter(high, low, 1, width);
+
+		}
+
+		for (u32 r = 1; r < rounds; r++) {
+
+			for (u32 j = 0; j < 8; j++) {
+				b[j] = _mm_aesenc_si128(b[j], k[r]);
+			}
+
+		}
+
+		for (u32 j = 0; j < 8; j++) {
+
+			__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i + j * 16));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(target + i + j * 16), _mm_xor_si128(x, _mm_aesenclast_si128(b[j], k[rounds])));
+
+		}
+
+	}
+
+	for (; i < size; i += 16) {
+
+		__m128i b = _mm_xor_si128(_mm_shuffle_epi8(_mm_set_epi64x(low, high), mask), k[0]);
+		addCounter(high, low, 1, width);
+
+		for (u32 r = 1; r < rounds; r++) {
+			b = _mm_aesenc_si128(b, k[r]);
+		}
+
+		alignas(16) u8 keystream[16];
+		_mm_store_si128(reinterpret_cast<__m128i*>(keystream), _mm_aesenclast_si128(b, k[rounds]));
+
+		SizeT bytes = std::min<SizeT>(size - i, 16);
+
+		for (SizeT j = 0; j < bytes; j++) {
+			target[i + j] = source[i + j] ^ keystream[j];
+		}
+
+	}
+
+}
+
+
+
+/*
+	GHASH with PCLMULQDQ
+	Operands are byte reversed so that the carry-less product of the bit reflected field elements only needs a shift by one before the reduction.
+*/
+ARC_TARGET("pclmul,sse2") ARC_FORCE_INLINE static void clmulGF128(__m128i a, __m128i b, __m128i& low, __m128i& high) {
+
+	__m128i l = _mm_clmulepi64_si128(a, b, 0x00);
+	__m128i m = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10), _mm_clmulepi64_si128(a, b, 0x01));
+	__m128i h = _mm_clmulepi64_si128(a, b, 0x11);
+
+	low = _mm_xor_si128(l, _mm_slli_si128(m, 8));
+	high = _mm_xor_si128(h, _mm_srli_si128(m, 8));
+
+}
+
+
+
+ARC_TARGET("pclmul,sse2") ARC_FORCE_INLINE static __m128i reduceGF128(__m128i low, __m128i high) {
+
+	//Shift the 256 bit product left by one
+	__m128i lowCarry = _mm_srli_epi32(low, 31);
+	__m128i highCarry = _mm_srli_epi32(high, 31);
+
+	low = _mm_slli_epi32(low, 1);
+	high = _mm_slli_epi32(high, 1);
+
+	high = _mm_or_si128(_mm_or_si128(high, _mm_slli_si128(highCarry, 4)), _mm_srli_si128(lowCarry, 12));
+	low = _mm_or_si128(low, _mm_slli_si128(lowCarry, 4));
+
+	//Reduce modulo x^128 + x^7 + x^2 + x + 1
+	__m128i a = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(low, 31), _mm_slli_epi32(low, 30)), _mm_slli_epi32(low, 25));
+	__m128i carry = _mm_srli_si128(a, 4);
+
+	low = _mm_xor_si128(low, _mm_slli_si128(a, 12));
+
+	__m128i b = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(low, 1), _mm_srli_epi32(low, 2)), _mm_srli_epi32(low, 7));
+
+	return _mm_xor_si128(high, _mm_xor_si128(low, _mm_xor_si128(b, carry)));
+
+}
+
+
+
+ARC_TARGET("pclmul,sse2") ARC_FORCE_INLINE static __m128i multiplyCLMUL(__m128i a, __m128i b) {
+
+	__m128i low, high;
+	clmulGF128(a, b, low, high);
+
+	return reduceGF128(low, high);
+
+}
+
+
+
+ARC_TARGET("pclmul,ssse3") static void ghashCLMUL(u8* y, const u8* h, const u8* data, SizeT size) {
+
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607, 0x08090A0B0C0D0E0F);
+
+	__m128i x = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y)), mask);
+	__m128i h1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(h)), mask);
+	__m128i h2 = multiplyCLMUL(h1, h1);
+	__m128i h3 = multiplyCLMUL(h2, h1);
+	__m128i h4 = multiplyCLMUL(h3, h1);
+
+	SizeT i = 0;
+
+	//Four blocks share one reduction: x' = (x + b0)h^4 + b1h^3 + b2h^2 + b3h
+	for (; i + 64 <= size; i += 64) {
+
+		__m128i b0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), mask);
+		__m128i b1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16)), mask);
+		__m128i b2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 32)), mask);
+		__m128i b3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 48)), mask);
+
+		__m128i low, high, l, t;
+
+		clmulGF128(_mm_xor_si128(x, b0), h4, low, high);
+
+		clmulGF128(b1, h3, l, t);
+		low = _mm_xor_si128(low, l);
+		high = _mm_xor_si128(high, t);
+
+		clmulGF128(b2, h2, l, t);
+		low = _mm_xor_si128(low, l);
+		high = _mm_xor_si128(high, t);
+
+		clmulGF128(b3, h1, l, t);
+		low = _mm_xor_si128(low, l);
+		high = _mm_xor_si128(high, t);
+
+		x = reduceGF128(low, high);
+
+	}
+
+	for (; i < size; i += 16) {
+
+		alignas(16) u8 block[16] = {};
+		std::memcpy(block, data + i, std::min<SizeT>(size - i, 16));
+
+		x = multiplyCLMUL(_mm_xor_si128(x, _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i*>(block)), mask)), h1);
+
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(y), _mm_shuffle_epi8(x, mask));
+
+}
+
+#endif
+
+
+
+struct Implementation {
+
+	BlockFunction encrypt;
+	BlockFunction decrypt;
+	CounterFunction counter;
+	GHashFunction ghash;
+
+};
+
+
+
+static const Implementation& implementation() {
+
+	static const Implementation impl = []() {
+
+		Implementation i = {cryptBlocksPortable<false>, cryptBlocksPortable<true>, counterPortable, ghashPortable};
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::AES)) {
+
+			i.encrypt = cryptBlocksNI<false>;
+			i.decrypt = cryptBlocksNI<true>;
+			i.counter = counterNI;
+
+		}
+
+		if (CPUID::hasFeature(CPUFeature::PCLMULQDQ) && CPUID::hasFeature(CPUFeature::SSSE3)) {
+			i.ghash = ghashCLMUL;
+		}
+
+#endif
+
+		return i;
+
+	}();
+
+	return impl;
+
+}
+
+
+
+AES::Cipher::Cipher(const std::span<const u8>& key) {
+
+	u32 keyWords = key.size() / 4;
+
+	arc_assert(keyWords == 4 || keyWords == 6 || keyWords == 8, "Illegal AES key size");
+
+	rounds = keyWords + 6;
+
+	u32 totalWords = (rounds + 1) * 4;
+	u8* w = encryptionKeys;
+
+	std::copy(key.begin(), key.end(), w);
+
+	for (u32 i = keyWords; i < totalWords; i++) {
+
+		u8 t[4];
+		std::copy_n(w + (i - 1) * 4, 4, t);
+
+		if (i % keyWords == 0 || (keyWords > 6 && i % keyWords == 4)) {
+
+			if (i % keyWords == 0) {
+				std::rotate(t, t + 1, t + 4);
+			}
+
+			//The key schedule reuses the constant time S-box
+			u8 s[64] = {};
+			std::copy_n(t, 4, s);
+			subBytes<false>(s);
+			std::copy_n(s, 4, t);
+
+			if (i % keyWords == 0) {
+				t[0] ^= roundConstants[i / keyWords - 1];
+			}
+
+		}
+
+		for (u32 j = 0; j < 4; j++) {
+			w[i * 4 + j] = w[(i - keyWords) * 4 + j] ^ t[j];
+		}
+
+	}
+
+	//Equivalent inverse cipher: reversed round keys with InvMixColumns applied to the inner ones
+	for (u32 r = 0; r <= rounds; r++) {
+
+		u8* dk = decryptionKeys + r * 16;
+		std::copy_n(encryptionKeys + (rounds - r) * 16, 16, dk);
+
+		if (r != 0 && r != rounds) {
+			mixColumns<true>(dk);
+		}
+
+	}
+
+}
+
+
+
+void AES::Cipher::encryptBlocks(const u8* source, u8* target, SizeT count) const {
+	implementation().encrypt(encryptionKeys, rounds, source, target, count);
+}
+
+
+
+void AES::Cipher::decryptBlocks(const u8* source, u8* target, SizeT count) const {
+	implementation().decrypt(decryptionKeys, rounds, source, target, count);
+}
+
+
+
+void AES::Cipher::applyKeystream(const Block& counter, u32 counterWidth, const u8* source, u8* target, SizeT size) const {
+	implementation().counter(encryptionKeys, rounds, counter.data(), counterWidth, source, target, size);
+}
+
+
+
+u32 AES::Cipher::getRounds() const {
+	return rounds;
+}
+
+
+
+std::vector<u8> AES::encrypt(const std::span<const u8>& data, const Cipher& cipher) {
+
+	std::vector<u8> result(Math::alignUp(data.size(), BlockSize));
+
+	std::copy(data.begin(), data.end(), result.begin());
+	cipher.encryptBlocks(result.data(), result.data(), result.size() / BlockSize);
+
+	return result;
+
+}
+
+
+
+std::vector<u8> AES::decrypt(const std::span<const u8>& data, const Cipher& cipher) {
+
+	std::vector<u8> result(Math::alignUp(data.size(), BlockSize));
+
+	std::copy(data.begin(), data.end(), result.begin());
+	cipher.decryptBlocks(result.data(), result.data(), result.size() / BlockSize);
+
+	result.resize(data.size());
+
+	return result;
+
+}
+
+
+
+//CTR over a counter of width bytes, chunks of ParallelChunkBlocks run as independent tasks
+static void processCounter(const u8* source, u8* target, SizeT size, const AES::Cipher& cipher, const AES::Block& counter, u32 width, ThreadPool* threadPool) {
+
+	constexpr SizeT ChunkSize = ParallelChunkBlocks * AES::BlockSize;
+
+	SizeT chunks = (size + ChunkSize - 1) / ChunkSize;
+
+	if (threadPool && chunks > 1) {
+
+		threadPool->parallelFor(0, chunks, [&](SizeT chunk) {
+
+			AES::Block chunkCounter = counter;
+			addCounter(chunkCounter.data(), chunk * ParallelChunkBlocks, width);
+
+			SizeT offset = chunk * ChunkSize;
+			cipher.applyKeystream(chunkCounter, width, source + offset, target + offset, std::min(size - offset, ChunkSize));
+
+		}, 1);
+
+	} else {
+
+		cipher.applyKeystream(counter, width, source, target, size);
+
+	}
+
+}
+
+
+
+void AES::processCTR(const u8* source, u8* target, SizeT size, const Cipher& cipher, const Block& counter, ThreadPool* threadPool) {
+	processCounter(source, target, size, cipher, counter, BlockSize, threadPool);
+}
+
+
+
+std::vector<u8> AES::encryptCTR(const std::span<const u8>& data, const Cipher& cipher, const Block& counter, ThreadPool* threadPool) {
+
+	std::vector<u8> result(data.size());
+	processCTR(data.data(), result.data(), data.size(), cipher, counter, threadPool);
+
+	return result;
+
+}
+
+
+
+std::vector<u8> AES::decryptCTR(const std::span<const u8>& data, const Cipher& cipher, const Block& counter, ThreadPool* threadPool) {
+	return encryptCTR(data, cipher, counter, threadPool);
+}
+
+
+
+//Computes the GCM tag over aad and ciphertext, j0 is the pre-counter block
+static AES::Tag computeTag(const AES::Cipher& cipher, const AES::Block& j0, const std::span<const u8>& aad, const std::span<const u8>& ciphertext) {
+
+	GHashFunction ghash = implementation().ghash;
+
+	AES::Block h = {};
+	cipher.encryptBlocks(h.data(), h.data(), 1);
+
+	u8 lengths[16];
+	Bits::disassemble(Bits::big64(u64(aad.size()) * 8), lengths);
+	Bits::disassemble(Bits::big64(u64(ciphertext.size()) * 8), lengths + 8);
+
+	u8 y[16] = {};
+	ghash(y, h.data(), aad.data(), aad.size());
+	ghash(y, h.data(), ciphertext.data(), ciphertext.size());
+	ghash(y, h.data(), lengths, 16);
+
+	AES::Tag tag;
+	cipher.encryptBlocks(j0.data(), tag.data(), 1);
+
+	for (u32 i = 0; i < AES::TagSize; i++) {
+		tag[i] ^= y[i];
+	}
+
+	return tag;
+
+}
+
+
+
+static AES::Block preCounterBlock(const AES::Nonce& nonce) {
+
+	AES::Block j0 = {};
+
+	std::copy(nonce.begin(), nonce.end(), j0.begin());
+	j0[15] = 1;
+
+	return j0;
+
+}
+
+
+
+std::vector<u8> AES::encryptGCM(const std::span<const u8>& data, const Cipher& cipher, const Nonce& nonce, const std::span<const u8>& aad, ThreadPool* threadPool) {
+
+	Block j0 = preCounterBlock(nonce);
+	Block counter = j0;
+	addCounter(counter.data(), 1, 4);
+
+	std::vector<u8> result(data.size() + TagSize);
+	processCounter(data.data(), result.data(), data.size(), cipher, counter, 4, threadPool);
+
+	Tag tag = computeTag(cipher, j0, aad, std::span<const u8>(result.data(), data.size()));
+	std::copy(tag.begin(), tag.end(), result.end() - TagSize);
+
+	return result;
+
+}
+
+
+
+std::optional<std::vector<u8>> AES::decryptGCM(const std::span<const u8>& data, const Cipher& cipher, const Nonce& nonce, const std::span<const u8>& aad, ThreadPool* threadPool) {
+
+	if (data.size() < TagSize) {
+		return std::nullopt;
+	}
+
+	std::span<const u8> ciphertext = data.first(data.size() - TagSize);
+
+	Block j0 = preCounterBlock(nonce);
+	Tag tag = computeTag(cipher, j0, aad, ciphertext);
+
+	//Compare without early exit to not leak the position of the first mismatch
+	u8 difference = 0;
+
+	for (u32 i = 0; i < TagSize; i++) {
+		difference |= tag[i] ^ data[ciphertext.size() + i];
+	}
+
+	if (difference) {
+		return std::nullopt;
+	}
+
+	Block counter = j0;
+	addCounter(counter.data(), 1, 4);
+
+	std::vector<u8> result(ciphertext.size());
+	processCounter(ciphertext.data(), result.data(), ciphertext.size(), cipher, counter, 4, threadPool);
+
+	return result;
+
+}
\ No newline at end of file
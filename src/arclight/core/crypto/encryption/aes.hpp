@@ -0,0 +1,134 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 aes.hpp
+ */
+
+#pragma once
+
+#include "key.hpp"
+#include "types.hpp"
+
+#include <array>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+
+class ThreadPool;
+
+
+
+namespace AES {
+
+	constexpr SizeT BlockSize = 16;
+	constexpr SizeT TagSize = 16;
+
+	using Block = std::array<u8, BlockSize>;
+	using Nonce = std::array<u8, 12>;
+	using Tag = std::array<u8, TagSize>;
+
+
+	/*
+		AES-128/192/256 block cipher with an expanded key schedule.
+		The key bytes are taken in Key::toArray() order.
+
+		Blocks are processed with AES-NI if available, eight at a time to hide the instruction latency.
+		The fallback computes the S-box as a bitsliced circuit over 64 bytes at once and uses no lookup tables, hence it runs in constant time.
+	*/
+	class Cipher {
+
+	public:
+
+		template<SizeT KeySize> requires (KeySize == 128 || KeySize == 192 || KeySize == 256)
+		explicit Cipher(const Key<KeySize>& key) : Cipher(std::span<const u8>(key.toArray())) {}
+
+		//Encrypts/Decrypts count consecutive blocks, source and target may be identical
+		void encryptBlocks(const u8* source, u8* target, SizeT count) const;
+		void decryptBlocks(const u8* source, u8* target, SizeT count) const;
+
+		//XORs the keystream of consecutive counter blocks into source, the low counterWidth bytes form a big endian counter that wraps around
+		void applyKeystream(const Block& counter, u32 counterWidth, const u8* source, u8* target, SizeT size) const;
+
+		u32 getRounds() const;
+
+	private:
+
+		explicit Cipher(const std::span<const u8>& key);
+
+		u32 rounds;
+
+		//Round keys for encryption and the equivalent inverse cipher
+		alignas(16) u8 encryptionKeys[15 * BlockSize];
+		alignas(16) u8 decryptionKeys[15 * BlockSize];
+
+	};
+
+
+	/*
+		Electronic codebook mode, mirroring DES::encrypt/decrypt.
+		The input is zero-padded to a multiple of the block size, decrypt() truncates the result to the input size.
+	*/
+	std::vector<u8> encrypt(const std::span<const u8>& data, const Cipher& cipher);
+	std::vector<u8> decrypt(const std::span<const u8>& data, const Cipher& cipher);
+
+
+	/*
+		Counter mode. counter is the initial counter block, incremented as a 128 bit big endian integer per block.
+		Encryption and decryption are the same operation. source and target may be identical.
+		Large buffers are split into independent counter ranges and processed on threadPool if given.
+	*/
+	void processCTR(const u8* source, u8* target, SizeT size, const Cipher& cipher, const Block& counter, ThreadPool* threadPool = nullptr);
+
+	std::vector<u8> encryptCTR(const std::span<const u8>& data, const Cipher& cipher, const Block& counter, ThreadPool* threadPool = nullptr);
+	std::vector<u8> decryptCTR(const std::span<const u8>& data, const Cipher& cipher, const Block& counter, ThreadPool* threadPool = nullptr);
+
+
+	/*
+		Galois/Counter mode with a 96 bit nonce. A nonce must never be reused with the same key.
+		encryptGCM() returns the ciphertext followed by the 16 byte tag authenticating both the ciphertext and aad.
+		decryptGCM() expects the same layout and returns std::nullopt if authentication fails.
+		GHASH uses PCLMULQDQ with four blocks aggregated per reduction if available.
+	*/
+	std::vector<u8> encryptGCM(const std::span<const u8>& data, const Cipher& cipher, const Nonce& nonce, const std::span<const u8>& aad = {}, ThreadPool* threadPool = nullptr);
+	std::optional<std::vector<u8>> decryptGCM(const std::span<const u8>& data, const Cipher& cipher, const Nonce& nonce, const std::span<const u8>& aad = {}, ThreadPool* threadPool = nullptr);
+
+
+	/*
+		Key overloads expanding the key schedule per call.
+		Construct a Cipher once when encrypting repeatedly with the same key.
+	*/
+	template<SizeT KeySize>
+	std::vector<u8> encrypt(const std::span<const u8>& data, const Key<KeySize>& key) {
+		return encrypt(data, Cipher(key));
+	}
+
+	template<SizeT KeySize>
+	std::vector<u8> decrypt(const std::span<const u8>& data, const Key<KeySize>& key) {
+		return decrypt(data, Cipher(key));
+	}
+
+	template<SizeT KeySize>
+	std::vector<u8> encryptCTR(const std::span<const u8>& data, const Key<KeySize>& key, const Block& counter, ThreadPool* threadPool = nullptr) {
+		return encryptCTR(data, Cipher(key), counter, threadPool);
+	}
+
+	template<SizeT KeySize>
+	std::vector<u8> decryptCTR(const std::span<const u8>& data, const Key<KeySize>& key, const Block& counter, ThreadPool* threadPool = nullptr) {
+		return decryptCTR(data, Cipher(key), counter, threadPool);
+	}
+
+	template<SizeT KeySize>
+	std::vector<u8> encryptGCM(const std::span<const u8>& data, const Key<KeySize>& key, const Nonce& nonce, const std::span<const u8>& aad = {}, ThreadPool* threadPool = nullptr) {
+		return encryptGCM(data, Cipher(key), nonce, aad, threadPool);
+	}
+
+	template<SizeT KeySize>
+	std::optional<std::vector<u8>> decryptGCM(const std::span<const u8>& data, const Key<KeySize>& key, const Nonce& nonce, const std::span<const u8>& aad = {}, ThreadPool* threadPool = nullptr) {
+		return decryptGCM(data, Cipher(key), nonce, aad, threadPool);
+	}
+
+}
\ No newline at end of file
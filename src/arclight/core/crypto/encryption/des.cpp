@@ -0,0 +1,347 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 des.cpp
+ */
+
+#include "des.hpp"
+#include "concurrent/threadpool.hpp"
+
+#include <algorithm>
+
+
+
+/*
+	Bit numbering follows the standard: bit 1 is the most significant bit of a block, key or subkey.
+	Blocks and keys are the integers assembled from their bytes, which is how __Detail::process reads them.
+*/
+
+using PermutationTable = std::array<std::array<u64, 256>, 8>;
+using SPTable = std::array<std::array<u32, 64>, 8>;
+
+//Blocks per task when splitting across threads
+constexpr static SizeT ParallelChunkBlocks = 8192;
+
+
+
+//Maps every input byte to its contribution to the permuted block, table[i] lists the source bit of output bit i + 1
+constexpr static PermutationTable makePermutationTable(const u8 (&table)[64]) {
+
+	PermutationTable t{};
+
+	for (u32 b = 0; b < 8; b++) {
+
+		for (u32 v = 0; v < 256; v++) {
+
+			u64 in = u64(v) << (b * 8);
+			u64 out = 0;
+
+			for (u32 i = 0; i < 64; i++) {
+				out |= ((in >> (64 - table[i])) & 1) << (63 - i);
+			}
+
+			t[b][v] = out;
+
+		}
+
+	}
+
+	return t;
+
+}
+
+
+
+//Combines S-box i with the P permutation, indexed by the six input bits of the S-box
+constexpr static SPTable makeSPTable() {
+
+	SPTable t{};
+
+	for (u32 i = 0; i < 8; i++) {
+
+		for (u32 x = 0; x < 64; x++) {
+
+			u32 row = ((x >> 4) & 2) | (x & 1);
+			u32 col = (x >> 1) & 0xF;
+			u32 v = u32(DES::__Detail::s[i][row * 16 + col]) << (28 - i * 4);
+			u32 out = 0;
+
+			for (u32 j = 0; j < 32; j++) {
+				out |= ((v >> (32 - DES::__Detail::p[j])) & 1) << (31 - j);
+			}
+
+			t[i][x] = out;
+
+		}
+
+	}
+
+	return t;
+
+}
+
+
+
+constexpr static PermutationTable initialPermutation = makePermutationTable(DES::__Detail::ip);
+constexpr static PermutationTable finalPermutation = makePermutationTable(DES::__Detail::p1);
+constexpr static SPTable spTable = makeSPTable();
+
+
+
+static u64 permute(const PermutationTable& table, u64 block) {
+
+	u64 out = 0;
+
+	for (u32 b = 0; b < 8; b++) {
+		out |= table[b][(block >> (b * 8)) & 0xFF];
+	}
+
+	return out;
+
+}
+
+
+
+//Expands r to eight six bit groups (E), mixes in the subkey and substitutes/permutes them
+static u32 feistel(u32 r, const u8* subkey) {
+
+	u32 out = 0;
+
+	for (u32 i = 0; i < 8; i++) {
+
+		//Group i spans bits 4i to 4i + 5 of r, wrapping around
+		u32 group = Bits::ror(r, (27 - i * 4) % 32) & 0x3F;
+		out |= spTable[i][group ^ subkey[i]];
+
+	}
+
+	return out;
+
+}
+
+
+
+static void generateSubkeys(const Key<64>& key, u8 (&subkeys)[16][8]) {
+
+	u64 k = Bits::assemble<u64>(key.toArray().data());
+	u64 cd = 0;
+
+	//PC1 selects 56 bits, cd holds them right aligned
+	for (u32 i = 0; i < 56; i++) {
+		cd |= ((k >> (64 - DES::__Detail::pc1[i])) & 1) << (55 - i);
+	}
+
+	u32 c = cd >> 28;
+	u32 d = cd & 0xFFFFFFF;
+
+	for (u32 r = 0; r < 16; r++) {
+
+		u32 shift = Bool::any(r, 0, 1, 8, 15) ? 1 : 2;
+
+		c = ((c << shift) | (c >> (28 - shift))) & 0xFFFFFFF;
+		d = ((d << shift) | (d >> (28 - shift))) & 0xFFFFFFF;
+
+		u64 joined = (u64(c) << 28) | d;
+		u64 subkey = 0;
+
+		//PC2 selects 48 bits
+		for (u32 i = 0; i < 48; i++) {
+			subkey |= ((joined >> (56 - DES::__Detail::pc2[i])) & 1) << (47 - i);
+		}
+
+		for (u32 i = 0; i < 8; i++) {
+			subkeys[r][i] = (subkey >> (42 - i * 6)) & 0x3F;
+		}
+
+	}
+
+}
+
+
+
+template<bool Decrypt>
+static u64 cryptBlock(u64 block, const u8 (&subkeys)[16][8]) {
+
+	block = permute(initialPermutation, block);
+
+	u32 l = block >> 32;
+	u32 r = block;
+
+	for (u32 i = 0; i < 16; i++) {
+
+		u32 t = l ^ feistel(r, subkeys[Decrypt ? 15 - i : i]);
+		l = r;
+		r = t;
+
+	}
+
+	return permute(finalPermutation, (u64(r) << 32) | l);
+
+}
+
+
+
+DES::Cipher::Cipher(const Key<64>& key) : stages(1) {
+	generateSubkeys(key, subkeys[0]);
+}
+
+
+
+DES::Cipher::Cipher(const Key<64>& key1, const Key<64>& key2) : Cipher(key1, key2, key1) {}
+
+
+
+DES::Cipher::Cipher(const Key<64>& key1, const Key<64>& key2, const Key<64>& key3) : stages(3) {
+
+	generateSubkeys(key1, subkeys[0]);
+	generateSubkeys(key2, subkeys[1]);
+	generateSubkeys(key3, subkeys[2]);
+
+}
+
+
+
+void DES::Cipher::encryptBlocks(const u8* source, u8* target, SizeT count) const {
+	processBlocks<false>(source, target, count);
+}
+
+
+
+void DES::Cipher::decryptBlocks(const u8* source, u8* target, SizeT count) const {
+	processBlocks<true>(source, target, count);
+}
+
+
+
+void DES::Cipher::applyKeystream(u64 counter, const u8* source, u8* target, SizeT size) const {
+
+	for (SizeT i = 0; i < size; i += 8) {
+
+		u8 keystream[8];
+		Bits::disassemble(counter++, keystream);
+		encryptBlocks(keystream, keystream, 1);
+
+		SizeT bytes = std::min<SizeT>(size - i, 8);
+
+		for (SizeT j = 0; j < bytes; j++) {
+			target[i + j] = source[i + j] ^ keystream[j];
+		}
+
+	}
+
+}
+
+
+
+template<bool Decrypt>
+void DES::Cipher::processBlocks(const u8* source, u8* target, SizeT count) const {
+
+	for (SizeT i = 0; i < count; i++) {
+
+		u64 block = Bits::assemble<u64>(source + i * 8);
+
+		if (stages == 1) {
+
+			block = cryptBlock<Decrypt>(block, subkeys[0]);
+
+		} else if constexpr (Decrypt) {
+
+			//EDE reversed: decrypt with key3, encrypt with key2, decrypt with key1
+			block = cryptBlock<true>(block, subkeys[2]);
+			block = cryptBlock<false>(block, subkeys[1]);
+			block = cryptBlock<true>(block, subkeys[0]);
+
+		} else {
+
+			block = cryptBlock<false>(block, subkeys[0]);
+			block = cryptBlock<true>(block, subkeys[1]);
+			block = cryptBlock<false>(block, subkeys[2]);
+
+		}
+
+		Bits::disassemble(block, target + i * 8);
+
+	}
+
+}
+
+
+
+//Runs function(offset, size) on chunks of ParallelChunkBlocks blocks, on threadPool if given
+template<class Function>
+static void forEachChunk(SizeT size, ThreadPool* threadPool, Function&& function) {
+
+	constexpr SizeT ChunkSize = ParallelChunkBlocks * 8;
+
+	SizeT chunks = (size + ChunkSize - 1) / ChunkSize;
+
+	if (threadPool && chunks > 1) {
+
+		threadPool->parallelFor(0, chunks, [&](SizeT chunk) {
+
+			SizeT offset = chunk * ChunkSize;
+			function(offset, std::min(size - offset, ChunkSize));
+
+		}, 1);
+
+	} else if (size) {
+
+		function(0, size);
+
+	}
+
+}
+
+
+
+std::vector<u8> DES::encrypt(const std::span<const u8>& data, const Cipher& cipher, ThreadPool* threadPool) {
+
+	std::vector<u8> result(Math::alignUp(data.size(), 8));
+	std::copy(data.begin(), data.end(), result.begin());
+
+	forEachChunk(result.size(), threadPool, [&](SizeT offset, SizeT size) {
+		cipher.encryptBlocks(result.data() + offset, result.data() + offset, size / 8);
+	});
+
+	return result;
+
+}
+
+
+
+std::vector<u8> DES::decrypt(const std::span<const u8>& data, const Cipher& cipher, ThreadPool* threadPool) {
+
+	std::vector<u8> result(Math::alignUp(data.size(), 8));
+	std::copy(data.begin(), data.end(), result.begin());
+
+	forEachChunk(result.size(), threadPool, [&](SizeT offset, SizeT size) {
+		cipher.decryptBlocks(result.data() + offset, result.data() + offset, size / 8);
+	});
+
+	result.resize(data.size());
+
+	return result;
+
+}
+
+
+
+std::vector<u8> DES::encryptCTR(const std::span<const u8>& data, const Cipher& cipher, u64 counter, ThreadPool* threadPool) {
+
+	std::vector<u8> result(data.size());
+
+	forEachChunk(data.size(), threadPool, [&](SizeT offset, SizeT size) {
+		cipher.applyKeystream(counter + offset / 8, data.data() + offset, result.data() + offset, size);
+	});
+
+	return result;
+
+}
+
+
+
+std::vector<u8> DES::decryptCTR(const std::span<const u8>& data, const Cipher& cipher, u64 counter, ThreadPool* threadPool) {
+	return encryptCTR(data, cipher, counter, threadPool);
+}
\ No newline at end of file
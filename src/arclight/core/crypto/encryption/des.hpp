@@ -12,9 +12,15 @@
 #include "common/typetraits.hpp"
 #include "util/bits.hpp"
 #include "util/assert.hpp"
+#include "util/bool.hpp"
 
 #include <span>
 #include <array>
+#include <vector>
+
+
+
+class ThreadPool;
 
 
 
@@ -142,7 +148,7 @@ namespace DES {
 
 			SizeT remaining = bytes.size() - position;
 
-			return Bits::assemble<u64>(bytes.data(), Math::min(remaining, 8));
+			return Bits::assemble<u64>(bytes.data() + position, Math::min(remaining, 8));
 
 		}
 
@@ -161,7 +167,7 @@ namespace DES {
 
 		template<bool Upper>
 		constexpr u32 splitKey(const Key<56>& key) {
-			return key.subKey<Upper ? 28 : 0, 28>().bits().read<u32>(28);
+			return key.template subKey<Upper ? 28 : 0, 28>().bits().template read<u32>(28);
 		}
 
 		constexpr Key<48> concatKeys(u32 keyL, u32 keyR) {
@@ -287,7 +293,7 @@ namespace DES {
 
 			for (u32 s = 0; s < 16; s++) {
 
-				u8 shift = Bool::any(s, 0, 1, 8, 15) ? 1 : 2;
+				u8 shift = Bool::any(s, 0u, 1u, 8u, 15u) ? 1 : 2;
 
 				// Shift the two keys to the left
 				keyL = shiftKey(keyL, shift);
@@ -349,7 +355,7 @@ namespace DES {
 
 	}
 
-	auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<64>& key) {
+	inline auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<64>& key) {
 
 		// Calculate size aligned to 8 bytes
 		SizeT alignedSize = Math::alignUp(data.size(), 8);
@@ -396,6 +402,54 @@ namespace DES {
 
 	}
 
+
+
+	/*
+		Bulk DES/TripleDES for large inputs.
+		Rounds look up combined S-box/P tables, the initial and final permutations are applied bytewise through tables.
+		Results match encrypt()/decrypt() byte for byte. Large inputs are split across threadPool if given.
+
+		One key yields DES, two or three keys TripleDES in EDE mode as in the TripleDES namespace.
+	*/
+	class Cipher {
+
+	public:
+
+		explicit Cipher(const Key<64>& key);
+		Cipher(const Key<64>& key1, const Key<64>& key2);
+		Cipher(const Key<64>& key1, const Key<64>& key2, const Key<64>& key3);
+
+		//Encrypts/Decrypts count consecutive 8 byte blocks, source and target may be identical
+		void encryptBlocks(const u8* source, u8* target, SizeT count) const;
+		void decryptBlocks(const u8* source, u8* target, SizeT count) const;
+
+		//Encrypts the blocks counter, counter + 1, ... and XORs them into source
+		void applyKeystream(u64 counter, const u8* source, u8* target, SizeT size) const;
+
+	private:
+
+		template<bool Decrypt>
+		void processBlocks(const u8* source, u8* target, SizeT count) const;
+
+		u32 stages;
+
+		//Six bit subkey groups per round and stage
+		u8 subkeys[3][16][8];
+
+	};
+
+
+	//Electronic codebook mode, equivalent to encrypt()/decrypt() with the cipher's keys
+	std::vector<u8> encrypt(const std::span<const u8>& data, const Cipher& cipher, ThreadPool* threadPool = nullptr);
+	std::vector<u8> decrypt(const std::span<const u8>& data, const Cipher& cipher, ThreadPool* threadPool = nullptr);
+
+	/*
+		Counter mode. Block i of the keystream is the encryption of counter + i, stored like an encrypt() output.
+		Encryption and decryption are the same operation, the data is not padded.
+	*/
+	std::vector<u8> encryptCTR(const std::span<const u8>& data, const Cipher& cipher, u64 counter, ThreadPool* threadPool = nullptr);
+	std::vector<u8> decryptCTR(const std::span<const u8>& data, const Cipher& cipher, u64 counter, ThreadPool* threadPool = nullptr);
+
 }
 
 
@@ -412,7 +466,7 @@ namespace TripleDES {
 		return DES::encrypt<Extent>(data, key);
 	}
 
-	auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<64>& key) {
+	inline auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<64>& key) {
 		return DES::encrypt(data, key);
 	}
 
@@ -450,7 +504,7 @@ namespace TripleDES {
 
 	}
 
-	auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<64>& key1, const Key<64>& key2) {
+	inline auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<64>& key1, const Key<64>& key2) {
 
 		// Calculate size aligned to 8 bytes
 		SizeT alignedSize = Math::alignUp(data.size(), 8);
@@ -518,7 +572,7 @@ namespace TripleDES {
 		return encrypt<Extent>(data, key.subKey<0, 64>(), key.subKey<64, 64>());
 	}
 
-	auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<128>& key) {
+	inline auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<128>& key) {
 		return encrypt(data, key.subKey<0, 64>(), key.subKey<64, 64>());
 	}
 
@@ -528,7 +582,7 @@ namespace TripleDES {
 		return decrypt<Extent>(data, key.subKey<0, 64>(), key.subKey<64, 64>());
 	}
 
-	auto decrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<128>& key) {
+	inline auto decrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<128>& key) {
 		return decrypt(data, key.subKey<0, 64>(), key.subKey<64, 64>());
 	}
 
@@ -555,7 +609,7 @@ namespace TripleDES {
 
 	}
 
-	auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<64>& key1, const Key<64>& key2, const Key<64>& key3) {
+	inline auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<64>& key1, const Key<64>& key2, const Key<64>& key3) {
 
 		// Calculate size aligned to 8 bytes
 		SizeT alignedSize = Math::alignUp(data.size(), 8);
@@ -584,13 +638,13 @@ namespace TripleDES {
 		std::array<u8, Math::alignUp(Extent, 8)> result{};
 
 		// Decrypt - first stage
-		__Detail::process(1, data, result, key1);
+		__Detail::process(1, data, result, key3);
 
 		// Encrypt - second stage
 		__Detail::process(0, result, result, key2);
 
 		// Decrypt - third stage
-		__Detail::process(1, result, result, key3);
+		__Detail::process(1, result, result, key1);
 
 		return result;
 
@@ -605,13 +659,13 @@ namespace TripleDES {
 		std::vector<u8> result(alignedSize);
 
 		// Decrypt - first stage
-		__Detail::process(1, data, result, key1);
+		__Detail::process(1, data, result, key3);
 
 		// Encrypt - second stage
 		__Detail::process(0, result, result, key2);
 
 		// Decrypt - third stage
-		__Detail::process(1, result, result, key3);
+		__Detail::process(1, result, result, key1);
 
 		return result;
 
@@ -623,7 +677,7 @@ namespace TripleDES {
 		return encrypt<Extent>(data, key.subKey<0, 64>(), key.subKey<64, 64>(), key.subKey<128, 64>());
 	}
 
-	auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<192>& key) {
+	inline auto encrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<192>& key) {
 		return encrypt(data, key.subKey<0, 64>(), key.subKey<64, 64>(), key.subKey<128, 64>());
 	}
 
@@ -633,8 +687,32 @@ namespace TripleDES {
 		return decrypt<Extent>(data, key.subKey<0, 64>(), key.subKey<64, 64>(), key.subKey<128, 64>());
 	}
 
-	auto decrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<192>& key) {
+	inline auto decrypt(const std::span<const u8, std::dynamic_extent>& data, const Key<192>& key) {
 		return decrypt(data, key.subKey<0, 64>(), key.subKey<64, 64>(), key.subKey<128, 64>());
 	}
 
+
+
+	/*
+	*	Bulk encryption/decryption, see DES::Cipher
+	*/
+
+	using Cipher = DES::Cipher;
+
+	inline std::vector<u8> encrypt(const std::span<const u8>& data, const Cipher& cipher, ThreadPool* threadPool = nullptr) {
+		return DES::encrypt(data, cipher, threadPool);
+	}
+
+	inline std::vector<u8> decrypt(const std::span<const u8>& data, const Cipher& cipher, ThreadPool* threadPool = nullptr) {
+		return DES::decrypt(data, cipher, threadPool);
+	}
+
+	inline std::vector<u8> encryptCTR(const std::span<const u8>& data, const Cipher& cipher, u64 counter, ThreadPool* threadPool = nullptr) {
+		return DES::encryptCTR(data, cipher, counter, threadPool);
+	}
+
+	inline std::vector<u8> decryptCTR(const std::span<const u8>& data, const Cipher& cipher, u64 counter, ThreadPool* threadPool = nullptr) {
+		return DES::decryptCTR(data, cipher, counter, threadPool);
+	}
+
 }
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "math/math.hpp"
+#include "stdext/bitspan.hpp"
 #include "util/bits.hpp"
 #include "util/string.hpp"
 #include "common/concepts.hpp"
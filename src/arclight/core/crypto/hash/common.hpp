@@ -18,77 +18,127 @@
 
 namespace Crypto {
 
-	template<SizeT Size> requires (Size == 64 || Size == 128)
-	struct MDConstruction {
+	/*
+		Incremental Merkle-Damgard driver shared by the MD5/SHA family.
+		Input of arbitrary size is buffered until a full block is available, complete blocks of the input are compressed in place.
+		The compressor receives a span of one or more whole blocks, allowing implementations to keep their state in registers across blocks.
+		finalize() appends the padding and the message length in bits as a 64 bit (128 bit for 128 byte blocks) integer of the given byte order.
+	*/
+	template<SizeT BlockSize> requires (BlockSize == 64 || BlockSize == 128)
+	class MDStream {
 
-		u8 prevLastBlock[Size];
-		u8 lastBlock[Size];
-		SizeT blocks;
-		bool prevBlockUsed;
+	public:
 
-	};
+		constexpr MDStream() noexcept : buffer{}, used(0), length(0) {}
 
-	template<SizeT Size>
-	constexpr void mdConstruct(MDConstruction<Size>& construct, const std::span<const u8>& data, ByteOrder order) {
+		constexpr void reset() noexcept {
 
-		constexpr bool bits64 = Size == 128;
-		SizeT blockSize = (bits64 ? 1024 : 512) / 8;
-		SizeT padOffset = blockSize - (bits64 ? 16 : 8);
+			used = 0;
+			length = 0;
 
-		//Lengths (SizeT will constrain the maximum size anyways)
-		SizeT bytes = data.size();
-		SizeT bits = bytes * 8;
+		}
 
-		//Helper variables
-		SizeT rem = bytes % blockSize;
-		SizeT lbStart = bytes / blockSize * blockSize;
+		template<class Compressor>
+		constexpr void update(std::span<const u8> data, Compressor&& compress) {
 
-		//Whether prevLastBlock will contain the second last block
-		construct.prevBlockUsed = rem >= padOffset;
-		
-		//Total block count
-		construct.blocks = bytes / blockSize + construct.prevBlockUsed + 1;
+			length += data.size();
 
-		//Fill last blocks
-		if(construct.prevBlockUsed) {
+			//Complete the pending block first
+			if (used) {
 
-			std::copy_n(data.data() + lbStart, rem, construct.prevLastBlock);
-			construct.prevLastBlock[rem] = 0x80;
-			
-			std::fill(construct.prevLastBlock + rem + 1, construct.prevLastBlock + blockSize, u8(0));
-			std::fill_n(construct.lastBlock, padOffset, 0);
+				SizeT count = std::min(BlockSize - used, data.size());
 
-		} else {
+				std::copy_n(data.data(), count, buffer + used);
+				used += count;
+				data = data.subspan(count);
 
-			std::copy_n(data.data() + lbStart, rem, construct.lastBlock);
-			construct.lastBlock[rem] = 0x80;
+				if (used < BlockSize) {
+					return;
+				}
 
-			std::fill(construct.lastBlock + rem + 1, construct.lastBlock + padOffset, u8(0));
+				compress(std::span<const u8>(buffer, BlockSize));
+				used = 0;
 
-		}
+			}
+
+			SizeT blockBytes = data.size() / BlockSize * BlockSize;
+
+			if (blockBytes) {
+
+				compress(data.first(blockBytes));
+				data = data.subspan(blockBytes);
+
+			}
+
+			std::copy_n(data.data(), data.size(), buffer);
+			used = data.size();
 
-		//Conditionally convert
-		if (Bits::requiresEndianConversion(order)) {
-			bits = Bits::swap(bits);
 		}
 
-		//Add length
-		if(bits64) {
+		template<class Compressor>
+		constexpr void finalize(ByteOrder order, Compressor&& compress) {
+
+			constexpr SizeT LengthSize = BlockSize / 8;
+			constexpr SizeT PadOffset = BlockSize - LengthSize;
+
+			buffer[used++] = 0x80;
+
+			//The length does not fit anymore, pad into an extra block
+			if (used > PadOffset) {
+
+				std::fill(buffer + used, buffer + BlockSize, u8(0));
+				compress(std::span<const u8>(buffer, BlockSize));
+				used = 0;
 
-			if constexpr (sizeof(SizeT) > 8) {
-				Bits::disassemble<u64>(bits >> 64, construct.lastBlock + padOffset);
-			} else {
-				Bits::disassemble<u64>(0, construct.lastBlock + padOffset);
 			}
 
-			Bits::disassemble<u64>(bits & ~u64(0), construct.lastBlock + padOffset + 8);
+			std::fill(buffer + used, buffer + PadOffset, u8(0));
+
+			u64 bitsLow = length << 3;
+			u64 bitsHigh = length >> 61;
+
+			auto store = [&](u64 value, SizeT offset) {
 
-		} else {
+				for (SizeT i = 0; i < 8; i++) {
 
-			Bits::disassemble<u64>(bits, construct.lastBlock + padOffset);
+					SizeT shift = order == ByteOrder::Little ? i * 8 : 56 - i * 8;
+					buffer[offset + i] = static_cast<u8>(value >> shift);
+
+				}
+
+			};
+
+			if constexpr (LengthSize == 16) {
+
+				if (order == ByteOrder::Little) {
+
+					store(bitsLow, PadOffset);
+					store(bitsHigh, PadOffset + 8);
+
+				} else {
+
+					store(bitsHigh, PadOffset);
+					store(bitsLow, PadOffset + 8);
+
+				}
+
+			} else {
+
+				store(bitsLow, PadOffset);
+
+			}
+
+			compress(std::span<const u8>(buffer, BlockSize));
+			reset();
 
 		}
 
-	}
+	private:
+
+		u8 buffer[BlockSize];
+		SizeT used;
+		u64 length;
+
+	};
 
 }
\ No newline at end of file
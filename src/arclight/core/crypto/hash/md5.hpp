@@ -114,35 +114,70 @@ namespace MD5 {
 
 	}
 
-	constexpr Hash<128> hash(const std::span<const u8>& data) {
+	/*
+		Incremental MD5 hasher.
+		Data may be passed to update() in chunks of any size, finalize() returns the hash and resets the hasher.
+	*/
+	class Hasher {
 
-		Crypto::MDConstruction<64> construct;
-		Crypto::mdConstruct(construct, data, ByteOrder::Little);
+	public:
 
-		u32 a = 0x67452301;
-		u32 b = 0xEFCDAB89;
-		u32 c = 0x98BADCFE;
-		u32 d = 0x10325476;
+		constexpr Hasher() noexcept {
+			init();
+		}
 
-		SizeT blocks = construct.blocks;
-		SizeT specialBlocks = construct.prevBlockUsed + 1;
+		constexpr void init() noexcept {
 
-		//Hash blocks
-		if (blocks >= specialBlocks) {
+			stream.reset();
 
-			for(SizeT i = 0; i < blocks - specialBlocks; i++) {
-				__Detail::dispatchBlock(data.subspan(i * 64, 64), a, b, c, d);
-			}
+			a = 0x67452301;
+			b = 0xEFCDAB89;
+			c = 0x98BADCFE;
+			d = 0x10325476;
 
 		}
 
-		if (construct.prevBlockUsed) {
-			__Detail::dispatchBlock({construct.prevLastBlock, 64}, a, b, c, d);
+		constexpr void update(const std::span<const u8>& data) noexcept {
+			stream.update(data, [this](const std::span<const u8>& blocks) { compress(blocks); });
 		}
 
-		__Detail::dispatchBlock({construct.lastBlock, 64}, a, b, c, d);
+		constexpr Hash<128> finalize() noexcept {
+
+			stream.finalize(ByteOrder::Little, [this](const std::span<const u8>& blocks) { compress(blocks); });
+
+			Hash<128> hash(Bits::little32(a), Bits::little32(b), Bits::little32(c), Bits::little32(d));
+			init();
+
+			return hash;
+
+		}
+
+	private:
+
+		constexpr void compress(const std::span<const u8>& blocks) noexcept {
+
+			for (SizeT i = 0; i < blocks.size(); i += 64) {
+				__Detail::dispatchBlock(blocks.subspan(i, 64), a, b, c, d);
+			}
+
+		}
+
+		Crypto::MDStream<64> stream;
+
+		u32 a;
+		u32 b;
+		u32 c;
+		u32 d;
+
+	};
+
+
+	constexpr Hash<128> hash(const std::span<const u8>& data) {
+
+		Hasher hasher;
+		hasher.update(data);
 
-		return Hash<128>(Bits::little32(a), Bits::little32(b), Bits::little32(c), Bits::little32(d));
+		return hasher.finalize();
 
 	}
 
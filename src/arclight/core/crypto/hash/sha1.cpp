@@ -0,0 +1,112 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 sha1.cpp
+ */
+
+#include "sha1.hpp"
+#include "arcintrinsic.hpp"
+#include "util/cpuid.hpp"
+
+#include <utility>
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+/*
+	One group of four SHA-1 rounds with SHA-NI.
+	The message registers rotate every group, msg[G % 4] holds w[4G, 4G + 3] upon entry.
+	Scheduling of the following words is interleaved with the rounds as the instruction latencies permit.
+*/
+template<u32 G>
+ARC_TARGET("sha,sse4.1,ssse3") ARC_FORCE_INLINE static void roundsSHA1(__m128i& abcd, __m128i (&e)[2], __m128i (&msg)[4], const u8* block, __m128i mask) {
+
+	if constexpr (G < 4) {
+		msg[G] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + G * 16)), mask);
+	}
+
+	if constexpr (G == 0) {
+		e[0] = _mm_add_epi32(e[0], msg[0]);
+	} else {
+		e[G % 2] = _mm_sha1nexte_epu32(e[G % 2], msg[G % 4]);
+	}
+
+	e[(G + 1) % 2] = abcd;
+
+	if constexpr (G >= 3 && G <= 18) {
+		msg[(G + 1) % 4] = _mm_sha1msg2_epu32(msg[(G + 1) % 4], msg[G % 4]);
+	}
+
+	abcd = _mm_sha1rnds4_epu32(abcd, e[G % 2], G / 5);
+
+	if constexpr (G >= 1 && G <= 16) {
+		msg[(G + 3) % 4] = _mm_sha1msg1_epu32(msg[(G + 3) % 4], msg[G % 4]);
+	}
+
+	if constexpr (G >= 2 && G <= 17) {
+		msg[(G + 2) % 4] = _mm_xor_si128(msg[(G + 2) % 4], msg[G % 4]);
+	}
+
+}
+
+
+
+template<u32... G>
+ARC_TARGET("sha,sse4.1,ssse3") ARC_FORCE_INLINE static void blockSHA1(__m128i& abcd, __m128i& e0, const u8* block, __m128i mask, std::integer_sequence<u32, G...>) {
+
+	__m128i abcdSave = abcd;
+	__m128i eSave = e0;
+	__m128i e[2] = {e0, e0};
+	__m128i msg[4];
+
+	(roundsSHA1<G>(abcd, e, msg, block, mask), ...);
+
+	e0 = _mm_sha1nexte_epu32(e[0], eSave);
+	abcd = _mm_add_epi32(abcd, abcdSave);
+
+}
+
+
+
+ARC_TARGET("sha,sse4.1,ssse3") static void compressSHA1NI(u32* state, const u8* blocks, SizeT count) {
+
+	const __m128i mask = _mm_set_epi64x(0x0001020304050607, 0x08090A0B0C0D0E0F);
+
+	__m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0x1B);
+	__m128i e = _mm_set_epi32(state[4], 0, 0, 0);
+
+	for (SizeT i = 0; i < count; i++) {
+		blockSHA1(abcd, e, blocks + i * 64, mask, std::make_integer_sequence<u32, 20>{});
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_shuffle_epi32(abcd, 0x1B));
+	state[4] = _mm_extract_epi32(e, 3);
+
+}
+
+#endif
+
+
+
+__SHA01Detail::BlockFunction __SHA01Detail::getAcceleratedSHA1() noexcept {
+
+	static const BlockFunction function = []() -> BlockFunction {
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::SHA) && CPUID::hasFeature(CPUFeature::SSE4_1)) {
+			return compressSHA1NI;
+		}
+
+#endif
+
+		return nullptr;
+
+	}();
+
+	return function;
+
+}
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "util/bits.hpp"
 
 #include <span>
+#include <type_traits>
 
 
 
@@ -104,37 +105,88 @@ namespace __SHA01Detail {
 	}
 
 
+	//Compresses consecutive 64 byte blocks into the state h0-h4
+	using BlockFunction = void(*)(u32* state, const u8* blocks, SizeT count);
+
+	//Returns the SHA-NI implementation of SHA-1 if the CPU supports it, nullptr otherwise
+	BlockFunction getAcceleratedSHA1() noexcept;
+
+
 	template<bool SHA1>
-	constexpr Hash<160> hashSHA01(const std::span<const u8>& data) {
+	class SHA01Hasher {
 
-		Crypto::MDConstruction<64> construct;
-		Crypto::mdConstruct(construct, data, ByteOrder::Big);
+	public:
 
-		u32 a = 0x67452301;
-		u32 b = 0xEFCDAB89;
-		u32 c = 0x98BADCFE;
-		u32 d = 0x10325476;
-		u32 e = 0xC3D2E1F0;
+		constexpr SHA01Hasher() noexcept {
+			init();
+		}
 
-		SizeT blocks = construct.blocks;
-		u32 specialBlocks = construct.prevBlockUsed + 1;
+		constexpr void init() noexcept {
 
-		//Hash blocks
-		if (blocks >= specialBlocks) {
+			stream.reset();
 
-			for(SizeT i = 0; i < blocks - specialBlocks; i++) {
-				dispatchBlockSHA01<SHA1>(data.subspan(i * 64, 64), a, b, c, d, e);
-			}
+			h[0] = 0x67452301;
+			h[1] = 0xEFCDAB89;
+			h[2] = 0x98BADCFE;
+			h[3] = 0x10325476;
+			h[4] = 0xC3D2E1F0;
+
+		}
 
+		constexpr void update(const std::span<const u8>& data) noexcept {
+			stream.update(data, [this](const std::span<const u8>& blocks) { compress(blocks); });
 		}
 
-		if (construct.prevBlockUsed) {
-			dispatchBlockSHA01<SHA1>({construct.prevLastBlock, 64}, a, b, c, d, e);
+		constexpr Hash<160> finalize() noexcept {
+
+			stream.finalize(ByteOrder::Big, [this](const std::span<const u8>& blocks) { compress(blocks); });
+
+			Hash<160> hash(Bits::big32(h[0]), Bits::big32(h[1]), Bits::big32(h[2]), Bits::big32(h[3]), Bits::big32(h[4]));
+			init();
+
+			return hash;
+
 		}
 
-		dispatchBlockSHA01<SHA1>({construct.lastBlock, 64}, a, b, c, d, e);
+	private:
+
+		constexpr void compress(const std::span<const u8>& blocks) noexcept {
+
+			//SHA-NI implements SHA-1 only
+			if constexpr (SHA1) {
+
+				if (!std::is_constant_evaluated()) {
+
+					if (BlockFunction function = getAcceleratedSHA1()) {
+
+						function(h, blocks.data(), blocks.size() / 64);
+						return;
 
-		return Hash<160>(Bits::big32(a), Bits::big32(b), Bits::big32(c), Bits::big32(d), Bits::big32(e));
+					}
+
+				}
+
+			}
+
+			for (SizeT i = 0; i < blocks.size(); i += 64) {
+				dispatchBlockSHA01<SHA1>(blocks.subspan(i, 64), h[0], h[1], h[2], h[3], h[4]);
+			}
+
+		}
+
+		Crypto::MDStream<64> stream;
+		u32 h[5];
+
+	};
+
+
+	template<bool SHA1>
+	constexpr Hash<160> hashSHA01(const std::span<const u8>& data) {
+
+		SHA01Hasher<SHA1> hasher;
+		hasher.update(data);
+
+		return hasher.finalize();
 
 	}
 
@@ -144,6 +196,9 @@ namespace __SHA01Detail {
 
 namespace SHA0 {
 
+	//Incremental SHA-0 hasher, see MD5::Hasher
+	using Hasher = __SHA01Detail::SHA01Hasher<false>;
+
 	constexpr Hash<160> hash(const std::span<const u8>& data) {
 		return __SHA01Detail::hashSHA01<false>(data);
 	}
@@ -152,6 +207,9 @@ namespace SHA0 {
 
 namespace SHA1 {
 
+	//Incremental SHA-1 hasher, see MD5::Hasher
+	using Hasher = __SHA01Detail::SHA01Hasher<true>;
+
 	constexpr Hash<160> hash(const std::span<const u8>& data) {
 		return __SHA01Detail::hashSHA01<true>(data);
 	}
@@ -0,0 +1,377 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 sha2.cpp
+ */
+
+#include "sha2.hpp"
+#include "arcintrinsic.hpp"
+#include "util/assert.hpp"
+#include "util/cpuid.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+
+
+constexpr static u32 sha256IV[8] = {0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+/*
+	One group of four SHA-256 rounds with SHA-NI.
+	msg[G % 4] holds w[4G, 4G + 3] upon entry, the schedule of the following groups is interleaved with the rounds.
+*/
+template<u32 G>
+ARC_TARGET("sha,sse4.1,ssse3") ARC_FORCE_INLINE static void roundsSHA256(__m128i& state0, __m128i& state1, __m128i (&msg)[4], const u8* block, __m128i mask) {
+
+	if constexpr (G < 4) {
+		msg[G] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(block + G * 16)), mask);
+	}
+
+	__m128i w = _mm_add_epi32(msg[G % 4], _mm_loadu_si128(reinterpret_cast<const __m128i*>(SHA2::__Detail::sha2Constants32 + G * 4)));
+	state1 = _mm_sha256rnds2_epu32(state1, state0, w);
+
+	if constexpr (G >= 3 && G <= 14) {
+
+		__m128i t = _mm_alignr_epi8(msg[G % 4], msg[(G + 3) % 4], 4);
+		msg[(G + 1) % 4] = _mm_sha256msg2_epu32(_mm_add_epi32(msg[(G + 1) % 4], t), msg[G % 4]);
+
+	}
+
+	state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(w, 0x0E));
+
+	if constexpr (G >= 1 && G <= 12) {
+		msg[(G + 3) % 4] = _mm_sha256msg1_epu32(msg[(G + 3) % 4], msg[G % 4]);
+	}
+
+}
+
+
+
+template<u32... G>
+ARC_TARGET("sha,sse4.1,ssse3") ARC_FORCE_INLINE static void blockSHA256(__m128i& state0, __m128i& state1, const u8* block, __m128i mask, std::integer_sequence<u32, G...>) {
+
+	__m128i save0 = state0;
+	__m128i save1 = state1;
+	__m128i msg[4];
+
+	(roundsSHA256<G>(state0, state1, msg, block, mask), ...);
+
+	state0 = _mm_add_epi32(state0, save0);
+	state1 = _mm_add_epi32(state1, save1);
+
+}
+
+
+
+ARC_TARGET("sha,sse4.1,ssse3") static void compressSHA256NI(u32* state, const u8* blocks, SizeT count) {
+
+	const __m128i mask = _mm_set_epi64x(0x0C0D0E0F08090A0B, 0x0405060700010203);
+
+	//SHA-NI operates on ABEF/CDGH
+	__m128i dcba = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state)), 0xB1);
+	__m128i hgfe = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4)), 0x1B);
+	__m128i state0 = _mm_alignr_epi8(dcba, hgfe, 8);
+	__m128i state1 = _mm_blend_epi16(hgfe, dcba, 0xF0);
+
+	for (SizeT i = 0; i < count; i++) {
+		blockSHA256(state0, state1, blocks + i * 64, mask, std::make_integer_sequence<u32, 16>{});
+	}
+
+	__m128i feba = _mm_shuffle_epi32(state0, 0x1B);
+	state1 = _mm_shuffle_epi32(state1, 0xB1);
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state), _mm_blend_epi16(feba, state1, 0xF0));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), _mm_alignr_epi8(state1, feba, 8));
+
+}
+
+
+
+ARC_TARGET("avx2") ARC_FORCE_INLINE static __m256i ror8x32(__m256i x, u32 n) {
+	return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+}
+
+
+
+//Transposes the 8x8 word matrix in rows, afterwards rows[i] holds word i of every lane
+ARC_TARGET("avx2") ARC_FORCE_INLINE static void transpose8x32(__m256i (&rows)[8]) {
+
+	__m256i t0 = _mm256_unpacklo_epi32(rows[0], rows[1]);
+	__m256i t1 = _mm256_unpackhi_epi32(rows[0], rows[1]);
+	__m256i t2 = _mm256_unpacklo_epi32(rows[2], rows[3]);
+	__m256i t3 = _mm256_unpackhi_epi32(rows[2], rows[3]);
+	__m256i t4 = _mm256_unpacklo_epi32(rows[4], rows[5]);
+	__m256i t5 = _mm256_unpackhi_epi32(rows[4], rows[5]);
+	__m256i t6 = _mm256_unpacklo_epi32(rows[6], rows[7]);
+	__m256i t7 = _mm256_unpackhi_epi32(rows[6], rows[7]);
+
+	__m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+	__m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+	__m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+	__m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+	__m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+	__m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+	__m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+	__m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+	rows[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+	rows[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+	rows[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+	rows[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+	rows[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+	rows[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+	rows[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+	rows[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+
+}
+
+
+
+/*
+	Compresses one block per lane for eight independent messages.
+	state[i] holds word i of all eight lane states.
+*/
+ARC_TARGET("avx2") static void compressLanesAVX2(u32 (&state)[8][8], const u8* const (&blocks)[8]) {
+
+	const __m256i mask = _mm256_set_epi64x(0x0C0D0E0F08090A0B, 0x0405060700010203, 0x0C0D0E0F08090A0B, 0x0405060700010203);
+
+	__m256i w[16];
+
+	for (u32 half = 0; half < 2; half++) {
+
+		__m256i rows[8];
+
+		for (u32 i = 0; i < 8; i++) {
+			rows[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(blocks[i] + half * 32));
+		}
+
+		transpose8x32(rows);
+
+		for (u32 i = 0; i < 8; i++) {
+			w[half * 8 + i] = _mm256_shuffle_epi8(rows[i], mask);
+		}
+
+	}
+
+	__m256i h[8];
+
+	for (u32 i = 0; i < 8; i++) {
+		h[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(state[i]));
+	}
+
+	__m256i a = h[0], b = h[1], c = h[2], d = h[3], e = h[4], f = h[5], g = h[6], k = h[7];
+
+	for (u32 i = 0; i < 64; i++) {
+
+		//Extend the schedule in place, w[i % 16] is replaced by w[i]
+		if (i >= 16) {
+
+			__m256i w15 = w[(i + 1) % 16];
+			__m256i w2 = w[(i + 14) % 16];
+
+			__m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ror8x32(w15, 7), ror8x32(w15, 18)), _mm256_srli_epi32(w15, 3));
+			__m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ror8x32(w2, 17), ror8x32(w2, 19)), _mm256_srli_epi32(w2, 10));
+
+			w[i % 16] = _mm256_add_epi32(_mm256_add_epi32(w[i % 16], w[(i + 9) % 16]), _mm256_add_epi32(s0, s1));
+
+		}
+
+		__m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ror8x32(e, 6), ror8x32(e, 11)), ror8x32(e, 25));
+		__m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+		__m256i t1 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(k, s1), _mm256_add_epi32(ch, w[i % 16])), _mm256_set1_epi32(SHA2::__Detail::sha2Constants32[i]));
+
+		__m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ror8x32(a, 2), ror8x32(a, 13)), ror8x32(a, 22));
+		__m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+		__m256i t2 = _mm256_add_epi32(s0, maj);
+
+		k = g;
+		g = f;
+		f = e;
+		e = _mm256_add_epi32(d, t1);
+		d = c;
+		c = b;
+		b = a;
+		a = _mm256_add_epi32(t1, t2);
+
+	}
+
+	__m256i r[8] = {a, b, c, d, e, f, g, k};
+
+	for (u32 i = 0; i < 8; i++) {
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(state[i]), _mm256_add_epi32(h[i], r[i]));
+	}
+
+}
+
+
+
+/*
+	Feeds up to eight messages at a time through compressLanesAVX2.
+	Full blocks are read in place, the padded tail of each message is built in a per-lane buffer.
+	A lane whose message completes picks up the next one, lanes left without a message compress a dummy block.
+*/
+static void hash256LanesAVX2(std::span<const std::span<const u8>> messages, std::span<Hash<256>> hashes) {
+
+	struct Lane {
+
+		SizeT message;
+		const u8* data;
+		SizeT fullBlocks;
+		SizeT tailBlocks;
+		SizeT tailIndex;
+		alignas(32) u8 tail[128];
+
+	};
+
+	constexpr SizeT Idle = -1;
+
+	alignas(32) static constexpr u8 dummy[64] = {};
+
+	Lane lanes[8];
+	u32 state[8][8];
+	SizeT nextMessage = 0;
+
+	auto assign = [&](u32 l) {
+
+		Lane& lane = lanes[l];
+
+		if (nextMessage == messages.size()) {
+
+			lane.message = Idle;
+			return;
+
+		}
+
+		const std::span<const u8>& message = messages[nextMessage];
+		SizeT remainder = message.size() % 64;
+
+		lane.message = nextMessage++;
+		lane.data = message.data();
+		lane.fullBlocks = message.size() / 64;
+		lane.tailBlocks = remainder < 56 ? 1 : 2;
+		lane.tailIndex = 0;
+
+		//Padding: 0x80, zeros and the big endian bit length
+		SizeT tailSize = lane.tailBlocks * 64;
+		u64 bitLength = Bits::big64(u64(message.size()) * 8);
+
+		std::fill_n(lane.tail, tailSize, 0);
+
+		if (remainder) {
+			std::memcpy(lane.tail, message.data() + lane.fullBlocks * 64, remainder);
+		}
+
+		lane.tail[remainder] = 0x80;
+		std::memcpy(lane.tail + tailSize - 8, &bitLength, 8);
+
+		for (u32 i = 0; i < 8; i++) {
+			state[i][l] = sha256IV[i];
+		}
+
+	};
+
+	for (u32 l = 0; l < 8; l++) {
+		assign(l);
+	}
+
+	while (std::any_of(lanes, lanes + 8, [](const Lane& lane) { return lane.message != Idle; })) {
+
+		const u8* blocks[8];
+
+		for (u32 l = 0; l < 8; l++) {
+
+			Lane& lane = lanes[l];
+
+			if (lane.message == Idle) {
+
+				blocks[l] = dummy;
+
+			} else if (lane.fullBlocks) {
+
+				blocks[l] = lane.data;
+				lane.data += 64;
+				lane.fullBlocks--;
+
+			} else {
+
+				blocks[l] = lane.tail + lane.tailIndex * 64;
+				lane.tailIndex++;
+
+			}
+
+		}
+
+		compressLanesAVX2(state, blocks);
+
+		for (u32 l = 0; l < 8; l++) {
+
+			Lane& lane = lanes[l];
+
+			if (lane.message != Idle && lane.tailIndex == lane.tailBlocks) {
+
+				hashes[lane.message] = Hash<256>(Bits::big32(state[0][l]), Bits::big32(state[1][l]), Bits::big32(state[2][l]), Bits::big32(state[3][l]),
+												 Bits::big32(state[4][l]), Bits::big32(state[5][l]), Bits::big32(state[6][l]), Bits::big32(state[7][l]));
+				assign(l);
+
+			}
+
+		}
+
+	}
+
+}
+
+#endif
+
+
+
+SHA2::__Detail::BlockFunction256 SHA2::__Detail::getAcceleratedSHA256() noexcept {
+
+	static const BlockFunction256 function = []() -> BlockFunction256 {
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::SHA) && CPUID::hasFeature(CPUFeature::SSE4_1)) {
+			return compressSHA256NI;
+		}
+
+#endif
+
+		return nullptr;
+
+	}();
+
+	return function;
+
+}
+
+
+
+void SHA2::hash256Batch(std::span<const std::span<const u8>> messages, std::span<Hash<256>> hashes) {
+
+	arc_assert(messages.size() <= hashes.size(), "SHA-256 batch hash buffer too small");
+
+#ifdef ARC_DISPATCH_X86
+
+	//SHA-NI hashes a single message faster than eight AVX2 lanes do
+	if (!__Detail::getAcceleratedSHA256() && CPUID::hasFeature(CPUFeature::AVX2) && messages.size() > 1) {
+
+		hash256LanesAVX2(messages, hashes);
+		return;
+
+	}
+
+#endif
+
+	for (SizeT i = 0; i < messages.size(); i++) {
+		hashes[i] = hash256(messages[i]);
+	}
+
+}
\ No newline at end of file
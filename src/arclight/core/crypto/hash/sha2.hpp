@@ -16,6 +16,7 @@
 
 #include <span>
 #include <algorithm>
+#include <type_traits>
 
 
 
@@ -142,92 +143,161 @@ namespace SHA2 {
 		}
 
 
+		//Compresses consecutive 64 byte blocks into the state h0-h7
+		using BlockFunction256 = void(*)(u32* state, const u8* blocks, SizeT count);
+
+		//Returns the SHA-NI implementation of the SHA-224/256 compression if the CPU supports it, nullptr otherwise
+		BlockFunction256 getAcceleratedSHA256() noexcept;
+
+
+		/*
+			Incremental SHA-2 hasher for the given variant.
+			Data may be passed to update() in chunks of any size, finalize() returns the hash and resets the hasher.
+		*/
 		template<SHA2Variant Variant>
-		constexpr static auto hashSHA2(const std::span<const u8>& data) {
+		class SHA2Hasher {
 
-			constexpr bool bits64 = is64BitSHA2Variant(Variant);
-			constexpr u32 bytes = bits64 ? 128 : 64;
+			constexpr static bool bits64 = is64BitSHA2Variant(Variant);
+			constexpr static u32 bytes = bits64 ? 128 : 64;
 
 			using ValueT = TT::Conditional<bits64, u64, u32>;
 
-			Crypto::MDConstruction<bytes> construct {};
-			Crypto::mdConstruct(construct, data, ByteOrder::Big);
+		public:
 
-			ValueT h[8];
+			constexpr SHA2Hasher() noexcept {
+				init();
+			}
+
+			constexpr void init() noexcept {
+
+				stream.reset();
 
-			if constexpr (Variant == SHA2Variant::SHA224) {
+				if constexpr (Variant == SHA2Variant::SHA224) {
 
-				constexpr u32 s[8] = {0xC1059ED8, 0x367CD507, 0x3070DD17, 0xF70E5939, 0xFFC00B31, 0x68581511, 0x64F98FA7, 0xBEFA4FA4};
-				std::copy_n(s, 8, h);
+					constexpr u32 s[8] = {0xC1059ED8, 0x367CD507, 0x3070DD17, 0xF70E5939, 0xFFC00B31, 0x68581511, 0x64F98FA7, 0xBEFA4FA4};
+					std::copy_n(s, 8, h);
 
-			} else if constexpr (Variant == SHA2Variant::SHA256) {
+				} else if constexpr (Variant == SHA2Variant::SHA256) {
 
-				constexpr u32 s[8] = {0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
-				std::copy_n(s, 8, h);
+					constexpr u32 s[8] = {0x6A09E667, 0xBB67AE85, 0x3C6EF372, 0xA54FF53A, 0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19};
+					std::copy_n(s, 8, h);
 
-			} else if constexpr (Variant == SHA2Variant::SHA384) {
+				} else if constexpr (Variant == SHA2Variant::SHA384) {
 
-				constexpr u64 s[8] = {0xCBBB9D5DC1059ED8, 0x629A292A367CD507, 0x9159015A3070DD17, 0x152FECD8F70E5939, 0x67332667FFC00B31, 0x8EB44A8768581511, 0xDB0C2E0D64F98FA7, 0x47B5481DBEFA4FA4};
-				std::copy_n(s, 8, h);
+					constexpr u64 s[8] = {0xCBBB9D5DC1059ED8, 0x629A292A367CD507, 0x9159015A3070DD17, 0x152FECD8F70E5939, 0x67332667FFC00B31, 0x8EB44A8768581511, 0xDB0C2E0D64F98FA7, 0x47B5481DBEFA4FA4};
+					std::copy_n(s, 8, h);
 
-			} else if constexpr (Variant == SHA2Variant::SHA512) {
+				} else if constexpr (Variant == SHA2Variant::SHA512) {
 
-				constexpr u64 s[8] = {0x6A09E667F3BCC908, 0xBB67AE8584CAA73B, 0x3C6EF372FE94F82B, 0xA54FF53A5F1D36F1, 0x510E527FADE682D1, 0x9B05688C2B3E6C1F, 0x1F83D9ABFB41BD6B, 0x5BE0CD19137E2179};
-				std::copy_n(s, 8, h);
+					constexpr u64 s[8] = {0x6A09E667F3BCC908, 0xBB67AE8584CAA73B, 0x3C6EF372FE94F82B, 0xA54FF53A5F1D36F1, 0x510E527FADE682D1, 0x9B05688C2B3E6C1F, 0x1F83D9ABFB41BD6B, 0x5BE0CD19137E2179};
+					std::copy_n(s, 8, h);
 
-			} else if constexpr (Variant == SHA2Variant::SHA512t224) {
+				} else if constexpr (Variant == SHA2Variant::SHA512t224) {
 
-				constexpr u64 s[8] = {0x8C3D37C819544DA2, 0x73E1996689DCD4D6, 0x1DFAB7AE32FF9C82, 0x679DD514582F9FCF, 0x0F6D2B697BD44DA8, 0x77E36F7304C48942, 0x3F9D85A86A1D36C8, 0x1112E6AD91D692A1};
-				std::copy_n(s, 8, h);
+					constexpr u64 s[8] = {0x8C3D37C819544DA2, 0x73E1996689DCD4D6, 0x1DFAB7AE32FF9C82, 0x679DD514582F9FCF, 0x0F6D2B697BD44DA8, 0x77E36F7304C48942, 0x3F9D85A86A1D36C8, 0x1112E6AD91D692A1};
+					std::copy_n(s, 8, h);
 
-			} else if constexpr (Variant == SHA2Variant::SHA512t256) {
+				} else if constexpr (Variant == SHA2Variant::SHA512t256) {
 
-				constexpr u64 s[8] = {0x22312194FC2BF72C, 0x9F555FA3C84C64C2, 0x2393B86B6F53B151, 0x963877195940EABD, 0x96283EE2A88EFFE3, 0xBE5E1E2553863992, 0x2B0199FC2C85B8AA, 0x0EB72DDC81C52CA2};
-				std::copy_n(s, 8, h);
+					constexpr u64 s[8] = {0x22312194FC2BF72C, 0x9F555FA3C84C64C2, 0x2393B86B6F53B151, 0x963877195940EABD, 0x96283EE2A88EFFE3, 0xBE5E1E2553863992, 0x2B0199FC2C85B8AA, 0x0EB72DDC81C52CA2};
+					std::copy_n(s, 8, h);
+
+				}
 
 			}
 
-			SizeT blocks = construct.blocks;
-			SizeT specialBlocks = construct.prevBlockUsed + 1;
+			constexpr void update(const std::span<const u8>& data) noexcept {
+				stream.update(data, [this](const std::span<const u8>& blocks) { compress(blocks); });
+			}
 
-			if (blocks >= specialBlocks) {
+			constexpr auto finalize() noexcept {
 
-				for(SizeT i = 0; i < blocks - specialBlocks; i++) {
-					dispatchBlockSHA2<Variant>(data.subspan(i * bytes, bytes), h);
-				}
+				stream.finalize(ByteOrder::Big, [this](const std::span<const u8>& blocks) { compress(blocks); });
+
+				std::for_each_n(h, 8, [](ValueT& x) {
+					x = Bits::big(x);
+				});
+
+				auto hash = makeHash();
+				init();
+
+				return hash;
 
 			}
 
-			if (construct.prevBlockUsed) {
-				dispatchBlockSHA2<Variant>({construct.prevLastBlock, bytes}, h);
+		private:
+
+			constexpr void compress(const std::span<const u8>& blocks) noexcept {
+
+				if constexpr (!bits64) {
+
+					if (!std::is_constant_evaluated()) {
+
+						if (BlockFunction256 function = getAcceleratedSHA256()) {
+
+							function(h, blocks.data(), blocks.size() / bytes);
+							return;
+
+						}
+
+					}
+
+				}
+
+				for (SizeT i = 0; i < blocks.size(); i += bytes) {
+					dispatchBlockSHA2<Variant>(blocks.subspan(i, bytes), h);
+				}
+
 			}
 
-			dispatchBlockSHA2<Variant>({construct.lastBlock, bytes}, h);
-
-			std::for_each_n(h, 8, [](ValueT& x) {
-				x = Bits::big(x);
-			});
-
-			if constexpr (Variant == SHA2Variant::SHA224) {
-				return Hash<224>(h[0], h[1], h[2], h[3], h[4], h[5], h[6]);
-			} else if constexpr (Variant == SHA2Variant::SHA256) {
-				return Hash<256>(h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
-			} else if constexpr (Variant == SHA2Variant::SHA384) {
-				return Hash<384>(h[0], h[1], h[2], h[3], h[4], h[5]);
-			} else if constexpr (Variant == SHA2Variant::SHA512) {
-				return Hash<512>(h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
-			} else if constexpr (Variant == SHA2Variant::SHA512t224) {
-				return Hash<224>(h[0], h[1], h[2], static_cast<u32>(h[3] & ~u32(0)));
-			} else if constexpr (Variant == SHA2Variant::SHA512t256) {
-				return Hash<256>(h[0], h[1], h[2], h[3]);
+			constexpr auto makeHash() const noexcept {
+
+				if constexpr (Variant == SHA2Variant::SHA224) {
+					return Hash<224>(h[0], h[1], h[2], h[3], h[4], h[5], h[6]);
+				} else if constexpr (Variant == SHA2Variant::SHA256) {
+					return Hash<256>(h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+				} else if constexpr (Variant == SHA2Variant::SHA384) {
+					return Hash<384>(h[0], h[1], h[2], h[3], h[4], h[5]);
+				} else if constexpr (Variant == SHA2Variant::SHA512) {
+					return Hash<512>(h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7]);
+				} else if constexpr (Variant == SHA2Variant::SHA512t224) {
+					return Hash<224>(h[0], h[1], h[2], static_cast<u32>(h[3] & ~u32(0)));
+				} else if constexpr (Variant == SHA2Variant::SHA512t256) {
+					return Hash<256>(h[0], h[1], h[2], h[3]);
+				}
+
 			}
 
+			Crypto::MDStream<bytes> stream;
+			ValueT h[8];
+
+		};
+
+
+		template<SHA2Variant Variant>
+		constexpr static auto hashSHA2(const std::span<const u8>& data) {
+
+			SHA2Hasher<Variant> hasher;
+			hasher.update(data);
+
+			return hasher.finalize();
+
 		}
 
 	}
 
 
 
+	//Incremental hashers, see MD5::Hasher
+	using Hasher224 = __Detail::SHA2Hasher<__Detail::SHA2Variant::SHA224>;
+	using Hasher256 = __Detail::SHA2Hasher<__Detail::SHA2Variant::SHA256>;
+	using Hasher384 = __Detail::SHA2Hasher<__Detail::SHA2Variant::SHA384>;
+	using Hasher512 = __Detail::SHA2Hasher<__Detail::SHA2Variant::SHA512>;
+	using Hasher512t224 = __Detail::SHA2Hasher<__Detail::SHA2Variant::SHA512t224>;
+	using Hasher512t256 = __Detail::SHA2Hasher<__Detail::SHA2Variant::SHA512t256>;
+
+
+
 	constexpr Hash<224> hash224(const std::span<const u8>& data) {
 		return __Detail::hashSHA2<__Detail::SHA2Variant::SHA224>(data);
 	}
@@ -252,4 +322,11 @@ namespace SHA2 {
 		return __Detail::hashSHA2<__Detail::SHA2Variant::SHA512t256>(data);
 	}
 
+
+	/*
+		Computes the SHA-256 hashes of many independent messages, hashes[i] receives the hash of messages[i].
+		Without SHA-NI, eight messages are compressed in lockstep with AVX2, which pays off for large numbers of small messages.
+	*/
+	void hash256Batch(std::span<const std::span<const u8>> messages, std::span<Hash<256>> hashes);
+
 }
\ No newline at end of file
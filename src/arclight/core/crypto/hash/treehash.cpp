@@ -0,0 +1,241 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 treehash.cpp
+ */
+
+#include "treehash.hpp"
+#include "sha2.hpp"
+#include "concurrent/threadpool.hpp"
+#include "util/assert.hpp"
+
+#include <algorithm>
+
+
+
+constexpr static u8 LeafPrefix = 0x00;
+constexpr static u8 NodePrefix = 0x01;
+
+
+
+static Hash<256> hashLeaf(const std::span<const u8>& leaf) {
+
+	SHA2::Hasher256 hasher;
+	hasher.update(std::span<const u8>(&LeafPrefix, 1));
+	hasher.update(leaf);
+
+	return hasher.finalize();
+
+}
+
+
+
+static Hash<256> hashNode(const Hash<256>& left, const Hash<256>& right) {
+
+	SHA2::Hasher256 hasher;
+	hasher.update(std::span<const u8>(&NodePrefix, 1));
+	hasher.update(left.toArray());
+	hasher.update(right.toArray());
+
+	return hasher.finalize();
+
+}
+
+
+
+TreeHash::TreeHash(SizeT leafSize) : leafSize(leafSize), dataSize(0) {
+
+	arc_assert(leafSize, "Tree hash leaf size must not be zero");
+
+	leaves.push_back(hashLeaf({}));
+	hashNodes(0, 1);
+
+}
+
+
+
+void TreeHash::build(const std::span<const u8>& data, ThreadPool* threadPool) {
+
+	dataSize = data.size();
+	leaves.resize(leafCount(dataSize, leafSize));
+
+	hashLeaves(data, 0, leaves.size(), threadPool);
+	hashNodes(0, leaves.size());
+
+}
+
+
+
+void TreeHash::update(const std::span<const u8>& data, SizeT offset, SizeT size, ThreadPool* threadPool) {
+
+	arc_assert(offset + size <= data.size(), "Tree hash update range out of bounds");
+
+	SizeT newCount = leafCount(data.size(), leafSize);
+
+	SizeT first = offset / leafSize;
+	SizeT last = size ? (offset + size - 1) / leafSize + 1 : first;
+
+	if (data.size() != dataSize) {
+
+		//Leaves from the shorter end on have changed size
+		first = std::min({first, std::min(dataSize, data.size()) / leafSize, newCount - 1});
+		last = newCount;
+
+	}
+
+	last = std::min(last, newCount);
+
+	dataSize = data.size();
+	leaves.resize(newCount);
+
+	if (first < last) {
+
+		hashLeaves(data, first, last, threadPool);
+		hashNodes(first, last);
+
+	}
+
+}
+
+
+
+std::vector<SizeT> TreeHash::compare(const TreeHash& other) const {
+
+	std::vector<SizeT> changed;
+
+	SizeT common = std::min(leaves.size(), other.leaves.size());
+	SizeT total = std::max(leaves.size(), other.leaves.size());
+
+	for (SizeT i = 0; i < common; i++) {
+
+		Hash<256> leaf = leaves[i];
+
+		if (!(leaf == other.leaves[i])) {
+			changed.push_back(i);
+		}
+
+	}
+
+	for (SizeT i = common; i < total; i++) {
+		changed.push_back(i);
+	}
+
+	return changed;
+
+}
+
+
+
+Hash<256> TreeHash::getRoot() const {
+	return nodes.empty() ? leaves.front() : nodes.back().front();
+}
+
+
+
+std::span<const Hash<256>> TreeHash::getLeafHashes() const {
+	return leaves;
+}
+
+
+
+SizeT TreeHash::getLeafSize() const {
+	return leafSize;
+}
+
+
+
+SizeT TreeHash::getLeafCount() const {
+	return leaves.size();
+}
+
+
+
+SizeT TreeHash::getDataSize() const {
+	return dataSize;
+}
+
+
+
+Hash<256> TreeHash::hash(const std::span<const u8>& data, SizeT leafSize, ThreadPool* threadPool) {
+
+	TreeHash tree(leafSize);
+	tree.build(data, threadPool);
+
+	return tree.getRoot();
+
+}
+
+
+
+SizeT TreeHash::leafCount(SizeT dataSize, SizeT leafSize) {
+	return std::max<SizeT>((dataSize + leafSize - 1) / leafSize, 1);
+}
+
+
+
+void TreeHash::hashLeaves(const std::span<const u8>& data, SizeT first, SizeT last, ThreadPool* threadPool) {
+
+	auto hashRange = [&](SizeT begin, SizeT end) {
+
+		for (SizeT i = begin; i < end; i++) {
+
+			SizeT start = std::min(i * leafSize, data.size());
+			leaves[i] = hashLeaf(data.subspan(start, std::min(leafSize, data.size() - start)));
+
+		}
+
+	};
+
+	//Small leaves are grouped so that tasks stay large enough to outweigh the scheduling overhead
+	SizeT grainSize = (MinTaskSize + leafSize - 1) / leafSize;
+
+	if (threadPool && last - first > grainSize) {
+		threadPool->parallelFor(first, last, hashRange, grainSize);
+	} else {
+		hashRange(first, last);
+	}
+
+}
+
+
+
+void TreeHash::hashNodes(SizeT first, SizeT last) {
+
+	SizeT level = 0;
+
+	while ((level ? nodes[level - 1] : leaves).size() > 1) {
+
+		if (level == nodes.size()) {
+			nodes.emplace_back();
+		}
+
+		//Looked up after adding a level since that might move the lower ones
+		const std::vector<Hash<256>>& children = level ? nodes[level - 1] : leaves;
+		std::vector<Hash<256>>& parents = nodes[level];
+
+		parents.resize((children.size() + 1) / 2);
+
+		first /= 2;
+		last = (last + 1) / 2;
+
+		for (SizeT i = first; i < last; i++) {
+
+			//An odd node is promoted
+			if (i * 2 + 1 < children.size()) {
+				parents[i] = hashNode(children[i * 2], children[i * 2 + 1]);
+			} else {
+				parents[i] = children[i * 2];
+			}
+
+		}
+
+		level++;
+
+	}
+
+	//The tree might have become lower
+	nodes.resize(level);
+
+}
\ No newline at end of file
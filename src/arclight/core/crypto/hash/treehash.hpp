@@ -0,0 +1,81 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 treehash.hpp
+ */
+
+#pragma once
+
+#include "hash.hpp"
+#include "types.hpp"
+
+#include <span>
+#include <vector>
+
+
+
+class ThreadPool;
+
+
+
+/*
+	SHA-256 Merkle tree over fixed size leaves.
+
+	The input is split into leaves of leafSize bytes, the last one may be shorter.
+	Leaves are hashed as SHA-256(0x00 || leaf), inner nodes as SHA-256(0x01 || left || right) so that leaf and node hashes never collide.
+	A node without a right sibling is promoted to the next level unchanged. The empty input has a single empty leaf.
+
+	Leaves are hashed in parallel if a ThreadPool is passed. The root depends on the leaf size, but not on the thread count.
+	Keeping all levels of the tree around allows rehashing only the modified regions of large inputs and their ancestors,
+	as well as comparing trees leaf by leaf.
+*/
+class TreeHash {
+
+public:
+
+	constexpr static SizeT DefaultLeafSize = 1 << 20;
+
+	explicit TreeHash(SizeT leafSize = DefaultLeafSize);
+
+	//Hashes data from scratch
+	void build(const std::span<const u8>& data, ThreadPool* threadPool = nullptr);
+
+	/*
+		Rehashes the leaves overlapping the modified range [offset, offset + size) of data, which is the complete new input.
+		If the input size changed since the last call, the leaves from the old end onwards are rehashed as well.
+	*/
+	void update(const std::span<const u8>& data, SizeT offset, SizeT size, ThreadPool* threadPool = nullptr);
+
+	//Returns the indices of leaves differing between both trees. Leaves present in only one of them count as differing.
+	std::vector<SizeT> compare(const TreeHash& other) const;
+
+	Hash<256> getRoot() const;
+	std::span<const Hash<256>> getLeafHashes() const;
+
+	SizeT getLeafSize() const;
+	SizeT getLeafCount() const;
+	SizeT getDataSize() const;
+
+	//Computes the root of data without keeping the tree
+	static Hash<256> hash(const std::span<const u8>& data, SizeT leafSize = DefaultLeafSize, ThreadPool* threadPool = nullptr);
+
+private:
+
+	//Minimum number of bytes hashed by a single task
+	constexpr static SizeT MinTaskSize = 1 << 20;
+
+	static SizeT leafCount(SizeT dataSize, SizeT leafSize);
+
+	void hashLeaves(const std::span<const u8>& data, SizeT first, SizeT last, ThreadPool* threadPool);
+
+	//Recomputes the ancestors of the leaves in [first, last) and resizes the inner levels to the leaf count
+	void hashNodes(SizeT first, SizeT last);
+
+	SizeT leafSize;
+	SizeT dataSize;
+	std::vector<Hash<256>> leaves;
+	std::vector<std::vector<Hash<256>>> nodes;	//Inner levels from the parents of the leaves up to the root
+
+};
\ No newline at end of file
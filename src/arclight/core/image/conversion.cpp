@@ -0,0 +1,395 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 conversion.cpp
+ */
+
+#include "conversion.hpp"
+#include "arcintrinsic.hpp"
+#include "concurrent/threadpool.hpp"
+#include "util/cpuid.hpp"
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+
+
+//Pixels per parallel task and the minimum image size worth distributing
+constexpr static SizeT parallelGrain = 1 << 16;
+constexpr static SizeT parallelThreshold = 1 << 18;
+
+constexpr static u32 formatCount = static_cast<u32>(Pixel::ARGB8) + 1;
+
+using ConversionFunction = void(*)(const u8* source, u8* target, SizeT count);
+using ConversionTable = std::array<ConversionFunction, formatCount * formatCount>;
+
+
+
+template<Pixel From, Pixel To>
+static void convertDefault(const u8* source, u8* target, SizeT count) {
+
+	if constexpr (From == To) {
+
+		if (source != target) {
+			std::memcpy(target, source, count * PixelFormat<From>::BytesPerPixel);
+		}
+
+	} else {
+
+		//Pixel types are plain byte arrays, so the buffers are accessed as pixels directly like Image does
+		const PixelType<From>* sourcePixels = reinterpret_cast<const PixelType<From>*>(source);
+		PixelType<To>* targetPixels = reinterpret_cast<PixelType<To>*>(target);
+
+		//Each pixel is read completely before its target is written, which keeps in-place conversions intact
+		for (SizeT i = 0; i < count; i++) {
+			targetPixels[i] = PixelConverter::convert<To>(sourcePixels[i]);
+		}
+
+	}
+
+}
+
+
+
+template<SizeT... I>
+constexpr static ConversionTable makeDefaultTable(std::index_sequence<I...>) {
+	return {{ convertDefault<static_cast<Pixel>(I / formatCount), static_cast<Pixel>(I % formatCount)>... }};
+}
+
+constexpr static ConversionTable defaultTable = makeDefaultTable(std::make_index_sequence<formatCount * formatCount>{});
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+//Formats with 3 or 4 byte sized channels, conversions among them are pure byte shuffles
+template<Pixel P>
+constexpr static bool isByteFormat() {
+	return P == Pixel::RGB8 || P == Pixel::BGR8 || P == Pixel::RGBA8 || P == Pixel::ABGR8 || P == Pixel::BGRA8 || P == Pixel::ARGB8;
+}
+
+template<Pixel P>
+constexpr static bool isPackedFormat() {
+	return P == Pixel::RGB5 || P == Pixel::BGR5;
+}
+
+
+
+/*
+	pshufb control for four pixels of From converted to To.
+	Target bytes of channels missing in From are zeroed by the shuffle, a missing alpha channel is filled with 0xFF afterwards.
+*/
+struct ShuffleMask {
+
+	alignas(16) i8 shuffle[16];
+	alignas(16) u8 fill[16];
+
+};
+
+template<Pixel From, Pixel To>
+constexpr static ShuffleMask makeShuffleMask() {
+
+	using SourceFormat = PixelFormat<From>;
+	using TargetFormat = PixelFormat<To>;
+
+	constexpr u32 SourceMasks[4] = {SourceFormat::RedMask, SourceFormat::GreenMask, SourceFormat::BlueMask, SourceFormat::AlphaMask};
+	constexpr u32 SourceShifts[4] = {SourceFormat::RedShift, SourceFormat::GreenShift, SourceFormat::BlueShift, SourceFormat::AlphaShift};
+	constexpr u32 TargetMasks[4] = {TargetFormat::RedMask, TargetFormat::GreenMask, TargetFormat::BlueMask, TargetFormat::AlphaMask};
+	constexpr u32 TargetShifts[4] = {TargetFormat::RedShift, TargetFormat::GreenShift, TargetFormat::BlueShift, TargetFormat::AlphaShift};
+
+	ShuffleMask mask {};
+
+	for (u32 i = 0; i < 16; i++) {
+		mask.shuffle[i] = -1;
+	}
+
+	for (u32 k = 0; k < 4; k++) {
+
+		for (u32 c = 0; c < 4; c++) {
+
+			if (!TargetMasks[c]) {
+				continue;
+			}
+
+			u32 target = k * TargetFormat::BytesPerPixel + TargetShifts[c] / 8;
+
+			if (SourceMasks[c]) {
+				mask.shuffle[target] = static_cast<i8>(k * SourceFormat::BytesPerPixel + SourceShifts[c] / 8);
+			} else {
+				mask.fill[target] = 0xFF;
+			}
+
+		}
+
+	}
+
+	return mask;
+
+}
+
+template<Pixel From, Pixel To>
+constexpr static ShuffleMask shuffleMask = makeShuffleMask<From, To>();
+
+
+
+//Stores four converted pixels, 3 byte targets are written exactly to keep the following pixels intact
+template<u32 TargetBytes>
+ARC_TARGET("ssse3") static void storeQuad(u8* target, __m128i v) {
+
+	if constexpr (TargetBytes == 4) {
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(target), v);
+
+	} else {
+
+		u32 tail = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(target), v);
+		std::memcpy(target + 8, &tail, 4);
+
+	}
+
+}
+
+
+
+template<Pixel From, Pixel To>
+ARC_TARGET("ssse3") static void shuffleSSSE3(const u8* source, u8* target, SizeT count) {
+
+	constexpr u32 SourceBytes = PixelFormat<From>::BytesPerPixel;
+	constexpr u32 TargetBytes = PixelFormat<To>::BytesPerPixel;
+
+	//Four pixels per step, 3 byte sources load 16 bytes and need four bytes of slack
+	constexpr SizeT Reserve = SourceBytes == 3 ? 6 : 4;
+
+	const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffleMask<From, To>.shuffle));
+	const __m128i fill = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffleMask<From, To>.fill));
+
+	SizeT i = 0;
+
+	for (; count - i >= Reserve; i += 4) {
+
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * SourceBytes));
+		storeQuad<TargetBytes>(target + i * TargetBytes, _mm_or_si128(_mm_shuffle_epi8(v, shuffle), fill));
+
+	}
+
+	convertDefault<From, To>(source + i * SourceBytes, target + i * TargetBytes, count - i);
+
+}
+
+
+
+//Eight pixels per step, the shuffle is applied to both lanes separately
+template<Pixel From, Pixel To>
+ARC_TARGET("avx2") static void shuffleAVX2(const u8* source, u8* target, SizeT count) {
+
+	constexpr u32 SourceBytes = PixelFormat<From>::BytesPerPixel;
+	constexpr u32 TargetBytes = PixelFormat<To>::BytesPerPixel;
+
+	//3 byte sources fetch the upper four pixels with a separate load ending four bytes past them
+	constexpr SizeT Reserve = SourceBytes == 3 ? 10 : 8;
+
+	const __m256i shuffle = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(shuffleMask<From, To>.shuffle)));
+	const __m256i fill = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(shuffleMask<From, To>.fill)));
+	const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+	SizeT i = 0;
+
+	for (; count - i >= Reserve; i += 8) {
+
+		const u8* s = source + i * SourceBytes;
+		u8* t = target + i * TargetBytes;
+
+		__m256i v;
+
+		if constexpr (SourceBytes == 4) {
+			v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+		} else {
+			v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s))), _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + 12)), 1);
+		}
+
+		v = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), fill);
+
+		if constexpr (TargetBytes == 4) {
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(t), v);
+
+		} else {
+
+			//Both lanes hold twelve valid bytes, join them to 24 contiguous ones
+			v = _mm256_permutevar8x32_epi32(v, compact);
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(t), _mm256_castsi256_si128(v));
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(t + 16), _mm256_extracti128_si256(v, 1));
+
+		}
+
+	}
+
+	convertDefault<From, To>(source + i * SourceBytes, target + i * TargetBytes, count - i);
+
+}
+
+
+
+//Expands the 5 bit channels of eight packed pixels to bytes and interleaves them as c0 c1 c2 0xFF with c0 in the lowest bits
+ARC_TARGET("ssse3") static void unpack555(__m128i v, __m128i& low, __m128i& high) {
+
+	const __m128i channelMask = _mm_set1_epi16(0x1F);
+
+	__m128i c0 = _mm_and_si128(v, channelMask);
+	__m128i c1 = _mm_and_si128(_mm_srli_epi16(v, 5), channelMask);
+	__m128i c2 = _mm_and_si128(_mm_srli_epi16(v, 10), channelMask);
+
+#ifdef ARC_PIXEL_EXACT
+	//round(x * 255 / 31) for all x in [0, 31]
+	const __m128i scale = _mm_set1_epi16(527);
+	const __m128i bias = _mm_set1_epi16(23);
+
+	c0 = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(c0, scale), bias), 6);
+	c1 = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(c1, scale), bias), 6);
+	c2 = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(c2, scale), bias), 6);
+#else
+	c0 = _mm_slli_epi16(c0, 3);
+	c1 = _mm_slli_epi16(c1, 3);
+	c2 = _mm_slli_epi16(c2, 3);
+#endif
+
+	__m128i c01 = _mm_unpacklo_epi8(_mm_packus_epi16(c0, c0), _mm_packus_epi16(c1, c1));
+	__m128i c23 = _mm_unpacklo_epi8(_mm_packus_epi16(c2, c2), _mm_set1_epi8(-1));
+
+	low = _mm_unpacklo_epi16(c01, c23);
+	high = _mm_unpackhi_epi16(c01, c23);
+
+}
+
+
+
+/*
+	RGB5 unpacks to RGBA8 byte order and BGR5 to BGRA8, the result is then shuffled into the target like a 4 byte source.
+	The unpacked alpha is opaque, matching the scalar conversion of formats without alpha.
+*/
+template<Pixel From, Pixel To>
+ARC_TARGET("ssse3") static void unpackSSSE3(const u8* source, u8* target, SizeT count) {
+
+	constexpr Pixel Unpacked = From == Pixel::RGB5 ? Pixel::RGBA8 : Pixel::BGRA8;
+	constexpr u32 TargetBytes = PixelFormat<To>::BytesPerPixel;
+
+	const __m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(shuffleMask<Unpacked, To>.shuffle));
+
+	SizeT i = 0;
+
+	for (; i + 8 <= count; i += 8) {
+
+		__m128i low, high;
+		unpack555(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source + i * 2)), low, high);
+
+		storeQuad<TargetBytes>(target + i * TargetBytes, _mm_shuffle_epi8(low, shuffle));
+		storeQuad<TargetBytes>(target + (i + 4) * TargetBytes, _mm_shuffle_epi8(high, shuffle));
+
+	}
+
+	convertDefault<From, To>(source + i * 2, target + i * TargetBytes, count - i);
+
+}
+
+
+
+template<Pixel From, Pixel To>
+constexpr static ConversionFunction selectSSSE3() {
+
+	if constexpr (From != To && isByteFormat<From>() && isByteFormat<To>()) {
+		return shuffleSSSE3<From, To>;
+	} else if constexpr (isPackedFormat<From>() && isByteFormat<To>()) {
+		return unpackSSSE3<From, To>;
+	} else {
+		return convertDefault<From, To>;
+	}
+
+}
+
+template<Pixel From, Pixel To>
+constexpr static ConversionFunction selectAVX2() {
+
+	if constexpr (From != To && isByteFormat<From>() && isByteFormat<To>()) {
+		return shuffleAVX2<From, To>;
+	} else {
+		return selectSSSE3<From, To>();
+	}
+
+}
+
+
+
+template<SizeT... I>
+constexpr static ConversionTable makeSSSE3Table(std::index_sequence<I...>) {
+	return {{ selectSSSE3<static_cast<Pixel>(I / formatCount), static_cast<Pixel>(I % formatCount)>()... }};
+}
+
+template<SizeT... I>
+constexpr static ConversionTable makeAVX2Table(std::index_sequence<I...>) {
+	return {{ selectAVX2<static_cast<Pixel>(I / formatCount), static_cast<Pixel>(I % formatCount)>()... }};
+}
+
+constexpr static ConversionTable ssse3Table = makeSSSE3Table(std::make_index_sequence<formatCount * formatCount>{});
+constexpr static ConversionTable avx2Table = makeAVX2Table(std::make_index_sequence<formatCount * formatCount>{});
+
+#endif
+
+
+
+static const ConversionTable& conversionTable() {
+
+	static const ConversionTable& table = []() -> const ConversionTable& {
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::AVX2)) {
+			return avx2Table;
+		}
+
+		if (CPUID::hasFeature(CPUFeature::SSSE3)) {
+			return ssse3Table;
+		}
+
+#endif
+
+		return defaultTable;
+
+	}();
+
+	return table;
+
+}
+
+
+
+void PixelConversion::convert(Pixel from, Pixel to, const u8* source, u8* target, SizeT count, ThreadPool* threadPool) {
+
+	u32 fromIndex = static_cast<u32>(from);
+	u32 toIndex = static_cast<u32>(to);
+
+	arc_assert(fromIndex < formatCount && toIndex < formatCount, "Illegal pixel format");
+
+	ConversionFunction function = conversionTable()[fromIndex * formatCount + toIndex];
+
+	SizeT sourceBytes = getPixelSize(from);
+	SizeT targetBytes = getPixelSize(to);
+
+	if (threadPool && count >= parallelThreshold) {
+
+		threadPool->parallelFor(0, count, [&](SizeT begin, SizeT end) {
+			function(source + begin * sourceBytes, target + begin * targetBytes, end - begin);
+		}, parallelGrain);
+
+	} else {
+
+		function(source, target, count);
+
+	}
+
+}
\ No newline at end of file
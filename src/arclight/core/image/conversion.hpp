@@ -0,0 +1,69 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 conversion.hpp
+ */
+
+#pragma once
+
+#include "pixel.hpp"
+#include "types.hpp"
+
+#include <span>
+
+
+
+class ThreadPool;
+
+
+
+/*
+	Bulk pixel format conversion.
+	Every (From, To) pair of Pixel has a span kernel producing the same result as PixelConverter::convert applied per pixel.
+	Swizzles between the 8 bit RGB(A) formats and RGB5/BGR5 unpacking are vectorized with SSSE3/AVX2 where available.
+*/
+namespace PixelConversion {
+
+	constexpr u32 getPixelSize(Pixel format) {
+
+		switch (format) {
+
+			case Pixel::Grayscale8: return PixelFormat<Pixel::Grayscale8>::BytesPerPixel;
+			case Pixel::BGR5:       return PixelFormat<Pixel::BGR5>::BytesPerPixel;
+			case Pixel::RGB5:       return PixelFormat<Pixel::RGB5>::BytesPerPixel;
+			case Pixel::BGR8:       return PixelFormat<Pixel::BGR8>::BytesPerPixel;
+			case Pixel::RGB8:       return PixelFormat<Pixel::RGB8>::BytesPerPixel;
+			case Pixel::RGBA8:      return PixelFormat<Pixel::RGBA8>::BytesPerPixel;
+			case Pixel::ABGR8:      return PixelFormat<Pixel::ABGR8>::BytesPerPixel;
+			case Pixel::BGRA8:      return PixelFormat<Pixel::BGRA8>::BytesPerPixel;
+			case Pixel::ARGB8:      return PixelFormat<Pixel::ARGB8>::BytesPerPixel;
+			default:                return 0;
+
+		}
+
+	}
+
+	//True if the conversion may run in place, which requires both formats to have the same pixel size
+	constexpr bool isInPlace(Pixel from, Pixel to) {
+		return getPixelSize(from) == getPixelSize(to);
+	}
+
+	/*
+		Converts count pixels from source to target.
+		source and target may be identical if isInPlace(from, to) holds, otherwise they must not overlap.
+		Large conversions are split across threadPool if given.
+	*/
+	void convert(Pixel from, Pixel to, const u8* source, u8* target, SizeT count, ThreadPool* threadPool = nullptr);
+
+	//Converts all pixels of source, target must hold the same number of pixels
+	template<Pixel From, Pixel To>
+	void convert(std::span<const PixelType<From>> source, std::span<PixelType<To>> target, ThreadPool* threadPool = nullptr) {
+
+		arc_assert(source.size() == target.size(), "Pixel conversion size mismatch");
+		convert(From, To, Bits::toByteArray(source.data()), Bits::toByteArray(target.data()), source.size(), threadPool);
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,612 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 inflate.cpp
+ */
+
+#include "inflate.hpp"
+#include "zlib.hpp"
+#include "arcintrinsic.hpp"
+#include "math/math.hpp"
+#include "util/bits.hpp"
+
+#include <array>
+#include <cstring>
+
+
+
+constexpr static u32 EntryLength = 0x1000;
+constexpr static u32 EntryEnd = 0x2000;
+constexpr static u32 EntrySubtable = 0x4000;
+constexpr static u32 EntryInvalid = 0x8000;
+
+constexpr static u32 EntryFlagMask = 0xF000;
+constexpr static u32 EntryLengthMask = 0x1F;
+
+//Table entry templates without code length for every symbol
+constexpr static std::array<u32, 288> literalSymbols = []() {
+
+	std::array<u32, 288> a {};
+
+	for (u32 i = 0; i < 256; i++) {
+		a[i] = i << 16;
+	}
+
+	a[256] = EntryEnd;
+
+	for (u32 i = 0; i < 29; i++) {
+		a[257 + i] = Zlib::lengthBase[i] << 16 | EntryLength | Zlib::lengthExtra[i] << 8;
+	}
+
+	a[286] = EntryInvalid;
+	a[287] = EntryInvalid;
+
+	return a;
+
+}();
+
+constexpr static std::array<u32, 32> distanceSymbols = []() {
+
+	std::array<u32, 32> a {};
+
+	for (u32 i = 0; i < 30; i++) {
+		a[i] = u32(Zlib::distanceBase[i]) << 16 | Zlib::distanceExtra[i] << 8;
+	}
+
+	a[30] = EntryInvalid;
+	a[31] = EntryInvalid;
+
+	return a;
+
+}();
+
+constexpr static std::array<u32, 19> codeLengthSymbols = []() {
+
+	std::array<u32, 19> a {};
+
+	for (u32 i = 0; i < 19; i++) {
+		a[i] = i << 16;
+	}
+
+	return a;
+
+}();
+
+
+
+ARC_FORCE_INLINE static u32 lookup(const u32* table, u64 bitBuffer, u32 tableBits) {
+
+	u32 entry = table[bitBuffer & ((1 << tableBits) - 1)];
+
+	if (entry & EntrySubtable) {
+		entry = table[(entry >> 16) + ((bitBuffer >> tableBits) & ((1 << ((entry >> 8) & 0xF)) - 1))];
+	}
+
+	return entry;
+
+}
+
+
+
+Inflater::Inflater() : inStart(nullptr), in(nullptr), inEnd(nullptr), outStart(nullptr), out(nullptr), outEnd(nullptr), bitBuffer(0), bitCount(0), overrun(0) {
+
+	u8 lengths[288];
+
+	std::fill_n(lengths, 144, 8);
+	std::fill_n(lengths + 144, 112, 9);
+	std::fill_n(lengths + 256, 24, 7);
+	std::fill_n(lengths + 280, 8, 8);
+
+	buildTable(lengths, literalSymbols, LiteralTableBits, fixedLiteralTable);
+
+	std::fill_n(lengths, 32, 5);
+
+	buildTable(std::span{lengths, 32}, distanceSymbols, DistanceTableBits, fixedDistanceTable);
+
+}
+
+
+
+void Inflater::inflate(std::span<const u8> input, std::span<u8> output) {
+
+	if (input.size() < 6) {
+		throw ImageDecoderException("Zlib stream too small");
+	}
+
+	u8 cmf = input[0];
+	u8 flg = input[1];
+
+	if ((cmf & 0xF) != 8 || (cmf >> 4) > 7 || (cmf << 8 | flg) % 31) {
+		throw ImageDecoderException("Bad zlib stream header");
+	}
+
+	if (flg & 0x20) {
+		throw UnsupportedOperationException("Zlib preset dictionaries are not supported");
+	}
+
+	inStart = input.data();
+	in = inStart + 2;
+	inEnd = inStart + input.size();
+	outStart = output.data();
+	out = outStart;
+	outEnd = outStart + output.size();
+
+	bitBuffer = 0;
+	bitCount = 0;
+	overrun = 0;
+
+	bool finalBlock = false;
+
+	while (!finalBlock) {
+
+		refill();
+
+		finalBlock = bits(1);
+		u32 type = bits(2);
+
+		switch (type) {
+
+			case 0:
+				copyStoredBlock();
+				break;
+
+			case 1:
+				inflateBlock(fixedLiteralTable, fixedDistanceTable);
+				break;
+
+			case 2:
+				readDynamicTables();
+				inflateBlock(literalTable, distanceTable);
+				break;
+
+			default:
+				throw ImageDecoderException("Bad deflate block type");
+
+		}
+
+	}
+
+	if (out != outEnd) {
+		throw ImageDecoderException("Deflate stream ended early");
+	}
+
+	//Return the unused whole bytes of the bit buffer to the input
+	alignToByte();
+	checkOverrun();
+
+	const u8* trailer = in - (bitCount >> 3) + overrun;
+
+	if (inEnd - trailer < 4) {
+		throw ImageDecoderException("Zlib stream is missing the checksum");
+	}
+
+	if (Bits::swap32(Bits::assemble<u32>(trailer)) != Zlib::adler32(output)) {
+		throw ImageDecoderException("Zlib checksum mismatch");
+	}
+
+}
+
+
+
+void Inflater::buildTable(std::span<const u8> lengths, std::span<const u32> symbols, u32 tableBits, std::vector<u32>& table) {
+
+	u32 counts[16] = {};
+
+	for (u8 length : lengths) {
+		counts[length]++;
+	}
+
+	counts[0] = 0;
+
+	//Incomplete codes are permitted, their unused entries are marked as invalid
+	i32 left = 1;
+
+	for (u32 i = 1; i < 16; i++) {
+
+		left = (left << 1) - counts[i];
+
+		if (left < 0) {
+			throw ImageDecoderException("Over-subscribed Huffman code");
+		}
+
+	}
+
+	u32 nextCode[16] = {};
+
+	for (u32 i = 1, code = 0; i < 16; i++) {
+
+		code = (code + counts[i - 1]) << 1;
+		nextCode[i] = code;
+
+	}
+
+	u32 primarySize = 1 << tableBits;
+	u32 primaryMask = primarySize - 1;
+
+	std::array<u16, 288> codes;
+	std::array<u8, 1 << LiteralTableBits> subtableBits {};
+
+	//Deflate sends codes starting with the MSB, so the table is indexed by the reversed code
+	for (u32 i = 0; i < lengths.size(); i++) {
+
+		u32 length = lengths[i];
+
+		if (!length) {
+			continue;
+		}
+
+		codes[i] = Bits::reverse<u16>(nextCode[length]++) >> (16 - length);
+
+		if (length > tableBits) {
+
+			u8& bits = subtableBits[codes[i] & primaryMask];
+			bits = Math::max(bits, u8(length - tableBits));
+
+		}
+
+	}
+
+	table.assign(primarySize, EntryInvalid);
+
+	u32 offset = primarySize;
+
+	for (u32 i = 0; i < primarySize; i++) {
+
+		if (subtableBits[i]) {
+
+			table[i] = offset << 16 | EntrySubtable | subtableBits[i] << 8 | tableBits;
+			offset += 1 << subtableBits[i];
+
+		}
+
+	}
+
+	table.resize(offset, EntryInvalid);
+
+	for (u32 i = 0; i < lengths.size(); i++) {
+
+		u32 length = lengths[i];
+
+		if (!length) {
+			continue;
+		}
+
+		u32 entry = symbols[i] | length;
+		u32 code = codes[i];
+
+		if (length <= tableBits) {
+
+			for (u32 j = code; j < primarySize; j += 1 << length) {
+				table[j] = entry;
+			}
+
+		} else {
+
+			u32 pointer = table[code & primaryMask];
+			u32 base = pointer >> 16;
+			u32 size = 1 << ((pointer >> 8) & 0xF);
+
+			for (u32 j = code >> tableBits; j < size; j += 1 << (length - tableBits)) {
+				table[base + j] = entry;
+			}
+
+		}
+
+	}
+
+}
+
+
+
+void Inflater::readDynamicTables() {
+
+	refill();
+
+	u32 literalCount = bits(5) + 257;
+	u32 distanceCount = bits(5) + 1;
+	u32 codeLengthCount = bits(4) + 4;
+
+	if (literalCount > 286 || distanceCount > 30) {
+		throw ImageDecoderException("Bad deflate code counts");
+	}
+
+	u8 codeLengths[19] = {};
+
+	refill();
+
+	//Up to 57 bits, one more than a single refill guarantees
+	for (u32 i = 0; i < codeLengthCount; i++) {
+
+		if (i == 16) {
+			refill();
+		}
+
+		codeLengths[Zlib::codeLengthOrder[i]] = bits(3);
+
+	}
+
+	buildTable(codeLengths, codeLengthSymbols, CodeLengthTableBits, codeLengthTable);
+
+	//Literal and distance lengths form a single sequence, repeats may cross the boundary
+	u8 lengths[286 + 30];
+	u32 count = literalCount + distanceCount;
+
+	for (u32 i = 0; i < count;) {
+
+		refill();
+
+		u32 entry = lookup(codeLengthTable.data(), bitBuffer, CodeLengthTableBits);
+
+		if (entry & EntryInvalid) {
+			throw ImageDecoderException("Bad code length code");
+		}
+
+		consume(entry & EntryLengthMask);
+
+		u32 symbol = entry >> 16;
+		u32 repeat = 0;
+		u8 value = 0;
+
+		if (symbol < 16) {
+
+			lengths[i++] = symbol;
+			continue;
+
+		} else if (symbol == 16) {
+
+			if (!i) {
+				throw ImageDecoderException("Code length repeat without previous length");
+			}
+
+			value = lengths[i - 1];
+			repeat = bits(2) + 3;
+
+		} else if (symbol == 17) {
+
+			repeat = bits(3) + 3;
+
+		} else {
+
+			repeat = bits(7) + 11;
+
+		}
+
+		if (i + repeat > count) {
+			throw ImageDecoderException("Code length repeat exceeds code count");
+		}
+
+		std::fill_n(lengths + i, repeat, value);
+		i += repeat;
+
+	}
+
+	if (!lengths[256]) {
+		throw ImageDecoderException("Deflate block lacks an end code");
+	}
+
+	buildTable(std::span{lengths, literalCount}, literalSymbols, LiteralTableBits, literalTable);
+	buildTable(std::span{lengths + literalCount, distanceCount}, distanceSymbols, DistanceTableBits, distanceTable);
+
+}
+
+
+
+void Inflater::inflateBlock(const std::vector<u32>& literalTable, const std::vector<u32>& distanceTable) {
+
+	const u32* literals = literalTable.data();
+	const u32* distances = distanceTable.data();
+
+	while (true) {
+
+		//A refill provides at least 56 bits, enough for a length code with extra bits followed by a distance code with extra bits
+		refill();
+
+		u32 entry = lookup(literals, bitBuffer, LiteralTableBits);
+		consume(entry & EntryLengthMask);
+
+		if (!(entry & EntryFlagMask)) {
+
+			if (out == outEnd) {
+				throw ImageDecoderException("Deflate stream exceeds the output size");
+			}
+
+			*out++ = entry >> 16;
+			continue;
+
+		}
+
+		if (entry & EntryLength) {
+
+			u32 length = (entry >> 16) + bits((entry >> 8) & 0xF);
+			u32 distanceEntry = lookup(distances, bitBuffer, DistanceTableBits);
+
+			if (distanceEntry & EntryInvalid) {
+				throw ImageDecoderException("Bad deflate distance code");
+			}
+
+			consume(distanceEntry & EntryLengthMask);
+
+			u32 distance = (distanceEntry >> 16) + bits((distanceEntry >> 8) & 0xF);
+
+			if (distance > SizeT(out - outStart)) {
+				throw ImageDecoderException("Deflate distance exceeds the decoded data");
+			}
+
+			if (length > SizeT(outEnd - out)) {
+				throw ImageDecoderException("Deflate stream exceeds the output size");
+			}
+
+			const u8* src = out - distance;
+			u8* end = out + length;
+
+			//Chunked copies may write up to 15 bytes past the match, which are overwritten by subsequent data
+			if (outEnd - end >= 16 && distance >= 8) {
+
+				if (distance >= 16) {
+
+					do {
+
+						std::memcpy(out, src, 16);
+						out += 16;
+						src += 16;
+
+					} while (out < end);
+
+				} else {
+
+					do {
+
+						std::memcpy(out, src, 8);
+						out += 8;
+						src += 8;
+
+					} while (out < end);
+
+				}
+
+			} else if (outEnd - end >= 16 && distance == 1) {
+
+				std::memset(out, *src, 16);
+
+				if (length > 16) {
+					std::memset(out + 16, *src, length - 16);
+				}
+
+			} else {
+
+				while (out < end) {
+					*out++ = *src++;
+				}
+
+			}
+
+			out = end;
+			continue;
+
+		}
+
+		if (entry & EntryEnd) {
+
+			checkOverrun();
+			return;
+
+		}
+
+		throw ImageDecoderException("Bad deflate literal/length code");
+
+	}
+
+}
+
+
+
+void Inflater::copyStoredBlock() {
+
+	alignToByte();
+	checkOverrun();
+
+	//Stored data is copied straight from the input, so the bit buffer is emptied first
+	in -= (bitCount >> 3) - overrun;
+	bitBuffer = 0;
+	bitCount = 0;
+	overrun = 0;
+
+	if (inEnd - in < 4) {
+		throw ImageDecoderException("Stored block header truncated");
+	}
+
+	u16 length = Bits::assemble<u16>(in);
+	u16 complement = Bits::assemble<u16>(in + 2);
+	in += 4;
+
+	if (length != u16(~complement)) {
+		throw ImageDecoderException("Stored block length mismatch");
+	}
+
+	if (length > SizeT(inEnd - in)) {
+		throw ImageDecoderException("Stored block truncated");
+	}
+
+	if (length > SizeT(outEnd - out)) {
+		throw ImageDecoderException("Deflate stream exceeds the output size");
+	}
+
+	if (length) {
+		std::memcpy(out, in, length);
+	}
+
+	in += length;
+	out += length;
+
+}
+
+
+
+ARC_FORCE_INLINE void Inflater::refill() {
+
+	if (inEnd - in >= 8) {
+
+		//Loads whole bytes up to 56-63 valid bits, the remaining bits are rewritten by the next refill
+		u64 data;
+		std::memcpy(&data, in, 8);
+
+		bitBuffer |= Bits::little64(data) << bitCount;
+		in += (63 - bitCount) >> 3;
+		bitCount |= 56;
+
+	} else {
+
+		while (bitCount <= 56) {
+
+			if (in < inEnd) {
+				bitBuffer |= u64(*in++) << bitCount;
+			} else {
+				overrun++;
+			}
+
+			bitCount += 8;
+
+		}
+
+	}
+
+}
+
+
+
+ARC_FORCE_INLINE u32 Inflater::bits(u32 count) {
+
+	u32 value = bitBuffer & ((u64(1) << count) - 1);
+	consume(count);
+
+	return value;
+
+}
+
+
+
+ARC_FORCE_INLINE void Inflater::consume(u32 count) {
+
+	bitBuffer >>= count;
+	bitCount -= count;
+
+}
+
+
+
+void Inflater::alignToByte() {
+	consume(bitCount & 7);
+}
+
+
+
+void Inflater::checkOverrun() const {
+
+	//Bits beyond the end of the input are zero-filled, consuming any of them means the stream was truncated
+	if (overrun * 8 > bitCount) {
+		throw ImageDecoderException("Deflate stream truncated");
+	}
+
+}
\ No newline at end of file
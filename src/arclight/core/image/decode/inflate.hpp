@@ -0,0 +1,77 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 inflate.hpp
+ */
+
+#pragma once
+
+#include "decoder.hpp"
+#include "types.hpp"
+
+#include <span>
+#include <vector>
+
+
+
+/*
+	Inflater
+	Decompresses zlib streams (RFC 1950/1951) into a buffer of known size.
+	Input is consumed through a 64-bit bit buffer that is refilled with a single unaligned load, and Huffman codes are resolved by
+	a primary lookup table with second-level tables for long codes. Length and distance symbols directly carry their base values.
+	Tables are kept between calls to avoid reallocations when decoding multiple streams.
+*/
+class Inflater {
+
+public:
+
+	Inflater();
+
+	//Decompresses the zlib stream into output, which must have exactly the size of the decompressed data
+	void inflate(std::span<const u8> input, std::span<u8> output);
+
+private:
+
+	/*
+		Table entry layout:
+		Bits 0-4: Code length (total length for second-level entries, primary table bits for subtable pointers)
+		Bits 8-11: Extra bits (subtable bits for subtable pointers)
+		Bits 12-15: Entry flags
+		Bits 16-31: Literal, base length, base distance or subtable offset
+	*/
+	constexpr static u32 LiteralTableBits = 10;
+	constexpr static u32 DistanceTableBits = 8;
+	constexpr static u32 CodeLengthTableBits = 7;
+
+	static void buildTable(std::span<const u8> lengths, std::span<const u32> symbols, u32 tableBits, std::vector<u32>& table);
+
+	void readDynamicTables();
+	void inflateBlock(const std::vector<u32>& literalTable, const std::vector<u32>& distanceTable);
+	void copyStoredBlock();
+
+	void refill();
+	u32 bits(u32 count);
+	void consume(u32 count);
+	void alignToByte();
+	void checkOverrun() const;
+
+	const u8* inStart;
+	const u8* in;
+	const u8* inEnd;
+	u8* outStart;
+	u8* out;
+	u8* outEnd;
+
+	u64 bitBuffer;
+	u32 bitCount;
+	u32 overrun;
+
+	std::vector<u32> fixedLiteralTable;
+	std::vector<u32> fixedDistanceTable;
+	std::vector<u32> literalTable;
+	std::vector<u32> distanceTable;
+	std::vector<u32> codeLengthTable;
+
+};
\ No newline at end of file
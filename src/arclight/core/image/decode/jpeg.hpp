@@ -314,15 +314,21 @@ namespace JPEG {
 	struct FrameComponent {
 
 		constexpr FrameComponent() noexcept : FrameComponent(0, 0, 0) {}
-		constexpr FrameComponent(u32 sx, u32 sy, u32 qTableID) noexcept : samplesX(sx), samplesY(sy), qID(qTableID), width(0), height(0), progression(0) {}
+		constexpr FrameComponent(u32 sx, u32 sy, u32 qTableID) noexcept : samplesX(sx), samplesY(sy), qID(qTableID), width(0), height(0), blocksX(0), blocksY(0), windowY(0), progression(0) {}
 
 		u32 samplesX, samplesY;
 		u32 qID;
 
 		u32 width, height;
+		u32 blocksX, blocksY;
+
+		//First row held by imageData. Streaming decodes only keep a single MCU row resident.
+		u32 windowY;
 
 		u32 progression;
-		std::vector<i32> progressiveBuffer;
+
+		//Coefficients are stored block by block in the (transposed) order consumed by the IDCT, allowing elementwise dequantization
+		std::vector<i16> progressiveBuffer;
 		std::vector<i16> imageData;
 
 
@@ -330,7 +336,7 @@ namespace JPEG {
 
 	struct Frame {
 
-		Frame() : type(FrameType::Sequential), differential(false), encoding(Encoding::Huffman), bits(8), lines(0), samples(1) {}
+		Frame() : type(FrameType::Sequential), differential(false), encoding(Encoding::Huffman), bits(8), lines(0), samples(1), maxSamplesX(0), maxSamplesY(0), mcusX(0), mcusY(0), blockSize(8) {}
 
 		FrameType type;
 		bool differential;
@@ -340,7 +346,14 @@ namespace JPEG {
 		u32 lines;
 		u32 samples;
 
+		u32 maxSamplesX, maxSamplesY;
+		u32 mcusX, mcusY;
+
+		//Edge length of a decoded block, less than 8 if the image is downscaled in the DCT domain
+		u32 blockSize;
+
 		std::unordered_map<u8, FrameComponent> components;
+		std::vector<u8> componentOrder;
 
 	};
 
@@ -365,7 +378,7 @@ namespace JPEG {
 
 	struct Scan {
 
-		constexpr Scan() noexcept : spectralStart(0), spectralEnd(0), approximationHigh(0), approximationLow(0), predictor(1), pointTransform(0), maxSamplesX(0), maxSamplesY(0), mcuDataUnits(0), totalMCUs(0), mcusX(0), mcusY(0) {}
+		constexpr Scan() noexcept : spectralStart(0), spectralEnd(0), approximationHigh(0), approximationLow(0), predictor(1), pointTransform(0), mcuDataUnits(0), mcusX(0), mcusY(0), totalMCUs(0) {}
 
 		std::vector<ScanComponent> scanComponents;
 		u32 spectralStart;
@@ -375,7 +388,6 @@ namespace JPEG {
 		u32 predictor;
 		u32 pointTransform;
 
-		u32 maxSamplesX, maxSamplesY;
 		u32 mcuDataUnits;
 		u32 mcusX, mcusY;
 		u32 totalMCUs;
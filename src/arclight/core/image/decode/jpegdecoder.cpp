@@ -13,7 +13,10 @@
 #include "util/bool.hpp"
 #include "util/assert.hpp"
 #include "common/exception.hpp"
+#include "concurrent/threadpool.hpp"
+#include "util/cpuid.hpp"
 
+#include <algorithm>
 #include <map>
 
 
@@ -25,6 +28,7 @@ constexpr static u32 fixScaleShift = 10;
 constexpr static u32 fixMultiplyShift = 10;
 constexpr static u32 fixTransformShift = 7;
 constexpr static u32 ycbcrShift = 14;
+constexpr static u32 blendStripeHeight = 32;
 
 template<u32 Shift>
 constexpr static i32 colorBias = (Shift && Shift < 32) ? 1LL << (Shift - 1) : 0;
@@ -132,6 +136,7 @@ constexpr static bool app0StringCompare(const u8* a, const u8* b) noexcept {
 void JPEGDecoder::decode(std::span<const u8> data) {
 
 	validDecode = false;
+	stream = StreamState();
 
 	reader = BinaryReader(data, ByteOrder::Big);
 
@@ -149,6 +154,9 @@ void JPEGDecoder::decode(std::span<const u8> data) {
 	}
 
 	restartEnabled = false;
+	scanCount = 0;
+	frame = Frame();
+	scan = Scan();
 
 
 	//Find interpret markers
@@ -156,71 +164,22 @@ void JPEGDecoder::decode(std::span<const u8> data) {
 
 	while (marker != Markers::EOI) {
 
-		switch (marker) {
+		if (marker == Markers::SOS) {
 
-			case Markers::APP0:
-				parseApplicationSegment0();
-				break;
-
-			case Markers::APP1:
-				parseApplicationSegment1();
-				break;
-
-			case Markers::DQT:
-				parseQuantizationTable();
-				break;
-
-			case Markers::DHT:
-				parseHuffmanTable();
-				break;
-
-			case Markers::DAC:
-				parseArithmeticConditioning();
-				break;
-
-			case Markers::COM:
-				parseComment();
-				break;
-
-			case Markers::DRI:
-				parseRestartInterval();
-				break;
+			parseScanHeader();
+			resolveTargetFormat();
+			decodeScan();
+			scanCount++;
 
-			case Markers::SOF0:
-			case Markers::SOF1:
-			case Markers::SOF2:
-			case Markers::SOF3:
-			case Markers::SOF5:
-			case Markers::SOF6:
-			case Markers::SOF7:
-			case Markers::JPG:
-			case Markers::SOF9:
-			case Markers::SOF10:
-			case Markers::SOF11:
-			case Markers::SOF13:
-			case Markers::SOF14:
-			case Markers::SOF15:
-
-				frame.type = static_cast<FrameType>(marker & 0x03);
-				frame.encoding = static_cast<Encoding>((marker & 0x08) >> 3);
-				frame.differential = marker & 0x04;
-
-				parseFrameHeader();
-				break;
+		} else {
 
-			case Markers::SOS:
-				{
-					parseScanHeader();
-					resolveTargetFormat();
-					decodeScan();
-				}
-				break;
+			parseMarkerSegment(marker);
 
-			default:
-				//LogE("JPEG Decoder").print("Unknown marker 0x%X", marker);
-				reader.seek(-1);
-				break;
+		}
 
+		//Previews are built from the coefficients received so far
+		if (frame.type == FrameType::Progressive && scanLimit && scanCount >= scanLimit) {
+			break;
 		}
 
 
@@ -233,6 +192,16 @@ void JPEGDecoder::decode(std::span<const u8> data) {
 
 	}
 
+	if (frame.componentOrder.empty()) {
+		throw ImageDecoderException("No frame found");
+	}
+
+	collectFrameComponents();
+
+	if (frame.type == FrameType::Progressive) {
+		transformProgressiveComponents();
+	}
+
 	blendAndUpsample();
 
 	validDecode = true;
@@ -241,6 +210,189 @@ void JPEGDecoder::decode(std::span<const u8> data) {
 
 
 
+void JPEGDecoder::parseMarkerSegment(u16 marker) {
+
+	switch (marker) {
+
+		case Markers::APP0:
+			parseApplicationSegment0();
+			break;
+
+		case Markers::APP1:
+			parseApplicationSegment1();
+			break;
+
+		case Markers::DQT:
+			parseQuantizationTable();
+			break;
+
+		case Markers::DHT:
+			parseHuffmanTable();
+			break;
+
+		case Markers::DAC:
+			parseArithmeticConditioning();
+			break;
+
+		case Markers::COM:
+			parseComment();
+			break;
+
+		case Markers::DRI:
+			parseRestartInterval();
+			break;
+
+		case Markers::SOF0:
+		case Markers::SOF1:
+		case Markers::SOF2:
+		case Markers::SOF3:
+		case Markers::SOF5:
+		case Markers::SOF6:
+		case Markers::SOF7:
+		case Markers::JPG:
+		case Markers::SOF9:
+		case Markers::SOF10:
+		case Markers::SOF11:
+		case Markers::SOF13:
+		case Markers::SOF14:
+		case Markers::SOF15:
+
+			frame.type = static_cast<FrameType>(marker & 0x03);
+			frame.encoding = static_cast<Encoding>((marker & 0x08) >> 3);
+			frame.differential = marker & 0x04;
+
+			parseFrameHeader();
+			break;
+
+		default:
+			//LogE("JPEG Decoder").print("Unknown marker 0x%X", marker);
+			reader.seek(-1);
+			break;
+
+	}
+
+}
+
+
+
+void JPEGDecoder::setScanLimit(u32 scans) {
+	scanLimit = scans;
+}
+
+
+
+u32 JPEGDecoder::getScanCount() const {
+	return scanCount;
+}
+
+
+
+void JPEGDecoder::setScale(u32 denominator) {
+
+	if (denominator != 1 && denominator != 2 && denominator != 4 && denominator != 8) {
+		throw ImageDecoderException("Scale denominator must be 1, 2, 4 or 8");
+	}
+
+	scale = denominator;
+
+}
+
+
+
+void JPEGDecoder::beginStream(RowCallback callback) {
+
+	validDecode = false;
+	restartEnabled = false;
+	scanCount = 0;
+	frame = Frame();
+	scan = Scan();
+
+	stream = StreamState();
+	stream.callback = std::move(callback);
+	stream.phase = StreamPhase::Header;
+
+}
+
+
+
+bool JPEGDecoder::feed(std::span<const u8> data) {
+
+	if (stream.phase == StreamPhase::Idle) {
+		throw ImageDecoderException("No stream started");
+	}
+
+	//Data trailing EOI is ignored
+	if (stream.phase == StreamPhase::Finished) {
+		return true;
+	}
+
+	stream.input.insert(stream.input.end(), data.begin(), data.end());
+
+	if (stream.phase != StreamPhase::Buffered) {
+		advanceStream();
+	}
+
+	return stream.phase == StreamPhase::Finished;
+
+}
+
+
+
+void JPEGDecoder::endStream() {
+
+	if (stream.phase == StreamPhase::Buffered) {
+
+		finishBufferedStream();
+
+	} else if (stream.phase == StreamPhase::Scan) {
+
+		//No more data will arrive, so the last rows have to be decoded with what is there
+		stream.retrySize = 0;
+		advanceStream();
+
+	}
+
+	bool finished = stream.phase == StreamPhase::Finished;
+
+	//Release the stream buffers
+	stream = StreamState();
+
+	if (!finished) {
+		throw ImageDecoderException("Stream ended before the image was complete");
+	}
+
+}
+
+
+
+SizeT JPEGDecoder::getStreamInputSize() const {
+	return stream.input.size();
+}
+
+
+
+u32 JPEGDecoder::getStreamWindowRows() const {
+
+	if (stream.phase != StreamPhase::Scan && stream.phase != StreamPhase::Trailer) {
+		return 0;
+	}
+
+	u32 rows = 0;
+
+	for (const auto& [id, frameComponent] : frame.components) {
+
+		if (frameComponent.width) {
+			rows = Math::max(rows, static_cast<u32>(frameComponent.imageData.size() / frameComponent.width));
+		}
+
+	}
+
+	return rows;
+
+}
+
+
+
 RawImage& JPEGDecoder::getImage() {
 
 	if (!validDecode) {
@@ -850,6 +1002,10 @@ void JPEGDecoder::parseFrameHeader() {
 		}
 
 		frame.components.emplace(id, component);
+		frame.componentOrder.push_back(id);
+
+		frame.maxSamplesX = Math::max(frame.maxSamplesX, component.samplesX);
+		frame.maxSamplesY = Math::max(frame.maxSamplesY, component.samplesY);
 
 	}
 
@@ -858,6 +1014,36 @@ void JPEGDecoder::parseFrameHeader() {
 		searchForLineSegment();
 	}
 
+	u32 unitSize = frame.type == FrameType::Lossless ? 1 : 8;
+
+	frame.mcusX = (frame.samples + frame.maxSamplesX * unitSize - 1) / (frame.maxSamplesX * unitSize);
+	frame.mcusY = (frame.lines + frame.maxSamplesY * unitSize - 1) / (frame.maxSamplesY * unitSize);
+	frame.blockSize = frame.type == FrameType::Lossless ? 8 : 8 / scale;
+
+	//Setup component data, sized to the downscaled image
+	for (auto& [id, frameComponent] : frame.components) {
+
+		u32 width = (frame.samples * frameComponent.samplesX + frame.maxSamplesX - 1) / frame.maxSamplesX;
+		u32 height = (frame.lines * frameComponent.samplesY + frame.maxSamplesY - 1) / frame.maxSamplesY;
+
+		frameComponent.width = (width * frame.blockSize + 7) / 8;
+		frameComponent.height = (height * frame.blockSize + 7) / 8;
+		frameComponent.blocksX = frame.mcusX * frameComponent.samplesX;
+		frameComponent.blocksY = frame.mcusY * frameComponent.samplesY;
+
+		//Streaming decodes allocate their sample windows once the scan layout is known
+		if (stream.phase == StreamPhase::Header) {
+			continue;
+		}
+
+		if (frame.type == FrameType::Progressive) {
+			frameComponent.progressiveBuffer.assign(SizeT(frameComponent.blocksX) * frameComponent.blocksY * 64, 0);
+		}
+
+		frameComponent.imageData.resize(frameComponent.width * frameComponent.height);
+
+	}
+
 }
 
 
@@ -876,6 +1062,12 @@ void JPEGDecoder::parseScanHeader() {
 	LogI("JPEG Decoder").print("[SOS] Images: %d", components);
 #endif
 
+	if (frame.componentOrder.empty()) {
+		throw ImageDecoderException("[SOS] Scan without frame");
+	}
+
+	scan = Scan();
+
 	if (!Math::inRange(components, 1, 4)) {
 		throw ImageDecoderException("[SOS] Illegal component count");
 	}
@@ -902,9 +1094,6 @@ void JPEGDecoder::parseScanHeader() {
 
 		FrameComponent& frameComponent = frame.components[componentID];
 
-		scan.maxSamplesX = Math::max(scan.maxSamplesX, frameComponent.samplesX);
-		scan.maxSamplesY = Math::max(scan.maxSamplesY, frameComponent.samplesY);
-
 		if (dcTableID > 3 || (frame.type == FrameType::Sequential && dcTableID > 1)) {
 			throw ImageDecoderException("[SOS] Illegal DC table ID");
 		}
@@ -1004,10 +1193,6 @@ void JPEGDecoder::parseScanHeader() {
 					throw ImageDecoderException("[SOS] Bad scan settings");
 				}
 
-				if (restartEnabled && !(restartInterval % scan.mcusX)) {
-					throw ImageDecoderException("Restart interval must be an integer multiple of row MCUs");
-				}
-
 				//Alias to properly named variables
 				scan.pointTransform = scan.approximationLow;
 				scan.predictor = scan.spectralStart;
@@ -1024,44 +1209,33 @@ void JPEGDecoder::parseScanHeader() {
 
 	}
 
-	bool calcMCUs = true;
-	scan.mcuDataUnits = 0;
-
-	//Setup component data
-	for (ScanComponent& scanComponent : scan.scanComponents) {
-
-		FrameComponent& frameComponent = scanComponent.frameComponent;
-
-		frameComponent.width = (frame.samples * frameComponent.samplesX + scan.maxSamplesX - 1) / scan.maxSamplesX;
-		frameComponent.height = (frame.lines * frameComponent.samplesY + scan.maxSamplesY - 1) / scan.maxSamplesY;
-
-		u32 multipleX = frameComponent.samplesX;
-		u32 multipleY = frameComponent.samplesY;
-
-		if (frame.type != FrameType::Lossless) {
+	//Interleaved scans follow the frame MCU grid while non-interleaved scans consist of single data units
+	if (scan.scanComponents.size() > 1) {
 
-			multipleX *= 8;
-			multipleY *= 8;
+		scan.mcusX = frame.mcusX;
+		scan.mcusY = frame.mcusY;
+		scan.mcuDataUnits = 0;
 
+		for (const ScanComponent& scanComponent : scan.scanComponents) {
+			scan.mcuDataUnits += scanComponent.frameComponent.samplesX * scanComponent.frameComponent.samplesY;
 		}
 
-		scan.mcuDataUnits += frameComponent.samplesX * frameComponent.samplesY;
-
-		if (calcMCUs) {
+	} else {
 
-			scan.mcusX = (frameComponent.width + multipleX - 1) / multipleX;
-			scan.mcusY = (frameComponent.height + multipleY - 1) / multipleY;
-			scan.totalMCUs = scan.mcusX * scan.mcusY;
-			calcMCUs = false;
+		//Component dimensions are downscaled, so a data unit covers blockSize samples
+		const FrameComponent& frameComponent = scan.scanComponents[0].frameComponent;
+		u32 unitSize = frame.type == FrameType::Lossless ? 1 : frame.blockSize;
 
-		}
+		scan.mcusX = (frameComponent.width + unitSize - 1) / unitSize;
+		scan.mcusY = (frameComponent.height + unitSize - 1) / unitSize;
+		scan.mcuDataUnits = 1;
 
-		if (frame.type == FrameType::Progressive) {
-			frameComponent.progressiveBuffer.resize(scan.mcusX * scan.mcusY * 64);
-		}
+	}
 
-		frameComponent.imageData.resize(frameComponent.width * frameComponent.height);
+	scan.totalMCUs = scan.mcusX * scan.mcusY;
 
+	if (frame.type == FrameType::Lossless && restartEnabled && (restartInterval % scan.mcusX)) {
+		throw ImageDecoderException("Restart interval must be an integer multiple of row MCUs");
 	}
 
 	if (scan.mcuDataUnits > 10) {
@@ -1100,7 +1274,7 @@ void JPEGDecoder::resolveTargetFormat() {
 	//TODO: Finish this list
 	if (autoDetectFormat()) {
 
-		switch (scan.scanComponents.size()) {
+		switch (frame.components.size()) {
 
 			case 1:
 				baseFormat = Pixel::Grayscale8;
@@ -1120,7 +1294,7 @@ void JPEGDecoder::resolveTargetFormat() {
 
 		Pixel format = requestedFormat.value();
 
-		switch (scan.scanComponents.size()) {
+		switch (frame.components.size()) {
 
 			case 1:
 				baseFormat = Pixel::Grayscale8;
@@ -1148,8 +1322,8 @@ void JPEGDecoder::decodeScan() {
 		throw ImageDecoderException("Scan empty");
 	}
 
-	if (frame.bits != 8 || frame.type == FrameType::Progressive || frame.differential || (frame.type == FrameType::Lossless && frame.encoding == Encoding::Arithmetic)) {
-		throw UnsupportedOperationException("JPEG cannot be progressive, hierarchical or non-8 bpp");
+	if (frame.bits != 8 || frame.differential || (frame.type != FrameType::Sequential && frame.type != FrameType::ExtendedSequential && frame.encoding == Encoding::Arithmetic)) {
+		throw UnsupportedOperationException("JPEG cannot be hierarchical, non-8 bpp or arithmetic coded progressive/lossless");
 	}
 
 	//Start scan decoding
@@ -1157,16 +1331,22 @@ void JPEGDecoder::decodeScan() {
 
 		u32 restartCount = scan.totalMCUs / restartInterval;
 		u32 baseMCU = 0;
+		SizeT scanEnd = 0;
+
+		//Restart intervals are independent of each other except for lossless prediction. Corrupted streams take the sequential path.
+		if (threadPool && threadPool->getWorkerCount() > 1 && restartCount > 1 && frame.encoding == Encoding::Huffman && frame.type != FrameType::Lossless && splitRestartIntervals(scanEnd)) {
+
+			decodeScanParallel(scanEnd);
+			return;
+
+		}
 
 		for (u32 i = 0; i < restartCount; i++) {
 
 			decodeImage(baseMCU, baseMCU + restartInterval);
 			baseMCU += restartInterval;
 
-			//Skip potential marker
-			if (reader.remainingSize() >= 2 && Math::inRange(reader.peek<u16>(), Markers::RST0, Markers::RST7)) {
-				reader.seek(2);
-			}
+			skipToRestartMarker();
 
 		}
 
@@ -1184,173 +1364,363 @@ void JPEGDecoder::decodeScan() {
 
 
 
-void JPEGDecoder::decodeImage(u32 startMCU, u32 endMCU) {
+void JPEGDecoder::decodeScanParallel(SizeT scanEnd) {
 
-	auto decodeBlock = [this](ScanComponent& scanComponent, bool Huffman) constexpr {
+	u32 intervalCount = restartSegments.size();
 
-		if (Huffman) {
-			decodeHuffmanBlock(scanComponent);
-		} else {
-			decodeArithmeticBlock(scanComponent);
-		}
+	//Each worker owns a decoder, the scan component state and a block buffer. Intervals write to disjoint MCUs.
+	threadPool->parallelFor(0, intervalCount, [this](SizeT begin, SizeT end) {
 
-	};
+		std::vector<ScanComponent> components(scan.scanComponents);
 
-	auto doDecode = [&, this]<FrameType Type, bool Huffman, bool Interleave>() {
+		for (SizeT i = begin; i < end; i++) {
 
-		SizeT mcuX = startMCU % scan.mcusX;
-		SizeT mcuY = startMCU / scan.mcusX;
+			BinaryReader intervalReader(restartSegments[i], ByteOrder::Big);
+			HuffmanDecoder decoder(intervalReader);
 
-		auto sequentialDecode = [&](ScanComponent& scanComponent) {
+			u32 startMCU = i * restartInterval;
+			u32 endMCU = Math::min(startMCU + restartInterval, scan.totalMCUs);
 
-			FrameComponent& component = scanComponent.frameComponent;
+			decodeImage(startMCU, endMCU, decoder, components);
 
-			SizeT mcuBaseX = mcuX * component.samplesX * 8;
-			SizeT mcuBaseY = mcuY * component.samplesY * 8;
+		}
 
-			for (u32 sy = 0; sy < component.samplesY; sy++) {
+	});
 
-				SizeT baseY = mcuBaseY + sy * 8;
+	reader.seekTo(scanEnd);
 
-				if (baseY + 8 > component.height) {
+}
 
-					SizeT h = component.height - baseY;
 
-					for (u32 sx = 0; sx < component.samplesX; sx++) {
 
-						SizeT baseX = mcuBaseX + sx * 8;
-						SizeT w = 8;
+bool JPEGDecoder::splitRestartIntervals(SizeT& scanEnd) {
 
-						if (baseX + 8 > component.width) {
-							w = component.width - baseX;
-						}
+	std::span<const u8> data = reader.getStream();
+	SizeT segmentStart = reader.position();
+	SizeT cursor = segmentStart;
 
-						decodeBlock(scanComponent, Huffman);
-						applyPartialIDCT(scanComponent, baseY * component.width + baseX, w, h);
+	restartSegments.clear();
 
-					}
+	while (true) {
 
-				} else {
+		const u8* marker = std::find(data.data() + cursor, data.data() + data.size(), 0xFF);
+		cursor = marker - data.data();
 
-					for (u32 sx = 0; sx < component.samplesX; sx++) {
+		if (cursor + 1 >= data.size()) {
+			return false;
+		}
 
-						SizeT baseX = mcuBaseX + sx * 8;
+		u8 markerByte = data[cursor + 1];
 
-						decodeBlock(scanComponent, Huffman);
+		if (!markerByte) {
 
-						if (baseX + 8 > component.width) {
-							applyPartialIDCT(scanComponent, baseY * component.width + baseX, component.width - baseX, 8);
-						} else {
-							applyIDCT(scanComponent, baseY * component.width + baseX);
-						}
+			//Escaped 0xFF
+			cursor += 2;
+			continue;
 
-					}
+		}
 
-				}
+		restartSegments.emplace_back(data.subspan(segmentStart, cursor - segmentStart));
 
-			}
+		if (markerByte < (Markers::RST0 & 0xFF) || markerByte > (Markers::RST7 & 0xFF)) {
 
-		};
+			//Any other marker terminates the scan. DNL is consumed like the entropy decoder does.
+			scanEnd = markerByte == (Markers::DNL & 0xFF) ? cursor + 2 : cursor;
+			break;
 
-		auto progressiveDecode = [&](ScanComponent& component) {};
+		}
 
-		auto losslessDecode = [&, this](ScanComponent& scanComponent) {
+		cursor += 2;
+		segmentStart = cursor;
 
-			FrameComponent& component = scanComponent.frameComponent;
+	}
 
-			SizeT mcuBaseX = mcuX * component.samplesX;
-			SizeT mcuBaseY = mcuY * component.samplesY;
+	return restartSegments.size() == (scan.totalMCUs + restartInterval - 1) / restartInterval;
 
-			u32 predictor = scan.predictor;
+}
 
-			for (u32 sy = 0; sy < component.samplesY; sy++) {
 
-				u32 y = mcuBaseY + sy;
 
-				if (y == 0) {
-					predictor = 1;
-				}
+void JPEGDecoder::skipToRestartMarker() {
 
-				for (u32 sx = 0; sx < component.samplesX; sx++) {
+	EntropyDecoder& decoder = frame.encoding == Encoding::Huffman ? static_cast<EntropyDecoder&>(huffmanDecoder) : arithmeticDecoder;
 
-					u32 x = mcuBaseX + sx;
+	//The decoder consumes the marker only if it had to prefetch beyond the last MCU, so skip remaining padding bytes
+	if (decoder.end) {
+		return;
+	}
 
-					if (x == 0) {
-						predictor = y ? 2 : 0;
-					}
+	while (reader.remainingSize() >= 2) {
 
-					predictSample(scanComponent, x, y, predictor);
+		if (reader.peek<u8>() != 0xFF) {
 
-				}
+			reader.seek(1);
+			continue;
 
-			}
+		}
 
-		};
+		u16 marker = reader.peek<u16>();
 
-		for (u32 currentMCU = startMCU; currentMCU < endMCU; currentMCU++, mcuX++) {
+		if (Math::inRange(marker, Markers::RST0, Markers::RST7)) {
 
-			if (mcuX >= scan.mcusX) {
+			reader.seek(2);
+			return;
 
-				mcuX = 0;
-				mcuY++;
+		} else if (marker == 0xFF00) {
 
-			}
+			reader.seek(2);
 
-			for (u32 i = 0; Interleave ? i < scan.scanComponents.size() : i < 1; i++) {
+		} else {
 
-				ScanComponent& component = scan.scanComponents[i];
+			//Leave unknown markers to the next interval
+			return;
 
-				if constexpr (Type == FrameType::Sequential || Type == FrameType::ExtendedSequential) {
-					sequentialDecode(component);
-				} else if constexpr (Type == FrameType::Progressive) {
-					progressiveDecode(component);
-				} else {
-					losslessDecode(component);
-				}
+		}
 
-			}
+	}
 
-		}
+	decoder.exhausted = true;
 
-	};
+}
 
 
-	//Reset encoders
-	if (frame.encoding == Encoding::Huffman) {
 
-		huffmanDecoder.reset();
+void JPEGDecoder::decodeImage(u32 startMCU, u32 endMCU) {
+	decodeImage(startMCU, endMCU, huffmanDecoder, scan.scanComponents);
+}
 
-	} else {
 
-		arithmeticDecoder.reset();
-		arithmeticDecoder.prefetch();
 
-		for (ScanComponent& component : scan.scanComponents) {
+void JPEGDecoder::decodeImage(u32 startMCU, u32 endMCU, HuffmanDecoder& decoder, std::span<ScanComponent> components, bool restart) {
 
-			component.dcConditioning.bins.fill({});
-			component.acConditioning.bins.fill({});
+	auto decodeBlock = [&, this](ScanComponent& scanComponent, bool Huffman) constexpr {
 
+		if (Huffman) {
+			decodeHuffmanBlock(scanComponent, decoder);
+		} else {
+			decodeArithmeticBlock(scanComponent);
 		}
 
-	}
+	};
 
+	auto doDecode = [&, this]<FrameType Type, bool Huffman, bool Interleave>() {
 
-	if (frame.type == FrameType::Sequential || frame.type == FrameType::ExtendedSequential) {
+		SizeT mcuX = startMCU % scan.mcusX;
+		SizeT mcuY = startMCU / scan.mcusX;
 
-		alignas(32) i32 block[64];
+		//Non-interleaved MCUs consist of a single data unit
+		auto mcuSamplesX = [](const FrameComponent& component) constexpr { return Interleave ? component.samplesX : 1; };
+		auto mcuSamplesY = [](const FrameComponent& component) constexpr { return Interleave ? component.samplesY : 1; };
 
-		//Reset prediction and block buffer
-		for (ScanComponent& component : scan.scanComponents) {
+		auto sequentialDecode = [&](ScanComponent& scanComponent) {
+
+			FrameComponent& component = scanComponent.frameComponent;
+
+			u32 samplesX = mcuSamplesX(component);
+			u32 samplesY = mcuSamplesY(component);
+			u32 blockSize = frame.blockSize;
+
+			SizeT mcuBaseX = mcuX * samplesX * blockSize;
+			SizeT mcuBaseY = mcuY * samplesY * blockSize;
+
+			for (u32 sy = 0; sy < samplesY; sy++) {
+
+				SizeT baseY = mcuBaseY + sy * blockSize;
+
+				if (baseY + blockSize > component.height) {
+
+					SizeT h = baseY < component.height ? component.height - baseY : 0;
+
+					for (u32 sx = 0; sx < samplesX; sx++) {
+
+						SizeT baseX = mcuBaseX + sx * blockSize;
+						SizeT w = blockSize;
+
+						if (baseX + blockSize > component.width) {
+							w = baseX < component.width ? component.width - baseX : 0;
+						}
+
+						decodeBlock(scanComponent, Huffman);
+
+						//Padding blocks of interleaved MCUs lie entirely outside of the component
+						if (w && h) {
+							transformBlock(scanComponent, (baseY - component.windowY) * component.width + baseX, w, h);
+						}
+
+					}
+
+				} else {
+
+					for (u32 sx = 0; sx < samplesX; sx++) {
+
+						SizeT baseX = mcuBaseX + sx * blockSize;
+
+						decodeBlock(scanComponent, Huffman);
+
+						SizeT imageBase = (baseY - component.windowY) * component.width + baseX;
+
+						if (baseX >= component.width) {
+							continue;
+						} else if (baseX + blockSize > component.width) {
+							transformBlock(scanComponent, imageBase, component.width - baseX, blockSize);
+						} else if (blockSize == 8) {
+							applyIDCT(scanComponent, imageBase);
+						} else {
+							applyReducedIDCT(scanComponent, imageBase, blockSize, blockSize, blockSize);
+						}
+
+					}
+
+				}
+
+			}
+
+		};
+
+		auto progressiveDecode = [&](ScanComponent& scanComponent) {
+
+			FrameComponent& component = scanComponent.frameComponent;
+
+			u32 samplesX = mcuSamplesX(component);
+			u32 samplesY = mcuSamplesY(component);
+
+			for (u32 sy = 0; sy < samplesY; sy++) {
+
+				SizeT blockBase = ((mcuY * samplesY + sy) * component.blocksX + mcuX * samplesX) * 64;
+
+				for (u32 sx = 0; sx < samplesX; sx++) {
+
+					i16* coefficients = component.progressiveBuffer.data() + blockBase + sx * 64;
+
+					if (scan.spectralStart == 0) {
+
+						if (scan.approximationHigh == 0) {
+							decodeProgressiveDCFirst(scanComponent, decoder, coefficients);
+						} else {
+							decodeProgressiveDCRefinement(decoder, coefficients);
+						}
+
+					} else {
+
+						if (scan.approximationHigh == 0) {
+							decodeProgressiveACFirst(scanComponent, decoder, coefficients);
+						} else {
+							decodeProgressiveACRefinement(scanComponent, decoder, coefficients);
+						}
+
+					}
+
+				}
+
+			}
+
+		};
+
+		auto losslessDecode = [&, this](ScanComponent& scanComponent) {
+
+			FrameComponent& component = scanComponent.frameComponent;
+
+			u32 samplesX = mcuSamplesX(component);
+			u32 samplesY = mcuSamplesY(component);
+
+			SizeT mcuBaseX = mcuX * samplesX;
+			SizeT mcuBaseY = mcuY * samplesY;
+
+			u32 predictor = scan.predictor;
+
+			for (u32 sy = 0; sy < samplesY; sy++) {
+
+				u32 y = mcuBaseY + sy;
+
+				if (y == 0) {
+					predictor = 1;
+				}
+
+				for (u32 sx = 0; sx < samplesX; sx++) {
+
+					u32 x = mcuBaseX + sx;
+
+					if (x == 0) {
+						predictor = y ? 2 : 0;
+					}
+
+					predictSample(scanComponent, decoder, x, y, predictor);
+
+				}
+
+			}
+
+		};
+
+		for (u32 currentMCU = startMCU; currentMCU < endMCU; currentMCU++, mcuX++) {
+
+			if (mcuX >= scan.mcusX) {
+
+				mcuX = 0;
+				mcuY++;
+
+			}
+
+			for (u32 i = 0; Interleave ? i < components.size() : i < 1; i++) {
+
+				ScanComponent& component = components[i];
+
+				if constexpr (Type == FrameType::Sequential || Type == FrameType::ExtendedSequential) {
+					sequentialDecode(component);
+				} else if constexpr (Type == FrameType::Progressive) {
+					progressiveDecode(component);
+				} else {
+					losslessDecode(component);
+				}
+
+			}
+
+		}
+
+	};
+
+
+	//Reset encoders unless an interrupted interval is resumed
+	if (restart && frame.encoding == Encoding::Huffman) {
+
+		decoder.reset();
+
+	} else if (restart) {
+
+		arithmeticDecoder.reset();
+		arithmeticDecoder.prefetch();
+
+		for (ScanComponent& component : components) {
+
+			component.dcConditioning.bins.fill({});
+			component.acConditioning.bins.fill({});
+
+		}
+
+	}
+
+
+	if (frame.type == FrameType::Sequential || frame.type == FrameType::ExtendedSequential) {
+
+		alignas(32) i32 block[64];
+
+		//Reset prediction and block buffer
+		for (ScanComponent& component : components) {
+
+			if (restart) {
+
+				component.prediction = 0;
+				component.prevDifference = 0;
+
+			}
 
-			component.prediction = 0;
-			component.prevDifference = 0;
 			component.block = block;
 
 		}
 
 		if (frame.encoding == Encoding::Huffman) {
 
-			if (scan.scanComponents.size() > 1) {
+			if (components.size() > 1) {
 				doDecode.template operator()<FrameType::Sequential, true, true>();
 			} else {
 				doDecode.template operator()<FrameType::Sequential, true, false>();
@@ -1358,7 +1728,7 @@ void JPEGDecoder::decodeImage(u32 startMCU, u32 endMCU) {
 
 		} else {
 
-			if (scan.scanComponents.size() > 1) {
+			if (components.size() > 1) {
 				doDecode.template operator()<FrameType::Sequential, false, true>();
 			} else {
 				doDecode.template operator()<FrameType::Sequential, false, false>();
@@ -1368,24 +1738,18 @@ void JPEGDecoder::decodeImage(u32 startMCU, u32 endMCU) {
 
 	} else if (frame.type == FrameType::Progressive) {
 
-		bool dcProgression = scan.spectralStart == 0;
-
 		//Reset prediction
-		for (ScanComponent& component : scan.scanComponents) {
+		for (ScanComponent& component : components) {
 
-			FrameComponent& frameComponent = component.frameComponent;
-
-			if (dcProgression && frameComponent.progression != 0) {
-				throw ImageDecoderException("DC progression after AC progression");
+			if (restart) {
+				component.prediction = 0;
 			}
 
-			component.prediction = 0;
-
 		}
 
 		if (frame.encoding == Encoding::Huffman) {
 
-			if (scan.scanComponents.size() > 1) {
+			if (components.size() > 1) {
 				doDecode.template operator()<FrameType::Progressive, true, true>();
 			} else {
 				doDecode.template operator()<FrameType::Progressive, true, false>();
@@ -1393,7 +1757,7 @@ void JPEGDecoder::decodeImage(u32 startMCU, u32 endMCU) {
 
 		} else {
 
-			if (scan.scanComponents.size() > 1) {
+			if (components.size() > 1) {
 				doDecode.template operator()<FrameType::Progressive, false, true>();
 			} else {
 				doDecode.template operator()<FrameType::Progressive, false, false>();
@@ -1405,7 +1769,7 @@ void JPEGDecoder::decodeImage(u32 startMCU, u32 endMCU) {
 
 		if (frame.encoding == Encoding::Huffman) {
 
-			if (scan.scanComponents.size() > 1) {
+			if (components.size() > 1) {
 				doDecode.template operator()<FrameType::Lossless, true, true>();
 			} else {
 				doDecode.template operator()<FrameType::Lossless, true, false>();
@@ -1413,7 +1777,7 @@ void JPEGDecoder::decodeImage(u32 startMCU, u32 endMCU) {
 
 		} else {
 
-			if (scan.scanComponents.size() > 1) {
+			if (components.size() > 1) {
 				doDecode.template operator()<FrameType::Lossless, false, true>();
 			} else {
 				doDecode.template operator()<FrameType::Lossless, false, false>();
@@ -1427,13 +1791,13 @@ void JPEGDecoder::decodeImage(u32 startMCU, u32 endMCU) {
 
 
 
-void JPEGDecoder::decodeHuffmanBlock(JPEG::ScanComponent& component) {
+void JPEGDecoder::decodeHuffmanBlock(JPEG::ScanComponent& component, HuffmanDecoder& decoder) {
 
 	i32* block = clearBlockBuffer(component);
 
 	//DC
 	{
-		HuffmanResult result = huffmanDecoder.decodeDC(component.dcTable);
+		HuffmanResult result = decoder.decodeDC(component.dcTable);
 
 		u32 category = result.first;
 		i32 difference = 0;
@@ -1441,7 +1805,7 @@ void JPEGDecoder::decodeHuffmanBlock(JPEG::ScanComponent& component) {
 
 		if (category) {
 
-			offset = huffmanDecoder.decodeOffset(category);
+			offset = decoder.decodeOffset(category);
 			difference = offset >= entropyPositiveBase[category] ? static_cast<i32>(offset) : coeffBaseDifference[category] + static_cast<i32>(offset);
 
 		}
@@ -1456,7 +1820,7 @@ void JPEGDecoder::decodeHuffmanBlock(JPEG::ScanComponent& component) {
 
 	while (coefficient < 64) {
 
-		HuffmanResult result = huffmanDecoder.decodeAC(component.acTable);
+		HuffmanResult result = decoder.decodeAC(component.acTable);
 
 		u8 symbol = result.first;
 		u8 category = symbol & 0xF;
@@ -1485,7 +1849,7 @@ void JPEGDecoder::decodeHuffmanBlock(JPEG::ScanComponent& component) {
 		} else {
 
 			//Extract the AC magnitude
-			u32 offset = huffmanDecoder.decodeOffset(category);
+			u32 offset = decoder.decodeOffset(category);
 
 			coefficient += zeroes;
 
@@ -1661,165 +2025,340 @@ void JPEGDecoder::decodeArithmeticBlock(JPEG::ScanComponent& component) {
 
 
 
-void JPEGDecoder::decodeProgressiveDCBlock(JPEG::ScanComponent& component) {
+void JPEGDecoder::decodeProgressiveDCFirst(JPEG::ScanComponent& component, HuffmanDecoder& decoder, i16* coefficients) {
 
-	i32* block = std::assume_aligned<32>(component.block);
+	HuffmanResult result = decoder.decodeDC(component.dcTable);
 
-}
+	u32 category = result.first;
+	i32 difference = 0;
 
+	if (category) {
 
+		u32 offset = decoder.decodeOffset(category);
+		difference = offset >= entropyPositiveBase[category] ? static_cast<i32>(offset) : coeffBaseDifference[category] + static_cast<i32>(offset);
 
-void JPEGDecoder::predictSample(JPEG::ScanComponent& component, u32 x, u32 y, u32 predictor) {
+	}
 
-	i32 prediction = calculatePrediction(component, x, y, predictor);
+	component.prediction += difference;
+	coefficients[0] = static_cast<i16>(component.prediction * (1 << scan.approximationLow));
 
-	HuffmanResult result = huffmanDecoder.decodeDC(component.dcTable);
+}
 
-	u32 category = result.first;
-	i32 difference = 0;
 
-	if (category) {
 
-		if (category < 16) {
+void JPEGDecoder::decodeProgressiveDCRefinement(HuffmanDecoder& decoder, i16* coefficients) {
 
-			u32 offset = huffmanDecoder.decodeOffset(category);
-			difference = offset >= entropyPositiveBase[category] ? static_cast<i32>(offset) : coeffBaseDifference[category] + static_cast<i32>(offset);
+	if (decoder.decodeOffset(1)) {
+		coefficients[0] |= 1 << scan.approximationLow;
+	}
 
-		} else {
+}
 
-			difference = 32768;
 
-		}
+
+void JPEGDecoder::decodeProgressiveACFirst(JPEG::ScanComponent& component, HuffmanDecoder& decoder, i16* coefficients) {
+
+	//Inside an end-of-band run, the whole band stays zero
+	if (decoder.eobRun) {
+
+		decoder.eobRun--;
+		return;
 
 	}
 
-	component.frameComponent.imageData[y * component.frameComponent.width + x] = static_cast<i16>((prediction + difference) << scan.pointTransform);
+	for (u32 coefficient = scan.spectralStart; coefficient <= scan.spectralEnd; coefficient++) {
 
-}
+		HuffmanResult result = decoder.decodeAC(component.acTable);
 
+		u8 symbol = result.first;
+		u8 category = symbol & 0xF;
+		u8 zeroes = symbol >> 4;
 
+		if (category == 0) {
 
-i32 JPEGDecoder::calculatePrediction(JPEG::ScanComponent& component, u32 x, u32 y, u32 predictor) {
+			if (zeroes == 0xF) {
 
-	i32 prediction = 0;
+				//Zero Run Length
+				coefficient += 15;
+				continue;
 
-	switch (predictor) {
+			}
 
-		case 0:
-		default:
-			prediction = 1 << (frame.bits - scan.pointTransform - 1);
-			break;
+			//End Of Band run of 2^zeroes + offset bands including this one
+			decoder.eobRun = (1 << zeroes) - 1;
 
-		case 1:
-			prediction = sampleComponent(component, x - 1, y);
-			break;
+			if (zeroes) {
+				decoder.eobRun += decoder.decodeOffset(zeroes);
+			}
 
-		case 2:
-			prediction = sampleComponent(component, x, y - 1);
 			break;
 
-		case 3:
-			prediction = sampleComponent(component, x - 1, y - 1);
-			break;
+		}
 
-		case 4:
-			prediction = calculatePrediction(component, x, y, 1) + calculatePrediction(component, x, y, 2) - calculatePrediction(component, x, y, 3);
-			break;
+		coefficient += zeroes;
 
-		case 5:
-			prediction = calculatePrediction(component, x, y, 1) + ((calculatePrediction(component, x, y, 2) - calculatePrediction(component, x, y, 3)) >> 1);
-			break;
+		if (coefficient > scan.spectralEnd) {
 
-		case 6:
-			prediction = calculatePrediction(component, x, y, 2) + ((calculatePrediction(component, x, y, 1) - calculatePrediction(component, x, y, 3)) >> 1);
+			LogW("JPEG Decoder") << "AC symbol overflow, stream corrupted";
 			break;
 
-		case 7:
-			prediction = ((calculatePrediction(component, x, y, 1) + calculatePrediction(component, x, y, 2)) >> 1);
-			break;
+		}
 
-	}
+		u32 offset = decoder.decodeOffset(category);
+		i32 ac = offset >= entropyPositiveBase[category] ? static_cast<i32>(offset) : coeffBaseDifference[category] + static_cast<i32>(offset);
 
-	return prediction;
+		coefficients[dezigzagTableTransposed[coefficient]] = static_cast<i16>(ac * (1 << scan.approximationLow));
+
+	}
 
 }
 
 
 
-i16 JPEGDecoder::sampleComponent(JPEG::ScanComponent& component, u32 x, u32 y) {
-	return component.frameComponent.imageData[y * component.frameComponent.width + x];
-}
+void JPEGDecoder::decodeProgressiveACRefinement(JPEG::ScanComponent& component, HuffmanDecoder& decoder, i16* coefficients) {
 
+	i32 positiveBit = 1 << scan.approximationLow;
+	i32 negativeBit = -positiveBit;
 
+	//Nonzero coefficients receive a correction bit whenever they are passed
+	auto refine = [&](i16& value) {
 
-ARC_FORCE_INLINE i32* JPEGDecoder::clearBlockBuffer(JPEG::ScanComponent& component) {
+		if (decoder.decodeOffset(1) && !(value & positiveBit)) {
+			value += value >= 0 ? positiveBit : negativeBit;
+		}
 
-	i32* block = std::assume_aligned<32>(component.block);
+	};
 
-	//This really shouldn't be necessary, but MSVC fails to vectorize std::fill_n
-#ifdef ARC_VECTORIZE_X86_AVX2
+	u32 coefficient = scan.spectralStart;
 
-	__m256i* ptr = reinterpret_cast<__m256i*>(block);
+	if (!decoder.eobRun) {
 
-	for (u32 i = 0; i < 8; i++) {
-		_mm256_store_si256(ptr++, _mm256_setzero_si256());
-	}
+		for (; coefficient <= scan.spectralEnd; coefficient++) {
 
-#elif defined(ARC_VECTORIZE_X86_SSE2)
+			HuffmanResult result = decoder.decodeAC(component.acTable);
 
-	__m128i* ptr = reinterpret_cast<__m128i*>(block);
+			u8 symbol = result.first;
+			u8 category = symbol & 0xF;
+			i32 zeroes = symbol >> 4;
+			i32 value = 0;
 
-	for (u32 i = 0; i < 16; i++) {
-		_mm_store_si128(ptr++, _mm_setzero_si128());
-	}
+			if (category) {
 
-#else
+				if (category != 1) {
+					LogW("JPEG Decoder") << "Bad AC refinement symbol, stream corrupted";
+				}
 
-	std::fill_n(block, 64, 0);
+				value = decoder.decodeOffset(1) ? positiveBit : negativeBit;
 
-#endif
+			} else if (zeroes != 0xF) {
 
-	return block;
+				//End Of Band run, the remainder of this band is refined below
+				decoder.eobRun = 1 << zeroes;
 
-}
+				if (zeroes) {
+					decoder.eobRun += decoder.decodeOffset(zeroes);
+				}
 
+				break;
 
+			}
 
-template<bool Full>
-constexpr static void scalarIDCT(const i32* inData, i16* outData, SizeT outStride, u32 width, u32 height) {
+			//Skip zeroes zero-valued coefficients while refining nonzero ones on the way
+			for (; coefficient <= scan.spectralEnd; coefficient++) {
 
-	i32 buffer[64];
-	SizeT sizeX = Full ? 8 : width;
-	SizeT sizeY = Full ? 8 : height;
+				i16& current = coefficients[dezigzagTableTransposed[coefficient]];
 
-	//First pass
-	for (u32 i = 0; i < 8; i++) {
+				if (current) {
 
-		u32 k = i * 8;
+					refine(current);
 
-		//Stage 1: Pre-multiplication stage
-		i32 a0 = inData[k + 0] + inData[k + 4];
-		i32 a1 = inData[k + 0] - inData[k + 4];
-		i32 a2 = inData[k + 2] - inData[k + 6];
-		i32 a3 = inData[k + 2] + inData[k + 6];
-		i32 a4 = inData[k + 1] + inData[k + 7];
-		i32 a5 = inData[k + 1] - inData[k + 7];
-		i32 a6 = inData[k + 5] - inData[k + 3];
-		i32 a7 = inData[k + 5] + inData[k + 3];
-		i32 a8 = a6 - a4;
-		i32 a9 = a6 + a4;
+				} else {
 
-		//Stage 2: Multiplication
-		i32 b0 = (a3 * multiplyConstants[0]) >> fixMultiplyShift;
-		i32 b1 = (a8 * multiplyConstants[0]) >> fixMultiplyShift;
-		i32 b2 = (a7 * multiplyConstants[1]) >> fixMultiplyShift;
-		i32 b3 = (a5 * multiplyConstants[1]) >> fixMultiplyShift;
-		i32 b4 = (a7 * multiplyConstants[2]) >> fixMultiplyShift;
-		i32 b5 = (a5 * multiplyConstants[2]) >> fixMultiplyShift;
-		i32 b6 = b5 - b2;
-		i32 b7 = b3 + b4;
+					if (--zeroes < 0) {
+						break;
+					}
 
-		//Stage 3: Post-merge
+				}
+
+			}
+
+			if (value && coefficient <= scan.spectralEnd) {
+				coefficients[dezigzagTableTransposed[coefficient]] = static_cast<i16>(value);
+			}
+
+		}
+
+	}
+
+	if (decoder.eobRun) {
+
+		for (; coefficient <= scan.spectralEnd; coefficient++) {
+
+			i16& current = coefficients[dezigzagTableTransposed[coefficient]];
+
+			if (current) {
+				refine(current);
+			}
+
+		}
+
+		decoder.eobRun--;
+
+	}
+
+}
+
+
+
+void JPEGDecoder::predictSample(JPEG::ScanComponent& component, HuffmanDecoder& decoder, u32 x, u32 y, u32 predictor) {
+
+	i32 prediction = calculatePrediction(component, x, y, predictor);
+
+	HuffmanResult result = decoder.decodeDC(component.dcTable);
+
+	u32 category = result.first;
+	i32 difference = 0;
+
+	if (category) {
+
+		if (category < 16) {
+
+			u32 offset = decoder.decodeOffset(category);
+			difference = offset >= entropyPositiveBase[category] ? static_cast<i32>(offset) : coeffBaseDifference[category] + static_cast<i32>(offset);
+
+		} else {
+
+			difference = 32768;
+
+		}
+
+	}
+
+	component.frameComponent.imageData[y * component.frameComponent.width + x] = static_cast<i16>((prediction + difference) << scan.pointTransform);
+
+}
+
+
+
+i32 JPEGDecoder::calculatePrediction(JPEG::ScanComponent& component, u32 x, u32 y, u32 predictor) {
+
+	i32 prediction = 0;
+
+	switch (predictor) {
+
+		case 0:
+		default:
+			prediction = 1 << (frame.bits - scan.pointTransform - 1);
+			break;
+
+		case 1:
+			prediction = sampleComponent(component, x - 1, y);
+			break;
+
+		case 2:
+			prediction = sampleComponent(component, x, y - 1);
+			break;
+
+		case 3:
+			prediction = sampleComponent(component, x - 1, y - 1);
+			break;
+
+		case 4:
+			prediction = calculatePrediction(component, x, y, 1) + calculatePrediction(component, x, y, 2) - calculatePrediction(component, x, y, 3);
+			break;
+
+		case 5:
+			prediction = calculatePrediction(component, x, y, 1) + ((calculatePrediction(component, x, y, 2) - calculatePrediction(component, x, y, 3)) >> 1);
+			break;
+
+		case 6:
+			prediction = calculatePrediction(component, x, y, 2) + ((calculatePrediction(component, x, y, 1) - calculatePrediction(component, x, y, 3)) >> 1);
+			break;
+
+		case 7:
+			prediction = ((calculatePrediction(component, x, y, 1) + calculatePrediction(component, x, y, 2)) >> 1);
+			break;
+
+	}
+
+	return prediction;
+
+}
+
+
+
+i16 JPEGDecoder::sampleComponent(JPEG::ScanComponent& component, u32 x, u32 y) {
+	return component.frameComponent.imageData[y * component.frameComponent.width + x];
+}
+
+
+
+ARC_FORCE_INLINE i32* JPEGDecoder::clearBlockBuffer(JPEG::ScanComponent& component) {
+
+	i32* block = std::assume_aligned<32>(component.block);
+
+	//This really shouldn't be necessary, but MSVC fails to vectorize std::fill_n
+#ifdef ARC_VECTORIZE_X86_AVX2
+
+	__m256i* ptr = reinterpret_cast<__m256i*>(block);
+
+	for (u32 i = 0; i < 8; i++) {
+		_mm256_store_si256(ptr++, _mm256_setzero_si256());
+	}
+
+#elif defined(ARC_VECTORIZE_X86_SSE2)
+
+	__m128i* ptr = reinterpret_cast<__m128i*>(block);
+
+	for (u32 i = 0; i < 16; i++) {
+		_mm_store_si128(ptr++, _mm_setzero_si128());
+	}
+
+#else
+
+	std::fill_n(block, 64, 0);
+
+#endif
+
+	return block;
+
+}
+
+
+
+template<bool Full>
+constexpr static void scalarIDCT(const i32* inData, i16* outData, SizeT outStride, u32 width, u32 height) {
+
+	i32 buffer[64];
+	SizeT sizeX = Full ? 8 : width;
+	SizeT sizeY = Full ? 8 : height;
+
+	//First pass: Columns, matching the operation order of the vectorized versions
+	for (u32 i = 0; i < 8; i++) {
+
+		//Stage 1: Pre-multiplication stage
+		i32 a0 = inData[8 * 0 + i] + inData[8 * 4 + i];
+		i32 a1 = inData[8 * 0 + i] - inData[8 * 4 + i];
+		i32 a2 = inData[8 * 2 + i] - inData[8 * 6 + i];
+		i32 a3 = inData[8 * 2 + i] + inData[8 * 6 + i];
+		i32 a4 = inData[8 * 1 + i] + inData[8 * 7 + i];
+		i32 a5 = inData[8 * 1 + i] - inData[8 * 7 + i];
+		i32 a6 = inData[8 * 5 + i] - inData[8 * 3 + i];
+		i32 a7 = inData[8 * 5 + i] + inData[8 * 3 + i];
+		i32 a8 = a6 - a4;
+		i32 a9 = a6 + a4;
+
+		//Stage 2: Multiplication
+		i32 b0 = (a3 * multiplyConstants[0]) >> fixMultiplyShift;
+		i32 b1 = (a8 * multiplyConstants[0]) >> fixMultiplyShift;
+		i32 b2 = (a7 * multiplyConstants[1]) >> fixMultiplyShift;
+		i32 b3 = (a5 * multiplyConstants[1]) >> fixMultiplyShift;
+		i32 b4 = (a7 * multiplyConstants[2]) >> fixMultiplyShift;
+		i32 b5 = (a5 * multiplyConstants[2]) >> fixMultiplyShift;
+		i32 b6 = b5 - b2;
+		i32 b7 = b3 + b4;
+
+		//Stage 3: Post-merge
 		i32 bc = a2 - b0;
 		i32 c0 = a0 + b0;
 		i32 c1 = a1 + bc;
@@ -1844,8 +2383,8 @@ constexpr static void scalarIDCT(const i32* inData, i16* outData, SizeT outStrid
 
 	i32 tmp[8];
 
-	//Second pass
-	for (u32 i = 0; i < sizeY; i++) {
+	//Second pass: Rows, every row of the buffer yields one output column
+	for (u32 i = 0; i < sizeX; i++) {
 
 		u32 k = i * 8;
 
@@ -1892,8 +2431,9 @@ constexpr static void scalarIDCT(const i32* inData, i16* outData, SizeT outStrid
 		tmp[6] = c1 - c6;
 		tmp[7] = c0 - c7;
 
-		for (u32 j = 0; j < sizeX; j++) {
-			outData[outStride * i + j] = static_cast<i16>((tmp[j] >> (fixScaleShift - fixTransformShift)) + (128 << fixTransformShift));
+		//Saturate since overshooting samples would wrap around and turn bright pixels black
+		for (u32 j = 0; j < sizeY; j++) {
+			outData[outStride * j + i] = static_cast<i16>(Math::clamp((tmp[j] >> (fixScaleShift - fixTransformShift)) + (128 << fixTransformShift), -32768, 32767));
 		}
 
 	}
@@ -1902,186 +2442,141 @@ constexpr static void scalarIDCT(const i32* inData, i16* outData, SizeT outStrid
 
 
 
-void JPEGDecoder::applyIDCT(JPEG::ScanComponent& component, SizeT imageBase) {
+/*
+	Weights of the reduced IDCTs, indexed by [frequency][sample].
+	Every output sample is the mean of the 8 / Size samples of the 8-point IDCT it covers, which makes the reduced IDCT a box filter
+	in the DCT domain. Odd high frequencies alias into the result just as they would when averaging the full-size block.
+	The weights also undo the AAN prescale that is folded into the quantization tables.
+*/
+constexpr static u32 fixReducedShift = 13;
+
+template<u32 Size>
+constexpr static std::array<std::array<i32, Size>, 8> reducedWeights = []() {
+
+	constexpr long double prescale[8] = {
+		0.3535533905932737622004221810524245196424179688442370182941699344L,
+		0.4499881115682078523192547704709441977690008637064224926177235580L,
+		0.6532814824381882639283215867135935767918805941746347637744491834L,
+		0.2548977895520795844709699019939219568413092459544676848632214685L,
+		0.3535533905932737622004221810524245196424179688442370182941699344L,
+		1.2814577238707530893980431480888499545075616756936724560638481482L,
+		0.2705980500730984921998616026831947100305360316890077223406485478L,
+		0.3006724434675226402718609119546109175336279448003363610609320596L
+	};
 
-	const i32* inData = component.block;            //Aligned to 32 bytes
-	i16* outData = &component.frameComponent.imageData[imageBase];
+	//cos(k * pi / 16) for k = 0 to 15
+	constexpr long double cosines[16] = {
+		 1.0000000000000000000000000000000000000000000000000000000000000000L,
+		 0.9807852804032304491261822361342390369739337308933360950029160885L,
+		 0.9238795325112867561281831893967882868224166258636424861150977312L,
+		 0.8314696123025452370787883776179057567385608119872499634461245902L,
+		 0.7071067811865475244008443621048490392848359376884740365883398689L,
+		 0.5555702330196022247428308139485328743749371907548040459241535282L,
+		 0.3826834323650897717284599840303988667613445624856270414338006356L,
+		 0.1950903220161282678482848684770222409276916177519548077545020894L,
+		 0.0L,
+		-0.1950903220161282678482848684770222409276916177519548077545020894L,
+		-0.3826834323650897717284599840303988667613445624856270414338006356L,
+		-0.5555702330196022247428308139485328743749371907548040459241535282L,
+		-0.7071067811865475244008443621048490392848359376884740365883398689L,
+		-0.8314696123025452370787883776179057567385608119872499634461245902L,
+		-0.9238795325112867561281831893967882868224166258636424861150977312L,
+		-0.9807852804032304491261822361342390369739337308933360950029160885L
+	};
 
-#ifdef ARC_VECTORIZE_X86_AVX2
+	constexpr u32 span = 8 / Size;
 
-	const __m256i* inVec = reinterpret_cast<const __m256i*>(inData);
+	std::array<std::array<i32, Size>, 8> a {};
 
-	__m256i bufVec[8];
+	for (u32 u = 0; u < 8; u++) {
 
-	__m256i m0 = _mm256_set1_epi32(multiplyConstants[0]);
-	__m256i m1 = _mm256_set1_epi32(multiplyConstants[1]);
-	__m256i m2 = _mm256_set1_epi32(multiplyConstants[2]);
-	__m256i m3 = _mm256_set1_epi32(128 << fixTransformShift);
-	__m256i m4 = _mm256_setr_epi64x(1LL << 63, 1LL << 63, 0, 0);
-	__m256i m5 = _mm256_setr_epi64x(0, 0, 1LL << 63, 1LL << 63);
+		for (u32 x = 0; x < Size; x++) {
 
-	__int64* outVec[8];
+			long double c = 0;
+
+			//cos((2i + 1) * u * pi / 16), reduced into [0, 2pi) using cos(pi + t) = -cos(t)
+			for (u32 i = x * span; i < (x + 1) * span; i++) {
+
+				u32 k = ((2 * i + 1) * u) % 32;
+				c += k < 16 ? cosines[k] : -cosines[k - 16];
+
+			}
+
+			long double n = u ? 0.5L : 0.3535533905932737622004221810524245196424179688442370182941699344L;
+			long double w = n * c / span / prescale[u] * (1 << fixReducedShift);
+
+			a[u][x] = i32(w + (w < 0 ? -0.5L : 0.5L));
+
+		}
 
-	for (u32 i = 0; i < 8; i++) {
-		outVec[i] = reinterpret_cast<__int64*>(outData + component.frameComponent.width * i - (i & 1) * 8);
 	}
 
-	/*
-	 *  This algorithm is based on the scalar version, unrolled 8 times
-	 */
-	{
-		__m256i in0 = _mm256_load_si256(inVec + 0);
-		__m256i in1 = _mm256_load_si256(inVec + 1);
-		__m256i in2 = _mm256_load_si256(inVec + 2);
-		__m256i in3 = _mm256_load_si256(inVec + 3);
-		__m256i in4 = _mm256_load_si256(inVec + 4);
-		__m256i in5 = _mm256_load_si256(inVec + 5);
-		__m256i in6 = _mm256_load_si256(inVec + 6);
-		__m256i in7 = _mm256_load_si256(inVec + 7);
+	return a;
 
-		__m256i a0 = _mm256_add_epi32(in0, in4);
-		__m256i a1 = _mm256_sub_epi32(in0, in4);
-		__m256i a2 = _mm256_sub_epi32(in2, in6);
-		__m256i a3 = _mm256_add_epi32(in2, in6);
-		__m256i a4 = _mm256_add_epi32(in1, in7);
-		__m256i a5 = _mm256_sub_epi32(in1, in7);
-		__m256i a6 = _mm256_sub_epi32(in5, in3);
-		__m256i a7 = _mm256_add_epi32(in5, in3);
-		__m256i a8 = _mm256_sub_epi32(a6, a4);
-		__m256i a9 = _mm256_add_epi32(a6, a4);
+}();
 
-		__m256i b0 = _mm256_srai_epi32(_mm256_mullo_epi32(a3, m0), fixMultiplyShift);
-		__m256i b1 = _mm256_srai_epi32(_mm256_mullo_epi32(a8, m0), fixMultiplyShift);
-		__m256i b2 = _mm256_srai_epi32(_mm256_mullo_epi32(a7, m1), fixMultiplyShift);
-		__m256i b3 = _mm256_srai_epi32(_mm256_mullo_epi32(a5, m1), fixMultiplyShift);
-		__m256i b4 = _mm256_srai_epi32(_mm256_mullo_epi32(a7, m2), fixMultiplyShift);
-		__m256i b5 = _mm256_srai_epi32(_mm256_mullo_epi32(a5, m2), fixMultiplyShift);
-		__m256i b6 = _mm256_sub_epi32(b5, b2);
-		__m256i b7 = _mm256_add_epi32(b3, b4);
 
-		__m256i bc = _mm256_sub_epi32(a2, b0);
-		__m256i c0 = _mm256_add_epi32(a0, b0);
-		__m256i c1 = _mm256_add_epi32(a1, bc);
-		__m256i c2 = _mm256_sub_epi32(a1, bc);
-		__m256i c3 = _mm256_sub_epi32(a0, b0);
-		__m256i c4 = _mm256_add_epi32(b1, b6);
-		__m256i c5 = _mm256_sub_epi32(a9, b7);
-		__m256i c6 = b6;
-		__m256i c7 = _mm256_sub_epi32(b7, b1);
 
-		__m256i d0 = _mm256_add_epi32(c0, c7);
-		__m256i d1 = _mm256_add_epi32(c1, c6);
-		__m256i d2 = _mm256_add_epi32(c2, c5);
-		__m256i d3 = _mm256_add_epi32(c3, c4);
-		__m256i d4 = _mm256_sub_epi32(c3, c4);
-		__m256i d5 = _mm256_sub_epi32(c2, c5);
-		__m256i d6 = _mm256_sub_epi32(c1, c6);
-		__m256i d7 = _mm256_sub_epi32(c0, c7);
+//Reconstructs a Size x Size block by box filtering the 8x8 block in the DCT domain. Only the width x height upper left samples are written.
+template<u32 Size>
+static void reducedIDCT(const i32* inData, i16* outData, SizeT outStride, u32 width, u32 height) {
 
-		//8x8 flat transpose
-		__m256i e0 = _mm256_unpacklo_epi32(d0, d1);     //a0, b0, a1, b1, a4, b4, a5, b5
-		__m256i e1 = _mm256_unpacklo_epi32(d2, d3);     //c0, d0, c1, d1, c4, d4, c5, d5
-		__m256i e2 = _mm256_unpacklo_epi32(d4, d5);     //e0, f0, e1, f1, e4, f4, e5, f5
-		__m256i e3 = _mm256_unpacklo_epi32(d6, d7);     //g0, h0, g1, h1, g4, h4, g5, h5
-		__m256i e4 = _mm256_unpackhi_epi32(d0, d1);     //a2, b2, a3, b3, a6, b6, a7, b7
-		__m256i e5 = _mm256_unpackhi_epi32(d2, d3);     //c2, d2, c3, d3, c6, d6, c7, d7
-		__m256i e6 = _mm256_unpackhi_epi32(d4, d5);     //e2, f2, e3, f3, e6, f6, e7, f7
-		__m256i e7 = _mm256_unpackhi_epi32(d6, d7);     //g2, h2, g3, h3, g6, h6, g7, h7
+	constexpr i32 bias = 128 << fixTransformShift;
 
-		__m256i f0 = _mm256_shuffle_epi32(e1, 0x4E);    //c1, d1, c0, d0, c5, d5, c4, d4
-		__m256i f1 = _mm256_shuffle_epi32(e3, 0x4E);    //g1, h1, g0, h0, g5, h5, g4, h4
-		__m256i f2 = _mm256_shuffle_epi32(e5, 0x4E);    //c3, d3, c2, d2, c7, d7, c6, d6
-		__m256i f3 = _mm256_shuffle_epi32(e7, 0x4E);    //g3, h3, g2, h2, g7, h7, g6, h6
+	if constexpr (Size == 1) {
 
-		__m256i g0 = _mm256_blend_epi32(e0, f0, 0xCC);  //a0, b0, c0, d0, a4, b4, c4, d4
-		__m256i g1 = _mm256_blend_epi32(e2, f1, 0xCC);  //e0, f0, g0, h0, e4, f4, g4, h4
-		__m256i g2 = _mm256_blend_epi32(e4, f2, 0xCC);  //a2, b2, c2, d2, a6, b6, c6, d6
-		__m256i g3 = _mm256_blend_epi32(e6, f3, 0xCC);  //e2, f2, g2, h2, e6, f6, g6, h6
-		__m256i g4 = _mm256_blend_epi32(e0, f0, 0x33);  //c1, d1, a1, b1, c5, d5, a5, b5
-		__m256i g5 = _mm256_blend_epi32(e2, f1, 0x33);  //g1, h1, e1, f1, g5, h5, e5, f5
-		__m256i g6 = _mm256_blend_epi32(e4, f2, 0x33);  //c3, d3, a3, b3, c7, d7, a7, b7
-		__m256i g7 = _mm256_blend_epi32(e6, f3, 0x33);  //g3, h3, e3, f3, g7, h7, e7, f7
+		//All AC basis functions average out to zero and the weight of the DC coefficient equals the AAN prescale
+		outData[0] = static_cast<i16>(Math::clamp((inData[0] >> (fixScaleShift - fixTransformShift)) + bias, -32768, 32767));
 
-		__m256i h0 = _mm256_shuffle_epi32(g4, 0x4E);    //a1, b1, c1, d1, a5, b5, c5, d5
-		__m256i h1 = _mm256_shuffle_epi32(g5, 0x4E);    //e1, f1, g1, h1, e5, f5, g5, h5
-		__m256i h2 = _mm256_shuffle_epi32(g6, 0x4E);    //a3, b3, c3, d3, a7, b7, c7, d7
-		__m256i h3 = _mm256_shuffle_epi32(g7, 0x4E);    //e3, f3, g3, h3, e7, f7, g7, h7
+	} else {
 
-		_mm256_store_si256(bufVec + 0, _mm256_permute2x128_si256(g0, g1, 0x20));
-		_mm256_store_si256(bufVec + 1, _mm256_permute2x128_si256(h0, h1, 0x20));
-		_mm256_store_si256(bufVec + 2, _mm256_permute2x128_si256(g2, g3, 0x20));
-		_mm256_store_si256(bufVec + 3, _mm256_permute2x128_si256(h2, h3, 0x20));
-		_mm256_store_si256(bufVec + 4, _mm256_permute2x128_si256(g0, g1, 0x31));
-		_mm256_store_si256(bufVec + 5, _mm256_permute2x128_si256(h0, h1, 0x31));
-		_mm256_store_si256(bufVec + 6, _mm256_permute2x128_si256(g2, g3, 0x31));
-		_mm256_store_si256(bufVec + 7, _mm256_permute2x128_si256(h2, h3, 0x31));
-	}
+		const auto& weights = reducedWeights<Size>;
+		i64 buffer[8][Size];
 
-	{
-		__m256i in0 = _mm256_load_si256(bufVec + 0);
-		__m256i in1 = _mm256_load_si256(bufVec + 1);
-		__m256i in2 = _mm256_load_si256(bufVec + 2);
-		__m256i in3 = _mm256_load_si256(bufVec + 3);
-		__m256i in4 = _mm256_load_si256(bufVec + 4);
-		__m256i in5 = _mm256_load_si256(bufVec + 5);
-		__m256i in6 = _mm256_load_si256(bufVec + 6);
-		__m256i in7 = _mm256_load_si256(bufVec + 7);
+		//First pass: Vertical frequencies of each horizontal frequency
+		for (u32 u = 0; u < 8; u++) {
 
-		__m256i a0 = _mm256_add_epi32(in0, in4);
-		__m256i a1 = _mm256_sub_epi32(in0, in4);
-		__m256i a2 = _mm256_sub_epi32(in2, in6);
-		__m256i a3 = _mm256_add_epi32(in2, in6);
-		__m256i a4 = _mm256_add_epi32(in1, in7);
-		__m256i a5 = _mm256_sub_epi32(in1, in7);
-		__m256i a6 = _mm256_sub_epi32(in5, in3);
-		__m256i a7 = _mm256_add_epi32(in5, in3);
-		__m256i a8 = _mm256_sub_epi32(a6, a4);
-		__m256i a9 = _mm256_add_epi32(a6, a4);
+			for (u32 y = 0; y < Size; y++) {
 
-		__m256i b0 = _mm256_srai_epi32(_mm256_mullo_epi32(a3, m0), fixMultiplyShift);
-		__m256i b1 = _mm256_srai_epi32(_mm256_mullo_epi32(a8, m0), fixMultiplyShift);
-		__m256i b2 = _mm256_srai_epi32(_mm256_mullo_epi32(a7, m1), fixMultiplyShift);
-		__m256i b3 = _mm256_srai_epi32(_mm256_mullo_epi32(a5, m1), fixMultiplyShift);
-		__m256i b4 = _mm256_srai_epi32(_mm256_mullo_epi32(a7, m2), fixMultiplyShift);
-		__m256i b5 = _mm256_srai_epi32(_mm256_mullo_epi32(a5, m2), fixMultiplyShift);
-		__m256i b6 = _mm256_sub_epi32(b5, b2);
-		__m256i b7 = _mm256_add_epi32(b3, b4);
+				i64 sum = 0;
 
-		__m256i bc = _mm256_sub_epi32(a2, b0);
-		__m256i c0 = _mm256_add_epi32(a0, b0);
-		__m256i c1 = _mm256_add_epi32(a1, bc);
-		__m256i c2 = _mm256_sub_epi32(a1, bc);
-		__m256i c3 = _mm256_sub_epi32(a0, b0);
-		__m256i c4 = _mm256_add_epi32(b1, b6);
-		__m256i c5 = _mm256_sub_epi32(a9, b7);
-		__m256i c6 = b6;
-		__m256i c7 = _mm256_sub_epi32(b7, b1);
+				for (u32 v = 0; v < 8; v++) {
+					sum += i64(inData[u * 8 + v]) * weights[v][y];
+				}
 
-		__m256i d0 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c0, c7), (fixScaleShift - fixTransformShift)), m3);
-		__m256i d1 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c1, c6), (fixScaleShift - fixTransformShift)), m3);
-		__m256i d2 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c2, c5), (fixScaleShift - fixTransformShift)), m3);
-		__m256i d3 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c3, c4), (fixScaleShift - fixTransformShift)), m3);
-		__m256i d4 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_sub_epi32(c3, c4), (fixScaleShift - fixTransformShift)), m3);
-		__m256i d5 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_sub_epi32(c2, c5), (fixScaleShift - fixTransformShift)), m3);
-		__m256i d6 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_sub_epi32(c1, c6), (fixScaleShift - fixTransformShift)), m3);
-		__m256i d7 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_sub_epi32(c0, c7), (fixScaleShift - fixTransformShift)), m3);
+				buffer[u][y] = sum >> fixReducedShift;
 
-		__m256i e0 = _mm256_permute4x64_epi64(_mm256_packs_epi32(d0, d1), 0xD8);
-		__m256i e1 = _mm256_permute4x64_epi64(_mm256_packs_epi32(d2, d3), 0xD8);
-		__m256i e2 = _mm256_permute4x64_epi64(_mm256_packs_epi32(d4, d5), 0xD8);
-		__m256i e3 = _mm256_permute4x64_epi64(_mm256_packs_epi32(d6, d7), 0xD8);
+			}
+
+		}
+
+		//Second pass: Horizontal frequencies
+		for (u32 y = 0; y < height; y++) {
+
+			for (u32 x = 0; x < width; x++) {
+
+				i64 sum = 0;
+
+				for (u32 u = 0; u < 8; u++) {
+					sum += buffer[u][y] * weights[u][x];
+				}
+
+				i64 sample = (sum >> (fixReducedShift + fixScaleShift - fixTransformShift)) + bias;
+				outData[outStride * y + x] = static_cast<i16>(Math::clamp(sample, i64(-32768), i64(32767)));
+
+			}
+
+		}
 
-		_mm256_maskstore_epi64(outVec[0], m4, e0);
-		_mm256_maskstore_epi64(outVec[1], m5, e0);
-		_mm256_maskstore_epi64(outVec[2], m4, e1);
-		_mm256_maskstore_epi64(outVec[3], m5, e1);
-		_mm256_maskstore_epi64(outVec[4], m4, e2);
-		_mm256_maskstore_epi64(outVec[5], m5, e2);
-		_mm256_maskstore_epi64(outVec[6], m4, e3);
-		_mm256_maskstore_epi64(outVec[7], m5, e3);
 	}
 
-#elif defined(ARC_VECTORIZE_X86_SSE4_1)     //pmulld requires SSE4.1, possible improvement through optimized shifts + adds?
+}
+
+
+
+static void idctDefault(const i32* inData, i16* outData, SizeT outStride) {
+
+#ifdef ARC_VECTORIZE_X86_SSE4_1     //pmulld requires SSE4.1, possible improvement through optimized shifts + adds?
 
 	const __m128i* inVec = reinterpret_cast<const __m128i*>(inData);
 
@@ -2095,7 +2590,7 @@ void JPEGDecoder::applyIDCT(JPEG::ScanComponent& component, SizeT imageBase) {
 	__m128i* outVec[8];
 
 	for (u32 i = 0; i < 8; i++) {
-		outVec[i] = reinterpret_cast<__m128i*>(outData + component.width * i);
+		outVec[i] = reinterpret_cast<__m128i*>(outData + outStride * i);
 	}
 
 	/*
@@ -2279,18 +2774,638 @@ void JPEGDecoder::applyIDCT(JPEG::ScanComponent& component, SizeT imageBase) {
 
 	}
 
-#else
+#else
+
+	scalarIDCT<true>(inData, outData, outStride, 8, 8);
+
+#endif
+
+}
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+ARC_TARGET("avx2") static void idctAVX2(const i32* inData, i16* outData, SizeT outStride) {
+
+	const __m256i* inVec = reinterpret_cast<const __m256i*>(inData);
+
+	__m256i bufVec[8];
+
+	__m256i m0 = _mm256_set1_epi32(multiplyConstants[0]);
+	__m256i m1 = _mm256_set1_epi32(multiplyConstants[1]);
+	__m256i m2 = _mm256_set1_epi32(multiplyConstants[2]);
+	__m256i m3 = _mm256_set1_epi32(128 << fixTransformShift);
+
+	__m128i* outVec[8];
+
+	for (u32 i = 0; i < 8; i++) {
+		outVec[i] = reinterpret_cast<__m128i*>(outData + outStride * i);
+	}
+
+	/*
+	 *  This algorithm is based on the scalar version, unrolled 8 times
+	 */
+	{
+		__m256i in0 = _mm256_load_si256(inVec + 0);
+		__m256i in1 = _mm256_load_si256(inVec + 1);
+		__m256i in2 = _mm256_load_si256(inVec + 2);
+		__m256i in3 = _mm256_load_si256(inVec + 3);
+		__m256i in4 = _mm256_load_si256(inVec + 4);
+		__m256i in5 = _mm256_load_si256(inVec + 5);
+		__m256i in6 = _mm256_load_si256(inVec + 6);
+		__m256i in7 = _mm256_load_si256(inVec + 7);
+
+		__m256i a0 = _mm256_add_epi32(in0, in4);
+		__m256i a1 = _mm256_sub_epi32(in0, in4);
+		__m256i a2 = _mm256_sub_epi32(in2, in6);
+		__m256i a3 = _mm256_add_epi32(in2, in6);
+		__m256i a4 = _mm256_add_epi32(in1, in7);
+		__m256i a5 = _mm256_sub_epi32(in1, in7);
+		__m256i a6 = _mm256_sub_epi32(in5, in3);
+		__m256i a7 = _mm256_add_epi32(in5, in3);
+		__m256i a8 = _mm256_sub_epi32(a6, a4);
+		__m256i a9 = _mm256_add_epi32(a6, a4);
+
+		__m256i b0 = _mm256_srai_epi32(_mm256_mullo_epi32(a3, m0), fixMultiplyShift);
+		__m256i b1 = _mm256_srai_epi32(_mm256_mullo_epi32(a8, m0), fixMultiplyShift);
+		__m256i b2 = _mm256_srai_epi32(_mm256_mullo_epi32(a7, m1), fixMultiplyShift);
+		__m256i b3 = _mm256_srai_epi32(_mm256_mullo_epi32(a5, m1), fixMultiplyShift);
+		__m256i b4 = _mm256_srai_epi32(_mm256_mullo_epi32(a7, m2), fixMultiplyShift);
+		__m256i b5 = _mm256_srai_epi32(_mm256_mullo_epi32(a5, m2), fixMultiplyShift);
+		__m256i b6 = _mm256_sub_epi32(b5, b2);
+		__m256i b7 = _mm256_add_epi32(b3, b4);
+
+		__m256i bc = _mm256_sub_epi32(a2, b0);
+		__m256i c0 = _mm256_add_epi32(a0, b0);
+		__m256i c1 = _mm256_add_epi32(a1, bc);
+		__m256i c2 = _mm256_sub_epi32(a1, bc);
+		__m256i c3 = _mm256_sub_epi32(a0, b0);
+		__m256i c4 = _mm256_add_epi32(b1, b6);
+		__m256i c5 = _mm256_sub_epi32(a9, b7);
+		__m256i c6 = b6;
+		__m256i c7 = _mm256_sub_epi32(b7, b1);
+
+		__m256i d0 = _mm256_add_epi32(c0, c7);
+		__m256i d1 = _mm256_add_epi32(c1, c6);
+		__m256i d2 = _mm256_add_epi32(c2, c5);
+		__m256i d3 = _mm256_add_epi32(c3, c4);
+		__m256i d4 = _mm256_sub_epi32(c3, c4);
+		__m256i d5 = _mm256_sub_epi32(c2, c5);
+		__m256i d6 = _mm256_sub_epi32(c1, c6);
+		__m256i d7 = _mm256_sub_epi32(c0, c7);
+
+		//8x8 flat transpose
+		__m256i e0 = _mm256_unpacklo_epi32(d0, d1);     //a0, b0, a1, b1, a4, b4, a5, b5
+		__m256i e1 = _mm256_unpacklo_epi32(d2, d3);     //c0, d0, c1, d1, c4, d4, c5, d5
+		__m256i e2 = _mm256_unpacklo_epi32(d4, d5);     //e0, f0, e1, f1, e4, f4, e5, f5
+		__m256i e3 = _mm256_unpacklo_epi32(d6, d7);     //g0, h0, g1, h1, g4, h4, g5, h5
+		__m256i e4 = _mm256_unpackhi_epi32(d0, d1);     //a2, b2, a3, b3, a6, b6, a7, b7
+		__m256i e5 = _mm256_unpackhi_epi32(d2, d3);     //c2, d2, c3, d3, c6, d6, c7, d7
+		__m256i e6 = _mm256_unpackhi_epi32(d4, d5);     //e2, f2, e3, f3, e6, f6, e7, f7
+		__m256i e7 = _mm256_unpackhi_epi32(d6, d7);     //g2, h2, g3, h3, g6, h6, g7, h7
+
+		__m256i f0 = _mm256_shuffle_epi32(e1, 0x4E);    //c1, d1, c0, d0, c5, d5, c4, d4
+		__m256i f1 = _mm256_shuffle_epi32(e3, 0x4E);    //g1, h1, g0, h0, g5, h5, g4, h4
+		__m256i f2 = _mm256_shuffle_epi32(e5, 0x4E);    //c3, d3, c2, d2, c7, d7, c6, d6
+		__m256i f3 = _mm256_shuffle_epi32(e7, 0x4E);    //g3, h3, g2, h2, g7, h7, g6, h6
+
+		__m256i g0 = _mm256_blend_epi32(e0, f0, 0xCC);  //a0, b0, c0, d0, a4, b4, c4, d4
+		__m256i g1 = _mm256_blend_epi32(e2, f1, 0xCC);  //e0, f0, g0, h0, e4, f4, g4, h4
+		__m256i g2 = _mm256_blend_epi32(e4, f2, 0xCC);  //a2, b2, c2, d2, a6, b6, c6, d6
+		__m256i g3 = _mm256_blend_epi32(e6, f3, 0xCC);  //e2, f2, g2, h2, e6, f6, g6, h6
+		__m256i g4 = _mm256_blend_epi32(e0, f0, 0x33);  //c1, d1, a1, b1, c5, d5, a5, b5
+		__m256i g5 = _mm256_blend_epi32(e2, f1, 0x33);  //g1, h1, e1, f1, g5, h5, e5, f5
+		__m256i g6 = _mm256_blend_epi32(e4, f2, 0x33);  //c3, d3, a3, b3, c7, d7, a7, b7
+		__m256i g7 = _mm256_blend_epi32(e6, f3, 0x33);  //g3, h3, e3, f3, g7, h7, e7, f7
+
+		__m256i h0 = _mm256_shuffle_epi32(g4, 0x4E);    //a1, b1, c1, d1, a5, b5, c5, d5
+		__m256i h1 = _mm256_shuffle_epi32(g5, 0x4E);    //e1, f1, g1, h1, e5, f5, g5, h5
+		__m256i h2 = _mm256_shuffle_epi32(g6, 0x4E);    //a3, b3, c3, d3, a7, b7, c7, d7
+		__m256i h3 = _mm256_shuffle_epi32(g7, 0x4E);    //e3, f3, g3, h3, e7, f7, g7, h7
+
+		_mm256_store_si256(bufVec + 0, _mm256_permute2x128_si256(g0, g1, 0x20));
+		_mm256_store_si256(bufVec + 1, _mm256_permute2x128_si256(h0, h1, 0x20));
+		_mm256_store_si256(bufVec + 2, _mm256_permute2x128_si256(g2, g3, 0x20));
+		_mm256_store_si256(bufVec + 3, _mm256_permute2x128_si256(h2, h3, 0x20));
+		_mm256_store_si256(bufVec + 4, _mm256_permute2x128_si256(g0, g1, 0x31));
+		_mm256_store_si256(bufVec + 5, _mm256_permute2x128_si256(h0, h1, 0x31));
+		_mm256_store_si256(bufVec + 6, _mm256_permute2x128_si256(g2, g3, 0x31));
+		_mm256_store_si256(bufVec + 7, _mm256_permute2x128_si256(h2, h3, 0x31));
+	}
+
+	{
+		__m256i in0 = _mm256_load_si256(bufVec + 0);
+		__m256i in1 = _mm256_load_si256(bufVec + 1);
+		__m256i in2 = _mm256_load_si256(bufVec + 2);
+		__m256i in3 = _mm256_load_si256(bufVec + 3);
+		__m256i in4 = _mm256_load_si256(bufVec + 4);
+		__m256i in5 = _mm256_load_si256(bufVec + 5);
+		__m256i in6 = _mm256_load_si256(bufVec + 6);
+		__m256i in7 = _mm256_load_si256(bufVec + 7);
+
+		__m256i a0 = _mm256_add_epi32(in0, in4);
+		__m256i a1 = _mm256_sub_epi32(in0, in4);
+		__m256i a2 = _mm256_sub_epi32(in2, in6);
+		__m256i a3 = _mm256_add_epi32(in2, in6);
+		__m256i a4 = _mm256_add_epi32(in1, in7);
+		__m256i a5 = _mm256_sub_epi32(in1, in7);
+		__m256i a6 = _mm256_sub_epi32(in5, in3);
+		__m256i a7 = _mm256_add_epi32(in5, in3);
+		__m256i a8 = _mm256_sub_epi32(a6, a4);
+		__m256i a9 = _mm256_add_epi32(a6, a4);
+
+		__m256i b0 = _mm256_srai_epi32(_mm256_mullo_epi32(a3, m0), fixMultiplyShift);
+		__m256i b1 = _mm256_srai_epi32(_mm256_mullo_epi32(a8, m0), fixMultiplyShift);
+		__m256i b2 = _mm256_srai_epi32(_mm256_mullo_epi32(a7, m1), fixMultiplyShift);
+		__m256i b3 = _mm256_srai_epi32(_mm256_mullo_epi32(a5, m1), fixMultiplyShift);
+		__m256i b4 = _mm256_srai_epi32(_mm256_mullo_epi32(a7, m2), fixMultiplyShift);
+		__m256i b5 = _mm256_srai_epi32(_mm256_mullo_epi32(a5, m2), fixMultiplyShift);
+		__m256i b6 = _mm256_sub_epi32(b5, b2);
+		__m256i b7 = _mm256_add_epi32(b3, b4);
+
+		__m256i bc = _mm256_sub_epi32(a2, b0);
+		__m256i c0 = _mm256_add_epi32(a0, b0);
+		__m256i c1 = _mm256_add_epi32(a1, bc);
+		__m256i c2 = _mm256_sub_epi32(a1, bc);
+		__m256i c3 = _mm256_sub_epi32(a0, b0);
+		__m256i c4 = _mm256_add_epi32(b1, b6);
+		__m256i c5 = _mm256_sub_epi32(a9, b7);
+		__m256i c6 = b6;
+		__m256i c7 = _mm256_sub_epi32(b7, b1);
+
+		__m256i d0 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c0, c7), (fixScaleShift - fixTransformShift)), m3);
+		__m256i d1 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c1, c6), (fixScaleShift - fixTransformShift)), m3);
+		__m256i d2 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c2, c5), (fixScaleShift - fixTransformShift)), m3);
+		__m256i d3 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_add_epi32(c3, c4), (fixScaleShift - fixTransformShift)), m3);
+		__m256i d4 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_sub_epi32(c3, c4), (fixScaleShift - fixTransformShift)), m3);
+		__m256i d5 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_sub_epi32(c2, c5), (fixScaleShift - fixTransformShift)), m3);
+		__m256i d6 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_sub_epi32(c1, c6), (fixScaleShift - fixTransformShift)), m3);
+		__m256i d7 = _mm256_add_epi32(_mm256_srai_epi32(_mm256_sub_epi32(c0, c7), (fixScaleShift - fixTransformShift)), m3);
+
+		__m256i e0 = _mm256_permute4x64_epi64(_mm256_packs_epi32(d0, d1), 0xD8);
+		__m256i e1 = _mm256_permute4x64_epi64(_mm256_packs_epi32(d2, d3), 0xD8);
+		__m256i e2 = _mm256_permute4x64_epi64(_mm256_packs_epi32(d4, d5), 0xD8);
+		__m256i e3 = _mm256_permute4x64_epi64(_mm256_packs_epi32(d6, d7), 0xD8);
+
+		_mm_storeu_si128(outVec[0], _mm256_castsi256_si128(e0));
+		_mm_storeu_si128(outVec[1], _mm256_extracti128_si256(e0, 1));
+		_mm_storeu_si128(outVec[2], _mm256_castsi256_si128(e1));
+		_mm_storeu_si128(outVec[3], _mm256_extracti128_si256(e1, 1));
+		_mm_storeu_si128(outVec[4], _mm256_castsi256_si128(e2));
+		_mm_storeu_si128(outVec[5], _mm256_extracti128_si256(e2, 1));
+		_mm_storeu_si128(outVec[6], _mm256_castsi256_si128(e3));
+		_mm_storeu_si128(outVec[7], _mm256_extracti128_si256(e3, 1));
+	}
+
+}
+
+#endif
+
+
+
+static void dequantizeDefault(const i16* coefficients, const i32* quantization, i32* block) {
+
+	for (u32 i = 0; i < 64; i++) {
+		block[i] = coefficients[i] * quantization[i];
+	}
+
+}
+
+
+
+template<u32 FixShift>
+static void convertYCbCrRowScalar(const i16* y, const i16* cb, const i16* cr, u8* rgb, u32 width, bool halfChroma) {
+
+	for (u32 i = 0; i < width; i++) {
+
+		u32 c = halfChroma ? i / 2 : i;
+
+		i32 l = y[i];
+		i32 u = cb[c] - (128 << FixShift);
+		i32 v = cr[c] - (128 << FixShift);
+
+		i32 r = l + ((v * ycbcrFactors[0]) >> ycbcrShift);
+		i32 g = l - ((u * ycbcrFactors[1]) >> ycbcrShift) - ((v * ycbcrFactors[2]) >> ycbcrShift);
+		i32 b = l + ((u * ycbcrFactors[3]) >> ycbcrShift);
+
+		rgb[0] = Math::clamp((r + colorBias<FixShift>) >> FixShift, 0, 255);
+		rgb[1] = Math::clamp((g + colorBias<FixShift>) >> FixShift, 0, 255);
+		rgb[2] = Math::clamp((b + colorBias<FixShift>) >> FixShift, 0, 255);
+
+		rgb += 3;
+
+	}
+
+}
+
+
+
+template<u32 FixShift>
+static void convertMonochromeRowScalar(const i16* y, u8* gray, u32 width) {
+
+	for (u32 i = 0; i < width; i++) {
+		gray[i] = Math::clamp((y[i] + colorBias<FixShift>) >> FixShift, 0, 255);
+	}
+
+}
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+//Interleaves 16 pixels of planar 16-bit r, g and b into 48 bytes of packed RGB8, saturating each channel
+ARC_TARGET("ssse3,sse4.1") ARC_FORCE_INLINE static void storeRGB16(u8* rgb, __m128i r0, __m128i r1, __m128i g0, __m128i g1, __m128i b0, __m128i b1) {
+
+	__m128i shuf0 = _mm_setr_epi32(0x0D070605, 0x01000F0E, 0x08040302, 0x0C0B0A09);
+	__m128i shuf1 = _mm_setr_epi32(0x06050403, 0x0D0C0B07, 0x01000F0E, 0x0A090802);
+	__m128i shuf2 = _mm_setr_epi32(0x010B0600, 0x08020C07, 0x0E09030D, 0x050F0A04);
+	__m128i shuf3 = _mm_setr_epi32(0x01060300, 0x05020704, 0x0B080D0A, 0x0F0C090E);
+	__m128i shuf4 = _mm_setr_epi32(0x0B05000A, 0x020C0601, 0x08030D07, 0x0F09040E);
+
+	__m128i m6 = _mm_packus_epi16(g0, b0);      //g0, g1, g2, g3, g4, [g5, g6, g7], b0, b1, b2, b3, b4, [b5, b6, b7]
+	__m128i m7 = _mm_packus_epi16(r0, b1);      //[r0, r1, r2, r3, r4, r5], r6, r7, b8, b9, [bA, bB, bC, bD, bE, bF]
+	__m128i m8 = _mm_packus_epi16(r1, g1);      //[r8, r9, rA], rB, rC, rD, rE, rF, [g8, g9, gA], gB, gC, gD, gE, gF
+
+	__m128i n0 = _mm_shuffle_epi8(m6, shuf0);   //[g5, g6, g7, b5, b6, b7], g0, g1, g2, g3, g4, b0, b1, b2, b3, b4
+	__m128i n1 = _mm_shuffle_epi8(m8, shuf1);   //rB, rC, rD, rE, rF, gB, gC, gD, gE, gF, [r8, r9, rA, g8, g9, gA]
+
+	__m128i n2 = _mm_blend_epi16(n0, m7, 0x07);                             //r0, r1, r2, r3, r4, r5, g0, g1, g2, g3, g4, b0, b1, b2, b3, b4
+	__m128i n3 = _mm_blend_epi16(_mm_blend_epi16(m7, n0, 0x07), n1, 0xE0);  //g5, g6, g7, b5, b6, b7, r6, r7, b8, b9, r8, r9, rA, g8, g9, gA
+	__m128i n4 = _mm_blend_epi16(n1, m7, 0xE0);                             //rB, rC, rD, rE, rF, gB, gC, gD, gE, gF, bA, bB, bC, bD, bE, bF
+
+	__m128i* target = reinterpret_cast<__m128i*>(rgb);
+
+	_mm_storeu_si128(target + 0, _mm_shuffle_epi8(n2, shuf2));   //r0, g0, b0, r1, g1, b1, r2, g2, b2, r3, g3, b3, r4, g4, b4, r5
+	_mm_storeu_si128(target + 1, _mm_shuffle_epi8(n3, shuf3));   //g5, b5, r6, g6, b6, r7, g7, b7, r8, g8, b8, r9, g9, b9, rA, gA
+	_mm_storeu_si128(target + 2, _mm_shuffle_epi8(n4, shuf4));   //bA, rB, gB, bB, rC, gC, bC, rD, gD, bD, rE, gE, bE, rF, gF, bF
+
+}
+
+
+
+//Loads 16 chroma samples for 16 pixels, duplicating each sample if the chroma row is horizontally subsampled
+ARC_TARGET("avx2") ARC_FORCE_INLINE static __m256i loadChroma16(const i16* chroma, bool halfChroma) {
+
+	if (halfChroma) {
+
+		__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(chroma));
+		return _mm256_set_m128i(_mm_unpackhi_epi16(c, c), _mm_unpacklo_epi16(c, c));
+
+	}
+
+	return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(chroma));
+
+}
+
+
+
+ARC_TARGET("avx2") static void dequantizeAVX2(const i16* coefficients, const i32* quantization, i32* block) {
+
+	for (u32 i = 0; i < 64; i += 8) {
+
+		__m256i c = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(coefficients + i)));
+		__m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(quantization + i));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(block + i), _mm256_mullo_epi32(c, q));
+
+	}
+
+}
+
+
+
+//Converts 8 pixels with the same 32-bit fixed point arithmetic as convertYCbCrRowScalar, making the output bit-exact
+ARC_TARGET("avx2") ARC_FORCE_INLINE static void convertYCbCr8(__m256i l, __m256i u, __m256i v, __m256i& r, __m256i& g, __m256i& b) {
+
+	constexpr u32 FixShift = fixTransformShift;
+
+	__m256i center = _mm256_set1_epi32(128 << FixShift);
+	__m256i bias = _mm256_set1_epi32(colorBias<FixShift>);
+
+	u = _mm256_sub_epi32(u, center);
+	v = _mm256_sub_epi32(v, center);
+
+	r = _mm256_add_epi32(l, _mm256_srai_epi32(_mm256_mullo_epi32(v, _mm256_set1_epi32(ycbcrFactors[0])), ycbcrShift));
+	g = _mm256_sub_epi32(l, _mm256_srai_epi32(_mm256_mullo_epi32(u, _mm256_set1_epi32(ycbcrFactors[1])), ycbcrShift));
+	g = _mm256_sub_epi32(g, _mm256_srai_epi32(_mm256_mullo_epi32(v, _mm256_set1_epi32(ycbcrFactors[2])), ycbcrShift));
+	b = _mm256_add_epi32(l, _mm256_srai_epi32(_mm256_mullo_epi32(u, _mm256_set1_epi32(ycbcrFactors[3])), ycbcrShift));
+
+	r = _mm256_srai_epi32(_mm256_add_epi32(r, bias), FixShift);
+	g = _mm256_srai_epi32(_mm256_add_epi32(g, bias), FixShift);
+	b = _mm256_srai_epi32(_mm256_add_epi32(b, bias), FixShift);
+
+}
+
+
+
+//packs_epi32 interleaves 128-bit lanes, the permutation restores pixel order
+ARC_TARGET("avx2") ARC_FORCE_INLINE static __m256i packOrdered(__m256i lo, __m256i hi) {
+	return _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+}
+
+
+
+//Handles 16 pixels per iteration, the remainder falls back to the scalar version
+ARC_TARGET("avx2") static void convertYCbCrRowAVX2(const i16* y, const i16* cb, const i16* cr, u8* rgb, u32 width, bool halfChroma) {
+
+	u32 vectorWidth = width & ~15;
+
+	for (u32 i = 0; i < vectorWidth; i += 16) {
+
+		__m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+		__m256i u = loadChroma16(cb + (halfChroma ? i / 2 : i), halfChroma);
+		__m256i v = loadChroma16(cr + (halfChroma ? i / 2 : i), halfChroma);
+
+		__m256i r0, g0, b0, r1, g1, b1;
+
+		convertYCbCr8(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(l)), _mm256_cvtepi16_epi32(_mm256_castsi256_si128(u)), _mm256_cvtepi16_epi32(_mm256_castsi256_si128(v)), r0, g0, b0);
+		convertYCbCr8(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(l, 1)), _mm256_cvtepi16_epi32(_mm256_extracti128_si256(u, 1)), _mm256_cvtepi16_epi32(_mm256_extracti128_si256(v, 1)), r1, g1, b1);
+
+		__m256i r = packOrdered(r0, r1);
+		__m256i g = packOrdered(g0, g1);
+		__m256i b = packOrdered(b0, b1);
+
+		storeRGB16(rgb + i * 3, _mm256_castsi256_si128(r), _mm256_extracti128_si256(r, 1), _mm256_castsi256_si128(g), _mm256_extracti128_si256(g, 1), _mm256_castsi256_si128(b), _mm256_extracti128_si256(b, 1));
+
+	}
+
+	u32 chromaStart = halfChroma ? vectorWidth / 2 : vectorWidth;
+
+	convertYCbCrRowScalar<fixTransformShift>(y + vectorWidth, cb + chromaStart, cr + chromaStart, rgb + vectorWidth * 3, width - vectorWidth, halfChroma);
+
+}
+
+
+
+ARC_TARGET("avx2") static void convertMonochromeRowAVX2(const i16* y, u8* gray, u32 width) {
+
+	constexpr u32 FixShift = fixTransformShift;
+
+	//Saturating adds keep the result identical to the 32-bit scalar version since anything above 255 clamps anyway
+	__m256i bias = _mm256_set1_epi16(colorBias<FixShift>);
+
+	u32 vectorWidth = width & ~31;
+
+	for (u32 i = 0; i < vectorWidth; i += 32) {
+
+		__m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i));
+		__m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i + 16));
+
+		v0 = _mm256_srai_epi16(_mm256_adds_epi16(v0, bias), FixShift);
+		v1 = _mm256_srai_epi16(_mm256_adds_epi16(v1, bias), FixShift);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(gray + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(v0, v1), 0xD8));
+
+	}
+
+	convertMonochromeRowScalar<FixShift>(y + vectorWidth, gray + vectorWidth, width - vectorWidth);
+
+}
+
+
+
+ARC_TARGET("avx512f") static void dequantizeAVX512(const i16* coefficients, const i32* quantization, i32* block) {
+
+	for (u32 i = 0; i < 64; i += 16) {
+
+		__m512i c = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(coefficients + i)));
+		__m512i q = _mm512_loadu_si512(quantization + i);
+
+		_mm512_storeu_si512(block + i, _mm512_mullo_epi32(c, q));
+
+	}
+
+}
+
+
+
+//Same arithmetic as convertYCbCrRowAVX2 on 16 lanes at once
+ARC_TARGET("avx512f,avx2") static void convertYCbCrRowAVX512(const i16* y, const i16* cb, const i16* cr, u8* rgb, u32 width, bool halfChroma) {
+
+	constexpr u32 FixShift = fixTransformShift;
+
+	__m512i rcr = _mm512_set1_epi32(ycbcrFactors[0]);
+	__m512i gcb = _mm512_set1_epi32(ycbcrFactors[1]);
+	__m512i gcr = _mm512_set1_epi32(ycbcrFactors[2]);
+	__m512i bcb = _mm512_set1_epi32(ycbcrFactors[3]);
+	__m512i center = _mm512_set1_epi32(128 << FixShift);
+	__m512i bias = _mm512_set1_epi32(colorBias<FixShift>);
+
+	u32 vectorWidth = width & ~15;
+
+	for (u32 i = 0; i < vectorWidth; i += 16) {
+
+		__m512i l = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + i)));
+		__m512i u = _mm512_sub_epi32(_mm512_cvtepi16_epi32(loadChroma16(cb + (halfChroma ? i / 2 : i), halfChroma)), center);
+		__m512i v = _mm512_sub_epi32(_mm512_cvtepi16_epi32(loadChroma16(cr + (halfChroma ? i / 2 : i), halfChroma)), center);
+
+		__m512i r = _mm512_add_epi32(l, _mm512_srai_epi32(_mm512_mullo_epi32(v, rcr), ycbcrShift));
+		__m512i g = _mm512_sub_epi32(l, _mm512_srai_epi32(_mm512_mullo_epi32(u, gcb), ycbcrShift));
+		g = _mm512_sub_epi32(g, _mm512_srai_epi32(_mm512_mullo_epi32(v, gcr), ycbcrShift));
+		__m512i b = _mm512_add_epi32(l, _mm512_srai_epi32(_mm512_mullo_epi32(u, bcb), ycbcrShift));
+
+		//Narrowing with signed saturation keeps the values in order, unlike packs
+		__m256i rs = _mm512_cvtsepi32_epi16(_mm512_srai_epi32(_mm512_add_epi32(r, bias), FixShift));
+		__m256i gs = _mm512_cvtsepi32_epi16(_mm512_srai_epi32(_mm512_add_epi32(g, bias), FixShift));
+		__m256i bs = _mm512_cvtsepi32_epi16(_mm512_srai_epi32(_mm512_add_epi32(b, bias), FixShift));
+
+		storeRGB16(rgb + i * 3, _mm256_castsi256_si128(rs), _mm256_extracti128_si256(rs, 1), _mm256_castsi256_si128(gs), _mm256_extracti128_si256(gs, 1), _mm256_castsi256_si128(bs), _mm256_extracti128_si256(bs, 1));
+
+	}
+
+	u32 chromaStart = halfChroma ? vectorWidth / 2 : vectorWidth;
+
+	convertYCbCrRowScalar<FixShift>(y + vectorWidth, cb + chromaStart, cr + chromaStart, rgb + vectorWidth * 3, width - vectorWidth, halfChroma);
+
+}
+
+#endif
+
+
+
+/*
+	Kernels used by the decoder, selected once at runtime depending on the CPU features.
+	Color conversion kernels operate on samples with fixTransformShift fractional bits.
+*/
+struct JPEGKernels {
+
+	void (*idct)(const i32* inData, i16* outData, SizeT outStride);
+	void (*dequantize)(const i16* coefficients, const i32* quantization, i32* block);
+	void (*convertYCbCrRow)(const i16* y, const i16* cb, const i16* cr, u8* rgb, u32 width, bool halfChroma);
+	void (*convertMonochromeRow)(const i16* y, u8* gray, u32 width);
+
+};
+
+
+
+static const JPEGKernels& kernels() {
+
+	static const JPEGKernels table = []() {
+
+		JPEGKernels k = {
+			idctDefault,
+			dequantizeDefault,
+			convertYCbCrRowScalar<fixTransformShift>,
+			convertMonochromeRowScalar<fixTransformShift>
+		};
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::AVX2)) {
+
+			k.idct = idctAVX2;
+			k.dequantize = dequantizeAVX2;
+			k.convertYCbCrRow = convertYCbCrRowAVX2;
+			k.convertMonochromeRow = convertMonochromeRowAVX2;
+
+		}
+
+		//The 8x8 IDCT is already a single pass of 8-lane vectors, AVX-512 only pays off for the wider kernels
+		if (CPUID::hasFeature(CPUFeature::AVX512F) && CPUID::hasFeature(CPUFeature::AVX2)) {
+
+			k.dequantize = dequantizeAVX512;
+			k.convertYCbCrRow = convertYCbCrRowAVX512;
+
+		}
+
+#endif
+
+		return k;
+
+	}();
+
+	return table;
+
+}
+
+
+
+void JPEGDecoder::applyIDCT(JPEG::ScanComponent& component, SizeT imageBase) {
+	kernels().idct(component.block, &component.frameComponent.imageData[imageBase], component.frameComponent.width);
+}
+
+
+
+void JPEGDecoder::applyPartialIDCT(JPEG::ScanComponent& component, SizeT imageBase, u32 width, u32 height) {
+	scalarIDCT<false>(component.block, &component.frameComponent.imageData[imageBase], component.frameComponent.width, width, height);
+}
+
+
+
+void JPEGDecoder::applyReducedIDCT(JPEG::ScanComponent& component, SizeT imageBase, u32 size, u32 width, u32 height) {
+
+	switch (size) {
+
+		case 1:
+			reducedIDCT<1>(component.block, &component.frameComponent.imageData[imageBase], component.frameComponent.width, width, height);
+			break;
+
+		case 2:
+			reducedIDCT<2>(component.block, &component.frameComponent.imageData[imageBase], component.frameComponent.width, width, height);
+			break;
+
+		case 4:
+			reducedIDCT<4>(component.block, &component.frameComponent.imageData[imageBase], component.frameComponent.width, width, height);
+			break;
+
+		default:
+			ARC_UNREACHABLE
+
+	}
+
+}
+
+
+
+void JPEGDecoder::transformBlock(JPEG::ScanComponent& component, SizeT imageBase, u32 width, u32 height) {
+
+	u32 blockSize = frame.blockSize;
+
+	if (blockSize != 8) {
+		applyReducedIDCT(component, imageBase, blockSize, width, height);
+	} else if (width == 8 && height == 8) {
+		applyIDCT(component, imageBase);
+	} else {
+		applyPartialIDCT(component, imageBase, width, height);
+	}
+
+}
+
+
+
+void JPEGDecoder::collectFrameComponents() {
+
+	//The image is assembled from all frame components in frame header order, independent of the last scan
+	scan.scanComponents.clear();
+
+	for (u8 id : frame.componentOrder) {
+
+		FrameComponent& frameComponent = frame.components[id];
+		scan.scanComponents.emplace_back(scan.scanComponents.size(), dcHuffmanTables[0], acHuffmanTables[0], dcConditioning[0], acConditioning[0], quantizationTables[frameComponent.qID], frameComponent);
+
+	}
+
+}
 
-	scalarIDCT<true>(inData, outData, component.frameComponent.width, 8, 8);
 
-#endif
 
-}
+void JPEGDecoder::transformProgressiveComponents() {
 
+	for (ScanComponent& scanComponent : scan.scanComponents) {
 
+		FrameComponent& component = scanComponent.frameComponent;
+
+		u32 blockSize = frame.blockSize;
+		u32 blockColumns = (component.width + blockSize - 1) / blockSize;
+		u32 blockRows = (component.height + blockSize - 1) / blockSize;
+
+		//Coefficients are already in IDCT order, so the quantization table is permuted once
+		alignas(64) i32 quantization[64];
+
+		for (u32 i = 0; i < 64; i++) {
+			quantization[dezigzagTableTransposed[i]] = scanComponent.qTable.data[i];
+		}
+
+		const JPEGKernels& kernel = kernels();
+
+		auto transformRows = [&](SizeT startRow, SizeT endRow) {
+
+			alignas(64) i32 block[64];
+
+			ScanComponent rowComponent = scanComponent;
+			rowComponent.block = block;
+
+			for (SizeT by = startRow; by < endRow; by++) {
+
+				const i16* coefficients = component.progressiveBuffer.data() + by * component.blocksX * 64;
+
+				for (u32 bx = 0; bx < blockColumns; bx++) {
+
+					kernel.dequantize(coefficients, quantization, block);
+
+					SizeT baseX = bx * blockSize;
+					SizeT baseY = by * blockSize;
+
+					transformBlock(rowComponent, baseY * component.width + baseX, Math::min(component.width - baseX, SizeT(blockSize)), Math::min(component.height - baseY, SizeT(blockSize)));
+
+					coefficients += 64;
+
+				}
+
+			}
+
+		};
+
+		//Block rows write to disjoint image rows
+		if (threadPool) {
+			threadPool->parallelFor(0, blockRows, transformRows);
+		} else {
+			transformRows(0, blockRows);
+		}
+
+	}
 
-void JPEGDecoder::applyPartialIDCT(JPEG::ScanComponent& component, SizeT imageBase, u32 width, u32 height) {
-	scalarIDCT<false>(component.block, &component.frameComponent.imageData[imageBase], component.frameComponent.width, width, height);
 }
 
 
@@ -2324,66 +3439,134 @@ void JPEGDecoder::blendAndUpsample() {
 
 
 
-template<u32 FixShift>
-static RawImage blendMonochromeCore(Scan& scan) {
+//Calls function(startRow, endRow) on stripes of rows, in parallel if a pool is given
+template<class Function>
+static void blendStripes(ThreadPool* pool, u32 height, Function&& function) {
 
-	const JPEG::ScanComponent& component = scan.scanComponents[0];
-	const JPEG::FrameComponent& frameComponent = component.frameComponent;
+	u32 stripes = (height + blendStripeHeight - 1) / blendStripeHeight;
+
+	if (pool && stripes > 1) {
+
+		pool->parallelFor(0, stripes, [&](SizeT stripe) {
+
+			u32 startRow = stripe * blendStripeHeight;
+			function(startRow, Math::min(startRow + blendStripeHeight, height));
+
+		});
+
+	} else {
+
+		function(0, height);
+
+	}
+
+}
 
-	Image<Pixel::Grayscale8> target(frameComponent.width, frameComponent.height);
 
-	SizeT offset = 0;
 
-#ifdef ARC_VECTORIZE_X86_SSE4_1
+//Determines how chroma samples map to luma samples. Throws for subsampling layouts that are not supported.
+static void getChromaSubsampling(const Scan& scan, bool& halfRows, bool& halfColumns) {
 
-	SizeT totalPixels = target.pixelCount();
-	SizeT vectorSize = totalPixels / 16;
-	SizeT scalarSize = totalPixels % 16;
+	u32 ySamplesX = scan.scanComponents[0].frameComponent.samplesX;
+	u32 ySamplesY = scan.scanComponents[0].frameComponent.samplesY;
+	u32 cbSamplesX = scan.scanComponents[1].frameComponent.samplesX;
+	u32 cbSamplesY = scan.scanComponents[1].frameComponent.samplesY;
+	u32 crSamplesX = scan.scanComponents[2].frameComponent.samplesX;
+	u32 crSamplesY = scan.scanComponents[2].frameComponent.samplesY;
+
+	u32 yArea = ySamplesX * ySamplesY;
+	u32 cbArea = cbSamplesX * cbSamplesY;
+	u32 crArea = crSamplesX * crSamplesY;
+
+	if (Bool::all(yArea, cbArea, crArea, 1)) {
 
-	__m128i* targetVecData = reinterpret_cast<__m128i*>(target.getImageBuffer().data());
-	const __m128i* vecData = reinterpret_cast<const __m128i*>(frameComponent.imageData.data());
+		//No chroma subsampling
+		halfRows = false;
+		halfColumns = false;
 
-	__m128i bias = _mm_set1_epi16(colorBias<FixShift>);
+	} else if (Bool::all(ySamplesX, ySamplesY, 2) && Bool::all(cbArea, crArea, 1)) {
 
-	for (SizeT i = 0; i < vectorSize; i++) {
+		//Symmetrical chroma subsampling
+		halfRows = true;
+		halfColumns = true;
 
-		__m128i v0 = _mm_load_si128(vecData + 0);
-		__m128i v1 = _mm_load_si128(vecData + 1);
+	} else if (yArea == 2 && Bool::all(cbArea, crArea, 1)) {
 
-		v0 = _mm_srai_epi16(_mm_add_epi16(v0, bias), FixShift);
-		v1 = _mm_srai_epi16(_mm_add_epi16(v1, bias), FixShift);
+		//Asymmetric chroma subsampling, either H > V or H < V
+		halfRows = ySamplesX == 1;
+		halfColumns = ySamplesX != 1;
 
-		_mm_storeu_si128(targetVecData++, _mm_packus_epi16(v0, v1));
+	} else {
 
-		vecData += 2;
+		//TODO: Generic upsampling
+		throw UnsupportedOperationException("Subsampling variant not implemented yet");
 
 	}
 
-	const i16* imgData = reinterpret_cast<const i16*>(vecData);
-	u8* targetSclData = Bits::toByteArray(targetVecData);
+}
+
+
+
+//Converts image rows [startRow, endRow) to Grayscale8. target points to startRow.
+template<u32 FixShift>
+static void blendMonochromeRows(const Scan& scan, u32 startRow, u32 endRow, u8* target) {
+
+	const JPEG::FrameComponent& component = scan.scanComponents[0].frameComponent;
 
-	for (SizeT i = 0; i < scalarSize; i++) {
+	auto convertRow = FixShift == fixTransformShift ? kernels().convertMonochromeRow : convertMonochromeRowScalar<FixShift>;
 
-		*targetSclData = (*imgData + colorBias) >> FixShift;
+	for (u32 i = startRow; i < endRow; i++) {
 
-		targetSclData++;
-		imgData++;
+		convertRow(component.imageData.data() + SizeT(i - component.windowY) * component.width, target, component.width);
+		target += component.width;
 
 	}
 
-#else
+}
+
 
-	for (u32 i = 0; i < target.getHeight(); i++) {
 
-		for (u32 j = 0; j < target.getWidth(); j++) {
+//Converts image rows [startRow, endRow) to RGB8, upsampling chroma if necessary. target points to startRow.
+template<u32 FixShift>
+static void blendYCbCrRows(const Scan& scan, u32 startRow, u32 endRow, u8* target) {
 
-			target.setPixel(j, i, PixelGrayscale8(Math::clamp((component.frameComponent.imageData[offset++] + colorBias<FixShift>) >> FixShift, 0, 255)));
+	const JPEG::FrameComponent& y = scan.scanComponents[0].frameComponent;
+	const JPEG::FrameComponent& cb = scan.scanComponents[1].frameComponent;
+	const JPEG::FrameComponent& cr = scan.scanComponents[2].frameComponent;
 
-		}
+	bool halfRows, halfColumns;
+	getChromaSubsampling(scan, halfRows, halfColumns);
+
+	auto convertRow = FixShift == fixTransformShift ? kernels().convertYCbCrRow : convertYCbCrRowScalar<FixShift>;
+
+	for (u32 i = startRow; i < endRow; i++) {
+
+		u32 chromaRow = halfRows ? i / 2 : i;
+
+		SizeT lumaOffset = SizeT(i - y.windowY) * y.width;
+		SizeT cbOffset = SizeT(chromaRow - cb.windowY) * cb.width;
+		SizeT crOffset = SizeT(chromaRow - cr.windowY) * cr.width;
+
+		convertRow(y.imageData.data() + lumaOffset, cb.imageData.data() + cbOffset, cr.imageData.data() + crOffset, target, y.width, halfColumns);
+		target += y.width * 3;
 
 	}
 
-#endif
+}
+
+
+
+template<u32 FixShift>
+static RawImage blendMonochromeCore(Scan& scan, ThreadPool* pool) {
+
+	const JPEG::FrameComponent& frameComponent = scan.scanComponents[0].frameComponent;
+
+	Image<Pixel::Grayscale8> target(frameComponent.width, frameComponent.height);
+	u8* targetData = Bits::toByteArray(target.getImageBuffer().data());
+
+	blendStripes(pool, target.getHeight(), [&](u32 startRow, u32 endRow) {
+		blendMonochromeRows<FixShift>(scan, startRow, endRow, targetData + SizeT(startRow) * target.getWidth());
+	});
 
 	return target.makeRaw();
 
@@ -2392,258 +3575,382 @@ static RawImage blendMonochromeCore(Scan& scan) {
 
 
 template<u32 FixShift>
-static RawImage blendAndUpsampleYCbCrCore(Scan& scan) {
+static RawImage blendAndUpsampleYCbCrCore(Scan& scan, ThreadPool* pool) {
 
-	enum class Subsampling {
-		None,
-		Horizontal,
-		Vertical,
-		Both
-	};
+	const JPEG::FrameComponent& frameComponent = scan.scanComponents[0].frameComponent;
 
-	auto exec = [&]<Subsampling S>() -> RawImage {
+	//Validate the layout before allocating the target
+	bool halfRows, halfColumns;
+	getChromaSubsampling(scan, halfRows, halfColumns);
 
-		const JPEG::ScanComponent& component = scan.scanComponents[0];
-		const JPEG::FrameComponent& frameComponent = component.frameComponent;
+	Image<Pixel::RGB8> target(frameComponent.width, frameComponent.height);
+	u8* targetData = Bits::toByteArray(target.getImageBuffer().data());
 
-		Image<Pixel::RGB8> target(frameComponent.width, frameComponent.height);
+	blendStripes(pool, target.getHeight(), [&](u32 startRow, u32 endRow) {
+		blendYCbCrRows<FixShift>(scan, startRow, endRow, targetData + SizeT(startRow) * target.getWidth() * 3);
+	});
 
-		const i16* imgData[3] = {scan.scanComponents[0].frameComponent.imageData.data(),
-								 scan.scanComponents[1].frameComponent.imageData.data(),
-								 scan.scanComponents[2].frameComponent.imageData.data()};
+	return target.makeRaw();
 
-	#ifdef ARC_VECTORIZE_X86_SSE4_1
+}
 
-		if constexpr (S != Subsampling::None) {
-			throw UnsupportedOperationException("Subsampling not yet vectorized");
-		}
 
-		SizeT totalPixels = target.pixelCount();
-		SizeT vectorSize = totalPixels / 16;
-		SizeT scalarSize = totalPixels % 16;
 
-		i32 yShift = 15 - ycbcrShift;
-		i32 rgbShift = FixShift + ycbcrShift - 15;
+void JPEGDecoder::blendMonochrome() {
+	image = blendMonochromeCore<fixTransformShift>(scan, threadPool);
+}
 
-		__m128i rcr = _mm_set1_epi16(ycbcrFactors[0]);
-		__m128i gcb = _mm_set1_epi16(ycbcrFactors[1]);
-		__m128i gcr = _mm_set1_epi16(ycbcrFactors[2]);
-		__m128i bcb = _mm_set1_epi16(ycbcrFactors[3]);
-		__m128i csb = _mm_set1_epi16(128 << FixShift);
-		__m128i bias = _mm_set1_epi16(i16(1 << (rgbShift - 1)));
 
-		__m128i shuf0 = _mm_setr_epi32(0x0D070605, 0x01000F0E, 0x08040302, 0x0C0B0A09);
-		__m128i shuf1 = _mm_setr_epi32(0x06050403, 0x0D0C0B07, 0x01000F0E, 0x0A090802);
-		__m128i shuf2 = _mm_setr_epi32(0x010B0600, 0x08020C07, 0x0E09030D, 0x050F0A04);
-		__m128i shuf3 = _mm_setr_epi32(0x01060300, 0x05020704, 0x0B080D0A, 0x0F0C090E);
-		__m128i shuf4 = _mm_setr_epi32(0x0B05000A, 0x020C0601, 0x08030D07, 0x0F09040E);
 
-		__m128i* targetVecData = reinterpret_cast<__m128i*>(target.getImageBuffer().data());
-		const __m128i* vecData[3] = { reinterpret_cast<const __m128i*>(imgData[0]),
-									  reinterpret_cast<const __m128i*>(imgData[1]),
-									  reinterpret_cast<const __m128i*>(imgData[2]) };
+void JPEGDecoder::blendMonochromeTransformless() {
+	image = blendMonochromeCore<0>(scan, threadPool);
+}
 
-		for (SizeT i = 0; i < vectorSize; i++) {
 
-			__m128i l0 = _mm_srai_epi16(_mm_load_si128(vecData[0] + 0), yShift);
-			__m128i l1 = _mm_srai_epi16(_mm_load_si128(vecData[0] + 1), yShift);
-			__m128i l2 = _mm_sub_epi16(_mm_load_si128(vecData[1] + 0), csb);
-			__m128i l3 = _mm_sub_epi16(_mm_load_si128(vecData[1] + 1), csb);
-			__m128i l4 = _mm_sub_epi16(_mm_load_si128(vecData[2] + 0), csb);
-			__m128i l5 = _mm_sub_epi16(_mm_load_si128(vecData[2] + 1), csb);
 
-			__m128i rx0 = _mm_mulhrs_epi16(l4, rcr);
-			__m128i gx0 = _mm_mulhrs_epi16(l2, gcb);
-			__m128i gy0 = _mm_mulhrs_epi16(l4, gcr);
-			__m128i bx0 = _mm_mulhrs_epi16(l2, bcb);
-			__m128i rx1 = _mm_mulhrs_epi16(l5, rcr);
-			__m128i gx1 = _mm_mulhrs_epi16(l3, gcb);
-			__m128i gy1 = _mm_mulhrs_epi16(l5, gcr);
-			__m128i bx1 = _mm_mulhrs_epi16(l3, bcb);
+void JPEGDecoder::blendAndUpsampleYCbCr() {
+	image = blendAndUpsampleYCbCrCore<fixTransformShift>(scan, threadPool);
+}
 
-			__m128i r0 = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(l0, rx0), bias), rgbShift);
-			__m128i g0 = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_sub_epi16(l0, gx0), gy0), bias), rgbShift);
-			__m128i b0 = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(l0, bx0), bias), rgbShift);
-			__m128i r1 = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(l1, rx1), bias), rgbShift);
-			__m128i g1 = _mm_srai_epi16(_mm_add_epi16(_mm_sub_epi16(_mm_sub_epi16(l1, gx1), gy1), bias), rgbShift);
-			__m128i b1 = _mm_srai_epi16(_mm_add_epi16(_mm_add_epi16(l1, bx1), bias), rgbShift);
 
-			__m128i m6 = _mm_packus_epi16(g0, b0);      //g0, g1, g2, g3, g4, [g5, g6, g7], b0, b1, b2, b3, b4, [b5, b6, b7]
-			__m128i m7 = _mm_packus_epi16(r0, b1);      //[r0, r1, r2, r3, r4, r5], r6, r7, b8, b9, [bA, bB, bC, bD, bE, bF]
-			__m128i m8 = _mm_packus_epi16(r1, g1);      //[r8, r9, rA], rB, rC, rD, rE, rF, [g8, g9, gA], gB, gC, gD, gE, gF
 
-			__m128i n0 = _mm_shuffle_epi8(m6, shuf0);   //[g5, g6, g7, b5, b6, b7], g0, g1, g2, g3, g4, b0, b1, b2, b3, b4
-			__m128i n1 = _mm_shuffle_epi8(m8, shuf1);   //rB, rC, rD, rE, rF, gB, gC, gD, gE, gF, [r8, r9, rA, g8, g9, gA]
+void JPEGDecoder::blendAndUpsampleYCbCrTransformless() {
+	image = blendAndUpsampleYCbCrCore<0>(scan, threadPool);
+}
 
-			__m128i n2 = _mm_blend_epi16(n0, m7, 0x07);                             //r0, r1, r2, r3, r4, r5, g0, g1, g2, g3, g4, b0, b1, b2, b3, b4
-			__m128i n3 = _mm_blend_epi16(_mm_blend_epi16(m7, n0, 0x07), n1, 0xE0);  //g5, g6, g7, b5, b6, b7, r6, r7, b8, b9, r8, r9, rA, g8, g9, gA
-			__m128i n4 = _mm_blend_epi16(n1, m7, 0xE0);                             //rB, rC, rD, rE, rF, gB, gC, gD, gE, gF, bA, bB, bC, bD, bE, bF
 
-			__m128i c0 = _mm_shuffle_epi8(n2, shuf2);   //r0, g0, b0, r1, g1, b1, r2, g2, b2, r3, g3, b3, r4, g4, b4, r5
-			__m128i c1 = _mm_shuffle_epi8(n3, shuf3);   //g5, b5, r6, g6, b6, r7, g7, b7, r8, g8, b8, r9, g9, b9, rA, gA
-			__m128i c2 = _mm_shuffle_epi8(n4, shuf4);   //bA, rB, gB, bB, rC, gC, bC, rD, gD, bD, rE, gE, bE, rF, gF, bF
 
-			_mm_storeu_si128(targetVecData + 0, c0);
-			_mm_storeu_si128(targetVecData + 1, c1);
-			_mm_storeu_si128(targetVecData + 2, c2);
+void JPEGDecoder::blendRows(u32 startRow, u32 endRow, u8* target) {
 
-			targetVecData += 3;
+	switch (scan.scanComponents.size()) {
 
-			for (u32 j = 0; j < 3; j++) {
-				vecData[j] += 2;
-			}
+		case 1:
+			blendMonochromeRows<fixTransformShift>(scan, startRow, endRow, target);
+			break;
 
-		}
+		case 3:
+			blendYCbCrRows<fixTransformShift>(scan, startRow, endRow, target);
+			break;
 
-		u8* targetSclData = Bits::toByteArray(targetVecData);
+		default:
+			ARC_UNREACHABLE
 
-		for (u32 i = 0; i < 3; i++) {
-			imgData[i] = reinterpret_cast<const i16*>(vecData[i]);
-		}
+	}
 
-		for (SizeT i = 0; i < scalarSize; i++) {
+}
 
-			//YCbCr to RGB
-			i32 y  = *imgData[0];
-			i32 cb = *imgData[1] - (128 << FixShift);
-			i32 cr = *imgData[2] - (128 << FixShift);
 
-			i32 r = y + ((cr * ycbcrFactors[0]) >> ycbcrShift);
-			i32 g = y - ((cb * ycbcrFactors[1]) >> ycbcrShift) - ((cr * ycbcrFactors[2]) >> ycbcrShift);
-			i32 b = y + ((cb * ycbcrFactors[3]) >> ycbcrShift);
 
-			u8 rb = Math::clamp((r + colorBias) >> FixShift, 0, 255);
-			u8 gb = Math::clamp((g + colorBias) >> FixShift, 0, 255);
-			u8 bb = Math::clamp((b + colorBias) >> FixShift, 0, 255);
+void JPEGDecoder::advanceStream() {
 
-			targetSclData[0] = rb;
-			targetSclData[1] = gb;
-			targetSclData[2] = bb;
+	while (true) {
 
-			targetSclData += 3;
+		//Appending to the input might have moved it
+		reader = BinaryReader(stream.input, ByteOrder::Big);
+		reader.seekTo(stream.position);
 
-			for (u32 j = 0; j < 3; j++) {
-				imgData[j]++;
-			}
+		bool progress = stream.phase == StreamPhase::Scan ? streamScanRow() : streamSegment();
 
+		if (!progress) {
+			break;
 		}
 
-	#else
+		stream.position = reader.position();
 
-		SizeT lumaOffset = 0;
-		SizeT chromaBase = 0;
-		SizeT chromaOffset = 0;
-		SizeT chromaAdvance = S == Subsampling::Horizontal ? target.getWidth() : (target.getWidth() + 1) / 2;
+		//Everything up to the scan is kept since non-streamable images are decoded from the start
+		if (stream.phase == StreamPhase::Scan || stream.phase == StreamPhase::Trailer) {
 
-		for (u32 i = 0; i < target.getHeight(); i++) {
+			stream.input.erase(stream.input.begin(), stream.input.begin() + stream.position);
+			stream.position = 0;
 
-			for (u32 j = 0; j < target.getWidth(); j++) {
+		}
 
-				if constexpr (S == Subsampling::None) {
-					chromaOffset = lumaOffset;
-				} else if constexpr (S == Subsampling::Horizontal) {
-					chromaOffset = chromaBase + j;
-				} else {
-					chromaOffset = chromaBase + j / 2;
-				}
+		if (stream.phase == StreamPhase::Buffered || stream.phase == StreamPhase::Finished) {
+			break;
+		}
 
-				i32 y = imgData[0][lumaOffset++];
-				i32 cb = imgData[1][chromaOffset] - (128 << FixShift);
-				i32 cr = imgData[2][chromaOffset] - (128 << FixShift);
+	}
 
-				i32 r = y + ((cr * ycbcrFactors[0]) >> ycbcrShift);
-				i32 g = y - ((cb * ycbcrFactors[1]) >> ycbcrShift) - ((cr * ycbcrFactors[2]) >> ycbcrShift);
-				i32 b = y + ((cb * ycbcrFactors[3]) >> ycbcrShift);
+}
 
-				target.setPixel(j, i, PixelRGB8(Math::clamp((r + colorBias<FixShift>) >> FixShift, 0, 255), Math::clamp((g + colorBias<FixShift>) >> FixShift, 0, 255), Math::clamp((b + colorBias<FixShift>) >> FixShift, 0, 255)));
 
-			}
 
-			if constexpr (Bool::any(S, Subsampling::Horizontal, Subsampling::Both)) {
+bool JPEGDecoder::streamSegment() {
 
-				if (i & 1) {
-					chromaBase += chromaAdvance;
-				}
+	if (stream.phase == StreamPhase::Header && reader.position() == 0) {
+
+		if (reader.remainingSize() < 2) {
+			return false;
+		}
 
-			} else if constexpr (S == Subsampling::Vertical) {
+		if (reader.read<u16>() != Markers::SOI) {
+			throw ImageDecoderException("No SOI marker found");
+		}
 
-				chromaBase += chromaAdvance;
+		return true;
 
-			}
+	}
+
+	if (reader.remainingSize() < 2) {
+		return false;
+	}
+
+	u16 marker = reader.peek<u16>();
+
+	//Skip padding trailing the entropy coded data
+	if (stream.phase == StreamPhase::Trailer && (marker >> 8) != 0xFF) {
+
+		reader.seek(1);
+		return true;
+
+	}
 
+	if (marker == Markers::EOI) {
+
+		if (stream.phase == StreamPhase::Header) {
+			throw ImageDecoderException("No scan found");
 		}
 
-	#endif
+		reader.seek(2);
+		stream.phase = StreamPhase::Finished;
 
-		return target.makeRaw();
+		return true;
 
-	};
+	}
 
-	u32 ySamplesX = scan.scanComponents[0].frameComponent.samplesX;
-	u32 ySamplesY = scan.scanComponents[0].frameComponent.samplesY;
-	u32 cbSamplesX = scan.scanComponents[1].frameComponent.samplesX;
-	u32 cbSamplesY = scan.scanComponents[1].frameComponent.samplesY;
-	u32 crSamplesX = scan.scanComponents[2].frameComponent.samplesX;
-	u32 crSamplesY = scan.scanComponents[2].frameComponent.samplesY;
+	bool frameHeader = Math::inRange(marker, Markers::SOF0, Markers::SOF15) && marker != Markers::DHT && marker != Markers::DAC;
+	bool segment = frameHeader || Bool::any(marker, Markers::APP0, Markers::APP1, Markers::DQT, Markers::DHT, Markers::DAC, Markers::COM, Markers::DRI, Markers::SOS);
 
-	u32 yArea = ySamplesX * ySamplesY;
-	u32 cbArea = cbSamplesX * cbSamplesY;
-	u32 crArea = crSamplesX * crSamplesY;
+	//Segments are only parsed once they are complete
+	if (segment) {
 
-	if (Bool::all(yArea, cbArea, crArea, 1)) {
+		if (reader.remainingSize() < 4) {
+			return false;
+		}
 
-		//No chroma subsampling
-		return exec.template operator()<Subsampling::None>();
+		reader.seek(2);
+		u16 length = reader.peek<u16>();
+		reader.seek(-2);
 
-	} else if (Bool::all(ySamplesX, ySamplesY, 2) && Bool::all(cbArea, crArea, 1)) {
+		if (reader.remainingSize() < static_cast<SizeT>(length) + 2) {
+			return false;
+		}
 
-		//Symmetrical chroma subsampling
-		return exec.template operator()<Subsampling::Both>();
+	}
 
-	} else if (yArea == 2 && Bool::all(cbArea, crArea, 1)) {
+	//Frames with their height defined by DNL would require the whole scan to be present
+	if (frameHeader && stream.phase == StreamPhase::Header && reader.remainingSize() >= 7) {
 
-		if (ySamplesX == 1) {
+		reader.seek(5);
+		u16 lines = reader.peek<u16>();
+		reader.seek(-5);
 
-			//Horizontally asymmetric chroma subsampling (H > V)
-			return exec.template operator()<Subsampling::Horizontal>();
+		if (!lines) {
 
-		} else {
+			stream.phase = StreamPhase::Buffered;
+			return true;
 
-			//Vertically asymmetric chroma subsampling (H < V)
-			return exec.template operator()<Subsampling::Vertical>();
+		}
+
+	}
+
+	reader.seek(2);
 
+	if (marker == Markers::SOS) {
+
+		if (stream.phase == StreamPhase::Trailer) {
+			throw ImageDecoderException("Unexpected scan after the image data");
 		}
 
+		parseScanHeader();
+		resolveTargetFormat();
+		beginStreamScan();
+
 	} else {
 
-		//TODO: Generic upsampling
-		throw UnsupportedOperationException("Subsampling variant not implemented yet");
+		parseMarkerSegment(marker);
 
 	}
 
+	return true;
+
 }
 
 
-void JPEGDecoder::blendMonochrome() {
-	image = blendMonochromeCore<fixTransformShift>(scan);
+
+void JPEGDecoder::beginStreamScan() {
+
+	u32 componentCount = frame.components.size();
+
+	bool sequential = frame.type == FrameType::Sequential || frame.type == FrameType::ExtendedSequential;
+	bool streamable = sequential && frame.encoding == Encoding::Huffman && frame.bits == 8 && !frame.differential && scan.scanComponents.size() == componentCount && (componentCount == 1 || componentCount == 3);
+
+	//Blending expects the components in frame order
+	for (u32 i = 0; streamable && i < componentCount; i++) {
+		streamable = &scan.scanComponents[i].frameComponent == &frame.components[frame.componentOrder[i]];
+	}
+
+	//Images spread over multiple scans need all samples resident
+	if (!streamable) {
+
+		stream.phase = StreamPhase::Buffered;
+		return;
+
+	}
+
+	if (componentCount == 3) {
+
+		bool halfRows, halfColumns;
+		getChromaSubsampling(scan, halfRows, halfColumns);
+
+	}
+
+	//Every component keeps a window of one MCU row
+	for (ScanComponent& component : scan.scanComponents) {
+
+		FrameComponent& frameComponent = component.frameComponent;
+		u32 windowRows = (componentCount > 1 ? frameComponent.samplesY : 1) * frame.blockSize;
+
+		frameComponent.windowY = 0;
+		frameComponent.imageData.assign(SizeT(frameComponent.width) * windowRows, 0);
+
+	}
+
+	stream.mcuRow = 0;
+	stream.rowsPerMCU = (componentCount > 1 ? frame.maxSamplesY : 1) * frame.blockSize;
+	stream.rows.resize(SizeT(scan.scanComponents[0].frameComponent.width) * stream.rowsPerMCU * componentCount);
+	stream.phase = StreamPhase::Scan;
+
 }
 
 
 
-void JPEGDecoder::blendMonochromeTransformless() {
-	image = blendMonochromeCore<0>(scan);
+bool JPEGDecoder::streamScanRow() {
+
+	//Retrying only after the pending input has doubled bounds the work spent on incomplete rows. Input ending in EOI is likely complete.
+	SizeT inputSize = stream.input.size();
+	bool terminated = inputSize >= 2 && stream.input[inputSize - 2] == 0xFF && stream.input[inputSize - 1] == (Markers::EOI & 0xFF);
+
+	if (reader.remainingSize() < stream.retrySize && !terminated) {
+		return false;
+	}
+
+	u32 startMCU = stream.mcuRow * scan.mcusX;
+	u32 endMCU = Math::min(startMCU + scan.mcusX, scan.totalMCUs);
+
+	//Snapshot the decoder state to retry the row once more data has arrived
+	SizeT position = reader.position();
+	HuffmanDecoder decoderState = huffmanDecoder;
+	i32 predictions[4];
+
+	for (u32 i = 0; i < scan.scanComponents.size(); i++) {
+
+		ScanComponent& component = scan.scanComponents[i];
+		FrameComponent& frameComponent = component.frameComponent;
+
+		predictions[i] = component.prediction;
+		frameComponent.windowY = stream.mcuRow * (frameComponent.imageData.size() / frameComponent.width);
+
+	}
+
+	bool complete = true;
+
+	for (u32 mcu = startMCU; mcu < endMCU && complete; mcu++) {
+
+		bool restart = mcu == 0;
+
+		if (restartEnabled && mcu && mcu % restartInterval == 0) {
+
+			skipToRestartMarker();
+			restart = true;
+
+			if (huffmanDecoder.exhausted) {
+
+				complete = false;
+				break;
+
+			}
+
+		}
+
+		decodeImage(mcu, mcu + 1, huffmanDecoder, scan.scanComponents, restart);
+		complete = !huffmanDecoder.exhausted;
+
+	}
+
+	if (!complete) {
+
+		reader.seekTo(position);
+
+		huffmanDecoder.data = decoderState.data;
+		huffmanDecoder.size = decoderState.size;
+		huffmanDecoder.end = decoderState.end;
+		huffmanDecoder.exhausted = decoderState.exhausted;
+		huffmanDecoder.eobRun = decoderState.eobRun;
+
+		for (u32 i = 0; i < scan.scanComponents.size(); i++) {
+			scan.scanComponents[i].prediction = predictions[i];
+		}
+
+		stream.retrySize = reader.remainingSize() * 2;
+
+		return false;
+
+	}
+
+	stream.retrySize = 0;
+
+	u32 startRow = stream.mcuRow * stream.rowsPerMCU;
+	emitStreamRows(startRow, Math::min(startRow + stream.rowsPerMCU, scan.scanComponents[0].frameComponent.height));
+
+	if (++stream.mcuRow == scan.mcusY) {
+		stream.phase = StreamPhase::Trailer;
+	}
+
+	return true;
+
 }
 
 
 
-void JPEGDecoder::blendAndUpsampleYCbCr() {
-	image = blendAndUpsampleYCbCrCore<fixTransformShift>(scan);
+void JPEGDecoder::emitStreamRows(u32 startRow, u32 endRow) {
+
+	const FrameComponent& component = scan.scanComponents[0].frameComponent;
+	SizeT rowSize = SizeT(component.width) * scan.scanComponents.size();
+
+	blendRows(startRow, endRow, stream.rows.data());
+
+	RowBlock block {component.width, component.height, startRow, endRow - startRow, baseFormat, std::span<const u8>(stream.rows.data(), rowSize * (endRow - startRow))};
+	stream.callback(block);
+
 }
 
 
 
-void JPEGDecoder::blendAndUpsampleYCbCrTransformless() {
-	image = blendAndUpsampleYCbCrCore<0>(scan);
+void JPEGDecoder::finishBufferedStream() {
+
+	std::vector<u8> input = std::move(stream.input);
+	RowCallback callback = std::move(stream.callback);
+
+	decode(input);
+
+	//Emit the image in MCU row sized blocks, just like streamed images
+	u32 width = image.getWidth();
+	u32 height = image.getHeight();
+	u32 blockRows = frame.maxSamplesY * frame.blockSize;
+	SizeT rowSize = height ? image.getRawBuffer().size() / height : 0;
+
+	for (u32 row = 0; row < height; row += blockRows) {
+
+		u32 rowCount = Math::min(blockRows, height - row);
+
+		RowBlock block {width, height, row, rowCount, image.getFormat(), image.getRawBuffer().subspan(row * rowSize, rowCount * rowSize)};
+		callback(block);
+
+	}
+
+	stream.phase = StreamPhase::Finished;
+
 }
 
 
@@ -2894,6 +4201,7 @@ void JPEGDecoder::HuffmanDecoder::reset() {
 	EntropyDecoder::unblock();
 	data = 0;
 	size = 0;
+	eobRun = 0;
 
 }
 
@@ -3013,6 +4321,7 @@ std::optional<u8> JPEGDecoder::EntropyDecoder::fetchByte() {
 	if (!sink.remainingSize()) {
 
 		end = true;
+		exhausted = true;
 		return {};
 
 	}
@@ -3025,6 +4334,7 @@ std::optional<u8> JPEGDecoder::EntropyDecoder::fetchByte() {
 		if (!sink.remainingSize()) {
 
 			end = true;
+			exhausted = true;
 			return {};
 
 		}
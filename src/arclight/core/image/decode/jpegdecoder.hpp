@@ -17,34 +17,127 @@
 #include "time/profiler.hpp"
 #include "locale/unicodestring.hpp"
 
+#include <functional>
+
+
+
+class ThreadPool;
 
 class JPEGDecoder : public IImageDecoder {
 
 public:
 
-	explicit JPEGDecoder(std::optional<Pixel> reqFormat) : IImageDecoder(reqFormat), baseFormat(Pixel::RGB8), validDecode(false),
-		restartEnabled(false), huffmanDecoder(reader), arithmeticDecoder(reader), restartInterval(0) {}
+	/*
+		Rows emitted by the streaming decoder.
+		pixels holds rowCount tightly packed rows of width pixels in the given format, starting at firstRow.
+		The memory is reused for the next block of rows.
+	*/
+	struct RowBlock {
+
+		u32 width;
+		u32 height;
+		u32 firstRow;
+		u32 rowCount;
+		Pixel format;
+		std::span<const u8> pixels;
+
+	};
+
+	using RowCallback = std::function<void(const RowBlock&)>;
+
+	/*
+		Creates a JPEG decoder.
+		threadPool:	If set, restart intervals of sequential Huffman scans are decoded in parallel and blending is split into stripes.
+					The output is identical to the single-threaded decode.
+	*/
+	explicit JPEGDecoder(std::optional<Pixel> reqFormat, ThreadPool* threadPool = nullptr) : IImageDecoder(reqFormat), baseFormat(Pixel::RGB8), validDecode(false),
+		restartEnabled(false), huffmanDecoder(reader), arithmeticDecoder(reader), restartInterval(0), threadPool(threadPool), scanLimit(0), scanCount(0), scale(1), stream() {}
 
 	void decode(std::span<const u8> data);
 	RawImage& getImage();
 
+	/*
+		Stops decoding progressive images after the given number of scans and builds the image from the coefficients received so far.
+		Useful for thumbnails since the first scans usually carry the DC and low frequency bands. 0 decodes all scans.
+	*/
+	void setScanLimit(u32 scans);
+
+	//Returns the number of scans decoded by the last call to decode()
+	u32 getScanCount() const;
+
+	/*
+		Decodes the image downscaled by 1 / denominator, with denominator being 1, 2, 4 or 8.
+		Blocks are reconstructed by reduced-size IDCTs (4x4, 2x2 or DC only), which is much faster than decoding at full size and resizing.
+		Lossless images are always decoded at full size.
+	*/
+	void setScale(u32 denominator);
+
+
+	/*
+		Starts an incremental decode. Input is passed in arbitrarily sized chunks via feed().
+		Finished MCU rows are passed to callback as soon as their data has arrived.
+		Single-scan sequential Huffman images (i.e. baseline) only keep one MCU row of samples and the undecoded input resident,
+		so memory does not grow with the image height. All other images are buffered and decoded as a whole by endStream().
+		getImage() is only valid for buffered images.
+	*/
+	void beginStream(RowCallback callback);
+
+	//Appends data to the stream and emits all rows that can be completed. Returns true once the image has been decoded entirely.
+	bool feed(std::span<const u8> data);
+
+	//Signals the end of input. Throws an ImageDecoderException if the image is incomplete.
+	void endStream();
+
+	//Returns the number of input bytes currently held by the stream
+	SizeT getStreamInputSize() const;
+
+	//Returns the height of the largest component sample window held by the stream, 0 before the first scan
+	u32 getStreamWindowRows() const;
+
 private:
 
+	enum class StreamPhase {
+		Idle,
+		Header,
+		Scan,
+		Trailer,
+		Buffered,
+		Finished
+	};
+
+	struct StreamState {
+
+		StreamState() noexcept : phase(StreamPhase::Idle), position(0), retrySize(0), mcuRow(0), rowsPerMCU(0) {}
+
+		RowCallback callback;
+		StreamPhase phase;
+
+		std::vector<u8> input;
+		SizeT position;
+		SizeT retrySize;	//Input required before an incomplete row is attempted again
+
+		u32 mcuRow;
+		u32 rowsPerMCU;
+		std::vector<u8> rows;
+
+	};
+
 	struct EntropyDecoder {
 
-		constexpr explicit EntropyDecoder(BinaryReader& reader) : end(false), sink(reader) {}
+		constexpr explicit EntropyDecoder(BinaryReader& reader) : end(false), exhausted(false), sink(reader) {}
 
-		constexpr void unblock() noexcept { end = false; }
+		constexpr void unblock() noexcept { end = false; exhausted = false; }
 		std::optional<u8> fetchByte();
 
 		bool end;
+		bool exhausted;		//Set if the end of the data has been hit instead of a marker
 		BinaryReader& sink;
 
 	};
 
 	struct HuffmanDecoder : public EntropyDecoder {
 
-		constexpr explicit HuffmanDecoder(BinaryReader& reader) : EntropyDecoder(reader), data(0), size(0) {}
+		constexpr explicit HuffmanDecoder(BinaryReader& reader) : EntropyDecoder(reader), data(0), size(0), eobRun(0) {}
 
 		void reset();
 		JPEG::HuffmanResult decodeDC(const JPEG::HuffmanTable& table);
@@ -57,6 +150,7 @@ private:
 
 		u32 data;
 		i32 size;
+		u32 eobRun;
 
 	};
 
@@ -95,16 +189,24 @@ private:
 
 	void parseFrameHeader();
 	void parseScanHeader();
+	void parseMarkerSegment(u16 marker);
 
 	void searchForLineSegment();
 	void resolveTargetFormat();
 
 	void decodeScan();
+	void decodeScanParallel(SizeT scanEnd);
+	bool splitRestartIntervals(SizeT& scanEnd);
+	void skipToRestartMarker();
 	void decodeImage(u32 startMCU, u32 endMCU);
-	void decodeHuffmanBlock(JPEG::ScanComponent& component);
+	void decodeImage(u32 startMCU, u32 endMCU, HuffmanDecoder& decoder, std::span<JPEG::ScanComponent> components, bool restart = true);
+	void decodeHuffmanBlock(JPEG::ScanComponent& component, HuffmanDecoder& decoder);
 	void decodeArithmeticBlock(JPEG::ScanComponent& component);
-	void decodeProgressiveDCBlock(JPEG::ScanComponent& component);
-	void predictSample(JPEG::ScanComponent& component, u32 x, u32 y, u32 predictor);
+	void decodeProgressiveDCFirst(JPEG::ScanComponent& component, HuffmanDecoder& decoder, i16* coefficients);
+	void decodeProgressiveDCRefinement(HuffmanDecoder& decoder, i16* coefficients);
+	void decodeProgressiveACFirst(JPEG::ScanComponent& component, HuffmanDecoder& decoder, i16* coefficients);
+	void decodeProgressiveACRefinement(JPEG::ScanComponent& component, HuffmanDecoder& decoder, i16* coefficients);
+	void predictSample(JPEG::ScanComponent& component, HuffmanDecoder& decoder, u32 x, u32 y, u32 predictor);
 	i32 calculatePrediction(JPEG::ScanComponent& component, u32 x, u32 y, u32 predictor);
 	static i16 sampleComponent(JPEG::ScanComponent& component, u32 x, u32 y);
 
@@ -112,12 +214,25 @@ private:
 
 	static void applyIDCT(JPEG::ScanComponent& component, SizeT imageBase);
 	static void applyPartialIDCT(JPEG::ScanComponent& component, SizeT imageBase, u32 width, u32 height);
+	static void applyReducedIDCT(JPEG::ScanComponent& component, SizeT imageBase, u32 size, u32 width, u32 height);
+	void transformBlock(JPEG::ScanComponent& component, SizeT imageBase, u32 width, u32 height);
+
+	void collectFrameComponents();
+	void transformProgressiveComponents();
 
 	void blendAndUpsample();
 	void blendMonochrome();
 	void blendMonochromeTransformless();
 	void blendAndUpsampleYCbCr();
 	void blendAndUpsampleYCbCrTransformless();
+	void blendRows(u32 startRow, u32 endRow, u8* target);
+
+	void advanceStream();
+	bool streamSegment();
+	bool streamScanRow();
+	void beginStreamScan();
+	void emitStreamRows(u32 startRow, u32 endRow);
+	void finishBufferedStream();
 
 	u16 verifySegmentLength();
 
@@ -141,6 +256,15 @@ private:
 	HuffmanDecoder huffmanDecoder;
 	ArithmeticDecoder arithmeticDecoder;
 
+	ThreadPool* threadPool;
+	std::vector<std::span<const u8>> restartSegments;
+
+	u32 scanLimit;
+	u32 scanCount;
+	u32 scale;
+
+	StreamState stream;
+
 	RawImage image;
 
 };
\ No newline at end of file
@@ -0,0 +1,170 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 png.hpp
+ */
+
+#pragma once
+
+#include "types.hpp"
+
+#include <array>
+#include <span>
+
+
+
+namespace PNG {
+
+	constexpr u64 Signature = 0x89504E470D0A1A0A;
+
+	namespace Chunks {
+
+		constexpr u32 IHDR = 0x49484452;
+		constexpr u32 PLTE = 0x504C5445;
+		constexpr u32 IDAT = 0x49444154;
+		constexpr u32 IEND = 0x49454E44;
+		constexpr u32 tRNS = 0x74524E53;
+
+		//Chunks with a lowercase first letter may be skipped by decoders
+		constexpr bool isCritical(u32 type) {
+			return !(type & 0x20000000);
+		}
+
+	};
+
+	enum class ColorType : u8 {
+		Grayscale = 0,
+		RGB = 2,
+		Palette = 3,
+		GrayscaleAlpha = 4,
+		RGBA = 6
+	};
+
+	enum class FilterType : u8 {
+		None,
+		Sub,
+		Up,
+		Average,
+		Paeth
+	};
+
+	struct Header {
+
+		constexpr Header() : width(0), height(0), bitDepth(0), colorType(ColorType::Grayscale), interlaced(false) {}
+
+		u32 width;
+		u32 height;
+		u8 bitDepth;
+		ColorType colorType;
+		bool interlaced;
+
+	};
+
+	constexpr u32 channelCount(ColorType type) {
+
+		switch (type) {
+
+			case ColorType::Grayscale:
+			case ColorType::Palette:
+				return 1;
+
+			case ColorType::GrayscaleAlpha:
+				return 2;
+
+			case ColorType::RGB:
+				return 3;
+
+			case ColorType::RGBA:
+				return 4;
+
+		}
+
+		return 0;
+
+	}
+
+	//Adam7 passes, each sampling every stepX-th pixel of every stepY-th row starting at (startX, startY)
+	struct InterlacePass {
+
+		u32 startX;
+		u32 startY;
+		u32 stepX;
+		u32 stepY;
+
+	};
+
+	constexpr InterlacePass interlacePasses[7] = {
+		{0, 0, 8, 8},
+		{4, 0, 8, 8},
+		{0, 4, 4, 8},
+		{2, 0, 4, 4},
+		{0, 2, 2, 4},
+		{1, 0, 2, 2},
+		{0, 1, 1, 2}
+	};
+
+
+	/*
+		CRC-32 as used by PNG chunks (reflected, polynomial 0xEDB88320).
+		Slicing-by-8: Eight tables allow for one lookup per input byte without a serial dependency between them.
+	*/
+	constexpr std::array<std::array<u32, 256>, 8> crcTables = []() {
+
+		std::array<std::array<u32, 256>, 8> t {};
+
+		for (u32 i = 0; i < 256; i++) {
+
+			u32 c = i;
+
+			for (u32 k = 0; k < 8; k++) {
+				c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+			}
+
+			t[0][i] = c;
+
+		}
+
+		for (u32 i = 0; i < 256; i++) {
+
+			for (u32 k = 1; k < 8; k++) {
+				t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+			}
+
+		}
+
+		return t;
+
+	}();
+
+	//Continues the CRC of previous data, starting with 0 for new data
+	inline u32 crc32(std::span<const u8> data, u32 crc = 0) {
+
+		const u8* p = data.data();
+		SizeT size = data.size();
+
+		crc = ~crc;
+
+		while (size >= 8) {
+
+			u32 lo = crc ^ (p[0] | p[1] << 8 | p[2] << 16 | u32(p[3]) << 24);
+			u32 hi = p[4] | p[5] << 8 | p[6] << 16 | u32(p[7]) << 24;
+
+			crc = crcTables[7][lo & 0xFF] ^ crcTables[6][(lo >> 8) & 0xFF] ^ crcTables[5][(lo >> 16) & 0xFF] ^ crcTables[4][lo >> 24] ^
+				  crcTables[3][hi & 0xFF] ^ crcTables[2][(hi >> 8) & 0xFF] ^ crcTables[1][(hi >> 16) & 0xFF] ^ crcTables[0][hi >> 24];
+
+			p += 8;
+			size -= 8;
+
+		}
+
+		while (size--) {
+			crc = crcTables[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+		}
+
+		return ~crc;
+
+	}
+
+}
\ No newline at end of file
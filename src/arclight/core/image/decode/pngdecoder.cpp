@@ -0,0 +1,1044 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 pngdecoder.cpp
+ */
+
+#include "pngdecoder.hpp"
+#include "arcintrinsic.hpp"
+#include "math/math.hpp"
+#include "util/cpuid.hpp"
+
+#include <cstring>
+
+
+
+using UnfilterFunction = void(*)(u8* row, const u8* prior, SizeT size, u32 bpp);
+
+using PNG::ColorType;
+
+
+
+static void unfilterSubScalar(u8* row, const u8*, SizeT size, u32 bpp) {
+
+	for (SizeT i = bpp; i < size; i++) {
+		row[i] += row[i - bpp];
+	}
+
+}
+
+
+
+static void unfilterUpScalar(u8* row, const u8* prior, SizeT size, u32) {
+
+	for (SizeT i = 0; i < size; i++) {
+		row[i] += prior[i];
+	}
+
+}
+
+
+
+static void unfilterAverageScalar(u8* row, const u8* prior, SizeT size, u32 bpp) {
+
+	for (SizeT i = 0; i < bpp; i++) {
+		row[i] += prior[i] >> 1;
+	}
+
+	for (SizeT i = bpp; i < size; i++) {
+		row[i] += (row[i - bpp] + prior[i]) >> 1;
+	}
+
+}
+
+
+
+static void unfilterPaethScalar(u8* row, const u8* prior, SizeT size, u32 bpp) {
+
+	//Without a left neighbor, the predictor always picks the upper sample
+	for (SizeT i = 0; i < bpp; i++) {
+		row[i] += prior[i];
+	}
+
+	for (SizeT i = bpp; i < size; i++) {
+
+		i32 a = row[i - bpp];
+		i32 b = prior[i];
+		i32 c = prior[i - bpp];
+
+		i32 pa = Math::abs(b - c);
+		i32 pb = Math::abs(a - c);
+		i32 pc = Math::abs(a + b - c - c);
+
+		if (pa <= pb && pa <= pc) {
+			row[i] += a;
+		} else if (pb <= pc) {
+			row[i] += b;
+		} else {
+			row[i] += c;
+		}
+
+	}
+
+}
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+/*
+	Sub, Average and Paeth depend on the reconstructed pixel to the left, so a vector holds a single pixel.
+	This still removes the per-byte branches of the predictors. Only the common 3 and 4 byte pixels are vectorized.
+*/
+template<u32 Bpp>
+ARC_TARGET("sse2") ARC_FORCE_INLINE static __m128i loadPixelSSE2(const u8* p, SizeT remaining) {
+
+	//Whole words avoid assembling 3 byte pixels on the stack. The fourth byte belongs to the next pixel and is never stored.
+	if (Bpp == 4 || remaining >= 4) {
+
+		u32 v;
+		std::memcpy(&v, p, 4);
+
+		return _mm_cvtsi32_si128(v);
+
+	}
+
+	u32 v = 0;
+	std::memcpy(&v, p, Bpp);
+
+	return _mm_cvtsi32_si128(v);
+
+}
+
+
+
+template<u32 Bpp>
+ARC_TARGET("sse2") ARC_FORCE_INLINE static void storePixelSSE2(u8* p, __m128i x) {
+
+	u32 v = _mm_cvtsi128_si32(x);
+	std::memcpy(p, &v, Bpp);
+
+}
+
+
+
+template<u32 Bpp>
+ARC_TARGET("sse2") static void unfilterSubSSE2(u8* row, SizeT size) {
+
+	__m128i a = _mm_setzero_si128();
+
+	for (SizeT i = 0; i < size; i += Bpp) {
+
+		__m128i d = _mm_add_epi8(loadPixelSSE2<Bpp>(row + i, size - i), a);
+		storePixelSSE2<Bpp>(row + i, d);
+		a = d;
+
+	}
+
+}
+
+
+
+template<u32 Bpp>
+ARC_TARGET("sse2") static void unfilterAverageSSE2(u8* row, const u8* prior, SizeT size) {
+
+	__m128i a = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+
+	for (SizeT i = 0; i < size; i += Bpp) {
+
+		__m128i b = loadPixelSSE2<Bpp>(prior + i, size - i);
+
+		//pavgb rounds up, the correction subtracts the carry of odd sums
+		__m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+		__m128i d = _mm_add_epi8(loadPixelSSE2<Bpp>(row + i, size - i), avg);
+
+		storePixelSSE2<Bpp>(row + i, d);
+		a = d;
+
+	}
+
+}
+
+
+
+ARC_TARGET("sse2") ARC_FORCE_INLINE static __m128i select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+
+
+ARC_TARGET("sse2") ARC_FORCE_INLINE static __m128i abs16(__m128i x) {
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+
+
+template<u32 Bpp>
+ARC_TARGET("sse2") static void unfilterPaethSSE2(u8* row, const u8* prior, SizeT size) {
+
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i a = zero;
+	__m128i c = zero;
+
+	for (SizeT i = 0; i < size; i += Bpp) {
+
+		__m128i b = _mm_unpacklo_epi8(loadPixelSSE2<Bpp>(prior + i, size - i), zero);
+
+		//p - a = b - c, p - b = a - c, p - c = (a - c) + (b - c)
+		__m128i pa = _mm_sub_epi16(b, c);
+		__m128i pb = _mm_sub_epi16(a, c);
+		__m128i pc = _mm_add_epi16(pa, pb);
+
+		pa = abs16(pa);
+		pb = abs16(pb);
+		pc = abs16(pc);
+
+		//Ties prefer a over b over c
+		__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+		__m128i predictor = select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+		__m128i d = _mm_add_epi8(loadPixelSSE2<Bpp>(row + i, size - i), _mm_packus_epi16(predictor, predictor));
+		storePixelSSE2<Bpp>(row + i, d);
+
+		a = _mm_unpacklo_epi8(d, zero);
+		c = b;
+
+	}
+
+}
+
+
+
+ARC_TARGET("sse2") static void unfilterSubDispatchSSE2(u8* row, const u8* prior, SizeT size, u32 bpp) {
+
+	switch (bpp) {
+
+		case 3:
+			unfilterSubSSE2<3>(row, size);
+			break;
+
+		case 4:
+			unfilterSubSSE2<4>(row, size);
+			break;
+
+		default:
+			unfilterSubScalar(row, prior, size, bpp);
+			break;
+
+	}
+
+}
+
+
+
+ARC_TARGET("sse2") static void unfilterAverageDispatchSSE2(u8* row, const u8* prior, SizeT size, u32 bpp) {
+
+	switch (bpp) {
+
+		case 3:
+			unfilterAverageSSE2<3>(row, prior, size);
+			break;
+
+		case 4:
+			unfilterAverageSSE2<4>(row, prior, size);
+			break;
+
+		default:
+			unfilterAverageScalar(row, prior, size, bpp);
+			break;
+
+	}
+
+}
+
+
+
+ARC_TARGET("sse2") static void unfilterPaethDispatchSSE2(u8* row, const u8* prior, SizeT size, u32 bpp) {
+
+	switch (bpp) {
+
+		case 3:
+			unfilterPaethSSE2<3>(row, prior, size);
+			break;
+
+		case 4:
+			unfilterPaethSSE2<4>(row, prior, size);
+			break;
+
+		default:
+			unfilterPaethScalar(row, prior, size, bpp);
+			break;
+
+	}
+
+}
+
+
+
+ARC_TARGET("sse2") static void unfilterUpSSE2(u8* row, const u8* prior, SizeT size, u32 bpp) {
+
+	SizeT i = 0;
+
+	for (; i + 16 <= size; i += 16) {
+
+		__m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i));
+		__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), _mm_add_epi8(r, p));
+
+	}
+
+	unfilterUpScalar(row + i, prior + i, size - i, bpp);
+
+}
+
+
+
+ARC_TARGET("avx2") static void unfilterUpAVX2(u8* row, const u8* prior, SizeT size, u32 bpp) {
+
+	SizeT i = 0;
+
+	for (; i + 32 <= size; i += 32) {
+
+		__m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(row + i));
+		__m256i p = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(prior + i));
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(row + i), _mm256_add_epi8(r, p));
+
+	}
+
+	unfilterUpScalar(row + i, prior + i, size - i, bpp);
+
+}
+
+#endif
+
+
+
+struct UnfilterKernels {
+
+	UnfilterFunction sub;
+	UnfilterFunction up;
+	UnfilterFunction average;
+	UnfilterFunction paeth;
+
+};
+
+
+
+static const UnfilterKernels& kernels() {
+
+	static const UnfilterKernels table = []() {
+
+		UnfilterKernels k = {
+			unfilterSubScalar,
+			unfilterUpScalar,
+			unfilterAverageScalar,
+			unfilterPaethScalar
+		};
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::SSE2)) {
+
+			k.sub = unfilterSubDispatchSSE2;
+			k.up = unfilterUpSSE2;
+			k.average = unfilterAverageDispatchSSE2;
+			k.paeth = unfilterPaethDispatchSSE2;
+
+		}
+
+		if (CPUID::hasFeature(CPUFeature::AVX2)) {
+			k.up = unfilterUpAVX2;
+		}
+
+#endif
+
+		return k;
+
+	}();
+
+	return table;
+
+}
+
+
+
+//Writes a pixel with 8-bit channels into any target format
+template<Pixel P>
+ARC_FORCE_INLINE static void storePixel(u8* target, u8 r, u8 g, u8 b, u8 a) {
+
+	using Format = PixelFormat<P>;
+
+	if constexpr (Bits::popcount(Format::RedMask) == 8) {
+
+		target[Format::RedShift / 8] = r;
+
+		if constexpr (Format::GreenMask) {
+			target[Format::GreenShift / 8] = g;
+		}
+
+		if constexpr (Format::BlueMask) {
+			target[Format::BlueShift / 8] = b;
+		}
+
+		if constexpr (Format::AlphaMask) {
+			target[Format::AlphaShift / 8] = a;
+		}
+
+	} else {
+
+		auto packed = PixelConverter::convert<P>(PixelRGBA8(r, g, b, a)).pack();
+
+		for (u32 i = 0; i < Format::BytesPerPixel; i++) {
+			target[i] = packed >> (i * 8);
+		}
+
+	}
+
+}
+
+
+
+//Extracts the x-th sample of a row with less than 8 bits per sample
+ARC_FORCE_INLINE static u32 packedSample(const u8* source, u32 x, u32 bitDepth) {
+
+	u32 bit = x * bitDepth;
+	return (source[bit / 8] >> (8 - bitDepth - bit % 8)) & ((1 << bitDepth) - 1);
+
+}
+
+
+
+void PNGDecoder::decode(std::span<const u8> data) {
+
+	validDecode = false;
+
+	reader = BinaryReader(data, ByteOrder::Big);
+
+	header = PNG::Header();
+	paletteSize = 0;
+	transparency = false;
+	transparentColor = {};
+	compressedData.clear();
+
+	for (u32 i = 0; i < 256; i++) {
+
+		palette[i * 4 + 0] = 0;
+		palette[i * 4 + 1] = 0;
+		palette[i * 4 + 2] = 0;
+		palette[i * 4 + 3] = 255;
+
+	}
+
+	if (reader.remainingSize() < 8 || reader.read<u64>() != PNG::Signature) {
+		throw ImageDecoderException("PNG signature doesn't match");
+	}
+
+	bool headerFound = false;
+	bool endFound = false;
+	bool dataFinished = false;
+	u32 dataChunkCount = 0;
+
+	std::span<const u8> firstDataChunk;
+
+	while (!endFound) {
+
+		if (reader.remainingSize() < 12) {
+			throw ImageDecoderException("PNG stream size too small");
+		}
+
+		u32 length = reader.read<u32>();
+		const u8* typeStart = reader.head();
+		u32 type = reader.read<u32>();
+
+		if (length > 0x7FFFFFFF || reader.remainingSize() < SizeT(length) + 4) {
+			throw ImageDecoderException("PNG chunk exceeds the stream size");
+		}
+
+		std::span<const u8> chunk(reader.head(), length);
+		reader.seek(length);
+
+		u32 crc = reader.read<u32>();
+
+		//The CRC covers both chunk type and data
+		if (PNG::crc32({typeStart, SizeT(length) + 4}) != crc) {
+			throw ImageDecoderException("PNG chunk CRC mismatch");
+		}
+
+		if (!headerFound && type != PNG::Chunks::IHDR) {
+			throw ImageDecoderException("PNG stream doesn't start with a header chunk");
+		}
+
+		if (dataChunkCount && type != PNG::Chunks::IDAT) {
+			dataFinished = true;
+		}
+
+		switch (type) {
+
+			case PNG::Chunks::IHDR:
+
+				if (headerFound) {
+					throw ImageDecoderException("Duplicate PNG header chunk");
+				}
+
+				parseHeader(chunk);
+				headerFound = true;
+
+				break;
+
+			case PNG::Chunks::PLTE:
+				parsePalette(chunk);
+				break;
+
+			case PNG::Chunks::tRNS:
+				parseTransparency(chunk);
+				break;
+
+			case PNG::Chunks::IDAT:
+
+				if (dataFinished) {
+					throw ImageDecoderException("PNG data chunks must be consecutive");
+				}
+
+				//The zlib stream is only copied if it is split across multiple chunks
+				if (!dataChunkCount) {
+
+					firstDataChunk = chunk;
+
+				} else {
+
+					if (dataChunkCount == 1) {
+						compressedData.assign(firstDataChunk.begin(), firstDataChunk.end());
+					}
+
+					compressedData.insert(compressedData.end(), chunk.begin(), chunk.end());
+
+				}
+
+				dataChunkCount++;
+
+				break;
+
+			case PNG::Chunks::IEND:
+				endFound = true;
+				break;
+
+			default:
+
+				if (PNG::Chunks::isCritical(type)) {
+					throw UnsupportedOperationException("Unknown critical PNG chunk");
+				}
+
+				break;
+
+		}
+
+	}
+
+	if (!dataChunkCount) {
+		throw ImageDecoderException("PNG stream contains no image data");
+	}
+
+	if (header.colorType == ColorType::Palette && !paletteSize) {
+		throw ImageDecoderException("PNG palette missing");
+	}
+
+	filteredSize = 0;
+
+	if (header.interlaced) {
+
+		for (const PNG::InterlacePass& pass : PNG::interlacePasses) {
+
+			u32 passWidth = header.width > pass.startX ? (header.width - pass.startX + pass.stepX - 1) / pass.stepX : 0;
+			u32 passHeight = header.height > pass.startY ? (header.height - pass.startY + pass.stepY - 1) / pass.stepY : 0;
+
+			//Empty passes don't contain filter bytes
+			if (passWidth && passHeight) {
+				filteredSize += passHeight * (getRowSize(passWidth) + 1);
+			}
+
+		}
+
+	} else {
+
+		filteredSize = header.height * (getRowSize(header.width) + 1);
+
+	}
+
+	//Deflate cannot expand data by more than ~1032:1, reject bogus dimensions before allocating
+	SizeT compressedSize = dataChunkCount > 1 ? compressedData.size() : firstDataChunk.size();
+
+	if (filteredSize / 1032 > compressedSize) {
+		throw ImageDecoderException("PNG image data too small for image dimensions");
+	}
+
+	filteredData = std::make_unique_for_overwrite<u8[]>(filteredSize);
+
+	inflater.inflate(dataChunkCount > 1 ? std::span<const u8>(compressedData) : firstDataChunk, {filteredData.get(), filteredSize});
+
+	switch (resolveTargetFormat()) {
+
+		case Pixel::Grayscale8:	reconstructImage<Pixel::Grayscale8>();	break;
+		case Pixel::BGR5:		reconstructImage<Pixel::BGR5>();		break;
+		case Pixel::RGB5:		reconstructImage<Pixel::RGB5>();		break;
+		case Pixel::BGR8:		reconstructImage<Pixel::BGR8>();		break;
+		case Pixel::RGB8:		reconstructImage<Pixel::RGB8>();		break;
+		case Pixel::RGBA8:		reconstructImage<Pixel::RGBA8>();		break;
+		case Pixel::ABGR8:		reconstructImage<Pixel::ABGR8>();		break;
+		case Pixel::BGRA8:		reconstructImage<Pixel::BGRA8>();		break;
+		case Pixel::ARGB8:		reconstructImage<Pixel::ARGB8>();		break;
+
+	}
+
+	filteredData.reset();
+	validDecode = true;
+
+}
+
+
+
+RawImage& PNGDecoder::getImage() {
+
+	if (!validDecode) {
+		throw ImageDecoderException("Bad image decode");
+	}
+
+	return image;
+
+}
+
+
+
+void PNGDecoder::parseHeader(std::span<const u8> chunk) {
+
+	if (chunk.size() != 13) {
+		throw ImageDecoderException("Bad PNG header size");
+	}
+
+	BinaryReader headerReader(chunk, ByteOrder::Big);
+
+	header.width = headerReader.read<u32>();
+	header.height = headerReader.read<u32>();
+	header.bitDepth = headerReader.read<u8>();
+	header.colorType = static_cast<ColorType>(headerReader.read<u8>());
+
+	u8 compression = headerReader.read<u8>();
+	u8 filter = headerReader.read<u8>();
+	u8 interlace = headerReader.read<u8>();
+
+	if (!header.width || !header.height || header.width > 0x7FFFFFFF || header.height > 0x7FFFFFFF) {
+		throw ImageDecoderException("Bad PNG image size");
+	}
+
+	bool validDepth = false;
+	u8 depth = header.bitDepth;
+
+	switch (header.colorType) {
+
+		case ColorType::Grayscale:
+			validDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8 || depth == 16;
+			break;
+
+		case ColorType::Palette:
+			validDepth = depth == 1 || depth == 2 || depth == 4 || depth == 8;
+			break;
+
+		case ColorType::RGB:
+		case ColorType::GrayscaleAlpha:
+		case ColorType::RGBA:
+			validDepth = depth == 8 || depth == 16;
+			break;
+
+		default:
+			throw ImageDecoderException("Bad PNG color type");
+
+	}
+
+	if (!validDepth) {
+		throw ImageDecoderException("Bad PNG bit depth");
+	}
+
+	if (compression || filter || interlace > 1) {
+		throw ImageDecoderException("Bad PNG compression, filter or interlace method");
+	}
+
+	header.interlaced = interlace;
+
+}
+
+
+
+void PNGDecoder::parsePalette(std::span<const u8> chunk) {
+
+	if (chunk.size() % 3 || chunk.empty() || chunk.size() > 256 * 3) {
+		throw ImageDecoderException("Bad PNG palette size");
+	}
+
+	//Palettes of truecolor images are suggestions for quantization only
+	if (header.colorType != ColorType::Palette) {
+		return;
+	}
+
+	paletteSize = chunk.size() / 3;
+
+	for (u32 i = 0; i < paletteSize; i++) {
+
+		palette[i * 4 + 0] = chunk[i * 3 + 0];
+		palette[i * 4 + 1] = chunk[i * 3 + 1];
+		palette[i * 4 + 2] = chunk[i * 3 + 2];
+
+	}
+
+}
+
+
+
+void PNGDecoder::parseTransparency(std::span<const u8> chunk) {
+
+	switch (header.colorType) {
+
+		case ColorType::Palette:
+
+			if (chunk.size() > paletteSize) {
+				throw ImageDecoderException("PNG transparency exceeds the palette size");
+			}
+
+			for (u32 i = 0; i < chunk.size(); i++) {
+				palette[i * 4 + 3] = chunk[i];
+			}
+
+			break;
+
+		case ColorType::Grayscale:
+
+			if (chunk.size() != 2) {
+				throw ImageDecoderException("Bad PNG transparency size");
+			}
+
+			transparentColor[0] = chunk[0] << 8 | chunk[1];
+			break;
+
+		case ColorType::RGB:
+
+			if (chunk.size() != 6) {
+				throw ImageDecoderException("Bad PNG transparency size");
+			}
+
+			for (u32 i = 0; i < 3; i++) {
+				transparentColor[i] = chunk[i * 2] << 8 | chunk[i * 2 + 1];
+			}
+
+			break;
+
+		default:
+			//Images with an alpha channel must not carry transparency
+			return;
+
+	}
+
+	transparency = true;
+
+}
+
+
+
+Pixel PNGDecoder::resolveTargetFormat() const {
+
+	if (!autoDetectFormat()) {
+		return requestedFormat.value();
+	}
+
+	switch (header.colorType) {
+
+		case ColorType::Grayscale:
+			return transparency ? Pixel::RGBA8 : Pixel::Grayscale8;
+
+		case ColorType::RGB:
+		case ColorType::Palette:
+			return transparency ? Pixel::RGBA8 : Pixel::RGB8;
+
+		default:
+			return Pixel::RGBA8;
+
+	}
+
+}
+
+
+
+SizeT PNGDecoder::getRowSize(u32 width) const {
+	return (SizeT(width) * PNG::channelCount(header.colorType) * header.bitDepth + 7) / 8;
+}
+
+
+
+void PNGDecoder::unfilterRow(u8 filter, u8* row, const u8* prior, SizeT size) const {
+
+	//Filters operate on bytes, with the left neighbor being the corresponding byte of the previous pixel
+	u32 bpp = Math::max((PNG::channelCount(header.colorType) * header.bitDepth) / 8, 1u);
+
+	switch (static_cast<PNG::FilterType>(filter)) {
+
+		case PNG::FilterType::None:
+			break;
+
+		case PNG::FilterType::Sub:
+			kernels().sub(row, prior, size, bpp);
+			break;
+
+		case PNG::FilterType::Up:
+			kernels().up(row, prior, size, bpp);
+			break;
+
+		case PNG::FilterType::Average:
+			kernels().average(row, prior, size, bpp);
+			break;
+
+		case PNG::FilterType::Paeth:
+			kernels().paeth(row, prior, size, bpp);
+			break;
+
+		default:
+			throw ImageDecoderException("Bad PNG filter type");
+
+	}
+
+}
+
+
+
+template<Pixel P>
+void PNGDecoder::reconstructImage() {
+
+	constexpr u32 BytesPerPixel = PixelFormat<P>::BytesPerPixel;
+
+	Image<P> target(header.width, header.height);
+	u8* targetData = reinterpret_cast<u8*>(target.getImageBuffer().data());
+
+	u8* data = filteredData.get();
+
+	//Rows are converted right after unfiltering while they are still cached
+	auto reconstructPass = [&](u32 width, u32 height, auto&& emitRow) {
+
+		SizeT rowSize = getRowSize(width);
+		std::vector<u8> emptyRow(rowSize);
+
+		const u8* prior = emptyRow.data();
+
+		for (u32 y = 0; y < height; y++) {
+
+			u8* row = data + 1;
+
+			unfilterRow(data[0], row, prior, rowSize);
+			emitRow(y, row);
+
+			prior = row;
+			data += rowSize + 1;
+
+		}
+
+	};
+
+	if (!header.interlaced) {
+
+		reconstructPass(header.width, header.height, [&](u32 y, const u8* row) {
+			convertRow<P>(row, targetData + SizeT(y) * header.width * BytesPerPixel, header.width);
+		});
+
+	} else {
+
+		std::vector<u8> passRow(header.width * BytesPerPixel);
+
+		for (const PNG::InterlacePass& pass : PNG::interlacePasses) {
+
+			u32 passWidth = header.width > pass.startX ? (header.width - pass.startX + pass.stepX - 1) / pass.stepX : 0;
+			u32 passHeight = header.height > pass.startY ? (header.height - pass.startY + pass.stepY - 1) / pass.stepY : 0;
+
+			if (!passWidth || !passHeight) {
+				continue;
+			}
+
+			reconstructPass(passWidth, passHeight, [&](u32 y, const u8* row) {
+
+				convertRow<P>(row, passRow.data(), passWidth);
+
+				u8* targetRow = targetData + ((pass.startY + SizeT(y) * pass.stepY) * header.width + pass.startX) * BytesPerPixel;
+
+				for (u32 x = 0; x < passWidth; x++) {
+					std::memcpy(targetRow + SizeT(x) * pass.stepX * BytesPerPixel, passRow.data() + x * BytesPerPixel, BytesPerPixel);
+				}
+
+			});
+
+		}
+
+	}
+
+	image = target.makeRaw();
+
+}
+
+
+
+template<Pixel P>
+void PNGDecoder::convertRow(const u8* source, u8* target, u32 width) const {
+
+	constexpr u32 BytesPerPixel = PixelFormat<P>::BytesPerPixel;
+
+	u32 depth = header.bitDepth;
+
+	switch (header.colorType) {
+
+		case ColorType::Grayscale:
+
+			if (depth == 8) {
+
+				if constexpr (P == Pixel::Grayscale8) {
+
+					if (!transparency) {
+
+						std::memcpy(target, source, width);
+						return;
+
+					}
+
+				}
+
+				for (u32 x = 0; x < width; x++) {
+
+					u8 g = source[x];
+					storePixel<P>(target + x * BytesPerPixel, g, g, g, transparency && g == transparentColor[0] ? 0 : 255);
+
+				}
+
+			} else if (depth == 16) {
+
+				for (u32 x = 0; x < width; x++) {
+
+					u8 g = source[x * 2];
+					u16 sample = g << 8 | source[x * 2 + 1];
+
+					storePixel<P>(target + x * BytesPerPixel, g, g, g, transparency && sample == transparentColor[0] ? 0 : 255);
+
+				}
+
+			} else {
+
+				//Scales the sample range to 0-255
+				u32 scale = 255 / ((1 << depth) - 1);
+
+				for (u32 x = 0; x < width; x++) {
+
+					u32 sample = packedSample(source, x, depth);
+					u8 g = sample * scale;
+
+					storePixel<P>(target + x * BytesPerPixel, g, g, g, transparency && sample == transparentColor[0] ? 0 : 255);
+
+				}
+
+			}
+
+			break;
+
+		case ColorType::RGB:
+
+			if (depth == 8) {
+
+				if constexpr (P == Pixel::RGB8) {
+
+					if (!transparency) {
+
+						std::memcpy(target, source, SizeT(width) * 3);
+						return;
+
+					}
+
+				}
+
+				for (u32 x = 0; x < width; x++) {
+
+					const u8* s = source + x * 3;
+					bool transparent = transparency && s[0] == transparentColor[0] && s[1] == transparentColor[1] && s[2] == transparentColor[2];
+
+					storePixel<P>(target + x * BytesPerPixel, s[0], s[1], s[2], transparent ? 0 : 255);
+
+				}
+
+			} else {
+
+				for (u32 x = 0; x < width; x++) {
+
+					const u8* s = source + x * 6;
+					bool transparent = transparency && (s[0] << 8 | s[1]) == transparentColor[0] && (s[2] << 8 | s[3]) == transparentColor[1] && (s[4] << 8 | s[5]) == transparentColor[2];
+
+					storePixel<P>(target + x * BytesPerPixel, s[0], s[2], s[4], transparent ? 0 : 255);
+
+				}
+
+			}
+
+			break;
+
+		case ColorType::Palette:
+
+			for (u32 x = 0; x < width; x++) {
+
+				const u8* entry = &palette[(depth == 8 ? source[x] : packedSample(source, x, depth)) * 4];
+				storePixel<P>(target + x * BytesPerPixel, entry[0], entry[1], entry[2], entry[3]);
+
+			}
+
+			break;
+
+		case ColorType::GrayscaleAlpha:
+			{
+				u32 stride = depth / 4;
+
+				for (u32 x = 0; x < width; x++) {
+
+					const u8* s = source + x * stride;
+					storePixel<P>(target + x * BytesPerPixel, s[0], s[0], s[0], s[stride / 2]);
+
+				}
+			}
+			break;
+
+		case ColorType::RGBA:
+
+			if (depth == 8) {
+
+				if constexpr (P == Pixel::RGBA8) {
+
+					std::memcpy(target, source, SizeT(width) * 4);
+					return;
+
+				}
+
+				for (u32 x = 0; x < width; x++) {
+
+					const u8* s = source + x * 4;
+					storePixel<P>(target + x * BytesPerPixel, s[0], s[1], s[2], s[3]);
+
+				}
+
+			} else {
+
+				for (u32 x = 0; x < width; x++) {
+
+					const u8* s = source + x * 8;
+					storePixel<P>(target + x * BytesPerPixel, s[0], s[2], s[4], s[6]);
+
+				}
+
+			}
+
+			break;
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 pngdecoder.hpp
+ */
+
+#pragma once
+
+#include "decoder.hpp"
+#include "inflate.hpp"
+#include "png.hpp"
+#include "image/image.hpp"
+#include "stream/binaryreader.hpp"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+
+
+class PNGDecoder : public IImageDecoder {
+
+public:
+
+	/*
+		Decodes PNG images of all standard color types and bit depths, interlaced or not.
+		Samples are written straight into the requested format, otherwise Grayscale8, RGB8 or RGBA8 are chosen depending on the presence of alpha.
+		16-bit samples are reduced to 8 bits.
+	*/
+	explicit PNGDecoder(std::optional<Pixel> reqFormat) : IImageDecoder(reqFormat), paletteSize(0), transparency(false), filteredSize(0), validDecode(false) {}
+
+	void decode(std::span<const u8> data);
+	RawImage& getImage();
+
+private:
+
+	void parseHeader(std::span<const u8> chunk);
+	void parsePalette(std::span<const u8> chunk);
+	void parseTransparency(std::span<const u8> chunk);
+
+	Pixel resolveTargetFormat() const;
+	SizeT getRowSize(u32 width) const;
+
+	void unfilterRow(u8 filter, u8* row, const u8* prior, SizeT size) const;
+
+	template<Pixel P>
+	void reconstructImage();
+
+	template<Pixel P>
+	void convertRow(const u8* source, u8* target, u32 width) const;
+
+	BinaryReader reader;
+	Inflater inflater;
+
+	PNG::Header header;
+
+	//RGBA palette entries, unused entries stay opaque black
+	std::array<u8, 256 * 4> palette;
+	u32 paletteSize;
+
+	//Transparent color key of grayscale and RGB images, compared against the full precision samples
+	bool transparency;
+	std::array<u16, 3> transparentColor;
+
+	std::vector<u8> compressedData;
+	std::unique_ptr<u8[]> filteredData;
+	SizeT filteredSize;
+
+	RawImage image;
+	bool validDecode;
+
+};
\ No newline at end of file
@@ -0,0 +1,101 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 zlib.hpp
+ */
+
+#pragma once
+
+#include "math/math.hpp"
+#include "types.hpp"
+
+#include <span>
+
+
+
+namespace Zlib {
+
+	constexpr u32 WindowSize = 32768;
+	constexpr u32 MinMatchLength = 3;
+	constexpr u32 MaxMatchLength = 258;
+
+	constexpr u32 EndOfBlock = 256;
+	constexpr u32 LiteralCodes = 286;
+	constexpr u32 DistanceCodes = 30;
+	constexpr u32 CodeLengthCodes = 19;
+	constexpr u32 MaxCodeLength = 15;
+	constexpr u32 MaxCodeLengthCodeLength = 7;
+
+	constexpr u16 lengthBase[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+
+	constexpr u8 lengthExtra[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+
+	constexpr u16 distanceBase[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+	};
+
+	constexpr u8 distanceExtra[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+
+	constexpr u8 codeLengthOrder[19] = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+	};
+
+
+	constexpr u32 adlerModulus = 65521;
+	constexpr u32 adlerBlockSize = 5552;		//Largest block size that cannot overflow the 32-bit sums
+
+	//Continues the checksum of previous data, starting with 1 for new data
+	inline u32 adler32(std::span<const u8> data, u32 adler = 1) {
+
+		u32 a = adler & 0xFFFF;
+		u32 b = adler >> 16;
+
+		const u8* p = data.data();
+		SizeT size = data.size();
+
+		while (size) {
+
+			SizeT blockSize = Math::min(size, SizeT(adlerBlockSize));
+			size -= blockSize;
+
+			while (blockSize >= 8) {
+
+				a += p[0]; b += a;
+				a += p[1]; b += a;
+				a += p[2]; b += a;
+				a += p[3]; b += a;
+				a += p[4]; b += a;
+				a += p[5]; b += a;
+				a += p[6]; b += a;
+				a += p[7]; b += a;
+
+				p += 8;
+				blockSize -= 8;
+
+			}
+
+			while (blockSize--) {
+
+				a += *p++;
+				b += a;
+
+			}
+
+			a %= adlerModulus;
+			b %= adlerModulus;
+
+		}
+
+		return b << 16 | a;
+
+	}
+
+}
\ No newline at end of file
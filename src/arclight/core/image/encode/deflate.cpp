@@ -0,0 +1,972 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 deflate.cpp
+ */
+
+#include "deflate.hpp"
+#include "encoder.hpp"
+#include "image/decode/zlib.hpp"
+#include "arcintrinsic.hpp"
+#include "math/math.hpp"
+#include "util/bits.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+
+
+constexpr static u32 WindowMask = Zlib::WindowSize - 1;
+constexpr static u32 MatchFlag = 0x80000000;
+
+//Length symbol (minus 257) of every match length minus 3
+constexpr static std::array<u8, 256> lengthCodes = []() {
+
+	std::array<u8, 256> a {};
+
+	for (u32 c = 0; c < 29; c++) {
+
+		u32 end = c < 28 ? Zlib::lengthBase[c + 1] : Zlib::MaxMatchLength + 1;
+
+		for (u32 l = Zlib::lengthBase[c]; l < end; l++) {
+			a[l - 3] = c;
+		}
+
+	}
+
+	return a;
+
+}();
+
+//Distance symbol of every distance minus 1, indexed directly below 256 and by the upper bits above
+constexpr static std::array<u8, 512> distanceCodes = []() {
+
+	std::array<u8, 512> a {};
+
+	for (u32 c = 0; c < 30; c++) {
+
+		for (u32 d = Zlib::distanceBase[c] - 1; d < Zlib::distanceBase[c] - 1 + (1u << Zlib::distanceExtra[c]); d++) {
+
+			if (d < 256) {
+				a[d] = c;
+			} else {
+				a[256 + (d >> 7)] = c;
+			}
+
+		}
+
+	}
+
+	return a;
+
+}();
+
+constexpr static std::array<u8, 288> fixedLiteralLengths = []() {
+
+	std::array<u8, 288> a {};
+
+	for (u32 i = 0; i < 288; i++) {
+		a[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+	}
+
+	return a;
+
+}();
+
+constexpr static std::array<u8, 30> fixedDistanceLengths = []() {
+
+	std::array<u8, 30> a {};
+	a.fill(5);
+
+	return a;
+
+}();
+
+
+
+ARC_FORCE_INLINE static u32 distanceCode(u32 distance) {
+	return distance < 256 ? distanceCodes[distance] : distanceCodes[256 + (distance >> 7)];
+}
+
+
+
+ARC_FORCE_INLINE static u32 load32(const u8* p) {
+
+	u32 v;
+	std::memcpy(&v, p, 4);
+
+	return v;
+
+}
+
+
+
+ARC_FORCE_INLINE static u32 hash(const u8* p, u32 bits) {
+	return (load32(p) * 0x9E3779B1) >> (32 - bits);
+}
+
+
+
+ARC_FORCE_INLINE static u32 matchLength(const u8* match, const u8* current, u32 maxLength) {
+
+	u32 length = 0;
+
+	while (length + 8 <= maxLength) {
+
+		u64 a, b;
+		std::memcpy(&a, match + length, 8);
+		std::memcpy(&b, current + length, 8);
+
+		u64 difference = Bits::little64(a ^ b);
+
+		if (difference) {
+			return length + Bits::ctz(difference) / 8;
+		}
+
+		length += 8;
+
+	}
+
+	while (length < maxLength && match[length] == current[length]) {
+		length++;
+	}
+
+	return length;
+
+}
+
+
+
+/*
+	Computes length-limited Huffman code lengths.
+	Optimal lengths are derived with the two-queue method over the frequency-sorted leaves. Lengths exceeding the limit are
+	clamped and the resulting oversubscription is repaid by pushing shorter codes one level down, as done by most deflate encoders.
+*/
+static void buildCodeLengths(const u32* frequencies, u32 count, u32 maxLength, u8* lengths) {
+
+	std::array<u32, 288> order;
+	u32 n = 0;
+
+	for (u32 i = 0; i < count; i++) {
+
+		lengths[i] = 0;
+
+		if (frequencies[i]) {
+			order[n++] = i;
+		}
+
+	}
+
+	if (n == 0) {
+		return;
+	}
+
+	//A single code is padded with a dummy to keep the code complete
+	if (n == 1) {
+
+		lengths[order[0]] = 1;
+		lengths[order[0] == 0 ? 1 : 0] = 1;
+
+		return;
+
+	}
+
+	std::sort(order.begin(), order.begin() + n, [frequencies](u32 a, u32 b) {
+		return frequencies[a] < frequencies[b] || (frequencies[a] == frequencies[b] && a < b);
+	});
+
+	std::array<u32, 576> weight;
+	std::array<u32, 576> parent;
+
+	for (u32 i = 0; i < n; i++) {
+		weight[i] = frequencies[order[i]];
+	}
+
+	u32 leaf = 0;
+	u32 node = n;
+
+	for (u32 next = n; next < 2 * n - 1; next++) {
+
+		u32 sum = 0;
+
+		for (u32 k = 0; k < 2; k++) {
+
+			if (leaf < n && (node >= next || weight[leaf] <= weight[node])) {
+
+				parent[leaf] = next;
+				sum += weight[leaf++];
+
+			} else {
+
+				parent[node] = next;
+				sum += weight[node++];
+
+			}
+
+		}
+
+		weight[next] = sum;
+
+	}
+
+	//Node depths overwrite the weights, parents always come after their children
+	weight[2 * n - 2] = 0;
+
+	for (u32 i = 2 * n - 2; i-- > 0;) {
+		weight[i] = weight[parent[i]] + 1;
+	}
+
+	std::array<u32, 16> lengthCounts {};
+
+	for (u32 i = 0; i < n; i++) {
+		lengthCounts[Math::min(weight[i], maxLength)]++;
+	}
+
+	u32 total = 0;
+
+	for (u32 l = maxLength; l > 0; l--) {
+		total += lengthCounts[l] << (maxLength - l);
+	}
+
+	while (total != (1u << maxLength)) {
+
+		lengthCounts[maxLength]--;
+
+		for (u32 l = maxLength - 1; l > 0; l--) {
+
+			if (lengthCounts[l]) {
+
+				lengthCounts[l]--;
+				lengthCounts[l + 1] += 2;
+				break;
+
+			}
+
+		}
+
+		total--;
+
+	}
+
+	//The least frequent symbols receive the longest codes
+	u32 i = 0;
+
+	for (u32 l = maxLength; l > 0; l--) {
+
+		for (u32 c = lengthCounts[l]; c > 0; c--) {
+			lengths[order[i++]] = l;
+		}
+
+	}
+
+}
+
+
+
+//Assigns canonical codes, bit-reversed for LSB-first output
+static void buildCodes(const u8* lengths, u32 count, u16* codes) {
+
+	std::array<u32, 16> lengthCounts {};
+	std::array<u32, 16> nextCode {};
+
+	for (u32 i = 0; i < count; i++) {
+		lengthCounts[lengths[i]]++;
+	}
+
+	lengthCounts[0] = 0;
+
+	u32 code = 0;
+
+	for (u32 l = 1; l < 16; l++) {
+
+		code = (code + lengthCounts[l - 1]) << 1;
+		nextCode[l] = code;
+
+	}
+
+	for (u32 i = 0; i < count; i++) {
+
+		u32 length = lengths[i];
+
+		if (length) {
+			codes[i] = Bits::reverse<u16>(nextCode[length]++) >> (16 - length);
+		}
+
+	}
+
+}
+
+
+
+Deflater::Deflater(Level level) : head(1 << HashBits), prev(Zlib::WindowSize), literalFrequencies(Zlib::LiteralCodes), distanceFrequencies(Zlib::DistanceCodes),
+	blockStart(0), output(nullptr), outputPosition(0), bitBuffer(0), bitCount(0) {
+
+	setLevel(level);
+	symbols.reserve(BlockSymbols);
+
+}
+
+
+
+void Deflater::setLevel(Level level) {
+
+	this->level = level;
+
+	switch (level) {
+
+		default:
+		case Level::Store:
+		case Level::Fast:
+			parameters = {4, 32, 0, false};
+			break;
+
+		case Level::Default:
+			parameters = {32, 128, 32, true};
+			break;
+
+		case Level::Best:
+			parameters = {1024, Zlib::MaxMatchLength, Zlib::MaxMatchLength, true};
+			break;
+
+	}
+
+}
+
+
+
+Deflater::Level Deflater::getLevel() const {
+	return level;
+}
+
+
+
+void Deflater::deflate(std::span<const u8> input, std::vector<u8>& out) {
+
+	if (input.size() >= 0xFFFFFFFF - Zlib::MaxMatchLength) {
+		throw ImageEncoderException("Deflate input too large");
+	}
+
+	output = &out;
+	outputPosition = out.size();
+	bitBuffer = 0;
+	bitCount = 0;
+
+	//CMF announces a 32K window, FLEVEL the compression level and FCHECK makes the header a multiple of 31
+	u32 header = 0x7800 | u32(level) << 6;
+	header += (31 - header % 31) % 31;
+
+	ensureCapacity(16);
+	putBits(header >> 8, 8);
+	putBits(header & 0xFF, 8);
+	flushBits();
+
+	if (level == Level::Store) {
+		compressStored(input);
+	} else {
+		compressMatches(input);
+	}
+
+	alignToByte();
+
+	out.resize(outputPosition);
+
+	u32 adler = Zlib::adler32(input);
+
+	out.push_back(adler >> 24);
+	out.push_back(adler >> 16);
+	out.push_back(adler >> 8);
+	out.push_back(adler);
+
+	output = nullptr;
+
+}
+
+
+
+void Deflater::compressStored(std::span<const u8> input) {
+
+	ensureCapacity((input.size() / 65535 + 1) * 48 + input.size() * 8);
+	writeStoredBlocks(input.data(), input.size(), true);
+
+}
+
+
+
+void Deflater::compressMatches(std::span<const u8> input) {
+
+	const u8* base = input.data();
+	u32 end = input.size();
+
+	std::fill(head.begin(), head.end(), 0);
+	std::fill(literalFrequencies.begin(), literalFrequencies.end(), 0);
+	std::fill(distanceFrequencies.begin(), distanceFrequencies.end(), 0);
+	symbols.clear();
+	blockStart = 0;
+
+	u32 pos = 0;
+
+	auto insertRange = [&](u32 start, u32 stop) {
+
+		if (parameters.insertAll) {
+
+			stop = Math::min(stop, end >= 3 ? end - 3 : 0);
+
+			for (u32 p = start; p < stop; p++) {
+				insert(base, p);
+			}
+
+		}
+
+	};
+
+	if (!parameters.lazyLength) {
+
+		while (pos < end) {
+
+			u32 available = end - pos;
+			u32 length = 0;
+			u32 distance = 0;
+
+			if (available >= 4) {
+
+				length = findMatch(base, pos, available, 0, distance);
+				insert(base, pos);
+
+			}
+
+			if (length) {
+
+				addMatch(length, distance);
+				insertRange(pos + 1, pos + length);
+				pos += length;
+
+			} else {
+
+				addLiteral(base[pos]);
+				pos++;
+
+			}
+
+			if (symbols.size() >= BlockSymbols) {
+
+				flushBlock(base + blockStart, pos - blockStart, false);
+				blockStart = pos;
+
+			}
+
+		}
+
+	} else {
+
+		//The decision for the byte at pos - 1 is deferred until the match at pos is known
+		u32 prevLength = 0;
+		u32 prevDistance = 0;
+		bool pending = false;
+
+		while (pos < end) {
+
+			u32 available = end - pos;
+			u32 length = 0;
+			u32 distance = 0;
+
+			if (available >= 4) {
+
+				if (prevLength < parameters.lazyLength) {
+					length = findMatch(base, pos, available, prevLength, distance);
+				}
+
+				insert(base, pos);
+
+			}
+
+			if (!pending) {
+
+				pending = true;
+				prevLength = length;
+				prevDistance = distance;
+				pos++;
+				continue;
+
+			}
+
+			if (prevLength && !length) {
+
+				addMatch(prevLength, prevDistance);
+				insertRange(pos + 1, pos - 1 + prevLength);
+
+				pos += prevLength - 1;
+				prevLength = 0;
+				pending = false;
+
+			} else {
+
+				addLiteral(base[pos - 1]);
+
+				prevLength = length;
+				prevDistance = distance;
+				pos++;
+
+			}
+
+			if (symbols.size() >= BlockSymbols) {
+
+				u32 covered = pending ? pos - 1 : pos;
+
+				flushBlock(base + blockStart, covered - blockStart, false);
+				blockStart = covered;
+
+			}
+
+		}
+
+		if (pending) {
+
+			if (prevLength) {
+				addMatch(prevLength, prevDistance);
+			} else {
+				addLiteral(base[pos - 1]);
+			}
+
+		}
+
+	}
+
+	flushBlock(base + blockStart, end - blockStart, true);
+
+}
+
+
+
+ARC_FORCE_INLINE void Deflater::insert(const u8* base, u32 position) {
+
+	u32& entry = head[hash(base + position, HashBits)];
+
+	prev[position & WindowMask] = entry;
+	entry = position + 1;
+
+}
+
+
+
+/*
+	Returns the length of the longest match exceeding prevLength, or 0 if there is none.
+	Chain entries hold positions + 1, positions are always searched before being inserted.
+*/
+ARC_FORCE_INLINE u32 Deflater::findMatch(const u8* base, u32 position, u32 available, u32 prevLength, u32& distance) const {
+
+	u32 maxLength = Math::min(available, Zlib::MaxMatchLength);
+	u32 best = Math::max(prevLength, Zlib::MinMatchLength);
+
+	if (best >= maxLength) {
+		return 0;
+	}
+
+	const u8* current = base + position;
+	u32 currentPrefix = load32(current);
+
+	u32 candidate = head[hash(current, HashBits)];
+	u32 chain = parameters.maxChain;
+	u32 found = 0;
+
+	while (candidate && chain--) {
+
+		u32 matchPosition = candidate - 1;
+		u32 matchDistance = position - matchPosition;
+
+		if (matchDistance > Zlib::WindowSize) {
+			break;
+		}
+
+		const u8* match = base + matchPosition;
+
+		if (match[best] == current[best] && load32(match) == currentPrefix) {
+
+			u32 length = matchLength(match, current, maxLength);
+
+			if (length > best) {
+
+				best = length;
+				found = length;
+				distance = matchDistance;
+
+				if (length >= parameters.niceLength || length == maxLength) {
+					break;
+				}
+
+			}
+
+		}
+
+		candidate = prev[matchPosition & WindowMask];
+
+	}
+
+	return found;
+
+}
+
+
+
+ARC_FORCE_INLINE void Deflater::addLiteral(u8 literal) {
+
+	symbols.push_back(literal);
+	literalFrequencies[literal]++;
+
+}
+
+
+
+ARC_FORCE_INLINE void Deflater::addMatch(u32 length, u32 distance) {
+
+	symbols.push_back(MatchFlag | (length - 3) << 16 | (distance - 1));
+	literalFrequencies[257 + lengthCodes[length - 3]]++;
+	distanceFrequencies[distanceCode(distance - 1)]++;
+
+}
+
+
+
+void Deflater::flushBlock(const u8* blockData, SizeT blockSize, bool final) {
+
+	literalFrequencies[Zlib::EndOfBlock] = 1;
+
+	std::array<u8, Zlib::LiteralCodes> literalLengths;
+	std::array<u8, Zlib::DistanceCodes> distanceLengths;
+
+	buildCodeLengths(literalFrequencies.data(), Zlib::LiteralCodes, Zlib::MaxCodeLength, literalLengths.data());
+	buildCodeLengths(distanceFrequencies.data(), Zlib::DistanceCodes, Zlib::MaxCodeLength, distanceLengths.data());
+
+	//Extra bits are the same for both Huffman variants
+	SizeT extraBits = 0;
+
+	for (u32 i = 0; i < 29; i++) {
+		extraBits += SizeT(literalFrequencies[257 + i]) * Zlib::lengthExtra[i];
+	}
+
+	for (u32 i = 0; i < Zlib::DistanceCodes; i++) {
+		extraBits += SizeT(distanceFrequencies[i]) * Zlib::distanceExtra[i];
+	}
+
+	auto dataBits = [&](const u8* literalCodeLengths, const u8* distanceCodeLengths) {
+
+		SizeT bits = extraBits;
+
+		for (u32 i = 0; i < Zlib::LiteralCodes; i++) {
+			bits += SizeT(literalFrequencies[i]) * literalCodeLengths[i];
+		}
+
+		for (u32 i = 0; i < Zlib::DistanceCodes; i++) {
+			bits += SizeT(distanceFrequencies[i]) * distanceCodeLengths[i];
+		}
+
+		return bits;
+
+	};
+
+	DynamicHeader header;
+
+	SizeT dynamicBits = 3 + buildDynamicHeader(literalLengths.data(), distanceLengths.data(), header) + dataBits(literalLengths.data(), distanceLengths.data());
+	SizeT fixedBits = 3 + dataBits(fixedLiteralLengths.data(), fixedDistanceLengths.data());
+	SizeT storedBits = (blockSize / 65535 + 1) * 48 + blockSize * 8;
+
+	if (storedBits <= fixedBits && storedBits <= dynamicBits) {
+
+		ensureCapacity(storedBits);
+		writeStoredBlocks(blockData, blockSize, final);
+
+	} else if (fixedBits <= dynamicBits) {
+
+		ensureCapacity(fixedBits);
+		writeHuffmanBlock(fixedLiteralLengths.data(), fixedDistanceLengths.data(), final, nullptr);
+
+	} else {
+
+		ensureCapacity(dynamicBits);
+		writeHuffmanBlock(literalLengths.data(), distanceLengths.data(), final, &header);
+
+	}
+
+	symbols.clear();
+	std::fill(literalFrequencies.begin(), literalFrequencies.end(), 0);
+	std::fill(distanceFrequencies.begin(), distanceFrequencies.end(), 0);
+
+}
+
+
+
+void Deflater::writeStoredBlocks(const u8* data, SizeT size, bool final) {
+
+	do {
+
+		u32 chunk = Math::min(size, SizeT(65535));
+		bool last = final && chunk == size;
+
+		putBits(last, 1);
+		putBits(0, 2);
+		alignToByte();
+
+		u8* out = output->data() + outputPosition;
+
+		out[0] = chunk;
+		out[1] = chunk >> 8;
+		out[2] = ~chunk;
+		out[3] = ~chunk >> 8;
+
+		if (chunk) {
+			std::memcpy(out + 4, data, chunk);
+		}
+
+		outputPosition += chunk + 4;
+		data += chunk;
+		size -= chunk;
+
+	} while (size);
+
+}
+
+
+
+/*
+	Run-length codes both code length sequences as one and builds the code length code.
+	Returns the size of the header in bits.
+*/
+SizeT Deflater::buildDynamicHeader(const u8* literalLengths, const u8* distanceLengths, DynamicHeader& header) {
+
+	constexpr u8 runExtraBits[3] = {2, 3, 7};
+
+	u32 literalCount = Zlib::LiteralCodes;
+	u32 distanceCount = Zlib::DistanceCodes;
+
+	while (literalCount > 257 && !literalLengths[literalCount - 1]) {
+		literalCount--;
+	}
+
+	while (distanceCount > 1 && !distanceLengths[distanceCount - 1]) {
+		distanceCount--;
+	}
+
+	std::array<u8, Zlib::LiteralCodes + Zlib::DistanceCodes> combined;
+	std::copy_n(literalLengths, literalCount, combined.begin());
+	std::copy_n(distanceLengths, distanceCount, combined.begin() + literalCount);
+
+	u32 combinedCount = literalCount + distanceCount;
+
+	std::array<u32, Zlib::CodeLengthCodes> runFrequencies {};
+	u32 runCount = 0;
+
+	auto addRun = [&](u32 symbol, u32 extra) {
+
+		header.runs[runCount++] = symbol | extra << 8;
+		runFrequencies[symbol]++;
+
+	};
+
+	for (u32 i = 0; i < combinedCount;) {
+
+		u8 length = combined[i];
+		u32 run = 1;
+
+		while (i + run < combinedCount && combined[i + run] == length) {
+			run++;
+		}
+
+		i += run;
+
+		if (!length) {
+
+			while (run >= 11) {
+
+				u32 r = Math::min(run, 138u);
+				addRun(18, r - 11);
+				run -= r;
+
+			}
+
+			if (run >= 3) {
+
+				addRun(17, run - 3);
+				run = 0;
+
+			}
+
+		} else {
+
+			//Repeats refer to the previous length, which has to be emitted once first
+			addRun(length, 0);
+			run--;
+
+			while (run >= 3) {
+
+				u32 r = Math::min(run, 6u);
+				addRun(16, r - 3);
+				run -= r;
+
+			}
+
+		}
+
+		while (run--) {
+			addRun(length, 0);
+		}
+
+	}
+
+	buildCodeLengths(runFrequencies.data(), Zlib::CodeLengthCodes, Zlib::MaxCodeLengthCodeLength, header.runLengths.data());
+	buildCodes(header.runLengths.data(), Zlib::CodeLengthCodes, header.runCodes.data());
+
+	u32 runLengthCount = Zlib::CodeLengthCodes;
+
+	while (runLengthCount > 4 && !header.runLengths[Zlib::codeLengthOrder[runLengthCount - 1]]) {
+		runLengthCount--;
+	}
+
+	header.literalCount = literalCount;
+	header.distanceCount = distanceCount;
+	header.runLengthCount = runLengthCount;
+	header.runCount = runCount;
+
+	SizeT bits = 14 + runLengthCount * 3;
+
+	for (u32 i = 0; i < Zlib::CodeLengthCodes; i++) {
+		bits += SizeT(runFrequencies[i]) * (header.runLengths[i] + (i >= 16 ? runExtraBits[i - 16] : 0));
+	}
+
+	return bits;
+
+}
+
+
+
+void Deflater::writeHuffmanBlock(const u8* literalLengths, const u8* distanceLengths, bool final, const DynamicHeader* header) {
+
+	constexpr u8 runExtraBits[3] = {2, 3, 7};
+
+	std::array<u16, 288> literalCodes;
+	std::array<u16, 30> distanceCodesTable;
+
+	putBits(final, 1);
+	putBits(header ? 2 : 1, 2);
+
+	if (header) {
+
+		putBits(header->literalCount - 257, 5);
+		putBits(header->distanceCount - 1, 5);
+		putBits(header->runLengthCount - 4, 4);
+		flushBits();
+
+		for (u32 i = 0; i < header->runLengthCount; i++) {
+
+			putBits(header->runLengths[Zlib::codeLengthOrder[i]], 3);
+			flushBits();
+
+		}
+
+		for (u32 i = 0; i < header->runCount; i++) {
+
+			u32 symbol = header->runs[i] & 0xFF;
+
+			putBits(header->runCodes[symbol], header->runLengths[symbol]);
+
+			if (symbol >= 16) {
+				putBits(header->runs[i] >> 8, runExtraBits[symbol - 16]);
+			}
+
+			flushBits();
+
+		}
+
+		buildCodes(literalLengths, header->literalCount, literalCodes.data());
+		buildCodes(distanceLengths, header->distanceCount, distanceCodesTable.data());
+
+	} else {
+
+		buildCodes(literalLengths, 288, literalCodes.data());
+		buildCodes(distanceLengths, Zlib::DistanceCodes, distanceCodesTable.data());
+
+	}
+
+	for (u32 symbol : symbols) {
+
+		if (!(symbol & MatchFlag)) {
+
+			putBits(literalCodes[symbol], literalLengths[symbol]);
+
+		} else {
+
+			u32 length = (symbol >> 16) & 0xFF;
+			u32 distance = symbol & 0x7FFF;
+			u32 lengthCode = lengthCodes[length];
+			u32 distCode = distanceCode(distance);
+
+			putBits(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+			putBits(length + 3 - Zlib::lengthBase[lengthCode], Zlib::lengthExtra[lengthCode]);
+			putBits(distanceCodesTable[distCode], distanceLengths[distCode]);
+			putBits(distance + 1 - Zlib::distanceBase[distCode], Zlib::distanceExtra[distCode]);
+
+		}
+
+		flushBits();
+
+	}
+
+	putBits(literalCodes[Zlib::EndOfBlock], literalLengths[Zlib::EndOfBlock]);
+	flushBits();
+
+}
+
+
+
+//Makes room for the given number of bits plus slack for the 8-byte stores of flushBits
+void Deflater::ensureCapacity(SizeT bits) {
+
+	SizeT required = outputPosition + bits / 8 + 16;
+
+	if (output->size() < required) {
+		output->resize(Math::max(required, output->size() + output->size() / 2));
+	}
+
+}
+
+
+
+ARC_FORCE_INLINE void Deflater::putBits(u32 value, u32 count) {
+
+	bitBuffer |= u64(value) << bitCount;
+	bitCount += count;
+
+}
+
+
+
+//Writes all complete bytes, at most 63 bits may be pending
+ARC_FORCE_INLINE void Deflater::flushBits() {
+
+	u64 data = Bits::little64(bitBuffer);
+	std::memcpy(output->data() + outputPosition, &data, 8);
+
+	u32 bytes = bitCount >> 3;
+
+	outputPosition += bytes;
+	bitBuffer = bytes == 8 ? 0 : bitBuffer >> (bytes * 8);
+	bitCount &= 7;
+
+}
+
+
+
+void Deflater::alignToByte() {
+
+	flushBits();
+
+	if (bitCount) {
+
+		(*output)[outputPosition++] = bitBuffer;
+		bitBuffer = 0;
+		bitCount = 0;
+
+	}
+
+}
\ No newline at end of file
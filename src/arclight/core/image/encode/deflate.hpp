@@ -0,0 +1,111 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 deflate.hpp
+ */
+
+#pragma once
+
+#include "types.hpp"
+
+#include <array>
+#include <span>
+#include <vector>
+
+
+
+/*
+	Deflater
+	Compresses data into a zlib stream (RFC 1950/1951).
+	Matches are found through hash chains over 4-byte prefixes, the level controls chain depth and lazy matching.
+	Symbols are collected per block and emitted with whichever of dynamic Huffman, fixed Huffman or stored coding is smallest.
+	Tables are kept between calls to avoid reallocations when compressing multiple streams.
+*/
+class Deflater {
+
+public:
+
+	enum class Level {
+		Store,		//No compression, stored blocks only
+		Fast,		//Shallow greedy search
+		Default,	//Moderate search with lazy matching
+		Best		//Exhaustive search
+	};
+
+	explicit Deflater(Level level = Level::Default);
+
+	void setLevel(Level level);
+	Level getLevel() const;
+
+	//Appends the compressed stream to output
+	void deflate(std::span<const u8> input, std::vector<u8>& output);
+
+private:
+
+	struct SearchParameters {
+
+		u32 maxChain;		//Chain entries examined per search
+		u32 niceLength;		//Searching stops at matches of this length
+		u32 lazyLength;		//Matches shorter than this are compared against the match at the next position, 0 for greedy parsing
+		bool insertAll;		//Inserts every position covered by a match into the hash chains
+
+	};
+
+	//Run-length coded code lengths of a dynamic block
+	struct DynamicHeader {
+
+		u32 literalCount;
+		u32 distanceCount;
+		u32 runLengthCount;
+		u32 runCount;
+
+		//Symbol in the lower, extra bits in the upper byte
+		std::array<u16, 316> runs;
+		std::array<u8, 19> runLengths;
+		std::array<u16, 19> runCodes;
+
+	};
+
+	constexpr static u32 HashBits = 15;
+	constexpr static u32 BlockSymbols = 1 << 15;
+
+	void compressStored(std::span<const u8> input);
+	void compressMatches(std::span<const u8> input);
+
+	void insert(const u8* base, u32 position);
+	u32 findMatch(const u8* base, u32 position, u32 available, u32 prevLength, u32& distance) const;
+
+	void addLiteral(u8 literal);
+	void addMatch(u32 length, u32 distance);
+	void flushBlock(const u8* blockData, SizeT blockSize, bool final);
+
+	void writeStoredBlocks(const u8* data, SizeT size, bool final);
+	void writeHuffmanBlock(const u8* literalLengths, const u8* distanceLengths, bool final, const DynamicHeader* header);
+
+	static SizeT buildDynamicHeader(const u8* literalLengths, const u8* distanceLengths, DynamicHeader& header);
+
+	void ensureCapacity(SizeT bits);
+	void putBits(u32 value, u32 count);
+	void flushBits();
+	void alignToByte();
+
+	Level level;
+	SearchParameters parameters;
+
+	std::vector<u32> head;
+	std::vector<u32> prev;
+
+	//Literals are stored directly, matches as 0x80000000 | (length - 3) << 16 | (distance - 1)
+	std::vector<u32> symbols;
+	std::vector<u32> literalFrequencies;
+	std::vector<u32> distanceFrequencies;
+	SizeT blockStart;
+
+	std::vector<u8>* output;
+	SizeT outputPosition;
+	u64 bitBuffer;
+	u32 bitCount;
+
+};
\ No newline at end of file
@@ -0,0 +1,833 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 jpegencoder.cpp
+ */
+
+#include "jpegencoder.hpp"
+#include "image/decode/jpeg.hpp"
+#include "arcintrinsic.hpp"
+#include "math/math.hpp"
+#include "util/bits.hpp"
+#include "util/cpuid.hpp"
+
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+
+
+using FDCTFunction = void(*)(const float* samples, SizeT stride, const float* scales, i16* block);
+
+struct HuffmanSpecification {
+
+	u8 counts[16];
+	u8 values[162];
+
+};
+
+struct HuffmanEncoding {
+
+	std::array<u16, 256> codes;
+	std::array<u8, 256> lengths;
+
+};
+
+
+
+constexpr static u8 luminanceQuantization[64] = {
+	16, 11, 10, 16,  24,  40,  51,  61,
+	12, 12, 14, 19,  26,  58,  60,  55,
+	14, 13, 16, 24,  40,  57,  69,  56,
+	14, 17, 22, 29,  51,  87,  80,  62,
+	18, 22, 37, 56,  68, 109, 103,  77,
+	24, 35, 55, 64,  81, 104, 113,  92,
+	49, 64, 78, 87, 103, 121, 120, 101,
+	72, 92, 95, 98, 112, 100, 103,  99
+};
+
+constexpr static u8 chrominanceQuantization[64] = {
+	17, 18, 24, 47, 99, 99, 99, 99,
+	18, 21, 26, 66, 99, 99, 99, 99,
+	24, 26, 56, 99, 99, 99, 99, 99,
+	47, 66, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99,
+	99, 99, 99, 99, 99, 99, 99, 99
+};
+
+//Example tables from Annex K.3, in the order DC luminance, DC chrominance, AC luminance, AC chrominance
+constexpr static HuffmanSpecification huffmanSpecifications[4] = {
+	{
+		{0, 1, 5, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0},
+		{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}
+	},
+	{
+		{0, 3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0},
+		{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11}
+	},
+	{
+		{0, 2, 1, 3, 3, 2, 4, 3, 5, 5, 4, 4, 0, 0, 1, 0x7D},
+		{
+			0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06, 0x13, 0x51, 0x61, 0x07,
+			0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xA1, 0x08, 0x23, 0x42, 0xB1, 0xC1, 0x15, 0x52, 0xD1, 0xF0,
+			0x24, 0x33, 0x62, 0x72, 0x82, 0x09, 0x0A, 0x16, 0x17, 0x18, 0x19, 0x1A, 0x25, 0x26, 0x27, 0x28,
+			0x29, 0x2A, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+			0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+			0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+			0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7,
+			0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3, 0xC4, 0xC5,
+			0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA, 0xE1, 0xE2,
+			0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF1, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+			0xF9, 0xFA
+		}
+	},
+	{
+		{0, 2, 1, 2, 4, 4, 3, 4, 7, 5, 4, 4, 0, 1, 2, 0x77},
+		{
+			0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41, 0x51, 0x07, 0x61, 0x71,
+			0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91, 0xA1, 0xB1, 0xC1, 0x09, 0x23, 0x33, 0x52, 0xF0,
+			0x15, 0x62, 0x72, 0xD1, 0x0A, 0x16, 0x24, 0x34, 0xE1, 0x25, 0xF1, 0x17, 0x18, 0x19, 0x1A, 0x26,
+			0x27, 0x28, 0x29, 0x2A, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48,
+			0x49, 0x4A, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59, 0x5A, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68,
+			0x69, 0x6A, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79, 0x7A, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+			0x88, 0x89, 0x8A, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9A, 0xA2, 0xA3, 0xA4, 0xA5,
+			0xA6, 0xA7, 0xA8, 0xA9, 0xAA, 0xB2, 0xB3, 0xB4, 0xB5, 0xB6, 0xB7, 0xB8, 0xB9, 0xBA, 0xC2, 0xC3,
+			0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xD2, 0xD3, 0xD4, 0xD5, 0xD6, 0xD7, 0xD8, 0xD9, 0xDA,
+			0xE2, 0xE3, 0xE4, 0xE5, 0xE6, 0xE7, 0xE8, 0xE9, 0xEA, 0xF2, 0xF3, 0xF4, 0xF5, 0xF6, 0xF7, 0xF8,
+			0xF9, 0xFA
+		}
+	}
+};
+
+constexpr static std::array<HuffmanEncoding, 4> huffmanEncodings = []() {
+
+	std::array<HuffmanEncoding, 4> encodings {};
+
+	for (u32 t = 0; t < 4; t++) {
+
+		const HuffmanSpecification& spec = huffmanSpecifications[t];
+
+		u32 code = 0;
+		u32 k = 0;
+
+		for (u32 length = 1; length <= 16; length++) {
+
+			for (u32 i = 0; i < spec.counts[length - 1]; i++) {
+
+				encodings[t].codes[spec.values[k]] = code++;
+				encodings[t].lengths[spec.values[k]] = length;
+				k++;
+
+			}
+
+			code <<= 1;
+
+		}
+
+	}
+
+	return encodings;
+
+}();
+
+//Scale factors of the AAN DCT, sqrt(2) * cos(k * pi / 16) except for the DC term
+constexpr static float aanScaleFactors[8] = {
+	1.0f, 1.387039845f, 1.306562965f, 1.175875602f, 1.0f, 0.785694958f, 0.541196100f, 0.275899379f
+};
+
+
+
+//One-dimensional AAN forward DCT, outputs are scaled by the corresponding AAN factors
+ARC_FORCE_INLINE static void fdct1D(float* d0, float* d1, float* d2, float* d3, float* d4, float* d5, float* d6, float* d7) {
+
+	float tmp0 = *d0 + *d7;
+	float tmp7 = *d0 - *d7;
+	float tmp1 = *d1 + *d6;
+	float tmp6 = *d1 - *d6;
+	float tmp2 = *d2 + *d5;
+	float tmp5 = *d2 - *d5;
+	float tmp3 = *d3 + *d4;
+	float tmp4 = *d3 - *d4;
+
+	float tmp10 = tmp0 + tmp3;
+	float tmp13 = tmp0 - tmp3;
+	float tmp11 = tmp1 + tmp2;
+	float tmp12 = tmp1 - tmp2;
+
+	*d0 = tmp10 + tmp11;
+	*d4 = tmp10 - tmp11;
+
+	float z1 = (tmp12 + tmp13) * 0.707106781f;
+
+	*d2 = tmp13 + z1;
+	*d6 = tmp13 - z1;
+
+	tmp10 = tmp4 + tmp5;
+	tmp11 = tmp5 + tmp6;
+	tmp12 = tmp6 + tmp7;
+
+	float z5 = (tmp10 - tmp12) * 0.382683433f;
+	float z2 = tmp10 * 0.541196100f + z5;
+	float z4 = tmp12 * 1.306562965f + z5;
+	float z3 = tmp11 * 0.707106781f;
+
+	float z11 = tmp7 + z3;
+	float z13 = tmp7 - z3;
+
+	*d5 = z13 + z2;
+	*d3 = z13 - z2;
+	*d1 = z11 + z4;
+	*d7 = z11 - z4;
+
+}
+
+
+
+/*
+	Transforms and quantizes a block of level shifted samples.
+	Columns are transformed first and rows second, which leaves the coefficients transposed. This matches the vectorized
+	variant, where the row pass works on transposed registers.
+*/
+static void fdctDefault(const float* samples, SizeT stride, const float* scales, i16* block) {
+
+	float data[64];
+
+	for (u32 y = 0; y < 8; y++) {
+		std::memcpy(data + y * 8, samples + y * stride, 8 * sizeof(float));
+	}
+
+	for (u32 x = 0; x < 8; x++) {
+		fdct1D(data + x, data + x + 8, data + x + 16, data + x + 24, data + x + 32, data + x + 40, data + x + 48, data + x + 56);
+	}
+
+	for (u32 y = 0; y < 8; y++) {
+
+		float* d = data + y * 8;
+		fdct1D(d, d + 1, d + 2, d + 3, d + 4, d + 5, d + 6, d + 7);
+
+	}
+
+	for (u32 v = 0; v < 8; v++) {
+
+		for (u32 u = 0; u < 8; u++) {
+			block[u * 8 + v] = std::lrint(data[v * 8 + u] * scales[u * 8 + v]);
+		}
+
+	}
+
+}
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+ARC_TARGET("avx2") ARC_FORCE_INLINE static void fdct1DAVX2(__m256* v) {
+
+	__m256 tmp0 = _mm256_add_ps(v[0], v[7]);
+	__m256 tmp7 = _mm256_sub_ps(v[0], v[7]);
+	__m256 tmp1 = _mm256_add_ps(v[1], v[6]);
+	__m256 tmp6 = _mm256_sub_ps(v[1], v[6]);
+	__m256 tmp2 = _mm256_add_ps(v[2], v[5]);
+	__m256 tmp5 = _mm256_sub_ps(v[2], v[5]);
+	__m256 tmp3 = _mm256_add_ps(v[3], v[4]);
+	__m256 tmp4 = _mm256_sub_ps(v[3], v[4]);
+
+	__m256 tmp10 = _mm256_add_ps(tmp0, tmp3);
+	__m256 tmp13 = _mm256_sub_ps(tmp0, tmp3);
+	__m256 tmp11 = _mm256_add_ps(tmp1, tmp2);
+	__m256 tmp12 = _mm256_sub_ps(tmp1, tmp2);
+
+	v[0] = _mm256_add_ps(tmp10, tmp11);
+	v[4] = _mm256_sub_ps(tmp10, tmp11);
+
+	__m256 z1 = _mm256_mul_ps(_mm256_add_ps(tmp12, tmp13), _mm256_set1_ps(0.707106781f));
+
+	v[2] = _mm256_add_ps(tmp13, z1);
+	v[6] = _mm256_sub_ps(tmp13, z1);
+
+	tmp10 = _mm256_add_ps(tmp4, tmp5);
+	tmp11 = _mm256_add_ps(tmp5, tmp6);
+	tmp12 = _mm256_add_ps(tmp6, tmp7);
+
+	__m256 z5 = _mm256_mul_ps(_mm256_sub_ps(tmp10, tmp12), _mm256_set1_ps(0.382683433f));
+	__m256 z2 = _mm256_add_ps(_mm256_mul_ps(tmp10, _mm256_set1_ps(0.541196100f)), z5);
+	__m256 z4 = _mm256_add_ps(_mm256_mul_ps(tmp12, _mm256_set1_ps(1.306562965f)), z5);
+	__m256 z3 = _mm256_mul_ps(tmp11, _mm256_set1_ps(0.707106781f));
+
+	__m256 z11 = _mm256_add_ps(tmp7, z3);
+	__m256 z13 = _mm256_sub_ps(tmp7, z3);
+
+	v[5] = _mm256_add_ps(z13, z2);
+	v[3] = _mm256_sub_ps(z13, z2);
+	v[1] = _mm256_add_ps(z11, z4);
+	v[7] = _mm256_sub_ps(z11, z4);
+
+}
+
+
+
+ARC_TARGET("avx2") ARC_FORCE_INLINE static void transposeAVX2(__m256* v) {
+
+	__m256 t0 = _mm256_unpacklo_ps(v[0], v[1]);
+	__m256 t1 = _mm256_unpackhi_ps(v[0], v[1]);
+	__m256 t2 = _mm256_unpacklo_ps(v[2], v[3]);
+	__m256 t3 = _mm256_unpackhi_ps(v[2], v[3]);
+	__m256 t4 = _mm256_unpacklo_ps(v[4], v[5]);
+	__m256 t5 = _mm256_unpackhi_ps(v[4], v[5]);
+	__m256 t6 = _mm256_unpacklo_ps(v[6], v[7]);
+	__m256 t7 = _mm256_unpackhi_ps(v[6], v[7]);
+
+	__m256 s0 = _mm256_shuffle_ps(t0, t2, 0x44);
+	__m256 s1 = _mm256_shuffle_ps(t0, t2, 0xEE);
+	__m256 s2 = _mm256_shuffle_ps(t1, t3, 0x44);
+	__m256 s3 = _mm256_shuffle_ps(t1, t3, 0xEE);
+	__m256 s4 = _mm256_shuffle_ps(t4, t6, 0x44);
+	__m256 s5 = _mm256_shuffle_ps(t4, t6, 0xEE);
+	__m256 s6 = _mm256_shuffle_ps(t5, t7, 0x44);
+	__m256 s7 = _mm256_shuffle_ps(t5, t7, 0xEE);
+
+	v[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	v[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	v[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	v[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	v[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	v[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	v[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	v[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+
+}
+
+
+
+//Each register holds a row, so the first pass transforms all columns at once
+ARC_TARGET("avx2") static void fdctAVX2(const float* samples, SizeT stride, const float* scales, i16* block) {
+
+	__m256 v[8];
+
+	for (u32 i = 0; i < 8; i++) {
+		v[i] = _mm256_loadu_ps(samples + i * stride);
+	}
+
+	fdct1DAVX2(v);
+	transposeAVX2(v);
+	fdct1DAVX2(v);
+
+	for (u32 i = 0; i < 8; i += 2) {
+
+		__m256i a = _mm256_cvtps_epi32(_mm256_mul_ps(v[i], _mm256_loadu_ps(scales + i * 8)));
+		__m256i b = _mm256_cvtps_epi32(_mm256_mul_ps(v[i + 1], _mm256_loadu_ps(scales + i * 8 + 8)));
+
+		//Packing works per lane, the permutation restores the order
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(block + i * 8), packed);
+
+	}
+
+}
+
+#endif
+
+
+
+struct EncoderKernels {
+
+	FDCTFunction fdct;
+
+};
+
+
+
+static const EncoderKernels& kernels() {
+
+	static const EncoderKernels table = []() {
+
+		EncoderKernels k = {
+			fdctDefault
+		};
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::AVX2)) {
+			k.fdct = fdctAVX2;
+		}
+
+#endif
+
+		return k;
+
+	}();
+
+	return table;
+
+}
+
+
+
+JPEGEncoder::JPEGEncoder(std::optional<Pixel> reqFormat, u32 quality, bool subsampling) : IImageEncoder(reqFormat), quality(Math::clamp(quality, 1u, 100u)), subsampling(subsampling),
+	planeStride(0), bufferPosition(0), bitBuffer(0), bitCount(0), validEncode(false) {
+
+	u32 scale = this->quality < 50 ? 5000 / this->quality : 200 - this->quality * 2;
+
+	for (u32 t = 0; t < 2; t++) {
+
+		const u8* base = t ? chrominanceQuantization : luminanceQuantization;
+
+		for (u32 i = 0; i < 64; i++) {
+
+			u32 natural = JPEG::dezigzagTable[i];
+			u32 value = Math::clamp((base[natural] * scale + 50) / 100, 1u, 255u);
+
+			quantizationTables[t][i] = value;
+
+			//natural = v * 8 + u, the transform leaves coefficient (u, v) at u * 8 + v
+			u32 v = natural / 8;
+			u32 u = natural % 8;
+
+			quantizationScales[t][u * 8 + v] = 1.0f / (value * aanScaleFactors[u] * aanScaleFactors[v] * 8.0f);
+
+		}
+
+	}
+
+}
+
+
+
+void JPEGEncoder::encode(const RawImage& image) {
+
+	validEncode = false;
+
+	if (image.getWidth() == 0)
+		throw ImageEncoderException("Image width should be non-zero");
+
+	if (image.getHeight() == 0)
+		throw ImageEncoderException("Image height should be non-zero");
+
+	if (image.getWidth() > 0xFFFF || image.getHeight() > 0xFFFF)
+		throw ImageEncoderException("JPEG images cannot exceed 65535 pixels per dimension");
+
+	Pixel format = autoDetectFormat() ? image.getFormat() : requestedFormat.value();
+
+	if (format == Pixel::Grayscale8) {
+		encodeImage<Pixel::Grayscale8>(image);
+	} else {
+		encodeImage<Pixel::RGB8>(image);
+	}
+
+	validEncode = true;
+
+}
+
+
+
+const std::vector<u8>& JPEGEncoder::getBuffer() {
+
+	if (!validEncode) {
+		throw ImageEncoderException("Bad image encode");
+	}
+
+	return buffer;
+
+}
+
+
+
+template<Pixel P>
+void JPEGEncoder::encodeImage(const RawImage& image) {
+
+	constexpr bool Color = P != Pixel::Grayscale8;
+
+	u32 width = image.getWidth();
+	u32 height = image.getHeight();
+
+	//Images already in the stored format are read in place
+	RawImage converted;
+	std::span<const u8> pixels = image.getRawBuffer();
+
+	if (image.getFormat() != P) {
+
+		RawImage copy(image);
+		converted = Image<P>::fromRaw(copy, true).makeRaw();
+		pixels = converted.getRawBuffer();
+
+	}
+
+	bool subsampled = Color && subsampling;
+	u32 mcuSize = subsampled ? 16 : 8;
+	u32 mcusX = (width + mcuSize - 1) / mcuSize;
+	u32 mcusY = (height + mcuSize - 1) / mcuSize;
+
+	planeStride = mcusX * mcuSize;
+
+	for (u32 i = 0; i < (Color ? 3 : 1); i++) {
+		planes[i].resize(planeStride * mcuSize);
+	}
+
+	buffer.clear();
+	bufferPosition = 0;
+	bitBuffer = 0;
+	bitCount = 0;
+
+	writeHeaders(width, height, Color);
+
+	i32 predictions[3] = {};
+
+	for (u32 my = 0; my < mcusY; my++) {
+
+		loadStripe(pixels, width, height, my * mcuSize, Color);
+
+		for (u32 mx = 0; mx < mcusX; mx++) {
+
+			//Worst case of six blocks with every coefficient taking 27 bits, doubled for byte stuffing
+			ensureCapacity(6 * 64 * 4 * 2);
+
+			SizeT x = mx * mcuSize;
+
+			if (subsampled) {
+
+				encodeBlock(planes[0].data() + x, planeStride, 0, predictions[0]);
+				encodeBlock(planes[0].data() + x + 8, planeStride, 0, predictions[0]);
+				encodeBlock(planes[0].data() + x + 8 * planeStride, planeStride, 0, predictions[0]);
+				encodeBlock(planes[0].data() + x + 8 * planeStride + 8, planeStride, 0, predictions[0]);
+				encodeBlock(planes[1].data() + x / 2, planeStride, 1, predictions[1]);
+				encodeBlock(planes[2].data() + x / 2, planeStride, 1, predictions[2]);
+
+			} else {
+
+				encodeBlock(planes[0].data() + x, planeStride, 0, predictions[0]);
+
+				if constexpr (Color) {
+
+					encodeBlock(planes[1].data() + x, planeStride, 1, predictions[1]);
+					encodeBlock(planes[2].data() + x, planeStride, 1, predictions[2]);
+
+				}
+
+			}
+
+		}
+
+	}
+
+	//Pad the last byte with ones
+	ensureCapacity(16);
+	putBits(0x7F, 7);
+	flushBits();
+
+	buffer.resize(bufferPosition);
+	buffer.push_back(0xFF);
+	buffer.push_back(0xD9);
+
+}
+
+
+
+/*
+	Converts an MCU row into level shifted planes, replicating the last column and row into the padding.
+	Subsampled chroma is averaged over 2x2 pixels and stored in the left half of its plane.
+*/
+void JPEGEncoder::loadStripe(std::span<const u8> pixels, u32 width, u32 height, u32 y, bool color) {
+
+	u32 rows = planes[0].size() / planeStride;
+	u32 channels = color ? 3 : 1;
+	SizeT rowSize = SizeT(width) * channels;
+
+	for (u32 r = 0; r < rows; r++) {
+
+		const u8* source = pixels.data() + Math::min(y + r, height - 1) * rowSize;
+
+		float* luma = planes[0].data() + r * planeStride;
+
+		if (!color) {
+
+			for (u32 x = 0; x < width; x++) {
+				luma[x] = source[x] - 128.0f;
+			}
+
+		} else {
+
+			float* cb = planes[1].data() + r * planeStride;
+			float* cr = planes[2].data() + r * planeStride;
+
+			for (u32 x = 0; x < width; x++) {
+
+				float red = source[x * 3];
+				float green = source[x * 3 + 1];
+				float blue = source[x * 3 + 2];
+
+				luma[x] = 0.299f * red + 0.587f * green + 0.114f * blue - 128.0f;
+				cb[x] = -0.168735892f * red - 0.331264108f * green + 0.5f * blue;
+				cr[x] = 0.5f * red - 0.418687589f * green - 0.081312411f * blue;
+
+			}
+
+			for (u32 x = width; x < planeStride; x++) {
+
+				cb[x] = cb[width - 1];
+				cr[x] = cr[width - 1];
+
+			}
+
+		}
+
+		for (u32 x = width; x < planeStride; x++) {
+			luma[x] = luma[width - 1];
+		}
+
+	}
+
+	if (color && subsampling) {
+
+		for (u32 p = 1; p < 3; p++) {
+
+			float* plane = planes[p].data();
+
+			for (u32 r = 0; r < rows / 2; r++) {
+
+				const float* upper = plane + r * 2 * planeStride;
+				const float* lower = upper + planeStride;
+				float* target = plane + r * planeStride;
+
+				//Target rows never overtake the rows they are computed from
+				for (u32 x = 0; x < planeStride / 2; x++) {
+					target[x] = (upper[x * 2] + upper[x * 2 + 1] + lower[x * 2] + lower[x * 2 + 1]) * 0.25f;
+				}
+
+			}
+
+		}
+
+	}
+
+}
+
+
+
+void JPEGEncoder::encodeBlock(const float* samples, SizeT stride, u32 table, i32& prediction) {
+
+	alignas(32) i16 block[64];
+
+	kernels().fdct(samples, stride, quantizationScales[table].data(), block);
+
+	const HuffmanEncoding& dcTable = huffmanEncodings[table];
+	const HuffmanEncoding& acTable = huffmanEncodings[2 + table];
+
+	i16 coefficients[64];
+	u64 nonzero = 0;
+
+	for (u32 i = 0; i < 64; i++) {
+
+		coefficients[i] = block[JPEG::dezigzagTableTransposed[i]];
+		nonzero |= u64(coefficients[i] != 0) << i;
+
+	}
+
+	//Values are coded as category followed by the low bits, negative values in one's complement
+	auto encodeValue = [](i32 value, u32& bits) {
+
+		u32 magnitude = Math::abs(value);
+		u32 category = std::bit_width(magnitude);
+
+		bits = (value < 0 ? value - 1 : value) & ((1 << category) - 1);
+
+		return category;
+
+	};
+
+	u32 bits;
+	i32 difference = coefficients[0] - prediction;
+	u32 category = encodeValue(difference, bits);
+
+	prediction = coefficients[0];
+
+	putBits(dcTable.codes[category], dcTable.lengths[category]);
+	putBits(bits, category);
+	flushBits();
+
+	nonzero &= ~u64(1);
+
+	u32 last = 0;
+
+	while (nonzero) {
+
+		u32 index = Bits::ctz(nonzero);
+		u32 run = index - last - 1;
+
+		nonzero &= nonzero - 1;
+		last = index;
+
+		while (run >= 16) {
+
+			putBits(acTable.codes[0xF0], acTable.lengths[0xF0]);
+			flushBits();
+
+			run -= 16;
+
+		}
+
+		category = encodeValue(coefficients[index], bits);
+
+		u32 symbol = run << 4 | category;
+
+		putBits(acTable.codes[symbol], acTable.lengths[symbol]);
+		putBits(bits, category);
+		flushBits();
+
+	}
+
+	if (last != 63) {
+
+		putBits(acTable.codes[0x00], acTable.lengths[0x00]);
+		flushBits();
+
+	}
+
+}
+
+
+
+void JPEGEncoder::writeHeaders(u32 width, u32 height, bool color) {
+
+	u32 components = color ? 3 : 1;
+
+	buffer.push_back(0xFF);
+	buffer.push_back(0xD8);
+
+	const u8 jfif[14] = {0x4A, 0x46, 0x49, 0x46, 0x00, 1, 1, 0, 0, 1, 0, 1, 0, 0};
+	writeMarker(JPEG::Markers::APP0, jfif);
+
+	std::vector<u8> segment;
+
+	for (u32 t = 0; t < components && t < 2; t++) {
+
+		segment.push_back(t);
+		segment.insert(segment.end(), quantizationTables[t].begin(), quantizationTables[t].end());
+
+	}
+
+	writeMarker(JPEG::Markers::DQT, segment);
+
+	u8 luminanceSampling = color && subsampling ? 0x22 : 0x11;
+
+	segment = {8, u8(height >> 8), u8(height), u8(width >> 8), u8(width), u8(components)};
+
+	for (u32 c = 0; c < components; c++) {
+
+		segment.push_back(c + 1);
+		segment.push_back(c ? 0x11 : luminanceSampling);
+		segment.push_back(c ? 1 : 0);
+
+	}
+
+	writeMarker(JPEG::Markers::SOF0, segment);
+
+	segment.clear();
+
+	for (u32 t = 0; t < 4; t++) {
+
+		u32 id = t & 1;
+		u32 tableClass = t >> 1;
+
+		if (id && !color) {
+			continue;
+		}
+
+		const HuffmanSpecification& spec = huffmanSpecifications[t];
+		u32 valueCount = 0;
+
+		for (u32 count : spec.counts) {
+			valueCount += count;
+		}
+
+		segment.push_back(tableClass << 4 | id);
+		segment.insert(segment.end(), std::begin(spec.counts), std::end(spec.counts));
+		segment.insert(segment.end(), spec.values, spec.values + valueCount);
+
+	}
+
+	writeMarker(JPEG::Markers::DHT, segment);
+
+	segment = {u8(components)};
+
+	for (u32 c = 0; c < components; c++) {
+
+		segment.push_back(c + 1);
+		segment.push_back(c ? 0x11 : 0x00);
+
+	}
+
+	segment.push_back(0);
+	segment.push_back(63);
+	segment.push_back(0);
+
+	writeMarker(JPEG::Markers::SOS, segment);
+
+	bufferPosition = buffer.size();
+
+}
+
+
+
+void JPEGEncoder::writeMarker(u16 marker, std::span<const u8> data) {
+
+	u32 length = data.size() + 2;
+
+	buffer.push_back(marker >> 8);
+	buffer.push_back(marker);
+	buffer.push_back(length >> 8);
+	buffer.push_back(length);
+	buffer.insert(buffer.end(), data.begin(), data.end());
+
+}
+
+
+
+void JPEGEncoder::ensureCapacity(SizeT bytes) {
+
+	SizeT required = bufferPosition + bytes + 8;
+
+	if (buffer.size() < required) {
+		buffer.resize(Math::max(required, buffer.size() + buffer.size() / 2));
+	}
+
+}
+
+
+
+//Bits are collected MSB first, at most 63 bits may be pending
+ARC_FORCE_INLINE void JPEGEncoder::putBits(u32 value, u32 count) {
+
+	bitBuffer = bitBuffer << count | value;
+	bitCount += count;
+
+}
+
+
+
+//Writes all complete bytes, stuffing a zero byte after every 0xFF
+ARC_FORCE_INLINE void JPEGEncoder::flushBits() {
+
+	u8* out = buffer.data() + bufferPosition;
+
+	while (bitCount >= 8) {
+
+		bitCount -= 8;
+
+		u8 byte = bitBuffer >> bitCount;
+
+		*out++ = byte;
+
+		if (byte == 0xFF) {
+			*out++ = 0;
+		}
+
+	}
+
+	bufferPosition = out - buffer.data();
+
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 jpegencoder.hpp
+ */
+
+#pragma once
+
+#include "encoder.hpp"
+#include "image/image.hpp"
+
+#include <array>
+#include <vector>
+
+
+
+class JPEGEncoder : public IImageEncoder {
+
+public:
+
+	/*
+		Encodes baseline JPEGs with the example Huffman tables of the standard.
+		Grayscale images are stored with a single component, everything else as YCbCr with chroma subsampled 2x2 unless disabled.
+		Quality ranges from 1 to 100 and scales the example quantization tables like libjpeg does.
+	*/
+	explicit JPEGEncoder(std::optional<Pixel> reqFormat, u32 quality = 90, bool subsampling = true);
+
+	void encode(const RawImage& image);
+	const std::vector<u8>& getBuffer();
+
+private:
+
+	template<Pixel P>
+	void encodeImage(const RawImage& image);
+
+	void loadStripe(std::span<const u8> pixels, u32 width, u32 height, u32 y, bool color);
+	void encodeBlock(const float* samples, SizeT stride, u32 table, i32& prediction);
+
+	void writeHeaders(u32 width, u32 height, bool color);
+	void writeMarker(u16 marker, std::span<const u8> data);
+
+	void ensureCapacity(SizeT bytes);
+	void putBits(u32 value, u32 count);
+	void flushBits();
+
+	u32 quality;
+	bool subsampling;
+
+	//Zigzag ordered tables as stored in the stream and reciprocal divisors including the DCT scale factors, in transposed order
+	std::array<std::array<u8, 64>, 2> quantizationTables;
+	std::array<std::array<float, 64>, 2> quantizationScales;
+
+	//Level shifted planar samples of one MCU row, padded to full MCUs
+	std::array<std::vector<float>, 3> planes;
+	SizeT planeStride;
+
+	std::vector<u8> buffer;
+	SizeT bufferPosition;
+	u64 bitBuffer;
+	u32 bitCount;
+
+	bool validEncode;
+
+};
\ No newline at end of file
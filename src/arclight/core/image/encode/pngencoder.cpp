@@ -0,0 +1,533 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 pngencoder.cpp
+ */
+
+#include "pngencoder.hpp"
+#include "image/decode/png.hpp"
+#include "arcintrinsic.hpp"
+#include "math/math.hpp"
+#include "util/cpuid.hpp"
+
+#include <array>
+#include <cstring>
+
+
+
+using FilterFunction = void(*)(const u8* row, const u8* prior, u8* out, SizeT size, u32 bpp);
+using CostFunction = u64(*)(const u8* data, SizeT size);
+
+using PNG::ColorType;
+using PNG::FilterType;
+
+
+
+/*
+	Forward filters only depend on unfiltered samples, so unlike unfiltering every byte can be computed independently.
+	The first bpp bytes have no left neighbor and are handled separately.
+*/
+static void filterSubScalar(const u8* row, const u8*, u8* out, SizeT size, u32 bpp) {
+
+	for (SizeT i = 0; i < bpp; i++) {
+		out[i] = row[i];
+	}
+
+	for (SizeT i = bpp; i < size; i++) {
+		out[i] = row[i] - row[i - bpp];
+	}
+
+}
+
+
+
+static void filterUpScalar(const u8* row, const u8* prior, u8* out, SizeT size, u32) {
+
+	for (SizeT i = 0; i < size; i++) {
+		out[i] = row[i] - prior[i];
+	}
+
+}
+
+
+
+static void filterAverageScalar(const u8* row, const u8* prior, u8* out, SizeT size, u32 bpp) {
+
+	for (SizeT i = 0; i < bpp; i++) {
+		out[i] = row[i] - (prior[i] >> 1);
+	}
+
+	for (SizeT i = bpp; i < size; i++) {
+		out[i] = row[i] - ((row[i - bpp] + prior[i]) >> 1);
+	}
+
+}
+
+
+
+ARC_FORCE_INLINE static u8 paethPredictor(i32 a, i32 b, i32 c) {
+
+	i32 pa = Math::abs(b - c);
+	i32 pb = Math::abs(a - c);
+	i32 pc = Math::abs(a + b - c - c);
+
+	if (pa <= pb && pa <= pc) {
+		return a;
+	} else if (pb <= pc) {
+		return b;
+	} else {
+		return c;
+	}
+
+}
+
+
+
+static void filterPaethScalar(const u8* row, const u8* prior, u8* out, SizeT size, u32 bpp) {
+
+	for (SizeT i = 0; i < bpp; i++) {
+		out[i] = row[i] - prior[i];
+	}
+
+	for (SizeT i = bpp; i < size; i++) {
+		out[i] = row[i] - paethPredictor(row[i - bpp], prior[i], prior[i - bpp]);
+	}
+
+}
+
+
+
+//Sum of absolute values of the filtered bytes interpreted as signed, the usual heuristic for adaptive filtering
+static u64 filterCostScalar(const u8* data, SizeT size) {
+
+	u64 cost = 0;
+
+	for (SizeT i = 0; i < size; i++) {
+		cost += Math::abs(i8(data[i]));
+	}
+
+	return cost;
+
+}
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+ARC_TARGET("sse2") ARC_FORCE_INLINE static __m128i load(const u8* p) {
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+
+
+ARC_TARGET("sse2") ARC_FORCE_INLINE static void store(u8* p, __m128i x) {
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), x);
+}
+
+
+
+ARC_TARGET("sse2") static void filterSubSSE2(const u8* row, const u8*, u8* out, SizeT size, u32 bpp) {
+
+	SizeT i = Math::min(SizeT(bpp), size);
+
+	std::memcpy(out, row, i);
+
+	for (; i + 16 <= size; i += 16) {
+		store(out + i, _mm_sub_epi8(load(row + i), load(row + i - bpp)));
+	}
+
+	for (; i < size; i++) {
+		out[i] = row[i] - row[i - bpp];
+	}
+
+}
+
+
+
+ARC_TARGET("sse2") static void filterUpSSE2(const u8* row, const u8* prior, u8* out, SizeT size, u32 bpp) {
+
+	SizeT i = 0;
+
+	for (; i + 16 <= size; i += 16) {
+		store(out + i, _mm_sub_epi8(load(row + i), load(prior + i)));
+	}
+
+	filterUpScalar(row + i, prior + i, out + i, size - i, bpp);
+
+}
+
+
+
+ARC_TARGET("sse2") static void filterAverageSSE2(const u8* row, const u8* prior, u8* out, SizeT size, u32 bpp) {
+
+	SizeT i = Math::min(SizeT(bpp), size);
+	const __m128i one = _mm_set1_epi8(1);
+
+	for (SizeT j = 0; j < i; j++) {
+		out[j] = row[j] - (prior[j] >> 1);
+	}
+
+	for (; i + 16 <= size; i += 16) {
+
+		__m128i a = load(row + i - bpp);
+		__m128i b = load(prior + i);
+
+		//pavgb rounds up, the correction subtracts the carry of odd sums
+		__m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+
+		store(out + i, _mm_sub_epi8(load(row + i), avg));
+
+	}
+
+	for (; i < size; i++) {
+		out[i] = row[i] - ((row[i - bpp] + prior[i]) >> 1);
+	}
+
+}
+
+
+
+ARC_TARGET("sse2") ARC_FORCE_INLINE static __m128i select(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+
+
+ARC_TARGET("sse2") ARC_FORCE_INLINE static __m128i abs16(__m128i x) {
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+
+
+//Paeth predictor of eight 16-bit lanes
+ARC_TARGET("sse2") ARC_FORCE_INLINE static __m128i paethPredictorSSE2(__m128i a, __m128i b, __m128i c) {
+
+	__m128i pa = _mm_sub_epi16(b, c);
+	__m128i pb = _mm_sub_epi16(a, c);
+	__m128i pc = abs16(_mm_add_epi16(pa, pb));
+
+	pa = abs16(pa);
+	pb = abs16(pb);
+
+	//Ties prefer a over b over c
+	__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+	return select(_mm_cmpeq_epi16(smallest, pa), a, select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+}
+
+
+
+ARC_TARGET("sse2") static void filterPaethSSE2(const u8* row, const u8* prior, u8* out, SizeT size, u32 bpp) {
+
+	SizeT i = Math::min(SizeT(bpp), size);
+	const __m128i zero = _mm_setzero_si128();
+
+	for (SizeT j = 0; j < i; j++) {
+		out[j] = row[j] - prior[j];
+	}
+
+	for (; i + 16 <= size; i += 16) {
+
+		__m128i a = load(row + i - bpp);
+		__m128i b = load(prior + i);
+		__m128i c = load(prior + i - bpp);
+
+		__m128i lo = paethPredictorSSE2(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero), _mm_unpacklo_epi8(c, zero));
+		__m128i hi = paethPredictorSSE2(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero), _mm_unpackhi_epi8(c, zero));
+
+		store(out + i, _mm_sub_epi8(load(row + i), _mm_packus_epi16(lo, hi)));
+
+	}
+
+	for (; i < size; i++) {
+		out[i] = row[i] - paethPredictor(row[i - bpp], prior[i], prior[i - bpp]);
+	}
+
+}
+
+
+
+ARC_TARGET("sse2") static u64 filterCostSSE2(const u8* data, SizeT size) {
+
+	const __m128i zero = _mm_setzero_si128();
+	__m128i sum = zero;
+	SizeT i = 0;
+
+	for (; i + 16 <= size; i += 16) {
+
+		__m128i x = load(data + i);
+		__m128i magnitude = _mm_min_epu8(x, _mm_sub_epi8(zero, x));
+
+		sum = _mm_add_epi64(sum, _mm_sad_epu8(magnitude, zero));
+
+	}
+
+	u64 cost = _mm_cvtsi128_si64(sum) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(sum, sum));
+
+	return cost + filterCostScalar(data + i, size - i);
+
+}
+
+#endif
+
+
+
+struct FilterKernels {
+
+	FilterFunction sub;
+	FilterFunction up;
+	FilterFunction average;
+	FilterFunction paeth;
+	CostFunction cost;
+
+};
+
+
+
+static const FilterKernels& kernels() {
+
+	static const FilterKernels table = []() {
+
+		FilterKernels k = {
+			filterSubScalar,
+			filterUpScalar,
+			filterAverageScalar,
+			filterPaethScalar,
+			filterCostScalar
+		};
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::SSE2)) {
+
+			k.sub = filterSubSSE2;
+			k.up = filterUpSSE2;
+			k.average = filterAverageSSE2;
+			k.paeth = filterPaethSSE2;
+			k.cost = filterCostSSE2;
+
+		}
+
+#endif
+
+		return k;
+
+	}();
+
+	return table;
+
+}
+
+
+
+void PNGEncoder::encode(const RawImage& image) {
+
+	validEncode = false;
+
+	if (image.getWidth() == 0)
+		throw ImageEncoderException("Image width should be non-zero");
+
+	if (image.getHeight() == 0)
+		throw ImageEncoderException("Image height should be non-zero");
+
+	Pixel format = autoDetectFormat() ? image.getFormat() : requestedFormat.value();
+
+	switch (format) {
+
+		case Pixel::Grayscale8:
+			encodeImage<Pixel::Grayscale8>(image);
+			break;
+
+		case Pixel::RGBA8:
+		case Pixel::ABGR8:
+		case Pixel::BGRA8:
+		case Pixel::ARGB8:
+			encodeImage<Pixel::RGBA8>(image);
+			break;
+
+		default:
+			encodeImage<Pixel::RGB8>(image);
+			break;
+
+	}
+
+	validEncode = true;
+
+}
+
+
+
+const std::vector<u8>& PNGEncoder::getBuffer() {
+
+	if (!validEncode) {
+		throw ImageEncoderException("Bad image encode");
+	}
+
+	return buffer;
+
+}
+
+
+
+template<Pixel P>
+void PNGEncoder::encodeImage(const RawImage& image) {
+
+	constexpr ColorType Type = P == Pixel::Grayscale8 ? ColorType::Grayscale : P == Pixel::RGBA8 ? ColorType::RGBA : ColorType::RGB;
+	constexpr u32 BytesPerPixel = PixelFormat<P>::BytesPerPixel;
+
+	u32 width = image.getWidth();
+	u32 height = image.getHeight();
+
+	//Images already in the stored format are read in place
+	RawImage converted;
+	std::span<const u8> pixels = image.getRawBuffer();
+
+	if (image.getFormat() != P) {
+
+		RawImage copy(image);
+		converted = Image<P>::fromRaw(copy, true).makeRaw();
+		pixels = converted.getRawBuffer();
+
+	}
+
+	filterImage(pixels, width, height, BytesPerPixel);
+
+	buffer.clear();
+
+	for (u32 i = 0; i < 8; i++) {
+		buffer.push_back(PNG::Signature >> (56 - i * 8));
+	}
+
+	std::array<u8, 13> header = {
+		u8(width >> 24), u8(width >> 16), u8(width >> 8), u8(width),
+		u8(height >> 24), u8(height >> 16), u8(height >> 8), u8(height),
+		8, u8(Type), 0, 0, 0
+	};
+
+	writeChunk(PNG::Chunks::IHDR, header);
+
+	//The stream is compressed straight into a single IDAT chunk, length and CRC are filled in afterwards
+	SizeT chunkStart = buffer.size();
+	buffer.resize(chunkStart + 8);
+
+	deflater.deflate(filteredData, buffer);
+
+	SizeT dataSize = buffer.size() - chunkStart - 8;
+
+	if (dataSize > 0x7FFFFFFF) {
+		throw ImageEncoderException("PNG image data too large");
+	}
+
+	u8* chunk = buffer.data() + chunkStart;
+
+	for (u32 i = 0; i < 4; i++) {
+
+		chunk[i] = dataSize >> (24 - i * 8);
+		chunk[i + 4] = PNG::Chunks::IDAT >> (24 - i * 8);
+
+	}
+
+	u32 crc = PNG::crc32({chunk + 4, dataSize + 4});
+
+	for (u32 i = 0; i < 4; i++) {
+		buffer.push_back(crc >> (24 - i * 8));
+	}
+
+	writeChunk(PNG::Chunks::IEND, {});
+
+}
+
+
+
+void PNGEncoder::filterImage(std::span<const u8> pixels, u32 width, u32 height, u32 bpp) {
+
+	const FilterKernels& kernel = kernels();
+	Deflater::Level level = deflater.getLevel();
+
+	SizeT rowSize = SizeT(width) * bpp;
+
+	filteredData.resize((rowSize + 1) * height);
+
+	std::vector<u8> zeroRow(rowSize, 0);
+	std::vector<u8> candidates(level > Deflater::Level::Fast ? rowSize * 4 : 0);
+
+	const FilterFunction filters[4] = {kernel.sub, kernel.up, kernel.average, kernel.paeth};
+
+	for (u32 y = 0; y < height; y++) {
+
+		const u8* row = pixels.data() + y * rowSize;
+		const u8* prior = y ? row - rowSize : zeroRow.data();
+		u8* out = filteredData.data() + y * (rowSize + 1);
+
+		switch (level) {
+
+			case Deflater::Level::Store:
+
+				out[0] = u8(FilterType::None);
+				std::memcpy(out + 1, row, rowSize);
+				break;
+
+			//Paeth alone performs well on both photographic and synthetic content
+			case Deflater::Level::Fast:
+
+				out[0] = u8(FilterType::Paeth);
+				kernel.paeth(row, prior, out + 1, rowSize, bpp);
+				break;
+
+			default:
+				{
+					u32 bestFilter = 0;
+					u64 bestCost = kernel.cost(row, rowSize);
+
+					for (u32 f = 0; f < 4; f++) {
+
+						filters[f](row, prior, candidates.data() + f * rowSize, rowSize, bpp);
+
+						u64 cost = kernel.cost(candidates.data() + f * rowSize, rowSize);
+
+						if (cost < bestCost) {
+
+							bestCost = cost;
+							bestFilter = f + 1;
+
+						}
+
+					}
+
+					out[0] = bestFilter;
+					std::memcpy(out + 1, bestFilter ? candidates.data() + (bestFilter - 1) * rowSize : row, rowSize);
+				}
+				break;
+
+		}
+
+	}
+
+}
+
+
+
+void PNGEncoder::writeChunk(u32 type, std::span<const u8> data) {
+
+	std::array<u8, 8> chunkHeader;
+
+	for (u32 i = 0; i < 4; i++) {
+
+		chunkHeader[i] = data.size() >> (24 - i * 8);
+		chunkHeader[i + 4] = type >> (24 - i * 8);
+
+	}
+
+	buffer.insert(buffer.end(), chunkHeader.begin(), chunkHeader.end());
+	buffer.insert(buffer.end(), data.begin(), data.end());
+
+	u32 crc = PNG::crc32({buffer.data() + buffer.size() - data.size() - 4, data.size() + 4});
+
+	for (u32 i = 0; i < 4; i++) {
+		buffer.push_back(crc >> (24 - i * 8));
+	}
+
+}
\ No newline at end of file
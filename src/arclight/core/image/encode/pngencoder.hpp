@@ -0,0 +1,47 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 pngencoder.hpp
+ */
+
+#pragma once
+
+#include "encoder.hpp"
+#include "deflate.hpp"
+#include "image/image.hpp"
+
+#include <vector>
+
+
+
+class PNGEncoder : public IImageEncoder {
+
+public:
+
+	/*
+		Encodes 8-bit grayscale, RGB or RGBA images, depending on the requested or otherwise the source format.
+		The level trades speed for size: Store skips filtering and compression, Fast applies a fixed filter and all other levels choose
+		the filter per row.
+	*/
+	explicit PNGEncoder(std::optional<Pixel> reqFormat, Deflater::Level level = Deflater::Level::Default) : IImageEncoder(reqFormat), deflater(level), validEncode(false) {}
+
+	void encode(const RawImage& image);
+	const std::vector<u8>& getBuffer();
+
+private:
+
+	template<Pixel P>
+	void encodeImage(const RawImage& image);
+
+	void filterImage(std::span<const u8> pixels, u32 width, u32 height, u32 bpp);
+	void writeChunk(u32 type, std::span<const u8> data);
+
+	Deflater deflater;
+
+	std::vector<u8> filteredData;
+	std::vector<u8> buffer;
+	bool validEncode;
+
+};
\ No newline at end of file
@@ -0,0 +1,207 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 qoiencoder.cpp
+ */
+
+#include "qoiencoder.hpp"
+#include "stream/binarywriter.hpp"
+
+#include <cstring>
+
+
+
+constexpr static u8 hash(u8 r, u8 g, u8 b, u8 a) {
+	return (r * 3 + g * 5 + b * 7 + a * 11) % 64;
+}
+
+
+
+void QOIEncoder::encode(const RawImage& image) {
+
+	validEncode = false;
+
+	if (image.getWidth() == 0)
+		throw ImageEncoderException("Image width should be non-zero");
+
+	if (image.getHeight() == 0)
+		throw ImageEncoderException("Image height should be non-zero");
+
+	Pixel format = autoDetectFormat() ? image.getFormat() : requestedFormat.value();
+
+	switch (format) {
+
+		case Pixel::RGBA8:
+		case Pixel::ABGR8:
+		case Pixel::BGRA8:
+		case Pixel::ARGB8:
+			encodeImage<Pixel::RGBA8>(image);
+			break;
+
+		default:
+			encodeImage<Pixel::RGB8>(image);
+			break;
+
+	}
+
+	validEncode = true;
+
+}
+
+
+
+const std::vector<u8>& QOIEncoder::getBuffer() {
+
+	if (!validEncode) {
+		throw ImageEncoderException("Bad image encode");
+	}
+
+	return buffer;
+
+}
+
+
+
+template<Pixel P>
+void QOIEncoder::encodeImage(const RawImage& image) {
+
+	constexpr u32 Channels = PixelFormat<P>::BytesPerPixel;
+
+	u32 width = image.getWidth();
+	u32 height = image.getHeight();
+
+	//Images already in the stored format are read in place
+	RawImage converted;
+	std::span<const u8> pixels = image.getRawBuffer();
+
+	if (image.getFormat() != P) {
+
+		RawImage copy(image);
+		converted = Image<P>::fromRaw(copy, true).makeRaw();
+		pixels = converted.getRawBuffer();
+
+	}
+
+	SizeT pixelCount = SizeT(width) * height;
+
+	//Worst case: Every pixel is stored as a full RGB(A) chunk
+	buffer.resize(14 + pixelCount * (Channels + 1) + 8);
+
+	BinaryWriter writer(buffer, ByteOrder::Big);
+
+	writer.write<u32>(0x716F6966);
+	writer.write<u32>(width);
+	writer.write<u32>(height);
+	writer.write<u8>(Channels);
+	writer.write<u8>(0);
+
+	u8* out = buffer.data() + 14;
+	const u8* in = pixels.data();
+
+	//Pixels are compared packed as r | g << 8 | b << 16 | a << 24
+	u32 index[64] = {};
+	u32 previous = 0xFF000000;
+	u32 run = 0;
+
+	for (SizeT i = 0; i < pixelCount; i++, in += Channels) {
+
+		u32 current;
+
+		if constexpr (Channels == 4) {
+			current = in[0] | in[1] << 8 | in[2] << 16 | u32(in[3]) << 24;
+		} else {
+			current = in[0] | in[1] << 8 | in[2] << 16 | 0xFF000000;
+		}
+
+		if (current == previous) {
+
+			run++;
+
+			if (run == 62) {
+
+				*out++ = 0xC0 | (run - 1);
+				run = 0;
+
+			}
+
+			continue;
+
+		}
+
+		if (run) {
+
+			*out++ = 0xC0 | (run - 1);
+			run = 0;
+
+		}
+
+		u8 r = current;
+		u8 g = current >> 8;
+		u8 b = current >> 16;
+		u8 a = current >> 24;
+
+		u8 h = hash(r, g, b, a);
+
+		if (index[h] == current) {
+
+			*out++ = h;
+
+		} else if ((current ^ previous) >> 24) {
+
+			index[h] = current;
+
+			*out++ = 0xFF;
+			*out++ = r;
+			*out++ = g;
+			*out++ = b;
+			*out++ = a;
+
+		} else {
+
+			index[h] = current;
+
+			i8 dr = r - u8(previous);
+			i8 dg = g - u8(previous >> 8);
+			i8 db = b - u8(previous >> 16);
+
+			i8 drg = dr - dg;
+			i8 dbg = db - dg;
+
+			if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+
+				*out++ = 0x40 | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+
+			} else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+
+				*out++ = 0x80 | (dg + 32);
+				*out++ = (drg + 8) << 4 | (dbg + 8);
+
+			} else {
+
+				*out++ = 0xFE;
+				*out++ = r;
+				*out++ = g;
+				*out++ = b;
+
+			}
+
+		}
+
+		previous = current;
+
+	}
+
+	if (run) {
+		*out++ = 0xC0 | (run - 1);
+	}
+
+	//End marker
+	std::memset(out, 0, 7);
+	out[7] = 1;
+	out += 8;
+
+	buffer.resize(out - buffer.data());
+
+}
\ No newline at end of file
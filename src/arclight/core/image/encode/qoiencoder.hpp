@@ -0,0 +1,34 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 qoiencoder.hpp
+ */
+
+#pragma once
+
+#include "encoder.hpp"
+#include "image/image.hpp"
+
+
+
+class QOIEncoder : public IImageEncoder {
+
+public:
+
+	//Images are stored with 3 or 4 channels depending on whether the requested or otherwise the source format carries alpha
+	constexpr explicit QOIEncoder(std::optional<Pixel> reqFormat) noexcept : IImageEncoder(reqFormat), validEncode(false) {}
+
+	void encode(const RawImage& image);
+	const std::vector<u8>& getBuffer();
+
+private:
+
+	template<Pixel P>
+	void encodeImage(const RawImage& image);
+
+	std::vector<u8> buffer;
+	bool validEncode;
+
+};
\ No newline at end of file
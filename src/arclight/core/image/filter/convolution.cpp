@@ -0,0 +1,888 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 convolution.cpp
+ */
+
+#include "convolution.hpp"
+#include "arcintrinsic.hpp"
+#include "concurrent/threadpool.hpp"
+#include "math/math.hpp"
+#include "util/cpuid.hpp"
+
+#include <cmath>
+#include <cstring>
+
+
+
+//Rows per parallel task and columns per tile
+constexpr static u32 bandHeight = 64;
+constexpr static u32 tileWidth = 512;
+
+//All row lengths handed to the kernels are padded to this granularity
+constexpr static u32 rowGranularity = 32;
+
+//Fixed point kernels are limited so that neither intermediate nor accumulators can overflow
+constexpr static u32 fixedMaxTaps = 64;
+constexpr static u32 fixedWeightBits = 14;
+constexpr static u32 fixedIntermediateBits = 7;
+
+using FixedRowFunction = void(*)(const u8* in, const i16* weights, u32 taps, i16* out, u32 count);
+using FixedColumnFunction = void(*)(const i16* rows, SizeT stride, const i16* weights, u32 taps, u8* out, u32 count, u8 maxValue);
+using FloatRowFunction = void(*)(const float* in, const float* weights, u32 taps, float* accumulator, u32 count);
+using FloatColumnFunction = void(*)(const float* rows, SizeT stride, const float* weights, u32 taps, float* accumulator, u32 count);
+using FloatStoreFunction = void(*)(const float* accumulator, u8* out, u32 count, u8 maxValue);
+
+
+
+ConvolutionKernel::ConvolutionKernel(u32 width, u32 height, std::span<const double> weights) : width(width), height(height), weights(weights.begin(), weights.end()) {
+
+	if (!width || !height) {
+		throw ImageException("Convolution kernel dimensions must be non-zero");
+	}
+
+	if (weights.size() != SizeT(width) * height) {
+		throw ImageException("Convolution kernel weight count does not match its dimensions");
+	}
+
+	separate();
+
+}
+
+
+
+ConvolutionKernel::ConvolutionKernel(const Mat3<double>& matrix) : width(3), height(3), weights(9) {
+
+	for (u32 y = 0; y < 3; y++) {
+
+		for (u32 x = 0; x < 3; x++) {
+			weights[y * 3 + x] = matrix[x][y];
+		}
+
+	}
+
+	separate();
+
+}
+
+
+
+ConvolutionKernel ConvolutionKernel::separable(std::span<const double> horizontal, std::span<const double> vertical) {
+
+	std::vector<double> weights;
+	weights.reserve(horizontal.size() * vertical.size());
+
+	for (double v : vertical) {
+
+		for (double h : horizontal) {
+			weights.push_back(h * v);
+		}
+
+	}
+
+	ConvolutionKernel kernel(horizontal.size(), vertical.size(), weights);
+
+	//Keep the factors as given instead of the reconstructed ones
+	if (kernel.isSeparable()) {
+
+		kernel.horizontalFactor.assign(horizontal.begin(), horizontal.end());
+		kernel.verticalFactor.assign(vertical.begin(), vertical.end());
+
+	}
+
+	return kernel;
+
+}
+
+
+
+ConvolutionKernel ConvolutionKernel::box(u32 width, u32 height) {
+
+	std::vector<double> horizontal(width, 1.0);
+	std::vector<double> vertical(height, 1.0);
+
+	return separable(horizontal, vertical);
+
+}
+
+
+
+ConvolutionKernel ConvolutionKernel::gaussian(double sigma) {
+
+	if (!(sigma > 0)) {
+		throw ImageException("Gaussian kernel sigma must be positive");
+	}
+
+	u32 radius = static_cast<u32>(std::ceil(sigma * 3));
+	std::vector<double> factor(radius * 2 + 1);
+
+	for (u32 i = 0; i < factor.size(); i++) {
+
+		double x = static_cast<double>(i) - radius;
+		factor[i] = std::exp(-x * x / (2 * sigma * sigma));
+
+	}
+
+	return separable(factor, factor);
+
+}
+
+
+
+/*
+	Tests whether the kernel is an outer product by factoring it through its largest weight.
+	The row and column of the pivot determine the factors, every other weight has to match their product.
+*/
+void ConvolutionKernel::separate() {
+
+	horizontalFactor.clear();
+	verticalFactor.clear();
+
+	SizeT pivot = 0;
+
+	for (SizeT i = 1; i < weights.size(); i++) {
+
+		if (Math::abs(weights[i]) > Math::abs(weights[pivot])) {
+			pivot = i;
+		}
+
+	}
+
+	double pivotWeight = weights[pivot];
+
+	if (pivotWeight == 0) {
+		return;
+	}
+
+	u32 pivotX = pivot % width;
+	u32 pivotY = pivot / width;
+
+	std::vector<double> horizontal(weights.begin() + pivotY * width, weights.begin() + (pivotY + 1) * width);
+	std::vector<double> vertical(height);
+
+	for (u32 y = 0; y < height; y++) {
+		vertical[y] = weights[y * width + pivotX] / pivotWeight;
+	}
+
+	double tolerance = Math::abs(pivotWeight) * 1e-9;
+
+	for (u32 y = 0; y < height; y++) {
+
+		for (u32 x = 0; x < width; x++) {
+
+			if (Math::abs(weights[y * width + x] - horizontal[x] * vertical[y]) > tolerance) {
+				return;
+			}
+
+		}
+
+	}
+
+	horizontalFactor = std::move(horizontal);
+	verticalFactor = std::move(vertical);
+
+}
+
+
+
+//Taps are applied to blocks of outputs at once, which keeps the inner loops free of reductions and lets them vectorize
+constexpr static u32 defaultBlockSize = 64;
+
+static void fixedRowDefault(const u8* in, const i16* weights, u32 taps, i16* out, u32 count) {
+
+	for (u32 start = 0; start < count; start += defaultBlockSize) {
+
+		u32 block = Math::min(count - start, defaultBlockSize);
+		i32 sums[defaultBlockSize] = {};
+
+		for (u32 i = 0; i < taps; i++) {
+
+			i32 w = weights[i];
+			const u8* samples = in + start + i;
+
+			for (u32 x = 0; x < block; x++) {
+				sums[x] += w * samples[x];
+			}
+
+		}
+
+		for (u32 x = 0; x < block; x++) {
+			out[start + x] = Math::clamp((sums[x] + (1 << (fixedIntermediateBits - 1))) >> fixedIntermediateBits, -32768, 32767);
+		}
+
+	}
+
+}
+
+
+
+static void fixedColumnDefault(const i16* rows, SizeT stride, const i16* weights, u32 taps, u8* out, u32 count, u8 maxValue) {
+
+	constexpr u32 Shift = fixedWeightBits + fixedIntermediateBits;
+
+	for (u32 start = 0; start < count; start += defaultBlockSize) {
+
+		u32 block = Math::min(count - start, defaultBlockSize);
+		i32 sums[defaultBlockSize] = {};
+
+		for (u32 j = 0; j < taps; j++) {
+
+			i32 w = weights[j];
+			const i16* row = rows + j * stride + start;
+
+			for (u32 x = 0; x < block; x++) {
+				sums[x] += w * row[x];
+			}
+
+		}
+
+		for (u32 x = 0; x < block; x++) {
+
+			u32 value = (static_cast<u32>(Math::abs(sums[x])) + (1 << (Shift - 1))) >> Shift;
+			out[start + x] = Math::min(value, u32(maxValue));
+
+		}
+
+	}
+
+}
+
+
+
+static void floatRowDefault(const float* in, const float* weights, u32 taps, float* accumulator, u32 count) {
+
+	for (u32 i = 0; i < taps; i++) {
+
+		float w = weights[i];
+
+		for (u32 x = 0; x < count; x++) {
+			accumulator[x] += w * in[x + i];
+		}
+
+	}
+
+}
+
+
+
+static void floatColumnDefault(const float* rows, SizeT stride, const float* weights, u32 taps, float* accumulator, u32 count) {
+
+	for (u32 j = 0; j < taps; j++) {
+
+		float w = weights[j];
+		const float* row = rows + j * stride;
+
+		for (u32 x = 0; x < count; x++) {
+			accumulator[x] += w * row[x];
+		}
+
+	}
+
+}
+
+
+
+static void floatStoreDefault(const float* accumulator, u8* out, u32 count, u8 maxValue) {
+
+	for (u32 x = 0; x < count; x++) {
+		out[x] = static_cast<u8>(Math::min(std::abs(accumulator[x]) + 0.5f, static_cast<float>(maxValue)));
+	}
+
+}
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+/*
+	Pairs of taps are multiplied with madd. Interleaving the samples of two taps splits the outputs across two accumulators,
+	the lane-wise pack afterwards restores their order.
+*/
+ARC_TARGET("avx2") static void fixedRowAVX2(const u8* in, const i16* weights, u32 taps, i16* out, u32 count) {
+
+	const __m256i rounding = _mm256_set1_epi32(1 << (fixedIntermediateBits - 1));
+
+	for (u32 x = 0; x < count; x += 16) {
+
+		__m256i sumLow = _mm256_setzero_si256();
+		__m256i sumHigh = _mm256_setzero_si256();
+
+		for (u32 i = 0; i < taps; i += 2) {
+
+			__m256i a = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x + i)));
+			__m256i b = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x + i + 1)));
+			__m256i w = _mm256_set1_epi32(static_cast<u16>(weights[i]) | static_cast<u32>(static_cast<u16>(weights[i + 1])) << 16);
+
+			sumLow = _mm256_add_epi32(sumLow, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+			sumHigh = _mm256_add_epi32(sumHigh, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+
+		}
+
+		sumLow = _mm256_srai_epi32(_mm256_add_epi32(sumLow, rounding), fixedIntermediateBits);
+		sumHigh = _mm256_srai_epi32(_mm256_add_epi32(sumHigh, rounding), fixedIntermediateBits);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + x), _mm256_packs_epi32(sumLow, sumHigh));
+
+	}
+
+}
+
+
+
+ARC_TARGET("avx2") static void fixedColumnAVX2(const i16* rows, SizeT stride, const i16* weights, u32 taps, u8* out, u32 count, u8 maxValue) {
+
+	constexpr u32 Shift = fixedWeightBits + fixedIntermediateBits;
+
+	const __m256i rounding = _mm256_set1_epi32(1 << (Shift - 1));
+	const __m128i limit = _mm_set1_epi8(static_cast<char>(maxValue));
+
+	for (u32 x = 0; x < count; x += 16) {
+
+		__m256i sumLow = _mm256_setzero_si256();
+		__m256i sumHigh = _mm256_setzero_si256();
+
+		for (u32 j = 0; j < taps; j += 2) {
+
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + j * stride + x));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + (j + 1) * stride + x));
+			__m256i w = _mm256_set1_epi32(static_cast<u16>(weights[j]) | static_cast<u32>(static_cast<u16>(weights[j + 1])) << 16);
+
+			sumLow = _mm256_add_epi32(sumLow, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+			sumHigh = _mm256_add_epi32(sumHigh, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+
+		}
+
+		sumLow = _mm256_srli_epi32(_mm256_add_epi32(_mm256_abs_epi32(sumLow), rounding), Shift);
+		sumHigh = _mm256_srli_epi32(_mm256_add_epi32(_mm256_abs_epi32(sumHigh), rounding), Shift);
+
+		__m256i words = _mm256_packs_epi32(sumLow, sumHigh);
+		__m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0xD8);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_min_epu8(_mm256_castsi256_si128(bytes), limit));
+
+	}
+
+}
+
+
+
+//Four independent accumulators hide the FMA latency
+ARC_TARGET("avx2,fma") static void floatRowAVX2(const float* in, const float* weights, u32 taps, float* accumulator, u32 count) {
+
+	for (u32 x = 0; x < count; x += 32) {
+
+		__m256 a0 = _mm256_loadu_ps(accumulator + x);
+		__m256 a1 = _mm256_loadu_ps(accumulator + x + 8);
+		__m256 a2 = _mm256_loadu_ps(accumulator + x + 16);
+		__m256 a3 = _mm256_loadu_ps(accumulator + x + 24);
+
+		for (u32 i = 0; i < taps; i++) {
+
+			__m256 w = _mm256_set1_ps(weights[i]);
+			const float* p = in + x + i;
+
+			a0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(p), a0);
+			a1 = _mm256_fmadd_ps(w, _mm256_loadu_ps(p + 8), a1);
+			a2 = _mm256_fmadd_ps(w, _mm256_loadu_ps(p + 16), a2);
+			a3 = _mm256_fmadd_ps(w, _mm256_loadu_ps(p + 24), a3);
+
+		}
+
+		_mm256_storeu_ps(accumulator + x, a0);
+		_mm256_storeu_ps(accumulator + x + 8, a1);
+		_mm256_storeu_ps(accumulator + x + 16, a2);
+		_mm256_storeu_ps(accumulator + x + 24, a3);
+
+	}
+
+}
+
+
+
+ARC_TARGET("avx2,fma") static void floatColumnAVX2(const float* rows, SizeT stride, const float* weights, u32 taps, float* accumulator, u32 count) {
+
+	for (u32 x = 0; x < count; x += 32) {
+
+		__m256 a0 = _mm256_loadu_ps(accumulator + x);
+		__m256 a1 = _mm256_loadu_ps(accumulator + x + 8);
+		__m256 a2 = _mm256_loadu_ps(accumulator + x + 16);
+		__m256 a3 = _mm256_loadu_ps(accumulator + x + 24);
+
+		for (u32 j = 0; j < taps; j++) {
+
+			__m256 w = _mm256_set1_ps(weights[j]);
+			const float* p = rows + j * stride + x;
+
+			a0 = _mm256_fmadd_ps(w, _mm256_loadu_ps(p), a0);
+			a1 = _mm256_fmadd_ps(w, _mm256_loadu_ps(p + 8), a1);
+			a2 = _mm256_fmadd_ps(w, _mm256_loadu_ps(p + 16), a2);
+			a3 = _mm256_fmadd_ps(w, _mm256_loadu_ps(p + 24), a3);
+
+		}
+
+		_mm256_storeu_ps(accumulator + x, a0);
+		_mm256_storeu_ps(accumulator + x + 8, a1);
+		_mm256_storeu_ps(accumulator + x + 16, a2);
+		_mm256_storeu_ps(accumulator + x + 24, a3);
+
+	}
+
+}
+
+
+
+ARC_TARGET("avx2") static void floatStoreAVX2(const float* accumulator, u8* out, u32 count, u8 maxValue) {
+
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 limit = _mm256_set1_ps(maxValue);
+
+	for (u32 x = 0; x < count; x += 16) {
+
+		__m256 a = _mm256_min_ps(_mm256_add_ps(_mm256_andnot_ps(signMask, _mm256_loadu_ps(accumulator + x)), half), limit);
+		__m256 b = _mm256_min_ps(_mm256_add_ps(_mm256_andnot_ps(signMask, _mm256_loadu_ps(accumulator + x + 8)), half), limit);
+
+		//Packs work per lane, each of them is followed by a permutation restoring linear order
+		__m256i words = _mm256_permute4x64_epi64(_mm256_packs_epi32(_mm256_cvttps_epi32(a), _mm256_cvttps_epi32(b)), 0xD8);
+		__m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0xD8);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm256_castsi256_si128(bytes));
+
+	}
+
+}
+
+#endif
+
+
+
+struct ConvolutionKernels {
+
+	FixedRowFunction fixedRow;
+	FixedColumnFunction fixedColumn;
+	FloatRowFunction floatRow;
+	FloatColumnFunction floatColumn;
+	FloatStoreFunction floatStore;
+
+};
+
+
+
+static const ConvolutionKernels& kernels() {
+
+	static const ConvolutionKernels table = []() {
+
+		ConvolutionKernels k = {
+			fixedRowDefault,
+			fixedColumnDefault,
+			floatRowDefault,
+			floatColumnDefault,
+			floatStoreDefault
+		};
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::AVX2)) {
+
+			k.fixedRow = fixedRowAVX2;
+			k.fixedColumn = fixedColumnAVX2;
+			k.floatStore = floatStoreAVX2;
+
+			if (CPUID::hasFeature(CPUFeature::FMA)) {
+
+				k.floatRow = floatRowAVX2;
+				k.floatColumn = floatColumnAVX2;
+
+			}
+
+		}
+
+#endif
+
+		return k;
+
+	}();
+
+	return table;
+
+}
+
+
+
+//Maps a coordinate outside of [0, size) back into the image. Ignored edges are clamped here and fixed up afterwards.
+static u32 mapCoordinate(i64 c, u32 size, ConvolutionFilter::EdgeHandling edgeType) {
+
+	if (c >= 0 && c < size) {
+		return c;
+	}
+
+	if (edgeType == ConvolutionFilter::Repeat) {
+		return static_cast<u32>((c % size + size) % size);
+	}
+
+	return c < 0 ? 0 : size - 1;
+
+}
+
+
+
+//Copies samples between interleaved and planar rows, common pixel sizes get their own loops
+static u8* copyStrided(u8* target, u32 targetStride, const u8* source, u32 sourceStride, SizeT count) {
+
+	auto copy = [&]<u32 TargetStride, u32 SourceStride>() {
+
+		for (SizeT i = 0; i < count; i++) {
+			target[i * TargetStride] = source[i * SourceStride];
+		}
+
+	};
+
+	if (targetStride == 1 && sourceStride == 1) {
+		std::memcpy(target, source, count);
+	} else if (targetStride == 1 && sourceStride == 3) {
+		copy.template operator()<1, 3>();
+	} else if (targetStride == 1 && sourceStride == 4) {
+		copy.template operator()<1, 4>();
+	} else if (targetStride == 3 && sourceStride == 1) {
+		copy.template operator()<3, 1>();
+	} else if (targetStride == 4 && sourceStride == 1) {
+		copy.template operator()<4, 1>();
+	} else {
+
+		for (SizeT i = 0; i < count; i++) {
+			target[i * targetStride] = source[i * sourceStride];
+		}
+
+	}
+
+	return target + count * targetStride;
+
+}
+
+
+
+//Gathers count samples of a row starting at x, samples lie stride bytes apart in the source
+static void loadRow(const u8* source, u32 stride, u32 width, u32 height, ConvolutionFilter::EdgeHandling edgeType, i64 y, i64 x, u32 count, u8* out) {
+
+	const u8* row = source + SizeT(mapCoordinate(y, height, edgeType)) * width * stride;
+
+	i64 end = x + count;
+	i64 insideStart = Math::clamp(x, 0, i64(width));
+	i64 insideEnd = Math::clamp(end, insideStart, i64(width));
+
+	for (i64 i = x; i < insideStart; i++) {
+		*out++ = row[SizeT(mapCoordinate(i, width, edgeType)) * stride];
+	}
+
+	out = copyStrided(out, 1, row + insideStart * stride, stride, insideEnd - insideStart);
+
+	for (i64 i = insideEnd; i < end; i++) {
+		*out++ = row[SizeT(mapCoordinate(i, width, edgeType)) * stride];
+	}
+
+}
+
+
+
+static void storeRow(const u8* in, u32 stride, u32 count, u8* target) {
+	copyStrided(target, stride, in, 1, count);
+}
+
+
+
+//Computes a single output pixel the way ignored edges define it, normalizing only by the weights inside the image
+static u8 convolveIgnoredEdge(const u8* source, u32 stride, u32 width, u32 height, u32 maxValue, const ConvolutionKernel& kernel, u32 x, u32 y) {
+
+	i64 startX = i64(x) - kernel.getWidth() / 2;
+	i64 startY = i64(y) - kernel.getHeight() / 2;
+
+	double sum = 0;
+	double norm = 0;
+
+	for (u32 j = 0; j < kernel.getHeight(); j++) {
+
+		i64 sy = startY + j;
+
+		if (sy < 0 || sy >= height) {
+			continue;
+		}
+
+		for (u32 i = 0; i < kernel.getWidth(); i++) {
+
+			i64 sx = startX + i;
+
+			if (sx < 0 || sx >= width) {
+				continue;
+			}
+
+			double w = kernel.get(i, j);
+
+			sum += w * source[(sy * width + sx) * stride];
+			norm += Math::abs(w);
+
+		}
+
+	}
+
+	if (norm == 0) {
+		return 0;
+	}
+
+	return static_cast<u8>(Math::min(Math::abs(sum / norm) + 0.5, static_cast<double>(maxValue)));
+
+}
+
+
+
+static u32 padCount(u32 count) {
+	return (count + rowGranularity - 1) / rowGranularity * rowGranularity;
+}
+
+
+
+void ConvolutionFilter::convolveChannel(const u8* source, u8* target, u32 stride, u32 width, u32 height, u32 maxValue, const ConvolutionKernel& kernel, EdgeHandling edgeType, ThreadPool* threadPool) {
+
+	u32 kernelWidth = kernel.getWidth();
+	u32 kernelHeight = kernel.getHeight();
+	u32 anchorX = kernelWidth / 2;
+	u32 anchorY = kernelHeight / 2;
+
+	double norm = 0;
+
+	for (double w : kernel.getWeights()) {
+		norm += Math::abs(w);
+	}
+
+	if (norm == 0) {
+
+		for (SizeT i = 0; i < SizeT(width) * height; i++) {
+			target[i * stride] = 0;
+		}
+
+		return;
+
+	}
+
+	const ConvolutionKernels& k = kernels();
+
+	bool separable = kernel.isSeparable();
+	bool fixedPoint = separable && kernelWidth <= fixedMaxTaps && kernelHeight <= fixedMaxTaps;
+
+	//Weights are normalized per pass, the product of both normalizations equals the norm of the full kernel
+	auto normalize = [](std::span<const double> factor) {
+
+		double sum = 0;
+
+		for (double w : factor) {
+			sum += Math::abs(w);
+		}
+
+		std::vector<double> normalized(factor.begin(), factor.end());
+
+		for (double& w : normalized) {
+			w /= sum;
+		}
+
+		return normalized;
+
+	};
+
+	//Fixed point taps are padded to an even count since the kernels consume them in pairs
+	auto quantize = [](const std::vector<double>& factor) {
+
+		std::vector<i16> quantized((factor.size() + 1) & ~SizeT(1));
+
+		for (SizeT i = 0; i < factor.size(); i++) {
+			quantized[i] = static_cast<i16>(std::lround(factor[i] * (1 << fixedWeightBits)));
+		}
+
+		return quantized;
+
+	};
+
+	std::vector<i16> fixedHorizontal, fixedVertical;
+	std::vector<float> floatHorizontal, floatVertical, floatWeights;
+
+	if (separable) {
+
+		std::vector<double> horizontal = normalize(kernel.getHorizontalFactor());
+		std::vector<double> vertical = normalize(kernel.getVerticalFactor());
+
+		if (fixedPoint) {
+
+			fixedHorizontal = quantize(horizontal);
+			fixedVertical = quantize(vertical);
+
+		} else {
+
+			floatHorizontal.assign(horizontal.begin(), horizontal.end());
+			floatVertical.assign(vertical.begin(), vertical.end());
+
+		}
+
+	} else {
+
+		for (double w : kernel.getWeights()) {
+			floatWeights.push_back(w / norm);
+		}
+
+	}
+
+	auto processTile = [&](u32 startX, u32 endX, u32 startY, u32 endY) {
+
+		u32 count = endX - startX;
+		u32 paddedCount = padCount(count);
+		u32 rowsIn = endY - startY + kernelHeight - 1;
+		u32 rowLength = count + kernelWidth - 1;
+
+		i64 sourceX = i64(startX) - anchorX;
+		i64 sourceY = i64(startY) - anchorY;
+
+		std::vector<u8> rowBuffer(paddedCount + kernelWidth + rowGranularity);
+		std::vector<u8> outRow(paddedCount);
+
+		if (fixedPoint) {
+
+			u32 horizontalTaps = fixedHorizontal.size();
+			u32 verticalTaps = fixedVertical.size();
+
+			//One additional row is read by the zero weight of an odd vertical kernel
+			std::vector<i16> intermediate(SizeT(rowsIn + 1) * paddedCount);
+
+			for (u32 r = 0; r < rowsIn; r++) {
+
+				loadRow(source, stride, width, height, edgeType, sourceY + r, sourceX, rowLength, rowBuffer.data());
+				k.fixedRow(rowBuffer.data(), fixedHorizontal.data(), horizontalTaps, intermediate.data() + SizeT(r) * paddedCount, paddedCount);
+
+			}
+
+			for (u32 y = startY; y < endY; y++) {
+
+				k.fixedColumn(intermediate.data() + SizeT(y - startY) * paddedCount, paddedCount, fixedVertical.data(), verticalTaps, outRow.data(), paddedCount, maxValue);
+				storeRow(outRow.data(), stride, count, target + (SizeT(y) * width + startX) * stride);
+
+			}
+
+			return;
+
+		}
+
+		u32 floatRowLength = paddedCount + kernelWidth;
+
+		std::vector<float> inputRows(SizeT(rowsIn) * floatRowLength);
+		std::vector<float> accumulator(paddedCount);
+
+		for (u32 r = 0; r < rowsIn; r++) {
+
+			loadRow(source, stride, width, height, edgeType, sourceY + r, sourceX, rowLength, rowBuffer.data());
+
+			float* row = inputRows.data() + SizeT(r) * floatRowLength;
+
+			for (u32 x = 0; x < rowLength; x++) {
+				row[x] = rowBuffer[x];
+			}
+
+		}
+
+		if (separable) {
+
+			std::vector<float> intermediate(SizeT(rowsIn) * paddedCount);
+
+			for (u32 r = 0; r < rowsIn; r++) {
+				k.floatRow(inputRows.data() + SizeT(r) * floatRowLength, floatHorizontal.data(), kernelWidth, intermediate.data() + SizeT(r) * paddedCount, paddedCount);
+			}
+
+			for (u32 y = startY; y < endY; y++) {
+
+				std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+
+				k.floatColumn(intermediate.data() + SizeT(y - startY) * paddedCount, paddedCount, floatVertical.data(), kernelHeight, accumulator.data(), paddedCount);
+				k.floatStore(accumulator.data(), outRow.data(), paddedCount, maxValue);
+
+				storeRow(outRow.data(), stride, count, target + (SizeT(y) * width + startX) * stride);
+
+			}
+
+		} else {
+
+			for (u32 y = startY; y < endY; y++) {
+
+				std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+
+				for (u32 j = 0; j < kernelHeight; j++) {
+					k.floatRow(inputRows.data() + SizeT(y - startY + j) * floatRowLength, floatWeights.data() + j * kernelWidth, kernelWidth, accumulator.data(), paddedCount);
+				}
+
+				k.floatStore(accumulator.data(), outRow.data(), paddedCount, maxValue);
+
+				storeRow(outRow.data(), stride, count, target + (SizeT(y) * width + startX) * stride);
+
+			}
+
+		}
+
+	};
+
+	//Pixels whose kernel footprint leaves the image
+	i64 rightEdge = i64(width) - (kernelWidth - 1 - anchorX);
+	i64 bottomEdge = i64(height) - (kernelHeight - 1 - anchorY);
+
+	auto processBand = [&](u32 band) {
+
+		u32 startY = band * bandHeight;
+		u32 endY = Math::min(startY + bandHeight, height);
+
+		for (u32 startX = 0; startX < width; startX += tileWidth) {
+			processTile(startX, Math::min(startX + tileWidth, width), startY, endY);
+		}
+
+		if (edgeType != Ignore) {
+			return;
+		}
+
+		for (u32 y = startY; y < endY; y++) {
+
+			if (y < anchorY || y >= bottomEdge) {
+
+				for (u32 x = 0; x < width; x++) {
+					target[(SizeT(y) * width + x) * stride] = convolveIgnoredEdge(source, stride, width, height, maxValue, kernel, x, y);
+				}
+
+			} else {
+
+				u32 leftEnd = Math::min(anchorX, width);
+				u32 rightStart = static_cast<u32>(Math::clamp(rightEdge, i64(leftEnd), i64(width)));
+
+				for (u32 x = 0; x < leftEnd; x++) {
+					target[(SizeT(y) * width + x) * stride] = convolveIgnoredEdge(source, stride, width, height, maxValue, kernel, x, y);
+				}
+
+				for (u32 x = rightStart; x < width; x++) {
+					target[(SizeT(y) * width + x) * stride] = convolveIgnoredEdge(source, stride, width, height, maxValue, kernel, x, y);
+				}
+
+			}
+
+		}
+
+	};
+
+	u32 bands = (height + bandHeight - 1) / bandHeight;
+
+	if (threadPool && bands > 1) {
+
+		threadPool->parallelFor(0, bands, [&](SizeT band) {
+			processBand(band);
+		});
+
+	} else {
+
+		for (u32 band = 0; band < bands; band++) {
+			processBand(band);
+		}
+
+	}
+
+}
\ No newline at end of file
@@ -12,8 +12,83 @@
 #include "math/matrix.hpp"
 #include "types.hpp"
 
+#include <cstring>
+#include <memory>
+#include <span>
+#include <vector>
 
-// Convolution filter with a 3x3 matrix
+
+class ThreadPool;
+
+
+/*
+	Convolution kernel of arbitrary size, anchored at (width / 2, height / 2).
+	Kernels of rank one are detected on construction and applied as a horizontal followed by a vertical pass.
+*/
+class ConvolutionKernel {
+
+public:
+
+	//Weights are given row by row
+	ConvolutionKernel(u32 width, u32 height, std::span<const double> weights);
+
+	//Weights are accessed as matrix[x][y]
+	explicit ConvolutionKernel(const Mat3<double>& matrix);
+
+	static ConvolutionKernel separable(std::span<const double> horizontal, std::span<const double> vertical);
+	static ConvolutionKernel box(u32 width, u32 height);
+	static ConvolutionKernel gaussian(double sigma);
+
+	constexpr u32 getWidth() const noexcept {
+		return width;
+	}
+
+	constexpr u32 getHeight() const noexcept {
+		return height;
+	}
+
+	constexpr double get(u32 x, u32 y) const noexcept {
+		return weights[y * width + x];
+	}
+
+	constexpr std::span<const double> getWeights() const noexcept {
+		return weights;
+	}
+
+	constexpr bool isSeparable() const noexcept {
+		return !horizontalFactor.empty();
+	}
+
+	//Factors satisfy get(x, y) == horizontal[x] * vertical[y] if the kernel is separable
+	constexpr std::span<const double> getHorizontalFactor() const noexcept {
+		return horizontalFactor;
+	}
+
+	constexpr std::span<const double> getVerticalFactor() const noexcept {
+		return verticalFactor;
+	}
+
+private:
+
+	void separate();
+
+	u32 width;
+	u32 height;
+	std::vector<double> weights;
+
+	std::vector<double> horizontalFactor;
+	std::vector<double> verticalFactor;
+
+};
+
+
+
+/*
+	Convolves the selected channels of an image with a kernel.
+	Results are normalized by the sum of absolute weights that hit the image and stored as absolute values.
+	Separable kernels up to 64 taps per direction run on 16 bit fixed point, all others on floats.
+	Rows are processed in tiles, which are distributed over the thread pool if one is given.
+*/
 class ConvolutionFilter {
 
 public:
@@ -32,133 +107,92 @@ public:
 	};
 
 	template<Pixel P>
-	constexpr static void run(Image<P>& image, Mat3<double> convMat, u32 channels = Red | Green | Blue, EdgeHandling edgeType = Ignore) {
+	static void run(Image<P>& image, const Mat3<double>& convMat, u32 channels = Red | Green | Blue, EdgeHandling edgeType = Ignore, ThreadPool* threadPool = nullptr) {
+		run(image, ConvolutionKernel(convMat), channels, edgeType, threadPool);
+	}
 
-		if (!channels) {
-			return;
-		}
+	template<Pixel P>
+	static void run(Image<P>& image, const ConvolutionKernel& kernel, u32 channels = Red | Green | Blue, EdgeHandling edgeType = Ignore, ThreadPool* threadPool = nullptr) {
 
 		using Format = typename Image<P>::Format;
 
-		Image<P> buffer(image.getWidth() + 2, image.getHeight() + 2);
-		image.copy(buffer, { 0, 0, image.getWidth(), image.getHeight() }, { 1, 1 });
-
-		auto function = [&]<EdgeHandling E>() {
-
-			for(u32 y = 0; y < image.getHeight(); y++) {
-
-				for(u32 x = 0; x < image.getWidth(); x++) {
-
-					double r = 0;
-					double g = 0;
-					double b = 0;
-					double a = 0;
-
-					// Used in the end to normalize the output
-					double sumChecked = 0;
-
-					auto& p = image.getPixel(x, y);
-
-					if (!(channels & Red)) {
-						r = p.getRed();
-					}
-					if (!(channels & Green)) {
-						g = p.getGreen();
-					}
-					if (!(channels & Blue)) {
-						b = p.getBlue();
-					}
-					if (!(channels & Alpha)) {
-						a = p.getAlpha();
-					}
-
-//                    LogI("ConvFilter").print("(%i, %i)", x, y);
-					for (u32 offY = 0; offY < 3; offY++) {
-						for (u32 offX = 0; offX < 3; offX++) {
-							calcPX<P, E>(buffer, convMat, channels, x + offX, y + offY, offX, offY, r, g, b, a, sumChecked);
-//                            LogI("ConvFilter").print("(%i, %i, %i), (%i, %i), %i", r, g, b, offX, offY, sumChecked);
-						}
-					}
-
-					// Calculate the average
-					if (channels & Red) {
-						r = Math::abs(r / sumChecked);
-					}
-					if (channels & Green) {
-						g = Math::abs(g / sumChecked);
-					}
-					if (channels & Blue) {
-						b = Math::abs(b / sumChecked);
-					}
-					if (channels & Alpha) {
-						a = Math::abs(a / sumChecked);
-					}
-
-					image.getPixel(x, y).setRGBA(r + 0.5, g + 0.5, b + 0.5, a);
+		constexpr u32 Masks[4] = {Format::RedMask, Format::GreenMask, Format::BlueMask, Format::AlphaMask};
+		constexpr u32 Shifts[4] = {Format::RedShift, Format::GreenShift, Format::BlueShift, Format::AlphaShift};
+
+		constexpr bool ByteAligned = [&]() {
 
+			for (u32 c = 0; c < 4; c++) {
+
+				if (Masks[c] && (Masks[c] >> Shifts[c] != 0xFF || Shifts[c] % 8)) {
+					return false;
 				}
 
 			}
 
-		};
+			return true;
 
-		switch(edgeType) {
+		}();
 
-			case EdgeHandling::Ignore:
-				function.template operator()<EdgeHandling::Ignore>();
-				break;
+		u32 width = image.getWidth();
+		u32 height = image.getHeight();
 
-			case EdgeHandling::Clamp:
-				// Set up the borders of the buffer image so we don't have to worry about them anymore
-				buffer.copy( { 1, 1, buffer.getWidth() - 2, 1 }, { 1, 0 } );
-				buffer.copy( { 1, buffer.getHeight() - 2, buffer.getWidth() - 2, 1 }, { 1, buffer.getHeight() - 1 } );
-				buffer.copy( { 1, 0, 1, buffer.getHeight() }, { 0, 0 } );
-				buffer.copy( { buffer.getWidth() - 2, 0, 1, buffer.getHeight() }, { buffer.getWidth() - 1, 0 } );
+		if (!(channels & (Red | Green | Blue | Alpha)) || !width || !height) {
+			return;
+		}
 
-				function.template operator()<EdgeHandling::Clamp>();
-				break;
+		SizeT pixelCount = SizeT(width) * height;
 
-			default:
-			case EdgeHandling::Repeat:
-				// Set up the borders of the buffer image so we don't have to worry about them anymore
-				buffer.copy( { 1, 1, buffer.getWidth() - 2, 1 }, { 1, buffer.getHeight() - 1 } );
-				buffer.copy( { 1, buffer.getHeight() - 2, buffer.getWidth() - 2, 1 }, { 1, 0 } );
-				buffer.copy( { 1, 0, 1, buffer.getHeight() }, { buffer.getWidth() - 1, 0 } );
-				buffer.copy( { buffer.getWidth() - 2, 0, 1, buffer.getHeight() }, { 0, 0 } );
+		auto pixels = image.getImageBuffer();
+		u8* bytes = reinterpret_cast<u8*>(pixels.data());
 
-				function.template operator()<EdgeHandling::Repeat>();
-				break;
+		//Byte sized channels are convolved straight from a copy of the image, everything else goes through planes
+		if constexpr (ByteAligned) {
 
-		}
+			constexpr u32 Stride = Format::BytesPerPixel;
 
-	}
+			std::unique_ptr<u8[]> copy(new u8[pixelCount * Stride]);
+			std::memcpy(copy.get(), bytes, pixelCount * Stride);
 
-private:
+			for (u32 c = 0; c < 4; c++) {
+
+				if (Masks[c] && (channels & (1 << c))) {
+					convolveChannel(copy.get() + Shifts[c] / 8, bytes + Shifts[c] / 8, Stride, width, height, 0xFF, kernel, edgeType, threadPool);
+				}
 
-	// Multiplies the pixel with the corresponding entry in the matrix. Expects all pixel values to be valid
-	template<Pixel P, EdgeHandling E>
-	constexpr static void calcPX(Image<P>& buffer, Mat3<double> convMat, u32 channels, u32 imX, u32 imY, u32 matX, u32 matY, double& r, double& g, double& b, double& a, double& checked) {
-		if constexpr (E == Ignore) {
-			if (imX == 0 || imX == buffer.getWidth() - 1 || imY == 0 || imY == buffer.getHeight() - 1) {
-				return;
 			}
-		}
 
-		auto& p = buffer.getPixel(imX, imY);
+		} else {
+
+			std::unique_ptr<u8[]> planes(new u8[pixelCount * 2]);
+
+			u8* source = planes.get();
+			u8* target = source + pixelCount;
+
+			for (u32 c = 0; c < 4; c++) {
+
+				if (!Masks[c] || !(channels & (1 << c))) {
+					continue;
+				}
+
+				for (SizeT i = 0; i < pixelCount; i++) {
+					source[i] = (pixels[i].pack() & Masks[c]) >> Shifts[c];
+				}
+
+				convolveChannel(source, target, 1, width, height, Masks[c] >> Shifts[c], kernel, edgeType, threadPool);
+
+				for (SizeT i = 0; i < pixelCount; i++) {
+					pixels[i].unpack((pixels[i].pack() & ~Masks[c]) | target[i] << Shifts[c]);
+				}
+
+			}
 
-		if (channels & Red) {
-			r += convMat[matX][matY] * p.getRed();
-		}
-		if (channels & Green) {
-			g += convMat[matX][matY] * p.getGreen();
-		}
-		if (channels & Blue) {
-			b += convMat[matX][matY] * p.getBlue();
-		}
-		if (channels & Alpha) {
-			a += convMat[matX][matY] * p.getAlpha();
 		}
 
-		checked += Math::abs(convMat[matX][matY]);
 	}
+
+private:
+
+	//Convolves a single channel with values up to maxValue, consecutive samples lie stride bytes apart
+	static void convolveChannel(const u8* source, u8* target, u32 stride, u32 width, u32 height, u32 maxValue, const ConvolutionKernel& kernel, EdgeHandling edgeType, ThreadPool* threadPool);
+
 };
\ No newline at end of file
@@ -9,7 +9,9 @@
 #pragma once
 
 #include "pixel.hpp"
+#include "conversion.hpp"
 #include "rawimage.hpp"
+#include "resampler.hpp"
 #include "math/vector.hpp"
 #include "math/rectangle.hpp"
 #include "types.hpp"
@@ -20,12 +22,6 @@
 
 
 
-enum class ImageScaling {
-	Nearest,
-	Bilinear
-};
-
-
 class ImageException : public ArclightException {
 
 public:
@@ -42,7 +38,7 @@ class Image {
 public:
 
 	using Format = PixelFormat<P>;
-	using PixelType = PixelType<P>;
+	using PixelType = ::PixelType<P>;
 
 	constexpr static u32 PixelBytes = Format::BytesPerPixel;
 
@@ -76,12 +72,14 @@ public:
 
 	template<class Filter, class... Args> void applyFilter(Args&&... args);
 
-	constexpr void resize(ImageScaling scaling, u32 w, u32 h = 0);
+	constexpr void resize(ImageScaling scaling, u32 w, u32 h = 0, ThreadPool* threadPool = nullptr);
+	void resample(ImageResampler& resampler, Image& target, ThreadPool* threadPool = nullptr) const;
 	constexpr void flipY();
 	constexpr void copy(Image<P>& destImage, const RectUI& src, const Vec2ui& dest);
 	constexpr void copy(const RectUI& src, const Vec2ui& dest);
 
-	template<Pixel Q> Image<Q> convert() const;
+	template<Pixel Q> Image<Q> convert(ThreadPool* threadPool = nullptr) const&;
+	template<Pixel Q> Image<Q> convert(ThreadPool* threadPool = nullptr) &&;
 
 	RawImage makeRaw();
 	static Image fromRaw(RawImage& image, bool allowConversion = true);
@@ -92,7 +90,25 @@ public:
 
 private:
 
-	template<Pixel P> friend class Image;
+	template<Pixel Q> friend class Image;
+
+	//True if every channel occupies a whole byte, which allows resampling the raw data
+	constexpr static bool hasByteChannels() {
+
+		constexpr u32 Masks[4] = {Format::RedMask, Format::GreenMask, Format::BlueMask, Format::AlphaMask};
+		constexpr u32 Shifts[4] = {Format::RedShift, Format::GreenShift, Format::BlueShift, Format::AlphaShift};
+
+		for (u32 c = 0; c < 4; c++) {
+
+			if (Masks[c] && (Masks[c] >> Shifts[c] != 0xFF || Shifts[c] % 8)) {
+				return false;
+			}
+
+		}
+
+		return true;
+
+	}
 
 	u32 width;
 	u32 height;
@@ -150,7 +150,7 @@ void Image<P>::applyFilter(Args&&... args) {
 }
 
 template<Pixel P>
-constexpr void Image<P>::resize(ImageScaling scaling, u32 w, u32 h) {
+constexpr void Image<P>::resize(ImageScaling scaling, u32 w, u32 h, ThreadPool* threadPool) {
 
 	if (!width || !height) {
 		LogE("Image") << "Cannot resize zero-dimensioned image";
@@ -176,6 +176,44 @@ constexpr void Image<P>::resize(ImageScaling scaling, u32 w, u32 h) {
 		return;
 	}
 
+	if (scaling == ImageScaling::Bicubic || scaling == ImageScaling::Lanczos3 || scaling == ImageScaling::Area) {
+
+		if constexpr (hasByteChannels()) {
+
+			ImageResampler resampler(scaling, width, height, w, h, PixelBytes);
+			std::span<u8> source(getImageData(), pixelCount() * PixelBytes);
+
+			//Shrinking images are resampled into their own buffer
+			if (u64(w) * h <= pixelCount()) {
+
+				resampler.run(source, source.subspan(0, SizeT(w) * h * PixelBytes), threadPool);
+
+			} else {
+
+				std::unique_ptr<PixelType[]> resizedPixelData = std::make_unique<PixelType[]>(w * h);
+				resampler.run(source, {reinterpret_cast<u8*>(resizedPixelData.get()), SizeT(w) * h * PixelBytes}, threadPool);
+
+				pixels = std::move(resizedPixelData);
+
+			}
+
+			width = w;
+			height = h;
+
+		} else {
+
+			//Packed channels are expanded to bytes first
+			Image<Pixel::RGB8> expanded = convert<Pixel::RGB8>(threadPool);
+			expanded.resize(scaling, w, h, threadPool);
+
+			*this = expanded.template convert<P>(threadPool);
+
+		}
+
+		return;
+
+	}
+
 	std::unique_ptr<PixelType[]> resizedPixelData = std::make_unique<PixelType[]>(w * h);
 
 	switch(scaling) {
@@ -275,6 +313,19 @@ constexpr void Image<P>::resize(ImageScaling scaling, u32 w, u32 h) {
 
 }
 
+template<Pixel P>
+void Image<P>::resample(ImageResampler& resampler, Image& target, ThreadPool* threadPool) const {
+
+	static_assert(hasByteChannels(), "Resampling requires byte sized channels");
+
+	if (resampler.getChannels() != PixelBytes || resampler.getSourceWidth() != width || resampler.getSourceHeight() != height || resampler.getTargetWidth() != target.width || resampler.getTargetHeight() != target.height) {
+		throw ImageException("Resampler geometry does not match the images");
+	}
+
+	resampler.run({getImageData(), pixelCount() * PixelBytes}, {target.getImageData(), target.pixelCount() * PixelBytes}, threadPool);
+
+}
+
 template<Pixel P>
 constexpr void Image<P>::flipY() {
 
@@ -354,25 +405,51 @@ constexpr void Image<P>::copy(const RectUI& src, const Vec2ui& dest) {
 
 template<Pixel P>
 template<Pixel Q>
-Image<Q> Image<P>::convert() const {
+Image<Q> Image<P>::convert(ThreadPool* threadPool) const& {
 
 	if constexpr (P == Q) {
 		return *this;
 	}
 
-	Image<Q> img(width, height);
+	Image<Q> img;
+	img.width = width;
+	img.height = height;
+	img.pixels = std::make_unique_for_overwrite<::PixelType<Q>[]>(pixelCount());
 
-	for (u32 y = 0; y < height; y++) {
+	PixelConversion::convert(P, Q, getImageData(), img.getImageData(), pixelCount(), threadPool);
 
-		for (u32 x = 0; x < width; x++) {
+	return img;
 
-			img.setPixel(x, y, PixelConverter::convert<Q>(getPixel(x, y)));
+}
 
-		}
 
-	}
+template<Pixel P>
+template<Pixel Q>
+Image<Q> Image<P>::convert(ThreadPool* threadPool) && {
 
-	return img;
+	if constexpr (P == Q) {
+
+		return std::move(*this);
+
+	} else if constexpr (PixelBytes == Image<Q>::PixelBytes) {
+
+		//Equally sized pixels are converted in place and the buffer is handed over
+		PixelConversion::convert(P, Q, getImageData(), getImageData(), pixelCount(), threadPool);
+
+		Image<Q> img;
+		img.width = width;
+		img.height = height;
+		img.pixels = std::unique_ptr<::PixelType<Q>[]>(reinterpret_cast<::PixelType<Q>*>(pixels.release()));
+
+		reset();
+
+		return img;
+
+	} else {
+
+		return std::as_const(*this).template convert<Q>(threadPool);
+
+	}
 
 }
 
@@ -418,7 +495,7 @@ Image<P> Image<P>::fromRaw(RawImage& image, bool allowConversion) {
 		newImage.height = h;
 		newImage.pixels = std::unique_ptr<Type[]>(reinterpret_cast<Type*>(image.release().data()));
 
-		return newImage.template convert<P>();
+		return std::move(newImage).template convert<P>();
 
 	};
 
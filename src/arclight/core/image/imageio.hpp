@@ -12,11 +12,15 @@
 #include "decode/decoder.hpp"
 #include "decode/bitmapdecoder.hpp"
 #include "decode/jpegdecoder.hpp"
+#include "decode/pngdecoder.hpp"
 #include "decode/ppmdecoder.hpp"
 #include "decode/qoidecoder.hpp"
 #include "decode/tgadecoder.hpp"
 #include "encode/encoder.hpp"
+#include "encode/jpegencoder.hpp"
+#include "encode/pngencoder.hpp"
 #include "encode/ppmencoder.hpp"
+#include "encode/qoiencoder.hpp"
 #include "util/bool.hpp"
 
 
@@ -82,12 +86,12 @@ namespace ImageIO {
 
 	template<Pixel P, CC::ImageEncoder Encoder, class Img, class... Args>
 	std::vector<u8> save(const Img& image, Args&&... args) {
-		return encode<Encoder, Args...>(image, P, std::forward<Args>(args)...).getBuffer();
+		return encode<Encoder, Img, Args...>(image, P, std::forward<Args>(args)...).getBuffer();
 	}
 
 	template<Pixel P, CC::ImageEncoder Encoder, class Img, class... Args>
 	void save(const Path& path, const Img& image, Args&&... args) {
-		Detail::saveFile(path, save<P, Encoder, Args...>(image, P, std::forward<Args>(args)...));
+		Detail::saveFile(path, save<P, Encoder, Img, Args...>(image, std::forward<Args>(args)...));
 	}
 
 
@@ -114,13 +118,13 @@ namespace ImageIO {
 		if constexpr (!CC::Equal<Img, RawImage>)
 			reqFormat = Img::getFormat();
 		
-		return encode<Encoder, Args...>(image, reqFormat, std::forward<Args>(args)...).getBuffer();
+		return encode<Encoder, Img, Args...>(image, reqFormat, std::forward<Args>(args)...).getBuffer();
 
 	}
 
 	template<CC::ImageEncoder Encoder, class Img, class... Args>
 	void save(const Path& path, const Img& image, Args&&... args) {
-		Detail::saveFile(path, save<Encoder, Args...>(image, std::forward<Args>(args)...));
+		Detail::saveFile(path, save<Encoder, Img, Args...>(image, std::forward<Args>(args)...));
 	}
 
 
@@ -146,6 +150,8 @@ namespace ImageIO {
 				return doLoad.template operator()<BitmapDecoder>(path);
 			} else if (Bool::any(ext, ".jpg", ".jpeg", ".jfif")) {
 				return doLoad.template operator()<JPEGDecoder>(path);
+			} else if (ext == ".png") {
+				return doLoad.template operator()<PNGDecoder>(path);
 			} else if (ext == ".ppm") {
 	            return doLoad.template operator()<PPMDecoder>(path);
 	        } else if (ext == ".qoi") {
@@ -163,9 +169,15 @@ namespace ImageIO {
 
 			std::string ext = path.getExtension();
 
-			if (ext == ".ppm") {
+			if (Bool::any(ext, ".jpg", ".jpeg", ".jfif")) {
+				save<JPEGEncoder, Img>(path, image);
+			} else if (ext == ".png") {
+				save<PNGEncoder, Img>(path, image);
+			} else if (ext == ".ppm") {
 	            save<PPMEncoder, Img>(path, image);
-	        } else {
+	        } else if (ext == ".qoi") {
+				save<QOIEncoder, Img>(path, image);
+			} else {
 				throw ImageException("Unknown image file format");
 			}
 
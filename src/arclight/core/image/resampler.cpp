@@ -0,0 +1,571 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 resampler.cpp
+ */
+
+#include "resampler.hpp"
+#include "image.hpp"
+#include "arcintrinsic.hpp"
+#include "concurrent/threadpool.hpp"
+#include "math/math.hpp"
+#include "util/cpuid.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numbers>
+
+
+
+//Rows per parallel task
+constexpr static u32 bandHeight = 32;
+
+//Taps are padded to this granularity, intermediate rows to the vertical kernel width
+constexpr static u32 tapGranularity = 4;
+constexpr static u32 rowGranularity = 16;
+
+//Weights carry 14 fractional bits, the intermediate buffer 6
+constexpr static u32 weightBits = 14;
+constexpr static u32 intermediateBits = 6;
+constexpr static u32 horizontalShift = weightBits - intermediateBits;
+constexpr static u32 verticalShift = weightBits + intermediateBits;
+
+using HorizontalFunction = void(*)(const u8* in, u32 width, const u32* starts, const i16* weights, u32 taps, i16* out, u32 count);
+using VerticalFunction = void(*)(const i16* rows, SizeT stride, const i16* weights, u32 taps, u8* out, u32 count);
+
+
+
+static double bicubicFilter(double x) {
+
+	constexpr double a = -0.5;
+
+	x = std::abs(x);
+
+	if (x < 1) {
+		return ((a + 2) * x - (a + 3)) * x * x + 1;
+	} else if (x < 2) {
+		return ((a * x - 5 * a) * x + 8 * a) * x - 4 * a;
+	}
+
+	return 0;
+
+}
+
+
+
+static double lanczos3Filter(double x) {
+
+	if (x == 0) {
+		return 1;
+	} else if (x <= -3 || x >= 3) {
+		return 0;
+	}
+
+	double px = std::numbers::pi * x;
+
+	return 3 * std::sin(px) * std::sin(px / 3) / (px * px);
+
+}
+
+
+
+ImageResampler::ImageResampler(ImageScaling scaling, u32 sourceWidth, u32 sourceHeight, u32 targetWidth, u32 targetHeight, u32 channels) : scaling(scaling), channels(channels) {
+
+	if (scaling != ImageScaling::Bicubic && scaling != ImageScaling::Lanczos3 && scaling != ImageScaling::Area) {
+		throw ImageException("Resampler does not support the requested scaling");
+	}
+
+	if (!sourceWidth || !sourceHeight || !targetWidth || !targetHeight) {
+		throw ImageException("Cannot resample zero-dimensioned images");
+	}
+
+	if (channels < 1 || channels > 4) {
+		throw ImageException("Resampler supports between 1 and 4 channels");
+	}
+
+	horizontal = computeAxis(scaling, sourceWidth, targetWidth);
+	vertical = computeAxis(scaling, sourceHeight, targetHeight);
+
+	//One spare sample per row absorbs the overlapping stores of the three channel kernel
+	intermediateStride = (SizeT(targetWidth) * channels + rowGranularity) / rowGranularity * rowGranularity;
+
+	//Rows past the source stay zero, windows of short columns may reach into them
+	SizeT rows = SizeT(sourceHeight) + vertical.taps;
+
+	intermediate = std::make_unique<i16[]>(rows * intermediateStride);
+
+}
+
+
+
+/*
+	Computes the windows and Q14 weights for one axis.
+	Weights are normalized per target sample so that they add up to exactly one.
+	Zero weights at the window borders are dropped before all windows are padded to a common tap count.
+	Windows are shifted left to end inside the source wherever possible so that the kernels never need bounds checks.
+*/
+ImageResampler::Axis ImageResampler::computeAxis(ImageScaling scaling, u32 sourceSize, u32 targetSize) {
+
+	constexpr i32 One = 1 << weightBits;
+
+	double scale = static_cast<double>(sourceSize) / targetSize;
+	double filterScale = Math::max(scale, 1.0);
+	double support = scaling == ImageScaling::Lanczos3 ? 3 * filterScale : 2 * filterScale;
+
+	std::vector<u32> starts(targetSize);
+	std::vector<u32> counts(targetSize);
+	std::vector<std::vector<i32>> windows(targetSize);
+	std::vector<double> buffer;
+
+	u32 maxCount = 1;
+
+	for (u32 x = 0; x < targetSize; x++) {
+
+		i64 lo, hi;
+
+		buffer.clear();
+
+		if (scaling == ImageScaling::Area) {
+
+			//Weights are the exact overlap of the source pixels with the target footprint
+			double begin = x * scale;
+			double end = (x + 1) * scale;
+
+			lo = Math::clamp(static_cast<i64>(std::floor(begin)), 0, i64(sourceSize) - 1);
+			hi = Math::clamp(static_cast<i64>(std::ceil(end)), lo + 1, i64(sourceSize));
+
+			for (i64 i = lo; i < hi; i++) {
+				buffer.push_back(Math::max(Math::min(end, i + 1.0) - Math::max(begin, static_cast<double>(i)), 0.0));
+			}
+
+		} else {
+
+			double center = (x + 0.5) * scale;
+
+			lo = Math::clamp(static_cast<i64>(std::floor(center - support)), 0, i64(sourceSize) - 1);
+			hi = Math::clamp(static_cast<i64>(std::ceil(center + support)), lo + 1, i64(sourceSize));
+
+			for (i64 i = lo; i < hi; i++) {
+
+				double t = (i + 0.5 - center) / filterScale;
+				buffer.push_back(scaling == ImageScaling::Lanczos3 ? lanczos3Filter(t) : bicubicFilter(t));
+
+			}
+
+		}
+
+		double sum = 0;
+
+		for (double w : buffer) {
+			sum += w;
+		}
+
+		std::vector<i32>& window = windows[x];
+		window.resize(buffer.size());
+
+		if (sum == 0) {
+
+			//Degenerate windows fall back to the nearest sample
+			std::fill(window.begin(), window.end(), 0);
+			window[Math::min(static_cast<SizeT>((x + 0.5) * scale - lo), window.size() - 1)] = One;
+
+		} else {
+
+			//Rounding the running sum keeps every weight within one unit and the total exact
+			double partial = 0;
+			i32 previous = 0;
+
+			for (SizeT i = 0; i < buffer.size(); i++) {
+
+				partial += buffer[i];
+
+				i32 current = static_cast<i32>(std::lround(partial / sum * One));
+				window[i] = current - previous;
+				previous = current;
+
+			}
+
+		}
+
+		SizeT first = 0;
+		SizeT last = window.size();
+
+		while (window[first] == 0) {
+			first++;
+		}
+
+		while (window[last - 1] == 0) {
+			last--;
+		}
+
+		window.erase(window.begin() + last, window.end());
+		window.erase(window.begin(), window.begin() + first);
+
+		starts[x] = static_cast<u32>(lo + first);
+		counts[x] = static_cast<u32>(window.size());
+		maxCount = Math::max(maxCount, counts[x]);
+
+	}
+
+	Axis axis;
+	axis.sourceSize = sourceSize;
+	axis.targetSize = targetSize;
+	axis.taps = (maxCount + tapGranularity - 1) / tapGranularity * tapGranularity;
+	axis.starts.resize(targetSize);
+	axis.weights.resize(SizeT(targetSize) * axis.taps);
+
+	for (u32 x = 0; x < targetSize; x++) {
+
+		u32 start = starts[x];
+		u32 shift = 0;
+
+		if (sourceSize >= axis.taps && start + axis.taps > sourceSize) {
+
+			shift = start + axis.taps - sourceSize;
+			start -= shift;
+
+		}
+
+		axis.starts[x] = start;
+
+		i16* weights = axis.weights.data() + SizeT(x) * axis.taps;
+
+		for (u32 i = 0; i < counts[x]; i++) {
+			weights[shift + i] = static_cast<i16>(windows[x][i]);
+		}
+
+	}
+
+	return axis;
+
+}
+
+
+
+template<u32 Channels>
+static void horizontalDefault(const u8* in, u32 width, const u32* starts, const i16* weights, u32 taps, i16* out, u32 count) {
+
+	for (u32 x = 0; x < count; x++) {
+
+		u32 start = starts[x];
+		u32 end = Math::min(taps, width - start);
+
+		const u8* p = in + SizeT(start) * Channels;
+		const i16* w = weights + SizeT(x) * taps;
+
+		i32 sum[Channels] = {};
+
+		for (u32 i = 0; i < end; i++) {
+
+			for (u32 c = 0; c < Channels; c++) {
+				sum[c] += w[i] * p[i * Channels + c];
+			}
+
+		}
+
+		for (u32 c = 0; c < Channels; c++) {
+			out[x * Channels + c] = static_cast<i16>(Math::clamp((sum[c] + (1 << (horizontalShift - 1))) >> horizontalShift, -32768, 32767));
+		}
+
+	}
+
+}
+
+
+
+static void verticalDefault(const i16* rows, SizeT stride, const i16* weights, u32 taps, u8* out, u32 count) {
+
+	for (u32 x = 0; x < count; x++) {
+
+		i32 sum = 0;
+
+		for (u32 j = 0; j < taps; j++) {
+			sum += weights[j] * rows[j * stride + x];
+		}
+
+		out[x] = static_cast<u8>(Math::clamp((sum + (1 << (verticalShift - 1))) >> verticalShift, 0, 255));
+
+	}
+
+}
+
+
+
+#ifdef ARC_DISPATCH_X86
+
+/*
+	Four taps are handled per step: the samples of tap pairs are interleaved per channel so that madd applies both weights at once.
+	The first pair occupies the lower lane, the second one the upper lane, both lanes are summed up at the end.
+*/
+ARC_TARGET("avx2") static void horizontal4AVX2(const u8* in, u32, const u32* starts, const i16* weights, u32 taps, i16* out, u32 count) {
+
+	const __m128i order = _mm_setr_epi8(0, 4, 1, 5, 2, 6, 3, 7, 8, 12, 9, 13, 10, 14, 11, 15);
+	const __m128i rounding = _mm_set1_epi32(1 << (horizontalShift - 1));
+
+	for (u32 x = 0; x < count; x++) {
+
+		const u8* p = in + SizeT(starts[x]) * 4;
+		const i16* w = weights + SizeT(x) * taps;
+
+		__m256i sum = _mm256_setzero_si256();
+
+		for (u32 i = 0; i < taps; i += 4) {
+
+			__m256i s = _mm256_cvtepu8_epi16(_mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i * 4)), order));
+			__m128i q = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(w + i));
+			__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_shuffle_epi32(q, 0x00)), _mm_shuffle_epi32(q, 0x55), 1);
+
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(s, v));
+
+		}
+
+		__m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		total = _mm_srai_epi32(_mm_add_epi32(total, rounding), horizontalShift);
+
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + SizeT(x) * 4), _mm_packs_epi32(total, total));
+
+	}
+
+}
+
+
+
+//Same as above, the twelve bytes of four pixels are fetched with two overlapping loads to stay inside the row
+ARC_TARGET("avx2") static void horizontal3AVX2(const u8* in, u32, const u32* starts, const i16* weights, u32 taps, i16* out, u32 count) {
+
+	const __m128i order = _mm_setr_epi8(0, 3, 1, 4, 2, 5, -1, -1, 10, 13, 11, 14, 12, 15, -1, -1);
+	const __m128i rounding = _mm_set1_epi32(1 << (horizontalShift - 1));
+
+	for (u32 x = 0; x < count; x++) {
+
+		const u8* p = in + SizeT(starts[x]) * 3;
+		const i16* w = weights + SizeT(x) * taps;
+
+		__m256i sum = _mm256_setzero_si256();
+
+		for (u32 i = 0; i < taps; i += 4) {
+
+			const u8* q = p + i * 3;
+			__m128i b = _mm_unpacklo_epi64(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(q)), _mm_loadl_epi64(reinterpret_cast<const __m128i*>(q + 4)));
+
+			__m256i s = _mm256_cvtepu8_epi16(_mm_shuffle_epi8(b, order));
+			__m128i c = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(w + i));
+			__m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_shuffle_epi32(c, 0x00)), _mm_shuffle_epi32(c, 0x55), 1);
+
+			sum = _mm256_add_epi32(sum, _mm256_madd_epi16(s, v));
+
+		}
+
+		__m128i total = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+		total = _mm_srai_epi32(_mm_add_epi32(total, rounding), horizontalShift);
+
+		//The fourth value spills into the next pixel, which is written afterwards, or into the spare sample of the row
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(out + SizeT(x) * 3), _mm_packs_epi32(total, total));
+
+	}
+
+}
+
+
+
+ARC_TARGET("avx2") static void horizontal1AVX2(const u8* in, u32, const u32* starts, const i16* weights, u32 taps, i16* out, u32 count) {
+
+	for (u32 x = 0; x < count; x++) {
+
+		const u8* p = in + starts[x];
+		const i16* w = weights + SizeT(x) * taps;
+
+		__m128i sum = _mm_setzero_si128();
+
+		for (u32 i = 0; i < taps; i += 4) {
+
+			u32 samples;
+			std::memcpy(&samples, p + i, 4);
+
+			__m128i s = _mm_cvtepu8_epi16(_mm_cvtsi32_si128(static_cast<i32>(samples)));
+			sum = _mm_add_epi32(sum, _mm_madd_epi16(s, _mm_loadl_epi64(reinterpret_cast<const __m128i*>(w + i))));
+
+		}
+
+		i32 total = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 4));
+
+		out[x] = static_cast<i16>(Math::clamp((total + (1 << (horizontalShift - 1))) >> horizontalShift, -32768, 32767));
+
+	}
+
+}
+
+
+
+ARC_TARGET("avx2") static __m128i verticalBlockAVX2(const i16* rows, SizeT stride, const i16* weights, u32 taps) {
+
+	const __m256i rounding = _mm256_set1_epi32(1 << (verticalShift - 1));
+
+	__m256i sumLow = _mm256_setzero_si256();
+	__m256i sumHigh = _mm256_setzero_si256();
+
+	for (u32 j = 0; j < taps; j += 2) {
+
+		__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + j * stride));
+		__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rows + (j + 1) * stride));
+		__m256i w = _mm256_set1_epi32(static_cast<u16>(weights[j]) | static_cast<u32>(static_cast<u16>(weights[j + 1])) << 16);
+
+		sumLow = _mm256_add_epi32(sumLow, _mm256_madd_epi16(_mm256_unpacklo_epi16(a, b), w));
+		sumHigh = _mm256_add_epi32(sumHigh, _mm256_madd_epi16(_mm256_unpackhi_epi16(a, b), w));
+
+	}
+
+	sumLow = _mm256_srai_epi32(_mm256_add_epi32(sumLow, rounding), verticalShift);
+	sumHigh = _mm256_srai_epi32(_mm256_add_epi32(sumHigh, rounding), verticalShift);
+
+	//Unpacking and packing both work per lane, so the results are in order again, saturation clamps them to bytes
+	__m256i words = _mm256_packs_epi32(sumLow, sumHigh);
+	__m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(words, words), 0xD8);
+
+	return _mm256_castsi256_si128(bytes);
+
+}
+
+
+
+ARC_TARGET("avx2") static void verticalAVX2(const i16* rows, SizeT stride, const i16* weights, u32 taps, u8* out, u32 count) {
+
+	u32 x = 0;
+
+	for (; x + 16 <= count; x += 16) {
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), verticalBlockAVX2(rows + x, stride, weights, taps));
+	}
+
+	//Intermediate rows are padded, only the target needs a partial store
+	if (x < count) {
+
+		alignas(16) u8 tail[16];
+		_mm_store_si128(reinterpret_cast<__m128i*>(tail), verticalBlockAVX2(rows + x, stride, weights, taps));
+
+		std::memcpy(out + x, tail, count - x);
+
+	}
+
+}
+
+#endif
+
+
+
+struct ResamplerKernels {
+
+	HorizontalFunction horizontal[4];
+	VerticalFunction vertical;
+
+};
+
+
+
+static constexpr ResamplerKernels defaultKernels = {
+	{horizontalDefault<1>, horizontalDefault<2>, horizontalDefault<3>, horizontalDefault<4>},
+	verticalDefault
+};
+
+
+
+static const ResamplerKernels& kernels() {
+
+	static const ResamplerKernels table = []() {
+
+		ResamplerKernels k = defaultKernels;
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::AVX2)) {
+
+			k.horizontal[0] = horizontal1AVX2;
+			k.horizontal[2] = horizontal3AVX2;
+			k.horizontal[3] = horizontal4AVX2;
+			k.vertical = verticalAVX2;
+
+		}
+
+#endif
+
+		return k;
+
+	}();
+
+	return table;
+
+}
+
+
+
+void ImageResampler::run(std::span<const u8> source, std::span<u8> target, ThreadPool* threadPool) {
+
+	SizeT sourceRowSize = SizeT(horizontal.sourceSize) * channels;
+	SizeT targetRowSize = SizeT(horizontal.targetSize) * channels;
+
+	if (source.size() < sourceRowSize * vertical.sourceSize) {
+		throw ImageException("Resampling source is smaller than the resampler geometry");
+	}
+
+	if (target.size() < targetRowSize * vertical.targetSize) {
+		throw ImageException("Resampling target is smaller than the resampler geometry");
+	}
+
+	const ResamplerKernels& k = kernels();
+
+	//The vectorized row kernels rely on all windows ending inside the row
+	HorizontalFunction horizontalPass = horizontal.sourceSize >= horizontal.taps ? k.horizontal[channels - 1] : defaultKernels.horizontal[channels - 1];
+	VerticalFunction verticalPass = k.vertical;
+
+	auto filterRows = [&](SizeT band) {
+
+		u32 start = static_cast<u32>(band * bandHeight);
+		u32 end = Math::min(start + bandHeight, vertical.sourceSize);
+
+		for (u32 y = start; y < end; y++) {
+			horizontalPass(source.data() + y * sourceRowSize, horizontal.sourceSize, horizontal.starts.data(), horizontal.weights.data(), horizontal.taps, intermediate.get() + y * intermediateStride, horizontal.targetSize);
+		}
+
+	};
+
+	auto filterColumns = [&](SizeT band) {
+
+		u32 start = static_cast<u32>(band * bandHeight);
+		u32 end = Math::min(start + bandHeight, vertical.targetSize);
+
+		for (u32 y = start; y < end; y++) {
+
+			const i16* rows = intermediate.get() + vertical.starts[y] * intermediateStride;
+			const i16* weights = vertical.weights.data() + SizeT(y) * vertical.taps;
+
+			verticalPass(rows, intermediateStride, weights, vertical.taps, target.data() + y * targetRowSize, static_cast<u32>(targetRowSize));
+
+		}
+
+	};
+
+	//The horizontal pass has to finish before any target row is written, the target may overlap the source
+	auto distribute = [&](u32 rows, auto&& function) {
+
+		u32 bands = (rows + bandHeight - 1) / bandHeight;
+
+		if (threadPool && bands > 1) {
+
+			threadPool->parallelFor(0, bands, function);
+
+		} else {
+
+			for (u32 band = 0; band < bands; band++) {
+				function(band);
+			}
+
+		}
+
+	};
+
+	distribute(vertical.sourceSize, filterRows);
+	distribute(vertical.targetSize, filterColumns);
+
+}
\ No newline at end of file
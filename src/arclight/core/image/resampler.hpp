@@ -0,0 +1,97 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 resampler.hpp
+ */
+
+#pragma once
+
+#include "types.hpp"
+
+#include <memory>
+#include <span>
+#include <vector>
+
+
+
+enum class ImageScaling {
+	Nearest,
+	Bilinear,
+	Bicubic,
+	Lanczos3,
+	Area
+};
+
+
+class ThreadPool;
+
+
+
+/*
+	Separable resampler for interleaved images with 8 bit channels.
+	Weight tables and the intermediate buffer are prepared on construction, so repeated runs of the same geometry do not allocate.
+	Rows are filtered horizontally into a 16 bit fixed point buffer first, then the columns are filtered into the target.
+	Since the source is consumed completely before the first target row is written, target and source may overlap.
+*/
+class ImageResampler {
+
+public:
+
+	//Supports Bicubic, Lanczos3 and Area, channels range from 1 to 4
+	ImageResampler(ImageScaling scaling, u32 sourceWidth, u32 sourceHeight, u32 targetWidth, u32 targetHeight, u32 channels);
+
+	//Source and target hold tightly packed rows of sourceWidth and targetWidth pixels respectively
+	void run(std::span<const u8> source, std::span<u8> target, ThreadPool* threadPool = nullptr);
+
+	constexpr ImageScaling getScaling() const noexcept {
+		return scaling;
+	}
+
+	constexpr u32 getSourceWidth() const noexcept {
+		return horizontal.sourceSize;
+	}
+
+	constexpr u32 getSourceHeight() const noexcept {
+		return vertical.sourceSize;
+	}
+
+	constexpr u32 getTargetWidth() const noexcept {
+		return horizontal.targetSize;
+	}
+
+	constexpr u32 getTargetHeight() const noexcept {
+		return vertical.targetSize;
+	}
+
+	constexpr u32 getChannels() const noexcept {
+		return channels;
+	}
+
+private:
+
+	//Every target sample reads taps consecutive source samples from its start on
+	struct Axis {
+
+		u32 sourceSize;
+		u32 targetSize;
+		u32 taps;
+
+		std::vector<u32> starts;
+		std::vector<i16> weights;
+
+	};
+
+	static Axis computeAxis(ImageScaling scaling, u32 sourceSize, u32 targetSize);
+
+	ImageScaling scaling;
+	u32 channels;
+
+	Axis horizontal;
+	Axis vertical;
+
+	SizeT intermediateStride;
+	std::unique_ptr<i16[]> intermediate;
+
+};
\ No newline at end of file
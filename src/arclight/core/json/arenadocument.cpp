@@ -0,0 +1,426 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 arenadocument.cpp
+ */
+
+#include "arenadocument.hpp"
+#include "scanner.hpp"
+#include "math/math.hpp"
+#include "util/char.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+
+
+/*
+	Upper bound of the arena size for a source of the given size.
+	Besides the source copy and decoded strings, which never exceed their source, every value but the root takes at least two source bytes
+	and is stored as a node or member. Each container allocation adds at most one alignment padding.
+*/
+static SizeT getReserveSize(SizeT sourceSize) {
+	return sourceSize * 2 + (sourceSize / 2 + 1) * (sizeof(JsonMember) + alignof(JsonMember));
+}
+
+
+
+JsonArenaDocument::JsonArenaDocument(const StringView& json, bool borrowSource) {
+	read(json, borrowSource);
+}
+
+
+
+void JsonArenaDocument::read(const StringView& json, bool borrowSource) {
+
+	root = JsonNode();
+
+	elementStack.clear();
+	memberStack.clear();
+
+	// Reuse the committed memory of the previous document if the reservation suffices
+	SizeT reserveSize = getReserveSize(json.size());
+
+	if (arena.getReservedSize() >= reserveSize) {
+		arena.reset();
+	} else {
+		arena.create(reserveSize);
+	}
+
+	const char* source = json.data();
+
+	if (!borrowSource && !json.empty()) {
+
+		char* copy = arena.allocate<char>(json.size());
+		std::memcpy(copy, json.data(), json.size());
+
+		source = copy;
+
+	}
+
+	Cursor c = { source, source + json.size() };
+
+	skipWhitespace(c);
+
+	if (c.cur == c.end)
+		return;
+
+	// The root is only published once the whole document has been read
+	JsonNode value;
+
+	readValue(c, value);
+	skipWhitespace(c);
+
+	if (c.cur != c.end)
+		throw JsonSyntaxError("Unexpected characters after the root value");
+
+	root = value;
+
+}
+
+void JsonArenaDocument::clear() {
+
+	root = JsonNode();
+	arena.clear();
+
+	elementStack.clear();
+	memberStack.clear();
+
+}
+
+bool JsonArenaDocument::empty() const {
+	return !root.isValid();
+}
+
+const JsonNode& JsonArenaDocument::getRoot() const {
+	return root;
+}
+
+SizeT JsonArenaDocument::getMemoryUsage() const {
+	return arena.getCommittedSize();
+}
+
+
+
+void JsonArenaDocument::skipWhitespace(Cursor& c) {
+
+	while (c.cur < c.end) {
+
+		switch (c.cur[0]) {
+
+		case ' ':
+		case '\t':
+		case '\r':
+		case '\n':
+			c.cur++;
+			break;
+
+		case '/':
+		{
+			if (c.end - c.cur < 2 || (c.cur[1] != '/' && c.cur[1] != '*'))
+				return;
+
+			if (c.cur[1] == '/') {
+
+				// Single-line comments can be interrupted by an EOF
+				const char* newline = static_cast<const char*>(std::memchr(c.cur, '\n', c.end - c.cur));
+				c.cur = newline ? newline + 1 : c.end;
+
+			} else {
+
+				StringView rest(c.cur + 2, c.end - c.cur - 2);
+				SizeT close = rest.find("*/");
+
+				if (close == StringView::npos)
+					throw JsonSyntaxError("Unteriminated multi-line comment found");
+
+				c.cur = rest.data() + close + 2;
+
+			}
+
+			break;
+		}
+
+		default:
+			return;
+
+		}
+
+	}
+
+}
+
+void JsonArenaDocument::readValue(Cursor& c, JsonNode& node) {
+
+	if (c.cur == c.end)
+		throw JsonSyntaxError("Unexpected EOF while reading value");
+
+	auto matchLiteral = [&](const StringView& literal) {
+
+		if (StringView(c.cur, Math::min<SizeT>(literal.size(), c.end - c.cur)) != literal)
+			throw JsonSyntaxError("Invalid symbol found in value definition");
+
+		c.cur += literal.size();
+
+	};
+
+	switch (c.cur[0]) {
+
+	case '"':
+	{
+		StringView string = readString(c);
+
+		node.type = Json::Type::String;
+		node.string = string.data();
+		node.count = static_cast<u32>(string.size());
+		return;
+	}
+
+	case '{':
+		readObject(c, node);
+		return;
+
+	case '[':
+		readArray(c, node);
+		return;
+
+	case 't':
+		matchLiteral("true");
+		node.type = Json::Type::Boolean;
+		node.boolean = true;
+		return;
+
+	case 'f':
+		matchLiteral("false");
+		node.type = Json::Type::Boolean;
+		node.boolean = false;
+		return;
+
+	case 'n':
+		matchLiteral("null");
+		node.type = Json::Type::Null;
+		return;
+
+	default:
+	{
+		if (c.cur[0] != '-' && !Character::isDigit(c.cur[0]))
+			throw JsonSyntaxError("Invalid symbol found in value definition");
+
+		Json::IntegerType integer;
+		Json::FloatType floating;
+		bool isInteger;
+
+		const char* next = Json::parseNumber(c.cur, c.end, integer, floating, isInteger);
+
+		if (!next)
+			throw JsonSyntaxError("Invalid symbol found in value definition");
+
+		node.type = Json::Type::Number;
+		node.integral = isInteger;
+
+		if (isInteger)
+			node.integer = integer;
+		else
+			node.floating = floating;
+
+		c.cur = next;
+		return;
+	}
+
+	}
+
+}
+
+/*
+	Strings are located first, escape sequences are only skipped over.
+	Strings containing none of them are returned as views into the source, all others are decoded into the arena.
+	Decoding never grows a string, so its escaped length is a sufficient allocation.
+*/
+auto JsonArenaDocument::readString(Cursor& c) -> StringView {
+
+	const char* begin = c.cur + 1;
+	const char* cur = begin;
+	bool escaped = false;
+
+	while (true) {
+
+		cur = Json::findStringDelimiter(cur, c.end);
+
+		if (cur == c.end)
+			throw JsonSyntaxError("Unexpected EOF while reading string");
+
+		if (*cur == '"')
+			break;
+
+		escaped = true;
+		cur += 2;
+
+		if (cur > c.end)
+			throw JsonSyntaxError("Unexpected EOF while reading string");
+
+	}
+
+	SizeT length = cur - begin;
+	c.cur = cur + 1;
+
+	if (length > std::numeric_limits<u32>::max())
+		throw JsonSyntaxError("String exceeds the maximum supported length");
+
+	if (!escaped)
+		return { begin, length };
+
+	char* string = arena.allocate<char>(length);
+	char* out = string;
+	const char* in = begin;
+
+	while (in < cur) {
+
+		const char* delimiter = Json::findStringDelimiter(in, cur);
+		std::memcpy(out, in, delimiter - in);
+
+		out += delimiter - in;
+		in = delimiter;
+
+		if (in < cur)
+			out += Json::decodeEscape(in, cur, out);
+
+	}
+
+	// The string is the topmost allocation, so its unused tail can be returned to the arena
+	SizeT decodedLength = out - string;
+	arena.rewind(arena.getMarker() - (length - decodedLength));
+
+	return { string, decodedLength };
+
+}
+
+void JsonArenaDocument::readArray(Cursor& c, JsonNode& node) {
+
+	SizeT base = elementStack.size();
+
+	c.cur++;
+	skipWhitespace(c);
+
+	if (c.cur < c.end && c.cur[0] == ']') {
+
+		c.cur++;
+
+	} else {
+
+		while (true) {
+
+			// Nested containers grow the stack, so the element is read into a local first
+			JsonNode element;
+
+			skipWhitespace(c);
+			readValue(c, element);
+			elementStack.push_back(element);
+
+			skipWhitespace(c);
+
+			if (c.cur == c.end)
+				throw JsonSyntaxError("Unexpected EOF while reading array");
+
+			if (c.cur[0] == ']') {
+				c.cur++;
+				break;
+			}
+
+			if (c.cur[0] != ',')
+				throw JsonSyntaxError("Expected a comma separator or a closing character");
+
+			c.cur++;
+
+		}
+
+	}
+
+	SizeT count = elementStack.size() - base;
+	JsonNode* elements = arena.allocate<JsonNode>(count);
+
+	std::copy(elementStack.begin() + base, elementStack.end(), elements);
+	elementStack.resize(base);
+
+	node.type = Json::Type::Array;
+	node.elements = elements;
+	node.count = static_cast<u32>(count);
+
+}
+
+void JsonArenaDocument::readObject(Cursor& c, JsonNode& node) {
+
+	SizeT base = memberStack.size();
+
+	c.cur++;
+	skipWhitespace(c);
+
+	if (c.cur < c.end && c.cur[0] == '}') {
+
+		c.cur++;
+
+	} else {
+
+		while (true) {
+
+			JsonMember member;
+
+			skipWhitespace(c);
+
+			if (c.cur == c.end || c.cur[0] != '"')
+				throw JsonSyntaxError("Expected a member name definition");
+
+			member.name = readString(c);
+			skipWhitespace(c);
+
+			if (c.cur == c.end || c.cur[0] != ':')
+				throw JsonSyntaxError("Expected a name:value separator character");
+
+			c.cur++;
+			skipWhitespace(c);
+			readValue(c, member.value);
+			memberStack.push_back(member);
+
+			skipWhitespace(c);
+
+			if (c.cur == c.end)
+				throw JsonSyntaxError("Unexpected EOF while reading object");
+
+			if (c.cur[0] == '}') {
+				c.cur++;
+				break;
+			}
+
+			if (c.cur[0] != ',')
+				throw JsonSyntaxError("Expected a comma separator or a closing character");
+
+			c.cur++;
+
+		}
+
+	}
+
+	SizeT count = memberStack.size() - base;
+	JsonMember* members = arena.allocate<JsonMember>(count);
+
+	std::copy(memberStack.begin() + base, memberStack.end(), members);
+	memberStack.resize(base);
+
+	// Sorted members allow binary search and expose duplicates as neighbours
+	auto byName = [](const JsonMember& a, const JsonMember& b) {
+		return a.name < b.name;
+	};
+
+	if (!std::is_sorted(members, members + count, byName))
+		std::sort(members, members + count, byName);
+
+	if (std::adjacent_find(members, members + count, [](const JsonMember& a, const JsonMember& b) { return a.name == b.name; }) != members + count)
+		throw JsonSyntaxError("Duplicate member name found");
+
+	node.type = Json::Type::Object;
+	node.members = members;
+	node.count = static_cast<u32>(count);
+
+}
\ No newline at end of file
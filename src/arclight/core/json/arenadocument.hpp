@@ -0,0 +1,70 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 arenadocument.hpp
+ */
+
+#pragma once
+
+#include "common.hpp"
+#include "node.hpp"
+#include "memory/arenaallocator.hpp"
+
+#include <vector>
+
+
+
+/*
+	Read-only document whose nodes, keys and strings all live in a single arena.
+	Containers are stored as flat arrays. The arena reserves address space for the worst case up front and commits it as the document grows,
+	so reading costs no per-node allocations and clearing a document releases a single reservation.
+	Strings without escape sequences are views into the source text. By default the source is copied into the arena,
+	with borrowSource set the caller has to keep it alive for as long as the document is in use instead.
+*/
+class JsonArenaDocument {
+
+public:
+
+	using StringView = Json::StringView;
+
+	JsonArenaDocument() = default;
+	explicit JsonArenaDocument(const StringView& json, bool borrowSource = false);
+
+	JsonArenaDocument(JsonArenaDocument&&) noexcept = default;
+	JsonArenaDocument& operator=(JsonArenaDocument&&) noexcept = default;
+
+	void read(const StringView& json, bool borrowSource = false);
+
+	void clear();
+	bool empty() const;
+
+	const JsonNode& getRoot() const;
+
+	// Memory committed by the arena
+	SizeT getMemoryUsage() const;
+
+private:
+
+	struct Cursor {
+
+		const char* cur;
+		const char* end;
+
+	};
+
+	void skipWhitespace(Cursor& c);
+	void readValue(Cursor& c, JsonNode& node);
+	StringView readString(Cursor& c);
+	void readArray(Cursor& c, JsonNode& node);
+	void readObject(Cursor& c, JsonNode& node);
+
+	ArenaAllocator arena;
+	JsonNode root;
+
+	// Children of all open containers, reused between reads
+	std::vector<JsonNode> elementStack;
+	std::vector<JsonMember> memberStack;
+
+};
\ No newline at end of file
@@ -7,10 +7,13 @@
  */
 
 #include "document.hpp"
+#include "scanner.hpp"
 #include "filesystem/path.hpp"
 #include "filesystem/file.hpp"
 #include "util/log.hpp"
 
+#include <memory>
+
 
 
 JsonDocument::JsonDocument(const JsonObject& root) : root(root) {}
@@ -51,12 +54,23 @@ auto JsonDocument::write(bool compact) const -> StringType {
 
 	StringType string;
 
-	writeObject(string, root, compact, 1);
+	write([&string](const StringView& chunk) {
+		string += chunk;
+	}, compact);
 
 	return string;
 
 }
 
+void JsonDocument::write(const JsonWriter::Sink& sink, bool compact) const {
+
+	JsonWriter writer(sink, compact);
+
+	writer.value(root);
+	writer.flush();
+
+}
+
 
 
 void JsonDocument::clear() {
@@ -102,19 +116,18 @@ bool JsonDocument::readComment(Iterator& it) {
 
 	bool singleLine = it.cur[1] == '/';
 
+	// The iterator is left on the last character of the comment, callers advance past it
 	for (it.cur += 2; it.cur < it.end; it.cur++) {
 
 		if (singleLine) {
 			
-			if (it.matchAny("\r\n")) {
-				it.cur += (it.cur[0] == '\r') ? 2 : 1;
+			if (it.matchAny("\r\n"))
 				return true;
-			}
 			
 		} else {
 
 			if (it.matchSequence("*/")) {
-				it.cur += 2;
+				it.cur += 1;
 				return true;
 			}
 
@@ -123,8 +136,10 @@ bool JsonDocument::readComment(Iterator& it) {
 	}
 
 	// Single-line comments can be interrupted by an EOF
-	if (singleLine)
+	if (singleLine) {
+		it.cur = it.end - 1;
 		return true;
+	}
 	
 	// Multi-line comments require a closing sequence
 	throw JsonSyntaxError("Unteriminated multi-line comment found");
@@ -136,76 +151,56 @@ bool JsonDocument::readString(Iterator& it, StringType& string) {
 	if (it.cur[0] != '"')
 		return false;
 
-	for (it.cur++; it.cur < it.end; it.cur++) {
-
-		auto ch = it.cur[0];
-		if (ch == '"')
-			break;
-
-		string += it.cur[0];
-
-	}
-
-	// Unterminated string
-	return !it.overflown();
-
-}
-
-bool JsonDocument::readNumber(Iterator& it, JsonValue& value) {
-
-	Iterator tmp = it;
-
-	if (tmp.cur[0] == '-')
-		tmp.cur++;
+	const char* cur = std::to_address(it.cur) + 1;
+	const char* end = std::to_address(it.end);
 
-	bool integer = true;
+	while (true) {
 
-	// Select the numeric type
-	for (; tmp.cur < tmp.end; tmp.cur++) {
+		// Copy everything up to the next delimiter at once
+		const char* delimiter = Json::findStringDelimiter(cur, end);
+		string.append(cur, delimiter);
+		cur = delimiter;
 
-		if (!Character::isDigit(tmp.cur[0])) {
-
-			// Digit sequence interrupted
-
-			switch (tmp.cur[0]) {
+		// Unterminated string
+		if (cur == end)
+			return false;
 
-			case '.': // Decimal point, use Json::FloatType
-				integer = false;
-				break;
+		if (*cur == '"')
+			break;
 
-			case 'e': // Scientific notation, use Json::FloatType
-				integer = false;
-				break;
+		char decoded[4];
+		string.append(decoded, Json::decodeEscape(cur, end, decoded));
 
-			}
+	}
 
-			break;
+	// Leave the iterator on the closing quote
+	it.cur += cur - std::to_address(it.cur);
 
-		}
+	return true;
 
-	}
+}
 
-	std::istringstream is(StringType(it.cur, it.end));
+bool JsonDocument::readNumber(Iterator& it, JsonValue& value) {
 
-	if (integer) {
+	const char* begin = std::to_address(it.cur);
 
-		Json::IntegerType n;
-		is >> n;
-		value = n;
+	Json::IntegerType integer;
+	Json::FloatType floating;
+	bool isInteger;
 
-	}
-	else {
+	const char* next = Json::parseNumber(begin, std::to_address(it.end), integer, floating, isInteger);
 
-		Json::FloatType f;
-		is >> f;
-		value = f;
+	if (!next)
+		return false;
 
-	}
+	if (isInteger)
+		value = integer;
+	else
+		value = floating;
 
-	it.cur += is.tellg();
-	it.cur -= 1;
+	it.cur += next - begin - 1;
 
-	return !is.fail();
+	return true;
 
 }
 
@@ -234,27 +229,21 @@ void JsonDocument::readValue(Iterator& it, JsonValue& value) {
 			if (!readString(it, string))
 				throw JsonSyntaxError("Unexpected EOF while reading string");
 
-			value = string;
+			value = std::move(string);
 			return;
 		}
 
-		case '{': // Object
+		case '{': // Object, built in place
 		{
-			JsonObject object;
-
-			readObject(it, object);
-
-			value = object;
+			value = JsonObject();
+			readObject(it, value.toObject());
 			return;
 		}
 
-		case '[': // Array
+		case '[': // Array, built in place
 		{
-			JsonArray array;
-
-			readArray(it, array);
-
-			value = array;
+			value = JsonArray();
+			readArray(it, value.toArray());
 			return;
 		}
 
@@ -425,11 +414,16 @@ void JsonDocument::readArray(Iterator& it, JsonArray& array) {
 
 			case ReadStepValue:
 			{
-				JsonValue value;
+				auto ch = it.cur[0];
 
-				readValue(it, value);
+				if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n')
+					break;
 
-				array.append(value);
+				// Empty array
+				if (ch == ']' && array.empty())
+					return;
+
+				readValue(it, array.emplace());
 
 				step++;
 				break;
@@ -482,7 +476,7 @@ void JsonDocument::readObject(Iterator& it, JsonObject& object) {
 				if (closed)
 					return;
 
-				auto it = object.items.try_emplace(name);
+				auto it = object.items.try_emplace(std::move(name));
 				if (!it.second)
 					throw JsonSyntaxError("Duplicate member name found");
 
@@ -502,11 +496,7 @@ void JsonDocument::readObject(Iterator& it, JsonObject& object) {
 
 			case ReadStepValue:
 			{
-				JsonValue value;
-
-				readValue(it, value);
-
-				item->second = value;
+				readValue(it, item->second);
 
 				step++;
 				break;
@@ -534,130 +524,6 @@ void JsonDocument::readObject(Iterator& it, JsonObject& object) {
 
 
 
-void JsonDocument::writeValue(StringType& string, const JsonValue& value, bool compact, u32 level) const {
-
-	switch (value.getType()) {
-
-		case Json::Type::String:
-			string += '"' + value.toString() + '"';
-			break;
-
-		case Json::Type::Number:
-
-			if (value.isInteger()) {
-
-				auto n = value.toNumber<Json::IntegerType>();
-				string += std::to_string(n);
-
-			} else {
-
-				auto f = value.toNumber<Json::FloatType>();
-				string += std::to_string(f);
-
-			}
-
-			break;
-
-		case Json::Type::Object:
-			writeObject(string, value.toObject(), compact, level + 1);
-			break;
-
-		case Json::Type::Array:
-			writeArray(string, value.toArray(), compact, level + 1);
-			break;
-
-		case Json::Type::Boolean:
-			string += value.toBoolean() ? "true" : "false";
-			break;
-
-		case Json::Type::Null:
-		case Json::Type::None:
-			string += "null";
-			break;
-
-	}
-
-}
-
-void JsonDocument::writeArray(StringType& string, const JsonArray& array, bool compact, u32 level) const {
-
-	StringType lineTab(level * IndentationLevel, IndentationChar);
-	StringType lastTab = "";
-
-	if (!compact && !array.empty())
-		lastTab = StringType((level - 1) * IndentationLevel, IndentationChar);
-
-	string += "[";
-
-	bool first = true;
-
-	for (const auto& value : array) {
-
-		if (first) {
-			first = false;
-		} else {
-			string += ",";
-		}
-
-		if (!compact)
-			string += '\n' + lineTab;
-
-		writeValue(string, value, compact, level);
-
-	}
-	
-	if (!compact) {
-		string += '\n';
-		string += lastTab;
-	}
-
-	string += ']';
-
-}
-
-void JsonDocument::writeObject(StringType& string, const JsonObject& object, bool compact, u32 level) const {
-
-	StringType lineTab(level * IndentationLevel, ' ');
-	StringType lastTab = "";
-
-	if (!compact && !object.empty())
-		lastTab = StringType((level - 1) * IndentationLevel, IndentationChar);
-
-	string += "{";
-
-	bool first = true;
-
-	for (const auto& [name, value] : object) {
-
-		if (first) {
-			first = false;
-		} else {
-			string += ",";
-		}
-
-		if (!compact)
-			string += '\n' + lineTab;
-
-		string += '"' + name + "\":";
-
-		if (!compact)
-			string += ' ';
-
-		writeValue(string, value, compact, level);
-
-	}
-
-	if (!compact) {
-		string += '\n';
-		string += lastTab;
-	}
-
-	string += '}';
-
-}
-
-
-
 RawLog& operator<<(RawLog& log, const JsonDocument& document) {
 
 	log << document.write();
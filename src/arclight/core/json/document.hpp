@@ -11,8 +11,8 @@
 #include "common.hpp"
 #include "object.hpp"
 #include "array.hpp"
+#include "writer.hpp"
 #include "util/char.hpp"
-#include <sstream>
 
 
 
@@ -25,8 +25,8 @@ public:
 	using StringIterator = StringView::iterator;
 	using StringConstIterator = StringView::const_iterator;
 
-	static constexpr u32 IndentationLevel = 2;
-	static constexpr char IndentationChar = ' ';
+	static constexpr u32 IndentationLevel = JsonWriter::IndentationLevel;
+	static constexpr char IndentationChar = JsonWriter::IndentationChar;
 
 	JsonDocument() = default;
 	JsonDocument(const JsonObject& root);
@@ -34,6 +34,7 @@ public:
 
 	void read(const StringView& json);
 	StringType write(bool compact = false) const;
+	void write(const JsonWriter::Sink& sink, bool compact = false) const;
 
 	void clear();
 	bool empty() const;
@@ -106,10 +107,6 @@ private:
 	void readArray(Iterator& it, JsonArray& array);
 	void readObject(Iterator& it, JsonObject& object);
 
-	void writeValue(StringType& string, const JsonValue& value, bool compact, u32 level) const;
-	void writeArray(StringType& string, const JsonArray& array, bool compact, u32 level) const;
-	void writeObject(StringType& string, const JsonObject& object, bool compact, u32 level) const;
-
 	JsonObject root;
 
 };
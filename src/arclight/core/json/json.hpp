@@ -13,3 +13,6 @@
 #include "array.hpp"
 #include "object.hpp"
 #include "document.hpp"
+#include "arenadocument.hpp"
+#include "reader.hpp"
+#include "writer.hpp"
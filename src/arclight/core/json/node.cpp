@@ -0,0 +1,165 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 node.cpp
+ */
+
+#include "node.hpp"
+#include "value.hpp"
+#include "array.hpp"
+#include "object.hpp"
+
+#include <algorithm>
+
+
+
+// Objects up to this size are searched linearly
+static constexpr u32 LinearSearchLimit = 8;
+
+
+
+bool JsonNode::toBoolean() const {
+
+	checkType(Type::Boolean);
+	return boolean;
+
+}
+
+auto JsonNode::toString() const -> StringView {
+
+	checkType(Type::String);
+	return { string, count };
+
+}
+
+std::span<const JsonNode> JsonNode::toArray() const {
+
+	checkType(Type::Array);
+	return { elements, count };
+
+}
+
+std::span<const JsonMember> JsonNode::toObject() const {
+
+	checkType(Type::Object);
+	return { members, count };
+
+}
+
+
+
+bool JsonNode::contains(const StringView& name) const {
+	return find(name) != nullptr;
+}
+
+const JsonNode* JsonNode::find(const StringView& name) const {
+
+	checkType(Type::Object);
+
+	const JsonMember* begin = members;
+	const JsonMember* end = members + count;
+
+	if (count <= LinearSearchLimit) {
+
+		for (const JsonMember* member = begin; member != end; member++) {
+
+			if (member->name == name)
+				return &member->value;
+
+		}
+
+		return nullptr;
+
+	}
+
+	const JsonMember* member = std::lower_bound(begin, end, name, [](const JsonMember& m, const StringView& n) {
+		return m.name < n;
+	});
+
+	return member != end && member->name == name ? &member->value : nullptr;
+
+}
+
+const JsonNode& JsonNode::operator[](const StringView& name) const {
+
+	const JsonNode* node = find(name);
+
+	if (!node)
+		throw JsonValueNotFoundException(Json::StringType(name));
+
+	return *node;
+
+}
+
+const JsonNode& JsonNode::operator[](SizeT index) const {
+
+	checkType(Type::Array);
+
+	if (index >= count)
+		throw JsonException("Array index out of bounds");
+
+	return elements[index];
+
+}
+
+
+
+JsonValue JsonNode::toValue() const {
+
+	switch (type) {
+
+		case Type::String:
+			return Json::StringType(string, count);
+
+		case Type::Number:
+
+			if (integral)
+				return integer;
+			else
+				return floating;
+
+		case Type::Boolean:
+			return boolean;
+
+		case Type::Null:
+			return nullptr;
+
+		case Type::Array:
+		{
+			JsonValue value = JsonArray();
+			JsonArray& array = value.toArray();
+
+			for (u32 i = 0; i < count; i++)
+				array.emplace() = elements[i].toValue();
+
+			return value;
+		}
+
+		case Type::Object:
+		{
+			JsonValue value = JsonObject();
+			JsonObject& object = value.toObject();
+
+			for (u32 i = 0; i < count; i++)
+				object.items.try_emplace(Json::StringType(members[i].name)).first->second = members[i].value.toValue();
+
+			return value;
+		}
+
+		default:
+			return {};
+
+	}
+
+}
+
+
+
+void JsonNode::checkType(Type target) const {
+
+	if (type != target)
+		throw JsonTypeCastException(type, target);
+
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 node.hpp
+ */
+
+#pragma once
+
+#include "common.hpp"
+
+#include <span>
+
+
+
+class JsonValue;
+struct JsonMember;
+
+
+/*
+	Immutable value of a JsonArenaDocument.
+	Strings, elements and members are views into memory owned by the document and stay valid until it is cleared.
+	Object members are sorted by name, lookups use binary search.
+*/
+class JsonNode {
+
+public:
+
+	using StringView = Json::StringView;
+	using Type = Json::Type;
+	using IntegerType = Json::IntegerType;
+	using FloatType = Json::FloatType;
+
+	constexpr JsonNode() noexcept : integer(0), count(0), type(Type::None), integral(false) {}
+
+	constexpr Type getType() const noexcept {
+		return type;
+	}
+
+	template<CC::JsonNumber T>
+	T toNumber() const {
+
+		checkType(Type::Number);
+
+		return integral ? static_cast<T>(integer) : static_cast<T>(floating);
+
+	}
+
+	bool toBoolean() const;
+	StringView toString() const;
+	std::span<const JsonNode> toArray() const;
+	std::span<const JsonMember> toObject() const;
+
+	// Number of elements or members, zero for all other types
+	constexpr SizeT size() const noexcept {
+		return type == Type::Array || type == Type::Object ? count : 0;
+	}
+
+	bool contains(const StringView& name) const;
+	const JsonNode* find(const StringView& name) const;
+
+	const JsonNode& operator[](const StringView& name) const;
+	const JsonNode& operator[](SizeT index) const;
+
+	// Deep copy into the regular document model
+	JsonValue toValue() const;
+
+	constexpr bool isString() const noexcept {
+		return type == Type::String;
+	}
+
+	constexpr bool isNumber() const noexcept {
+		return type == Type::Number;
+	}
+
+	constexpr bool isInteger() const noexcept {
+		return isNumber() && integral;
+	}
+
+	constexpr bool isFloat() const noexcept {
+		return isNumber() && !integral;
+	}
+
+	constexpr bool isObject() const noexcept {
+		return type == Type::Object;
+	}
+
+	constexpr bool isArray() const noexcept {
+		return type == Type::Array;
+	}
+
+	constexpr bool isBoolean() const noexcept {
+		return type == Type::Boolean;
+	}
+
+	constexpr bool isNull() const noexcept {
+		return type == Type::Null;
+	}
+
+	constexpr bool isValid() const noexcept {
+		return type != Type::None;
+	}
+
+private:
+
+	friend class JsonArenaDocument;
+
+	void checkType(Type target) const;
+
+	union {
+		IntegerType integer;
+		FloatType floating;
+		bool boolean;
+		const char* string;
+		const JsonNode* elements;
+		const JsonMember* members;
+	};
+
+	u32 count;
+	Type type;
+	bool integral;
+
+};
+
+
+
+struct JsonMember {
+
+	Json::StringView name;
+	JsonNode value;
+
+};
\ No newline at end of file
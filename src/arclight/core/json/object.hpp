@@ -88,6 +88,7 @@ private:
 	inline static JsonValue nullValue;
 
 	friend class JsonDocument;
+	friend class JsonNode;
 
 	ItemContainer items;
 
@@ -0,0 +1,474 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 reader.cpp
+ */
+
+#include "reader.hpp"
+#include "scanner.hpp"
+#include "math/math.hpp"
+#include "util/char.hpp"
+
+
+
+JsonReader::JsonReader() {
+	reset();
+}
+
+
+
+void JsonReader::feed(const StringView& chunk) {
+
+	if (finished)
+		throw JsonException("Cannot feed a finished reader");
+
+	// Drop consumed input, unfinished tokens move to the front
+	buffer.erase(0, position);
+	buffer.append(chunk);
+
+	position = 0;
+
+}
+
+void JsonReader::finish() {
+	finished = true;
+}
+
+void JsonReader::reset() {
+
+	buffer.clear();
+	position = 0;
+	scanOffset = 0;
+	scanEscaped = false;
+	finished = false;
+
+	state = State::Root;
+	containers.clear();
+
+	lastEvent = Event::NeedInput;
+	skipping = false;
+	skipDepth = 0;
+
+	string = {};
+	decoded.clear();
+	integer = 0;
+	floating = 0;
+	integral = false;
+	boolean = false;
+
+}
+
+
+
+auto JsonReader::next() -> Event {
+
+	while (true) {
+
+		Event event = readEvent();
+
+		if (event == Event::NeedInput || event == Event::EndOfInput)
+			return event;
+
+		if (skipping) {
+
+			// Skipping ends with the first scalar or closing event back on the original level
+			if (containers.size() == skipDepth && event != Event::StartObject && event != Event::StartArray)
+				skipping = false;
+
+			continue;
+
+		}
+
+		lastEvent = event;
+
+		return event;
+
+	}
+
+}
+
+void JsonReader::skip() {
+
+	if (lastEvent == Event::StartObject || lastEvent == Event::StartArray) {
+
+		skipping = true;
+		skipDepth = containers.size() - 1;
+
+	} else if (lastEvent == Event::Key) {
+
+		skipping = true;
+		skipDepth = containers.size();
+
+	}
+
+	lastEvent = Event::NeedInput;
+
+}
+
+
+
+auto JsonReader::getString() const -> StringView {
+	return string;
+}
+
+bool JsonReader::isInteger() const {
+	return integral;
+}
+
+auto JsonReader::getInteger() const -> IntegerType {
+	return integral ? integer : static_cast<IntegerType>(floating);
+}
+
+auto JsonReader::getFloat() const -> FloatType {
+	return integral ? static_cast<FloatType>(integer) : floating;
+}
+
+bool JsonReader::getBoolean() const {
+	return boolean;
+}
+
+
+
+auto JsonReader::readEvent() -> Event {
+
+	while (true) {
+
+		if (!skipWhitespace())
+			return Event::NeedInput;
+
+		if (position == buffer.size()) {
+
+			if (!finished)
+				return Event::NeedInput;
+
+			if (state != State::Root)
+				throw JsonSyntaxError("Unexpected EOF while reading JSON data");
+
+			return Event::EndOfInput;
+
+		}
+
+		char c = buffer[position];
+
+		switch (state) {
+
+		case State::Root:
+		case State::Value:
+			return readValue();
+
+		case State::ArrayFirst:
+
+			if (c == ']') {
+
+				position++;
+				containers.pop_back();
+				completeValue();
+
+				return Event::EndArray;
+
+			}
+
+			return readValue();
+
+		case State::ObjectFirst:
+
+			if (c == '}') {
+
+				position++;
+				containers.pop_back();
+				completeValue();
+
+				return Event::EndObject;
+
+			}
+
+			[[fallthrough]];
+
+		case State::Key:
+
+			if (c != '"')
+				throw JsonSyntaxError("Expected a member name definition");
+
+			return readString(Event::Key);
+
+		case State::Colon:
+
+			if (c != ':')
+				throw JsonSyntaxError("Expected a name:value separator character");
+
+			position++;
+			state = State::Value;
+			break;
+
+		case State::Separator:
+
+			if (c == ',') {
+
+				position++;
+				state = containers.back() == '{' ? State::Key : State::Value;
+				break;
+
+			}
+
+			if (c != (containers.back() == '{' ? '}' : ']'))
+				throw JsonSyntaxError("Expected a comma separator or a closing character");
+
+			position++;
+			containers.pop_back();
+			completeValue();
+
+			return c == '}' ? Event::EndObject : Event::EndArray;
+
+		}
+
+	}
+
+}
+
+auto JsonReader::readValue() -> Event {
+
+	switch (buffer[position]) {
+
+	case '{':
+		position++;
+		containers.push_back('{');
+		state = State::ObjectFirst;
+		return Event::StartObject;
+
+	case '[':
+		position++;
+		containers.push_back('[');
+		state = State::ArrayFirst;
+		return Event::StartArray;
+
+	case '"':
+		return readString(Event::String);
+
+	case 't':
+		boolean = true;
+		return readLiteral("true", Event::Boolean);
+
+	case 'f':
+		boolean = false;
+		return readLiteral("false", Event::Boolean);
+
+	case 'n':
+		return readLiteral("null", Event::Null);
+
+	default:
+		return readNumber();
+
+	}
+
+}
+
+/*
+	Strings are scanned for their closing quote first, the scan resumes where it stopped when more input arrives.
+	Strings without escape sequences are returned as views into the buffer, all others are decoded.
+*/
+auto JsonReader::readString(Event event) -> Event {
+
+	const char* data = buffer.data();
+	SizeT size = buffer.size();
+	SizeT begin = position + 1;
+	SizeT cur = begin + scanOffset;
+
+	while (true) {
+
+		cur = Json::findStringDelimiter(data + cur, data + size) - data;
+
+		// Escape sequences cut off by the end are rescanned from their backslash
+		if (cur == size || (data[cur] == '\\' && cur + 1 == size)) {
+
+			if (finished)
+				throw JsonSyntaxError("Unexpected EOF while reading string");
+
+			scanOffset = cur - begin;
+			return Event::NeedInput;
+
+		}
+
+		if (data[cur] == '"')
+			break;
+
+		scanEscaped = true;
+		cur += 2;
+
+	}
+
+	if (scanEscaped) {
+
+		decoded.clear();
+
+		const char* in = data + begin;
+		const char* end = data + cur;
+
+		while (in < end) {
+
+			const char* delimiter = Json::findStringDelimiter(in, end);
+			decoded.append(in, delimiter);
+			in = delimiter;
+
+			if (in < end) {
+
+				char sequence[4];
+				decoded.append(sequence, Json::decodeEscape(in, end, sequence));
+
+			}
+
+		}
+
+		string = decoded;
+
+	} else {
+
+		string = StringView(data + begin, cur - begin);
+
+	}
+
+	scanOffset = 0;
+	scanEscaped = false;
+	position = cur + 1;
+
+	if (event == Event::Key)
+		state = State::Colon;
+	else
+		completeValue();
+
+	return event;
+
+}
+
+auto JsonReader::readLiteral(const StringView& literal, Event event) -> Event {
+
+	SizeT available = Math::min(buffer.size() - position, literal.size());
+
+	if (StringView(buffer).substr(position, available) != literal.substr(0, available))
+		throw JsonSyntaxError("Invalid symbol found in value definition");
+
+	if (available < literal.size()) {
+
+		if (finished)
+			throw JsonSyntaxError("Unexpected EOF in value definition");
+
+		return Event::NeedInput;
+
+	}
+
+	position += literal.size();
+	completeValue();
+
+	return event;
+
+}
+
+auto JsonReader::readNumber() -> Event {
+
+	SizeT end = position;
+
+	while (end < buffer.size()) {
+
+		char c = buffer[end];
+
+		if (!Character::isDigit(c) && c != '-' && c != '+' && c != '.' && c != 'e' && c != 'E')
+			break;
+
+		end++;
+
+	}
+
+	// The number might continue in the next chunk
+	if (end == buffer.size() && !finished)
+		return Event::NeedInput;
+
+	const char* first = buffer.data() + position;
+	const char* last = buffer.data() + end;
+
+	if (first == last || Json::parseNumber(first, last, integer, floating, integral) != last)
+		throw JsonSyntaxError("Invalid symbol found in value definition");
+
+	position = end;
+	completeValue();
+
+	return Event::Number;
+
+}
+
+// Returns false if a comment is cut off by the end of the available input
+bool JsonReader::skipWhitespace() {
+
+	while (position < buffer.size()) {
+
+		switch (buffer[position]) {
+
+		case ' ':
+		case '\t':
+		case '\r':
+		case '\n':
+			position++;
+			break;
+
+		case '/':
+		{
+			if (buffer.size() - position < 2)
+				return finished;
+
+			char type = buffer[position + 1];
+
+			if (type == '/') {
+
+				SizeT newline = buffer.find('\n', position + 2);
+
+				// Single-line comments can be interrupted by an EOF
+				if (newline == StringType::npos) {
+
+					if (!finished)
+						return false;
+
+					position = buffer.size();
+					return true;
+
+				}
+
+				position = newline + 1;
+
+			} else if (type == '*') {
+
+				SizeT close = buffer.find("*/", position + 2);
+
+				if (close == StringType::npos) {
+
+					if (!finished)
+						return false;
+
+					throw JsonSyntaxError("Unteriminated multi-line comment found");
+
+				}
+
+				position = close + 2;
+
+			} else {
+
+				return true;
+
+			}
+
+			break;
+		}
+
+		default:
+			return true;
+
+		}
+
+	}
+
+	return true;
+
+}
+
+void JsonReader::completeValue() {
+	state = containers.empty() ? State::Root : State::Separator;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 reader.hpp
+ */
+
+#pragma once
+
+#include "common.hpp"
+
+#include <vector>
+
+
+
+/*
+	Pull parser for chunked JSON input.
+	Input is handed over with feed() in pieces of any size, next() then yields one event at a time and
+	reports NeedInput whenever a token is cut off by the end of the available data. Once finish() has been called,
+	the remaining input is drained and EndOfInput is reported.
+	Top-level values may follow each other, which covers newline-delimited JSON.
+	Consumed input is discarded on every feed(), memory use is bounded by the largest token plus the chunk size.
+*/
+class JsonReader {
+
+public:
+
+	using StringType = Json::StringType;
+	using StringView = Json::StringView;
+	using IntegerType = Json::IntegerType;
+	using FloatType = Json::FloatType;
+
+	enum class Event {
+		NeedInput,
+		EndOfInput,
+		StartObject,
+		EndObject,
+		StartArray,
+		EndArray,
+		Key,
+		String,
+		Number,
+		Boolean,
+		Null
+	};
+
+	JsonReader();
+
+	void feed(const StringView& chunk);
+	void finish();
+	void reset();
+
+	Event next();
+
+	// Skips the value of the last Key or the container opened by the last StartObject/StartArray
+	void skip();
+
+	// Valid for Key and String events until the next call to next() or feed()
+	StringView getString() const;
+
+	bool isInteger() const;
+	IntegerType getInteger() const;
+	FloatType getFloat() const;
+	bool getBoolean() const;
+
+	// Number of containers enclosing the current position
+	constexpr SizeT getDepth() const noexcept {
+		return containers.size();
+	}
+
+private:
+
+	enum class State {
+		Root,
+		Value,
+		ArrayFirst,
+		ObjectFirst,
+		Key,
+		Colon,
+		Separator
+	};
+
+	Event readEvent();
+	Event readValue();
+	Event readString(Event event);
+	Event readLiteral(const StringView& literal, Event event);
+	Event readNumber();
+	bool skipWhitespace();
+	void completeValue();
+
+	StringType buffer;
+	SizeT position;
+	SizeT scanOffset;
+	bool scanEscaped;
+	bool finished;
+
+	State state;
+	std::vector<char> containers;
+
+	Event lastEvent;
+	bool skipping;
+	SizeT skipDepth;
+
+	StringView string;
+	StringType decoded;
+	IntegerType integer;
+	FloatType floating;
+	bool integral;
+	bool boolean;
+
+};
\ No newline at end of file
@@ -0,0 +1,258 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 scanner.cpp
+ */
+
+#include "scanner.hpp"
+#include "arcintrinsic.hpp"
+#include "util/bits.hpp"
+#include "util/char.hpp"
+#include "util/cpuid.hpp"
+
+#include <charconv>
+
+
+
+using DelimiterSearchFunction = const char*(*)(const char* begin, const char* end);
+
+// Returns the first quote or backslash in [begin, end), end if there is none
+static const char* findStringDelimiterDefault(const char* begin, const char* end) {
+
+	for (; begin < end; begin++) {
+
+		if (*begin == '"' || *begin == '\\')
+			break;
+
+	}
+
+	return begin;
+
+}
+
+#ifdef ARC_DISPATCH_X86
+
+ARC_TARGET("sse2") static const char* findStringDelimiterSSE2(const char* begin, const char* end) {
+
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+
+	for (; end - begin >= 16; begin += 16) {
+
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+		u32 mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash)));
+
+		if (mask)
+			return begin + Bits::ctz(mask);
+
+	}
+
+	return findStringDelimiterDefault(begin, end);
+
+}
+
+ARC_TARGET("avx2") static const char* findStringDelimiterAVX2(const char* begin, const char* end) {
+
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+
+	for (; end - begin >= 32; begin += 32) {
+
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+		u32 mask = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)));
+
+		if (mask)
+			return begin + Bits::ctz(mask);
+
+	}
+
+	return findStringDelimiterDefault(begin, end);
+
+}
+
+#endif
+
+const char* Json::findStringDelimiter(const char* begin, const char* end) {
+
+	static const DelimiterSearchFunction function = []() {
+
+#ifdef ARC_DISPATCH_X86
+
+		if (CPUID::hasFeature(CPUFeature::AVX2))
+			return findStringDelimiterAVX2;
+
+		if (CPUID::hasFeature(CPUFeature::SSE2))
+			return findStringDelimiterSSE2;
+
+#endif
+
+		return findStringDelimiterDefault;
+
+	}();
+
+	return function(begin, end);
+
+}
+
+// Parses four hex digits, returns -1 on failure
+static i32 readHexQuad(const char* p) {
+
+	i32 value = 0;
+
+	for (u32 i = 0; i < 4; i++) {
+
+		char c = p[i];
+		value <<= 4;
+
+		if (c >= '0' && c <= '9')
+			value |= c - '0';
+		else if (c >= 'a' && c <= 'f')
+			value |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			value |= c - 'A' + 10;
+		else
+			return -1;
+
+	}
+
+	return value;
+
+}
+
+static u32 encodeUTF8(u32 codepoint, char* out) {
+
+	if (codepoint < 0x80) {
+
+		out[0] = static_cast<char>(codepoint);
+		return 1;
+
+	} else if (codepoint < 0x800) {
+
+		out[0] = static_cast<char>(0xC0 | codepoint >> 6);
+		out[1] = static_cast<char>(0x80 | (codepoint & 0x3F));
+		return 2;
+
+	} else if (codepoint < 0x10000) {
+
+		out[0] = static_cast<char>(0xE0 | codepoint >> 12);
+		out[1] = static_cast<char>(0x80 | (codepoint >> 6 & 0x3F));
+		out[2] = static_cast<char>(0x80 | (codepoint & 0x3F));
+		return 3;
+
+	}
+
+	out[0] = static_cast<char>(0xF0 | codepoint >> 18);
+	out[1] = static_cast<char>(0x80 | (codepoint >> 12 & 0x3F));
+	out[2] = static_cast<char>(0x80 | (codepoint >> 6 & 0x3F));
+	out[3] = static_cast<char>(0x80 | (codepoint & 0x3F));
+	return 4;
+
+}
+
+u32 Json::decodeEscape(const char*& cur, const char* end, char* out) {
+
+	if (end - cur < 2)
+		throw JsonSyntaxError("Unexpected EOF in escape sequence");
+
+	char escaped = cur[1];
+	cur += 2;
+
+	switch (escaped) {
+
+	case '"':
+	case '\\':
+	case '/':
+		out[0] = escaped;
+		return 1;
+
+	case 'b':
+		out[0] = '\b';
+		return 1;
+
+	case 'f':
+		out[0] = '\f';
+		return 1;
+
+	case 'n':
+		out[0] = '\n';
+		return 1;
+
+	case 'r':
+		out[0] = '\r';
+		return 1;
+
+	case 't':
+		out[0] = '\t';
+		return 1;
+
+	case 'u':
+	{
+		i32 codepoint = end - cur >= 4 ? readHexQuad(cur) : -1;
+
+		if (codepoint < 0)
+			throw JsonSyntaxError("Invalid unicode escape sequence");
+
+		cur += 4;
+
+		// Surrogate pairs are combined, unpaired surrogates become replacement characters
+		if (codepoint >= 0xD800 && codepoint < 0xDC00) {
+
+			i32 low = end - cur >= 6 && cur[0] == '\\' && cur[1] == 'u' ? readHexQuad(cur + 2) : -1;
+
+			if (low >= 0xDC00 && low < 0xE000) {
+				codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+				cur += 6;
+			} else {
+				codepoint = 0xFFFD;
+			}
+
+		} else if (codepoint >= 0xDC00 && codepoint < 0xE000) {
+			codepoint = 0xFFFD;
+		}
+
+		return encodeUTF8(codepoint, out);
+	}
+
+	default:
+		throw JsonSyntaxError("Invalid escape sequence in string");
+
+	}
+
+}
+
+const char* Json::parseNumber(const char* begin, const char* end, IntegerType& integer, FloatType& floating, bool& isInteger) {
+
+	const char* digits = begin + (begin[0] == '-');
+	const char* cur = digits;
+
+	while (cur < end && Character::isDigit(*cur))
+		cur++;
+
+	// At least one digit must follow the sign, this rules out inf and nan
+	if (cur == digits)
+		return nullptr;
+
+	// Select the numeric type
+	isInteger = cur == end || (*cur != '.' && *cur != 'e' && *cur != 'E');
+
+	if (isInteger) {
+
+		auto [next, error] = std::from_chars(begin, end, integer);
+
+		if (error == std::errc())
+			return next;
+
+		if (error != std::errc::result_out_of_range)
+			return nullptr;
+
+		isInteger = false;
+
+	}
+
+	auto [next, error] = std::from_chars(begin, end, floating);
+
+	return error == std::errc() ? next : nullptr;
+
+}
\ No newline at end of file
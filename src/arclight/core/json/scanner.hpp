@@ -0,0 +1,38 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 scanner.hpp
+ */
+
+#pragma once
+
+#include "common.hpp"
+
+
+
+/*
+	Low-level scanning routines shared by the JSON readers.
+	All of them operate on raw character ranges and never read past the given end.
+*/
+namespace Json {
+
+	// Returns the first quote or backslash in [begin, end), end if there is none
+	const char* findStringDelimiter(const char* begin, const char* end);
+
+	/*
+		Decodes the escape sequence starting at the backslash cur points to.
+		Writes up to four UTF-8 bytes to out and returns their count, cur is advanced past the sequence.
+		Throws JsonSyntaxError on malformed sequences.
+	*/
+	u32 decodeEscape(const char*& cur, const char* end, char* out);
+
+	/*
+		Parses the number starting at begin, which must be a minus sign or a digit.
+		Integers exceeding IntegerType are read as floats.
+		Returns the end of the number or nullptr if there is none.
+	*/
+	const char* parseNumber(const char* begin, const char* end, IntegerType& integer, FloatType& floating, bool& isInteger);
+
+}
\ No newline at end of file
@@ -10,7 +10,7 @@
 
 namespace Json {
 
-	enum class Type {
+	enum class Type : u8 {
 
 		None,
 		String,
@@ -10,6 +10,8 @@
 #include "array.hpp"
 #include "object.hpp"
 
+#include <utility>
+
 
 
 bool JsonValue::toBoolean() const {
@@ -29,6 +29,8 @@ public:
 	template<CC::JsonString T>
 	constexpr JsonValue(const T& string) : type(Type::String), data(StringType(string)), integer(false) {}
 
+	JsonValue(StringType&& string) noexcept : type(Type::String), data(std::move(string)), integer(false) {}
+
 	template<CC::JsonNumber T> requires(CC::Float<TT::RemoveCVRef<T>>)
 	constexpr JsonValue(T number) : type(Type::Number), data(FloatType(number)), integer(false) {}
 
@@ -0,0 +1,400 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 writer.cpp
+ */
+
+#include "writer.hpp"
+#include "value.hpp"
+#include "array.hpp"
+#include "object.hpp"
+#include "math/math.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+
+
+JsonWriter::JsonWriter(const Sink& sink, bool compact) : sink(sink), compact(compact), buffer(std::make_unique<char[]>(BufferSize)), size(0), keyWritten(false), rootWritten(false) {}
+
+
+
+void JsonWriter::beginObject() {
+	beginContainer(true, '{');
+}
+
+void JsonWriter::endObject() {
+	endContainer(true, '}');
+}
+
+void JsonWriter::beginArray() {
+	beginContainer(false, '[');
+}
+
+void JsonWriter::endArray() {
+	endContainer(false, ']');
+}
+
+
+
+void JsonWriter::key(const StringView& name) {
+
+	if (containers.empty() || !containers.back().object || keyWritten)
+		throw JsonException("Member name written outside of an object");
+
+	Container& container = containers.back();
+
+	if (!container.empty)
+		write(',');
+
+	container.empty = false;
+
+	writeIndentation();
+	writeString(name);
+	write(':');
+
+	if (!compact)
+		write(' ');
+
+	keyWritten = true;
+
+}
+
+
+
+void JsonWriter::value(const StringView& string) {
+
+	beginValue();
+	writeString(string);
+
+}
+
+void JsonWriter::value(const StringType& string) {
+	value(StringView(string));
+}
+
+void JsonWriter::value(const char* string) {
+	value(StringView(string));
+}
+
+void JsonWriter::value(bool boolean) {
+
+	beginValue();
+
+	if (boolean)
+		write("true", 4);
+	else
+		write("false", 5);
+
+}
+
+void JsonWriter::value(std::nullptr_t) {
+
+	beginValue();
+	write("null", 4);
+
+}
+
+void JsonWriter::value(const JsonValue& value) {
+
+	switch (value.getType()) {
+
+	case Json::Type::String:
+		this->value(value.toString());
+		break;
+
+	case Json::Type::Number:
+
+		if (value.isInteger())
+			this->value(value.toNumber<IntegerType>());
+		else
+			this->value(value.toNumber<FloatType>());
+
+		break;
+
+	case Json::Type::Object:
+		this->value(value.toObject());
+		break;
+
+	case Json::Type::Array:
+		this->value(value.toArray());
+		break;
+
+	case Json::Type::Boolean:
+		this->value(value.toBoolean());
+		break;
+
+	case Json::Type::Null:
+	case Json::Type::None:
+		this->value(nullptr);
+		break;
+
+	}
+
+}
+
+void JsonWriter::value(const JsonObject& object) {
+
+	beginObject();
+
+	for (const auto& [name, member] : object) {
+
+		key(name);
+		value(member);
+
+	}
+
+	endObject();
+
+}
+
+void JsonWriter::value(const JsonArray& array) {
+
+	beginArray();
+
+	for (const JsonValue& element : array)
+		value(element);
+
+	endArray();
+
+}
+
+
+
+void JsonWriter::flush() {
+
+	if (size) {
+
+		sink(StringView(buffer.get(), size));
+		size = 0;
+
+	}
+
+}
+
+
+
+void JsonWriter::beginValue() {
+
+	if (containers.empty()) {
+
+		// Top-level values are separated by newlines
+		if (rootWritten)
+			write('\n');
+
+		rootWritten = true;
+		return;
+
+	}
+
+	Container& container = containers.back();
+
+	if (container.object) {
+
+		if (!keyWritten)
+			throw JsonException("Object member written without a name");
+
+		keyWritten = false;
+		return;
+
+	}
+
+	if (!container.empty)
+		write(',');
+
+	container.empty = false;
+
+	writeIndentation();
+
+}
+
+void JsonWriter::beginContainer(bool object, char c) {
+
+	beginValue();
+	write(c);
+
+	containers.push_back({ object, true });
+
+}
+
+void JsonWriter::endContainer(bool object, char c) {
+
+	if (containers.empty() || containers.back().object != object || keyWritten)
+		throw JsonException("Mismatched container end");
+
+	bool empty = containers.back().empty;
+	containers.pop_back();
+
+	if (!empty)
+		writeIndentation();
+
+	write(c);
+
+}
+
+
+
+void JsonWriter::writeInteger(IntegerType integer) {
+
+	beginValue();
+
+	char digits[24];
+	auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), integer);
+
+	write(digits, end - digits);
+
+}
+
+void JsonWriter::writeFloat(FloatType floating) {
+
+	beginValue();
+
+	// JSON has no representation for NaN and infinity
+	if (!std::isfinite(floating)) {
+
+		write("null", 4);
+		return;
+
+	}
+
+	char digits[32];
+	auto [end, ec] = std::to_chars(digits, digits + sizeof(digits), floating);
+
+	write(digits, end - digits);
+
+	// Keep the value a float when it is read back
+	if (std::find_if(digits, end, [](char c) { return c == '.' || c == 'e'; }) == end)
+		write(".0", 2);
+
+}
+
+void JsonWriter::writeString(const StringView& string) {
+
+	static constexpr char hexDigits[] = "0123456789abcdef";
+
+	write('"');
+
+	const char* cur = string.data();
+	const char* end = cur + string.size();
+
+	while (cur != end) {
+
+		// Copy runs without special characters in one go
+		const char* run = cur;
+
+		while (run != end && *run != '"' && *run != '\\' && static_cast<u8>(*run) >= 0x20)
+			run++;
+
+		write(cur, run - cur);
+		cur = run;
+
+		if (cur == end)
+			break;
+
+		char c = *cur++;
+
+		switch (c) {
+
+		case '"':
+			write("\\\"", 2);
+			break;
+
+		case '\\':
+			write("\\\\", 2);
+			break;
+
+		case '\b':
+			write("\\b", 2);
+			break;
+
+		case '\f':
+			write("\\f", 2);
+			break;
+
+		case '\n':
+			write("\\n", 2);
+			break;
+
+		case '\r':
+			write("\\r", 2);
+			break;
+
+		case '\t':
+			write("\\t", 2);
+			break;
+
+		default:
+		{
+			// Remaining control characters have no short form
+			char sequence[6] = { '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xF] };
+			write(sequence, 6);
+			break;
+		}
+
+		}
+
+	}
+
+	write('"');
+
+}
+
+void JsonWriter::writeIndentation() {
+
+	if (compact)
+		return;
+
+	write('\n');
+
+	SizeT count = containers.size() * IndentationLevel;
+
+	while (count) {
+
+		SizeT chunk = Math::min(count, BufferSize - size);
+
+		std::memset(buffer.get() + size, IndentationChar, chunk);
+		size += chunk;
+		count -= chunk;
+
+		if (size == BufferSize)
+			flush();
+
+	}
+
+}
+
+
+
+void JsonWriter::write(const char* data, SizeT count) {
+
+	if (size + count > BufferSize) {
+
+		flush();
+
+		// Large blocks bypass the buffer
+		if (count >= BufferSize) {
+
+			sink(StringView(data, count));
+			return;
+
+		}
+
+	}
+
+	std::memcpy(buffer.get() + size, data, count);
+	size += count;
+
+}
+
+void JsonWriter::write(char c) {
+
+	if (size == BufferSize)
+		flush();
+
+	buffer[size++] = c;
+
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 writer.hpp
+ */
+
+#pragma once
+
+#include "common.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+
+class JsonValue;
+
+
+/*
+	Streaming JSON serializer.
+	Output is collected in a fixed-size buffer which is handed to the sink whenever it fills up and on flush().
+	Consecutive top-level values are separated by newlines, which produces newline-delimited JSON.
+	flush() has to be called once writing is complete, the destructor does not invoke the sink.
+*/
+class JsonWriter {
+
+public:
+
+	using StringType = Json::StringType;
+	using StringView = Json::StringView;
+	using IntegerType = Json::IntegerType;
+	using FloatType = Json::FloatType;
+	using Sink = std::function<void(const StringView&)>;
+
+	static constexpr SizeT BufferSize = 0x4000;
+	static constexpr u32 IndentationLevel = 2;
+	static constexpr char IndentationChar = ' ';
+
+	explicit JsonWriter(const Sink& sink, bool compact = true);
+
+	void beginObject();
+	void endObject();
+	void beginArray();
+	void endArray();
+
+	void key(const StringView& name);
+
+	void value(const StringView& string);
+	void value(const StringType& string);
+	void value(const char* string);
+	void value(bool boolean);
+	void value(std::nullptr_t);
+
+	template<CC::JsonNumber T>
+	void value(T number) {
+
+		if constexpr (CC::Float<T>) {
+			writeFloat(static_cast<FloatType>(number));
+		} else {
+			writeInteger(static_cast<IntegerType>(number));
+		}
+
+	}
+
+	// Serializes a complete DOM subtree
+	void value(const JsonValue& value);
+	void value(const JsonObject& object);
+	void value(const JsonArray& array);
+
+	void flush();
+
+private:
+
+	struct Container {
+
+		bool object;
+		bool empty;
+
+	};
+
+	void beginValue();
+	void beginContainer(bool object, char c);
+	void endContainer(bool object, char c);
+
+	void writeInteger(IntegerType integer);
+	void writeFloat(FloatType floating);
+	void writeString(const StringView& string);
+	void writeIndentation();
+
+	void write(const char* data, SizeT count);
+	void write(char c);
+
+	Sink sink;
+	bool compact;
+
+	std::unique_ptr<char[]> buffer;
+	SizeT size;
+
+	std::vector<Container> containers;
+	bool keyWritten;
+	bool rootWritten;
+
+};
\ No newline at end of file
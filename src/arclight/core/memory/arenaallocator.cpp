@@ -0,0 +1,205 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 arenaallocator.cpp
+ */
+
+#include "arenaallocator.hpp"
+#include "virtualmemory.hpp"
+#include "util/bits.hpp"
+#include "math/math.hpp"
+#include "util/assert.hpp"
+
+#include <array>
+#include <new>
+#include <utility>
+
+
+
+static thread_local std::array<ArenaAllocator, 2> frameArenas;
+static thread_local u32 frameIndex = 0;
+
+
+
+ArenaAllocator::ArenaAllocator(SizeT reserveSize) : ArenaAllocator() {
+	create(reserveSize);
+}
+
+
+
+ArenaAllocator::~ArenaAllocator() noexcept {
+	clear();
+}
+
+
+
+ArenaAllocator::ArenaAllocator(ArenaAllocator&& allocator) noexcept :
+	base(std::exchange(allocator.base, nullptr)),
+	top(std::exchange(allocator.top, 0)),
+	committedSize(std::exchange(allocator.committedSize, 0)),
+	reservedSize(std::exchange(allocator.reservedSize, 0)),
+	peakSize(std::exchange(allocator.peakSize, 0)) {}
+
+
+
+ArenaAllocator& ArenaAllocator::operator=(ArenaAllocator&& allocator) noexcept {
+
+	if (this != &allocator) {
+
+		clear();
+
+		base = std::exchange(allocator.base, nullptr);
+		top = std::exchange(allocator.top, 0);
+		committedSize = std::exchange(allocator.committedSize, 0);
+		reservedSize = std::exchange(allocator.reservedSize, 0);
+		peakSize = std::exchange(allocator.peakSize, 0);
+
+	}
+
+	return *this;
+
+}
+
+
+
+void ArenaAllocator::create(SizeT reserveSize) {
+
+	clear();
+
+	SizeT alignedSize = Math::alignUp(Math::max(reserveSize, 1), CommitGranularity);
+	base = static_cast<u8*>(VirtualMemory::reserve(alignedSize));
+
+	if (!base) {
+		throw std::bad_alloc();
+	}
+
+	reservedSize = alignedSize;
+
+}
+
+
+
+void ArenaAllocator::clear() noexcept {
+
+	if (base) {
+		VirtualMemory::deallocate(base, reservedSize);
+	}
+
+	base = nullptr;
+	top = 0;
+	committedSize = 0;
+	reservedSize = 0;
+	peakSize = 0;
+
+}
+
+
+
+void* ArenaAllocator::allocate(SizeT size, AlignT alignment) {
+
+	arc_assert(Bits::isPowerOf2(alignment), "Alignment must be a power of two");
+
+	//Align the address rather than the offset so alignments beyond the page size are honored
+	AddressT start = reinterpret_cast<AddressT>(base);
+	SizeT offset = Math::alignUp(start + top, alignment) - start;
+
+	if (offset > committedSize || size > committedSize - offset) {
+		grow(offset, size);
+	}
+
+	top = offset + size;
+	peakSize = Math::max(peakSize, top);
+
+	return base + offset;
+
+}
+
+
+
+void ArenaAllocator::deallocate(void* ptr, SizeT size) noexcept {
+
+	u8* p = static_cast<u8*>(ptr);
+
+	//Popping the topmost allocation lets containers that grow by reallocation reuse their old space
+	if (p && p + size == base + top) {
+		top = p - base;
+	}
+
+}
+
+
+
+void ArenaAllocator::rewind(Marker marker) noexcept {
+
+	arc_assert(marker <= peakSize, "Arena marker was not obtained from this arena");
+
+	//Deallocating the topmost allocation may have popped the top below a marker taken later on
+	if (marker < top) {
+		top = marker;
+	}
+
+}
+
+
+
+void ArenaAllocator::reset() noexcept {
+	top = 0;
+}
+
+
+
+void ArenaAllocator::trim(SizeT retainSize) noexcept {
+
+	SizeT keepSize = Math::min(Math::alignUp(Math::max(top, retainSize), CommitGranularity), reservedSize);
+
+	if (keepSize < committedSize) {
+
+		VirtualMemory::decommit(base + keepSize, committedSize - keepSize);
+		committedSize = keepSize;
+
+	}
+
+}
+
+
+
+ArenaAllocator& ArenaAllocator::getFrameArena() {
+
+	ArenaAllocator& arena = frameArenas[frameIndex];
+
+	if (!arena.base) {
+		arena.create();
+	}
+
+	return arena;
+
+}
+
+
+
+void ArenaAllocator::nextFrame() noexcept {
+
+	frameIndex ^= 1;
+	frameArenas[frameIndex].reset();
+
+}
+
+
+
+void ArenaAllocator::grow(SizeT offset, SizeT size) {
+
+	if (offset > reservedSize || size > reservedSize - offset) {
+		throw std::bad_alloc();
+	}
+
+	SizeT newSize = Math::min(Math::alignUp(offset + size, CommitGranularity), reservedSize);
+
+	if (!VirtualMemory::commit(base + committedSize, newSize - committedSize, VirtualMemory::Protection::ReadWrite)) {
+		throw std::bad_alloc();
+	}
+
+	committedSize = newSize;
+
+}
\ No newline at end of file
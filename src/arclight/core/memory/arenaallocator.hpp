@@ -0,0 +1,206 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 arenaallocator.hpp
+ */
+
+#pragma once
+
+#include "types.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+
+
+
+/*
+
+	ArenaAllocator
+	Linear allocator for data sharing the same lifetime.
+
+	The arena reserves a contiguous range of address space on creation and commits it in CommitGranularity steps as the top grows.
+	Allocation bumps the top pointer, memory is reclaimed all at once by rewinding to a marker or resetting the whole arena.
+	Since the reservation never moves, pointers stay valid until the arena is rewound past them.
+
+	+---------------------+-----------------+--------------------------+
+	|      allocated      |    committed    |         reserved         |
+	+---------------------+-----------------+--------------------------+
+	base                  top               committed end              reserved end
+
+	ArenaAllocator is not thread-safe. Every thread owns a pair of frame arenas accessible through getFrameArena().
+
+*/
+class ArenaAllocator {
+
+public:
+
+	//Rollback point returned by getMarker()
+	using Marker = SizeT;
+
+	//Rewinds the arena to the state at construction on destruction
+	class Scope {
+
+	public:
+
+		explicit Scope(ArenaAllocator& arena) noexcept : arena(arena), marker(arena.getMarker()) {}
+		~Scope() noexcept { arena.rewind(marker); }
+
+		Scope(const Scope& scope) = delete;
+		Scope& operator=(const Scope& scope) = delete;
+
+	private:
+
+		ArenaAllocator& arena;
+		Marker marker;
+
+	};
+
+
+	constexpr static SizeT DefaultReserveSize = SizeT(1) << 30;
+	constexpr static SizeT CommitGranularity = 65536;
+
+
+	//Creates a new ArenaAllocator instance. No memory is reserved upon construction.
+	constexpr ArenaAllocator() noexcept : base(nullptr), top(0), committedSize(0), reservedSize(0), peakSize(0) {}
+
+	//Creates an arena reserving reserveSize bytes of address space. Throws std::bad_alloc if the reservation failed.
+	explicit ArenaAllocator(SizeT reserveSize);
+
+	//Memory is released automatically. Objects living in the arena are not destroyed.
+	~ArenaAllocator() noexcept;
+
+	//Move allowed, copy disabled.
+	ArenaAllocator(const ArenaAllocator& allocator) = delete;
+	ArenaAllocator& operator=(const ArenaAllocator& allocator) = delete;
+	ArenaAllocator(ArenaAllocator&& allocator) noexcept;
+	ArenaAllocator& operator=(ArenaAllocator&& allocator) noexcept;
+
+
+	/*
+		Reserves reserveSize bytes of address space without committing any of it. The previous reservation is released.
+		Throws std::bad_alloc if the reservation failed.
+	*/
+	void create(SizeT reserveSize = DefaultReserveSize);
+
+
+	//Releases the reservation if it has been created.
+	void clear() noexcept;
+
+
+	/*
+		Allocates size bytes aligned to alignment, which must be a power of two.
+		Throws std::bad_alloc if the arena has not been created, the reservation is exhausted or committing failed.
+	*/
+	[[nodiscard]] void* allocate(SizeT size, AlignT alignment = alignof(std::max_align_t));
+
+
+	//Allocates uninitialized storage for count objects of type T.
+	template<class T>
+	[[nodiscard]] T* allocate(SizeT count) {
+		return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+	}
+
+
+	/*
+		Returns memory to the arena. Only the topmost allocation is reclaimed immediately, anything else is freed on rewind/reset.
+		ptr:		The pointer to be deallocated. nullptr has no effect.
+		size:		The size passed to allocate().
+	*/
+	void deallocate(void* ptr, SizeT size) noexcept;
+
+
+	//Returns a marker for the current top of the arena.
+	Marker getMarker() const noexcept {
+		return top;
+	}
+
+	//Frees every allocation made after marker was obtained. Committed memory is kept for reuse. Has no effect if the top already lies below marker.
+	void rewind(Marker marker) noexcept;
+
+	//Frees all allocations. Committed memory is kept for reuse.
+	void reset() noexcept;
+
+	//Decommits memory above the top of the arena, keeping at least retainSize bytes committed.
+	void trim(SizeT retainSize = 0) noexcept;
+
+
+	//Returns the number of allocated bytes, including alignment padding.
+	SizeT getUsedSize() const noexcept {
+		return top;
+	}
+
+	SizeT getCommittedSize() const noexcept {
+		return committedSize;
+	}
+
+	SizeT getReservedSize() const noexcept {
+		return reservedSize;
+	}
+
+	//Returns the highest top since creation.
+	SizeT getPeakSize() const noexcept {
+		return peakSize;
+	}
+
+
+	/*
+		Returns the calling thread's arena for the current frame. The arenas are created on first use.
+		Allocations stay valid until the second call to nextFrame() after they were made, so data may be handed over to the next frame.
+	*/
+	static ArenaAllocator& getFrameArena();
+
+	//Advances the calling thread's frame, resetting the arena of the frame before the last one.
+	static void nextFrame() noexcept;
+
+
+private:
+
+	void grow(SizeT offset, SizeT size);
+
+
+	u8* base;
+	SizeT top;
+	SizeT committedSize;
+	SizeT reservedSize;
+	SizeT peakSize;
+
+};
+
+
+
+/*
+	Adapter exposing an ArenaAllocator as std::pmr::memory_resource.
+	The arena must outlive the resource and every container using it.
+*/
+class ArenaResource : public std::pmr::memory_resource {
+
+public:
+
+	explicit ArenaResource(ArenaAllocator& arena) noexcept : arena(arena) {}
+
+	ArenaAllocator& getArena() const noexcept {
+		return arena;
+	}
+
+private:
+
+	void* do_allocate(SizeT bytes, AlignT alignment) override {
+		return arena.allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void* p, SizeT bytes, [[maybe_unused]] AlignT alignment) override {
+		arena.deallocate(p, bytes);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+
+		const ArenaResource* resource = dynamic_cast<const ArenaResource*>(&other);
+		return resource && &resource->arena == &arena;
+
+	}
+
+	ArenaAllocator& arena;
+
+};
\ No newline at end of file
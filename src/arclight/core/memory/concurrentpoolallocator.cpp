@@ -0,0 +1,207 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 concurrentpoolallocator.cpp
+ */
+
+#include "concurrentpoolallocator.hpp"
+#include "math/math.hpp"
+#include "util/log.hpp"
+#include "arcconfig.hpp"
+
+#include <new>
+
+
+
+//Upper pointer bits are free on all supported platforms and hold the ABA tag
+constexpr static u32 PointerBits = sizeof(void*) == 8 ? 48 : 32;
+constexpr static u64 PointerMask = (u64(1) << PointerBits) - 1;
+
+
+
+constexpr static u64 nextTag(u64 top) noexcept {
+	return ((top >> PointerBits) + 1) << PointerBits;
+}
+
+
+
+ConcurrentPoolAllocator::~ConcurrentPoolAllocator() noexcept {
+	clear();
+}
+
+
+
+void ConcurrentPoolAllocator::create(AddressT blockCount, AddressT blockSize, AlignT blockAlign, bool growable) {
+
+	clear();
+
+	if (blockCount) {
+
+		AddressT baseSize = Math::max(blockSize, sizeof(Storage));
+		AlignT baseAlign = Math::max(blockAlign, alignof(Storage));
+		AddressT alignedSize = Math::alignUp(baseSize, baseAlign);
+
+		this->chunkBlocks = blockCount;
+		this->blockSize = alignedSize;
+		this->blockAlign = baseAlign;
+		this->growable = growable;
+
+		Storage* first = generateChunk();
+		head.store(reinterpret_cast<AddressT>(first), std::memory_order_release);
+
+	#ifdef ARC_ALLOCATOR_DEBUG_LOG
+		LogD("Concurrent Pool Allocator").print("Pool created at %p. Block size: %d, blocks per chunk: %d,", chunks, alignedSize, chunkBlocks);
+	#endif
+
+	}
+
+}
+
+
+
+void ConcurrentPoolAllocator::clear() noexcept {
+
+	u8* chunk = chunks;
+
+	while (chunk) {
+
+		u8* nextChunk = reinterpret_cast<ChunkLink*>(chunk + chunkBlocks * blockSize)->next;
+		::operator delete(chunk, std::align_val_t(blockAlign));
+
+	#ifdef ARC_ALLOCATOR_DEBUG_LOG
+		LogD("Concurrent Pool Allocator").print("Chunk destroyed at %p.", chunk);
+	#endif
+
+		chunk = nextChunk;
+
+	}
+
+	head.store(0, std::memory_order_relaxed);
+	chunks = nullptr;
+	chunkBlocks = 0;
+	blockSize = 0;
+	blockAlign = 0;
+	growable = false;
+
+}
+
+
+
+[[nodiscard]] void* ConcurrentPoolAllocator::allocate() {
+
+	Storage* block = pop();
+
+	if (!block) {
+
+		if (!growable) {
+			throw std::bad_alloc();
+		}
+
+		std::lock_guard lock(growMutex);
+
+		//Another thread may have grown the pool while this one was waiting
+		block = pop();
+
+		if (!block) {
+
+			block = generateChunk();
+
+			Storage* next = std::atomic_ref<Storage*>(block->next).load(std::memory_order_relaxed);
+
+			if (next) {
+				pushRange(next, reinterpret_cast<Storage*>(reinterpret_cast<u8*>(block) + (chunkBlocks - 1) * blockSize));
+			}
+
+		#ifdef ARC_ALLOCATOR_DEBUG_LOG
+			LogD("Concurrent Pool Allocator").print("Chunk created at %p.", chunks);
+		#endif
+
+		}
+
+	}
+
+	return block;
+
+}
+
+
+
+void ConcurrentPoolAllocator::deallocate(void* ptr) noexcept {
+
+	if (ptr) {
+
+		//Other threads may still read the link of this block in pop(), so it is only ever written atomically
+		Storage* storagePtr = static_cast<Storage*>(ptr);
+		std::atomic_ref<Storage*>(storagePtr->next).store(nullptr, std::memory_order_relaxed);
+
+		pushRange(storagePtr, storagePtr);
+
+	}
+
+}
+
+
+
+ConcurrentPoolAllocator::Storage* ConcurrentPoolAllocator::generateChunk() {
+
+	AddressT chunkSize = chunkBlocks * blockSize + sizeof(ChunkLink);
+	u8* chunk = static_cast<u8*>(::operator new(chunkSize, std::align_val_t(blockAlign)));
+
+	for (AddressT i = 0; i < chunkBlocks; i++) {
+
+		u8* ptr = chunk + i * blockSize;
+		u8* next = i == chunkBlocks - 1 ? nullptr : ptr + blockSize;
+
+		std::atomic_ref<Storage*>(reinterpret_cast<Storage*>(ptr)->next).store(reinterpret_cast<Storage*>(next), std::memory_order_relaxed);
+
+	}
+
+	//ChunkLink shares Storage's alignment. Chunks are only linked for destruction, the list is guarded by growMutex or create()
+	::new(chunk + chunkBlocks * blockSize) ChunkLink(chunks);
+	chunks = chunk;
+
+	return reinterpret_cast<Storage*>(chunk);
+
+}
+
+
+
+void ConcurrentPoolAllocator::pushRange(Storage* first, Storage* last) noexcept {
+
+	u64 top = head.load(std::memory_order_relaxed);
+	u64 newTop;
+
+	do {
+
+		std::atomic_ref<Storage*>(last->next).store(reinterpret_cast<Storage*>(top & PointerMask), std::memory_order_relaxed);
+		newTop = reinterpret_cast<AddressT>(first) | nextTag(top);
+
+	} while (!head.compare_exchange_weak(top, newTop, std::memory_order_release, std::memory_order_relaxed));
+
+}
+
+
+
+ConcurrentPoolAllocator::Storage* ConcurrentPoolAllocator::pop() noexcept {
+
+	u64 top = head.load(std::memory_order_acquire);
+
+	while (top & PointerMask) {
+
+		Storage* block = reinterpret_cast<Storage*>(top & PointerMask);
+
+		//The block may be taken and overwritten concurrently, chunks stay allocated so the read is safe and the tag invalidates the exchange
+		Storage* next = std::atomic_ref<Storage*>(block->next).load(std::memory_order_relaxed);
+		u64 newTop = reinterpret_cast<AddressT>(next) | nextTag(top);
+
+		if (head.compare_exchange_weak(top, newTop, std::memory_order_acquire, std::memory_order_acquire)) {
+			return block;
+		}
+
+	}
+
+	return nullptr;
+
+}
\ No newline at end of file
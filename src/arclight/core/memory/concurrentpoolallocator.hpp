@@ -0,0 +1,130 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 concurrentpoolallocator.hpp
+ */
+
+#pragma once
+
+#include "types.hpp"
+
+#include <atomic>
+#include <mutex>
+
+
+
+/*
+
+	ConcurrentPoolAllocator
+	Thread-safe variant of PoolAllocator.
+
+	allocate() and deallocate() are lock-free and may be called from any number of threads concurrently.
+	Free blocks form an intrusive stack whose head carries a modification tag in the unused upper pointer bits.
+	Every successful exchange increments the tag, so a head that has been popped and pushed again in between (ABA) is detected.
+
+	Blocks are carved out of chunks that stay allocated until clear() is called, hence reading the link of a block that
+	has just been taken by another thread is safe; the tag makes the following exchange fail.
+
+	If the pool is created as growable, an exhausted pool allocates another chunk of the initial block count instead of throwing.
+	Growing takes a lock, but only one thread allocates the chunk while the others keep allocating from blocks freed meanwhile.
+
+*/
+class ConcurrentPoolAllocator {
+
+public:
+
+	//Creates a new ConcurrentPoolAllocator instance. No memory is allocated upon construction.
+	constexpr ConcurrentPoolAllocator() noexcept : head(0), chunks(nullptr), chunkBlocks(0), blockSize(0), blockAlign(0), growable(false) {}
+
+	//Memory is freed automatically. However, the user must ensure every destructor is called before destroying the allocator itself.
+	~ConcurrentPoolAllocator() noexcept;
+
+	//Neither copyable nor movable since other threads may hold references.
+	ConcurrentPoolAllocator(const ConcurrentPoolAllocator& allocator) = delete;
+	ConcurrentPoolAllocator& operator=(const ConcurrentPoolAllocator& allocator) = delete;
+
+
+	/*
+		Creates a new heap which is partitioned into blocks. The previously created heap will be destroyed.
+		Not thread-safe. May throw std::bad_alloc if initial allocation failed.
+
+		blockCount:	Number of blocks the heap will contain initially. Growable pools add chunks of the same count.
+		blockSize:	Specifies the size of the block.
+		blockAlign: Specifies the alignment of the block.
+		growable:	If true, allocate() grows the heap once all blocks are in use.
+
+		The actual block size/alignment has a minimum as specified by Storage.
+	*/
+	void create(AddressT blockCount, AddressT blockSize, AlignT blockAlign, bool growable = false);
+
+
+	/*
+		Creates a new heap whereas block size/alignment is deduced by T.
+		See create(blockCount, blockSize, blockAlign, growable) for more information.
+	*/
+	template<class T>
+	void create(AddressT blockCount, bool growable = false) {
+		create(blockCount, sizeof(T), alignof(T), growable);
+	}
+
+
+	//Deallocates the heap if it has been created. Not thread-safe.
+	void clear() noexcept;
+
+
+	/*
+		Acquires a block of allocated memory.
+		Throws std::bad_alloc if no memory has been allocated, there is no free block left in a fixed pool or growing failed.
+		returns:	A pointer to the allocated block.
+	*/
+	[[nodiscard]] void* allocate();
+
+
+	/*
+		Deallocates a pointer. Deallocating memory as pointed to by the pointer which he does not own results in undefined behaviour.
+		ptr:		The pointer to be deallocated. nullptr has no effect.
+	*/
+	void deallocate(void* ptr) noexcept;
+
+
+private:
+
+	//Class that stores a pointer to the next free block. The link is only accessed through std::atomic_ref.
+	struct Storage {
+		Storage* next;
+	};
+
+	//Chunk link to the next chunk, placed behind the last block.
+	struct ChunkLink {
+
+		constexpr ChunkLink(u8* next) noexcept : next(next) {}
+
+		u8* next;
+
+	};
+
+
+	//Allocates a chunk, links its blocks and returns the first one.
+	Storage* generateChunk();
+
+	//Pushes the linked blocks [first; last] onto the freelist.
+	void pushRange(Storage* first, Storage* last) noexcept;
+
+	//Pops a block from the freelist or returns nullptr if it is empty.
+	Storage* pop() noexcept;
+
+
+	//Tagged freelist head on its own cache line to avoid false sharing with the read-mostly members
+	alignas(CacheLineSize) std::atomic<u64> head;
+
+	alignas(CacheLineSize) std::mutex growMutex;
+	u8* chunks;
+
+	AddressT chunkBlocks;
+	AddressT blockSize;
+	AlignT blockAlign;
+	bool growable;
+
+};
\ No newline at end of file
@@ -0,0 +1,628 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 sizeclassallocator.cpp
+ */
+
+#include "sizeclassallocator.hpp"
+#include "virtualmemory.hpp"
+#include "util/bits.hpp"
+#include "math/math.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+
+
+//Smallest block size and guaranteed alignment of small allocations
+constexpr static SizeT MinBlockSize = 16;
+constexpr static SizeT LinearClassLimit = 128;
+
+//Upper pointer bits are free on all supported platforms and hold ABA tags and batch sizes
+constexpr static u32 PointerBits = sizeof(void*) == 8 ? 48 : 32;
+constexpr static u64 PointerMask = (u64(1) << PointerBits) - 1;
+
+//Slab map covering the whole address space, one entry per slab
+constexpr static u32 SlabBits = 16;
+constexpr static u32 LeafBits = 16;
+constexpr static u32 RootBits = PointerBits - SlabBits - LeafBits;
+
+static_assert(SizeClassAllocator::SlabSize == SizeT(1) << SlabBits, "Slab size mismatch");
+
+
+
+/*
+	Sizes grow linearly in 16 byte steps up to 128 bytes, then in four steps per power of two.
+	This bounds internal fragmentation to 25% while keeping the class count low.
+*/
+constexpr static std::array<SizeT, SizeClassAllocator::ClassCount> classSizes = []() {
+
+	std::array<SizeT, SizeClassAllocator::ClassCount> sizes {};
+	u32 i = 0;
+
+	for (SizeT size = MinBlockSize; size <= LinearClassLimit; size += MinBlockSize) {
+		sizes[i++] = size;
+	}
+
+	for (SizeT base = LinearClassLimit; base < SizeClassAllocator::MaxSmallSize; base *= 2) {
+
+		for (SizeT step = 1; step <= 4; step++) {
+			sizes[i++] = base + base / 4 * step;
+		}
+
+	}
+
+	return sizes;
+
+}();
+
+static_assert(classSizes.back() == SizeClassAllocator::MaxSmallSize, "Size classes do not cover all small allocations");
+
+
+
+//Number of blocks moved between a thread cache and the central freelist at once
+constexpr static u32 getBatchSize(u32 sizeClass) {
+	return Math::clamp(SizeClassAllocator::SlabSize / classSizes[sizeClass] / 4, 1, 32);
+}
+
+
+
+constexpr static u32 getSizeClass(SizeT size) {
+
+	if (size <= LinearClassLimit) {
+		return (Math::max(size, 1) + MinBlockSize - 1) / MinBlockSize - 1;
+	}
+
+	u32 exponent = 63 - Bits::clz(u64(size - 1));
+	SizeT step = (SizeT(1) << exponent) / 4;
+
+	return 8 + (exponent - 7) * 4 + (size - 1 - (SizeT(1) << exponent)) / step;
+
+}
+
+
+
+//Free blocks are linked through their first word. The first block of a batch additionally links to the next batch and stores the batch size.
+//popBatch() may read batchLink of a batch that is being pushed concurrently, so it is only accessed through std::atomic_ref.
+struct Block {
+
+	Block* next;
+	u64 batchLink;
+
+};
+
+struct alignas(CacheLineSize) CentralList {
+
+	std::atomic<u64> head;
+
+};
+
+struct FreeList {
+
+	Block* head;
+	u32 count;
+
+};
+
+//Counters are only written by the owning thread
+struct Counters {
+
+	std::atomic<SizeT> allocations;
+	std::atomic<SizeT> deallocations;
+	std::atomic<SizeT> allocatedBytes;
+	std::atomic<SizeT> largeAllocations;
+	std::atomic<SizeT> largeBytes;
+
+};
+
+//Stored in front of every large allocation
+struct LargeHeader {
+
+	void* base;
+	SizeT mappedSize;
+	SizeT usableSize;
+
+};
+
+
+struct ThreadCache {
+
+	ThreadCache() noexcept;
+	~ThreadCache() noexcept;
+
+	FreeList lists[SizeClassAllocator::ClassCount] {};
+	Counters counters {};
+
+	ThreadCache* previous;
+	ThreadCache* next;
+
+};
+
+
+
+static CentralList centralLists[SizeClassAllocator::ClassCount];
+static std::atomic<u8*> slabMap[SizeT(1) << RootBits];
+static std::atomic<SizeT> slabBytes;
+
+//Registry of live thread caches and counters of finished threads
+static std::mutex registryMutex;
+static ThreadCache* registryHead;
+static Counters retiredCounters;
+
+static thread_local ThreadCache threadCache;
+static thread_local bool threadCacheDestroyed;
+
+
+
+static void addCounter(std::atomic<SizeT>& counter, SizeT value) noexcept {
+	counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+
+
+static void pushBatch(u32 sizeClass, Block* batch, u32 count) noexcept {
+
+	std::atomic<u64>& head = centralLists[sizeClass].head;
+	u64 top = head.load(std::memory_order_relaxed);
+	u64 newTop;
+
+	do {
+
+		std::atomic_ref<u64>(batch->batchLink).store((top & PointerMask) | (u64(count) << PointerBits), std::memory_order_relaxed);
+		newTop = reinterpret_cast<AddressT>(batch) | ((top >> PointerBits) + 1) << PointerBits;
+
+	} while (!head.compare_exchange_weak(top, newTop, std::memory_order_release, std::memory_order_relaxed));
+
+}
+
+
+
+static Block* popBatch(u32 sizeClass, u32& count) noexcept {
+
+	std::atomic<u64>& head = centralLists[sizeClass].head;
+	u64 top = head.load(std::memory_order_acquire);
+
+	while (top & PointerMask) {
+
+		Block* batch = reinterpret_cast<Block*>(top & PointerMask);
+
+		//The batch may be taken concurrently, slabs stay mapped so the read is safe and the tag invalidates the exchange
+		u64 link = std::atomic_ref<u64>(batch->batchLink).load(std::memory_order_relaxed);
+		u64 newTop = (link & PointerMask) | ((top >> PointerBits) + 1) << PointerBits;
+
+		if (head.compare_exchange_weak(top, newTop, std::memory_order_acquire, std::memory_order_acquire)) {
+
+			count = link >> PointerBits;
+			return batch;
+
+		}
+
+	}
+
+	return nullptr;
+
+}
+
+
+
+//Returns the size class of the slab containing ptr or ClassCount if ptr is not part of a slab
+static u32 lookupSlab(const void* ptr) noexcept {
+
+	AddressT index = reinterpret_cast<AddressT>(ptr) >> SlabBits;
+	const u8* leaf = slabMap[index >> LeafBits].load(std::memory_order_acquire);
+
+	if (!leaf || !leaf[index & ((1 << LeafBits) - 1)]) {
+		return SizeClassAllocator::ClassCount;
+	}
+
+	return leaf[index & ((1 << LeafBits) - 1)] - 1;
+
+}
+
+
+
+static void registerSlab(const void* slab, u32 sizeClass) {
+
+	AddressT index = reinterpret_cast<AddressT>(slab) >> SlabBits;
+	std::atomic<u8*>& root = slabMap[index >> LeafBits];
+	u8* leaf = root.load(std::memory_order_acquire);
+
+	if (!leaf) {
+
+		u8* newLeaf = new u8[SizeT(1) << LeafBits] {};
+
+		if (root.compare_exchange_strong(leaf, newLeaf, std::memory_order_acq_rel, std::memory_order_acquire)) {
+			leaf = newLeaf;
+		} else {
+			delete[] newLeaf;
+		}
+
+	}
+
+	leaf[index & ((1 << LeafBits) - 1)] = sizeClass + 1;
+
+}
+
+
+
+//Carves a new slab into batches, the first one refills the given list
+static void createSlab(u32 sizeClass, FreeList& list) {
+
+	u8* slab = static_cast<u8*>(::operator new(SizeClassAllocator::SlabSize, std::align_val_t(SizeClassAllocator::SlabSize)));
+
+	registerSlab(slab, sizeClass);
+	slabBytes.fetch_add(SizeClassAllocator::SlabSize, std::memory_order_relaxed);
+
+	SizeT blockSize = classSizes[sizeClass];
+	u32 blockCount = SizeClassAllocator::SlabSize / blockSize;
+	u32 batchSize = getBatchSize(sizeClass);
+
+	for (u32 i = 0; i < blockCount; i += batchSize) {
+
+		u32 count = Math::min(batchSize, blockCount - i);
+		Block* batch = reinterpret_cast<Block*>(slab + i * blockSize);
+
+		for (u32 j = 0; j < count; j++) {
+
+			Block* block = reinterpret_cast<Block*>(slab + (i + j) * blockSize);
+			block->next = j + 1 < count ? reinterpret_cast<Block*>(slab + (i + j + 1) * blockSize) : nullptr;
+
+		}
+
+		if (i == 0) {
+
+			list.head = batch;
+			list.count = count;
+
+		} else {
+
+			pushBatch(sizeClass, batch, count);
+
+		}
+
+	}
+
+}
+
+
+
+static void refill(u32 sizeClass, FreeList& list) {
+
+	u32 count;
+	Block* batch = popBatch(sizeClass, count);
+
+	if (batch) {
+
+		list.head = batch;
+		list.count = count;
+
+	} else {
+
+		createSlab(sizeClass, list);
+
+	}
+
+}
+
+
+
+//Moves up to count blocks from the list to the central freelist
+static void release(u32 sizeClass, FreeList& list, u32 count) noexcept {
+
+	Block* batch = list.head;
+	Block* last = batch;
+
+	count = Math::min(count, list.count);
+
+	for (u32 i = 1; i < count; i++) {
+		last = last->next;
+	}
+
+	list.head = last->next;
+	list.count -= count;
+	last->next = nullptr;
+
+	pushBatch(sizeClass, batch, count);
+
+}
+
+
+
+static void releaseAll(FreeList* lists) noexcept {
+
+	for (u32 i = 0; i < SizeClassAllocator::ClassCount; i++) {
+
+		while (lists[i].count) {
+			release(i, lists[i], getBatchSize(i));
+		}
+
+	}
+
+}
+
+
+
+static void retireCounters(const Counters& counters) noexcept {
+
+	retiredCounters.allocations.fetch_add(counters.allocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	retiredCounters.deallocations.fetch_add(counters.deallocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	retiredCounters.allocatedBytes.fetch_add(counters.allocatedBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	retiredCounters.largeAllocations.fetch_add(counters.largeAllocations.load(std::memory_order_relaxed), std::memory_order_relaxed);
+	retiredCounters.largeBytes.fetch_add(counters.largeBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+}
+
+
+
+ThreadCache::ThreadCache() noexcept : previous(nullptr) {
+
+	std::lock_guard lock(registryMutex);
+
+	next = registryHead;
+
+	if (registryHead) {
+		registryHead->previous = this;
+	}
+
+	registryHead = this;
+
+}
+
+
+
+ThreadCache::~ThreadCache() noexcept {
+
+	releaseAll(lists);
+
+	std::lock_guard lock(registryMutex);
+
+	retireCounters(counters);
+
+	if (previous) {
+		previous->next = next;
+	} else {
+		registryHead = next;
+	}
+
+	if (next) {
+		next->previous = previous;
+	}
+
+	threadCacheDestroyed = true;
+
+}
+
+
+
+static void* allocateLarge(SizeT size, AlignT alignment) {
+
+	SizeT mappedSize = size + sizeof(LargeHeader) + alignment;
+
+	if (mappedSize < size) {
+		throw std::bad_alloc();
+	}
+
+	void* base = VirtualMemory::allocate(mappedSize, VirtualMemory::Protection::ReadWrite);
+
+	if (!base) {
+		throw std::bad_alloc();
+	}
+
+	u8* ptr = reinterpret_cast<u8*>(Math::alignUp(reinterpret_cast<AddressT>(base) + sizeof(LargeHeader), alignment));
+	LargeHeader* header = reinterpret_cast<LargeHeader*>(ptr) - 1;
+
+	header->base = base;
+	header->mappedSize = mappedSize;
+	header->usableSize = static_cast<u8*>(base) + mappedSize - ptr;
+
+	//Memory handed out during thread teardown bypasses the cache and its counters
+	if (threadCacheDestroyed) {
+
+		retiredCounters.allocations.fetch_add(1, std::memory_order_relaxed);
+		retiredCounters.largeAllocations.fetch_add(1, std::memory_order_relaxed);
+		retiredCounters.largeBytes.fetch_add(mappedSize, std::memory_order_relaxed);
+
+	} else {
+
+		Counters& counters = threadCache.counters;
+
+		addCounter(counters.allocations, 1);
+		addCounter(counters.largeAllocations, 1);
+		addCounter(counters.largeBytes, mappedSize);
+
+	}
+
+	return ptr;
+
+}
+
+
+
+static void deallocateLarge(void* ptr) noexcept {
+
+	LargeHeader* header = static_cast<LargeHeader*>(ptr) - 1;
+	SizeT mappedSize = header->mappedSize;
+
+	VirtualMemory::deallocate(header->base, mappedSize);
+
+	if (threadCacheDestroyed) {
+
+		retiredCounters.deallocations.fetch_add(1, std::memory_order_relaxed);
+		retiredCounters.largeAllocations.fetch_sub(1, std::memory_order_relaxed);
+		retiredCounters.largeBytes.fetch_sub(mappedSize, std::memory_order_relaxed);
+
+	} else {
+
+		Counters& counters = threadCache.counters;
+
+		addCounter(counters.deallocations, 1);
+		addCounter(counters.largeAllocations, -1);
+		addCounter(counters.largeBytes, -mappedSize);
+
+	}
+
+}
+
+
+
+void* SizeClassAllocator::allocate(SizeT size, AlignT alignment) {
+
+	//Power of two classes are aligned to their size within a slab
+	if (alignment > MinBlockSize && size <= MaxSmallSize) {
+		size = Bits::ceilPowerOf2(Math::max(size, alignment));
+	}
+
+	if (size > MaxSmallSize) {
+		return allocateLarge(size, alignment);
+	}
+
+	u32 sizeClass = getSizeClass(size);
+
+	if (threadCacheDestroyed) {
+
+		FreeList list {};
+		refill(sizeClass, list);
+
+		Block* block = list.head;
+		list.head = block->next;
+		list.count--;
+
+		if (list.count) {
+			pushBatch(sizeClass, list.head, list.count);
+		}
+
+		retiredCounters.allocations.fetch_add(1, std::memory_order_relaxed);
+		retiredCounters.allocatedBytes.fetch_add(classSizes[sizeClass], std::memory_order_relaxed);
+
+		return block;
+
+	}
+
+	ThreadCache& cache = threadCache;
+	FreeList& list = cache.lists[sizeClass];
+
+	if (!list.head) {
+		refill(sizeClass, list);
+	}
+
+	Block* block = list.head;
+	list.head = block->next;
+	list.count--;
+
+	addCounter(cache.counters.allocations, 1);
+	addCounter(cache.counters.allocatedBytes, classSizes[sizeClass]);
+
+	return block;
+
+}
+
+
+
+void SizeClassAllocator::deallocate(void* ptr) noexcept {
+
+	if (!ptr) {
+		return;
+	}
+
+	u32 sizeClass = lookupSlab(ptr);
+
+	if (sizeClass == ClassCount) {
+
+		deallocateLarge(ptr);
+		return;
+
+	}
+
+	Block* block = static_cast<Block*>(ptr);
+
+	if (threadCacheDestroyed) {
+
+		block->next = nullptr;
+		pushBatch(sizeClass, block, 1);
+
+		retiredCounters.deallocations.fetch_add(1, std::memory_order_relaxed);
+		retiredCounters.allocatedBytes.fetch_sub(classSizes[sizeClass], std::memory_order_relaxed);
+
+		return;
+
+	}
+
+	ThreadCache& cache = threadCache;
+	FreeList& list = cache.lists[sizeClass];
+
+	block->next = list.head;
+	list.head = block;
+	list.count++;
+
+	//Keep one batch around so alternating allocations and deallocations don't hit the central list
+	u32 batchSize = getBatchSize(sizeClass);
+
+	if (list.count >= batchSize * 2) {
+		release(sizeClass, list, batchSize);
+	}
+
+	addCounter(cache.counters.deallocations, 1);
+	addCounter(cache.counters.allocatedBytes, -classSizes[sizeClass]);
+
+}
+
+
+
+SizeT SizeClassAllocator::getSize(const void* ptr) noexcept {
+
+	if (!ptr) {
+		return 0;
+	}
+
+	u32 sizeClass = lookupSlab(ptr);
+
+	if (sizeClass == ClassCount) {
+		return (static_cast<const LargeHeader*>(ptr) - 1)->usableSize;
+	}
+
+	return classSizes[sizeClass];
+
+}
+
+
+
+void SizeClassAllocator::releaseThreadCache() noexcept {
+
+	if (!threadCacheDestroyed) {
+		releaseAll(threadCache.lists);
+	}
+
+}
+
+
+
+SizeClassAllocator::Statistics SizeClassAllocator::getStatistics() noexcept {
+
+	Statistics statistics {};
+
+	auto accumulate = [&statistics](const Counters& counters) {
+
+		statistics.allocations += counters.allocations.load(std::memory_order_relaxed);
+		statistics.deallocations += counters.deallocations.load(std::memory_order_relaxed);
+		statistics.allocatedBytes += counters.allocatedBytes.load(std::memory_order_relaxed);
+		statistics.largeAllocations += counters.largeAllocations.load(std::memory_order_relaxed);
+		statistics.largeBytes += counters.largeBytes.load(std::memory_order_relaxed);
+
+	};
+
+	std::lock_guard lock(registryMutex);
+
+	accumulate(retiredCounters);
+
+	for (const ThreadCache* cache = registryHead; cache; cache = cache->next) {
+		accumulate(cache->counters);
+	}
+
+	statistics.slabBytes = slabBytes.load(std::memory_order_relaxed);
+
+	return statistics;
+
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 sizeclassallocator.hpp
+ */
+
+#pragma once
+
+#include "common/concepts.hpp"
+#include "types.hpp"
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+
+
+/*
+
+	SizeClassAllocator
+	General-purpose thread-safe allocator.
+
+	Requests up to MaxSmallSize bytes are rounded up to one of ClassCount size classes and served from a per-thread cache without synchronization.
+	Thread caches exchange batches of blocks with a lock-free central freelist per size class, which in turn carves new blocks out of SlabSize slabs.
+	Slabs are never returned to the system, their blocks are reused for the same size class.
+	Larger requests are served through VirtualMemory and unmapped on deallocation.
+
+	Blocks may be deallocated by any thread, they end up in the cache of the deallocating thread.
+
+*/
+class SizeClassAllocator {
+
+public:
+
+	//Allocation counters summed over all threads.
+	struct Statistics {
+
+		SizeT allocations;			//Total number of allocations
+		SizeT deallocations;		//Total number of deallocations
+		SizeT allocatedBytes;		//Bytes in live small allocations, including size class rounding
+		SizeT largeAllocations;		//Number of live allocations served by VirtualMemory
+		SizeT largeBytes;			//Bytes mapped for live large allocations
+		SizeT slabBytes;			//Bytes reserved for slabs
+
+	};
+
+	constexpr static SizeT MaxSmallSize = 32768;
+	constexpr static SizeT SlabSize = 65536;
+	constexpr static u32 ClassCount = 40;
+
+	SizeClassAllocator() = delete;
+
+
+	/*
+		Allocates at least size bytes aligned to alignment, which must be a power of two.
+		Throws std::bad_alloc if the system is out of memory.
+	*/
+	[[nodiscard]] static void* allocate(SizeT size, AlignT alignment = alignof(std::max_align_t));
+
+
+	/*
+		Deallocates memory obtained from allocate(). Passing any other pointer results in undefined behaviour.
+		ptr:		The pointer to be deallocated. nullptr has no effect.
+	*/
+	static void deallocate(void* ptr) noexcept;
+
+
+	//Returns the number of usable bytes of an allocation.
+	static SizeT getSize(const void* ptr) noexcept;
+
+
+	//Hands all blocks cached by the calling thread back to the central freelists. Called automatically on thread exit.
+	static void releaseThreadCache() noexcept;
+
+
+	//Returns a snapshot of the allocation counters. Counters of running threads are read without synchronization and may be slightly out of date.
+	static Statistics getStatistics() noexcept;
+
+};
+
+
+
+template<class T> requires (!CC::ConstType<T>)
+class SizeClassAllocatorAdapter {
+
+public:
+
+	using value_type = T;
+	using size_type = SizeT;
+	using difference_type = std::ptrdiff_t;
+	using propagate_on_container_move_assignment = std::true_type;
+	using is_always_equal = std::true_type;
+
+
+	constexpr SizeClassAllocatorAdapter() noexcept = default;
+	constexpr ~SizeClassAllocatorAdapter() noexcept = default;
+
+	constexpr SizeClassAllocatorAdapter(const SizeClassAllocatorAdapter& alloc) noexcept = default;
+	constexpr SizeClassAllocatorAdapter& operator=(const SizeClassAllocatorAdapter& alloc) = default;
+
+	template<class U>
+	constexpr SizeClassAllocatorAdapter(const SizeClassAllocatorAdapter<U>& alloc) noexcept {};
+
+
+	[[nodiscard]] T* allocate(SizeT n) {
+
+		if (std::numeric_limits<SizeT>::max() / sizeof(T) < n) {
+			throw std::bad_array_new_length();
+		}
+
+		return static_cast<T*>(SizeClassAllocator::allocate(n * sizeof(T), alignof(T)));
+
+	}
+
+	void deallocate(T* p, [[maybe_unused]] SizeT n) noexcept {
+		SizeClassAllocator::deallocate(p);
+	}
+
+
+	template<class U>
+	struct rebind {
+		using other = SizeClassAllocatorAdapter<U>;
+	};
+
+};
+
+
+template<class T, class U>
+constexpr bool operator==(const SizeClassAllocatorAdapter<T>& lhs, const SizeClassAllocatorAdapter<U>& rhs) noexcept {
+	return true;
+}
\ No newline at end of file
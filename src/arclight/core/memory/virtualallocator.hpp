@@ -52,8 +52,8 @@ public:
 
 	}
 
-	constexpr void deallocate(T* p, [[maybe_unused]] SizeT n) noexcept {
-		VirtualMemory::deallocate(p);
+	constexpr void deallocate(T* p, SizeT n) noexcept {
+		VirtualMemory::deallocate(p, n * sizeof(T));
 	}
 
 
@@ -0,0 +1,46 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 virtualmemory.cpp
+ */
+
+#include "virtualmemory.hpp"
+#include "math/math.hpp"
+
+
+
+//Guarded allocations are built on top of the platform reservation primitives
+void* VirtualMemory::allocateGuarded(SizeT size, Protection protection) {
+
+	SizeT pageSize = getPageSize();
+	SizeT usableSize = Math::alignUp(size, pageSize);
+
+	u8* base = static_cast<u8*>(reserve(usableSize + 2 * pageSize));
+
+	if (!base) {
+		return nullptr;
+	}
+
+	if (!commit(base + pageSize, usableSize, protection)) {
+
+		deallocate(base, usableSize + 2 * pageSize);
+		return nullptr;
+
+	}
+
+	return base + pageSize;
+
+}
+
+
+
+bool VirtualMemory::deallocateGuarded(void* ptr, SizeT size) {
+
+	SizeT pageSize = getPageSize();
+	SizeT usableSize = Math::alignUp(size, pageSize);
+
+	return deallocate(static_cast<u8*>(ptr) - pageSize, usableSize + 2 * pageSize);
+
+}
\ No newline at end of file
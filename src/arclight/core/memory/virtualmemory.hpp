@@ -15,6 +15,7 @@
 namespace VirtualMemory {
 
 	enum class Protection {
+		NoAccess,
 		Execute,
 		ReadOnly,
 		ReadWrite,
@@ -23,19 +24,67 @@ namespace VirtualMemory {
 	};
 
 	/*
-	 *  Allocates virtual memory pages with the given protection
-	 *
+	 *  Returns the size of a regular page
+	 */
+	SizeT getPageSize();
+
+	/*
+	 *  Returns the size of a huge/large page or 0 if the system does not support them
+	 */
+	SizeT getLargePageSize();
+
+	/*
+	 *  Allocates virtual memory pages with the given protection. Returns nullptr on failure.
 	 */
 	void* allocate(SizeT size, Protection protection);
 
 	/*
-	 *  Deallocates virtual memory allocated with allocate(). Returns true if the deallocation was successful, false otherwise.
+	 *  Allocates memory backed by explicit huge/large pages. size is rounded up to a multiple of getLargePageSize().
+	 *  Returns nullptr if no huge pages are available, the caller is expected to fall back to allocate().
+	 */
+	void* allocateLarge(SizeT size, Protection protection);
+
+	/*
+	 *  Deallocates virtual memory allocated with allocate(), allocateLarge() or reserve(). size must match the (rounded) allocation size.
+	 *  Returns true if the deallocation was successful, false otherwise.
 	 */
-	bool deallocate(void* ptr);
+	bool deallocate(void* ptr, SizeT size);
 
 	/*
 	 *  Sets the page protection for all pages containing the addresses in the range [start; start + size]. Returns true if the page protection has been applied correctly.
 	 */
 	bool protect(void* start, SizeT size, Protection protection);
 
+	/*
+	 *  Reserves address space without backing it by physical memory. Accessing reserved pages faults until they are committed.
+	 *  Returns nullptr on failure. The reservation is freed with deallocate().
+	 */
+	void* reserve(SizeT size);
+
+	/*
+	 *  Commits the pages containing [start; start + size] of a reservation. Newly committed pages are zeroed.
+	 */
+	bool commit(void* start, SizeT size, Protection protection);
+
+	/*
+	 *  Returns the physical memory of the pages containing [start; start + size] to the system while keeping the address range reserved.
+	 */
+	bool decommit(void* start, SizeT size);
+
+	/*
+	 *  Hints that the range should be backed by transparent huge pages. Returns false if the hint is not supported.
+	 */
+	bool adviseHugePages(void* start, SizeT size);
+
+	/*
+	 *  Allocates size bytes rounded up to whole pages, surrounded by one inaccessible guard page on either side.
+	 *  Overruns and underruns fault immediately. Returns nullptr on failure.
+	 */
+	void* allocateGuarded(SizeT size, Protection protection);
+
+	/*
+	 *  Deallocates memory allocated with allocateGuarded(). size must be the requested allocation size.
+	 */
+	bool deallocateGuarded(void* ptr, SizeT size);
+
 }
\ No newline at end of file
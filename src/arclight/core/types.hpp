@@ -38,4 +38,8 @@ using AddressT  = uintptr_t;
 	using SystemT = u16;
 #else
 	using SystemT = u32;
-#endif
\ No newline at end of file
+#endif
+
+
+//Cache line size used to separate data written by different threads
+constexpr SizeT CacheLineSize = 64;
\ No newline at end of file
@@ -12,6 +12,8 @@
 #include "common/concepts.hpp"
 #include "types.hpp"
 
+#include <utility>
+
 
 
 namespace Bool {
@@ -0,0 +1,189 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 cpuid.cpp
+ */
+
+#include "cpuid.hpp"
+#include "arcbuild.hpp"
+
+#include <cstdlib>
+#include <iterator>
+#include <string_view>
+
+#ifdef ARC_PLATFORM_X86
+	#ifdef ARC_COMPILER_MSVC
+		#include <intrin.h>
+	#else
+		#include <cpuid.h>
+	#endif
+#endif
+
+
+
+namespace CPUID {
+
+#ifdef ARC_PLATFORM_X86
+
+	static void query(u32 leaf, u32 subleaf, u32 (&registers)[4]) noexcept {
+
+#ifdef ARC_COMPILER_MSVC
+		int values[4];
+		__cpuidex(values, leaf, subleaf);
+
+		for (u32 i = 0; i < 4; i++) {
+			registers[i] = values[i];
+		}
+#else
+		__cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+
+	}
+
+
+	static u64 readExtendedControlRegister() noexcept {
+
+#ifdef ARC_COMPILER_MSVC
+		return _xgetbv(0);
+#else
+		u32 low, high;
+		__asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+
+		return (u64(high) << 32) | low;
+#endif
+
+	}
+
+
+	static u32 detectFeatures() noexcept {
+
+		auto flag = [](CPUFeature feature) {
+			return 1u << static_cast<u32>(feature);
+		};
+
+		u32 features = 0;
+		u32 registers[4] = {};
+
+		query(0, 0, registers);
+		u32 maxLeaf = registers[0];
+
+		if (maxLeaf < 1) {
+			return 0;
+		}
+
+		query(1, 0, registers);
+
+		u32 ecx1 = registers[2];
+		u32 edx1 = registers[3];
+
+		features |= (edx1 & (1 << 26)) ? flag(CPUFeature::SSE2) : 0;
+		features |= (ecx1 & (1 <<  0)) ? flag(CPUFeature::SSE3) : 0;
+		features |= (ecx1 & (1 <<  9)) ? flag(CPUFeature::SSSE3) : 0;
+		features |= (ecx1 & (1 << 19)) ? flag(CPUFeature::SSE4_1) : 0;
+		features |= (ecx1 & (1 << 20)) ? flag(CPUFeature::SSE4_2) : 0;
+		features |= (ecx1 & (1 << 25)) ? flag(CPUFeature::AES) : 0;
+		features |= (ecx1 & (1 <<  1)) ? flag(CPUFeature::PCLMULQDQ) : 0;
+
+		//YMM/ZMM state must be enabled by the OS via XSAVE
+		bool osxsave = ecx1 & (1 << 27);
+		u64 xcr0 = osxsave ? readExtendedControlRegister() : 0;
+
+		bool ymmState = (xcr0 & 0x06) == 0x06;
+		bool zmmState = (xcr0 & 0xE6) == 0xE6;
+
+		if (ymmState) {
+
+			features |= (ecx1 & (1 << 28)) ? flag(CPUFeature::AVX) : 0;
+			features |= (ecx1 & (1 << 12)) ? flag(CPUFeature::FMA) : 0;
+
+		}
+
+		if (maxLeaf >= 7) {
+
+			query(7, 0, registers);
+
+			u32 ebx7 = registers[1];
+
+			features |= (ebx7 & (1 <<  8)) ? flag(CPUFeature::BMI2) : 0;
+			features |= (ebx7 & (1 << 29)) ? flag(CPUFeature::SHA) : 0;
+
+			if (ymmState) {
+				features |= (ebx7 & (1 << 5)) ? flag(CPUFeature::AVX2) : 0;
+			}
+
+			if (zmmState) {
+
+				features |= (ebx7 & (1 << 16)) ? flag(CPUFeature::AVX512F) : 0;
+				features |= (ebx7 & (1 << 17)) ? flag(CPUFeature::AVX512DQ) : 0;
+				features |= (ebx7 & (1 << 30)) ? flag(CPUFeature::AVX512BW) : 0;
+				features |= (ebx7 & (1u << 31)) ? flag(CPUFeature::AVX512VL) : 0;
+
+			}
+
+		}
+
+		return features;
+
+	}
+
+#else
+
+	static u32 detectFeatures() noexcept {
+		return 0;
+	}
+
+#endif
+
+
+	//Returns the features named in the comma separated list, or all features if any entry is no feature name
+	static u32 parseFeatureList(std::string_view list) noexcept {
+
+		constexpr const char* names[] = {
+			"SSE2", "SSE3", "SSSE3", "SSE4_1", "SSE4_2", "AVX", "AVX2", "FMA", "BMI2",
+			"AVX512F", "AVX512DQ", "AVX512BW", "AVX512VL", "AES", "PCLMULQDQ", "SHA"
+		};
+
+		static_assert(std::size(names) == static_cast<u32>(CPUFeature::SHA) + 1, "Feature name missing");
+
+		u32 features = 0;
+
+		while (!list.empty()) {
+
+			SizeT end = list.find(',');
+			std::string_view name = list.substr(0, end);
+			u32 i = 0;
+
+			while (i < std::size(names) && name != names[i]) {
+				i++;
+			}
+
+			if (i == std::size(names)) {
+				return ~0u;
+			}
+
+			features |= 1u << i;
+			list = end == list.npos ? std::string_view() : list.substr(end + 1);
+
+		}
+
+		return features ? features : ~0u;
+
+	}
+
+
+	bool hasFeature(CPUFeature feature) noexcept {
+
+		static const u32 features = []() {
+
+			const char* disabled = std::getenv("ARC_CPUID_DISABLE");
+			return detectFeatures() & ~(disabled ? parseFeatureList(disabled) : 0);
+
+		}();
+
+		return features & (1u << static_cast<u32>(feature));
+
+	}
+
+}
\ No newline at end of file
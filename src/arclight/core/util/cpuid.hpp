@@ -0,0 +1,46 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 cpuid.hpp
+ */
+
+#pragma once
+
+#include "types.hpp"
+
+
+
+enum class CPUFeature {
+	SSE2,
+	SSE3,
+	SSSE3,
+	SSE4_1,
+	SSE4_2,
+	AVX,
+	AVX2,
+	FMA,
+	BMI2,
+	AVX512F,
+	AVX512DQ,
+	AVX512BW,
+	AVX512VL,
+	AES,
+	PCLMULQDQ,
+	SHA
+};
+
+
+/*
+	Runtime instruction set detection.
+	Features are queried once and cached. AVX and AVX-512 are only reported if the OS saves the extended register state.
+	On non-x86 platforms, no feature is reported.
+	Setting the environment variable ARC_CPUID_DISABLE hides all features, which forces the dispatched code onto its fallback paths.
+	If it holds a comma separated list of feature names instead, e.g. ARC_CPUID_DISABLE=SHA,AVX512F, only those are hidden.
+*/
+namespace CPUID {
+
+	bool hasFeature(CPUFeature feature) noexcept;
+
+}
\ No newline at end of file
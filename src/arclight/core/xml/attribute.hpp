@@ -48,7 +48,9 @@ namespace Xml
 		{}
 #else
 		XML_TEMPLATE_INLINE Attribute(NodeT& parent) :
-			parent(parent)
+			parent(parent),
+			next(nullptr),
+			previous(nullptr)
 		{}
 #endif
 
@@ -115,19 +117,19 @@ namespace Xml
 	private:
 
 #ifdef XML_TEMPLATE_CHAR_TYPE
-		template<CC::Char CharType>
+		template<CC::Char C>
 #endif
 		friend class Document;
 
 #ifdef XML_TEMPLATE_CHAR_TYPE
-		template<CC::Char CharType>
+		template<CC::Char C>
 #endif
 		friend class Node;
 
 
 #ifdef XML_TEMPLATE_CHAR_TYPE
-		template<CC::Char CharType>
-		friend std::basic_ostream<CharType>& operator<<(std::basic_ostream<CharType>&, const Attribute<CharType>&);
+		template<CC::Char C>
+		friend std::basic_ostream<C>& operator<<(std::basic_ostream<C>&, const Attribute<C>&);
 #else
 		friend std::basic_ostream<CharType>& operator<<(std::basic_ostream<CharType>&, const Attribute&);
 #endif
@@ -139,7 +141,8 @@ namespace Xml
 		u64 index;
 #else
 		NodeT& parent;
-		SizeT index;
+		AttributeT* next;
+		AttributeT* previous;
 #endif
 		
 		StringRefT name;
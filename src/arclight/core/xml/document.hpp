@@ -14,6 +14,7 @@
 #include "stringref.hpp"
 #include "attribute.hpp"
 #include "node.hpp"
+#include "memory/chunkallocator.hpp"
 
 #include <sstream>
 
@@ -55,8 +56,16 @@ namespace Xml
 #else
 			root(*this, {}, NodeType::Element)
 #endif
-		{}
+		{
+#ifndef XML_NODE_STORAGE_UNIFIED
+			createStorage();
+#endif
+		}
 
+		/*
+			Parses the given text in-situ. Names and values reference the source directly,
+			therefore the source (e.g. a memory-mapped file) has to outlive the document.
+		*/
 		XML_TEMPLATE_INLINE SizeT read(const StringView& sv) {
 
 			CharIteratorT it(sv);
@@ -94,6 +103,41 @@ namespace Xml
 
 		}
 
+#ifndef XML_NODE_STORAGE_UNIFIED
+		// Takes ownership of the source and replaces the current content
+		XML_TEMPLATE_INLINE SizeT read(String&& text) {
+
+			clear();
+
+			source = std::move(text);
+
+			return read(StringView(source));
+
+		}
+
+		XML_TEMPLATE_INLINE SizeT read(const CharType* text) {
+			return read(StringView(text));
+		}
+
+		// Removes all nodes and releases the owned source
+		XML_TEMPLATE_INLINE void clear() {
+
+			// Pool memory is dropped as a whole, links to it must not survive
+			root.firstChild = nullptr;
+			root.lastChild = nullptr;
+			root.firstAttribute = nullptr;
+			root.lastAttribute = nullptr;
+			root.name.clear();
+			root.value.clear();
+
+			createStorage();
+
+			source.clear();
+			source.shrink_to_fit();
+
+		}
+#endif
+
 		XML_TEMPLATE_INLINE void write(std::basic_ostream<CharType>& os, int indentWidth = 4, CharType indentChar = ' ') const {
 
 			writeNodes(os, root.getFirstChild(), indentWidth, indentChar);
@@ -645,12 +689,12 @@ namespace Xml
 	private:
 
 #ifdef XML_TEMPLATE_CHAR_TYPE
-		template<CC::Char CharType>
+		template<CC::Char C>
 #endif
 		friend class Node;
 
 #ifdef XML_TEMPLATE_CHAR_TYPE
-		template<CC::Char CharType>
+		template<CC::Char C>
 #endif
 		friend class Attribute;
 
@@ -675,12 +719,138 @@ namespace Xml
 		u64 nodeUUID = 0;
 		u64 attributeUUID = 0;
 
+#else
+
+		// Number of nodes/attributes per pool chunk
+		constexpr static SizeT NodeChunkSize = 1024;
+		constexpr static SizeT AttributeChunkSize = 1024;
+
+		// Recreating the pools hands out blocks in document order again
+		XML_TEMPLATE_INLINE void createStorage() {
+
+			nodeStorage.template create<NodeT>(NodeChunkSize);
+			attributeStorage.template create<AttributeT>(AttributeChunkSize);
+
+		}
+
+		XML_TEMPLATE_INLINE NodeT& createNode(NodeT& parent) {
+			return *::new(nodeStorage.allocate()) NodeT(*this, parent, NodeType::Element);
+		}
+
+		XML_TEMPLATE_INLINE AttributeT& createAttribute(NodeT& parent) {
+			return *::new(attributeStorage.allocate()) AttributeT(parent);
+		}
+
+		XML_TEMPLATE_INLINE void destroyNode(NodeT& node) {
+
+			node.~NodeT();
+			nodeStorage.deallocate(&node);
+
+		}
+
+		XML_TEMPLATE_INLINE void destroyAttribute(AttributeT& attribute) {
+
+			attribute.~AttributeT();
+			attributeStorage.deallocate(&attribute);
+
+		}
+
+		ChunkAllocator nodeStorage;
+		ChunkAllocator attributeStorage;
+		String source;
+
 #endif
 
 		NodeT root;
 
 	};
 
+#ifndef XML_NODE_STORAGE_UNIFIED
+
+#ifdef XML_TEMPLATE_CHAR_TYPE
+	template<CC::Char CharType>
+	void Node<CharType>::clear() {
+#else
+	void Node::clear() {
+#endif
+
+		for (NodeT* child = firstChild; child;) {
+
+			NodeT* nextChild = child->next;
+
+			child->clear();
+			owner.destroyNode(*child);
+
+			child = nextChild;
+
+		}
+
+		for (AttributeT* attr = firstAttribute; attr;) {
+
+			AttributeT* nextAttr = attr->next;
+			owner.destroyAttribute(*attr);
+			attr = nextAttr;
+
+		}
+
+		firstChild = nullptr;
+		lastChild = nullptr;
+		firstAttribute = nullptr;
+		lastAttribute = nullptr;
+
+		name.clear();
+		value.clear();
+
+	}
+
+#ifdef XML_TEMPLATE_CHAR_TYPE
+	template<CC::Char CharType>
+	Node<CharType>& Node<CharType>::create() {
+#else
+	Node& Node::create() {
+#endif
+
+		NodeT& node = owner.createNode(*this);
+
+		node.previous = lastChild;
+
+		if (lastChild) {
+			lastChild->next = &node;
+		} else {
+			firstChild = &node;
+		}
+
+		lastChild = &node;
+
+		return node;
+
+	}
+
+#ifdef XML_TEMPLATE_CHAR_TYPE
+	template<CC::Char CharType>
+	Attribute<CharType>& Node<CharType>::createAttribute() {
+#else
+	Attribute& Node::createAttribute() {
+#endif
+
+		AttributeT& attr = owner.createAttribute(*this);
+
+		attr.previous = lastAttribute;
+
+		if (lastAttribute) {
+			lastAttribute->next = &attr;
+		} else {
+			firstAttribute = &attr;
+		}
+
+		lastAttribute = &attr;
+
+		return attr;
+
+	}
+
+#endif
+
 #ifdef XML_TEMPLATE_CHAR_TYPE
 	template<CC::Char CharType>
 	std::basic_ostream<CharType>& operator<<(std::basic_ostream<CharType>& os, const Document<CharType>& document) {
@@ -703,7 +873,8 @@ namespace Xml
 
 		std::basic_string<CharType> s(std::istreambuf_iterator<CharType>(is), {});
 
-		SizeT read = document.read(s);
+		// The document keeps the text alive since its nodes reference it
+		SizeT read = document.read(std::move(s));
 
 		return is.seekg(read);
 	
@@ -0,0 +1,200 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 entity.hpp
+ */
+
+#pragma once
+
+#include "xmlc.hpp"
+
+
+namespace Xml
+{
+
+	namespace Detail
+	{
+
+#ifdef XML_TEMPLATE_CHAR_TYPE
+		template<CC::Char CharType>
+#endif
+		XML_TEMPLATE_INLINE constexpr bool parseCharReference(const std::basic_string_view<CharType>& digits, u32& codepoint) {
+
+			u32 base = 10;
+			SizeT i = 0;
+
+			if (!digits.empty() && (digits[0] == CharType('x') || digits[0] == CharType('X'))) {
+				base = 16;
+				i++;
+			}
+
+			if (i == digits.size())
+				return false;
+
+			codepoint = 0;
+
+			for (; i < digits.size(); i++) {
+
+				CharType c = digits[i];
+				u32 digit;
+
+				if (c >= CharType('0') && c <= CharType('9')) {
+					digit = c - CharType('0');
+				} else if (base == 16 && c >= CharType('a') && c <= CharType('f')) {
+					digit = c - CharType('a') + 10;
+				} else if (base == 16 && c >= CharType('A') && c <= CharType('F')) {
+					digit = c - CharType('A') + 10;
+				} else {
+					return false;
+				}
+
+				codepoint = codepoint * base + digit;
+
+				if (codepoint > 0x10FFFF)
+					return false;
+
+			}
+
+			// Surrogates are no characters and cannot be encoded
+			return codepoint < 0xD800 || codepoint > 0xDFFF;
+
+		}
+
+#ifdef XML_TEMPLATE_CHAR_TYPE
+		template<CC::Char CharType>
+#endif
+		XML_TEMPLATE_INLINE constexpr void appendCodepoint(std::basic_string<CharType>& string, u32 codepoint) {
+
+			if constexpr (sizeof(CharType) == 1) {
+
+				if (codepoint < 0x80) {
+					string += CharType(codepoint);
+				} else if (codepoint < 0x800) {
+					string += CharType(0xC0 | (codepoint >> 6));
+					string += CharType(0x80 | (codepoint & 0x3F));
+				} else if (codepoint < 0x10000) {
+					string += CharType(0xE0 | (codepoint >> 12));
+					string += CharType(0x80 | ((codepoint >> 6) & 0x3F));
+					string += CharType(0x80 | (codepoint & 0x3F));
+				} else {
+					string += CharType(0xF0 | (codepoint >> 18));
+					string += CharType(0x80 | ((codepoint >> 12) & 0x3F));
+					string += CharType(0x80 | ((codepoint >> 6) & 0x3F));
+					string += CharType(0x80 | (codepoint & 0x3F));
+				}
+
+			} else if constexpr (sizeof(CharType) == 2) {
+
+				if (codepoint < 0x10000) {
+					string += CharType(codepoint);
+				} else {
+					codepoint -= 0x10000;
+					string += CharType(0xD800 | (codepoint >> 10));
+					string += CharType(0xDC00 | (codepoint & 0x3FF));
+				}
+
+			} else {
+
+				string += CharType(codepoint);
+
+			}
+
+		}
+
+	}
+
+	// Returns true if the string contains an entity or character reference
+#ifdef XML_TEMPLATE_CHAR_TYPE
+	template<CC::Char CharType>
+#endif
+	XML_TEMPLATE_INLINE constexpr bool hasEntities(const std::basic_string_view<CharType>& sv) {
+		return sv.find(CharType('&')) != sv.npos;
+	}
+
+	/*
+		Replaces the predefined entities and numeric character references.
+		Unknown or malformed references are copied verbatim. A reference ends at the next ';', or is malformed if another '&' comes first.
+	*/
+#ifdef XML_TEMPLATE_CHAR_TYPE
+	template<CC::Char CharType>
+#endif
+	XML_TEMPLATE_INLINE constexpr std::basic_string<CharType> decodeEntities(const std::basic_string_view<CharType>& sv) {
+
+		using StringView = std::basic_string_view<CharType>;
+
+		std::basic_string<CharType> string;
+		string.reserve(sv.size());
+
+		SizeT i = 0;
+
+		while (i < sv.size()) {
+
+			SizeT amp = sv.find(CharType('&'), i);
+
+			if (amp == sv.npos) {
+				string.append(sv.substr(i));
+				break;
+			}
+
+			string.append(sv.substr(i, amp - i));
+
+			const CharType terminators[] = { CharType(';'), CharType('&') };
+			SizeT semicolon = sv.find_first_of(StringView(terminators, 2), amp + 1);
+
+			if (semicolon == sv.npos) {
+				string.append(sv.substr(amp));
+				break;
+			}
+
+			// Another reference starts before this one is terminated
+			if (sv[semicolon] == CharType('&')) {
+				string.append(sv.substr(amp, semicolon - amp));
+				i = semicolon;
+				continue;
+			}
+
+			StringView entity = sv.substr(amp + 1, semicolon - amp - 1);
+			u32 codepoint = 0;
+
+			auto matches = [&entity](const char* name) {
+
+				SizeT j = 0;
+
+				for (; name[j]; j++) {
+
+					if (j == entity.size() || entity[j] != CharType(name[j]))
+						return false;
+
+				}
+
+				return j == entity.size();
+
+			};
+
+			if (matches("lt")) {
+				string += CharType('<');
+			} else if (matches("gt")) {
+				string += CharType('>');
+			} else if (matches("amp")) {
+				string += CharType('&');
+			} else if (matches("apos")) {
+				string += CharType('\'');
+			} else if (matches("quot")) {
+				string += CharType('"');
+			} else if (!entity.empty() && entity[0] == CharType('#') && Detail::parseCharReference(entity.substr(1), codepoint)) {
+				Detail::appendCodepoint(string, codepoint);
+			} else {
+				string.append(sv.substr(amp, semicolon - amp + 1));
+			}
+
+			i = semicolon + 1;
+
+		}
+
+		return string;
+
+	}
+
+}
\ No newline at end of file
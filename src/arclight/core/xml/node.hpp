@@ -62,21 +62,19 @@ namespace Xml
 #else
 		XML_TEMPLATE_INLINE Node(DocumentT& document, OptionalRef<NodeT> parent, NodeType type) :
 			owner(document),
+			type(type),
 			parent(parent),
-			type(type)
+			firstChild(nullptr),
+			lastChild(nullptr),
+			next(nullptr),
+			previous(nullptr),
+			firstAttribute(nullptr),
+			lastAttribute(nullptr)
 		{}
 #endif
 
 		// Removes children, attributes, name and value
-		XML_TEMPLATE_INLINE void clear() {
-
-			children.clear();
-			attributes.clear();
-
-			name.clear();
-			value.clear();
-
-		}
+		XML_TEMPLATE_INLINE void clear();
 
 		constexpr auto& getName() {
 			return name;
@@ -133,67 +131,47 @@ namespace Xml
 		// Returns the next node
 		XML_TEMPLATE_INLINE OptionalRef<NodeT> getNext() {
 
-			if (!parent)
-				return {};
-
-			SizeT nextID = index + 1;
-
-			if (nextID >= parent->children.size())
+			if (!next)
 				return {};
 
-			return *parent->children.at(nextID);
+			return *next;
 
 		}
 
 		// Returns the next node
 		XML_TEMPLATE_INLINE OptionalRef<const NodeT> getNext() const {
 
-			if (!parent)
+			if (!next)
 				return {};
 
-			SizeT nextID = index + 1;
-
-			if (nextID >= parent->children.size())
-				return {};
-
-			return *parent->children.at(nextID);
+			return *next;
 
 		}
 
 		// Returns the previous node
 		XML_TEMPLATE_INLINE OptionalRef<NodeT> getPrevious() {
 
-			if (!parent)
+			if (!previous)
 				return {};
 
-			SizeT prevID = index - 1;
-
-			if (prevID >= parent->children.size())
-				return {};
-
-			return *parent->children.at(prevID);
+			return *previous;
 
 		}
 
 		// Returns the previous node
 		XML_TEMPLATE_INLINE OptionalRef<const NodeT> getPrevious() const {
 
-			if (!parent)
-				return {};
-
-			SizeT prevID = index - 1;
-
-			if (prevID >= parent->children.size())
+			if (!previous)
 				return {};
 
-			return *parent->children.at(prevID);
+			return *previous;
 
 		}
 
 		// Returns the first node with the given name
 		XML_TEMPLATE_INLINE OptionalRef<NodeT> getNodeByName(const StringView& sv) {
 
-			for (auto& node : children) {
+			for (NodeT* node = firstChild; node; node = node->next) {
 				if (node->name == sv) {
 					return *node;
 				}
@@ -206,7 +184,7 @@ namespace Xml
 		// Returns the first node with the given name
 		XML_TEMPLATE_INLINE OptionalRef<const NodeT> getNodeByName(const StringView& sv) const {
 
-			for (auto& node : children) {
+			for (NodeT* node = firstChild; node; node = node->next) {
 				if (node->name == sv) {
 					return *node;
 				}
@@ -219,7 +197,7 @@ namespace Xml
 		// Returns the first attribute with the given name
 		XML_TEMPLATE_INLINE OptionalRef<AttributeT> getAttributeByName(const StringView& sv) {
 
-			for (auto& attr : attributes) {
+			for (AttributeT* attr = firstAttribute; attr; attr = attr->next) {
 				if (attr->name == sv) {
 					return *attr;
 				}
@@ -232,7 +210,7 @@ namespace Xml
 		// Returns the first attribute with the given name
 		XML_TEMPLATE_INLINE OptionalRef<const AttributeT> getAttributeByName(const StringView& sv) const {
 
-			for (auto& attr : attributes) {
+			for (AttributeT* attr = firstAttribute; attr; attr = attr->next) {
 				if (attr->name == sv) {
 					return *attr;
 				}
@@ -245,62 +223,48 @@ namespace Xml
 		// Returns the first child node
 		XML_TEMPLATE_INLINE OptionalRef<NodeT> getFirstChild() {
 
-			if (children.empty())
+			if (!firstChild)
 				return {};
 
-			return *children.front();
+			return *firstChild;
 
 		}
 
 		// Returns the first child node
 		XML_TEMPLATE_INLINE OptionalRef<const NodeT> getFirstChild() const {
 
-			if (children.empty())
+			if (!firstChild)
 				return {};
 
-			return *children.front();
+			return *firstChild;
 
 		}
 
 		// Returns the first attribute
 		XML_TEMPLATE_INLINE OptionalRef<AttributeT> getFirstAttribute() {
 
-			if (attributes.empty())
+			if (!firstAttribute)
 				return {};
 
-			return *attributes.front();
+			return *firstAttribute;
 
 		}
 
 		// Returns the first attribute
 		XML_TEMPLATE_INLINE OptionalRef<const AttributeT> getFirstAttribute() const {
 
-			if (attributes.empty())
+			if (!firstAttribute)
 				return {};
 
-			return *attributes.front();
+			return *firstAttribute;
 
 		}
 
 		// Creates a children node
-		XML_TEMPLATE_INLINE NodeT& create() {
-
-			auto& node = children.emplace_back(std::make_unique<NodeT>(owner, *this, NodeType::Element));
-			node->index = children.size() - 1;
-
-			return *node;
-
-		}
+		XML_TEMPLATE_INLINE NodeT& create();
 
 		// Creates an attribute
-		XML_TEMPLATE_INLINE AttributeT& createAttribute() {
-
-			auto& attr = attributes.emplace_back(std::make_unique<AttributeT>(*this));
-			attr->index = attributes.size() - 1;
-
-			return *attr;
-
-		}
+		XML_TEMPLATE_INLINE AttributeT& createAttribute();
 
 		Node(const NodeT&) = delete;
 		Node& operator=(const NodeT&) = delete;
@@ -375,19 +339,19 @@ namespace Xml
 		}
 
 #ifdef XML_TEMPLATE_CHAR_TYPE
-		template<CC::Char CharType>
+		template<CC::Char C>
 #endif
 		friend class Document;
 
 #ifdef XML_TEMPLATE_CHAR_TYPE
-		template<CC::Char CharType>
+		template<CC::Char C>
 #endif
 		friend class Attribute;
 
 
 #ifdef XML_TEMPLATE_CHAR_TYPE
-		template<CC::Char CharType>
-		friend std::basic_ostream<CharType>& operator<<(std::basic_ostream<CharType>&, const Node<CharType>&);
+		template<CC::Char C>
+		friend std::basic_ostream<C>& operator<<(std::basic_ostream<C>&, const Node<C>&);
 #else
 		friend std::basic_ostream<CharType>& operator<<(std::basic_ostream<CharType>&, const Node&);
 #endif
@@ -402,9 +366,14 @@ namespace Xml
 		std::vector<u64> attributes;
 #else
 		OptionalRef<NodeT> parent;
-		SizeT index;
-		std::vector<std::unique_ptr<NodeT>> children;
-		std::vector<std::unique_ptr<AttributeT>> attributes;
+
+		// Siblings and attributes are linked in document order, the objects themselves live in the document's pools
+		NodeT* firstChild;
+		NodeT* lastChild;
+		NodeT* next;
+		NodeT* previous;
+		AttributeT* firstAttribute;
+		AttributeT* lastAttribute;
 #endif
 
 		StringRefT name;
@@ -437,12 +406,10 @@ namespace Xml
 	OptionalRef<Attribute> Attribute::getNext() {
 #endif
 
-		SizeT nextID = index + 1;
-
-		if (nextID >= parent.attributes.size())
+		if (!next)
 			return {};
 
-		return *parent.attributes.at(nextID);
+		return *next;
 
 	}
 
@@ -453,12 +420,10 @@ namespace Xml
 	OptionalRef<const Attribute> Attribute::getNext() const {
 #endif
 
-		SizeT nextID = index + 1;
-
-		if (nextID >= parent.attributes.size())
+		if (!next)
 			return {};
 
-		return *parent.attributes.at(nextID);
+		return *next;
 
 	}
 
@@ -469,12 +434,10 @@ namespace Xml
 	OptionalRef<Attribute> Attribute::getPrevious() {
 #endif
 
-		SizeT prevID = index - 1;
-
-		if (prevID >= parent.attributes.size())
+		if (!previous)
 			return {};
 
-		return *parent.attributes.at(prevID);
+		return *previous;
 
 	}
 
@@ -485,12 +448,10 @@ namespace Xml
 	OptionalRef<const Attribute> Attribute::getPrevious() const {
 #endif
 
-		SizeT prevID = index - 1;
-
-		if (prevID >= parent.attributes.size())
+		if (!previous)
 			return {};
 
-		return *parent.attributes.at(prevID);
+		return *previous;
 	
 	}
 
@@ -0,0 +1,759 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 reader.hpp
+ */
+
+#pragma once
+
+#include "xmlc.hpp"
+#include "charfilter.hpp"
+#include "chariterator.hpp"
+#include "stringref.hpp"
+
+
+namespace Xml
+{
+
+	enum class ReaderEvent
+	{
+		NeedInput,				// The current token is incomplete, feed more data
+		EndOfInput,				// All input has been consumed
+		StartElement,			// <name
+		Attribute,				// name="value" inside an element or processing instruction
+		EndElement,				// </name> or the end of a self-closing element
+		Text,					// Character data, entities are not decoded
+		CData,					// <![CDATA[...]]>
+		Comment,				// <!-- ... -->
+		ProcessingInstruction,	// <?name ...?>
+		Declaration				// <!DOCTYPE ...> or <!ELEMENT ...>
+	};
+
+
+	/*
+		Pull parser for chunked XML input.
+		Data is handed over with feed() in pieces of any size, next() then yields one event at a time
+		and returns NeedInput whenever a token is cut off by the end of the available data.
+		Only the unconsumed input and the path of open elements are kept in memory.
+		Names and values reference the internal buffer and stay valid until the next call to next() or feed().
+	*/
+#ifdef XML_TEMPLATE_CHAR_TYPE
+	template<CC::Char CharType = char>
+#endif
+	class Reader
+	{
+	private:
+
+		using String		= std::basic_string<CharType>;
+		using StringView	= std::basic_string_view<CharType>;
+
+#ifdef XML_TEMPLATE_CHAR_TYPE
+		using FiltersT		= Filters<CharType>;
+		using StringRefT	= StringRef<CharType>;
+		using CharIteratorT = CharIterator<CharType>;
+#else
+		using FiltersT		= Filters;
+		using StringRefT	= StringRef;
+		using CharIteratorT = CharIterator;
+#endif
+
+	public:
+
+		XML_TEMPLATE_INLINE Reader() {
+			reset();
+		}
+
+		XML_TEMPLATE_INLINE void feed(const StringView& chunk) {
+
+			if (finished)
+				throw XmlParseError("Cannot feed a finished reader");
+
+			// Drop consumed input, tag boundaries move along
+			buffer.erase(0, position);
+
+			tagClose -= position;
+			tagNext -= position;
+			position = 0;
+
+			buffer.append(chunk);
+
+		}
+
+		XML_TEMPLATE_INLINE void finish() {
+			finished = true;
+		}
+
+		XML_TEMPLATE_INLINE void reset() {
+
+			buffer.clear();
+			position = 0;
+			scanOffset = 0;
+			scanQuote = 0;
+			scanBrackets = 0;
+			finished = false;
+			started = false;
+
+			state = State::Content;
+			tagClose = 0;
+			tagNext = 0;
+			selfClosing = false;
+
+			path.clear();
+			pathOffsets.clear();
+			popPending = false;
+
+			lastEvent = ReaderEvent::NeedInput;
+			skipping = false;
+			skipLevel = 0;
+
+			name.clear();
+			value.clear();
+
+		}
+
+		XML_TEMPLATE_INLINE ReaderEvent next() {
+
+			if (popPending) {
+				popElement();
+			}
+
+			if (skipping && !skipContent()) {
+				return ReaderEvent::NeedInput;
+			}
+
+			ReaderEvent event;
+
+			switch (state) {
+
+			case State::Attributes:
+				event = readAttribute();
+				break;
+
+			case State::SelfClose:
+
+				state = State::Content;
+				name = getElementName();
+				popPending = true;
+
+				event = ReaderEvent::EndElement;
+				break;
+
+			default:
+				event = readContent();
+				break;
+
+			}
+
+			if (event != ReaderEvent::NeedInput)
+				lastEvent = event;
+
+			return event;
+
+		}
+
+		// Skips the element opened by the last StartElement event including its end tag
+		XML_TEMPLATE_INLINE void skip() {
+
+			if (lastEvent != ReaderEvent::StartElement && lastEvent != ReaderEvent::Attribute)
+				return;
+
+			if (state == State::Attributes) {
+				position = tagNext;
+			}
+
+			lastEvent = ReaderEvent::NeedInput;
+
+			// Skipped content is never part of the path, so nothing is allocated
+			state = State::Content;
+
+			if (selfClosing) {
+
+				popElement();
+
+			} else {
+
+				skipping = true;
+				skipLevel = 0;
+
+			}
+
+		}
+
+		// Element, attribute, processing instruction or declaration name
+		XML_TEMPLATE_INLINE const StringRefT& getName() const {
+			return name;
+		}
+
+		// Attribute value, text, comment or declaration body
+		XML_TEMPLATE_INLINE const StringRefT& getValue() const {
+			return value;
+		}
+
+		// Names of all open elements separated by '/'
+		XML_TEMPLATE_INLINE StringView getPath() const {
+			return path;
+		}
+
+		XML_TEMPLATE_INLINE SizeT getDepth() const {
+			return pathOffsets.size();
+		}
+
+	private:
+
+		enum class State
+		{
+			Content,
+			Attributes,
+			SelfClose
+		};
+
+		enum class Token
+		{
+			Incomplete,
+			StartTag,
+			EndTag,
+			Comment,
+			CData,
+			ProcessingInstruction,
+			Declaration
+		};
+
+		XML_TEMPLATE_INLINE ReaderEvent readContent() {
+
+			if (!started) {
+
+				constexpr CharType bom[] = { CharType(0xEF), CharType(0xBB), CharType(0xBF) };
+
+				SizeT count = buffer.size() < 3 ? buffer.size() : 3;
+
+				// Wait until the byte order mark can be ruled out
+				if (StringView(buffer.data(), count) == StringView(bom, count)) {
+
+					if (count < 3 && !finished)
+						return ReaderEvent::NeedInput;
+
+					position = count;
+
+				}
+
+				started = true;
+
+			}
+
+			while (true) {
+
+				if (position == buffer.size()) {
+
+					if (!finished)
+						return ReaderEvent::NeedInput;
+
+					if (!pathOffsets.empty())
+						throw XmlParseError("Unexpected end of data");
+
+					return ReaderEvent::EndOfInput;
+
+				}
+
+				if (buffer[position] != CharType('<')) {
+
+					bool complete;
+
+					if (!readText(complete))
+						return ReaderEvent::NeedInput;
+
+					if (complete)
+						return ReaderEvent::Text;
+
+					continue;
+
+				}
+
+				Token token = classifyToken();
+				SizeT end;
+
+				if (token == Token::Incomplete || !findTokenEnd(token, end))
+					return ReaderEvent::NeedInput;
+
+				switch (token) {
+
+				case Token::Comment:
+					setValue(position + 4, end - 2);
+					position = end + 1;
+					return ReaderEvent::Comment;
+
+				case Token::CData:
+					setValue(position + 9, end - 2);
+					position = end + 1;
+					return ReaderEvent::CData;
+
+				case Token::ProcessingInstruction:
+
+					readTagName(position + 2, end);
+
+					tagClose = end - 1;
+					tagNext = end + 1;
+					selfClosing = false;
+					state = State::Attributes;
+
+					return ReaderEvent::ProcessingInstruction;
+
+				case Token::Declaration:
+				{
+					readTagName(position + 2, end);
+
+					CharIteratorT it(StringView(buffer.data() + position, end - position));
+
+					it.skip(FiltersT::Space);
+					value.begin(&it);
+					value.end(buffer.data() + end);
+
+					position = end + 1;
+
+					return ReaderEvent::Declaration;
+				}
+
+				case Token::EndTag:
+					readEndTag(end);
+					return ReaderEvent::EndElement;
+
+				default:
+
+					readTagName(position + 1, end);
+
+					selfClosing = buffer[end - 1] == CharType('/');
+					tagClose = selfClosing ? end - 1 : end;
+					tagNext = end + 1;
+					state = State::Attributes;
+
+					pushElement(name.toStringView());
+
+					return ReaderEvent::StartElement;
+
+				}
+
+			}
+
+		}
+
+		// Returns false if more input is required, complete is set if a non-blank text event was produced
+		XML_TEMPLATE_INLINE bool readText(bool& complete) {
+
+			SizeT end = buffer.find(CharType('<'), position + scanOffset);
+
+			if (end == buffer.npos) {
+
+				if (!finished) {
+					scanOffset = buffer.size() - position;
+					return false;
+				}
+
+				end = buffer.size();
+
+			}
+
+			scanOffset = 0;
+
+			CharIteratorT it(StringView(buffer.data() + position, end - position));
+			it.skip(FiltersT::Space);
+
+			const CharType* begin = &it;
+			position = end;
+
+			complete = begin != buffer.data() + end;
+
+			if (complete) {
+
+				if (pathOffsets.empty())
+					throw XmlParseError("Text data outside of the root element");
+
+				value.begin(begin);
+				value.end(buffer.data() + end);
+
+			}
+
+			return true;
+
+		}
+
+		XML_TEMPLATE_INLINE ReaderEvent readAttribute() {
+
+			CharIteratorT it(StringView(buffer.data() + position, tagClose - position));
+
+			if (!it.skip(FiltersT::Space)) {
+
+				// All attributes have been read
+				position = tagNext;
+				state = selfClosing ? State::SelfClose : State::Content;
+
+				return next();
+
+			}
+
+			name.begin(&it);
+
+			if (!it.skip(FiltersT::AttributeName)) {
+				throw XmlParseError("Expected '=' character in attribute definition");
+			}
+
+			name.end(&it);
+
+			if (name.empty()) {
+				throw XmlParseError("Expected attribute name");
+			}
+
+			it.skip(FiltersT::Space);
+
+			if (!it.cmp(CharType('='))) {
+				throw XmlParseError("Expected '=' character in attribute definition");
+			}
+
+			++it;
+			it.skip(FiltersT::Space);
+
+			if (!it.cmp(FiltersT::Quote)) {
+				throw XmlParseError("Expected a single quote or double quote character");
+			}
+
+			CharType quoteCh = *it++;
+
+			value.begin(&it);
+
+			if (!it.skip(quoteCh)) {
+				throw XmlParseError("Text data interrupted");
+			}
+
+			value.end(&it++);
+
+			position = &it - buffer.data();
+
+			return ReaderEvent::Attribute;
+
+		}
+
+		XML_TEMPLATE_INLINE void readEndTag(SizeT end) {
+
+			readTagName(position + 2, end);
+
+			CharIteratorT it(StringView(buffer.data() + position, end - position));
+
+			if (it.skip(FiltersT::Space)) {
+				throw XmlParseError("Expected closing bracket");
+			}
+
+			if (pathOffsets.empty() || name != getElementName().toStringView()) {
+				throw XmlParseError("Invalid closing element name");
+			}
+
+			position = end + 1;
+
+			// The name stays valid until the next event
+			name = getElementName();
+			popPending = true;
+
+		}
+
+		// Reads the name starting at begin and leaves the position behind it
+		XML_TEMPLATE_INLINE void readTagName(SizeT begin, SizeT end) {
+
+			CharIteratorT it(StringView(buffer.data() + begin, end - begin));
+
+			name.begin(&it);
+			it.skip(FiltersT::Name);
+			name.end(&it);
+
+			if (name.empty()) {
+				throw XmlParseError("Expected element name");
+			}
+
+			position = &it - buffer.data();
+
+		}
+
+		XML_TEMPLATE_INLINE void setValue(SizeT begin, SizeT end) {
+
+			value.begin(buffer.data() + begin);
+			value.end(buffer.data() + end);
+
+		}
+
+		// Determines the kind of markup at the current position
+		XML_TEMPLATE_INLINE Token classifyToken() const {
+
+			constexpr CharType commentOpen[] = { '<', '!', '-', '-' };
+			constexpr CharType cdataOpen[] = { '<', '!', '[', 'C', 'D', 'A', 'T', 'A', '[' };
+
+			SizeT available = buffer.size() - position;
+
+			if (available < 2)
+				return incompleteToken();
+
+			switch (buffer[position + 1]) {
+
+			case CharType('/'):
+				return Token::EndTag;
+
+			case CharType('?'):
+				return Token::ProcessingInstruction;
+
+			case CharType('!'):
+
+				for (const auto& sequence : { StringView(commentOpen, 4), StringView(cdataOpen, 9) }) {
+
+					SizeT count = available < sequence.size() ? available : sequence.size();
+
+					if (StringView(buffer).substr(position, count) == sequence.substr(0, count)) {
+
+						if (count < sequence.size())
+							return incompleteToken();
+
+						return sequence.size() == 4 ? Token::Comment : Token::CData;
+
+					}
+
+				}
+
+				return Token::Declaration;
+
+			default:
+				return Token::StartTag;
+
+			}
+
+		}
+
+		XML_TEMPLATE_INLINE Token incompleteToken() const {
+
+			if (finished)
+				throw XmlParseError("Unexpected end of data");
+
+			return Token::Incomplete;
+
+		}
+
+		/*
+			Finds the index of the token's closing '>'.
+			Scanning resumes where it stopped last time, so long tokens arriving in many chunks are only scanned once.
+		*/
+		XML_TEMPLATE_INLINE bool findTokenEnd(Token token, SizeT& end) {
+
+			const CharType* data = buffer.data();
+			SizeT size = buffer.size();
+
+			auto findSequence = [&](SizeT skip, const StringView& sequence) {
+
+				SizeT begin = position + (scanOffset > skip ? scanOffset : skip);
+				end = buffer.find(sequence, begin);
+
+				if (end == buffer.npos) {
+
+					// The sequence may start within the last few characters
+					SizeT rescan = size - position;
+					scanOffset = rescan > sequence.size() ? rescan - sequence.size() + 1 : 0;
+
+					return false;
+
+				}
+
+				end += sequence.size() - 1;
+
+				return true;
+
+			};
+
+			bool found = false;
+
+			switch (token) {
+
+			case Token::Comment:
+			{
+				constexpr CharType close[] = { '-', '-', '>' };
+				found = findSequence(4, StringView(close, 3));
+				break;
+			}
+
+			case Token::CData:
+			{
+				constexpr CharType close[] = { ']', ']', '>' };
+				found = findSequence(9, StringView(close, 3));
+				break;
+			}
+
+			case Token::ProcessingInstruction:
+			{
+				constexpr CharType close[] = { '?', '>' };
+				found = findSequence(2, StringView(close, 2));
+				break;
+			}
+
+			default:
+			{
+				// Tags end at the first '>' outside of quotes, declarations may contain a bracketed internal subset
+				SizeT i = position + (scanOffset ? scanOffset : 1);
+
+				for (; i < size; i++) {
+
+					CharType c = data[i];
+
+					if (scanQuote) {
+
+						if (c == scanQuote)
+							scanQuote = 0;
+
+					} else if (c == CharType('"') || c == CharType('\'')) {
+
+						scanQuote = c;
+
+					} else if (token == Token::Declaration && c == CharType('[')) {
+
+						scanBrackets++;
+
+					} else if (token == Token::Declaration && c == CharType(']') && scanBrackets) {
+
+						scanBrackets--;
+
+					} else if (c == CharType('>') && !scanBrackets) {
+
+						found = true;
+						break;
+
+					} else if (c == CharType('<') && token != Token::Declaration) {
+
+						throw XmlParseError("Unexpected opening bracket in tag");
+
+					}
+
+				}
+
+				end = i;
+				scanOffset = i - position;
+
+				break;
+			}
+
+			}
+
+			if (!found) {
+
+				if (finished)
+					throw XmlParseError("Unexpected end of data");
+
+				return false;
+
+			}
+
+			scanOffset = 0;
+			scanQuote = 0;
+			scanBrackets = 0;
+
+			return true;
+
+		}
+
+		// Consumes input up to and including the end tag of the skipped element, returns false if more input is required
+		XML_TEMPLATE_INLINE bool skipContent() {
+
+			while (true) {
+
+				SizeT begin = buffer.find(CharType('<'), position);
+
+				if (begin == buffer.npos) {
+
+					position = buffer.size();
+
+					if (finished)
+						throw XmlParseError("Unexpected end of data");
+
+					return false;
+
+				}
+
+				position = begin;
+
+				Token token = classifyToken();
+				SizeT end;
+
+				if (token == Token::Incomplete || !findTokenEnd(token, end))
+					return false;
+
+				if (token == Token::EndTag) {
+
+					if (!skipLevel) {
+
+						readEndTag(end);
+
+						popElement();
+						skipping = false;
+
+						return true;
+
+					}
+
+					skipLevel--;
+
+				} else if (token == Token::StartTag && buffer[end - 1] != CharType('/')) {
+
+					skipLevel++;
+
+				}
+
+				position = end + 1;
+
+			}
+
+		}
+
+		XML_TEMPLATE_INLINE void pushElement(const StringView& element) {
+
+			if (!path.empty()) {
+				path += CharType('/');
+			}
+
+			pathOffsets.push_back(path.size());
+			path.append(element);
+
+		}
+
+		XML_TEMPLATE_INLINE void popElement() {
+
+			SizeT offset = pathOffsets.back();
+
+			path.resize(offset ? offset - 1 : 0);
+			pathOffsets.pop_back();
+
+			popPending = false;
+
+		}
+
+		XML_TEMPLATE_INLINE StringRefT getElementName() const {
+			return StringView(path).substr(pathOffsets.back());
+		}
+
+		String buffer;
+		SizeT position;
+		SizeT scanOffset;
+		CharType scanQuote;
+		u32 scanBrackets;
+		bool finished;
+		bool started;
+
+		State state;
+		SizeT tagClose;
+		SizeT tagNext;
+		bool selfClosing;
+
+		String path;
+		std::vector<SizeT> pathOffsets;
+		bool popPending;
+
+		ReaderEvent lastEvent;
+		bool skipping;
+		SizeT skipLevel;
+
+		StringRefT name;
+		StringRefT value;
+
+	};
+
+}
\ No newline at end of file
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "xmlc.hpp"
+#include "entity.hpp"
 
 
 namespace Xml
@@ -57,6 +58,20 @@ namespace Xml
 			return { string, length };
 		}
 
+		// Returns the string with all entity and character references replaced
+		constexpr String toDecodedString() const {
+
+			if (!hasEntities())
+				return toString();
+
+			return decodeEntities(toStringView());
+
+		}
+
+		constexpr bool hasEntities() const {
+			return Xml::hasEntities(toStringView());
+		}
+
 
 		constexpr void size(SizeT size) {
 			length = size;
@@ -130,6 +145,11 @@ namespace Xml
 		}
 
 
+		constexpr bool operator==(const StringRef& str) const {
+			return toStringView() == str.toStringView();
+		}
+
+
 		constexpr bool operator==(const StringView& str) const {
 
 			if (str.length() != length)
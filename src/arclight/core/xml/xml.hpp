@@ -12,3 +12,4 @@
 #include "attribute.hpp"
 #include "node.hpp"
 #include "document.hpp"
+#include "reader.hpp"
@@ -62,6 +62,9 @@ namespace Xml
 	template<CC::Char CharType>
 	class Document;
 
+	template<CC::Char CharType>
+	class Reader;
+
 #else
 
 	class CharIterator;
@@ -70,6 +73,7 @@ namespace Xml
 	class Attribute;
 	class Node;
 	class Document;
+	class Reader;
 
 #endif
 
@@ -36,7 +36,7 @@ Path Path::getApplicationDirectory() {
 				//If length exceeds 0x10000 bytes, cancel
 				if(length >= 0x10000) {
 
-					LogE("Path") << "Failed to query application directory path: Path name exceeds 0x10000 bytes");
+					LogE("Path") << "Failed to query application directory path: Path name exceeds 0x10000 bytes";
 					return Path();
 
 				}
@@ -0,0 +1,187 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 virtualmemory.cpp
+ */
+
+#include "memory/virtualmemory.hpp"
+#include "math/math.hpp"
+#include "util/assert.hpp"
+
+#include <fstream>
+#include <limits>
+#include <string>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+
+
+constexpr static int protectionToProtectionFlags(VirtualMemory::Protection protection) {
+
+	switch (protection) {
+
+		case VirtualMemory::Protection::NoAccess:           return PROT_NONE;
+		case VirtualMemory::Protection::Execute:            return PROT_EXEC;
+		case VirtualMemory::Protection::ReadOnly:           return PROT_READ;
+		case VirtualMemory::Protection::ReadWrite:          return PROT_READ | PROT_WRITE;
+		case VirtualMemory::Protection::ExecuteRead:        return PROT_EXEC | PROT_READ;
+		case VirtualMemory::Protection::ExecuteReadWrite:   return PROT_EXEC | PROT_READ | PROT_WRITE;
+
+	}
+
+	arc_force_assert("Bad protection setting");
+	return PROT_READ;
+
+}
+
+
+
+//Expands [start; start + size] to whole pages as the kernel calls require page-aligned ranges
+static void pageAlign(void*& start, SizeT& size) {
+
+	SizeT pageSize = VirtualMemory::getPageSize();
+	AddressT begin = Math::alignDown(reinterpret_cast<AddressT>(start), pageSize);
+	AddressT end = Math::alignUp(reinterpret_cast<AddressT>(start) + size, pageSize);
+
+	start = reinterpret_cast<void*>(begin);
+	size = end - begin;
+
+}
+
+
+
+SizeT VirtualMemory::getPageSize() {
+
+	static const SizeT pageSize = sysconf(_SC_PAGESIZE);
+	return pageSize;
+
+}
+
+
+
+SizeT VirtualMemory::getLargePageSize() {
+
+	static const SizeT largePageSize = []() -> SizeT {
+
+		//The default huge page size is only exposed through procfs
+		std::ifstream meminfo("/proc/meminfo");
+		std::string key;
+
+		while (meminfo >> key) {
+
+			if (key == "Hugepagesize:") {
+
+				SizeT size = 0;
+				meminfo >> size;
+
+				return size * 1024;
+
+			}
+
+			meminfo.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+
+		}
+
+		return 0;
+
+	}();
+
+	return largePageSize;
+
+}
+
+
+
+void* VirtualMemory::allocate(SizeT size, Protection protection) {
+
+	void* ptr = mmap(nullptr, size, protectionToProtectionFlags(protection), MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return ptr == MAP_FAILED ? nullptr : ptr;
+
+}
+
+
+
+void* VirtualMemory::allocateLarge(SizeT size, Protection protection) {
+
+#ifdef MAP_HUGETLB
+
+	SizeT largePageSize = getLargePageSize();
+
+	if (!largePageSize) {
+		return nullptr;
+	}
+
+	void* ptr = mmap(nullptr, Math::alignUp(size, largePageSize), protectionToProtectionFlags(protection), MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	return ptr == MAP_FAILED ? nullptr : ptr;
+
+#else
+
+	return nullptr;
+
+#endif
+
+}
+
+
+
+bool VirtualMemory::deallocate(void* ptr, SizeT size) {
+	return munmap(ptr, size) == 0;
+}
+
+
+
+bool VirtualMemory::protect(void* start, SizeT size, Protection protection) {
+
+	pageAlign(start, size);
+	return mprotect(start, size, protectionToProtectionFlags(protection)) == 0;
+
+}
+
+
+
+void* VirtualMemory::reserve(SizeT size) {
+
+	void* ptr = mmap(nullptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	return ptr == MAP_FAILED ? nullptr : ptr;
+
+}
+
+
+
+bool VirtualMemory::commit(void* start, SizeT size, Protection protection) {
+
+	//Anonymous pages are backed lazily on first access, enabling access is sufficient
+	return protect(start, size, protection);
+
+}
+
+
+
+bool VirtualMemory::decommit(void* start, SizeT size) {
+
+	pageAlign(start, size);
+
+	//Drop the pages first so the range reads as zero after the next commit
+	return madvise(start, size, MADV_DONTNEED) == 0 && mprotect(start, size, PROT_NONE) == 0;
+
+}
+
+
+
+bool VirtualMemory::adviseHugePages(void* start, SizeT size) {
+
+#ifdef MADV_HUGEPAGE
+
+	pageAlign(start, size);
+	return madvise(start, size, MADV_HUGEPAGE) == 0;
+
+#else
+
+	return false;
+
+#endif
+
+}
\ No newline at end of file
@@ -7,6 +7,7 @@
  */
 
 #include "memory/virtualmemory.hpp"
+#include "math/math.hpp"
 #include "util/assert.hpp"
 
 #include <Windows.h>
@@ -17,6 +18,7 @@ constexpr static DWORD protectionToProtectionFlags(VirtualMemory::Protection pro
 
 	switch (protection) {
 
+		case VirtualMemory::Protection::NoAccess:           return PAGE_NOACCESS;
 		case VirtualMemory::Protection::Execute:            return PAGE_EXECUTE;
 		case VirtualMemory::Protection::ReadOnly:           return PAGE_READONLY;
 		case VirtualMemory::Protection::ReadWrite:          return PAGE_READWRITE;
@@ -31,13 +33,54 @@ constexpr static DWORD protectionToProtectionFlags(VirtualMemory::Protection pro
 }
 
 
+SizeT VirtualMemory::getPageSize() {
+
+	static const SizeT pageSize = []() -> SizeT {
+
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+
+		return info.dwPageSize;
+
+	}();
+
+	return pageSize;
+
+}
+
+
+
+SizeT VirtualMemory::getLargePageSize() {
+
+	static const SizeT largePageSize = GetLargePageMinimum();
+	return largePageSize;
+
+}
+
+
+
 void* VirtualMemory::allocate(SizeT size, Protection protection) {
 	return VirtualAlloc(nullptr, size, MEM_COMMIT, protectionToProtectionFlags(protection));
 }
 
 
 
-bool VirtualMemory::deallocate(void* ptr) {
+void* VirtualMemory::allocateLarge(SizeT size, Protection protection) {
+
+	SizeT largePageSize = getLargePageSize();
+
+	if (!largePageSize) {
+		return nullptr;
+	}
+
+	//Fails unless the process holds SeLockMemoryPrivilege
+	return VirtualAlloc(nullptr, Math::alignUp(size, largePageSize), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, protectionToProtectionFlags(protection));
+
+}
+
+
+
+bool VirtualMemory::deallocate(void* ptr, [[maybe_unused]] SizeT size) {
 	return VirtualFree(ptr, 0, MEM_RELEASE);
 }
 
@@ -48,4 +91,31 @@ bool VirtualMemory::protect(void* start, SizeT size, Protection protection) {
 	DWORD oldProtection;
 	return VirtualProtect(start, size, protectionToProtectionFlags(protection), &oldProtection);
 
+}
+
+
+
+void* VirtualMemory::reserve(SizeT size) {
+	return VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+
+
+bool VirtualMemory::commit(void* start, SizeT size, Protection protection) {
+	return VirtualAlloc(start, size, MEM_COMMIT, protectionToProtectionFlags(protection));
+}
+
+
+
+bool VirtualMemory::decommit(void* start, SizeT size) {
+	return VirtualFree(start, size, MEM_DECOMMIT);
+}
+
+
+
+bool VirtualMemory::adviseHugePages([[maybe_unused]] void* start, [[maybe_unused]] SizeT size) {
+
+	//Windows has no transparent huge pages
+	return false;
+
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 threadpool.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "concurrent/threadpool.hpp"
+#include "concurrent/thread.hpp"
+
+#include <atomic>
+#include <vector>
+
+
+
+//Compares the pool against spawning one Thread per task, the approach it replaced
+int main() {
+
+	constexpr u32 TaskCount = 1000;
+
+	ThreadPool pool;
+	std::atomic<u32> counter = 0;
+
+	double pooled = Benchmark::measure(20, [&]() {
+
+		std::vector<TaskHandle> tasks;
+		tasks.reserve(TaskCount);
+
+		for (u32 i = 0; i < TaskCount; i++) {
+			tasks.push_back(pool.submit([&counter]() { counter++; }));
+		}
+
+		pool.wait(tasks);
+
+	});
+
+	double spawned = Benchmark::measure(20, [&]() {
+
+		std::vector<Thread> threads(TaskCount);
+
+		for (Thread& thread : threads) {
+			thread.start([&counter]() { counter++; });
+		}
+
+		for (Thread& thread : threads) {
+			thread.finish();
+		}
+
+	});
+
+	double parallelFor = Benchmark::measure(20, [&]() {
+		pool.parallelFor(0, TaskCount, [&counter](SizeT) { counter++; }, 1);
+	});
+
+	std::printf("%u tasks on %u workers\n", TaskCount, pool.getWorkerCount());
+	Benchmark::report("ThreadPool::submit + wait", pooled);
+	Benchmark::report("ThreadPool::parallelFor (grain 1)", parallelFor);
+	Benchmark::report("Thread per task", spawned);
+
+	return 0;
+
+}
\ No newline at end of file
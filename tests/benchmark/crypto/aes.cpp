@@ -0,0 +1,62 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 aes.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "crypto/encryption/aes.hpp"
+#include "crypto/encryption/des.hpp"
+#include "concurrent/threadpool.hpp"
+#include "concurrent/thread.hpp"
+#include "math/math.hpp"
+
+#include <vector>
+
+
+
+/*
+	Runs on AES-NI and PCLMULQDQ if available. Run with ARC_CPUID_DISABLE=1 to measure the portable bitsliced cipher.
+	Scalar DES, which AES is meant to replace for asset packs, is measured on a smaller buffer as a baseline.
+*/
+int main() {
+
+	constexpr SizeT Size = SizeT(64) << 20;
+	constexpr SizeT DESSize = SizeT(4) << 20;
+
+	std::vector<u8> data(Size);
+	u32 state = 1;
+
+	for (u8& b : data) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	ThreadPool pool(Math::max(Thread::getHardwareThreadCount(), 1u));
+
+	AES::Cipher cipher(Key<128>(0x0706050403020100ull, 0x0F0E0D0C0B0A0908ull));
+	AES::Block counter = {};
+	AES::Nonce nonce = {};
+
+	std::printf("64 MiB, AES-128, %u hardware threads\n", Thread::getHardwareThreadCount());
+
+	Benchmark::report("AES ECB encrypt", Benchmark::measure(3, [&]() { Benchmark::consume(AES::encrypt(data, cipher)[0]); }), Size);
+	Benchmark::report("AES ECB decrypt", Benchmark::measure(3, [&]() { Benchmark::consume(AES::decrypt(data, cipher)[0]); }), Size);
+	Benchmark::report("AES CTR", Benchmark::measure(3, [&]() { Benchmark::consume(AES::encryptCTR(data, cipher, counter)[0]); }), Size);
+	Benchmark::report("AES CTR, thread pool", Benchmark::measure(3, [&]() { Benchmark::consume(AES::encryptCTR(data, cipher, counter, &pool)[0]); }), Size);
+	Benchmark::report("AES GCM encrypt", Benchmark::measure(3, [&]() { Benchmark::consume(AES::encryptGCM(data, cipher, nonce)[0]); }), Size);
+	Benchmark::report("AES GCM encrypt, thread pool", Benchmark::measure(3, [&]() { Benchmark::consume(AES::encryptGCM(data, cipher, nonce, {}, &pool)[0]); }), Size);
+
+	std::vector<u8> sealed = AES::encryptGCM(data, cipher, nonce);
+	Benchmark::report("AES GCM decrypt", Benchmark::measure(3, [&]() { Benchmark::consume(AES::decryptGCM(sealed, cipher, nonce)->at(0)); }), Size);
+
+	std::span<const u8> desData(data.data(), DESSize);
+	Benchmark::report("DES::encrypt, 4 MiB", Benchmark::measure(3, [&]() { Benchmark::consume(DES::encrypt(desData, Key<64>(0x0123456789ABCDEFull))[0]); }), DESSize);
+
+	return 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 des.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "crypto/encryption/des.hpp"
+#include "concurrent/threadpool.hpp"
+#include "concurrent/thread.hpp"
+#include "math/math.hpp"
+
+#include <vector>
+
+
+
+//Compares the bit by bit reference implementation against the table driven bulk cipher
+int main() {
+
+	constexpr SizeT Size = SizeT(16) << 20;
+	constexpr SizeT ReferenceSize = SizeT(2) << 20;
+
+	std::vector<u8> data(Size);
+	u32 state = 1;
+
+	for (u8& b : data) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	const Key<64> key1(0x0123456789ABCDEFull);
+	const Key<64> key2(0x23456789ABCDEF01ull);
+	const Key<64> key3(0x456789ABCDEF0123ull);
+
+	ThreadPool pool(Math::max(Thread::getHardwareThreadCount(), 1u));
+
+	DES::Cipher des(key1);
+	TripleDES::Cipher ede3(key1, key2, key3);
+
+	std::span<const u8> referenceData(data.data(), ReferenceSize);
+
+	std::printf("%u hardware threads\n", Thread::getHardwareThreadCount());
+
+	Benchmark::report("DES reference, 2 MiB", Benchmark::measure(1, [&]() { Benchmark::consume(DES::encrypt(referenceData, key1)[0]); }), ReferenceSize);
+	Benchmark::report("TripleDES reference, 2 MiB", Benchmark::measure(1, [&]() { Benchmark::consume(TripleDES::encrypt(referenceData, key1, key2, key3)[0]); }), ReferenceSize);
+
+	Benchmark::report("DES bulk, 16 MiB", Benchmark::measure(3, [&]() { Benchmark::consume(DES::encrypt(data, des)[0]); }), Size);
+	Benchmark::report("TripleDES bulk, 16 MiB", Benchmark::measure(3, [&]() { Benchmark::consume(TripleDES::encrypt(data, ede3)[0]); }), Size);
+	Benchmark::report("TripleDES bulk decrypt, 16 MiB", Benchmark::measure(3, [&]() { Benchmark::consume(TripleDES::decrypt(data, ede3)[0]); }), Size);
+	Benchmark::report("TripleDES bulk, thread pool, 16 MiB", Benchmark::measure(3, [&]() { Benchmark::consume(TripleDES::encrypt(data, ede3, &pool)[0]); }), Size);
+	Benchmark::report("TripleDES CTR, 16 MiB", Benchmark::measure(3, [&]() { Benchmark::consume(TripleDES::encryptCTR(data, ede3, 0)[0]); }), Size);
+
+	return 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 sha2.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "crypto/hash/sha1.hpp"
+#include "crypto/hash/sha2.hpp"
+
+#include <vector>
+
+
+
+static void reportGBs(const char* name, double microseconds, SizeT bytes) {
+	std::printf("%-40s %12.2f us %10.2f GB/s\n", name, microseconds, bytes / microseconds / 1000.0);
+}
+
+
+
+/*
+	Runs on SHA-NI if available. Run with ARC_CPUID_DISABLE=SHA to measure the AVX2 multi-buffer path
+	and with ARC_CPUID_DISABLE=1 to measure the portable block functions.
+*/
+int main() {
+
+	constexpr SizeT LargeSize = SizeT(64) << 20;
+	constexpr SizeT SmallSize = 4096;
+	constexpr SizeT SmallCount = 16384;
+
+	std::vector<u8> data(LargeSize);
+	u32 state = 1;
+
+	for (u8& b : data) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	reportGBs("SHA-1 64 MiB", Benchmark::measure(3, [&]() { Benchmark::consume(SHA1::hash(data)); }), LargeSize);
+	reportGBs("SHA-256 64 MiB", Benchmark::measure(3, [&]() { Benchmark::consume(SHA2::hash256(data)); }), LargeSize);
+	reportGBs("SHA-512 64 MiB", Benchmark::measure(3, [&]() { Benchmark::consume(SHA2::hash512(data)); }), LargeSize);
+
+	//The 4 KiB blobs are consecutive slices of the large buffer
+	std::vector<std::span<const u8>> messages;
+	std::vector<Hash<256>> hashes(SmallCount);
+
+	for (SizeT i = 0; i < SmallCount; i++) {
+		messages.emplace_back(data.data() + i * SmallSize, SmallSize);
+	}
+
+	reportGBs("SHA-256 16384 x 4 KiB, one by one", Benchmark::measure(3, [&]() {
+
+		for (SizeT i = 0; i < SmallCount; i++) {
+			hashes[i] = SHA2::hash256(messages[i]);
+		}
+
+		Benchmark::consume(hashes[0]);
+
+	}), SmallCount * SmallSize);
+
+	reportGBs("SHA-256 16384 x 4 KiB, hash256Batch", Benchmark::measure(3, [&]() {
+
+		SHA2::hash256Batch(messages, hashes);
+		Benchmark::consume(hashes[0]);
+
+	}), SmallCount * SmallSize);
+
+	return 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,69 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 treehash.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "crypto/hash/sha2.hpp"
+#include "crypto/hash/treehash.hpp"
+#include "concurrent/threadpool.hpp"
+#include "concurrent/thread.hpp"
+#include "math/math.hpp"
+
+#include <vector>
+
+
+
+//Compares sequential SHA-256 against tree hashing on one thread, on all hardware threads and against rehashing a single modified leaf
+int main() {
+
+	constexpr SizeT Size = SizeT(256) << 20;
+
+	std::vector<u8> data(Size);
+	u32 state = 1;
+
+	for (u8& b : data) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	ThreadPool pool(Math::max(Thread::getHardwareThreadCount(), 1u));
+
+	TreeHash tree;
+	tree.build(data, &pool);
+
+	TreeHash smallLeaves(4096);
+	smallLeaves.build(data, &pool);
+
+	std::printf("256 MiB, %u hardware threads\n", Thread::getHardwareThreadCount());
+
+	Benchmark::report("SHA2::hash256", Benchmark::measure(3, [&]() { Benchmark::consume(SHA2::hash256(data)); }), Size);
+	Benchmark::report("TreeHash::hash, single thread", Benchmark::measure(3, [&]() { Benchmark::consume(TreeHash::hash(data)); }), Size);
+	Benchmark::report("TreeHash::hash, thread pool", Benchmark::measure(3, [&]() { Benchmark::consume(TreeHash::hash(data, TreeHash::DefaultLeafSize, &pool)); }), Size);
+
+	Benchmark::report("TreeHash::hash, 4 KiB leaves, thread pool", Benchmark::measure(3, [&]() { Benchmark::consume(TreeHash::hash(data, 4096, &pool)); }), Size);
+
+	Benchmark::report("TreeHash::update, one modified byte", Benchmark::measure(20, [&]() {
+
+		data[Size / 2]++;
+		tree.update(data, Size / 2, 1);
+		Benchmark::consume(tree.getRoot());
+
+	}));
+
+	Benchmark::report("TreeHash::update, 4 KiB leaves", Benchmark::measure(20, [&]() {
+
+		data[Size / 2]++;
+		smallLeaves.update(data, Size / 2, 1);
+		Benchmark::consume(smallLeaves.getRoot());
+
+	}));
+
+	return 0;
+
+}
\ No newline at end of file
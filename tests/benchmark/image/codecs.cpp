@@ -0,0 +1,138 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 codecs.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "image/image.hpp"
+#include "image/decode/pngdecoder.hpp"
+#include "image/decode/qoidecoder.hpp"
+#include "image/decode/inflate.hpp"
+#include "image/encode/pngencoder.hpp"
+#include "image/encode/qoiencoder.hpp"
+#include "image/encode/deflate.hpp"
+#include "image/encode/jpegencoder.hpp"
+
+#include <vector>
+
+
+
+constexpr u32 Width = 1920;
+constexpr u32 Height = 1080;
+constexpr SizeT PixelBytes = SizeT(Width) * Height * 3;
+
+
+//Smooth gradients with a few bits of noise, compresses roughly like a photo
+static RawImage createImage() {
+
+	std::vector<u8> pixels(PixelBytes);
+	u32 state = 1;
+
+	for (u32 y = 0; y < Height; y++) {
+
+		for (u32 x = 0; x < Width; x++) {
+
+			state = state * 1103515245 + 12345;
+			u32 noise = (state >> 16) & 0x07;
+
+			u8* p = &pixels[(SizeT(y) * Width + x) * 3];
+			p[0] = (x * 255 / Width + noise) & 0xFF;
+			p[1] = (y * 255 / Height + noise) & 0xFF;
+			p[2] = ((x + y) / 12 + noise) & 0xFF;
+
+		}
+
+	}
+
+	return Image<Pixel::RGB8>(Width, Height, pixels).makeRaw();
+
+}
+
+
+
+template<class Encoder>
+static std::vector<u8> encode(const RawImage& image) {
+
+	Encoder encoder(Pixel::RGB8);
+	encoder.encode(image);
+
+	return encoder.getBuffer();
+
+}
+
+
+
+template<class Decoder>
+static void benchmarkDecoder(const char* name, const std::vector<u8>& data) {
+
+	double time = Benchmark::measure(10, [&]() {
+
+		Decoder decoder(Pixel::RGB8);
+		decoder.decode(data);
+
+	});
+
+	Benchmark::report(name, time, PixelBytes);
+
+}
+
+
+
+template<class Encoder, class... Args>
+static void benchmarkEncoder(const char* name, const RawImage& image, Args... args) {
+
+	SizeT size = 0;
+
+	double time = Benchmark::measure(5, [&]() {
+
+		Encoder encoder(Pixel::RGB8, args...);
+		encoder.encode(image);
+
+		size = encoder.getBuffer().size();
+
+	});
+
+	Benchmark::report(name, time, PixelBytes);
+	std::printf("%-40s %12.2f %%\n", "    Size relative to raw pixels", size * 100.0 / PixelBytes);
+
+}
+
+
+
+//Throughput is given in raw pixel bytes per second
+int main() {
+
+	RawImage image = createImage();
+
+	std::vector<u8> png = encode<PNGEncoder>(image);
+	std::vector<u8> qoi = encode<QOIEncoder>(image);
+
+	std::printf("1920x1080 RGB8, PNG %zu bytes, QOI %zu bytes\n", png.size(), qoi.size());
+
+	benchmarkDecoder<PNGDecoder>("PNG decode", png);
+	benchmarkDecoder<QOIDecoder>("QOI decode", qoi);
+
+	std::vector<u8> compressed;
+	std::vector<u8> inflated(PixelBytes);
+
+	Deflater().deflate(image.getRawBuffer(), compressed);
+	Inflater inflater;
+
+	double inflate = Benchmark::measure(10, [&]() {
+		inflater.inflate(compressed, inflated);
+	});
+
+	Benchmark::report("Inflate of the unfiltered pixels", inflate, PixelBytes);
+
+	benchmarkEncoder<PNGEncoder>("PNG encode, fast", image, Deflater::Level::Fast);
+	benchmarkEncoder<PNGEncoder>("PNG encode, default", image, Deflater::Level::Default);
+	benchmarkEncoder<PNGEncoder>("PNG encode, best", image, Deflater::Level::Best);
+	benchmarkEncoder<QOIEncoder>("QOI encode", image);
+	benchmarkEncoder<JPEGEncoder>("JPEG encode, quality 90", image, 90u);
+
+	return 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 conversion.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "image/image.hpp"
+#include "concurrent/threadpool.hpp"
+#include "concurrent/thread.hpp"
+#include "math/math.hpp"
+
+#include <string>
+
+
+
+//The original Image::convert, converting every pixel through getPixel/setPixel
+template<Pixel Q, Pixel P>
+static Image<Q> convertPerPixel(const Image<P>& source) {
+
+	Image<Q> image(source.getWidth(), source.getHeight());
+
+	for (u32 y = 0; y < source.getHeight(); y++) {
+
+		for (u32 x = 0; x < source.getWidth(); x++) {
+			image.setPixel(x, y, PixelConverter::convert<Q>(source.getPixel(x, y)));
+		}
+
+	}
+
+	return image;
+
+}
+
+
+
+template<Pixel P>
+static Image<P> createImage(u32 width, u32 height) {
+
+	std::vector<u8> bytes(SizeT(width) * height * PixelFormat<P>::BytesPerPixel);
+	u32 state = 5;
+
+	for (u8& b : bytes) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	return Image<P>(width, height, bytes);
+
+}
+
+
+
+template<Pixel From, Pixel To>
+static void run(const char* name, u32 width, u32 height, ThreadPool& pool) {
+
+	const Image<From> source = createImage<From>(width, height);
+	SizeT bytes = source.pixelCount() * PixelFormat<From>::BytesPerPixel;
+
+	std::string label = std::string(name).append(" ").append(std::to_string(width)).append("x").append(std::to_string(height));
+	std::string perPixel = label + ", per pixel";
+	std::string bulk = label + ", bulk";
+	std::string threaded = label + ", bulk threaded";
+
+	Benchmark::report(perPixel.c_str(), Benchmark::measure(10, [&]() { Benchmark::consume(convertPerPixel<To>(source).getImageData()[0]); }), bytes);
+	Benchmark::report(bulk.c_str(), Benchmark::measure(10, [&]() { Benchmark::consume(source.template convert<To>().getImageData()[0]); }), bytes);
+	Benchmark::report(threaded.c_str(), Benchmark::measure(10, [&]() { Benchmark::consume(source.template convert<To>(&pool).getImageData()[0]); }), bytes);
+
+	if constexpr (PixelConversion::isInPlace(From, To)) {
+
+		Image<From> image = source;
+		std::string inPlace = label + ", in place";
+
+		Benchmark::report(inPlace.c_str(), Benchmark::measure(10, [&]() {
+
+			PixelConversion::convert(From, To, image.getImageData(), image.getImageData(), image.pixelCount());
+			Benchmark::consume(image.getImageData()[0]);
+
+		}), bytes);
+
+	}
+
+}
+
+
+
+//Runs with ARC_CPUID_DISABLE set measure the scalar bulk kernels
+int main() {
+
+	ThreadPool pool(Math::max(Thread::getHardwareThreadCount(), 1u));
+
+	std::printf("%u hardware threads\n", Thread::getHardwareThreadCount());
+
+	for (auto [width, height] : {std::pair<u32, u32>(1920, 1080), std::pair<u32, u32>(3840, 2160)}) {
+
+		run<Pixel::RGB8, Pixel::RGBA8>("RGB8 -> RGBA8", width, height, pool);
+		run<Pixel::BGRA8, Pixel::RGBA8>("BGRA8 -> RGBA8", width, height, pool);
+		run<Pixel::RGBA8, Pixel::BGR8>("RGBA8 -> BGR8", width, height, pool);
+		run<Pixel::RGB5, Pixel::RGBA8>("RGB5 -> RGBA8", width, height, pool);
+		run<Pixel::RGBA8, Pixel::Grayscale8>("RGBA8 -> Grayscale8", width, height, pool);
+
+	}
+
+	return 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 convolution.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "image/filter/convolution.hpp"
+#include "concurrent/threadpool.hpp"
+#include "concurrent/thread.hpp"
+
+#include <cmath>
+#include <string>
+
+
+
+/*
+	The 3x3 filter that ConvolutionFilter replaced: per pixel double precision accumulation over a bordered copy.
+	Edges are handled by clamping, which matches the padded buffer of the original.
+*/
+static void originalFilter(Image<Pixel::RGBA8>& image, const Mat3<double>& matrix) {
+
+	u32 width = image.getWidth();
+	u32 height = image.getHeight();
+
+	Image<Pixel::RGBA8> buffer(width + 2, height + 2);
+
+	for (u32 y = 0; y < height + 2; y++) {
+
+		for (u32 x = 0; x < width + 2; x++) {
+			buffer.setPixel(x, y, image.getPixel(Math::clamp(x, 1u, width) - 1, Math::clamp(y, 1u, height) - 1));
+		}
+
+	}
+
+	for (u32 y = 0; y < height; y++) {
+
+		for (u32 x = 0; x < width; x++) {
+
+			double r = 0, g = 0, b = 0, checked = 0;
+
+			for (u32 offY = 0; offY < 3; offY++) {
+
+				for (u32 offX = 0; offX < 3; offX++) {
+
+					const PixelRGBA8& p = buffer.getPixel(x + offX, y + offY);
+					double weight = matrix[offX][offY];
+
+					r += weight * p.getRed();
+					g += weight * p.getGreen();
+					b += weight * p.getBlue();
+					checked += std::abs(weight);
+
+				}
+
+			}
+
+			image.getPixel(x, y).setRGBA(std::abs(r / checked) + 0.5, std::abs(g / checked) + 0.5, std::abs(b / checked) + 0.5, image.getPixel(x, y).getAlpha());
+
+		}
+
+	}
+
+}
+
+
+
+//Runs with ARC_CPUID_DISABLE set measure the scalar kernels
+int main() {
+
+	constexpr u32 Width = 3840;
+	constexpr u32 Height = 2160;
+	constexpr SizeT Bytes = SizeT(Width) * Height * 4;
+
+	Image<Pixel::RGBA8> image(Width, Height);
+
+	for (u32 y = 0; y < Height; y++) {
+
+		for (u32 x = 0; x < Width; x++) {
+			image.setPixel(x, y, PixelRGBA8(x, y, x ^ y, 255));
+		}
+
+	}
+
+	Mat3<double> blur(1, 2, 1, 2, 4, 2, 1, 2, 1);
+	Mat3<double> sharpen(0, -1, 0, -1, 5, -1, 0, -1, 0);
+	u32 channels = ConvolutionFilter::Red | ConvolutionFilter::Green | ConvolutionFilter::Blue;
+
+	std::printf("3840x2160 RGBA8, RGB channels\n");
+
+	Benchmark::report("Original 3x3 blur", Benchmark::measure(1, [&]() { originalFilter(image, blur); }), Bytes);
+	Benchmark::report("3x3 blur (separable)", Benchmark::measure(5, [&]() { ConvolutionFilter::run(image, blur, channels, ConvolutionFilter::Clamp); }), Bytes);
+	Benchmark::report("3x3 sharpen (general)", Benchmark::measure(5, [&]() { ConvolutionFilter::run(image, sharpen, channels, ConvolutionFilter::Clamp); }), Bytes);
+
+	ConvolutionKernel gaussian = ConvolutionKernel::gaussian(3.0);
+	ConvolutionKernel box = ConvolutionKernel::box(81, 81);
+
+	Benchmark::report("Gaussian sigma 3 (19x19)", Benchmark::measure(3, [&]() { ConvolutionFilter::run(image, gaussian, channels, ConvolutionFilter::Clamp); }), Bytes);
+	Benchmark::report("81x81 box (float path)", Benchmark::measure(1, [&]() { ConvolutionFilter::run(image, box, channels, ConvolutionFilter::Clamp); }), Bytes);
+
+	u32 hardwareThreads = Math::max(Thread::getHardwareThreadCount(), 1u);
+
+	for (u32 threads = 2; threads <= hardwareThreads; threads *= 2) {
+
+		ThreadPool pool(threads);
+		std::string name = "Gaussian sigma 3, " + std::to_string(threads) + " workers";
+
+		Benchmark::report(name.c_str(), Benchmark::measure(3, [&]() { ConvolutionFilter::run(image, gaussian, channels, ConvolutionFilter::Clamp, &pool); }), Bytes);
+
+	}
+
+	return 0;
+
+}
\ No newline at end of file
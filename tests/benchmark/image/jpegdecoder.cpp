@@ -0,0 +1,91 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 jpegdecoder.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "framework/test.hpp"
+#include "image/decode/jpegdecoder.hpp"
+#include "concurrent/threadpool.hpp"
+#include "concurrent/thread.hpp"
+#include "util/cpuid.hpp"
+#include "image/image.hpp"
+
+#include <string>
+
+
+
+/*
+	Decodes a 1920x1080 4:2:0 JPEG with a restart marker every 16 MCUs.
+	Run with ARC_CPUID_DISABLE set to measure the fallback kernels.
+*/
+int main() {
+
+	std::vector<u8> data = Test::readData("image/large.jpg");
+	SizeT outputSize = 1920 * 1080 * 3;
+
+	const char* kernels = CPUID::hasFeature(CPUFeature::AVX512F) ? "AVX-512" : CPUID::hasFeature(CPUFeature::AVX2) ? "AVX2" : "Fallback";
+	std::printf("Kernels: %s\n", kernels);
+
+	double serial = Benchmark::measure(10, [&]() {
+
+		JPEGDecoder decoder(Pixel::RGB8);
+		decoder.decode(data);
+
+	});
+
+	Benchmark::report("Serial", serial, outputSize);
+
+	u32 hardwareThreads = Math::max(Thread::getHardwareThreadCount(), 1u);
+
+	for (u32 threads = 1; threads <= hardwareThreads; threads *= 2) {
+
+		ThreadPool pool(threads);
+
+		double parallel = Benchmark::measure(10, [&]() {
+
+			JPEGDecoder decoder(Pixel::RGB8, &pool);
+			decoder.decode(data);
+
+		});
+
+		std::string name = "Restart-parallel, " + std::to_string(threads) + " workers";
+		Benchmark::report(name.c_str(), parallel, outputSize);
+
+	}
+
+	//Thumbnails: DCT-domain downscaling against a full decode followed by an area resize
+	for (u32 denominator : {2u, 4u, 8u}) {
+
+		double scaled = Benchmark::measure(10, [&]() {
+
+			JPEGDecoder decoder(Pixel::RGB8);
+			decoder.setScale(denominator);
+			decoder.decode(data);
+
+		});
+
+		double resized = Benchmark::measure(10, [&]() {
+
+			JPEGDecoder decoder(Pixel::RGB8);
+			decoder.decode(data);
+
+			Image<Pixel::RGB8> image = Image<Pixel::RGB8>::fromRaw(decoder.getImage());
+			image.resize(ImageScaling::Area, 1920 / denominator, 1080 / denominator);
+
+		});
+
+		std::string name = "Scaled 1/" + std::to_string(denominator);
+		Benchmark::report(name.c_str(), scaled);
+
+		name = "Full decode + area resize 1/" + std::to_string(denominator);
+		Benchmark::report(name.c_str(), resized);
+
+	}
+
+	return 0;
+
+}
\ No newline at end of file
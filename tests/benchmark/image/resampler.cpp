@@ -0,0 +1,106 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 resampler.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "image/image.hpp"
+#include "concurrent/threadpool.hpp"
+#include "concurrent/thread.hpp"
+
+#include <string>
+
+
+
+static Image<Pixel::RGBA8> createImage(u32 width, u32 height) {
+
+	Image<Pixel::RGBA8> image(width, height);
+
+	for (u32 y = 0; y < height; y++) {
+
+		for (u32 x = 0; x < width; x++) {
+			image.setPixel(x, y, PixelRGBA8(x, y, x ^ y, 255));
+		}
+
+	}
+
+	return image;
+
+}
+
+
+
+//Runs with ARC_CPUID_DISABLE set measure the scalar kernels
+int main() {
+
+	constexpr u32 Width = 3840;
+	constexpr u32 Height = 2160;
+	constexpr SizeT Bytes = SizeT(Width) * Height * 4;
+
+	const Image<Pixel::RGBA8> source = createImage(Width, Height);
+	const Image<Pixel::RGBA8> small = createImage(Width / 4, Height / 4);
+
+	struct Method {
+
+		const char* name;
+		ImageScaling scaling;
+
+	};
+
+	const Method methods[] = {
+		{"Nearest", ImageScaling::Nearest},
+		{"Bilinear", ImageScaling::Bilinear},
+		{"Bicubic", ImageScaling::Bicubic},
+		{"Lanczos3", ImageScaling::Lanczos3},
+		{"Area", ImageScaling::Area}
+	};
+
+	std::printf("RGBA8, Image::resize\n");
+
+	for (const Method& method : methods) {
+
+		std::string down = std::string(method.name) + " 3840x2160 -> 1920x1080";
+		std::string up = std::string(method.name) + " 960x540 -> 3840x2160";
+
+		Benchmark::report(down.c_str(), Benchmark::measure(3, [&]() {
+
+			Image<Pixel::RGBA8> image = source;
+			image.resize(method.scaling, Width / 2, Height / 2);
+			Benchmark::consume(image.getImageData()[0]);
+
+		}), Bytes);
+
+		Benchmark::report(up.c_str(), Benchmark::measure(3, [&]() {
+
+			Image<Pixel::RGBA8> image = small;
+			image.resize(method.scaling, Width, Height);
+			Benchmark::consume(image.getImageData()[0]);
+
+		}), Bytes);
+
+	}
+
+	std::printf("\nRGBA8, reused ImageResampler and target\n");
+
+	Image<Pixel::RGBA8> target(Width / 2, Height / 2);
+	ImageResampler lanczos(ImageScaling::Lanczos3, Width, Height, Width / 2, Height / 2, 4);
+
+	Benchmark::report("Lanczos3 3840x2160 -> 1920x1080", Benchmark::measure(5, [&]() { source.resample(lanczos, target); }), Bytes);
+
+	u32 hardwareThreads = Math::max(Thread::getHardwareThreadCount(), 1u);
+
+	for (u32 threads = 2; threads <= hardwareThreads; threads *= 2) {
+
+		ThreadPool pool(threads);
+		std::string name = "Lanczos3 3840x2160 -> 1920x1080, " + std::to_string(threads) + " workers";
+
+		Benchmark::report(name.c_str(), Benchmark::measure(5, [&]() { source.resample(lanczos, target, &pool); }), Bytes);
+
+	}
+
+	return 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 arenadocument.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "json/arenadocument.hpp"
+#include "json/document.hpp"
+
+#include <cstdlib>
+#include <new>
+#include <string>
+
+
+
+/*
+	Live heap bytes, tracked by replacing the global allocation functions.
+	Every block carries its size in a header that keeps the default new alignment.
+*/
+static SizeT heapUsage = 0;
+
+static constexpr SizeT HeaderSize = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+void* operator new(SizeT size) {
+
+	u8* block = static_cast<u8*>(std::malloc(size + HeaderSize));
+
+	if (!block) {
+		throw std::bad_alloc();
+	}
+
+	*reinterpret_cast<SizeT*>(block) = size;
+	heapUsage += size;
+
+	return block + HeaderSize;
+
+}
+
+void operator delete(void* p) noexcept {
+
+	if (p) {
+
+		u8* block = static_cast<u8*>(p) - HeaderSize;
+
+		heapUsage -= *reinterpret_cast<SizeT*>(block);
+		std::free(block);
+
+	}
+
+}
+
+void operator delete(void* p, SizeT) noexcept {
+	operator delete(p);
+}
+
+
+
+static std::string recordCorpus(SizeT size) {
+
+	std::string json = "{\"records\": [";
+	u32 state = 3;
+
+	for (u32 i = 0; json.size() < size; i++) {
+
+		state = state * 1103515245 + 12345;
+
+		json += i ? ", " : "";
+		json += "{\"id\": " + std::to_string(i) + ", \"name\": \"record" + std::to_string(state % 100000) + "\", \"value\": " + std::to_string(state / 65536.0);
+		json += ", \"active\": " + std::string(state & 1 ? "true" : "false") + ", \"tags\": [\"a\", \"b\"]}";
+
+	}
+
+	return json + "]}";
+
+}
+
+
+
+//Times a single run in microseconds, parsing and teardown cannot be repeated on the same document
+template<class Function>
+static double timeOnce(Function&& function) {
+
+	Timer timer;
+	timer.start();
+
+	function();
+
+	return timer.getElapsedTime(Time::Unit::Microseconds);
+
+}
+
+
+
+int main() {
+
+	std::string json = recordCorpus(SizeT(26) << 20);
+
+	std::printf("%.1f MB array of small records\n\n", json.size() / 1048576.0);
+
+	//Parse and teardown are timed separately on fresh documents
+	double domParse = 0, domTeardown = 0, arenaParse = 0, arenaTeardown = 0;
+	SizeT domMemory = 0, arenaMemory = 0;
+	constexpr u32 Runs = 3;
+
+	for (u32 i = 0; i < Runs; i++) {
+
+		JsonDocument* document = nullptr;
+		SizeT heapBefore = heapUsage;
+
+		domParse += timeOnce([&]() { document = new JsonDocument(json); });
+		domMemory = heapUsage - heapBefore;
+		domTeardown += timeOnce([&]() { delete document; });
+
+		JsonArenaDocument* arena = nullptr;
+		heapBefore = heapUsage;
+
+		arenaParse += timeOnce([&]() { arena = new JsonArenaDocument(json); });
+		arenaMemory = heapUsage - heapBefore + arena->getMemoryUsage();
+		arenaTeardown += timeOnce([&]() { delete arena; });
+
+	}
+
+	Benchmark::report("JsonDocument parse", domParse / Runs, json.size());
+	Benchmark::report("JsonDocument teardown", domTeardown / Runs);
+	Benchmark::report("JsonArenaDocument parse", arenaParse / Runs, json.size());
+	Benchmark::report("JsonArenaDocument teardown", arenaTeardown / Runs);
+
+	//Arena memory includes the copy of the source
+	std::printf("\n%-40s %12.1f MB\n", "JsonDocument memory", domMemory / 1048576.0);
+	std::printf("%-40s %12.1f MB\n", "JsonArenaDocument memory", arenaMemory / 1048576.0);
+
+	return 0;
+
+}
\ No newline at end of file
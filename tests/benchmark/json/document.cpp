@@ -0,0 +1,152 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 document.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "json/document.hpp"
+
+#include <sstream>
+#include <string>
+
+
+
+/*
+	The value readers JsonDocument used before from_chars and the delimiter search.
+	readNumber copies the remaining document into a stream for every number, readString appends one character at a time.
+*/
+static bool originalReadString(const char*& cur, const char* end, std::string& string) {
+
+	for (cur++; cur < end; cur++) {
+
+		if (*cur == '"') {
+			break;
+		}
+
+		string += *cur;
+
+	}
+
+	return cur <= end;
+
+}
+
+static bool originalReadNumber(const char*& cur, const char* end, double& value) {
+
+	std::istringstream is(std::string(cur, end));
+
+	is >> value;
+	cur += is.tellg();
+
+	return !is.fail();
+
+}
+
+
+
+//Feeds every value of a flat array to the original readers, which is less work than building the whole document
+static void originalParse(const std::string& json) {
+
+	const char* cur = json.data();
+	const char* end = cur + json.size();
+
+	std::string string;
+	double number = 0;
+
+	while (cur < end) {
+
+		if (*cur == '"') {
+
+			string.clear();
+			originalReadString(cur, end, string);
+			Benchmark::consume(string);
+
+		} else if (*cur == '-' || (*cur >= '0' && *cur <= '9')) {
+
+			originalReadNumber(cur, end, number);
+			Benchmark::consume(number);
+			continue;
+
+		}
+
+		cur++;
+
+	}
+
+}
+
+
+
+static std::string numberCorpus(SizeT size) {
+
+	std::string json = "{\"values\": [";
+	u32 state = 7;
+
+	while (json.size() < size) {
+
+		state = state * 1103515245 + 12345;
+		json += (state & 1) ? std::to_string(i32(state) / 7) : std::to_string(state / 65536.0 - 1000);
+		json += ", ";
+
+	}
+
+	return json + "0]}";
+
+}
+
+static std::string stringCorpus(SizeT size) {
+
+	std::string json = "{\"values\": [";
+
+	while (json.size() < size) {
+		json += "\"The quick brown fox jumps over the lazy dog, then takes a nap in the \\\"sun\\\"\", ";
+	}
+
+	return json + "\"\"]}";
+
+}
+
+
+
+int main() {
+
+	struct Corpus {
+
+		const char* name;
+		std::string(*create)(SizeT);
+
+	};
+
+	const Corpus corpora[] = {
+		{"numbers", numberCorpus},
+		{"strings", stringCorpus}
+	};
+
+	for (const Corpus& corpus : corpora) {
+
+		//The original number path is quadratic, so it only runs on small inputs
+		for (SizeT size : {SizeT(64) << 10, SizeT(256) << 10, SizeT(16) << 20}) {
+
+			std::string json = corpus.create(size);
+			std::string suffix = std::string(" ") + corpus.name + " " + std::to_string(size >> 10) + " KB";
+
+			if (size <= SizeT(256) << 10) {
+
+				std::string name = "Original" + suffix;
+				Benchmark::report(name.c_str(), Benchmark::measure(1, [&]() { originalParse(json); }), json.size());
+
+			}
+
+			std::string name = "JsonDocument" + suffix;
+			Benchmark::report(name.c_str(), Benchmark::measure(3, [&]() { JsonDocument document(json); Benchmark::consume(document); }), json.size());
+
+		}
+
+	}
+
+	return 0;
+
+}
\ No newline at end of file
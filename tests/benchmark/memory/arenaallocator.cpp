@@ -0,0 +1,151 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 arenaallocator.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "memory/arenaallocator.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+
+
+//Heap allocations, counted by replacing the global allocation functions
+static SizeT heapAllocations = 0;
+
+void* operator new(SizeT size) {
+
+	void* p = std::malloc(size ? size : 1);
+
+	if (!p) {
+		throw std::bad_alloc();
+	}
+
+	heapAllocations++;
+
+	return p;
+
+}
+
+void operator delete(void* p) noexcept {
+	std::free(p);
+}
+
+void operator delete(void* p, SizeT) noexcept {
+	operator delete(p);
+}
+
+
+
+constexpr u32 Frames = 2000;
+constexpr u32 Sprites = 2000;
+constexpr u32 Labels = 200;
+
+
+
+/*
+	Per-frame temporaries of a sprite renderer: sort keys built by push_back and sorted,
+	a set of short label strings and a scratch buffer for vertex data.
+*/
+template<class KeyVector, class LabelVector, class Scratch>
+static u64 frame(u32 index, KeyVector& keys, LabelVector& labels, Scratch& scratch) {
+
+	u32 state = index * 2654435761u + 1;
+
+	for (u32 i = 0; i < Sprites; i++) {
+
+		state = state * 1103515245 + 12345;
+		keys.push_back(u64(state) << 32 | i);
+
+	}
+
+	std::sort(keys.begin(), keys.end());
+
+	for (u32 i = 0; i < Labels; i++) {
+
+		labels.emplace_back();
+		labels.back().append("sprite label ").append(std::to_string(keys[i * 7] & 0xFFFF)).append(" of layer ").append(std::to_string(i));
+
+	}
+
+	scratch.resize(Sprites * 16);
+
+	u64 checksum = keys[Sprites / 2] + labels[Labels / 2].size();
+
+	for (u32 i = 0; i < Sprites; i++) {
+		scratch[i * 16] = float(keys[i] & 0xFF);
+	}
+
+	return checksum + u64(scratch[Sprites * 8]);
+
+}
+
+
+
+int main() {
+
+	u64 checksum = 0;
+
+	//Regular containers, freed at the end of every frame
+	SizeT heapBefore = heapAllocations;
+
+	double heapTime = Benchmark::measure(1, [&]() {
+
+		for (u32 f = 0; f < Frames; f++) {
+
+			std::vector<u64> keys;
+			std::vector<std::string> labels;
+			std::vector<float> scratch;
+
+			checksum += frame(f, keys, labels, scratch);
+
+		}
+
+	});
+
+	SizeT heapCount = (heapAllocations - heapBefore) / 2;
+
+	//The same containers drawing from the frame arena, which is reset by nextFrame()
+	heapBefore = heapAllocations;
+
+	double arenaTime = Benchmark::measure(1, [&]() {
+
+		for (u32 f = 0; f < Frames; f++) {
+
+			ArenaResource resource(ArenaAllocator::getFrameArena());
+
+			std::pmr::vector<u64> keys(&resource);
+			std::pmr::vector<std::pmr::string> labels(&resource);
+			std::pmr::vector<float> scratch(&resource);
+
+			checksum += frame(f, keys, labels, scratch);
+
+			ArenaAllocator::nextFrame();
+
+		}
+
+	});
+
+	SizeT arenaCount = (heapAllocations - heapBefore) / 2;
+
+	Benchmark::consume(checksum);
+
+	std::printf("%u frames of %u sort keys, %u labels and a scratch buffer\n\n", Frames, Sprites, Labels);
+
+	Benchmark::report("std::allocator", heapTime);
+	Benchmark::report("Frame arena", arenaTime);
+
+	std::printf("\n%-40s %12zu\n", "std::allocator heap allocations", heapCount);
+	std::printf("%-40s %12zu\n", "Frame arena heap allocations", arenaCount);
+	std::printf("%-40s %12zu KB\n", "Frame arena peak", ArenaAllocator::getFrameArena().getPeakSize() / 1024);
+
+	return 0;
+
+}
\ No newline at end of file
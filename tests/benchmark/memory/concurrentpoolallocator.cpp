@@ -0,0 +1,136 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 concurrentpoolallocator.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "memory/concurrentpoolallocator.hpp"
+#include "memory/poolallocator.hpp"
+#include "concurrent/thread.hpp"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+
+constexpr u32 Batch = 16;
+constexpr u32 MaxThreads = 64;
+constexpr u32 BlockSize = 64;
+
+
+
+//Shared pool guarded by a mutex, the previous way of sharing pools between workers
+struct LockedPool {
+
+	LockedPool() {
+		pool.create(MaxThreads * Batch, BlockSize, 8);
+	}
+
+	void* allocate() {
+
+		std::lock_guard lock(mutex);
+		return pool.allocate();
+
+	}
+
+	void deallocate(void* p) {
+
+		std::lock_guard lock(mutex);
+		pool.deallocate(p);
+
+	}
+
+	std::mutex mutex;
+	PoolAllocator pool;
+
+};
+
+struct LockFreePool {
+
+	LockFreePool() {
+		pool.create(MaxThreads * Batch, BlockSize, 8);
+	}
+
+	void* allocate() {
+		return pool.allocate();
+	}
+
+	void deallocate(void* p) {
+		pool.deallocate(p);
+	}
+
+	ConcurrentPoolAllocator pool;
+
+};
+
+
+
+//Every thread repeatedly takes a batch of blocks from the shared pool, touches them and returns them
+template<class Pool>
+static void contend(Pool& pool, u32 threadCount, u32 iterations) {
+
+	std::vector<Thread> threads(threadCount);
+
+	for (u32 t = 0; t < threadCount; t++) {
+
+		threads[t].start([&pool, iterations]() {
+
+			void* blocks[Batch];
+
+			for (u32 i = 0; i < iterations; i++) {
+
+				for (u32 j = 0; j < Batch; j++) {
+
+					blocks[j] = pool.allocate();
+					static_cast<u8*>(blocks[j])[0] = u8(i);
+
+				}
+
+				for (u32 j = 0; j < Batch; j++) {
+					pool.deallocate(blocks[j]);
+				}
+
+			}
+
+		});
+
+	}
+
+	for (Thread& thread : threads) {
+		thread.finish();
+	}
+
+}
+
+
+
+int main() {
+
+	//The total work is constant, so the times show the cost of contention alone
+	constexpr u32 TotalIterations = 1 << 18;
+
+	std::printf("%u batches of %u blocks split across the threads, %u hardware threads\n\n", TotalIterations, Batch, Thread::getHardwareThreadCount());
+
+	LockedPool locked;
+	LockFreePool lockFree;
+
+	for (u32 threads = 1; threads <= MaxThreads; threads *= 2) {
+
+		u32 iterations = TotalIterations / threads;
+
+		std::string suffix = ", " + std::to_string(threads) + " threads";
+		std::string lockedName = "Mutex + PoolAllocator" + suffix;
+		std::string lockFreeName = "ConcurrentPoolAllocator" + suffix;
+
+		Benchmark::report(lockedName.c_str(), Benchmark::measure(3, [&]() { contend(locked, threads, iterations); }));
+		Benchmark::report(lockFreeName.c_str(), Benchmark::measure(3, [&]() { contend(lockFree, threads, iterations); }));
+
+	}
+
+	return 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 sizeclassallocator.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "memory/sizeclassallocator.hpp"
+#include "concurrent/thread.hpp"
+#include "math/math.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+
+
+struct SystemAllocator {
+
+	static void* allocate(SizeT size) {
+		return std::malloc(size);
+	}
+
+	static void deallocate(void* p) {
+		std::free(p);
+	}
+
+};
+
+struct SizeClass {
+
+	static void* allocate(SizeT size) {
+		return SizeClassAllocator::allocate(size);
+	}
+
+	static void deallocate(void* p) {
+		SizeClassAllocator::deallocate(p);
+	}
+
+};
+
+
+
+//Every thread replaces random slots of its own working set with blocks of random size
+template<class Allocator>
+static void stress(u32 threadCount, u32 operations, SizeT maxSize) {
+
+	constexpr u32 Slots = 1024;
+
+	std::vector<Thread> threads(threadCount);
+
+	for (u32 t = 0; t < threadCount; t++) {
+
+		threads[t].start([=]() {
+
+			std::vector<void*> slots(Slots, nullptr);
+			u32 state = t * 7 + 1;
+
+			for (u32 i = 0; i < operations; i++) {
+
+				state = state * 1103515245 + 12345;
+
+				void*& slot = slots[(state >> 4) % Slots];
+
+				Allocator::deallocate(slot);
+				slot = Allocator::allocate((state >> 14) % maxSize + 1);
+
+				static_cast<u8*>(slot)[0] = u8(i);
+
+			}
+
+			for (void* p : slots) {
+				Allocator::deallocate(p);
+			}
+
+		});
+
+	}
+
+	for (Thread& thread : threads) {
+		thread.finish();
+	}
+
+}
+
+
+
+int main() {
+
+	constexpr u32 Operations = 1000000;
+
+	struct Workload {
+
+		const char* name;
+		SizeT maxSize;
+
+	};
+
+	const Workload workloads[] = {
+		{"1-256 B", 256},
+		{"1-4096 B", 4096},
+		{"1-32768 B", 32768}
+	};
+
+	u32 hardwareThreads = Math::max(Thread::getHardwareThreadCount(), 1u);
+
+	std::printf("%u operations per thread, %u hardware threads\n", Operations, hardwareThreads);
+
+	for (const Workload& workload : workloads) {
+
+		for (u32 threads = 1; threads <= Math::max(hardwareThreads, 4u); threads *= 2) {
+
+			std::string suffix = std::string(" ") + workload.name + ", " + std::to_string(threads) + " threads";
+			std::string system = "malloc" + suffix;
+			std::string sizeClass = "SizeClassAllocator" + suffix;
+
+			Benchmark::report(system.c_str(), Benchmark::measure(3, [&]() { stress<SystemAllocator>(threads, Operations, workload.maxSize); }));
+			Benchmark::report(sizeClass.c_str(), Benchmark::measure(3, [&]() { stress<SizeClass>(threads, Operations, workload.maxSize); }));
+
+		}
+
+	}
+
+	return 0;
+
+}
\ No newline at end of file
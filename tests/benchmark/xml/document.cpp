@@ -0,0 +1,137 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 document.cpp
+ */
+
+#include "framework/benchmark.hpp"
+#include "xml/xml.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+	#include <Windows.h>
+	#include <Psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+
+
+//Peak resident set size of the process in bytes
+static SizeT peakMemory() {
+
+#ifdef _WIN32
+
+	PROCESS_MEMORY_COUNTERS counters;
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+
+	return counters.PeakWorkingSetSize;
+
+#else
+
+	rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+#ifdef __APPLE__
+	return usage.ru_maxrss;
+#else
+	return SizeT(usage.ru_maxrss) * 1024;
+#endif
+
+#endif
+
+}
+
+
+
+//SVG-like export with attribute-heavy elements and text with entities
+static std::string createCorpus(SizeT size) {
+
+	std::string xml;
+	xml.reserve(size + 4096);
+	xml += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg width=\"4096\" height=\"4096\">\n";
+	u32 state = 5;
+
+	for (u32 i = 0; xml.size() < size; i++) {
+
+		state = state * 1103515245 + 12345;
+
+		std::string id = std::to_string(i);
+		std::string x = std::to_string(state % 4096);
+		std::string y = std::to_string((state >> 12) % 4096);
+
+		xml += "\t<g id=\"group" + id + "\" transform=\"translate(" + x + " " + y + ")\">\n";
+		xml += "\t\t<rect x=\"0\" y=\"0\" width=\"" + x + "\" height=\"" + y + "\" fill=\"#" + std::to_string(state % 1000000) + "\"/>\n";
+		xml += "\t\t<path d=\"M 0 0 L " + x + " " + y + " Z\" stroke=\"black\"/>\n";
+		xml += "\t\t<text>Label " + id + " &amp; caption &lt;" + x + "&gt;</text>\n";
+
+		xml += "\t</g>\n";
+
+	}
+
+	xml += "</svg>\n";
+
+	return xml;
+
+}
+
+
+
+//Visits every node and attribute in document order
+static SizeT traverse(const Xml::Node<char>& node) {
+
+	SizeT bytes = node.getName().size() + node.getValue().size();
+
+	for (auto attribute = node.getFirstAttribute(); attribute; attribute = attribute->getNext()) {
+		bytes += attribute->getName().size() + attribute->getValue().size();
+	}
+
+	for (auto child = node.getFirstChild(); child; child = child->getNext()) {
+		bytes += traverse(*child);
+	}
+
+	return bytes;
+
+}
+
+
+
+//Usage: benchmark_xml_document [megabytes], peak memory is only meaningful for one size per process
+int main(int argc, char* argv[]) {
+
+	SizeT megabytes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 32;
+	std::string xml = createCorpus(megabytes << 20);
+
+	SizeT sourceMemory = peakMemory();
+
+	std::printf("%.1f MB SVG-like document\n\n", xml.size() / 1048576.0);
+
+	Xml::Document<char> document;
+
+	Timer timer;
+	timer.start();
+
+	document.read(std::string_view(xml));
+
+	double parse = timer.getElapsedTime(Time::Unit::Microseconds);
+	SizeT parseMemory = peakMemory();
+
+	SizeT bytes = 0;
+	double traversal = Benchmark::measure(3, [&]() { bytes = traverse(document.getRoot()); });
+
+	Benchmark::consume(bytes);
+
+	Benchmark::report("Document::read", parse, xml.size());
+	Benchmark::report("Traversal", traversal);
+
+	std::printf("\n%-40s %12.1f MB\n", "Peak RSS with the source", sourceMemory / 1048576.0);
+	std::printf("%-40s %12.1f MB\n", "Peak RSS after parsing", parseMemory / 1048576.0);
+
+	return 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 benchmark.hpp
+ */
+
+#pragma once
+
+#include "time/timer.hpp"
+#include "types.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+
+
+namespace Benchmark {
+
+	/*
+		Runs function iterations times after a single warm-up run and returns the average time per run in microseconds.
+	*/
+	template<class Function>
+	double measure(u32 iterations, Function&& function) {
+
+		function();
+
+		Timer timer;
+		timer.start();
+
+		for (u32 i = 0; i < iterations; i++) {
+			function();
+		}
+
+		return timer.getElapsedTime(Time::Unit::Microseconds) / iterations;
+
+	}
+
+	//Prints the time per run and, if bytes is non-zero, the throughput
+	inline void report(const char* name, double microseconds, SizeT bytes = 0) {
+
+		if (bytes) {
+			std::printf("%-40s %12.2f us %10.2f MB/s\n", name, microseconds, bytes / microseconds);
+		} else {
+			std::printf("%-40s %12.2f us\n", name, microseconds);
+		}
+
+	}
+
+	inline const void* volatile sink = nullptr;
+
+	//Keeps the compiler from discarding a computed value
+	template<class T>
+	inline void consume(const T& value) {
+		sink = &value;
+		std::atomic_signal_fence(std::memory_order_seq_cst);
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 main.cpp
+ */
+
+#include "test.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <exception>
+
+
+
+extern u32 failedExpectations;
+
+
+
+//Runs all registered cases, or only those whose name contains the first argument
+int main(int argc, char* argv[]) {
+
+	const char* filter = argc > 1 ? argv[1] : "";
+	u32 failedCases = 0;
+	u32 ranCases = 0;
+
+	for (const Test::Case& testCase : Test::getCases()) {
+
+		if (!std::strstr(testCase.name, filter)) {
+			continue;
+		}
+
+		u32 previousFailures = failedExpectations;
+
+		try {
+
+			testCase.function();
+
+		} catch (const std::exception& e) {
+
+			Test::fail(__FILE__, __LINE__, std::string("Unexpected exception: ") + e.what());
+
+		} catch (...) {
+
+			Test::fail(__FILE__, __LINE__, "Unexpected exception");
+
+		}
+
+		bool passed = failedExpectations == previousFailures;
+
+		std::printf("[%s] %s\n", passed ? "  OK  " : " FAIL ", testCase.name);
+
+		failedCases += !passed;
+		ranCases++;
+
+	}
+
+	std::printf("%u of %u cases passed\n", ranCases - failedCases, ranCases);
+
+	return failedCases ? 1 : 0;
+
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 test.cpp
+ */
+
+#include "test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+
+
+u32 failedExpectations = 0;
+
+
+
+Test::Registrar::Registrar(const char* name, Function function) {
+	getCases().push_back({name, function});
+}
+
+
+
+std::vector<Test::Case>& Test::getCases() {
+
+	static std::vector<Case> cases;
+	return cases;
+
+}
+
+
+
+void Test::fail(const char* file, u32 line, const std::string& message) {
+
+	std::fprintf(stderr, "%s:%u: %s\n", file, line, message.c_str());
+	failedExpectations++;
+
+}
+
+
+
+std::vector<u8> Test::readData(const std::string& name) {
+
+	std::ifstream stream(ARC_TEST_DATA_PATH + name, std::ios::binary);
+
+	if (!stream) {
+		throw std::runtime_error("Failed to open test data " + name);
+	}
+
+	return std::vector<u8>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 test.hpp
+ */
+
+#pragma once
+
+#include "types.hpp"
+
+#include <string>
+#include <vector>
+
+
+
+/*
+	Minimal test framework without external dependencies.
+
+	Every test executable consists of any number of ARC_TEST cases which are run in declaration order by framework/main.cpp.
+	Failed expectations are reported with their location and mark the case as failed, the remaining expectations still run.
+	The executable returns a non-zero exit code if any case failed.
+*/
+namespace Test {
+
+	using Function = void(*)();
+
+	struct Case {
+
+		const char* name;
+		Function function;
+
+	};
+
+	//Registers a case, used by ARC_TEST
+	struct Registrar {
+		Registrar(const char* name, Function function);
+	};
+
+	std::vector<Case>& getCases();
+
+	//Records a failed expectation in the running case
+	void fail(const char* file, u32 line, const std::string& message);
+
+	//Returns the contents of a file in tests/data
+	std::vector<u8> readData(const std::string& name);
+
+}
+
+
+
+#define ARC_TEST_CONCAT_IMPL(a, b) a##b
+#define ARC_TEST_CONCAT(a, b) ARC_TEST_CONCAT_IMPL(a, b)
+
+#define ARC_TEST(name) \
+	static void ARC_TEST_CONCAT(arcTest_, name)(); \
+	static Test::Registrar ARC_TEST_CONCAT(arcTestRegistrar_, name)(#name, ARC_TEST_CONCAT(arcTest_, name)); \
+	static void ARC_TEST_CONCAT(arcTest_, name)()
+
+#define ARC_EXPECT(expression) \
+	do { \
+		if (!(expression)) { \
+			Test::fail(__FILE__, __LINE__, "Expected " #expression); \
+		} \
+	} while (false)
+
+#define ARC_EXPECT_THROW(expression, ExceptionType) \
+	do { \
+		bool arcTestThrown = false; \
+		try { (void)(expression); } catch (const ExceptionType&) { arcTestThrown = true; } \
+		if (!arcTestThrown) { \
+			Test::fail(__FILE__, __LINE__, "Expected " #expression " to throw " #ExceptionType); \
+		} \
+	} while (false)
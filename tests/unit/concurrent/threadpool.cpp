@@ -0,0 +1,213 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 threadpool.cpp
+ */
+
+#include "framework/test.hpp"
+#include "concurrent/threadpool.hpp"
+#include "concurrent/taskgraph.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+
+
+ARC_TEST(SubmitAndWait) {
+
+	ThreadPool pool(4);
+	std::atomic<u32> counter = 0;
+	std::vector<TaskHandle> tasks;
+
+	for (u32 i = 0; i < 1000; i++) {
+		tasks.push_back(pool.submit([&counter]() { counter++; }));
+	}
+
+	pool.wait(tasks);
+
+	ARC_EXPECT(counter == 1000);
+
+	for (const TaskHandle& task : tasks) {
+		ARC_EXPECT(task.finished());
+	}
+
+}
+
+
+
+ARC_TEST(DependenciesRunInOrder) {
+
+	ThreadPool pool(4);
+	std::vector<u32> order;
+
+	TaskHandle first = pool.submit([&order]() { order.push_back(0); });
+	TaskHandle second = pool.then(first, [&order]() { order.push_back(1); });
+	TaskHandle third = pool.submit([&order]() { order.push_back(2); }, {first, second});
+
+	pool.wait(third);
+
+	ARC_EXPECT((order == std::vector<u32>{0, 1, 2}));
+
+}
+
+
+
+ARC_TEST(NestedTasks) {
+
+	ThreadPool pool(2);
+	std::atomic<u32> counter = 0;
+
+	TaskHandle outer = pool.submit([&]() {
+
+		std::vector<TaskHandle> inner;
+
+		for (u32 i = 0; i < 64; i++) {
+			inner.push_back(pool.submit([&counter]() { counter++; }));
+		}
+
+		pool.wait(inner);
+
+	});
+
+	pool.wait(outer);
+
+	ARC_EXPECT(counter == 64);
+
+}
+
+
+
+ARC_TEST(ParallelForVisitsEveryIndexOnce) {
+
+	ThreadPool pool(4);
+	std::vector<u32> visits(100003, 0);
+
+	pool.parallelFor(0, visits.size(), [&visits](SizeT i) { visits[i]++; });
+
+	ARC_EXPECT(std::all_of(visits.begin(), visits.end(), [](u32 v) { return v == 1; }));
+
+	pool.parallelFor(0, visits.size(), [&visits](SizeT begin, SizeT end) {
+
+		for (SizeT i = begin; i < end; i++) {
+			visits[i]++;
+		}
+
+	}, 7);
+
+	ARC_EXPECT(std::all_of(visits.begin(), visits.end(), [](u32 v) { return v == 2; }));
+
+	pool.parallelFor(5, 5, [&visits](SizeT i) { visits[i]++; });
+
+	ARC_EXPECT(visits[5] == 2);
+
+}
+
+
+
+ARC_TEST(ParallelReduce) {
+
+	ThreadPool pool(4);
+
+	u64 sum = pool.parallelReduce<u64>(0, 1000000, 0, [](SizeT i) { return u64(i); }, [](u64 a, u64 b) { return a + b; });
+
+	ARC_EXPECT(sum == 999999ull * 1000000 / 2);
+
+	//Chunks are combined in index order, so a non-commutative reduction is still deterministic
+	std::vector<u32> sequence = pool.parallelReduce<std::vector<u32>>(0, 100, {}, [](SizeT i) { return std::vector<u32>{u32(i)}; }, [](std::vector<u32> a, const std::vector<u32>& b) {
+
+		a.insert(a.end(), b.begin(), b.end());
+		return a;
+
+	}, 3);
+
+	std::vector<u32> expected(100);
+	std::iota(expected.begin(), expected.end(), 0);
+
+	ARC_EXPECT(sequence == expected);
+
+}
+
+
+
+ARC_TEST(ExceptionsPropagate) {
+
+	ThreadPool pool(2);
+
+	TaskHandle task = pool.submit([]() { throw std::runtime_error("Task failed"); });
+	ARC_EXPECT_THROW(pool.wait(task), std::runtime_error);
+
+	//Successors of a failed task are skipped and fail with its exception, also when it has already finished
+	std::atomic<bool> ran = false;
+
+	TaskHandle gate = pool.submit([]() {});
+	TaskHandle failing = pool.submit([]() { throw std::runtime_error("Predecessor failed"); }, {gate});
+	TaskHandle continuation = pool.then(failing, [&ran]() { ran = true; });
+	TaskHandle downstream = pool.then(continuation, [&ran]() { ran = true; });
+	TaskHandle joined = pool.submit([&ran]() { ran = true; }, {pool.submit([]() {}), failing});
+
+	ARC_EXPECT_THROW(pool.wait(downstream), std::runtime_error);
+	ARC_EXPECT_THROW(pool.wait(continuation), std::runtime_error);
+	ARC_EXPECT_THROW(pool.wait(joined), std::runtime_error);
+	ARC_EXPECT_THROW(pool.wait(pool.then(task, [&ran]() { ran = true; })), std::runtime_error);
+	ARC_EXPECT(!ran);
+
+	//Graph nodes downstream of a failed node are skipped as well
+	TaskGraph graph;
+	TaskGraph::NodeID source = graph.add([]() { throw std::runtime_error("Node failed"); });
+	TaskGraph::NodeID sink = graph.add([&ran]() { ran = true; });
+
+	graph.precede(source, sink);
+
+	ARC_EXPECT_THROW(pool.run(graph), std::runtime_error);
+	ARC_EXPECT(!ran);
+
+	ARC_EXPECT_THROW(pool.parallelFor(0, 1000, [](SizeT i) {
+
+		if (i == 777) {
+			throw std::runtime_error("Index failed");
+		}
+
+	}, 10), std::runtime_error);
+
+	//The pool stays usable afterwards
+	std::atomic<u32> counter = 0;
+	pool.parallelFor(0, 100, [&counter](SizeT) { counter++; });
+
+	ARC_EXPECT(counter == 100);
+
+}
+
+
+
+ARC_TEST(TaskGraph) {
+
+	ThreadPool pool(4);
+	TaskGraph graph;
+	std::atomic<u32> stage = 0;
+	std::atomic<bool> ordered = true;
+
+	TaskGraph::NodeID a = graph.add([&]() { stage = 1; });
+	TaskGraph::NodeID b = graph.add([&]() { ordered = ordered && stage >= 1; });
+	TaskGraph::NodeID c = graph.add([&]() { ordered = ordered && stage >= 1; });
+	TaskGraph::NodeID d = graph.add([&]() { ordered = ordered && stage >= 1; stage = 2; });
+
+	graph.precede(a, b);
+	graph.precede(a, c);
+	graph.precede(b, d);
+	graph.precede(c, d);
+
+	pool.run(graph);
+
+	ARC_EXPECT(ordered);
+	ARC_EXPECT(stage == 2);
+
+	graph.precede(d, a);
+
+	ARC_EXPECT_THROW(graph.validate(), TaskGraphException);
+
+}
\ No newline at end of file
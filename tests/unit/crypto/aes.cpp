@@ -0,0 +1,278 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 aes.cpp
+ */
+
+#include "framework/test.hpp"
+#include "crypto/encryption/aes.hpp"
+#include "concurrent/threadpool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+
+static std::vector<u8> fromHex(const std::string& hex) {
+
+	std::vector<u8> bytes;
+
+	for (SizeT i = 0; i + 1 < hex.size(); i += 2) {
+		bytes.push_back(u8(std::stoul(hex.substr(i, 2), nullptr, 16)));
+	}
+
+	return bytes;
+
+}
+
+
+
+template<SizeT N>
+static std::array<u8, N> fromHexArray(const std::string& hex) {
+
+	std::array<u8, N> array;
+	std::vector<u8> bytes = fromHex(hex);
+	std::copy_n(bytes.begin(), N, array.begin());
+
+	return array;
+
+}
+
+
+
+//Builds a key whose toArray() yields the given bytes
+template<SizeT KeySize>
+static Key<KeySize> makeKey(const std::string& hex) {
+
+	return std::apply([](auto... b) {
+		return Key<KeySize>(b...);
+	}, fromHexArray<KeySize / 8>(hex));
+
+}
+
+
+
+static std::string toHex(const std::span<const u8>& bytes) {
+
+	constexpr const char* digits = "0123456789abcdef";
+	std::string s;
+
+	for (u8 b : bytes) {
+		s.append(1, digits[b >> 4]).append(1, digits[b & 0xF]);
+	}
+
+	return s;
+
+}
+
+
+
+static std::vector<u8> createData(SizeT size, u32 seed) {
+
+	std::vector<u8> data(size);
+	u32 state = seed;
+
+	for (u8& b : data) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	return data;
+
+}
+
+
+
+//FIPS-197 appendix C
+ARC_TEST(BlockVectors) {
+
+	std::vector<u8> plaintext = fromHex("00112233445566778899aabbccddeeff");
+
+	AES::Cipher aes128(makeKey<128>("000102030405060708090a0b0c0d0e0f"));
+	AES::Cipher aes192(makeKey<192>("000102030405060708090a0b0c0d0e0f1011121314151617"));
+	AES::Cipher aes256(makeKey<256>("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"));
+
+	ARC_EXPECT(aes128.getRounds() == 10 && aes192.getRounds() == 12 && aes256.getRounds() == 14);
+
+	ARC_EXPECT(toHex(AES::encrypt(plaintext, aes128)) == "69c4e0d86a7b0430d8cdb78070b4c55a");
+	ARC_EXPECT(toHex(AES::encrypt(plaintext, aes192)) == "dda97ca4864cdfe06eaf70a0ec0d7191");
+	ARC_EXPECT(toHex(AES::encrypt(plaintext, aes256)) == "8ea2b7ca516745bfeafc49904b496089");
+
+	ARC_EXPECT(AES::decrypt(fromHex("69c4e0d86a7b0430d8cdb78070b4c55a"), aes128) == plaintext);
+	ARC_EXPECT(AES::decrypt(fromHex("dda97ca4864cdfe06eaf70a0ec0d7191"), aes192) == plaintext);
+	ARC_EXPECT(AES::decrypt(fromHex("8ea2b7ca516745bfeafc49904b496089"), aes256) == plaintext);
+
+	//Key overloads, multi-block runs crossing the eight block pipeline and in-place processing
+	std::vector<u8> data = createData(16 * 19, 3);
+	std::vector<u8> encrypted = AES::encrypt(data, makeKey<128>("000102030405060708090a0b0c0d0e0f"));
+
+	bool blockwise = true;
+
+	for (SizeT i = 0; i < data.size(); i += 16) {
+		blockwise &= std::equal(encrypted.begin() + i, encrypted.begin() + i + 16, AES::encrypt(std::span<const u8>(data).subspan(i, 16), aes128).begin());
+	}
+
+	ARC_EXPECT(blockwise);
+
+	aes128.encryptBlocks(data.data(), data.data(), 19);
+	ARC_EXPECT(data == encrypted);
+
+	aes128.decryptBlocks(data.data(), data.data(), 19);
+	ARC_EXPECT(data == createData(16 * 19, 3));
+
+	//ECB pads with zeros
+	std::vector<u8> odd = createData(21, 5);
+	std::vector<u8> padded = odd;
+	padded.resize(32);
+
+	ARC_EXPECT(AES::encrypt(odd, aes256) == AES::encrypt(padded, aes256));
+	ARC_EXPECT(AES::decrypt(AES::encrypt(odd, aes256), aes256) == padded);
+
+}
+
+
+
+//NIST SP 800-38A F.5.1
+ARC_TEST(CTR) {
+
+	AES::Cipher cipher(makeKey<128>("2b7e151628aed2a6abf7158809cf4f3c"));
+	AES::Block counter = fromHexArray<16>("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+
+	std::vector<u8> plaintext = fromHex("6bc1bee22e409f96e93d7e117393172aae2d8a571e03ac9c9eb76fac45af8e5130c81c46a35ce411e5fbc1191a0a52eff69f2445df4f9b17ad2b417be66c3710");
+	std::string expected = "874d6191b620e3261bef6864990db6ce9806f66b7970fdff8617187bb9fffdff5ae4df3edbd5d35e5b4f09020db03eab1e031dda2fbe03d1792170a0f3009cee";
+
+	ARC_EXPECT(toHex(AES::encryptCTR(plaintext, cipher, counter)) == expected);
+	ARC_EXPECT(AES::decryptCTR(fromHex(expected), cipher, counter) == plaintext);
+
+	//Partial blocks use a prefix of the keystream
+	ARC_EXPECT(toHex(AES::encryptCTR(std::span<const u8>(plaintext).first(37), cipher, counter)) == expected.substr(0, 74));
+
+	//The counter carries through all 128 bits and wraps around
+	for (const char* start : {"0000000000000000fffffffffffffffe", "ffffffffffffffffffffffffffffffff"}) {
+
+		AES::Block block = fromHexArray<16>(start);
+		std::vector<u8> counters;
+
+		for (u32 i = 0; i < 4; i++) {
+
+			counters.insert(counters.end(), block.begin(), block.end());
+
+			for (SizeT j = 16; j-- > 0 && ++block[j] == 0;) {}
+
+		}
+
+		std::vector<u8> zeros(64);
+		ARC_EXPECT(AES::encryptCTR(zeros, cipher, fromHexArray<16>(start)) == AES::encrypt(counters, cipher));
+
+	}
+
+}
+
+
+
+ARC_TEST(ThreadedCTR) {
+
+	AES::Cipher cipher(makeKey<256>("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4"));
+	AES::Block counter = fromHexArray<16>("00000000000000000000000000fffff0");
+
+	ThreadPool pool(4);
+
+	//Large enough to be split into many counter ranges, with a partial tail
+	for (SizeT size : {SizeT(100), SizeT(65536), SizeT((1 << 20) + 37)}) {
+
+		std::vector<u8> data = createData(size, 7);
+		std::vector<u8> sequential = AES::encryptCTR(data, cipher, counter);
+		std::vector<u8> threaded = AES::encryptCTR(data, cipher, counter, &pool);
+
+		ARC_EXPECT(sequential == threaded);
+		ARC_EXPECT(AES::decryptCTR(threaded, cipher, counter, &pool) == data);
+
+		//In place
+		AES::processCTR(data.data(), data.data(), data.size(), cipher, counter, &pool);
+		ARC_EXPECT(data == sequential);
+
+	}
+
+}
+
+
+
+//Test cases 1-4 of the GCM specification by McGrew and Viega
+ARC_TEST(GCMVectors) {
+
+	AES::Cipher zeroKey(makeKey<128>("00000000000000000000000000000000"));
+	AES::Nonce zeroNonce = {};
+
+	ARC_EXPECT(toHex(AES::encryptGCM({}, zeroKey, zeroNonce)) == "58e2fccefa7e3061367f1d57a4e7455a");
+	ARC_EXPECT(toHex(AES::encryptGCM(std::vector<u8>(16), zeroKey, zeroNonce)) == "0388dace60b6a392f328c2b971b2fe78ab6e47d42cec13bdf53a67b21257bddf");
+
+	AES::Cipher cipher(makeKey<128>("feffe9928665731c6d6a8f9467308308"));
+	AES::Nonce nonce = fromHexArray<12>("cafebabefacedbaddecaf888");
+
+	std::vector<u8> plaintext = fromHex("d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255");
+	std::vector<u8> aad = fromHex("feedfacedeadbeeffeedfacedeadbeefabaddad2");
+
+	ARC_EXPECT(toHex(AES::encryptGCM(plaintext, cipher, nonce)) == "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f59854d5c2af327cd64a62cf35abd2ba6fab4");
+
+	std::vector<u8> shortened(plaintext.begin(), plaintext.end() - 4);
+	std::string expected = "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e0915bc94fbc3221a5db94fae95ae7121a47";
+
+	ARC_EXPECT(toHex(AES::encryptGCM(shortened, cipher, nonce, aad)) == expected);
+
+	std::optional<std::vector<u8>> decrypted = AES::decryptGCM(fromHex(expected), cipher, nonce, aad);
+	ARC_EXPECT(decrypted && *decrypted == shortened);
+
+}
+
+
+
+ARC_TEST(GCMAuthentication) {
+
+	AES::Cipher cipher(makeKey<192>("000102030405060708090a0b0c0d0e0f1011121314151617"));
+	AES::Nonce nonce = fromHexArray<12>("000102030405060708090a0b");
+	ThreadPool pool(4);
+
+	std::vector<u8> aad = createData(77, 11);
+
+	//Lengths around the four block GHASH aggregation and the threading threshold
+	for (SizeT size : {SizeT(0), SizeT(1), SizeT(15), SizeT(16), SizeT(63), SizeT(64), SizeT(65), SizeT(1000), SizeT((1 << 20) + 5)}) {
+
+		std::vector<u8> data = createData(size, u32(size));
+		std::vector<u8> sealed = AES::encryptGCM(data, cipher, nonce, aad);
+
+		ARC_EXPECT(sealed.size() == size + AES::TagSize);
+		ARC_EXPECT(AES::encryptGCM(data, cipher, nonce, aad, &pool) == sealed);
+
+		std::optional<std::vector<u8>> opened = AES::decryptGCM(sealed, cipher, nonce, aad, &pool);
+		ARC_EXPECT(opened && *opened == data);
+
+		//Any flipped bit in the ciphertext, the tag or the aad fails authentication
+		std::vector<u8> tampered = sealed;
+		tampered[size / 2] ^= 0x01;
+		ARC_EXPECT(!AES::decryptGCM(tampered, cipher, nonce, aad));
+
+		tampered = sealed;
+		tampered.back() ^= 0x80;
+		ARC_EXPECT(!AES::decryptGCM(tampered, cipher, nonce, aad));
+
+		std::vector<u8> otherAAD = aad;
+		otherAAD[0] ^= 0x01;
+		ARC_EXPECT(!AES::decryptGCM(sealed, cipher, nonce, otherAAD));
+
+		AES::Nonce otherNonce = nonce;
+		otherNonce[11] ^= 0x01;
+		ARC_EXPECT(!AES::decryptGCM(sealed, cipher, otherNonce, aad));
+
+	}
+
+	//Inputs shorter than a tag are rejected
+	ARC_EXPECT(!AES::decryptGCM(std::vector<u8>(AES::TagSize - 1), cipher, nonce));
+
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 des.cpp
+ */
+
+#include "framework/test.hpp"
+#include "crypto/encryption/des.hpp"
+#include "concurrent/threadpool.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+
+static std::vector<u8> createData(SizeT size, u32 seed) {
+
+	std::vector<u8> data(size);
+	u32 state = seed;
+
+	for (u8& b : data) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	return data;
+
+}
+
+
+
+//Blocks hold the textbook 64 bit value in little endian byte order
+static std::vector<u8> block(u64 value) {
+
+	std::vector<u8> bytes(8);
+	Bits::disassemble(value, bytes.data());
+
+	return bytes;
+
+}
+
+
+
+/*
+	Reference results computed with OpenSSL's des-ecb, des-ede and des-ede3.
+	Data is converted per block since the keys are given as integers.
+*/
+ARC_TEST(KnownVectors) {
+
+	const Key<64> key1(0x133457799BBCDFF1ull);
+	const Key<64> keyA(0x0123456789ABCDEFull);
+	const Key<64> keyB(0x23456789ABCDEF01ull);
+	const Key<64> keyC(0x456789ABCDEF0123ull);
+
+	std::vector<u8> plaintext = block(0x0123456789ABCDEFull);
+
+	ARC_EXPECT(DES::encrypt(plaintext, key1) == block(0x85E813540F0AB405ull));
+	ARC_EXPECT(DES::decrypt(block(0x85E813540F0AB405ull), key1) == plaintext);
+	ARC_EXPECT(TripleDES::encrypt(plaintext, keyA, keyB) == block(0xA6BB373E196B375Eull));
+	ARC_EXPECT(TripleDES::encrypt(plaintext, keyA, keyB, keyC) == block(0xF2AFD84EE809E2B5ull));
+	ARC_EXPECT(TripleDES::decrypt(block(0xF2AFD84EE809E2B5ull), keyA, keyB, keyC) == plaintext);
+
+	ARC_EXPECT(DES::encrypt(plaintext, DES::Cipher(key1)) == block(0x85E813540F0AB405ull));
+	ARC_EXPECT(TripleDES::encrypt(plaintext, TripleDES::Cipher(keyA, keyB)) == block(0xA6BB373E196B375Eull));
+	ARC_EXPECT(TripleDES::encrypt(plaintext, TripleDES::Cipher(keyA, keyB, keyC)) == block(0xF2AFD84EE809E2B5ull));
+
+	//Every block of a multi-block input is encrypted on its own
+	std::vector<u8> twoBlocks = plaintext;
+	twoBlocks.insert(twoBlocks.end(), plaintext.begin(), plaintext.end());
+
+	std::vector<u8> ciphertext = block(0x85E813540F0AB405ull);
+	std::vector<u8> expected = ciphertext;
+	expected.insert(expected.end(), ciphertext.begin(), ciphertext.end());
+
+	ARC_EXPECT(DES::encrypt(twoBlocks, key1) == expected);
+
+}
+
+
+
+ARC_TEST(BulkMatchesReference) {
+
+	const Key<64> key1(0x0E329232EA6D0D73ull);
+	const Key<64> key2(0x9A2B3C4D5E6F7081ull);
+	const Key<64> key3(0x1F2E3D4C5B6A7988ull);
+
+	DES::Cipher des(key1);
+	TripleDES::Cipher ede2(key1, key2);
+	TripleDES::Cipher ede3(key1, key2, key3);
+
+	//Zero padding for sizes that are no multiple of the block size
+	for (SizeT size : {SizeT(0), SizeT(1), SizeT(7), SizeT(8), SizeT(9), SizeT(4099)}) {
+
+		std::vector<u8> data = createData(size, u32(size) + 1);
+		std::string label = std::to_string(size) + " bytes";
+
+		std::vector<u8> desCiphertext = DES::encrypt(data, des);
+		std::vector<u8> ede2Ciphertext = TripleDES::encrypt(data, ede2);
+		std::vector<u8> ede3Ciphertext = TripleDES::encrypt(data, ede3);
+
+		if (desCiphertext != DES::encrypt(data, key1) || ede2Ciphertext != TripleDES::encrypt(data, key1, key2) || ede3Ciphertext != TripleDES::encrypt(data, key1, key2, key3)) {
+			Test::fail(__FILE__, __LINE__, "Bulk encryption of " + label + " differs from the reference");
+		}
+
+		if (DES::decrypt(desCiphertext, des) != DES::decrypt(desCiphertext, key1) || TripleDES::decrypt(ede2Ciphertext, ede2) != TripleDES::decrypt(ede2Ciphertext, key1, key2) || TripleDES::decrypt(ede3Ciphertext, ede3) != TripleDES::decrypt(ede3Ciphertext, key1, key2, key3)) {
+			Test::fail(__FILE__, __LINE__, "Bulk decryption of " + label + " differs from the reference");
+		}
+
+	}
+
+	//Round trips with an odd key order, which decryption has to reverse
+	std::vector<u8> data = createData(4096, 3);
+
+	ARC_EXPECT(TripleDES::decrypt(TripleDES::encrypt(data, key1, key2, key3), key1, key2, key3) == data);
+	ARC_EXPECT(TripleDES::decrypt(TripleDES::encrypt(data, ede3), ede3) == data);
+
+}
+
+
+
+ARC_TEST(Threaded) {
+
+	TripleDES::Cipher cipher(Key<64>(0x0123456789ABCDEFull), Key<64>(0x23456789ABCDEF01ull), Key<64>(0x456789ABCDEF0123ull));
+	ThreadPool pool(4);
+
+	//Larger than a single chunk, with a partial block at the end
+	for (SizeT size : {SizeT(100), SizeT(65536), SizeT(300001)}) {
+
+		std::vector<u8> data = createData(size, 5);
+		std::vector<u8> ciphertext = TripleDES::encrypt(data, cipher);
+		std::vector<u8> threaded = TripleDES::encrypt(data, cipher, &pool);
+
+		ARC_EXPECT(threaded == ciphertext);
+		ARC_EXPECT(TripleDES::decrypt(threaded, cipher, &pool) == TripleDES::decrypt(ciphertext, cipher));
+
+		std::vector<u8> ctr = TripleDES::encryptCTR(data, cipher, 0xFFFFFFFFFFFFFF00ull);
+
+		ARC_EXPECT(ctr.size() == size);
+		ARC_EXPECT(TripleDES::encryptCTR(data, cipher, 0xFFFFFFFFFFFFFF00ull, &pool) == ctr);
+		ARC_EXPECT(TripleDES::decryptCTR(ctr, cipher, 0xFFFFFFFFFFFFFF00ull, &pool) == data);
+
+	}
+
+}
+
+
+
+ARC_TEST(CTRKeystream) {
+
+	DES::Cipher cipher(Key<64>(0x133457799BBCDFF1ull));
+
+	//The keystream is the encryption of consecutive counter blocks, wrapping around at 2^64
+	const u64 start = 0xFFFFFFFFFFFFFFFEull;
+	std::vector<u8> counters;
+
+	for (u64 i = 0; i < 4; i++) {
+
+		std::vector<u8> counter = block(start + i);
+		counters.insert(counters.end(), counter.begin(), counter.end());
+
+	}
+
+	std::vector<u8> keystream = DES::encryptCTR(std::vector<u8>(29), cipher, start);
+	std::vector<u8> expected = DES::encrypt(counters, cipher);
+
+	ARC_EXPECT(keystream.size() == 29 && std::equal(keystream.begin(), keystream.end(), expected.begin()));
+
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 hash.cpp
+ */
+
+#include "framework/test.hpp"
+#include "crypto/hash/md5.hpp"
+#include "crypto/hash/sha1.hpp"
+#include "crypto/hash/sha2.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+
+static std::span<const u8> bytes(const std::string& s) {
+	return {reinterpret_cast<const u8*>(s.data()), s.size()};
+}
+
+
+
+//Feeds data to the hasher in pieces of chunkSize bytes
+template<class Hasher>
+static auto hashChunked(Hasher& hasher, std::span<const u8> data, SizeT chunkSize) {
+
+	for (SizeT i = 0; i < data.size(); i += chunkSize) {
+		hasher.update(data.subspan(i, std::min(chunkSize, data.size() - i)));
+	}
+
+	return hasher.finalize();
+
+}
+
+
+
+/*
+	Compares one-shot and incremental hashing for all message lengths around the block and padding boundaries of both block sizes,
+	split into chunks that straddle those boundaries in every possible way.
+*/
+template<class Hasher, class Function>
+static bool matchesOneShot(Function&& oneShot) {
+
+	std::vector<u8> data(300);
+	u32 state = 17;
+
+	for (u8& b : data) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	const SizeT chunkSizes[] = {1, 3, 7, 55, 56, 63, 64, 65, 111, 112, 127, 128, 129, 1000};
+
+	Hasher hasher;
+
+	for (SizeT length = 0; length <= data.size(); length++) {
+
+		std::span<const u8> message(data.data(), length);
+		std::string expected = oneShot(message).toString();
+
+		for (SizeT chunkSize : chunkSizes) {
+
+			//The hasher is reused, finalize() has to reset it
+			if (hashChunked(hasher, message, chunkSize).toString() != expected) {
+				return false;
+			}
+
+		}
+
+	}
+
+	return true;
+
+}
+
+
+
+ARC_TEST(KnownVectors) {
+
+	const std::string abc = "abc";
+	const std::string empty;
+	const std::string twoBlocks = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+
+	ARC_EXPECT(MD5::hash(bytes(empty)).toString() == "d41d8cd98f00b204e9800998ecf8427e");
+	ARC_EXPECT(MD5::hash(bytes(abc)).toString() == "900150983cd24fb0d6963f7d28e17f72");
+	ARC_EXPECT(MD5::hash(bytes("12345678901234567890123456789012345678901234567890123456789012345678901234567890")).toString() == "57edf4a22be3c955ac49da2e2107b67a");
+
+	ARC_EXPECT(SHA0::hash(bytes(abc)).toString() == "0164b8a914cd2a5e74c4f7ff082c4d97f1edf880");
+	ARC_EXPECT(SHA1::hash(bytes(empty)).toString() == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+	ARC_EXPECT(SHA1::hash(bytes(abc)).toString() == "a9993e364706816aba3e25717850c26c9cd0d89d");
+	ARC_EXPECT(SHA1::hash(bytes(twoBlocks)).toString() == "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+
+	ARC_EXPECT(SHA2::hash224(bytes(abc)).toString() == "23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7");
+	ARC_EXPECT(SHA2::hash256(bytes(empty)).toString() == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	ARC_EXPECT(SHA2::hash256(bytes(abc)).toString() == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	ARC_EXPECT(SHA2::hash256(bytes(twoBlocks)).toString() == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+	ARC_EXPECT(SHA2::hash384(bytes(abc)).toString() == "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7");
+	ARC_EXPECT(SHA2::hash512(bytes(abc)).toString() == "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+	ARC_EXPECT(SHA2::hash512t224(bytes(abc)).toString() == "4634270f707b6a54daae7530460842e20e37ed265ceee9a43e8924aa");
+	ARC_EXPECT(SHA2::hash512t256(bytes(abc)).toString() == "53048e2681941ef99b2e29b76b4c7dabe4c2d0c634fc6d46e0e2f13107e7af23");
+
+}
+
+
+
+ARC_TEST(Streaming) {
+
+	//A million 'a's read in file sized chunks
+	const std::string chunk(4096, 'a');
+	const SizeT total = 1000000;
+
+	MD5::Hasher md5;
+	SHA1::Hasher sha1;
+	SHA2::Hasher256 sha256;
+	SHA2::Hasher512 sha512;
+
+	for (SizeT i = 0; i < total; i += chunk.size()) {
+
+		std::span<const u8> data = bytes(chunk).first(std::min(chunk.size(), total - i));
+
+		md5.update(data);
+		sha1.update(data);
+		sha256.update(data);
+		sha512.update(data);
+
+	}
+
+	ARC_EXPECT(md5.finalize().toString() == "7707d6ae4e027c70eea2a935c2296f21");
+	ARC_EXPECT(sha1.finalize().toString() == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+	ARC_EXPECT(sha256.finalize().toString() == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+	ARC_EXPECT(sha512.finalize().toString() == "e718483d0ce769644e2e42c7bc15b4638e1f98b13b2044285632a803afa973ebde0ff244877ea60a4cb0432ce577c31beb009c5c2c49aa2e4eadb217ad8cc09b");
+
+	//Hashers only buffer a partial block, memory does not depend on the message length
+	ARC_EXPECT(sizeof(SHA2::Hasher512) <= 256 && sizeof(SHA2::Hasher256) <= 128 && sizeof(MD5::Hasher) <= 128);
+
+	//init() discards pending data
+	sha256.update(bytes("garbage"));
+	sha256.init();
+	sha256.update(bytes("abc"));
+
+	ARC_EXPECT(sha256.finalize().toString() == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+
+}
+
+
+
+ARC_TEST(IncrementalMatchesOneShot) {
+
+	ARC_EXPECT(matchesOneShot<MD5::Hasher>(MD5::hash));
+	ARC_EXPECT(matchesOneShot<SHA0::Hasher>(SHA0::hash));
+	ARC_EXPECT(matchesOneShot<SHA1::Hasher>(SHA1::hash));
+	ARC_EXPECT(matchesOneShot<SHA2::Hasher224>(SHA2::hash224));
+	ARC_EXPECT(matchesOneShot<SHA2::Hasher256>(SHA2::hash256));
+	ARC_EXPECT(matchesOneShot<SHA2::Hasher384>(SHA2::hash384));
+	ARC_EXPECT(matchesOneShot<SHA2::Hasher512>(SHA2::hash512));
+	ARC_EXPECT(matchesOneShot<SHA2::Hasher512t224>(SHA2::hash512t224));
+	ARC_EXPECT(matchesOneShot<SHA2::Hasher512t256>(SHA2::hash512t256));
+
+}
+
+
+
+ARC_TEST(ConstantEvaluation) {
+
+	constexpr u8 abc[] = {'a', 'b', 'c'};
+
+	constexpr Hash<128> md5 = MD5::hash(abc);
+	constexpr Hash<160> sha1 = SHA1::hash(abc);
+	constexpr Hash<256> sha256 = SHA2::hash256(abc);
+	constexpr Hash<512> sha512 = SHA2::hash512(abc);
+
+	ARC_EXPECT(md5.toString() == "900150983cd24fb0d6963f7d28e17f72");
+	ARC_EXPECT(sha1.toString() == "a9993e364706816aba3e25717850c26c9cd0d89d");
+	ARC_EXPECT(sha256.toString() == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	ARC_EXPECT(sha512.toString() == "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+
+}
\ No newline at end of file
@@ -0,0 +1,135 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 sha2.cpp
+ */
+
+#include "framework/test.hpp"
+#include "crypto/hash/sha1.hpp"
+#include "crypto/hash/sha2.hpp"
+
+#include <string>
+#include <vector>
+
+
+
+/*
+	The tests run on SHA-NI, on the AVX2 lanes with SHA hidden and on the portable block functions with all features hidden.
+	Every run compares against the same reference digests, which were computed with Python's hashlib.
+*/
+static std::vector<u8> createData(SizeT size) {
+
+	std::vector<u8> data(size);
+	u32 state = 23;
+
+	for (u8& b : data) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	return data;
+
+}
+
+
+
+static std::span<const u8> bytes(const std::string& s) {
+	return {reinterpret_cast<const u8*>(s.data()), s.size()};
+}
+
+
+
+//Hashes the hex digests of all prefixes of data up to 1024 bytes
+template<class Hasher, class Function>
+static std::string prefixDigest(const std::vector<u8>& data, Function&& hash) {
+
+	Hasher outer;
+
+	for (SizeT length = 0; length <= 1024; length++) {
+		outer.update(bytes(hash(std::span<const u8>(data.data(), length)).toString()));
+	}
+
+	return outer.finalize().toString();
+
+}
+
+
+
+ARC_TEST(BlockFunctions) {
+
+	std::vector<u8> data = createData(1100);
+
+	ARC_EXPECT(prefixDigest<SHA1::Hasher>(data, SHA1::hash) == "b9a77e5d4f50cf74761037b2317eecc0544e06f8");
+	ARC_EXPECT(prefixDigest<SHA2::Hasher224>(data, SHA2::hash224) == "8d5f39d11a525ecb3bae9a672b173c67f94d9f99dc1031ad49b39764");
+	ARC_EXPECT(prefixDigest<SHA2::Hasher256>(data, SHA2::hash256) == "71b535c409861581a27082aef5c6016553092f1778d937e08bfd758dc3f7cf9c");
+
+}
+
+
+
+ARC_TEST(LargeUpdates) {
+
+	//A single update covering many blocks is compressed in one call
+	std::string million(1000000, 'a');
+
+	SHA1::Hasher sha1;
+	SHA2::Hasher256 sha256;
+
+	sha1.update(bytes(million.substr(0, 7)));
+	sha1.update(bytes(million.substr(7)));
+	sha256.update(bytes(million.substr(0, 100001)));
+	sha256.update(bytes(million.substr(100001)));
+
+	ARC_EXPECT(sha1.finalize().toString() == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+	ARC_EXPECT(sha256.finalize().toString() == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+
+}
+
+
+
+ARC_TEST(Batch) {
+
+	std::vector<u8> data = createData(5000);
+
+	//Lanes of different lengths finish at different blocks, counts that are no multiple of eight leave lanes idle
+	for (SizeT count : {SizeT(0), SizeT(1), SizeT(7), SizeT(8), SizeT(9), SizeT(100)}) {
+
+		std::vector<std::span<const u8>> messages;
+
+		for (SizeT i = 0; i < count; i++) {
+
+			SizeT length = i % 5 == 4 ? 4096 : (i * 37) % 300;
+			messages.emplace_back(data.data() + i % 100, length);
+
+		}
+
+		std::vector<Hash<256>> hashes(count);
+		SHA2::hash256Batch(messages, hashes);
+
+		bool match = true;
+
+		for (SizeT i = 0; i < count; i++) {
+			match &= hashes[i].toString() == SHA2::hash256(messages[i]).toString();
+		}
+
+		ARC_EXPECT(match);
+
+	}
+
+	//Known digests within a batch
+	std::string abc = "abc";
+	std::string empty;
+	std::span<const u8> known[] = {bytes(abc), bytes(empty), bytes(abc)};
+	Hash<256> knownHashes[3];
+
+	SHA2::hash256Batch(known, knownHashes);
+
+	ARC_EXPECT(knownHashes[0].toString() == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+	ARC_EXPECT(knownHashes[1].toString() == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+	ARC_EXPECT(knownHashes[2].toString() == knownHashes[0].toString());
+
+}
\ No newline at end of file
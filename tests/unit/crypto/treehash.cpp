@@ -0,0 +1,193 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 treehash.cpp
+ */
+
+#include "framework/test.hpp"
+#include "crypto/hash/treehash.hpp"
+#include "crypto/hash/sha2.hpp"
+#include "concurrent/threadpool.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+
+static std::vector<u8> createData(SizeT size, u32 seed) {
+
+	std::vector<u8> data(size);
+	u32 state = seed;
+
+	for (u8& b : data) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	return data;
+
+}
+
+
+
+static bool sameLeaves(const TreeHash& a, const TreeHash& b) {
+	return a.getRoot() == b.getRoot() && a.compare(b).empty();
+}
+
+
+
+//Reference roots computed with Python's hashlib
+ARC_TEST(KnownRoots) {
+
+	std::vector<u8> data = createData(10000, 29);
+
+	ARC_EXPECT(TreeHash::hash({}, 1024).toString() == "6e340b9cffb37a989ca544e6bb780a2c78901d3fb33738768511a30617afa01d");
+	ARC_EXPECT(TreeHash::hash(std::span<const u8>(data).first(1024), 1024).toString() == "60d93088ad18ec4a63928b8cebdc44ccf57f41a1905546137fdcd93a5c9b92ce");
+	ARC_EXPECT(TreeHash::hash(data, 1024).toString() == "f8f6511f09a43ad1fc9c8206fc3fbd00965b34be4b41b00a59cd9e457c114785");
+	ARC_EXPECT(TreeHash::hash(std::span<const u8>(data).first(5000), 1000).toString() == "0b47e663d60a6b42f0f491412cbc2dc1084eb869881628b0031920492f8c12fe");
+
+	//Empty input has a single empty leaf, a single leaf is the root
+	TreeHash empty(1024);
+
+	ARC_EXPECT(empty.getLeafCount() == 1 && empty.getDataSize() == 0);
+
+	u8 prefix = 0;
+	ARC_EXPECT(empty.getRoot() == SHA2::hash256(std::span<const u8>(&prefix, 1)));
+
+	TreeHash tree(1024);
+	tree.build(data);
+
+	ARC_EXPECT(tree.getLeafCount() == 10 && tree.getLeafSize() == 1024 && tree.getDataSize() == 10000);
+	ARC_EXPECT(TreeHash::hash(std::span<const u8>(data).first(1024), 1024) == tree.getLeafHashes()[0]);
+
+}
+
+
+
+ARC_TEST(ThreadCountIndependence) {
+
+	//Small leaves are grouped into tasks of at least 1 MiB, large leaves form a task each
+	std::vector<u8> data = createData(3000000, 31);
+
+	for (SizeT leafSize : {SizeT(4096), SizeT(1) << 20}) {
+
+		Hash<256> root = TreeHash::hash(data, leafSize);
+
+		for (u32 threads : {1u, 2u, 3u, 8u}) {
+
+			ThreadPool pool(threads);
+			ARC_EXPECT(TreeHash::hash(data, leafSize, &pool) == root);
+
+		}
+
+	}
+
+	//Leaf size changes the root
+	ARC_EXPECT(!(TreeHash::hash(data, 8192) == TreeHash::hash(data, 4096)));
+
+}
+
+
+
+ARC_TEST(Update) {
+
+	constexpr SizeT LeafSize = 256;
+
+	std::vector<u8> data = createData(10000, 37);
+	ThreadPool pool(4);
+
+	TreeHash tree(LeafSize);
+	tree.build(data);
+
+	u32 state = 41;
+
+	auto random = [&](SizeT bound) {
+
+		state = state * 1103515245 + 12345;
+		return SizeT(state >> 8) % bound;
+
+	};
+
+	//Random in-place modifications
+	for (u32 i = 0; i < 200; i++) {
+
+		SizeT offset = random(data.size());
+		SizeT size = random(std::min<SizeT>(data.size() - offset, 1000) + 1);
+
+		for (SizeT j = offset; j < offset + size; j++) {
+			data[j] ^= u8(random(255) + 1);
+		}
+
+		tree.update(data, offset, size, i % 2 ? &pool : nullptr);
+
+		TreeHash rebuilt(LeafSize);
+		rebuilt.build(data);
+
+		if (!sameLeaves(tree, rebuilt)) {
+			Test::fail(__FILE__, __LINE__, "Incremental update " + std::to_string(i) + " differs from a rebuild");
+			break;
+		}
+
+	}
+
+	//Growing and shrinking inputs, including across leaf boundaries and down to nothing
+	for (SizeT size : {SizeT(10000), SizeT(10001), SizeT(10240), SizeT(20000), SizeT(700), SizeT(0), SizeT(1), SizeT(512), SizeT(300)}) {
+
+		SizeT oldSize = data.size();
+		data.resize(size, 0x5A);
+
+		tree.update(data, std::min(oldSize, size), size > oldSize ? size - oldSize : 0);
+
+		TreeHash rebuilt(LeafSize);
+		rebuilt.build(data);
+
+		if (!sameLeaves(tree, rebuilt) || tree.getDataSize() != size) {
+			Test::fail(__FILE__, __LINE__, "Resizing to " + std::to_string(size) + " bytes differs from a rebuild");
+		}
+
+	}
+
+	//Empty ranges leave the tree untouched
+	Hash<256> root = tree.getRoot();
+	tree.update(data, 0, 0);
+
+	ARC_EXPECT(tree.getRoot() == root);
+
+}
+
+
+
+ARC_TEST(Compare) {
+
+	constexpr SizeT LeafSize = 1024;
+
+	std::vector<u8> data = createData(10000, 43);
+
+	TreeHash original(LeafSize);
+	original.build(data);
+
+	data[0] ^= 1;
+	data[5000] ^= 1;
+	data[9999] ^= 1;
+
+	TreeHash modified(LeafSize);
+	modified.build(data);
+
+	ARC_EXPECT(original.compare(original).empty());
+	ARC_EXPECT(original.compare(modified) == std::vector<SizeT>({0, 4, 9}));
+
+	//Leaves present in only one tree differ
+	data.resize(12000);
+
+	TreeHash longer(LeafSize);
+	longer.build(data);
+
+	ARC_EXPECT(modified.compare(longer) == std::vector<SizeT>({9, 10, 11}));
+	ARC_EXPECT(longer.compare(modified) == std::vector<SizeT>({9, 10, 11}));
+
+}
\ No newline at end of file
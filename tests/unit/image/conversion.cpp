@@ -0,0 +1,210 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 conversion.cpp
+ */
+
+#include "framework/test.hpp"
+#include "image/image.hpp"
+#include "concurrent/threadpool.hpp"
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+constexpr u32 FormatCount = static_cast<u32>(Pixel::ARGB8) + 1;
+
+
+
+static std::vector<u8> randomBytes(SizeT size, u32 seed) {
+
+	std::vector<u8> bytes(size);
+	u32 state = seed;
+
+	for (u8& b : bytes) {
+
+		state = state * 1103515245 + 12345;
+		b = u8(state >> 16);
+
+	}
+
+	return bytes;
+
+}
+
+
+
+//Per-pixel conversion through PixelConverter, the behaviour of the original Image::convert which copied equal formats
+template<Pixel From, Pixel To>
+static std::vector<u8> reference(const u8* source, SizeT count) {
+
+	constexpr u32 SourceBytes = PixelFormat<From>::BytesPerPixel;
+	constexpr u32 TargetBytes = PixelFormat<To>::BytesPerPixel;
+
+	if constexpr (From == To) {
+		return std::vector<u8>(source, source + count * SourceBytes);
+	}
+
+	std::vector<u8> target(count * TargetBytes);
+
+	for (SizeT i = 0; i < count; i++) {
+
+		PixelType<To> pixel = PixelConverter::convert<To>(PixelType<From>(std::span<const u8>(source + i * SourceBytes, SourceBytes)));
+		std::memcpy(&target[i * TargetBytes], pixel.p, TargetBytes);
+
+	}
+
+	return target;
+
+}
+
+
+
+//Calls function.template operator()<From, To>() for every pair of formats
+template<class Function, SizeT... I>
+static void forEachPair(Function&& function, std::index_sequence<I...>) {
+	(function.template operator()<static_cast<Pixel>(I / FormatCount), static_cast<Pixel>(I % FormatCount)>(), ...);
+}
+
+template<class Function>
+static void forEachPair(Function&& function) {
+	forEachPair(function, std::make_index_sequence<FormatCount * FormatCount>{});
+}
+
+
+
+ARC_TEST(MatchesPixelConverter) {
+
+	//Every length up to a few vector widths exercises the kernel tails
+	std::vector<SizeT> counts;
+
+	for (SizeT count = 0; count <= 40; count++) {
+		counts.push_back(count);
+	}
+
+	counts.push_back(1001);
+
+	forEachPair([&]<Pixel From, Pixel To>() {
+
+		constexpr u32 SourceBytes = PixelFormat<From>::BytesPerPixel;
+		constexpr u32 TargetBytes = PixelFormat<To>::BytesPerPixel;
+
+		for (SizeT count : counts) {
+
+			//Unaligned buffers with guard bytes behind the target
+			std::vector<u8> source = randomBytes(count * SourceBytes + 1, u32(count) + 7);
+			std::vector<u8> target(count * TargetBytes + 17, 0xCD);
+
+			PixelConversion::convert(From, To, source.data() + 1, target.data() + 1, count);
+
+			std::vector<u8> expected = reference<From, To>(source.data() + 1, count);
+			bool guarded = target[0] == 0xCD;
+
+			for (SizeT i = count * TargetBytes + 1; i < target.size(); i++) {
+				guarded &= target[i] == 0xCD;
+			}
+
+			bool match = std::memcmp(target.data() + 1, expected.data(), expected.size()) == 0;
+
+			if (!match || !guarded) {
+				Test::fail(__FILE__, __LINE__, "Conversion " + std::to_string(u32(From)) + " -> " + std::to_string(u32(To)) + " of " + std::to_string(count) + " pixels differs");
+			}
+
+			if constexpr (PixelConversion::isInPlace(From, To)) {
+
+				PixelConversion::convert(From, To, source.data() + 1, source.data() + 1, count);
+
+				if (std::memcmp(source.data() + 1, expected.data(), expected.size()) != 0) {
+					Test::fail(__FILE__, __LINE__, "In-place conversion " + std::to_string(u32(From)) + " -> " + std::to_string(u32(To)) + " of " + std::to_string(count) + " pixels differs");
+				}
+
+			}
+
+		}
+
+	});
+
+}
+
+
+
+ARC_TEST(KnownPixels) {
+
+	//RGB5 stores red in the lowest bits
+	u8 packed[2] = {0x1F, 0x7C};
+	u8 rgba[4];
+
+	PixelConversion::convert(Pixel::RGB5, Pixel::RGBA8, packed, rgba, 1);
+
+#ifdef ARC_PIXEL_EXACT
+	ARC_EXPECT(rgba[0] == 255 && rgba[1] == 0 && rgba[2] == 255 && rgba[3] == 255);
+#else
+	ARC_EXPECT(rgba[0] == 0xF8 && rgba[1] == 0 && rgba[2] == 0xF8 && rgba[3] == 255);
+#endif
+
+	u8 bgra[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+	u8 converted[8];
+
+	PixelConversion::convert(Pixel::BGRA8, Pixel::RGBA8, bgra, converted, 2);
+
+	ARC_EXPECT(converted[0] == 3 && converted[1] == 2 && converted[2] == 1 && converted[3] == 4);
+	ARC_EXPECT(converted[4] == 7 && converted[5] == 6 && converted[6] == 5 && converted[7] == 8);
+
+	u8 rgb[3] = {10, 20, 30};
+
+	PixelConversion::convert(Pixel::RGB8, Pixel::ARGB8, rgb, converted, 1);
+
+	//ARGB8 keeps alpha in the lowest byte
+	ARC_EXPECT(converted[0] == 255 && converted[1] == 10 && converted[2] == 20 && converted[3] == 30);
+
+}
+
+
+
+ARC_TEST(Images) {
+
+	constexpr u32 Width = 1021;
+	constexpr u32 Height = 517;
+
+	std::vector<u8> bytes = randomBytes(SizeT(Width) * Height * 4, 3);
+	Image<Pixel::BGRA8> source(Width, Height, bytes);
+
+	std::vector<u8> expected = reference<Pixel::BGRA8, Pixel::RGBA8>(bytes.data(), SizeT(Width) * Height);
+
+	//Large images are distributed across the pool
+	ThreadPool pool(4);
+
+	Image<Pixel::RGBA8> copied = source.convert<Pixel::RGBA8>();
+	Image<Pixel::RGBA8> threaded = source.convert<Pixel::RGBA8>(&pool);
+
+	ARC_EXPECT(std::memcmp(copied.getImageData(), expected.data(), expected.size()) == 0);
+	ARC_EXPECT(std::memcmp(threaded.getImageData(), expected.data(), expected.size()) == 0);
+
+	//Converting an rvalue of equal pixel size reuses its buffer
+	Image<Pixel::BGRA8> temporary = source;
+	const u8* buffer = temporary.getImageData();
+
+	Image<Pixel::RGBA8> moved = std::move(temporary).convert<Pixel::RGBA8>(&pool);
+
+	ARC_EXPECT(moved.getImageData() == buffer && moved.getWidth() == Width && moved.getHeight() == Height);
+	ARC_EXPECT(std::memcmp(moved.getImageData(), expected.data(), expected.size()) == 0);
+
+	//Different sizes fall back to a new buffer
+	Image<Pixel::RGB8> rgb = std::move(moved).convert<Pixel::RGB8>();
+	std::vector<u8> expectedRGB = reference<Pixel::BGRA8, Pixel::RGB8>(bytes.data(), SizeT(Width) * Height);
+
+	ARC_EXPECT(std::memcmp(rgb.getImageData(), expectedRGB.data(), expectedRGB.size()) == 0);
+
+	//Decoder output is converted while loading
+	Image<Pixel::BGRA8> decoded = source;
+	RawImage raw = decoded.makeRaw();
+	Image<Pixel::RGBA8> loaded = Image<Pixel::RGBA8>::fromRaw(raw);
+
+	ARC_EXPECT(loaded.getWidth() == Width && std::memcmp(loaded.getImageData(), expected.data(), expected.size()) == 0);
+
+}
\ No newline at end of file
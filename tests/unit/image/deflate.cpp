@@ -0,0 +1,120 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 deflate.cpp
+ */
+
+#include "framework/test.hpp"
+#include "image/encode/deflate.hpp"
+#include "image/decode/inflate.hpp"
+
+#include <vector>
+
+
+
+static std::vector<u8> noise(SizeT size) {
+
+	std::vector<u8> data(size);
+	u32 state = 99;
+
+	for (u8& byte : data) {
+
+		state = state * 1103515245 + 12345;
+		byte = state >> 16;
+
+	}
+
+	return data;
+
+}
+
+
+
+//Words from a small vocabulary, compressible like text
+static std::vector<u8> text(SizeT size) {
+
+	const char* words[] = {"arclight ", "engine ", "deflate ", "window ", "match ", "literal ", "huffman ", "block\n"};
+
+	std::vector<u8> data;
+	u32 state = 5;
+
+	while (data.size() < size) {
+
+		state = state * 1103515245 + 12345;
+
+		for (const char* c = words[(state >> 16) % 8]; *c && data.size() < size; c++) {
+			data.push_back(*c);
+		}
+
+	}
+
+	return data;
+
+}
+
+
+
+static std::vector<u8> compress(std::span<const u8> input, Deflater::Level level) {
+
+	std::vector<u8> output;
+	Deflater(level).deflate(input, output);
+
+	return output;
+
+}
+
+
+
+ARC_TEST(RoundTrip) {
+
+	std::vector<std::vector<u8>> inputs = {
+		{},
+		{42},
+		noise(100000),
+		text(300000),
+		std::vector<u8>(1 << 20, 0xAB)
+	};
+
+	Inflater inflater;
+
+	for (Deflater::Level level : {Deflater::Level::Store, Deflater::Level::Fast, Deflater::Level::Default, Deflater::Level::Best}) {
+
+		for (const std::vector<u8>& input : inputs) {
+
+			std::vector<u8> compressed = compress(input, level);
+			std::vector<u8> output(input.size());
+
+			inflater.inflate(compressed, output);
+
+			ARC_EXPECT(output == input);
+
+		}
+
+	}
+
+}
+
+
+
+ARC_TEST(CompressionRatio) {
+
+	std::vector<u8> zeros(1 << 20, 0);
+	std::vector<u8> random = noise(100000);
+	std::vector<u8> words = text(300000);
+
+	//Stored blocks add 5 bytes per 64 KB block plus the zlib header and trailer, incompressible data falls back to them
+	ARC_EXPECT(compress(random, Deflater::Level::Store).size() == random.size() + 5 * 2 + 6);
+	ARC_EXPECT(compress(random, Deflater::Level::Best).size() <= random.size() + 64);
+
+	ARC_EXPECT(compress(zeros, Deflater::Level::Fast).size() < zeros.size() / 200);
+	ARC_EXPECT(compress(zeros, Deflater::Level::Default).size() < zeros.size() / 1000);
+
+	SizeT fast = compress(words, Deflater::Level::Fast).size();
+	SizeT best = compress(words, Deflater::Level::Best).size();
+
+	ARC_EXPECT(fast < words.size() / 2);
+	ARC_EXPECT(best <= fast);
+
+}
\ No newline at end of file
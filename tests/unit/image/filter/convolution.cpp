@@ -0,0 +1,208 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 convolution.cpp
+ */
+
+#include "framework/test.hpp"
+#include "image/filter/convolution.hpp"
+#include "concurrent/threadpool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+
+
+using Filter = ConvolutionFilter;
+
+
+static Image<Pixel::RGBA8> createImage(u32 width, u32 height) {
+
+	Image<Pixel::RGBA8> image(width, height);
+	u32 state = 3;
+
+	for (u32 y = 0; y < height; y++) {
+
+		for (u32 x = 0; x < width; x++) {
+
+			state = state * 1103515245 + 12345;
+			image.setPixel(x, y, PixelRGBA8(x * 5, (state >> 16) & 0xFF, (x * y) & 0xFF, y * 3));
+
+		}
+
+	}
+
+	return image;
+
+}
+
+
+
+/*
+	Direct double precision convolution of a single channel as done by the original 3x3 filter.
+	Repeat wraps around, Clamp extends the border and Ignore skips samples outside of the image.
+	Results are normalized by the absolute weights that were applied and rounded.
+*/
+static u32 reference(const Image<Pixel::RGBA8>& image, u32 channel, const ConvolutionKernel& kernel, Filter::EdgeHandling edgeType, u32 x, u32 y) {
+
+	i64 width = image.getWidth();
+	i64 height = image.getHeight();
+
+	double sum = 0;
+	double norm = 0;
+
+	for (u32 ky = 0; ky < kernel.getHeight(); ky++) {
+
+		for (u32 kx = 0; kx < kernel.getWidth(); kx++) {
+
+			i64 sx = i64(x) + kx - kernel.getWidth() / 2;
+			i64 sy = i64(y) + ky - kernel.getHeight() / 2;
+
+			if (edgeType == Filter::Ignore && (sx < 0 || sy < 0 || sx >= width || sy >= height)) {
+				continue;
+			}
+
+			if (edgeType == Filter::Repeat) {
+
+				sx = (sx % width + width) % width;
+				sy = (sy % height + height) % height;
+
+			} else {
+
+				sx = std::clamp(sx, i64(0), width - 1);
+				sy = std::clamp(sy, i64(0), height - 1);
+
+			}
+
+			double weight = kernel.get(kx, ky);
+
+			sum += weight * image.getImageData()[(sy * width + sx) * 4 + channel];
+			norm += std::abs(weight);
+
+		}
+
+	}
+
+	return norm ? u32(std::abs(sum / norm) + 0.5) : 0;
+
+}
+
+
+
+//Returns the largest deviation from the reference, unselected channels have to stay untouched
+static u32 maxError(const ConvolutionKernel& kernel, Filter::EdgeHandling edgeType, u32 channels = Filter::Red | Filter::Green | Filter::Blue, ThreadPool* threadPool = nullptr) {
+
+	Image<Pixel::RGBA8> source = createImage(157, 93);
+	Image<Pixel::RGBA8> image = source;
+
+	Filter::run(image, kernel, channels, edgeType, threadPool);
+
+	u32 error = 0;
+
+	for (u32 y = 0; y < image.getHeight(); y++) {
+
+		for (u32 x = 0; x < image.getWidth(); x++) {
+
+			for (u32 c = 0; c < 4; c++) {
+
+				SizeT index = (SizeT(y) * image.getWidth() + x) * 4 + c;
+				u32 expected = channels & (1 << c) ? reference(source, c, kernel, edgeType, x, y) : source.getImageData()[index];
+
+				error = std::max<u32>(error, std::abs(i32(image.getImageData()[index]) - i32(expected)));
+
+			}
+
+		}
+
+	}
+
+	return error;
+
+}
+
+
+
+ARC_TEST(Mat3Kernels) {
+
+	Mat3<double> blur(1, 2, 1, 2, 4, 2, 1, 2, 1);
+	Mat3<double> sharpen(0, -1, 0, -1, 5, -1, 0, -1, 0);
+	Mat3<double> sobel(1, 0, -1, 2, 0, -2, 1, 0, -1);
+
+	for (Filter::EdgeHandling edgeType : {Filter::Repeat, Filter::Clamp, Filter::Ignore}) {
+
+		ARC_EXPECT(maxError(ConvolutionKernel(blur), edgeType) <= 1);
+		ARC_EXPECT(maxError(ConvolutionKernel(sharpen), edgeType) <= 1);
+		ARC_EXPECT(maxError(ConvolutionKernel(sobel), edgeType) <= 1);
+
+	}
+
+	ARC_EXPECT(ConvolutionKernel(blur).isSeparable());
+	ARC_EXPECT(!ConvolutionKernel(sharpen).isSeparable());
+
+}
+
+
+
+ARC_TEST(LargeKernels) {
+
+	ConvolutionKernel gaussian = ConvolutionKernel::gaussian(2.0);
+	ConvolutionKernel box = ConvolutionKernel::box(7, 3);
+
+	std::vector<double> weights(25);
+
+	for (SizeT i = 0; i < weights.size(); i++) {
+		weights[i] = std::sin(i * 0.7);
+	}
+
+	ConvolutionKernel general(5, 5, weights);
+
+	ARC_EXPECT(gaussian.isSeparable());
+	ARC_EXPECT(box.isSeparable());
+	ARC_EXPECT(!general.isSeparable());
+
+	for (Filter::EdgeHandling edgeType : {Filter::Repeat, Filter::Clamp, Filter::Ignore}) {
+
+		ARC_EXPECT(maxError(gaussian, edgeType) <= 1);
+		ARC_EXPECT(maxError(box, edgeType) <= 1);
+		ARC_EXPECT(maxError(general, edgeType) <= 1);
+
+	}
+
+	//A kernel wider than the fixed point limit takes the float path
+	ARC_EXPECT(maxError(ConvolutionKernel::box(81, 1), Filter::Clamp) <= 1);
+
+}
+
+
+
+ARC_TEST(ChannelSelection) {
+
+	ConvolutionKernel gaussian = ConvolutionKernel::gaussian(1.0);
+
+	ARC_EXPECT(maxError(gaussian, Filter::Clamp, Filter::Alpha) <= 1);
+	ARC_EXPECT(maxError(gaussian, Filter::Clamp, Filter::Red | Filter::Blue) <= 1);
+	ARC_EXPECT(maxError(gaussian, Filter::Clamp, Filter::Red | Filter::Green | Filter::Blue | Filter::Alpha) <= 1);
+
+}
+
+
+
+ARC_TEST(ThreadedMatchesSerial) {
+
+	ThreadPool pool(4);
+	Image<Pixel::RGBA8> serial = createImage(1200, 300);
+	Image<Pixel::RGBA8> parallel = serial;
+
+	ConvolutionKernel gaussian = ConvolutionKernel::gaussian(1.5);
+
+	Filter::run(serial, gaussian, Filter::Red | Filter::Green | Filter::Blue, Filter::Repeat);
+	Filter::run(parallel, gaussian, Filter::Red | Filter::Green | Filter::Blue, Filter::Repeat, &pool);
+
+	ARC_EXPECT(std::equal(serial.getImageData(), serial.getImageData() + serial.pixelCount() * 4, parallel.getImageData()));
+
+	ARC_EXPECT(maxError(gaussian, Filter::Ignore, Filter::Red, &pool) <= 1);
+
+}
\ No newline at end of file
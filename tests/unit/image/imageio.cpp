@@ -0,0 +1,190 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 imageio.cpp
+ */
+
+#include "framework/test.hpp"
+#include "image/imageio.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <vector>
+
+
+
+constexpr u32 Width = 123;
+constexpr u32 Height = 77;
+
+
+//Smooth gradients with sharp noise in the lower half, which exercises runs, matches and literals alike
+static Image<Pixel::RGBA8> createImage(bool noisy = true) {
+
+	Image<Pixel::RGBA8> image(Width, Height);
+	u32 state = 7;
+
+	for (u32 y = 0; y < Height; y++) {
+
+		for (u32 x = 0; x < Width; x++) {
+
+			state = state * 1103515245 + 12345;
+			u8 noise = noisy && y >= Height / 2 ? (state >> 16) & 0x3F : 0;
+
+			image.setPixel(x, y, PixelRGBA8(x * 2 + noise, y * 3, (x + y) & 0xFF, x < 10 ? 0x80 : 0xFF));
+
+		}
+
+	}
+
+	return image;
+
+}
+
+
+
+template<Pixel P>
+static bool equal(const Image<P>& a, const Image<P>& b) {
+
+	if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) {
+		return false;
+	}
+
+	return std::equal(a.getImageData(), a.getImageData() + a.pixelCount() * Image<P>::PixelBytes, b.getImageData());
+
+}
+
+
+
+template<Pixel P, class Encoder, class Decoder>
+static bool roundTrip(const Image<Pixel::RGBA8>& source) {
+
+	Image<P> image = source.convert<P>();
+
+	std::vector<u8> data = ImageIO::save<Encoder>(image);
+	Image<P> decoded = ImageIO::load<P, Decoder>(data);
+
+	return equal(image, decoded);
+
+}
+
+
+
+ARC_TEST(PNGRoundTrip) {
+
+	Image<Pixel::RGBA8> image = createImage();
+
+	ARC_EXPECT((roundTrip<Pixel::RGBA8, PNGEncoder, PNGDecoder>(image)));
+	ARC_EXPECT((roundTrip<Pixel::RGB8, PNGEncoder, PNGDecoder>(image)));
+	ARC_EXPECT((roundTrip<Pixel::BGR8, PNGEncoder, PNGDecoder>(image)));
+	ARC_EXPECT((roundTrip<Pixel::Grayscale8, PNGEncoder, PNGDecoder>(image)));
+
+	//Every compression level produces a valid stream
+	for (Deflater::Level level : {Deflater::Level::Store, Deflater::Level::Fast, Deflater::Level::Best}) {
+
+		std::vector<u8> data = ImageIO::save<PNGEncoder>(image, level);
+		ARC_EXPECT(equal(image, ImageIO::load<Pixel::RGBA8, PNGDecoder>(data)));
+
+	}
+
+}
+
+
+
+ARC_TEST(QOIRoundTrip) {
+
+	Image<Pixel::RGBA8> image = createImage();
+
+	ARC_EXPECT((roundTrip<Pixel::RGBA8, QOIEncoder, QOIDecoder>(image)));
+	ARC_EXPECT((roundTrip<Pixel::RGB8, QOIEncoder, QOIDecoder>(image)));
+
+}
+
+
+
+//Returns the PSNR in dB of the JPEG round trip
+template<Pixel P>
+static double jpegPSNR(const Image<Pixel::RGBA8>& source, u32 quality, bool subsampling = true) {
+
+	Image<P> image = source.convert<P>();
+
+	std::vector<u8> data = ImageIO::save<JPEGEncoder>(image, quality, subsampling);
+	Image<P> decoded = ImageIO::load<P, JPEGDecoder>(data);
+
+	if (decoded.getWidth() != Width || decoded.getHeight() != Height) {
+		return 0;
+	}
+
+	SizeT size = image.pixelCount() * Image<P>::PixelBytes;
+	double error = 0;
+
+	for (SizeT i = 0; i < size; i++) {
+
+		double d = double(image.getImageData()[i]) - decoded.getImageData()[i];
+		error += d * d;
+
+	}
+
+	return 10 * std::log10(255.0 * 255.0 * size / std::max(error, 1.0));
+
+}
+
+
+
+ARC_TEST(JPEGRoundTrip) {
+
+	Image<Pixel::RGBA8> smooth = createImage(false);
+	Image<Pixel::RGBA8> noisy = createImage();
+
+	double low = jpegPSNR<Pixel::RGB8>(smooth, 50);
+	double high = jpegPSNR<Pixel::RGB8>(smooth, 95);
+
+	ARC_EXPECT(low > 38);
+	ARC_EXPECT(high > 45);
+	ARC_EXPECT(high > low);
+
+	//The noise is mostly chroma, which subsampling averages out
+	double subsampled = jpegPSNR<Pixel::RGB8>(noisy, 95);
+	double full = jpegPSNR<Pixel::RGB8>(noisy, 95, false);
+
+	ARC_EXPECT(subsampled > 22);
+	ARC_EXPECT(full > 35);
+
+	ARC_EXPECT(jpegPSNR<Pixel::Grayscale8>(noisy, 90) > 35);
+
+	std::vector<u8> small = ImageIO::save<JPEGEncoder>(noisy, 30u);
+	std::vector<u8> large = ImageIO::save<JPEGEncoder>(noisy, 95u);
+
+	ARC_EXPECT(small.size() < large.size());
+
+}
+
+
+
+ARC_TEST(ExtensionDispatch) {
+
+	Image<Pixel::RGB8> image = createImage().convert<Pixel::RGB8>();
+	std::filesystem::path directory = std::filesystem::temp_directory_path();
+
+	for (const char* name : {"arclight_imageio_test.png", "arclight_imageio_test.qoi", "arclight_imageio_test.ppm"}) {
+
+		Path path(directory / name);
+
+		ImageIO::save(path, image);
+		ARC_EXPECT(equal(image, ImageIO::load<Pixel::RGB8>(path)));
+
+		std::filesystem::remove(directory / name);
+
+	}
+
+	Path path(directory / "arclight_imageio_test.jpg");
+
+	ImageIO::save(path, image);
+	ARC_EXPECT(ImageIO::load<Pixel::RGB8>(path).getWidth() == Width);
+
+	std::filesystem::remove(directory / "arclight_imageio_test.jpg");
+
+	ARC_EXPECT_THROW(ImageIO::save(Path(directory / "arclight_imageio_test.xyz"), image), ImageException);
+
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 inflate.cpp
+ */
+
+#include "framework/test.hpp"
+#include "image/decode/inflate.hpp"
+
+#include <vector>
+
+
+
+/*
+	The fixtures are zlib streams written by zlib with a stored, fixed Huffman and dynamic Huffman block strategy.
+	The first half of the source is noise over 16 symbols, the second half repeats with a period of 251 bytes.
+*/
+static std::vector<u8> source() {
+
+	std::vector<u8> data(20000);
+	u32 state = 12345;
+
+	for (SizeT i = 0; i < data.size(); i++) {
+
+		if (i < data.size() / 2) {
+
+			state = state * 1103515245 + 12345;
+			data[i] = (state >> 16) & 0x0F;
+
+		} else {
+
+			data[i] = (i % 251) ^ ((i / 4096) & 0x0F);
+
+		}
+
+	}
+
+	return data;
+
+}
+
+
+
+ARC_TEST(BlockTypes) {
+
+	std::vector<u8> expected = source();
+	Inflater inflater;
+
+	for (const char* name : {"stored.zlib", "fixed.zlib", "dynamic.zlib"}) {
+
+		std::vector<u8> data = Test::readData(std::string("image/") + name);
+		std::vector<u8> output(expected.size());
+
+		inflater.inflate(data, output);
+
+		ARC_EXPECT(output == expected);
+
+	}
+
+}
+
+
+
+ARC_TEST(CorruptStreams) {
+
+	std::vector<u8> data = Test::readData("image/dynamic.zlib");
+	std::vector<u8> output(20000);
+	Inflater inflater;
+
+	//Adler-32 trailer
+	std::vector<u8> corrupt = data;
+	corrupt.back() ^= 1;
+
+	ARC_EXPECT_THROW(inflater.inflate(corrupt, output), ImageDecoderException);
+
+	corrupt = data;
+	corrupt.resize(data.size() / 2);
+
+	ARC_EXPECT_THROW(inflater.inflate(corrupt, output), ImageDecoderException);
+
+	//The output size is known up front, larger streams must not overrun it
+	output.resize(10000);
+
+	ARC_EXPECT_THROW(inflater.inflate(data, output), ImageDecoderException);
+
+}
\ No newline at end of file
@@ -0,0 +1,414 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 jpegdecoder.cpp
+ */
+
+#include "framework/test.hpp"
+#include "image/decode/jpegdecoder.hpp"
+#include "concurrent/threadpool.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+
+/*
+	baseline.jpg, restart.jpg and progressive.jpg are 77x53 4:2:0 images with identical quantized coefficients, encoded by libjpeg at quality 90.
+	444.jpg is the same image without subsampling, gray.jpg a 64x40 grayscale image.
+	large.jpg is 1920x1080 with a restart marker every 16 MCUs.
+	baseline.rgb is libjpeg's decode of baseline.jpg with the integer IDCT and fancy upsampling.
+*/
+static std::vector<u8> decode(const std::string& name, ThreadPool* threadPool = nullptr) {
+
+	std::vector<u8> data = Test::readData("image/" + name);
+
+	JPEGDecoder decoder(Pixel::RGB8, threadPool);
+	decoder.decode(data);
+
+	std::span<const u8> pixels = decoder.getImage().getRawBuffer();
+
+	return std::vector<u8>(pixels.begin(), pixels.end());
+
+}
+
+
+
+ARC_TEST(RestartIntervalsDecodeLikeBaseline) {
+
+	std::vector<u8> baseline = decode("baseline.jpg");
+	std::vector<u8> restart = decode("restart.jpg");
+
+	ARC_EXPECT(baseline.size() == 77 * 53 * 3);
+	ARC_EXPECT(std::any_of(baseline.begin(), baseline.end(), [](u8 v) { return v != 0; }));
+	ARC_EXPECT(restart == baseline);
+
+}
+
+
+
+ARC_TEST(ParallelRestartDecodeMatchesSerial) {
+
+	ThreadPool pool(4);
+
+	std::vector<u8> serial = decode("restart.jpg");
+	std::vector<u8> parallel = decode("restart.jpg", &pool);
+
+	ARC_EXPECT(parallel == serial);
+	ARC_EXPECT(decode("large.jpg", &pool) == decode("large.jpg"));
+
+	//Images without restart markers take the sequential path with a pool too
+	ARC_EXPECT(decode("baseline.jpg", &pool) == decode("baseline.jpg"));
+
+}
+
+
+
+ARC_TEST(ProgressiveDecodesLikeBaseline) {
+
+	std::vector<u8> data = Test::readData("image/progressive.jpg");
+
+	JPEGDecoder decoder(Pixel::RGB8);
+	decoder.decode(data);
+
+	std::span<const u8> pixels = decoder.getImage().getRawBuffer();
+
+	//libjpeg's simple progression script for YCbCr has 10 scans
+	ARC_EXPECT(decoder.getScanCount() == 10);
+	ARC_EXPECT(std::vector<u8>(pixels.begin(), pixels.end()) == decode("baseline.jpg"));
+
+}
+
+
+
+ARC_TEST(ScanLimitedPreview) {
+
+	std::vector<u8> data = Test::readData("image/progressive.jpg");
+	std::vector<u8> full = decode("baseline.jpg");
+
+	JPEGDecoder decoder(Pixel::RGB8);
+	decoder.setScanLimit(1);
+	decoder.decode(data);
+
+	RawImage& preview = decoder.getImage();
+	std::span<const u8> pixels = preview.getRawBuffer();
+
+	ARC_EXPECT(decoder.getScanCount() == 1);
+	ARC_EXPECT(preview.getWidth() == 77 && preview.getHeight() == 53);
+	ARC_EXPECT(pixels.size() == full.size());
+
+	//The first scan only carries the DC coefficients, which turns the gradients into steps of 8x8 luma and 16x16 chroma blocks
+	u64 error = 0;
+
+	for (SizeT i = 0; i < full.size() && i < pixels.size(); i++) {
+		error += std::abs(pixels[i] - full[i]);
+	}
+
+	ARC_EXPECT(error < full.size() * 16);
+	ARC_EXPECT(!std::equal(pixels.begin(), pixels.end(), full.begin(), full.end()));
+
+}
+
+
+
+//FNV-1a over the decoded pixels
+static u64 digest(const std::string& name, Pixel format) {
+
+	std::vector<u8> data = Test::readData("image/" + name);
+
+	JPEGDecoder decoder(format);
+	decoder.decode(data);
+
+	u64 hash = 0xCBF29CE484222325;
+
+	for (u8 byte : decoder.getImage().getRawBuffer()) {
+		hash = (hash ^ byte) * 0x100000001B3;
+	}
+
+	return hash;
+
+}
+
+
+
+ARC_TEST(DecodeCloseToLibjpeg) {
+
+	std::vector<u8> reference = Test::readData("image/baseline.rgb");
+	std::vector<u8> pixels = decode("baseline.jpg");
+
+	ARC_EXPECT(pixels.size() == reference.size());
+
+	u64 error = 0;
+	u32 maxError = 0;
+
+	for (SizeT i = 0; i < reference.size() && i < pixels.size(); i++) {
+
+		u32 e = std::abs(pixels[i] - reference[i]);
+		error += e;
+		maxError = std::max(maxError, e);
+
+	}
+
+	ARC_EXPECT(error < reference.size() * 3 / 2);
+	ARC_EXPECT(maxError <= 6);
+
+}
+
+
+
+/*
+	All kernels are bit-exact, so the output must not depend on the instruction set.
+	The test also runs with ARC_CPUID_DISABLE set, which checks the same digests on the fallback kernels.
+*/
+ARC_TEST(KernelsAreBitExact) {
+
+	ARC_EXPECT(digest("baseline.jpg", Pixel::RGB8) == 0x66428F65E1BA4077);
+	ARC_EXPECT(digest("444.jpg", Pixel::RGB8) == 0xA16D4E1263FE2C2B);
+	ARC_EXPECT(digest("progressive.jpg", Pixel::RGB8) == 0x66428F65E1BA4077);
+	ARC_EXPECT(digest("large.jpg", Pixel::RGB8) == 0xB03E5C693547ABDC);
+	ARC_EXPECT(digest("gray.jpg", Pixel::Grayscale8) == 0xED0333B8D8B0A953);
+
+}
+
+
+//Feeds the image in chunks of chunkSize bytes and reassembles the emitted rows
+static std::vector<u8> decodeStreamed(const std::string& name, SizeT chunkSize) {
+
+	std::vector<u8> data = Test::readData("image/" + name);
+	std::vector<u8> pixels;
+	u32 nextRow = 0;
+
+	JPEGDecoder decoder(Pixel::RGB8);
+
+	decoder.beginStream([&](const JPEGDecoder::RowBlock& block) {
+
+		ARC_EXPECT(block.format == Pixel::RGB8);
+		ARC_EXPECT(block.firstRow == nextRow);
+		ARC_EXPECT(block.pixels.size() == SizeT(block.width) * block.rowCount * 3);
+
+		pixels.insert(pixels.end(), block.pixels.begin(), block.pixels.end());
+		nextRow += block.rowCount;
+
+	});
+
+	for (SizeT i = 0; i < data.size(); i += chunkSize) {
+		decoder.feed(std::span<const u8>(data).subspan(i, std::min(chunkSize, data.size() - i)));
+	}
+
+	decoder.endStream();
+
+	return pixels;
+
+}
+
+
+
+ARC_TEST(StreamedDecodeMatchesFullDecode) {
+
+	for (const char* name : {"baseline.jpg", "restart.jpg", "444.jpg", "progressive.jpg"}) {
+
+		std::vector<u8> full = decode(name);
+
+		for (SizeT chunkSize : {SizeT(1), SizeT(7), SizeT(256), SizeT(1) << 20}) {
+			ARC_EXPECT(decodeStreamed(name, chunkSize) == full);
+		}
+
+	}
+
+	ARC_EXPECT(decodeStreamed("large.jpg", 4096) == decode("large.jpg"));
+
+}
+
+
+
+ARC_TEST(StreamedDecodeIsIncremental) {
+
+	constexpr SizeT ChunkSize = 256;
+
+	for (auto [name, height] : {std::pair<const char*, u32>("baseline.jpg", 53), std::pair<const char*, u32>("large.jpg", 1080)}) {
+
+		std::vector<u8> data = Test::readData(std::string("image/") + name);
+		u32 nextRow = 0;
+
+		JPEGDecoder decoder(Pixel::RGB8);
+		decoder.beginStream([&](const JPEGDecoder::RowBlock& block) { nextRow += block.rowCount; });
+
+		//4:2:0 MCUs span 16 rows
+		const u32 mcuRows = (height + 15) / 16;
+		const SizeT rowInputSize = data.size() / mcuRows;
+
+		//Rows have to be delivered once half of the entropy coded data following SOS has arrived
+		SizeT scanStart = 0;
+
+		while (scanStart + 1 < data.size() && !(data[scanStart] == 0xFF && data[scanStart + 1] == 0xDA)) {
+			scanStart++;
+		}
+
+		const SizeT halfScan = scanStart + (data.size() - scanStart) / 2;
+
+		SizeT maxInput = 0;
+		u32 maxWindow = 0;
+		bool finished = false;
+
+		for (SizeT i = 0; i < data.size(); i += ChunkSize) {
+
+			if (i >= halfScan && i < halfScan + ChunkSize) {
+				ARC_EXPECT(nextRow > 0 && nextRow < height && !finished);
+			}
+
+			finished = decoder.feed(std::span<const u8>(data).subspan(i, std::min(ChunkSize, data.size() - i)));
+
+			maxInput = std::max(maxInput, decoder.getStreamInputSize());
+			maxWindow = std::max(maxWindow, decoder.getStreamWindowRows());
+
+		}
+
+		//EOI completes the image without waiting for endStream()
+		ARC_EXPECT(finished && nextRow == height);
+
+		//A single MCU row of samples and a few rows of undecoded input are resident
+		ARC_EXPECT(maxWindow == 16);
+		ARC_EXPECT(maxInput <= ChunkSize + 4 * rowInputSize);
+
+		decoder.endStream();
+
+	}
+
+}
+
+
+
+ARC_TEST(StreamedDecodeRejectsTruncatedInput) {
+
+	std::vector<u8> data = Test::readData("image/baseline.jpg");
+	data.resize(data.size() / 2);
+
+	JPEGDecoder decoder(Pixel::RGB8);
+	decoder.beginStream([](const JPEGDecoder::RowBlock&) {});
+
+	ARC_EXPECT(!decoder.feed(data));
+	ARC_EXPECT_THROW(decoder.endStream(), ImageDecoderException);
+
+}
+
+
+static RawImage decodeScaled(const std::string& name, u32 denominator, ThreadPool* threadPool = nullptr) {
+
+	std::vector<u8> data = Test::readData("image/" + name);
+
+	JPEGDecoder decoder(Pixel::RGB8, threadPool);
+	decoder.setScale(denominator);
+	decoder.decode(data);
+
+	return decoder.getImage();
+
+}
+
+
+
+//Returns the mean error of the scaled decode against the average of the covered full size pixels
+static double scaledError(const std::string& name, u32 fullWidth, u32 fullHeight, u32 denominator) {
+
+	std::vector<u8> full = decode(name);
+	RawImage image = decodeScaled(name, denominator);
+	std::span<const u8> pixels = image.getRawBuffer();
+
+	u32 width = (fullWidth + denominator - 1) / denominator;
+	u32 height = (fullHeight + denominator - 1) / denominator;
+
+	ARC_EXPECT(image.getWidth() == width);
+	ARC_EXPECT(image.getHeight() == height);
+
+	if (pixels.size() != SizeT(width) * height * 3 || full.size() != SizeT(fullWidth) * fullHeight * 3) {
+		return 255;
+	}
+
+	u64 error = 0;
+
+	for (u32 y = 0; y < height; y++) {
+
+		for (u32 x = 0; x < width; x++) {
+
+			for (u32 c = 0; c < 3; c++) {
+
+				u32 sum = 0;
+				u32 count = 0;
+
+				for (u32 sy = y * denominator; sy < std::min((y + 1) * denominator, fullHeight); sy++) {
+
+					for (u32 sx = x * denominator; sx < std::min((x + 1) * denominator, fullWidth); sx++) {
+
+						sum += full[(SizeT(sy) * fullWidth + sx) * 3 + c];
+						count++;
+
+					}
+
+				}
+
+				error += std::abs(i32(pixels[(SizeT(y) * width + x) * 3 + c]) - i32((sum + count / 2) / count));
+
+			}
+
+		}
+
+	}
+
+	return double(error) / pixels.size();
+
+}
+
+
+
+ARC_TEST(ScaledDecodeApproximatesBoxFilter) {
+
+	for (u32 denominator : {2u, 4u, 8u}) {
+
+		//Chroma of the small image is subsampled to few samples and its partial edge blocks average padding, hence the larger error
+		ARC_EXPECT(scaledError("large.jpg", 1920, 1080, denominator) < 1);
+		ARC_EXPECT(scaledError("baseline.jpg", 77, 53, denominator) < denominator * 1.25);
+
+	}
+
+	ARC_EXPECT_THROW(JPEGDecoder(Pixel::RGB8).setScale(3), ImageDecoderException);
+
+}
+
+
+
+ARC_TEST(ScaledDecodeIsIndependentOfPath) {
+
+	ThreadPool pool(4);
+
+	for (u32 denominator : {2u, 4u, 8u}) {
+
+		RawImage baseline = decodeScaled("baseline.jpg", denominator);
+		RawImage progressive = decodeScaled("progressive.jpg", denominator);
+		RawImage restart = decodeScaled("restart.jpg", denominator, &pool);
+
+		std::span<const u8> expected = baseline.getRawBuffer();
+
+		ARC_EXPECT(std::ranges::equal(progressive.getRawBuffer(), expected));
+		ARC_EXPECT(std::ranges::equal(restart.getRawBuffer(), expected));
+
+		std::vector<u8> data = Test::readData("image/baseline.jpg");
+		std::vector<u8> streamed;
+
+		JPEGDecoder decoder(Pixel::RGB8);
+		decoder.setScale(denominator);
+		decoder.beginStream([&streamed](const JPEGDecoder::RowBlock& block) {
+			streamed.insert(streamed.end(), block.pixels.begin(), block.pixels.end());
+		});
+
+		decoder.feed(data);
+		decoder.endStream();
+
+		ARC_EXPECT(std::ranges::equal(streamed, expected));
+
+	}
+
+}
\ No newline at end of file
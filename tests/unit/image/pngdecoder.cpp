@@ -0,0 +1,175 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 pngdecoder.cpp
+ */
+
+#include "framework/test.hpp"
+#include "image/decode/pngdecoder.hpp"
+
+#include <array>
+#include <vector>
+
+
+
+/*
+	The fixtures are 61x37 images written by libpng with all filter types enabled.
+	Sample values follow the pattern below, palette images use entry (x + y) % 16.
+*/
+constexpr u32 Width = 61;
+constexpr u32 Height = 37;
+
+static std::array<u8, 4> pattern(u32 x, u32 y) {
+	return {u8(x * 7 + y * 3), u8(x * y), u8((x ^ y) * 5), u8(x + y * 11)};
+}
+
+
+
+static RawImage decode(const std::string& name, Pixel format) {
+
+	std::vector<u8> data = Test::readData("image/" + name);
+
+	PNGDecoder decoder(format);
+	decoder.decode(data);
+
+	RawImage& image = decoder.getImage();
+
+	ARC_EXPECT(image.getWidth() == Width);
+	ARC_EXPECT(image.getHeight() == Height);
+	ARC_EXPECT(image.getFormat() == format);
+
+	return image;
+
+}
+
+
+
+//Checks every pixel against expected(x, y), which returns the channels in the order of format
+template<class Function>
+static bool matches(const RawImage& image, u32 channels, Function&& expected) {
+
+	std::span<const u8> pixels = image.getRawBuffer();
+
+	if (pixels.size() != SizeT(Width) * Height * channels) {
+		return false;
+	}
+
+	for (u32 y = 0; y < Height; y++) {
+
+		for (u32 x = 0; x < Width; x++) {
+
+			std::array<u8, 4> pixel = expected(x, y);
+
+			for (u32 c = 0; c < channels; c++) {
+
+				if (pixels[(y * Width + x) * channels + c] != pixel[c]) {
+					return false;
+				}
+
+			}
+
+		}
+
+	}
+
+	return true;
+
+}
+
+
+
+ARC_TEST(TrueColor) {
+
+	ARC_EXPECT(matches(decode("rgb.png", Pixel::RGB8), 3, pattern));
+	ARC_EXPECT(matches(decode("rgba.png", Pixel::RGBA8), 4, pattern));
+
+	//Converted on output
+	ARC_EXPECT(matches(decode("rgb.png", Pixel::RGBA8), 4, [](u32 x, u32 y) {
+
+		std::array<u8, 4> p = pattern(x, y);
+		return std::array<u8, 4>{p[0], p[1], p[2], 0xFF};
+
+	}));
+
+	ARC_EXPECT(matches(decode("rgba.png", Pixel::BGR8), 3, [](u32 x, u32 y) {
+
+		std::array<u8, 4> p = pattern(x, y);
+		return std::array<u8, 4>{p[2], p[1], p[0], 0};
+
+	}));
+
+}
+
+
+
+ARC_TEST(Grayscale) {
+
+	ARC_EXPECT(matches(decode("gray.png", Pixel::Grayscale8), 1, pattern));
+
+}
+
+
+
+ARC_TEST(Palette) {
+
+	ARC_EXPECT(matches(decode("palette.png", Pixel::RGB8), 3, [](u32 x, u32 y) {
+
+		u32 index = (x + y) % 16;
+		return std::array<u8, 4>{u8(index * 17), u8(255 - index * 17), u8(index * 53), 0};
+
+	}));
+
+}
+
+
+
+ARC_TEST(Interlaced) {
+
+	ARC_EXPECT(matches(decode("interlaced.png", Pixel::RGB8), 3, pattern));
+
+}
+
+
+
+ARC_TEST(SixteenBit) {
+
+	//Samples were stored as value * 257 + x and are reduced to their high byte
+	ARC_EXPECT(matches(decode("rgb16.png", Pixel::RGB8), 3, [](u32 x, u32 y) {
+
+		std::array<u8, 4> p = pattern(x, y);
+
+		for (u8& c : p) {
+			c = u16(c * 257 + x) >> 8;
+		}
+
+		return p;
+
+	}));
+
+}
+
+
+
+ARC_TEST(CorruptData) {
+
+	std::vector<u8> data = Test::readData("image/rgb.png");
+
+	//IHDR payload, caught by the chunk CRC
+	std::vector<u8> corrupt = data;
+	corrupt[20] ^= 1;
+
+	ARC_EXPECT_THROW(PNGDecoder(Pixel::RGB8).decode(corrupt), ImageDecoderException);
+
+	corrupt = data;
+	corrupt.resize(data.size() / 2);
+
+	ARC_EXPECT_THROW(PNGDecoder(Pixel::RGB8).decode(corrupt), ImageDecoderException);
+
+	corrupt = data;
+	corrupt[0] = 0;
+
+	ARC_EXPECT_THROW(PNGDecoder(Pixel::RGB8).decode(corrupt), ImageDecoderException);
+
+}
\ No newline at end of file
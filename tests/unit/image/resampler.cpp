@@ -0,0 +1,270 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 resampler.cpp
+ */
+
+#include "framework/test.hpp"
+#include "image/image.hpp"
+#include "concurrent/threadpool.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+
+
+static std::vector<u8> createImage(u32 width, u32 height, u32 channels) {
+
+	std::vector<u8> pixels(SizeT(width) * height * channels);
+	u32 state = 11;
+
+	for (u32 y = 0; y < height; y++) {
+
+		for (u32 x = 0; x < width; x++) {
+
+			state = state * 1103515245 + 12345;
+
+			u8* p = &pixels[(SizeT(y) * width + x) * channels];
+			u8 values[4] = {u8(x * 3), u8(y * 5), u8((state >> 16) & 0xFF), u8(x * y)};
+
+			std::copy_n(values, channels, p);
+
+		}
+
+	}
+
+	return pixels;
+
+}
+
+
+
+static double filter(ImageScaling scaling, double x) {
+
+	x = std::abs(x);
+
+	if (scaling == ImageScaling::Bicubic) {
+
+		//Keys cubic with a = -0.5
+		if (x < 1) {
+			return 1.5 * x * x * x - 2.5 * x * x + 1;
+		} else if (x < 2) {
+			return -0.5 * x * x * x + 2.5 * x * x - 4 * x + 2;
+		}
+
+		return 0;
+
+	}
+
+	if (x == 0) {
+		return 1;
+	} else if (x >= 3) {
+		return 0;
+	}
+
+	double px = std::numbers::pi * x;
+
+	return 3 * std::sin(px) * std::sin(px / 3) / (px * px);
+
+}
+
+
+
+//Normalized weights of all source samples for target sample x, filters are widened by the scale when downsampling
+static std::vector<double> weights(ImageScaling scaling, u32 sourceSize, u32 targetSize, u32 x) {
+
+	double scale = double(sourceSize) / targetSize;
+	std::vector<double> w(sourceSize, 0);
+	double sum = 0;
+
+	for (u32 i = 0; i < sourceSize; i++) {
+
+		if (scaling == ImageScaling::Area) {
+			w[i] = std::max(std::min((x + 1) * scale, i + 1.0) - std::max(x * scale, double(i)), 0.0);
+		} else {
+			w[i] = filter(scaling, (i + 0.5 - (x + 0.5) * scale) / std::max(scale, 1.0));
+		}
+
+		sum += w[i];
+
+	}
+
+	for (double& v : w) {
+		v /= sum;
+	}
+
+	return w;
+
+}
+
+
+
+//Double precision separable resampling, clipped to the image
+static std::vector<u8> reference(ImageScaling scaling, const std::vector<u8>& source, u32 sw, u32 sh, u32 tw, u32 th, u32 channels) {
+
+	std::vector<double> rows(SizeT(tw) * sh * channels, 0);
+
+	for (u32 x = 0; x < tw; x++) {
+
+		std::vector<double> w = weights(scaling, sw, tw, x);
+
+		for (u32 y = 0; y < sh; y++) {
+
+			for (u32 i = 0; i < sw; i++) {
+
+				for (u32 c = 0; c < channels; c++) {
+					rows[(SizeT(y) * tw + x) * channels + c] += w[i] * source[(SizeT(y) * sw + i) * channels + c];
+				}
+
+			}
+
+		}
+
+	}
+
+	std::vector<u8> target(SizeT(tw) * th * channels);
+
+	for (u32 y = 0; y < th; y++) {
+
+		std::vector<double> w = weights(scaling, sh, th, y);
+
+		for (u32 x = 0; x < tw; x++) {
+
+			for (u32 c = 0; c < channels; c++) {
+
+				double sum = 0;
+
+				for (u32 j = 0; j < sh; j++) {
+					sum += w[j] * rows[(SizeT(j) * tw + x) * channels + c];
+				}
+
+				target[(SizeT(y) * tw + x) * channels + c] = u8(std::clamp(std::round(sum), 0.0, 255.0));
+
+			}
+
+		}
+
+	}
+
+	return target;
+
+}
+
+
+
+static u32 maxError(ImageScaling scaling, u32 sw, u32 sh, u32 tw, u32 th, u32 channels) {
+
+	std::vector<u8> source = createImage(sw, sh, channels);
+	std::vector<u8> target(SizeT(tw) * th * channels);
+
+	ImageResampler resampler(scaling, sw, sh, tw, th, channels);
+	resampler.run(source, target);
+
+	std::vector<u8> expected = reference(scaling, source, sw, sh, tw, th, channels);
+	u32 error = 0;
+
+	for (SizeT i = 0; i < target.size(); i++) {
+		error = std::max<u32>(error, std::abs(i32(target[i]) - expected[i]));
+	}
+
+	return error;
+
+}
+
+
+
+ARC_TEST(MatchesReference) {
+
+	for (ImageScaling scaling : {ImageScaling::Bicubic, ImageScaling::Lanczos3, ImageScaling::Area}) {
+
+		//Down, up, mixed and non-integer factors
+		ARC_EXPECT(maxError(scaling, 97, 61, 31, 20, 3) <= 2);
+		ARC_EXPECT(maxError(scaling, 40, 30, 113, 71, 4) <= 2);
+		ARC_EXPECT(maxError(scaling, 80, 20, 33, 47, 1) <= 2);
+		ARC_EXPECT(maxError(scaling, 64, 64, 64, 64, 2) <= 2);
+
+	}
+
+}
+
+
+
+ARC_TEST(ConstantImagesStayConstant) {
+
+	for (ImageScaling scaling : {ImageScaling::Nearest, ImageScaling::Bilinear, ImageScaling::Bicubic, ImageScaling::Lanczos3, ImageScaling::Area}) {
+
+		Image<Pixel::RGBA8> image(90, 50, PixelRGBA8(12, 200, 255, 0));
+		image.resize(scaling, 37, 77);
+
+		ARC_EXPECT(image.getWidth() == 37 && image.getHeight() == 77);
+
+		for (const PixelRGBA8& pixel : image.getImageBuffer()) {
+
+			if (pixel.getRed() != 12 || pixel.getGreen() != 200 || pixel.getBlue() != 255 || pixel.getAlpha() != 0) {
+
+				ARC_EXPECT(!"Pixel changed");
+				break;
+
+			}
+
+		}
+
+	}
+
+}
+
+
+
+ARC_TEST(AreaHalvingAveragesBlocks) {
+
+	std::vector<u8> source = createImage(64, 48, 1);
+	std::vector<u8> target(32 * 24);
+
+	ImageResampler(ImageScaling::Area, 64, 48, 32, 24, 1).run(source, target);
+
+	u32 error = 0;
+
+	for (u32 y = 0; y < 24; y++) {
+
+		for (u32 x = 0; x < 32; x++) {
+
+			u32 sum = source[(y * 2) * 64 + x * 2] + source[(y * 2) * 64 + x * 2 + 1] + source[(y * 2 + 1) * 64 + x * 2] + source[(y * 2 + 1) * 64 + x * 2 + 1];
+			error = std::max<u32>(error, std::abs(i32(target[y * 32 + x]) - i32((sum + 2) / 4)));
+
+		}
+
+	}
+
+	ARC_EXPECT(error <= 1);
+
+}
+
+
+
+ARC_TEST(ThreadedAndInPlace) {
+
+	ThreadPool pool(4);
+
+	std::vector<u8> source = createImage(1000, 700, 3);
+	std::vector<u8> serial(400 * 300 * 3);
+	std::vector<u8> parallel(serial.size());
+
+	ImageResampler resampler(ImageScaling::Lanczos3, 1000, 700, 400, 300, 3);
+
+	resampler.run(source, serial);
+	resampler.run(source, parallel, &pool);
+
+	ARC_EXPECT(serial == parallel);
+
+	//Shrinking in place
+	resampler.run(source, std::span<u8>(source).first(serial.size()));
+
+	ARC_EXPECT(std::equal(serial.begin(), serial.end(), source.begin()));
+
+	ARC_EXPECT_THROW(ImageResampler(ImageScaling::Bilinear, 10, 10, 5, 5, 3), ImageException);
+
+}
\ No newline at end of file
@@ -0,0 +1,220 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 arenadocument.cpp
+ */
+
+#include "framework/test.hpp"
+#include "json/arenadocument.hpp"
+#include "json/document.hpp"
+
+#include <algorithm>
+#include <string>
+
+
+
+static bool equal(const JsonValue& a, const JsonValue& b);
+
+static bool equal(const JsonArray& a, const JsonArray& b) {
+
+	auto it = b.begin();
+
+	for (const JsonValue& value : a) {
+
+		if (it == b.end() || !equal(value, *it++)) {
+			return false;
+		}
+
+	}
+
+	return it == b.end();
+
+}
+
+static bool equal(const JsonObject& a, const JsonObject& b) {
+
+	auto it = b.begin();
+
+	for (const auto& [name, value] : a) {
+
+		if (it == b.end() || it->first != name || !equal(value, it->second)) {
+			return false;
+		}
+
+		it++;
+
+	}
+
+	return it == b.end();
+
+}
+
+static bool equal(const JsonValue& a, const JsonValue& b) {
+
+	if (a.getType() != b.getType()) {
+		return false;
+	}
+
+	switch (a.getType()) {
+
+		case Json::Type::String:	return a.toString() == b.toString();
+		case Json::Type::Boolean:	return a.toBoolean() == b.toBoolean();
+		case Json::Type::Array:		return equal(a.toArray(), b.toArray());
+		case Json::Type::Object:	return equal(a.toObject(), b.toObject());
+
+		case Json::Type::Number:
+
+			if (a.isInteger() != b.isInteger()) {
+				return false;
+			}
+
+			return a.isInteger() ? a.toNumber<i64>() == b.toNumber<i64>() : a.toNumber<double>() == b.toNumber<double>();
+
+		default:					return true;
+
+	}
+
+}
+
+
+
+static constexpr const char* Mixed = R"({
+	"name": "arena", "escaped": "tab\there é 😀", "empty": "",
+	"numbers": [0, -1, 9223372036854775807, 18446744073709551616, 1.5e-7, -0.0],
+	"flags": [true, false, null], "nested": {"z": [[], {}], "a": {"b": [1, {"c": "d"}]}},
+	// Comment
+	"records": [{"id": 1, "tags": ["x", "y"]}, {"id": 2, "tags": []}]
+})";
+
+
+
+ARC_TEST(MatchesDocument) {
+
+	JsonArenaDocument arena(Mixed);
+	JsonDocument document(Mixed);
+
+	ARC_EXPECT(arena.getRoot().isObject());
+	ARC_EXPECT(equal(arena.getRoot().toValue(), JsonValue(document.getRoot())));
+
+	const JsonNode& root = arena.getRoot();
+
+	ARC_EXPECT(root["escaped"].toString() == "tab\there \xC3\xA9 \xF0\x9F\x98\x80");
+	ARC_EXPECT(root["numbers"][2].isInteger() && root["numbers"][3].isFloat());
+	ARC_EXPECT(root["nested"]["a"]["b"][1]["c"].toString() == "d");
+	ARC_EXPECT(root["records"].size() == 2 && root["records"][1]["tags"].size() == 0);
+
+	//Members are sorted by name
+	std::span<const JsonMember> members = root.toObject();
+
+	ARC_EXPECT(std::is_sorted(members.begin(), members.end(), [](const JsonMember& a, const JsonMember& b) { return a.name < b.name; }));
+
+}
+
+
+
+ARC_TEST(Lookup) {
+
+	//Objects above the linear search limit are searched by bisection
+	std::string json = "{";
+
+	for (u32 i = 0; i < 300; i++) {
+		json += (i ? ", \"key" : "\"key") + std::to_string(i * 7919 % 300) + "\": " + std::to_string(i * 7919 % 300);
+	}
+
+	json += "}";
+
+	JsonArenaDocument document(json);
+	const JsonNode& root = document.getRoot();
+
+	ARC_EXPECT(root.size() == 300);
+
+	for (u32 i = 0; i < 300; i++) {
+
+		const JsonNode* node = root.find("key" + std::to_string(i));
+
+		if (!node || node->toNumber<u32>() != i) {
+
+			ARC_EXPECT(!"Member not found");
+			break;
+
+		}
+
+	}
+
+	ARC_EXPECT(!root.contains("key300") && !root.contains("") && !root.contains("key"));
+	ARC_EXPECT_THROW(root["missing"], JsonValueNotFoundException);
+	ARC_EXPECT_THROW(root[SizeT(0)], JsonTypeCastException);
+	ARC_EXPECT_THROW(root["key1"].toString(), JsonTypeCastException);
+
+	JsonArenaDocument small(R"({"b": 1, "a": 2})");
+
+	ARC_EXPECT(small.getRoot()["a"].toNumber<i32>() == 2 && small.getRoot().find("c") == nullptr);
+	ARC_EXPECT_THROW(small.getRoot()["b"][SizeT(0)], JsonTypeCastException);
+
+}
+
+
+
+ARC_TEST(SourceOwnership) {
+
+	std::string json = R"({"plain": "view", "escaped": "a\nb"})";
+
+	//Borrowed sources are referenced by plain strings
+	JsonArenaDocument borrowed(json, true);
+	Json::StringView plain = borrowed.getRoot()["plain"].toString();
+
+	ARC_EXPECT(plain == "view" && plain.data() >= json.data() && plain.data() < json.data() + json.size());
+
+	//Owned sources are copied, the document outlives the text
+	JsonArenaDocument owned;
+
+	{
+		std::string temporary = json;
+		owned.read(temporary);
+		std::fill(temporary.begin(), temporary.end(), 'x');
+	}
+
+	ARC_EXPECT(owned.getRoot()["plain"].toString() == "view");
+	ARC_EXPECT(owned.getRoot()["escaped"].toString() == "a\nb");
+
+}
+
+
+
+ARC_TEST(Lifetime) {
+
+	JsonArenaDocument document;
+
+	ARC_EXPECT(document.empty());
+
+	document.read(Mixed);
+	SizeT usage = document.getMemoryUsage();
+
+	ARC_EXPECT(!document.empty() && usage > 0);
+
+	//Re-reading replaces the previous contents
+	document.read("[1, 2, 3]");
+
+	ARC_EXPECT(document.getRoot().isArray() && document.getRoot()[2].toNumber<i32>() == 3);
+
+	JsonArenaDocument moved = std::move(document);
+
+	ARC_EXPECT(moved.getRoot().size() == 3);
+
+	moved.clear();
+
+	ARC_EXPECT(moved.empty() && moved.getMemoryUsage() == 0);
+
+	ARC_EXPECT_THROW(moved.read(R"({"a": 1, "a": 2})"), JsonSyntaxError);
+	ARC_EXPECT_THROW(moved.read(R"({"a": [1, 2})"), JsonSyntaxError);
+	ARC_EXPECT_THROW(moved.read(R"({"a": 1} 2)"), JsonSyntaxError);
+	ARC_EXPECT_THROW(moved.read(R"("open)"), JsonSyntaxError);
+
+	//A failed read leaves the document usable
+	moved.read("{\"ok\": true}");
+
+	ARC_EXPECT(moved.getRoot()["ok"].toBoolean());
+
+}
\ No newline at end of file
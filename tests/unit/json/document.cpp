@@ -0,0 +1,210 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 document.cpp
+ */
+
+#include "framework/test.hpp"
+#include "json/document.hpp"
+
+#include <limits>
+#include <string>
+
+
+
+static bool equal(const JsonValue& a, const JsonValue& b);
+
+static bool equal(const JsonArray& a, const JsonArray& b) {
+
+	auto it = b.begin();
+
+	for (const JsonValue& value : a) {
+
+		if (it == b.end() || !equal(value, *it++)) {
+			return false;
+		}
+
+	}
+
+	return it == b.end();
+
+}
+
+static bool equal(const JsonObject& a, const JsonObject& b) {
+
+	auto it = b.begin();
+
+	for (const auto& [name, value] : a) {
+
+		if (it == b.end() || it->first != name || !equal(value, it->second)) {
+			return false;
+		}
+
+		it++;
+
+	}
+
+	return it == b.end();
+
+}
+
+static bool equal(const JsonValue& a, const JsonValue& b) {
+
+	if (a.getType() != b.getType()) {
+		return false;
+	}
+
+	switch (a.getType()) {
+
+		case Json::Type::String:	return a.toString() == b.toString();
+		case Json::Type::Boolean:	return a.toBoolean() == b.toBoolean();
+		case Json::Type::Array:		return equal(a.toArray(), b.toArray());
+		case Json::Type::Object:	return equal(a.toObject(), b.toObject());
+
+		case Json::Type::Number:
+
+			if (a.isInteger() != b.isInteger()) {
+				return false;
+			}
+
+			return a.isInteger() ? a.toNumber<i64>() == b.toNumber<i64>() : a.toNumber<double>() == b.toNumber<double>();
+
+		default:					return true;
+
+	}
+
+}
+
+
+
+//Writes and reads back the document, both compact and indented
+static bool roundTrips(const JsonDocument& document) {
+
+	JsonDocument compact(document.write(true));
+	JsonDocument indented(document.write(false));
+
+	return equal(compact.getRoot(), document.getRoot()) && equal(indented.getRoot(), document.getRoot());
+
+}
+
+
+
+ARC_TEST(Numbers) {
+
+	JsonDocument document(R"({
+		"zero": 0, "negative": -17, "max": 9223372036854775807, "min": -9223372036854775808,
+		"huge": 18446744073709551616, "float": 1.5, "exponent": -2.5e-3, "upper": 1E3, "integral": 4.0,
+		"list": [1,2.25,-3e2]
+	})");
+
+	const JsonObject& root = document.getRoot();
+
+	ARC_EXPECT(root["zero"].isInteger() && root["zero"].toNumber<i64>() == 0);
+	ARC_EXPECT(root["negative"].toNumber<i64>() == -17);
+	ARC_EXPECT(root["max"].isInteger() && root["max"].toNumber<i64>() == std::numeric_limits<i64>::max());
+	ARC_EXPECT(root["min"].isInteger() && root["min"].toNumber<i64>() == std::numeric_limits<i64>::min());
+	ARC_EXPECT(root["huge"].isFloat() && root["huge"].toNumber<double>() == 18446744073709551616.0);
+	ARC_EXPECT(root["float"].isFloat() && root["float"].toNumber<double>() == 1.5);
+	ARC_EXPECT(root["exponent"].toNumber<double>() == -2.5e-3);
+	ARC_EXPECT(root["upper"].isFloat() && root["upper"].toNumber<double>() == 1000);
+	ARC_EXPECT(root["integral"].isFloat());
+
+	const JsonArray& list = root["list"].toArray();
+
+	ARC_EXPECT(list[0].isInteger() && list[1].toNumber<double>() == 2.25 && list[2].toNumber<double>() == -300);
+
+	//Floats are written with the shortest representation that reads back exactly
+	JsonObject values;
+
+	u32 index = 0;
+
+	for (double d : {0.1, 1.0 / 3, 6.02214076e23, -4.9e-324, 1e300}) {
+		values.insert(std::to_string(index++), JsonValue(d));
+	}
+
+	ARC_EXPECT(roundTrips(document));
+	ARC_EXPECT(roundTrips(JsonDocument(values)));
+
+	ARC_EXPECT_THROW(JsonDocument(R"({"a": -})"), JsonSyntaxError);
+	ARC_EXPECT_THROW(JsonDocument(R"({"a": 1.5e})"), JsonSyntaxError);
+
+}
+
+
+
+ARC_TEST(Escapes) {
+
+	JsonDocument document(R"({"escapes": "\"\\\/\b\f\n\r\t", "unicode": "Aé€😀", "lone": "\ud800x\udc00"})");
+	const JsonObject& root = document.getRoot();
+
+	ARC_EXPECT(root["escapes"].toString() == "\"\\/\b\f\n\r\t");
+	ARC_EXPECT(root["unicode"].toString() == "A\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+	ARC_EXPECT(root["lone"].toString() == "\xEF\xBF\xBDx\xEF\xBF\xBD");
+
+	//Control characters have to be escaped on output
+	JsonObject control;
+	control.insert("control", JsonValue(std::string("\x01\x1F\x7F end", 7)));
+	control.insert("quote\"key", JsonValue("\\"));
+
+	ARC_EXPECT(roundTrips(document));
+	ARC_EXPECT(roundTrips(JsonDocument(control)));
+
+	ARC_EXPECT_THROW(JsonDocument(R"({"a": "\q"})"), JsonSyntaxError);
+	ARC_EXPECT_THROW(JsonDocument(R"({"a": "\u12"})"), JsonSyntaxError);
+	ARC_EXPECT_THROW(JsonDocument(R"({"a": "open)"), JsonSyntaxError);
+
+}
+
+
+
+ARC_TEST(DelimitersAtEveryOffset) {
+
+	//Quotes and backslashes are searched in blocks, place them at every position relative to a block
+	for (u32 length = 0; length < 80; length++) {
+
+		for (u32 position = 0; position <= length; position++) {
+
+			std::string expected(length, 'a');
+			std::string escaped = expected;
+
+			if (position < length) {
+				expected[position] = '"';
+				escaped.replace(position, 1, "\\\"");
+			}
+
+			JsonDocument document("{\"s\": \"" + escaped + "\"}");
+
+			if (document.getRoot()["s"].toString() != expected) {
+
+				ARC_EXPECT(!"Misread string");
+				return;
+
+			}
+
+		}
+
+	}
+
+}
+
+
+
+ARC_TEST(Structure) {
+
+	JsonDocument document(R"({
+		// Comment
+		"empty": [], "object": {}, /* block */"nested": [[1, [true, false, null]], {"a": {"b": "c"}}]
+	})");
+
+	const JsonObject& root = document.getRoot();
+
+	ARC_EXPECT(root["empty"].isArray() && root["empty"].toArray().empty());
+	ARC_EXPECT(root["object"].isObject() && root["object"].toObject().empty());
+	ARC_EXPECT(root["nested"].toArray()[1].toObject()["a"].toObject()["b"].toString() == "c");
+	ARC_EXPECT(root["nested"].toArray()[0].toArray()[1].toArray()[2].isNull());
+
+	ARC_EXPECT(roundTrips(document));
+
+}
\ No newline at end of file
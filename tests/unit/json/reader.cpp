@@ -0,0 +1,283 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 reader.cpp
+ */
+
+#include "framework/test.hpp"
+#include "json/reader.hpp"
+#include "json/document.hpp"
+
+#include <algorithm>
+#include <string>
+
+
+
+//Pulls the next event, feeding chunks of the input whenever the reader runs dry
+class ChunkedReader {
+
+public:
+
+	ChunkedReader(const std::string& json, SizeT chunkSize) : json(json), chunkSize(chunkSize), offset(0) {}
+
+	JsonReader::Event next() {
+
+		JsonReader::Event event;
+
+		while ((event = reader.next()) == JsonReader::Event::NeedInput) {
+
+			if (offset == json.size()) {
+
+				reader.finish();
+				continue;
+
+			}
+
+			SizeT size = std::min(chunkSize, json.size() - offset);
+
+			reader.feed(Json::StringView(json).substr(offset, size));
+			offset += size;
+
+		}
+
+		return event;
+
+	}
+
+	JsonReader reader;
+
+private:
+
+	std::string json;
+	SizeT chunkSize;
+	SizeT offset;
+
+};
+
+
+
+//Renders the event stream as text
+static std::string trace(const std::string& json, SizeT chunkSize) {
+
+	ChunkedReader chunked(json, chunkSize);
+	JsonReader& reader = chunked.reader;
+	std::string events;
+
+	for (JsonReader::Event event = chunked.next(); event != JsonReader::Event::EndOfInput; event = chunked.next()) {
+
+		switch (event) {
+
+			case JsonReader::Event::StartObject:	events += "{ "; break;
+			case JsonReader::Event::EndObject:		events += "} "; break;
+			case JsonReader::Event::StartArray:		events += "[ "; break;
+			case JsonReader::Event::EndArray:		events += "] "; break;
+			case JsonReader::Event::Key:			events += "K:" + std::string(reader.getString()) + " "; break;
+			case JsonReader::Event::String:			events += "S:" + std::string(reader.getString()) + " "; break;
+			case JsonReader::Event::Boolean:		events += reader.getBoolean() ? "true " : "false "; break;
+			case JsonReader::Event::Null:			events += "null "; break;
+
+			case JsonReader::Event::Number:
+				events += reader.isInteger() ? "I:" + std::to_string(reader.getInteger()) + " " : "F:" + std::to_string(reader.getFloat()) + " ";
+				break;
+
+			default:
+				break;
+
+		}
+
+	}
+
+	return events;
+
+}
+
+
+
+static constexpr const char* Mixed = R"({"name": "reader", "escaped": "a\"b\\cé😀",
+	"numbers": [0, -12345678901, 2.5, -1e-3, 12e2], /* comment */ "literals": [true, false, null],
+	// Comment
+	"nested": {"empty": {}, "list": [[], [{}]]}})";
+
+static constexpr const char* MixedTrace =
+	"{ K:name S:reader K:escaped S:a\"b\\c\xC3\xA9\xF0\x9F\x98\x80 "
+	"K:numbers [ I:0 I:-12345678901 F:2.500000 F:-0.001000 F:1200.000000 ] K:literals [ true false null ] "
+	"K:nested { K:empty { } K:list [ [ ] [ { } ] ] } } ";
+
+
+
+ARC_TEST(ChunkSplitEquivalence) {
+
+	std::string json = Mixed;
+
+	ARC_EXPECT(trace(json, json.size()) == MixedTrace);
+
+	//Every token is cut at every possible position by some chunk size
+	for (SizeT chunkSize = 1; chunkSize <= 17; chunkSize++) {
+
+		if (trace(json, chunkSize) != MixedTrace) {
+
+			ARC_EXPECT(!"Chunked trace differs");
+			break;
+
+		}
+
+	}
+
+	//Trailing numbers and literals are only complete once the input is finished
+	ARC_EXPECT(trace("12", 1) == "I:12 ");
+	ARC_EXPECT(trace("true", 1) == "true ");
+
+}
+
+
+
+ARC_TEST(NewlineDelimited) {
+
+	std::string json;
+
+	for (u32 i = 0; i < 1000; i++) {
+		json += "{\"id\": " + std::to_string(i) + ", \"payload\": \"" + std::string(i % 50, 'x') + "\"}\n";
+	}
+
+	for (SizeT chunkSize : {SizeT(3), SizeT(4096), json.size()}) {
+
+		ChunkedReader chunked(json, chunkSize);
+		JsonReader& reader = chunked.reader;
+
+		u32 records = 0;
+		bool ordered = true;
+
+		for (JsonReader::Event event = chunked.next(); event != JsonReader::Event::EndOfInput; event = chunked.next()) {
+
+			if (event == JsonReader::Event::Key && reader.getString() == "id") {
+
+				chunked.next();
+				ordered &= reader.getInteger() == records++;
+
+			}
+
+		}
+
+		ARC_EXPECT(records == 1000 && ordered);
+
+	}
+
+}
+
+
+
+ARC_TEST(Skip) {
+
+	std::string json = R"({"skipped": {"a": [1, {"b": "}"}]}, "kept": [1, 2], "after": "x"})";
+
+	for (SizeT chunkSize : {SizeT(1), SizeT(5), json.size()}) {
+
+		ChunkedReader chunked(json, chunkSize);
+		JsonReader& reader = chunked.reader;
+
+		ARC_EXPECT(chunked.next() == JsonReader::Event::StartObject);
+		ARC_EXPECT(chunked.next() == JsonReader::Event::Key && reader.getString() == "skipped");
+
+		//Skipping a key discards its whole value
+		reader.skip();
+
+		ARC_EXPECT(chunked.next() == JsonReader::Event::Key && reader.getString() == "kept");
+		ARC_EXPECT(chunked.next() == JsonReader::Event::StartArray && reader.getDepth() == 2);
+
+		//Skipping a container discards the rest of it
+		reader.skip();
+
+		ARC_EXPECT(chunked.next() == JsonReader::Event::Key && reader.getString() == "after" && reader.getDepth() == 1);
+		ARC_EXPECT(chunked.next() == JsonReader::Event::String && reader.getString() == "x");
+		ARC_EXPECT(chunked.next() == JsonReader::Event::EndObject);
+		ARC_EXPECT(chunked.next() == JsonReader::Event::EndOfInput);
+
+	}
+
+}
+
+
+
+ARC_TEST(Errors) {
+
+	ARC_EXPECT_THROW(trace(R"({"a" 1})", 1), JsonSyntaxError);
+	ARC_EXPECT_THROW(trace(R"({"a": 1 "b": 2})", 1), JsonSyntaxError);
+	ARC_EXPECT_THROW(trace(R"([1, 2)", 1), JsonSyntaxError);
+	ARC_EXPECT_THROW(trace(R"(["open)", 2), JsonSyntaxError);
+	ARC_EXPECT_THROW(trace(R"([tru])", 1), JsonSyntaxError);
+	ARC_EXPECT_THROW(trace(R"({1: 2})", 1), JsonSyntaxError);
+
+	JsonReader reader;
+	reader.finish();
+
+	ARC_EXPECT_THROW(reader.feed("{}"), JsonException);
+
+}
+
+
+
+ARC_TEST(WriterRoundTrip) {
+
+	//JsonObject orders members by name
+	constexpr const char* SortedTrace =
+		"{ K:escaped S:a\"b\\c\xC3\xA9\xF0\x9F\x98\x80 K:literals [ true false null ] K:name S:reader "
+		"K:nested { K:empty { } K:list [ [ ] [ { } ] ] } K:numbers [ I:0 I:-12345678901 F:2.500000 F:-0.001000 F:1200.000000 ] } ";
+
+	JsonDocument document(Mixed);
+
+	//A small sink chunk checks that the buffered output is handed over in order
+	for (bool compact : {true, false}) {
+
+		std::string output;
+		SizeT largestChunk = 0;
+
+		JsonWriter writer([&](const Json::StringView& chunk) {
+			output += chunk;
+			largestChunk = std::max(largestChunk, chunk.size());
+		}, compact);
+
+		writer.value(document.getRoot());
+
+		ARC_EXPECT(output.empty());
+
+		writer.flush();
+
+		ARC_EXPECT(trace(output, 3) == SortedTrace);
+		ARC_EXPECT(output == document.write(compact));
+		ARC_EXPECT(largestChunk <= JsonWriter::BufferSize);
+
+	}
+
+	//Events written one by one, with output larger than the buffer
+	std::string output;
+	u32 chunks = 0;
+
+	JsonWriter writer([&](const Json::StringView& chunk) {
+		output += chunk;
+		chunks++;
+	});
+
+	for (u32 i = 0; i < 2000; i++) {
+
+		writer.beginObject();
+		writer.key("id");
+		writer.value(i);
+		writer.key("values");
+		writer.beginArray();
+		writer.value(0.5);
+		writer.value(nullptr);
+		writer.value("text");
+		writer.endArray();
+		writer.endObject();
+
+	}
+
+	writer.flush();
+
+	ARC_EXPECT(chunks > 1);
+	ARC_EXPECT(std::count(output.begin(), output.end(), '\n') >= 1999);
+	ARC_EXPECT(trace(output, 4096).starts_with("{ K:id I:0 K:values [ F:0.500000 null S:text ] } { K:id I:1 "));
+
+}
\ No newline at end of file
@@ -0,0 +1,306 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 arenaallocator.cpp
+ */
+
+#include "framework/test.hpp"
+#include "memory/arenaallocator.hpp"
+#include "concurrent/thread.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+
+
+ARC_TEST(BumpAllocation) {
+
+	ArenaAllocator arena(SizeT(16) << 20);
+
+	ARC_EXPECT(arena.getReservedSize() == SizeT(16) << 20);
+	ARC_EXPECT(arena.getUsedSize() == 0 && arena.getCommittedSize() == 0);
+
+	u8* a = static_cast<u8*>(arena.allocate(10, 1));
+	u8* b = static_cast<u8*>(arena.allocate(10, 1));
+
+	//Consecutive allocations are adjacent
+	ARC_EXPECT(b == a + 10);
+	ARC_EXPECT(arena.getUsedSize() == 20 && arena.getCommittedSize() == ArenaAllocator::CommitGranularity);
+
+	bool aligned = true;
+
+	for (AlignT alignment = 1; alignment <= 16384; alignment *= 2) {
+
+		void* p = arena.allocate(3, alignment);
+		aligned &= reinterpret_cast<uintptr_t>(p) % alignment == 0;
+
+	}
+
+	ARC_EXPECT(aligned);
+
+	u64* values = arena.allocate<u64>(1000);
+
+	ARC_EXPECT(reinterpret_cast<uintptr_t>(values) % alignof(u64) == 0);
+
+	//Committing grows in whole steps across multiple granules
+	u8* large = static_cast<u8*>(arena.allocate(ArenaAllocator::CommitGranularity * 3 + 1, 1));
+	std::memset(large, 0xAB, ArenaAllocator::CommitGranularity * 3 + 1);
+
+	ARC_EXPECT(arena.getCommittedSize() >= arena.getUsedSize() && arena.getCommittedSize() % ArenaAllocator::CommitGranularity == 0);
+	ARC_EXPECT(large[ArenaAllocator::CommitGranularity * 3] == 0xAB);
+	ARC_EXPECT(arena.getPeakSize() == arena.getUsedSize());
+
+}
+
+
+
+ARC_TEST(Markers) {
+
+	ArenaAllocator arena(SizeT(16) << 20);
+
+	void* first = arena.allocate(100);
+	ArenaAllocator::Marker marker = arena.getMarker();
+
+	void* second = arena.allocate(1000);
+	void* third = arena.allocate(200000);
+
+	ARC_EXPECT(third > second);
+
+	SizeT peak = arena.getUsedSize();
+	SizeT committed = arena.getCommittedSize();
+
+	//Rewinding reuses the same addresses and keeps the committed pages
+	arena.rewind(marker);
+
+	ARC_EXPECT(arena.getUsedSize() == marker);
+	ARC_EXPECT(arena.getCommittedSize() == committed);
+	ARC_EXPECT(arena.getPeakSize() == peak);
+	ARC_EXPECT(arena.allocate(1000) == second);
+
+	SizeT outer = arena.getUsedSize();
+
+	{
+
+		ArenaAllocator::Scope scope(arena);
+		ARC_EXPECT(arena.allocate(500) != nullptr);
+
+		SizeT inner = arena.getUsedSize();
+
+		{
+
+			ArenaAllocator::Scope nested(arena);
+			ARC_EXPECT(arena.allocate(5000) != nullptr);
+
+		}
+
+		ARC_EXPECT(arena.getUsedSize() == inner);
+
+	}
+
+	ARC_EXPECT(arena.getUsedSize() == outer);
+
+	arena.reset();
+
+	ARC_EXPECT(arena.getUsedSize() == 0);
+	ARC_EXPECT(arena.allocate(100) == first);
+
+	//Trimming decommits everything above the top, but never below the retained size
+	arena.trim(ArenaAllocator::CommitGranularity * 2);
+
+	ARC_EXPECT(arena.getCommittedSize() == ArenaAllocator::CommitGranularity * 2);
+
+	arena.trim();
+
+	ARC_EXPECT(arena.getCommittedSize() == ArenaAllocator::CommitGranularity);
+
+	//Decommitted memory reads as zero once committed again
+	u8* p = static_cast<u8*>(arena.allocate(ArenaAllocator::CommitGranularity * 2));
+	bool zero = true;
+
+	for (SizeT i = ArenaAllocator::CommitGranularity; i < ArenaAllocator::CommitGranularity * 2; i++) {
+		zero &= p[i] == 0;
+	}
+
+	ARC_EXPECT(zero);
+
+}
+
+
+
+ARC_TEST(Deallocation) {
+
+	ArenaAllocator arena(SizeT(1) << 20);
+
+	void* a = arena.allocate(64);
+	void* b = arena.allocate(64);
+
+	//Only the topmost allocation is reclaimed
+	arena.deallocate(a, 64);
+
+	ARC_EXPECT(arena.getUsedSize() == 128);
+
+	arena.deallocate(b, 64);
+
+	ARC_EXPECT(arena.getUsedSize() == 64);
+	ARC_EXPECT(arena.allocate(64) == b);
+
+	arena.deallocate(nullptr, 0);
+
+	ARC_EXPECT(arena.getUsedSize() == 128);
+
+	//Popping an allocation made before a scope leaves the top below its marker
+	void* outer = arena.allocate(64);
+
+	{
+
+		ArenaAllocator::Scope scope(arena);
+		arena.deallocate(outer, 64);
+
+		ARC_EXPECT(arena.getUsedSize() == 128);
+
+	}
+
+	ARC_EXPECT(arena.getUsedSize() == 128);
+
+	//Scope allocations made after the pop are released up to the marker
+	outer = arena.allocate(64);
+
+	{
+
+		ArenaAllocator::Scope scope(arena);
+		arena.deallocate(outer, 64);
+
+		ARC_EXPECT(arena.allocate(256) == outer);
+
+	}
+
+	ARC_EXPECT(arena.getUsedSize() == 192);
+
+}
+
+
+
+ARC_TEST(Exhaustion) {
+
+	ArenaAllocator empty;
+
+	ARC_EXPECT_THROW(empty.allocate(1), std::bad_alloc);
+
+	ArenaAllocator arena(ArenaAllocator::CommitGranularity * 2);
+
+	void* p = arena.allocate(ArenaAllocator::CommitGranularity * 2, 1);
+
+	ARC_EXPECT(p != nullptr && arena.getUsedSize() == arena.getReservedSize());
+	ARC_EXPECT_THROW(arena.allocate(1, 1), std::bad_alloc);
+	ARC_EXPECT_THROW(arena.allocate(SizeT(-1) / 2), std::bad_alloc);
+
+	//A failed allocation leaves the arena untouched
+	ARC_EXPECT(arena.getUsedSize() == arena.getReservedSize());
+
+	ArenaAllocator moved(std::move(arena));
+
+	ARC_EXPECT(arena.getReservedSize() == 0 && moved.getUsedSize() == moved.getReservedSize());
+
+	moved.clear();
+
+	ARC_EXPECT(moved.getReservedSize() == 0 && moved.getUsedSize() == 0 && moved.getPeakSize() == 0);
+
+}
+
+
+
+ARC_TEST(MemoryResource) {
+
+	ArenaAllocator arena(SizeT(64) << 20);
+	ArenaResource resource(arena);
+
+	{
+
+		std::pmr::vector<u32> vector(&resource);
+
+		for (u32 i = 0; i < 100000; i++) {
+			vector.push_back(i);
+		}
+
+		//Growing reuses the top buffer, so the arena holds little more than the final capacity
+		ARC_EXPECT(arena.getUsedSize() < vector.capacity() * sizeof(u32) * 2);
+
+		std::pmr::vector<std::pmr::string> strings(&resource);
+
+		for (u32 i = 0; i < 1000; i++) {
+			strings.emplace_back("a string too long for the small buffer " + std::to_string(i));
+		}
+
+		std::sort(strings.begin(), strings.end());
+
+		ARC_EXPECT(vector[99999] == 99999 && strings.front() == "a string too long for the small buffer 0");
+		ARC_EXPECT(strings[0].get_allocator().resource() == &resource);
+
+	}
+
+	//A string created before a scope and destroyed inside it pops the top below the scope's marker
+	{
+
+		std::pmr::string outer("a string too long for the small buffer", &resource);
+		SizeT used = arena.getUsedSize();
+
+		{
+
+			ArenaAllocator::Scope scope(arena);
+			std::pmr::string inner(std::move(outer));
+
+		}
+
+		ARC_EXPECT(arena.getUsedSize() < used);
+
+		std::pmr::string next("another string too long for the small buffer", &resource);
+
+		ARC_EXPECT(next.get_allocator().resource() == &resource);
+
+	}
+
+	ArenaResource other(arena);
+	ArenaAllocator otherArena(SizeT(1) << 20);
+	ArenaResource foreign(otherArena);
+
+	ARC_EXPECT(resource.is_equal(other) && !resource.is_equal(foreign));
+	ARC_EXPECT(!resource.is_equal(*std::pmr::new_delete_resource()));
+
+}
+
+
+
+ARC_TEST(FrameArenas) {
+
+	ArenaAllocator& first = ArenaAllocator::getFrameArena();
+	u32* handover = first.allocate<u32>(1);
+	*handover = 42;
+
+	//Data of the previous frame survives a single frame switch
+	ArenaAllocator::nextFrame();
+	ArenaAllocator& second = ArenaAllocator::getFrameArena();
+
+	ARC_EXPECT(&second != &first);
+	ARC_EXPECT(*handover == 42 && first.getUsedSize() != 0);
+
+	ARC_EXPECT(second.allocate(100) != nullptr);
+	ArenaAllocator::nextFrame();
+
+	ARC_EXPECT(&ArenaAllocator::getFrameArena() == &first);
+	ARC_EXPECT(first.getUsedSize() == 0 && second.getUsedSize() != 0);
+
+	//Every thread owns its own frame arenas
+	ArenaAllocator* threadArena = nullptr;
+
+	Thread thread;
+	thread.start([&]() { threadArena = &ArenaAllocator::getFrameArena(); });
+	thread.finish();
+
+	ARC_EXPECT(threadArena && threadArena != &first && threadArena != &second);
+
+}
\ No newline at end of file
@@ -0,0 +1,219 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 concurrentpoolallocator.cpp
+ */
+
+#include "framework/test.hpp"
+#include "memory/concurrentpoolallocator.hpp"
+#include "concurrent/thread.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+
+
+struct alignas(64) Particle {
+
+	u64 id;
+	float position[3];
+	float velocity[3];
+
+};
+
+
+
+ARC_TEST(FixedPool) {
+
+	ConcurrentPoolAllocator pool;
+
+	ARC_EXPECT_THROW(pool.allocate(), std::bad_alloc);
+
+	constexpr u32 BlockCount = 100;
+	pool.create<Particle>(BlockCount);
+
+	std::vector<Particle*> blocks;
+	bool aligned = true;
+
+	for (u32 i = 0; i < BlockCount; i++) {
+
+		Particle* p = static_cast<Particle*>(pool.allocate());
+		aligned &= reinterpret_cast<uintptr_t>(p) % alignof(Particle) == 0;
+
+		p->id = i;
+		blocks.push_back(p);
+
+	}
+
+	ARC_EXPECT(aligned);
+	ARC_EXPECT_THROW(pool.allocate(), std::bad_alloc);
+
+	//All blocks are distinct and do not overlap
+	std::vector<Particle*> sorted = blocks;
+	std::sort(sorted.begin(), sorted.end());
+
+	bool disjoint = true;
+
+	for (u32 i = 1; i < BlockCount; i++) {
+		disjoint &= reinterpret_cast<u8*>(sorted[i]) - reinterpret_cast<u8*>(sorted[i - 1]) >= std::ptrdiff_t(sizeof(Particle));
+	}
+
+	bool intact = true;
+
+	for (u32 i = 0; i < BlockCount; i++) {
+		intact &= blocks[i]->id == i;
+	}
+
+	ARC_EXPECT(disjoint && intact);
+
+	//The freelist is a stack, the last freed block is handed out first
+	pool.deallocate(blocks[10]);
+	pool.deallocate(blocks[20]);
+	pool.deallocate(nullptr);
+
+	ARC_EXPECT(pool.allocate() == blocks[20]);
+	ARC_EXPECT(pool.allocate() == blocks[10]);
+	ARC_EXPECT_THROW(pool.allocate(), std::bad_alloc);
+
+	for (Particle* p : blocks) {
+		pool.deallocate(p);
+	}
+
+	//Recreating drops the old heap
+	pool.create(4, 1, 1);
+
+	void* small[4];
+
+	for (void*& p : small) {
+		p = pool.allocate();
+	}
+
+	ARC_EXPECT(reinterpret_cast<uintptr_t>(small[0]) % alignof(void*) == 0);
+	ARC_EXPECT_THROW(pool.allocate(), std::bad_alloc);
+
+	pool.clear();
+
+	ARC_EXPECT_THROW(pool.allocate(), std::bad_alloc);
+
+}
+
+
+
+ARC_TEST(Growth) {
+
+	ConcurrentPoolAllocator pool;
+	pool.create<u64>(16, true);
+
+	std::vector<u64*> blocks;
+
+	for (u32 i = 0; i < 1000; i++) {
+
+		u64* p = static_cast<u64*>(pool.allocate());
+		*p = i * 0x9E3779B97F4A7C15ull;
+
+		blocks.push_back(p);
+
+	}
+
+	bool intact = true;
+
+	for (u32 i = 0; i < 1000; i++) {
+		intact &= *blocks[i] == i * 0x9E3779B97F4A7C15ull;
+	}
+
+	std::vector<u64*> sorted = blocks;
+	std::sort(sorted.begin(), sorted.end());
+
+	ARC_EXPECT(intact);
+	ARC_EXPECT(std::adjacent_find(sorted.begin(), sorted.end()) == sorted.end());
+
+	//Freed blocks are reused before the pool grows again
+	for (u64* p : blocks) {
+		pool.deallocate(p);
+	}
+
+	std::vector<u64*> reused;
+
+	for (u32 i = 0; i < 1000; i++) {
+		reused.push_back(static_cast<u64*>(pool.allocate()));
+	}
+
+	std::sort(reused.begin(), reused.end());
+
+	ARC_EXPECT(reused == sorted);
+
+}
+
+
+
+ARC_TEST(Contention) {
+
+	constexpr u32 ThreadCount = 8;
+	constexpr u32 Iterations = 20000;
+	constexpr u32 Batch = 16;
+
+	for (bool growable : {false, true}) {
+
+		//A fixed pool has just enough blocks for every thread's batch, a growable one starts tiny
+		ConcurrentPoolAllocator pool;
+		pool.create<u64>(growable ? 4 : ThreadCount * Batch, growable);
+
+		std::atomic<u32> corrupted = 0;
+		std::atomic<u32> failed = 0;
+		std::vector<Thread> threads(ThreadCount);
+
+		for (u32 t = 0; t < ThreadCount; t++) {
+
+			threads[t].start([&, t]() {
+
+				u64* blocks[Batch];
+
+				for (u32 i = 0; i < Iterations; i++) {
+
+					u32 count = i % Batch + 1;
+
+					try {
+
+						for (u32 j = 0; j < count; j++) {
+
+							blocks[j] = static_cast<u64*>(pool.allocate());
+							*blocks[j] = u64(t) << 32 | i << 5 | j;
+
+						}
+
+					} catch (const std::bad_alloc&) {
+
+						failed++;
+						return;
+
+					}
+
+					//A block handed out twice would have been overwritten by its other owner
+					for (u32 j = 0; j < count; j++) {
+
+						corrupted += *blocks[j] != (u64(t) << 32 | i << 5 | j);
+						pool.deallocate(blocks[j]);
+
+					}
+
+				}
+
+			});
+
+		}
+
+		for (Thread& thread : threads) {
+			thread.finish();
+		}
+
+		ARC_EXPECT(corrupted == 0);
+		ARC_EXPECT(failed == 0);
+
+	}
+
+}
\ No newline at end of file
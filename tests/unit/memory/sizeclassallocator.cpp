@@ -0,0 +1,266 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 sizeclassallocator.cpp
+ */
+
+#include "framework/test.hpp"
+#include "memory/sizeclassallocator.hpp"
+#include "concurrent/thread.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+
+
+//Fills a block with a pattern derived from its address and size
+static void fill(void* p, SizeT size) {
+	std::memset(p, u8(reinterpret_cast<uintptr_t>(p) >> 4 ^ size), size);
+}
+
+static bool check(const void* p, SizeT size) {
+
+	const u8* bytes = static_cast<const u8*>(p);
+	u8 expected = u8(reinterpret_cast<uintptr_t>(p) >> 4 ^ size);
+
+	for (SizeT i = 0; i < size; i++) {
+
+		if (bytes[i] != expected) {
+			return false;
+		}
+
+	}
+
+	return true;
+
+}
+
+
+
+ARC_TEST(SizesAndAlignment) {
+
+	SizeClassAllocator::deallocate(nullptr);
+
+	struct Block {
+
+		void* p;
+		SizeT size;
+
+	};
+
+	std::vector<Block> blocks;
+	bool valid = true;
+
+	for (SizeT size = 1; size <= SizeClassAllocator::MaxSmallSize; size += size / 8 + 1) {
+
+		for (AlignT alignment = 1; alignment <= 4096; alignment *= 4) {
+
+			void* p = SizeClassAllocator::allocate(size, alignment);
+
+			valid &= reinterpret_cast<uintptr_t>(p) % alignment == 0;
+			valid &= SizeClassAllocator::getSize(p) >= size;
+
+			fill(p, size);
+			blocks.push_back({p, size});
+
+		}
+
+	}
+
+	ARC_EXPECT(valid);
+
+	//No two live blocks overlap, which would have broken the patterns
+	for (const Block& block : blocks) {
+
+		valid &= check(block.p, block.size);
+		SizeClassAllocator::deallocate(block.p);
+
+	}
+
+	ARC_EXPECT(valid);
+
+	//Freed blocks of a class are reused
+	void* a = SizeClassAllocator::allocate(200);
+	SizeClassAllocator::deallocate(a);
+	void* b = SizeClassAllocator::allocate(200);
+
+	ARC_EXPECT(a == b);
+
+	SizeClassAllocator::deallocate(b);
+
+}
+
+
+
+ARC_TEST(LargeAllocations) {
+
+	SizeClassAllocator::Statistics before = SizeClassAllocator::getStatistics();
+
+	SizeT size = SizeClassAllocator::MaxSmallSize * 10 + 123;
+	void* p = SizeClassAllocator::allocate(size);
+	void* q = SizeClassAllocator::allocate(SizeClassAllocator::MaxSmallSize + 1, 4096);
+
+	ARC_EXPECT(SizeClassAllocator::getSize(p) >= size && SizeClassAllocator::getSize(q) > SizeClassAllocator::MaxSmallSize);
+	ARC_EXPECT(reinterpret_cast<uintptr_t>(q) % 4096 == 0);
+
+	fill(p, size);
+
+	ARC_EXPECT(check(p, size));
+
+	SizeClassAllocator::Statistics during = SizeClassAllocator::getStatistics();
+
+	ARC_EXPECT(during.largeAllocations == before.largeAllocations + 2);
+	ARC_EXPECT(during.largeBytes >= before.largeBytes + size + SizeClassAllocator::MaxSmallSize);
+
+	SizeClassAllocator::deallocate(p);
+	SizeClassAllocator::deallocate(q);
+
+	SizeClassAllocator::Statistics after = SizeClassAllocator::getStatistics();
+
+	ARC_EXPECT(after.largeAllocations == before.largeAllocations && after.largeBytes == before.largeBytes);
+
+}
+
+
+
+ARC_TEST(Statistics) {
+
+	SizeClassAllocator::Statistics before = SizeClassAllocator::getStatistics();
+
+	std::vector<void*> blocks;
+
+	for (u32 i = 0; i < 1000; i++) {
+		blocks.push_back(SizeClassAllocator::allocate(100));
+	}
+
+	SizeClassAllocator::Statistics during = SizeClassAllocator::getStatistics();
+
+	ARC_EXPECT(during.allocations == before.allocations + 1000);
+	ARC_EXPECT(during.allocatedBytes >= before.allocatedBytes + 100000);
+	ARC_EXPECT(during.slabBytes >= during.allocatedBytes);
+
+	for (void* p : blocks) {
+		SizeClassAllocator::deallocate(p);
+	}
+
+	SizeClassAllocator::Statistics after = SizeClassAllocator::getStatistics();
+
+	ARC_EXPECT(after.deallocations == before.deallocations + 1000);
+	ARC_EXPECT(after.allocatedBytes == before.allocatedBytes);
+
+}
+
+
+
+ARC_TEST(Adapter) {
+
+	std::vector<u64, SizeClassAllocatorAdapter<u64>> vector;
+
+	for (u64 i = 0; i < 100000; i++) {
+		vector.push_back(i * i);
+	}
+
+	std::map<u32, u32, std::less<u32>, SizeClassAllocatorAdapter<std::pair<const u32, u32>>> map;
+
+	for (u32 i = 0; i < 10000; i++) {
+		map[i * 7919 % 10007] = i;
+	}
+
+	ARC_EXPECT(vector[99999] == 99999ull * 99999 && map.size() == 10000 && map.begin()->first == 0);
+	ARC_EXPECT(SizeClassAllocatorAdapter<u32>() == SizeClassAllocatorAdapter<u64>());
+
+}
+
+
+
+ARC_TEST(CrossThreadFrees) {
+
+	constexpr u32 ThreadCount = 4;
+	constexpr u32 Iterations = 20000;
+
+	//Blocks are handed to the next thread, which verifies and frees them
+	std::mutex mutex;
+	std::vector<std::pair<void*, SizeT>> handoff[ThreadCount];
+	std::atomic<u32> corrupted = 0;
+
+	std::vector<Thread> threads(ThreadCount);
+
+	for (u32 t = 0; t < ThreadCount; t++) {
+
+		threads[t].start([&, t]() {
+
+			u32 state = t + 1;
+			std::vector<std::pair<void*, SizeT>> owned;
+
+			for (u32 i = 0; i < Iterations; i++) {
+
+				state = state * 1103515245 + 12345;
+				SizeT size = (state >> 8) % 4096 + 1;
+
+				void* p = SizeClassAllocator::allocate(size);
+				fill(p, size);
+
+				if (state & 0x10000) {
+
+					std::lock_guard lock(mutex);
+					handoff[(t + 1) % ThreadCount].emplace_back(p, size);
+
+				} else {
+
+					owned.emplace_back(p, size);
+
+				}
+
+				if (owned.size() > 64 || i + 1 == Iterations) {
+
+					std::lock_guard lock(mutex);
+					owned.insert(owned.end(), handoff[t].begin(), handoff[t].end());
+					handoff[t].clear();
+
+				}
+
+				if (owned.size() > 64 || i + 1 == Iterations) {
+
+					for (auto [block, blockSize] : owned) {
+
+						corrupted += !check(block, blockSize);
+						SizeClassAllocator::deallocate(block);
+
+					}
+
+					owned.clear();
+
+				}
+
+			}
+
+			SizeClassAllocator::releaseThreadCache();
+
+		});
+
+	}
+
+	for (Thread& thread : threads) {
+		thread.finish();
+	}
+
+	//Blocks handed to threads that had already finished
+	for (auto& list : handoff) {
+
+		for (auto [block, blockSize] : list) {
+
+			corrupted += !check(block, blockSize);
+			SizeClassAllocator::deallocate(block);
+
+		}
+
+	}
+
+	ARC_EXPECT(corrupted == 0);
+
+}
\ No newline at end of file
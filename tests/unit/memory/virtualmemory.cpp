@@ -0,0 +1,284 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 virtualmemory.cpp
+ */
+
+#include "framework/test.hpp"
+#include "memory/virtualmemory.hpp"
+#include "memory/virtualallocator.hpp"
+#include "arcbuild.hpp"
+
+#include <vector>
+
+#ifdef ARC_OS_LINUX
+	#include <sys/wait.h>
+	#include <unistd.h>
+#endif
+
+
+
+static bool isZero(const u8* p, SizeT size) {
+
+	for (SizeT i = 0; i < size; i++) {
+
+		if (p[i]) {
+			return false;
+		}
+
+	}
+
+	return true;
+
+}
+
+
+
+#ifdef ARC_OS_LINUX
+
+//Writes to the address in a child process and returns true if the write was killed by a signal
+static bool writeFaults(volatile u8* p) {
+
+	pid_t pid = fork();
+
+	if (pid == 0) {
+
+		*p = 0x5A;
+		_exit(0);
+
+	}
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+
+	return WIFSIGNALED(status);
+
+}
+
+#endif
+
+
+
+ARC_TEST(PageSizes) {
+
+	SizeT pageSize = VirtualMemory::getPageSize();
+	SizeT largePageSize = VirtualMemory::getLargePageSize();
+
+	ARC_EXPECT(pageSize >= 4096 && (pageSize & (pageSize - 1)) == 0);
+	ARC_EXPECT(largePageSize == 0 || (largePageSize > pageSize && largePageSize % pageSize == 0));
+
+}
+
+
+
+ARC_TEST(AllocateAndProtect) {
+
+	SizeT pageSize = VirtualMemory::getPageSize();
+	SizeT size = pageSize * 4;
+
+	u8* p = static_cast<u8*>(VirtualMemory::allocate(size, VirtualMemory::Protection::ReadWrite));
+
+	ARC_EXPECT(p != nullptr);
+
+	if (!p) {
+		return;
+	}
+
+	ARC_EXPECT(isZero(p, size));
+
+	p[0] = 1;
+	p[size - 1] = 2;
+
+	//Protecting an unaligned range covers every page it touches
+	ARC_EXPECT(VirtualMemory::protect(p + pageSize + 10, pageSize, VirtualMemory::Protection::ReadOnly));
+	ARC_EXPECT(p[0] == 1 && p[size - 1] == 2 && p[pageSize * 2] == 0);
+
+#ifdef ARC_OS_LINUX
+	ARC_EXPECT(!writeFaults(p));
+	ARC_EXPECT(writeFaults(p + pageSize));
+	ARC_EXPECT(writeFaults(p + pageSize * 2 + 10));
+	ARC_EXPECT(!writeFaults(p + pageSize * 3));
+#endif
+
+	ARC_EXPECT(VirtualMemory::protect(p + pageSize, pageSize * 2, VirtualMemory::Protection::ReadWrite));
+
+	p[pageSize * 2] = 3;
+
+	ARC_EXPECT(p[pageSize * 2] == 3);
+	ARC_EXPECT(VirtualMemory::deallocate(p, size));
+
+}
+
+
+
+ARC_TEST(ReserveAndCommit) {
+
+	SizeT pageSize = VirtualMemory::getPageSize();
+
+	//Reservations far beyond physical memory succeed since nothing is backed
+	SizeT reservation = SizeT(64) << 30;
+	u8* base = static_cast<u8*>(VirtualMemory::reserve(reservation));
+
+	ARC_EXPECT(base != nullptr);
+
+	if (!base) {
+		return;
+	}
+
+#ifdef ARC_OS_LINUX
+	ARC_EXPECT(writeFaults(base));
+#endif
+
+	//Commit a window in the middle of the reservation
+	u8* window = base + pageSize * 1000;
+	SizeT windowSize = pageSize * 16;
+
+	ARC_EXPECT(VirtualMemory::commit(window, windowSize, VirtualMemory::Protection::ReadWrite));
+	ARC_EXPECT(isZero(window, windowSize));
+
+	for (SizeT i = 0; i < windowSize; i++) {
+		window[i] = u8(i * 31 + 7);
+	}
+
+#ifdef ARC_OS_LINUX
+	ARC_EXPECT(writeFaults(window - 1));
+	ARC_EXPECT(writeFaults(window + windowSize));
+#endif
+
+	//Decommitted pages lose their contents and read as zero once committed again
+	ARC_EXPECT(VirtualMemory::decommit(window, pageSize * 8));
+
+#ifdef ARC_OS_LINUX
+	ARC_EXPECT(writeFaults(window));
+#endif
+
+	ARC_EXPECT(window[pageSize * 8] == u8(pageSize * 8 * 31 + 7));
+	ARC_EXPECT(VirtualMemory::commit(window, pageSize * 8, VirtualMemory::Protection::ReadWrite));
+	ARC_EXPECT(isZero(window, pageSize * 8));
+
+	bool kept = true;
+
+	for (SizeT i = pageSize * 8; i < windowSize; i++) {
+		kept &= window[i] == u8(i * 31 + 7);
+	}
+
+	ARC_EXPECT(kept);
+
+	//A committed range near the end of the reservation works just the same
+	u8* tail = base + reservation - pageSize * 2;
+
+	ARC_EXPECT(VirtualMemory::commit(tail, pageSize * 2, VirtualMemory::Protection::ReadWrite));
+
+	tail[pageSize * 2 - 1] = 0xFF;
+
+	ARC_EXPECT(tail[pageSize * 2 - 1] == 0xFF);
+	ARC_EXPECT(VirtualMemory::deallocate(base, reservation));
+
+}
+
+
+
+ARC_TEST(HugePages) {
+
+	SizeT largePageSize = VirtualMemory::getLargePageSize();
+	SizeT size = largePageSize ? largePageSize * 2 : VirtualMemory::getPageSize() * 512;
+
+	//Transparent huge pages are only a hint, the memory has to work either way
+	u8* p = static_cast<u8*>(VirtualMemory::allocate(size, VirtualMemory::Protection::ReadWrite));
+
+	ARC_EXPECT(p != nullptr);
+
+	if (p) {
+
+		VirtualMemory::adviseHugePages(p, size);
+
+		p[0] = 1;
+		p[size - 1] = 2;
+
+		ARC_EXPECT(p[0] == 1 && p[size - 1] == 2 && isZero(p + 1, size - 2));
+		ARC_EXPECT(VirtualMemory::deallocate(p, size));
+
+	}
+
+	//Explicit huge pages depend on the system configuration and may legitimately be unavailable
+	u8* large = static_cast<u8*>(VirtualMemory::allocateLarge(1, VirtualMemory::Protection::ReadWrite));
+
+	if (large) {
+
+		ARC_EXPECT(largePageSize != 0);
+
+		large[0] = 1;
+		large[largePageSize - 1] = 2;
+
+		ARC_EXPECT(large[0] == 1 && large[largePageSize - 1] == 2);
+		ARC_EXPECT(VirtualMemory::deallocate(large, largePageSize));
+
+	}
+
+}
+
+
+
+ARC_TEST(GuardPages) {
+
+	SizeT pageSize = VirtualMemory::getPageSize();
+
+	for (SizeT size : {SizeT(1), pageSize - 1, pageSize, pageSize * 3 + 100}) {
+
+		u8* p = static_cast<u8*>(VirtualMemory::allocateGuarded(size, VirtualMemory::Protection::ReadWrite));
+
+		ARC_EXPECT(p != nullptr);
+
+		if (!p) {
+			continue;
+		}
+
+		ARC_EXPECT(reinterpret_cast<uintptr_t>(p) % pageSize == 0);
+		ARC_EXPECT(isZero(p, size));
+
+		//The whole rounded up range is usable
+		SizeT usableSize = (size + pageSize - 1) / pageSize * pageSize;
+
+		for (SizeT i = 0; i < usableSize; i++) {
+			p[i] = u8(i);
+		}
+
+#ifdef ARC_OS_LINUX
+		ARC_EXPECT(writeFaults(p - 1));
+		ARC_EXPECT(writeFaults(p + usableSize));
+		ARC_EXPECT(!writeFaults(p + usableSize - 1));
+#endif
+
+		ARC_EXPECT(p[usableSize - 1] == u8(usableSize - 1));
+		ARC_EXPECT(VirtualMemory::deallocateGuarded(p, size));
+
+	}
+
+}
+
+
+
+ARC_TEST(Allocator) {
+
+	std::vector<u32, VirtualAllocator<u32, VirtualMemory::Protection::ReadWrite>> vector;
+
+	for (u32 i = 0; i < 100000; i++) {
+		vector.push_back(i * 3);
+	}
+
+	u64 sum = 0;
+
+	for (u32 v : vector) {
+		sum += v;
+	}
+
+	ARC_EXPECT(vector.size() == 100000 && sum == 3ull * 99999 * 100000 / 2);
+
+	vector.clear();
+	vector.shrink_to_fit();
+
+	ARC_EXPECT(vector.capacity() == 0);
+
+}
\ No newline at end of file
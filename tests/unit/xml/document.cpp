@@ -0,0 +1,186 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 document.cpp
+ */
+
+#include "framework/test.hpp"
+#include "xml/xml.hpp"
+
+#include <string>
+#include <string_view>
+
+
+
+using Document = Xml::Document<char>;
+using Node = Xml::Node<char>;
+
+
+
+static constexpr std::string_view Source = R"(<?xml version="1.0"?>
+<!-- Header -->
+<scene name="Tom &amp; Jerry" id="&#x1F600;">
+	<entity kind="camera" fov="90"/>
+	<entity kind="light">
+		<color r="1" g="0.5" b="0"/>
+		<text>a &lt; b &gt; c &quot;d&quot; &apos;e&apos;</text>
+	</entity>
+	<entity kind="mesh"><path>plain</path></entity>
+</scene>
+)";
+
+
+
+//Names of all elements and attributes in document order
+static void collect(const Node& node, std::string& names) {
+
+	for (auto child = node.getFirstChild(); child; child = child->getNext()) {
+
+		if (child->getType() != Xml::NodeType::Element) {
+			continue;
+		}
+
+		names += child->getName().toString() + "(";
+
+		for (auto attribute = child->getFirstAttribute(); attribute; attribute = attribute->getNext()) {
+			names += attribute->getName().toString() + " ";
+		}
+
+		collect(*child, names);
+
+		names += ")";
+
+	}
+
+}
+
+
+
+ARC_TEST(DocumentOrder) {
+
+	Document document;
+	document.read(Source);
+
+	std::string names;
+	collect(document.getRoot(), names);
+
+	ARC_EXPECT(names == "scene(name id entity(kind fov )entity(kind color(r g b )text())entity(kind path()))");
+
+	auto scene = document.getRoot().getNodeByName("scene");
+
+	ARC_EXPECT(scene && scene->getParent() && &*scene->getParent() == &document.getRoot());
+
+	//Siblings link both ways
+	auto first = scene->getFirstChild();
+	auto second = first->getNext();
+	auto third = second->getNext();
+
+	ARC_EXPECT(!first->getPrevious() && &*second->getPrevious() == &*first && &*third->getPrevious() == &*second && !third->getNext());
+	ARC_EXPECT(&*second->getFirstChild()->getParent() == &*second);
+
+	auto fov = first->getAttributeByName("fov");
+
+	ARC_EXPECT(fov && fov->getValue() == "90" && &fov->getParent() == &*first);
+	ARC_EXPECT(!first->getAttributeByName("missing") && !scene->getNodeByName("missing"));
+
+}
+
+
+
+ARC_TEST(LazyEntities) {
+
+	Document document;
+	document.read(Source);
+
+	auto scene = document.getRoot().getNodeByName("scene");
+	auto name = scene->getAttributeByName("name");
+
+	//Values keep the raw references, decoding happens on request
+	ARC_EXPECT(name->getValue() == "Tom &amp; Jerry" && name->getValue().hasEntities());
+	ARC_EXPECT(name->getValue().toDecodedString() == "Tom & Jerry");
+	ARC_EXPECT(scene->getAttributeByName("id")->getValue().toDecodedString() == "\xF0\x9F\x98\x80");
+
+	auto text = scene->getFirstChild()->getNext()->getNodeByName("text");
+
+	ARC_EXPECT(text->getValue().toDecodedString() == "a < b > c \"d\" 'e'");
+
+	auto path = scene->getFirstChild()->getNext()->getNext()->getNodeByName("path");
+
+	ARC_EXPECT(!path->getValue().hasEntities() && path->getValue().toDecodedString() == "plain");
+
+	//Malformed and unknown references are copied verbatim
+	ARC_EXPECT(Xml::decodeEntities(std::string_view("a & b &amp; c")) == "a & b & c");
+	ARC_EXPECT(Xml::decodeEntities(std::string_view("&unknown; &#xD800; &#x110000; &#; &#12a;")) == "&unknown; &#xD800; &#x110000; &#; &#12a;");
+	ARC_EXPECT(Xml::decodeEntities(std::string_view("&#65;&#x42;&#X43; &#233; trailing &amp")) == "ABC \xC3\xA9 trailing &amp");
+
+	ARC_EXPECT(Xml::decodeEntities(std::u16string_view(u"&#x1F600;&lt;")) == u"\U0001F600<");
+	ARC_EXPECT(Xml::decodeEntities(std::u32string_view(U"&#x1F600;&gt;")) == U"\U0001F600>");
+
+}
+
+
+
+ARC_TEST(InSitu) {
+
+	std::string text(Source);
+
+	//Borrowed sources are referenced directly
+	Document borrowed;
+	borrowed.read(std::string_view(text));
+
+	const char* name = borrowed.getRoot().getNodeByName("scene")->getName().data();
+
+	ARC_EXPECT(name >= text.data() && name < text.data() + text.size());
+
+	//Owned sources stay alive with the document
+	Document owned;
+	owned.read(std::string(Source));
+
+	ARC_EXPECT(owned.getRoot().getNodeByName("scene")->getAttributeByName("name")->getValue().toDecodedString() == "Tom & Jerry");
+
+	owned.clear();
+
+	ARC_EXPECT(!owned.getRoot().getFirstChild());
+
+	owned.read(std::string("<a><b/></a>"));
+
+	ARC_EXPECT(owned.getRoot().getNodeByName("a")->getNodeByName("b"));
+
+}
+
+
+
+ARC_TEST(WriteRoundTrip) {
+
+	Document document;
+	document.read(Source.substr(Source.find("<scene")));
+
+	std::string written;
+	document.write(written);
+
+	Document reread;
+	reread.read(std::move(written));
+
+	std::string a, b;
+	collect(document.getRoot(), a);
+	collect(reread.getRoot(), b);
+
+	ARC_EXPECT(a == b);
+	ARC_EXPECT(reread.getRoot().getNodeByName("scene")->getAttributeByName("name")->getValue().toDecodedString() == "Tom & Jerry");
+
+}
+
+
+
+ARC_TEST(Errors) {
+
+	Document document;
+
+	ARC_EXPECT_THROW(document.read(std::string("<a></b>")), Xml::XmlParseError);
+	ARC_EXPECT_THROW(document.read(std::string("<a b=\"1\" c></a>")), Xml::XmlParseError);
+	ARC_EXPECT_THROW(document.read(std::string("<a><b></a>")), Xml::XmlParseError);
+	ARC_EXPECT_THROW(document.read(std::string("<!-- open")), Xml::XmlParseError);
+
+}
\ No newline at end of file
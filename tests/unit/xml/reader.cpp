@@ -0,0 +1,233 @@
+/*
+ *	 Copyright (c) 2022 - Arclight Team
+ *
+ *	 This file is part of Arclight. All rights reserved.
+ *
+ *	 reader.cpp
+ */
+
+#include "framework/test.hpp"
+#include "xml/xml.hpp"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+
+
+
+using Reader = Xml::Reader<char>;
+using Event = Xml::ReaderEvent;
+
+
+
+//Pulls the next event, feeding chunks of the input whenever the reader runs dry
+class ChunkedReader {
+
+public:
+
+	ChunkedReader(const std::string& xml, SizeT chunkSize) : xml(xml), chunkSize(chunkSize), offset(0) {}
+
+	Event next() {
+
+		Event event;
+
+		while ((event = reader.next()) == Event::NeedInput) {
+
+			if (offset == xml.size()) {
+
+				reader.finish();
+				continue;
+
+			}
+
+			SizeT size = std::min(chunkSize, xml.size() - offset);
+
+			reader.feed(std::string_view(xml).substr(offset, size));
+			offset += size;
+
+		}
+
+		return event;
+
+	}
+
+	Reader reader;
+
+private:
+
+	std::string xml;
+	SizeT chunkSize;
+	SizeT offset;
+
+};
+
+
+
+//Renders the event stream as text
+static std::string trace(const std::string& xml, SizeT chunkSize) {
+
+	ChunkedReader chunked(xml, chunkSize);
+	Reader& reader = chunked.reader;
+	std::string events;
+
+	for (Event event = chunked.next(); event != Event::EndOfInput; event = chunked.next()) {
+
+		std::string name = reader.getName().toString();
+		std::string value = reader.getValue().toString();
+
+		switch (event) {
+
+			case Event::StartElement:			events += "<" + name + " [" + std::string(reader.getPath()) + "] "; break;
+			case Event::Attribute:				events += name + "=" + value + " "; break;
+			case Event::EndElement:				events += "/" + name + " "; break;
+			case Event::Text:					events += "T:" + value + " "; break;
+			case Event::CData:					events += "D:" + value + " "; break;
+			case Event::Comment:				events += "C:" + value + " "; break;
+			case Event::ProcessingInstruction:	events += "?" + name + " "; break;
+			case Event::Declaration:			events += "!" + name + " "; break;
+			default:							break;
+
+		}
+
+	}
+
+	return events;
+
+}
+
+
+
+static constexpr const char* Mixed = "\xEF\xBB\xBF<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+	"<!DOCTYPE svg>\n"
+	"<!-- Exported -->\n"
+	"<svg width='100' height=\"50\">\n"
+	"\t<g id=\"layer &amp; 1\"><rect x=\"1\" y=\"2\"/><rect x=\"3\"/></g>\n"
+	"\t<text>Label &lt;1&gt;</text>\n"
+	"\t<style><![CDATA[a > b { fill: <red> }]]></style>\n"
+	"\t<!-- Inner - comment -->\n"
+	"\t<path d=\"M 0 0 L 10 10\" />\n"
+	"</svg>\n";
+
+static constexpr const char* MixedTrace =
+	"?xml version=1.0 encoding=UTF-8 !DOCTYPE C: Exported  "
+	"<svg [svg] width=100 height=50 "
+	"<g [svg/g] id=layer &amp; 1 <rect [svg/g/rect] x=1 y=2 /rect <rect [svg/g/rect] x=3 /rect /g "
+	"<text [svg/text] T:Label &lt;1&gt; /text "
+	"<style [svg/style] D:a > b { fill: <red> } /style "
+	"C: Inner - comment  "
+	"<path [svg/path] d=M 0 0 L 10 10 /path "
+	"/svg ";
+
+
+
+ARC_TEST(ChunkSplitEquivalence) {
+
+	std::string xml = Mixed;
+
+	ARC_EXPECT(trace(xml, xml.size()) == MixedTrace);
+
+	//Every token is cut at every possible position by some chunk size
+	for (SizeT chunkSize = 1; chunkSize <= 19; chunkSize++) {
+
+		if (trace(xml, chunkSize) != MixedTrace) {
+
+			ARC_EXPECT(!"Chunked trace differs");
+			break;
+
+		}
+
+	}
+
+}
+
+
+
+ARC_TEST(Skip) {
+
+	std::string xml = "<root><skipped a=\"1\"><deep><deeper/>text<![CDATA[</skipped>]]><!-- </skipped> --></deep></skipped>"
+					  "<empty/><kept b=\"2\">value</kept></root>";
+
+	for (SizeT chunkSize : {SizeT(1), SizeT(6), xml.size()}) {
+
+		ChunkedReader chunked(xml, chunkSize);
+		Reader& reader = chunked.reader;
+
+		ARC_EXPECT(chunked.next() == Event::StartElement && reader.getName() == "root");
+		ARC_EXPECT(chunked.next() == Event::StartElement && reader.getName() == "skipped");
+
+		//Skipping before the attributes drops them with the subtree, markup in CDATA and comments is ignored
+		reader.skip();
+
+		ARC_EXPECT(chunked.next() == Event::StartElement && reader.getName() == "empty");
+
+		//Self-closing elements are skipped without their synthesized end
+		reader.skip();
+
+		ARC_EXPECT(chunked.next() == Event::StartElement && reader.getName() == "kept" && reader.getPath() == "root/kept");
+		ARC_EXPECT(chunked.next() == Event::Attribute && reader.getValue() == "2");
+		ARC_EXPECT(chunked.next() == Event::Text && reader.getValue() == "value");
+		ARC_EXPECT(chunked.next() == Event::EndElement && reader.getName() == "kept");
+		//The path still contains an element while its end is reported
+		ARC_EXPECT(chunked.next() == Event::EndElement && reader.getName() == "root" && reader.getDepth() == 1);
+		ARC_EXPECT(chunked.next() == Event::EndOfInput);
+
+	}
+
+}
+
+
+
+ARC_TEST(LargeStream) {
+
+	//Many records with a large text token that spans many chunks
+	std::string xml = "<log>";
+
+	for (u32 i = 0; i < 2000; i++) {
+		xml += "<record id=\"" + std::to_string(i) + "\"><payload>" + std::string(i % 7 ? 10 : 5000, 'x') + "</payload></record>";
+	}
+
+	xml += "</log>";
+
+	ChunkedReader chunked(xml, 512);
+	Reader& reader = chunked.reader;
+
+	u32 records = 0;
+	SizeT textBytes = 0;
+	SizeT maxDepth = 0;
+
+	for (Event event = chunked.next(); event != Event::EndOfInput; event = chunked.next()) {
+
+		maxDepth = std::max(maxDepth, reader.getDepth());
+
+		if (event == Event::Attribute && reader.getName() == "id") {
+			records += reader.getValue() == std::to_string(records);
+		} else if (event == Event::Text) {
+			textBytes += reader.getValue().size();
+		}
+
+	}
+
+	ARC_EXPECT(records == 2000);
+	ARC_EXPECT(textBytes == 286 * 5000 + (2000 - 286) * 10);
+	ARC_EXPECT(maxDepth == 3);
+
+}
+
+
+
+ARC_TEST(Errors) {
+
+	ARC_EXPECT_THROW(trace("<a></b>", 1), Xml::XmlParseError);
+	ARC_EXPECT_THROW(trace("<a><b></a>", 2), Xml::XmlParseError);
+	ARC_EXPECT_THROW(trace("<a x></a>", 1), Xml::XmlParseError);
+	ARC_EXPECT_THROW(trace("<a x=1></a>", 1), Xml::XmlParseError);
+	ARC_EXPECT_THROW(trace("text<a/>", 1), Xml::XmlParseError);
+	ARC_EXPECT_THROW(trace("<a><!-- open", 3), Xml::XmlParseError);
+	ARC_EXPECT_THROW(trace("<a", 1), Xml::XmlParseError);
+
+	Reader reader;
+	reader.finish();
+
+	ARC_EXPECT_THROW(reader.feed("<a/>"), Xml::XmlParseError);
+
+}
\ No newline at end of file